@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Encoding of streams with an increasing number of branches to labels (mostly near targets, some
+    far ones), compared to the same streams with the branches already encoded as rel32 (no labels).
+    The time per branch should stay flat as the stream grows.
+
+    Usage: bench_branch_relaxation [num_branches] [num_steps]
+*/
+
+#include "spasm/bytecode.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+#define NUM_BRANCHES_PER_LABEL 8
+
+static void push_stream(SpasmInstructions* instructions, size_t num_branches, bool labels)
+{
+    const uint32_t num_labels = (uint32_t)(num_branches / NUM_BRANCHES_PER_LABEL);
+
+    for(uint32_t i = 0; labels && i < num_labels; i++)
+        spasm_instructions_new_label(instructions);
+
+    srand(42);
+
+    uint32_t next_label = 0;
+
+    for(size_t i = 0; i < num_branches; i++)
+    {
+        if(i % NUM_BRANCHES_PER_LABEL == 0 && labels)
+            spasm_instructions_bind_label(instructions, next_label++);
+
+        const uint32_t spread = i % 16 == 0 ? num_labels : 4;
+        const uint32_t base = next_label > 2 ? next_label - 2 : 0;
+        const uint32_t target = (base + (uint32_t)rand() % spread) % num_labels;
+
+        if(labels)
+            spasm_instructions_push(instructions,
+                                    i % 2 == 0 ? SpasmMnemonic_x86_64_JNE : SpasmMnemonic_x86_64_JMP,
+                                    SpasmOpLabel(target));
+        else
+            spasm_instructions_push(instructions,
+                                    i % 2 == 0 ? SpasmMnemonic_x86_64_JNE : SpasmMnemonic_x86_64_JMP,
+                                    SpasmOpImm32(0));
+
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpReg(SpasmRegister_x86_64_RBX));
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+    }
+}
+
+static bool run(SpasmContext* ctx, size_t num_branches, bool labels, uint64_t* elapsed, size_t* code_size)
+{
+    SpasmInstructions instructions = spasm_instructions_new(ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(ctx);
+
+    push_stream(&instructions, num_branches, labels);
+
+    const uint64_t start = spasm_get_timestamp_ns();
+
+    bool res = spasm_x86_64_encode_instructions(ctx, &instructions, &bytecode, NULL);
+
+    *elapsed = spasm_get_timestamp_ns() - start;
+    *code_size = spasm_bytecode_size(&bytecode);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+
+    return res;
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_branches = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 10000;
+    uint32_t num_steps = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 5;
+
+    if(num_branches < NUM_BRANCHES_PER_LABEL * 4 || num_steps == 0)
+    {
+        fprintf(stderr, "Usage: bench_branch_relaxation [num_branches] [num_steps]\n");
+        return 1;
+    }
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    /* The relaxation itself is sequential, keep the encoding sequential to compare the two */
+    spasm_context_set_max_encoding_threads(&ctx, 1);
+
+    for(uint32_t step = 0; step < num_steps; step++, num_branches *= 2)
+    {
+        uint64_t labels_ns = 0;
+        uint64_t rel32_ns = 0;
+        size_t labels_size = 0;
+        size_t rel32_size = 0;
+
+        if(!run(&ctx, num_branches, true, &labels_ns, &labels_size) ||
+           !run(&ctx, num_branches, false, &rel32_ns, &rel32_size))
+        {
+            fprintf(stderr, "Encoding failed\n");
+            return 1;
+        }
+
+        printf("branches: %8zu | labels: %8.3f ms (%6.1f ns/branch, %9zu bytes)"
+               " | rel32: %8.3f ms (%9zu bytes)\n",
+               num_branches,
+               (double)labels_ns / 1e6,
+               (double)labels_ns / (double)num_branches,
+               labels_size,
+               (double)rel32_ns / 1e6,
+               rel32_size);
+    }
+
+    spasm_context_release(&ctx);
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Compile queue benchmark: submits a burst of small functions with mixed priorities and reports
+    the per-priority latency (queued time and submit-to-done time) and the overall throughput.
+
+    Usage: bench_compile_queue [num_jobs] [num_workers]
+*/
+
+#include "spasm/abi.h"
+#include "spasm/compile_queue.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+
+#include <stdlib.h>
+
+#define NUM_INSTRUCTIONS_PER_COMPILE 16
+
+typedef struct
+{
+    SpasmContext ctx;
+    SpasmData data;
+    SpasmInstructions instructions;
+    SpasmByteCode bytecode;
+    SpasmCompilePriority priority;
+    SpasmCompileJob* job;
+} BenchCompile;
+
+static void push_kernel(SpasmInstructions* instructions)
+{
+    for(uint32_t i = 0; i < NUM_INSTRUCTIONS_PER_COMPILE / 4; i++)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX),
+                                     SpasmOpImm32(i));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1),
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX));
+    }
+}
+
+static const char* priority_names[SpasmCompilePriority_COUNT] = { "high", "normal", "low" };
+
+int main(int argc, char** argv)
+{
+    uint32_t num_jobs = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 50000;
+    uint32_t num_workers = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 0;
+
+    SpasmCompileQueue* queue = spasm_compile_queue_new(NULL, spasm_get_current_abi(), num_workers);
+
+    if(queue == NULL)
+    {
+        fprintf(stderr, "Cannot create the compile queue\n");
+        return 1;
+    }
+
+    BenchCompile* compiles = (BenchCompile*)calloc(num_jobs, sizeof(BenchCompile));
+
+    if(compiles == NULL)
+    {
+        fprintf(stderr, "Cannot allocate the compiles\n");
+        return 1;
+    }
+
+    /* Mostly speculative low priority work with a few hot functions in between */
+    for(uint32_t i = 0; i < num_jobs; i++)
+    {
+        BenchCompile* compile = &compiles[i];
+
+        spasm_context_init(&compile->ctx);
+        spasm_data_init(&compile->data, &compile->ctx);
+        compile->instructions = spasm_instructions_new(&compile->ctx);
+        compile->bytecode = spasm_bytecode_new(&compile->ctx);
+        compile->priority = (i % 16) == 0 ? SpasmCompilePriority_High :
+                            (i % 4) == 0 ? SpasmCompilePriority_Normal :
+                                           SpasmCompilePriority_Low;
+
+        push_kernel(&compile->instructions);
+    }
+
+    printf("workers: %u, jobs: %u, instructions per compile: %u\n",
+           spasm_compile_queue_num_workers(queue),
+           num_jobs,
+           NUM_INSTRUCTIONS_PER_COMPILE);
+
+    uint64_t start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_jobs; i++)
+    {
+        compiles[i].job = spasm_compile_queue_submit(queue,
+                                                     &compiles[i].instructions,
+                                                     &compiles[i].data,
+                                                     &compiles[i].bytecode,
+                                                     compiles[i].priority);
+
+        if(compiles[i].job == NULL)
+        {
+            fprintf(stderr, "Cannot submit job %u\n", i);
+            return 1;
+        }
+    }
+
+    uint64_t num_per_priority[SpasmCompilePriority_COUNT] = { 0 };
+    uint64_t queued_per_priority[SpasmCompilePriority_COUNT] = { 0 };
+    uint64_t total_per_priority[SpasmCompilePriority_COUNT] = { 0 };
+    uint64_t max_total_per_priority[SpasmCompilePriority_COUNT] = { 0 };
+
+    for(uint32_t i = 0; i < num_jobs; i++)
+    {
+        if(spasm_compile_job_wait(compiles[i].job) != SpasmCompileJobStatus_Done)
+        {
+            fprintf(stderr, "Job %u failed\n", i);
+            return 1;
+        }
+    }
+
+    uint64_t elapsed = spasm_get_timestamp_ns() - start;
+
+    for(uint32_t i = 0; i < num_jobs; i++)
+    {
+        BenchCompile* compile = &compiles[i];
+        SpasmCompileJobTimings timings = spasm_compile_job_get_timings(compile->job);
+
+        num_per_priority[compile->priority]++;
+        queued_per_priority[compile->priority] += timings.queued_ns;
+        total_per_priority[compile->priority] += timings.total_ns;
+
+        if(timings.total_ns > max_total_per_priority[compile->priority])
+            max_total_per_priority[compile->priority] = timings.total_ns;
+
+        spasm_compile_job_release(compile->job);
+        spasm_bytecode_destroy(&compile->bytecode);
+        spasm_instructions_destroy(&compile->instructions);
+        spasm_data_release(&compile->data);
+        spasm_context_release(&compile->ctx);
+    }
+
+    spasm_compile_queue_destroy(queue);
+    free(compiles);
+
+    printf("time: %.3f ms | %.0f jobs/s\n",
+           (double)elapsed / 1e6,
+           (double)num_jobs / ((double)elapsed / 1e9));
+
+    for(uint32_t p = 0; p < SpasmCompilePriority_COUNT; p++)
+    {
+        if(num_per_priority[p] == 0)
+            continue;
+
+        printf("%-6s | jobs: %8llu | avg queued: %10.3f us | avg latency: %10.3f us | max latency: %10.3f us\n",
+               priority_names[p],
+               (unsigned long long)num_per_priority[p],
+               (double)queued_per_priority[p] / (double)num_per_priority[p] / 1e3,
+               (double)total_per_priority[p] / (double)num_per_priority[p] / 1e3,
+               (double)max_total_per_priority[p] / 1e3);
+    }
+
+    return 0;
+}
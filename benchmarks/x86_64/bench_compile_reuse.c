@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Back-to-back small compiles on a single thread, either creating and destroying the
+    instructions, bytecode and data for each compile, or resetting long-lived ones. The context
+    uses a tracking allocator to count the allocator calls made per compile.
+
+    Usage: bench_compile_reuse [num_compiles]
+*/
+
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/assembler.h"
+#include "spasm/context.h"
+#include "spasm/data.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_INSTRUCTIONS_PER_COMPILE 16
+
+static uint64_t value = 0;
+
+static void push_kernel(SpasmInstructions* instructions, SpasmData* data)
+{
+    spasm_data_add_bytes(data, "value", (uint8_t*)&value, sizeof(uint64_t), SpasmDataType_Data);
+
+    for(uint32_t i = 0; i < NUM_INSTRUCTIONS_PER_COMPILE / 4; i++)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RBX),
+                                     SpasmOpData("value"));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpImm32(i));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1),
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX));
+    }
+}
+
+static bool bench_create_destroy(SpasmContext* ctx, SpasmJitAssembler assembler, uint32_t num_compiles)
+{
+    bool ok = true;
+
+    for(uint32_t i = 0; i < num_compiles && ok; i++)
+    {
+        SpasmData data;
+        spasm_data_init(&data, ctx);
+
+        SpasmInstructions instructions = spasm_instructions_new(ctx);
+        SpasmByteCode bytecode = spasm_bytecode_new(ctx);
+
+        push_kernel(&instructions, &data);
+
+        ok = assembler(&instructions, &bytecode, &data);
+
+        spasm_bytecode_destroy(&bytecode);
+        spasm_instructions_destroy(&instructions);
+        spasm_data_release(&data);
+    }
+
+    return ok;
+}
+
+static bool bench_reset(SpasmContext* ctx, SpasmJitAssembler assembler, uint32_t num_compiles)
+{
+    bool ok = true;
+
+    SpasmData data;
+    spasm_data_init(&data, ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(ctx);
+
+    for(uint32_t i = 0; i < num_compiles && ok; i++)
+    {
+        spasm_data_reset(&data);
+        spasm_instructions_reset(&instructions);
+        spasm_bytecode_reset(&bytecode);
+
+        push_kernel(&instructions, &data);
+
+        ok = assembler(&instructions, &bytecode, &data);
+    }
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_data_release(&data);
+
+    return ok;
+}
+
+typedef bool (*BenchFunc)(SpasmContext*, SpasmJitAssembler, uint32_t);
+
+static bool run(const char* name, BenchFunc func, SpasmJitAssembler assembler, uint32_t num_compiles)
+{
+    SpasmTrackingAllocator tracking;
+    spasm_tracking_allocator_init(&tracking, NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_allocator(&ctx, &tracking.allocator);
+
+    uint64_t start = spasm_get_timestamp_ns();
+
+    bool ok = func(&ctx, assembler, num_compiles);
+
+    uint64_t elapsed = spasm_get_timestamp_ns() - start;
+
+    ok &= ctx.stats.num_errors == 0;
+
+    spasm_context_release(&ctx);
+
+    if(!ok)
+    {
+        fprintf(stderr, "%s: assembling failed\n", name);
+        return false;
+    }
+
+    const uint64_t num_calls = tracking.num_allocs + tracking.num_reallocs + tracking.num_frees;
+
+    printf("%-16s | time: %9.3f ms | %8.1f ns/compile | allocator calls: %10llu (%.2f/compile)"
+           " | peak: %zu bytes\n",
+           name,
+           (double)elapsed / 1e6,
+           (double)elapsed / (double)num_compiles,
+           (unsigned long long)num_calls,
+           (double)num_calls / (double)num_compiles,
+           tracking.peak_bytes_in_use);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t num_compiles = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(spasm_get_current_abi());
+
+    if(assembler == NULL)
+    {
+        fprintf(stderr, "Cannot find a jit assembler for the current abi\n");
+        return 1;
+    }
+
+    printf("compiles: %u, instructions per compile: %u\n", num_compiles, NUM_INSTRUCTIONS_PER_COMPILE);
+
+    if(!run("create/destroy", bench_create_destroy, assembler, num_compiles))
+        return 1;
+
+    if(!run("reset", bench_reset, assembler, num_compiles))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Stress benchmark for concurrent assembling: each thread owns a context and repeatedly
+    builds, assembles and destroys a small function. Reports the throughput for 1 to 64 threads.
+
+    Usage: bench_concurrent_assembling [num_compiles_per_thread]
+*/
+
+#include "spasm/abi.h"
+#include "spasm/assembler.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_THREADS 64
+#define NUM_INSTRUCTIONS_PER_COMPILE 16
+
+typedef struct
+{
+    SpasmJitAssembler assembler;
+    uint32_t num_compiles;
+    SpasmContext ctx;
+    bool failed;
+} BenchThreadData;
+
+static void push_kernel(SpasmInstructions* instructions)
+{
+    for(uint32_t i = 0; i < NUM_INSTRUCTIONS_PER_COMPILE / 4; i++)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX),
+                                     SpasmOpImm32(i));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1),
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX));
+    }
+}
+
+static void bench_thread(void* arg)
+{
+    BenchThreadData* thread_data = (BenchThreadData*)arg;
+
+    for(uint32_t i = 0; i < thread_data->num_compiles; i++)
+    {
+        SpasmData data;
+
+        if(!spasm_data_init(&data, &thread_data->ctx))
+        {
+            thread_data->failed = true;
+            return;
+        }
+
+        SpasmInstructions instructions = spasm_instructions_new(&thread_data->ctx);
+        SpasmByteCode bytecode = spasm_bytecode_new(&thread_data->ctx);
+
+        push_kernel(&instructions);
+
+        if(!thread_data->assembler(&instructions, &bytecode, &data))
+            thread_data->failed = true;
+
+        spasm_bytecode_destroy(&bytecode);
+        spasm_instructions_destroy(&instructions);
+        spasm_data_release(&data);
+
+        if(thread_data->failed)
+            return;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t num_compiles = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 20000;
+
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(spasm_get_current_abi());
+
+    if(assembler == NULL)
+    {
+        fprintf(stderr, "Cannot find a jit assembler for the current abi\n");
+        return 1;
+    }
+
+    static SpasmThread threads[MAX_THREADS];
+    static BenchThreadData threads_data[MAX_THREADS];
+
+    printf("cpus: %u, compiles per thread: %u, instructions per compile: %u\n",
+           spasm_get_num_cpus(),
+           num_compiles,
+           NUM_INSTRUCTIONS_PER_COMPILE);
+
+    double single_thread_throughput = 0.0;
+
+    for(uint32_t num_threads = 1; num_threads <= MAX_THREADS; num_threads <<= 1)
+    {
+        for(uint32_t i = 0; i < num_threads; i++)
+        {
+            threads_data[i].assembler = assembler;
+            threads_data[i].num_compiles = num_compiles;
+            threads_data[i].failed = false;
+            spasm_context_init(&threads_data[i].ctx);
+        }
+
+        uint64_t start = spasm_get_timestamp_ns();
+
+        for(uint32_t i = 0; i < num_threads; i++)
+        {
+            if(!spasm_thread_start(&threads[i], bench_thread, &threads_data[i]))
+            {
+                fprintf(stderr, "Cannot start thread %u\n", i);
+                return 1;
+            }
+        }
+
+        for(uint32_t i = 0; i < num_threads; i++)
+            spasm_thread_join(&threads[i]);
+
+        uint64_t elapsed = spasm_get_timestamp_ns() - start;
+
+        uint64_t num_encoded = 0;
+        uint64_t num_bytes = 0;
+
+        for(uint32_t i = 0; i < num_threads; i++)
+        {
+            const SpasmStats* stats = &threads_data[i].ctx.stats;
+
+            if(threads_data[i].failed || stats->num_errors != 0 ||
+               stats->num_instructions_encoded != (uint64_t)num_compiles * NUM_INSTRUCTIONS_PER_COMPILE)
+            {
+                fprintf(stderr, "Thread %u failed or encoded an unexpected number of instructions\n", i);
+                return 1;
+            }
+
+            num_encoded += stats->num_instructions_encoded;
+            num_bytes += stats->num_bytes_encoded;
+
+            spasm_context_release(&threads_data[i].ctx);
+        }
+
+        double seconds = (double)elapsed / 1e9;
+        double throughput = (double)num_encoded / seconds;
+
+        if(num_threads == 1)
+            single_thread_throughput = throughput;
+
+        printf("threads: %2u | time: %8.3f ms | %12.0f instr/s | %10.2f MB/s | scaling: %5.2fx\n",
+               num_threads,
+               (double)elapsed / 1e6,
+               throughput,
+               (double)num_bytes / seconds / (1024.0 * 1024.0),
+               throughput / single_thread_throughput);
+    }
+
+    return 0;
+}
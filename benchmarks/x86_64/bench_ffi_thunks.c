@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Overhead of calling a C function of a dynamic signature (double(int, double, int, double)) with
+    its arguments in 64 bits slots, as an interpreter holds them:
+        - typed: indirect call through a pointer of the right type, the lower bound
+        - thunk: through the generated thunk of the signature
+        - thunk+lookup: looking the thunk up in the cache before every call
+        - varargs: indirect call of a variadic function unpacking its arguments with va_arg
+    The thunk is generated once and all the calls go through the cache of the first lookup.
+
+    Usage: bench_ffi_thunks [num_calls]
+*/
+
+#include "spasm/ffi.h"
+#include "spasm/platform.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef double (*TypedFunc)(int64_t, double, int64_t, double);
+typedef double (*VarargsFunc)(uint32_t, ...);
+
+static double callee(int64_t a, double b, int64_t c, double d)
+{
+    return (double)a * b + (double)c - d;
+}
+
+static double callee_varargs(uint32_t num_args, ...)
+{
+    va_list args;
+    va_start(args, num_args);
+
+    const int64_t a = va_arg(args, int64_t);
+    const double b = va_arg(args, double);
+    const int64_t c = va_arg(args, int64_t);
+    const double d = va_arg(args, double);
+
+    va_end(args);
+
+    return (double)a * b + (double)c - d;
+}
+
+/* Read through volatile pointers so the compiler cannot inline nor hoist the calls */
+static TypedFunc volatile typed_func = callee;
+static VarargsFunc volatile varargs_func = callee_varargs;
+
+static double slot_as_double(uint64_t slot)
+{
+    double value;
+    memcpy(&value, &slot, sizeof(double));
+
+    return value;
+}
+
+static uint64_t double_as_slot(double value)
+{
+    uint64_t slot;
+    memcpy(&slot, &value, sizeof(double));
+
+    return slot;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t num_calls = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+
+    SpasmFFICache* cache = spasm_ffi_cache_new(NULL, 0);
+
+    if(cache == NULL)
+    {
+        fprintf(stderr, "Cannot generate ffi thunks for the current abi\n");
+        return 1;
+    }
+
+    SpasmFFISignature signature;
+    memset(&signature, 0, sizeof(SpasmFFISignature));
+    signature.return_type = SpasmFFIType_Double;
+    signature.num_args = 4;
+    signature.arg_types[0] = SpasmFFIType_Int;
+    signature.arg_types[1] = SpasmFFIType_Double;
+    signature.arg_types[2] = SpasmFFIType_Int;
+    signature.arg_types[3] = SpasmFFIType_Double;
+
+    uint64_t start = spasm_get_timestamp_ns();
+
+    SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+    const uint64_t generation_ns = spasm_get_timestamp_ns() - start;
+
+    if(thunk == NULL)
+    {
+        fprintf(stderr, "Cannot generate the thunk\n");
+        spasm_ffi_cache_destroy(cache);
+        return 1;
+    }
+
+    uint64_t args[4] = { 3, double_as_slot(0.5), 7, double_as_slot(0.25) };
+    double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    uint64_t times[4];
+
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_calls; i++)
+    {
+        args[0] = i;
+        sums[0] += typed_func((int64_t)args[0], slot_as_double(args[1]), (int64_t)args[2], slot_as_double(args[3]));
+    }
+
+    times[0] = spasm_get_timestamp_ns() - start;
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_calls; i++)
+    {
+        args[0] = i;
+
+        double result;
+        thunk((SpasmFFIFunction)callee, args, &result);
+        sums[1] += result;
+    }
+
+    times[1] = spasm_get_timestamp_ns() - start;
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_calls; i++)
+    {
+        args[0] = i;
+
+        double result;
+        spasm_ffi_cache_get(cache, &signature)((SpasmFFIFunction)callee, args, &result);
+        sums[2] += result;
+    }
+
+    times[2] = spasm_get_timestamp_ns() - start;
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_calls; i++)
+    {
+        args[0] = i;
+        sums[3] += varargs_func(4, (int64_t)args[0], slot_as_double(args[1]), (int64_t)args[2], slot_as_double(args[3]));
+    }
+
+    times[3] = spasm_get_timestamp_ns() - start;
+
+    spasm_ffi_cache_destroy(cache);
+
+    const char* names[4] = { "typed", "thunk", "thunk+lookup", "varargs" };
+
+    printf("calls: %u, thunk generation: %.1f us\n", num_calls, (double)generation_ns / 1e3);
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        if(sums[i] != sums[0])
+        {
+            fprintf(stderr, "%s: invalid results\n", names[i]);
+            return 1;
+        }
+
+        printf("%-12s | time: %9.3f ms | %6.2f ns/call\n",
+               names[i],
+               (double)times[i] / 1e6,
+               (double)times[i] / (double)num_calls);
+    }
+
+    return 0;
+}
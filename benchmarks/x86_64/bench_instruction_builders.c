@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Cost of building an instruction stream with the different push APIs: mnemonic strings,
+    mnemonic ids with varargs, operand arrays (spasm_instructions_push_array), the typed builders
+    of spasm/x86_64_emit.h and bulk appends of prepared records (spasm_instructions_append). The
+    stream is reset between passes so no allocation is measured. The encoding of the typed stream,
+    whose forms are pre-resolved, is then compared to the encoding of the matched one.
+
+    Usage: bench_instruction_builders [num_instructions] [num_passes]
+*/
+
+#include "spasm/bytecode.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+#include "spasm/x86_64_emit.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMPLATE_SIZE 4
+
+static SpasmInstruction template_instructions[TEMPLATE_SIZE];
+
+static void push_strings(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i += TEMPLATE_SIZE)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpImm32(i));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1),
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX));
+        spasm_instructions_push_backz(instructions, "syscall");
+    }
+}
+
+static void push_varargs(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i += TEMPLATE_SIZE)
+    {
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpImm32(i));
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1),
+                                SpasmOpReg(SpasmRegister_x86_64_RAX));
+        spasm_instructions_pushz(instructions, SpasmMnemonic_x86_64_SYSCALL);
+    }
+}
+
+static void push_arrays(SpasmInstructions* instructions, size_t num_instructions)
+{
+    SpasmOperand operands[2];
+
+    for(size_t i = 0; i < num_instructions; i += TEMPLATE_SIZE)
+    {
+        operands[0] = SpasmOpReg(SpasmRegister_x86_64_RAX);
+        operands[1] = SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1);
+        spasm_instructions_push_array(instructions, SpasmMnemonic_x86_64_MOV, operands, 2);
+
+        operands[1] = SpasmOpImm32(i);
+        spasm_instructions_push_array(instructions, SpasmMnemonic_x86_64_ADD, operands, 2);
+
+        operands[0] = SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1);
+        operands[1] = SpasmOpReg(SpasmRegister_x86_64_RAX);
+        spasm_instructions_push_array(instructions, SpasmMnemonic_x86_64_MOV, operands, 2);
+
+        spasm_instructions_push_array(instructions, SpasmMnemonic_x86_64_SYSCALL, NULL, 0);
+    }
+}
+
+static void push_typed(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i += TEMPLATE_SIZE)
+    {
+        spasm_x86_64_mov_r64_m(instructions,
+                               SpasmRegister_x86_64_RAX,
+                               SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+        spasm_x86_64_add_r64_imm32(instructions, SpasmRegister_x86_64_RAX, (int32_t)i);
+        spasm_x86_64_mov_m_r64(instructions,
+                               SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1),
+                               SpasmRegister_x86_64_RAX);
+        spasm_x86_64_syscall(instructions);
+    }
+}
+
+static void push_appends(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i += TEMPLATE_SIZE)
+    {
+        template_instructions[1].operands[1].imm_value = (int64_t)i;
+
+        spasm_instructions_append(instructions, template_instructions, TEMPLATE_SIZE);
+    }
+}
+
+typedef void (*PushFunc)(SpasmInstructions*, size_t);
+
+static uint64_t run(const char* name,
+                    PushFunc func,
+                    SpasmInstructions* instructions,
+                    size_t num_instructions,
+                    uint32_t num_passes,
+                    uint64_t reference_ns)
+{
+    /* Warm up, so the stream capacity is already there */
+    func(instructions, num_instructions);
+
+    uint64_t elapsed = 0;
+
+    for(uint32_t i = 0; i < num_passes; i++)
+    {
+        spasm_instructions_reset(instructions);
+
+        uint64_t start = spasm_get_timestamp_ns();
+
+        func(instructions, num_instructions);
+
+        elapsed += spasm_get_timestamp_ns() - start;
+    }
+
+    printf("%-16s | %8.3f ms/pass | %6.2f ns/instr | speedup: %5.2fx\n",
+           name,
+           (double)elapsed / 1e6 / num_passes,
+           (double)elapsed / (double)num_instructions / num_passes,
+           reference_ns > 0 ? (double)reference_ns / (double)elapsed : 1.0);
+
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_instructions = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+    uint32_t num_passes = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 10;
+
+    num_instructions = (num_instructions + TEMPLATE_SIZE - 1) / TEMPLATE_SIZE * TEMPLATE_SIZE;
+
+    if(num_instructions == 0 || num_passes == 0)
+    {
+        fprintf(stderr, "Usage: bench_instruction_builders [num_instructions] [num_passes]\n");
+        return 1;
+    }
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    /* Records appended by push_appends */
+    push_varargs(&instructions, TEMPLATE_SIZE);
+    memcpy(template_instructions, spasm_instructions_at(&instructions, 0), sizeof(template_instructions));
+    spasm_instructions_reset(&instructions);
+
+    printf("instructions: %zu, passes: %u\n", num_instructions, num_passes);
+
+    uint64_t reference_ns = run("strings", push_strings, &instructions, num_instructions, num_passes, 0);
+    run("ids + varargs", push_varargs, &instructions, num_instructions, num_passes, reference_ns);
+    run("ids + arrays", push_arrays, &instructions, num_instructions, num_passes, reference_ns);
+    run("typed builders", push_typed, &instructions, num_instructions, num_passes, reference_ns);
+    run("append", push_appends, &instructions, num_instructions, num_passes, reference_ns);
+
+    /* Encoding, with the forms matched from the operands or pre-resolved by the typed builders */
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    spasm_instructions_reset(&instructions);
+    push_varargs(&instructions, num_instructions);
+
+    uint64_t start = spasm_get_timestamp_ns();
+
+    bool res = spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL);
+
+    const uint64_t matched_ns = spasm_get_timestamp_ns() - start;
+    const size_t matched_size = spasm_bytecode_size(&bytecode);
+
+    spasm_bytecode_reset(&bytecode);
+    spasm_instructions_reset(&instructions);
+    push_typed(&instructions, num_instructions);
+
+    start = spasm_get_timestamp_ns();
+
+    res &= spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL);
+
+    const uint64_t resolved_ns = spasm_get_timestamp_ns() - start;
+
+    res &= spasm_bytecode_size(&bytecode) == matched_size;
+
+    printf("encode matched   | %8.3f ms      | %6.2f ns/instr\n",
+           (double)matched_ns / 1e6,
+           (double)matched_ns / (double)num_instructions);
+    printf("encode resolved  | %8.3f ms      | %6.2f ns/instr | speedup: %5.2fx\n",
+           (double)resolved_ns / 1e6,
+           (double)resolved_ns / (double)num_instructions,
+           (double)matched_ns / (double)resolved_ns);
+
+    spasm_bytecode_destroy(&bytecode);
+
+    const bool failed = !res || ctx.stats.num_errors != 0;
+
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Whole-stream pass over the contiguous instruction storage, compared to the same pass over
+    the previous layout (a vector of pointers to instructions whose operands live in a separate
+    block, allocated in a scattered order). The pass is a peephole-like scan looking for
+    "mov reg, reg" pairs, followed by a full encode for reference.
+
+    Usage: bench_instruction_layout [num_instructions] [num_passes]
+*/
+
+#include "spasm/bytecode.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Previous layout: instruction header pointing to its operands */
+typedef struct
+{
+    uint16_t mnemonic;
+    SpasmOperand* operands;
+    uint8_t num_operands;
+} ScatteredInstruction;
+
+static bool is_mov_reg_reg(uint16_t mnemonic, uint8_t num_operands, const SpasmOperand* operands)
+{
+    return mnemonic == SpasmMnemonic_x86_64_MOV &&
+           num_operands == 2 &&
+           operands[0].type == SpasmOperandType_Register &&
+           operands[1].type == SpasmOperandType_Register;
+}
+
+static size_t scan_contiguous(SpasmInstructions* instructions)
+{
+    size_t num_pairs = 0;
+
+    bool previous = false;
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        const bool current = is_mov_reg_reg(instr->mnemonic, instr->num_operands, instr->operands);
+
+        num_pairs += (size_t)(previous && current);
+        previous = current;
+    }
+
+    return num_pairs;
+}
+
+static size_t scan_scattered(ScatteredInstruction** instructions, size_t num_instructions)
+{
+    size_t num_pairs = 0;
+
+    bool previous = false;
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        const ScatteredInstruction* instr = instructions[i];
+
+        const bool current = is_mov_reg_reg(instr->mnemonic, instr->num_operands, instr->operands);
+
+        num_pairs += (size_t)(previous && current);
+        previous = current;
+    }
+
+    return num_pairs;
+}
+
+static void push_instructions(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        switch(i % 4)
+        {
+            case 0:
+            case 1:
+                spasm_instructions_push_back(instructions,
+                                             "mov",
+                                             SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                             SpasmOpReg(SpasmRegister_x86_64_RBX));
+                break;
+            case 2:
+                spasm_instructions_push_back(instructions,
+                                             "add",
+                                             SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                             SpasmOpImm32(i));
+                break;
+            default:
+                spasm_instructions_push_back(instructions,
+                                             "mov",
+                                             SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1),
+                                             SpasmOpReg(SpasmRegister_x86_64_RAX));
+                break;
+        }
+    }
+}
+
+/* Copies the stream to the previous layout, allocating the instructions in a shuffled order */
+static ScatteredInstruction** make_scattered(SpasmInstructions* instructions)
+{
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    ScatteredInstruction** scattered = (ScatteredInstruction**)malloc(num_instructions *
+                                                                     sizeof(ScatteredInstruction*));
+    size_t* order = (size_t*)malloc(num_instructions * sizeof(size_t));
+
+    for(size_t i = 0; i < num_instructions; i++)
+        order[i] = i;
+
+    srand(42);
+
+    for(size_t i = num_instructions - 1; i > 0; i--)
+    {
+        size_t j = ((size_t)rand() * ((size_t)RAND_MAX + 1) + (size_t)rand()) % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, order[i]);
+
+        ScatteredInstruction* copy = (ScatteredInstruction*)malloc(sizeof(ScatteredInstruction));
+        copy->mnemonic = instr->mnemonic;
+        copy->num_operands = instr->num_operands;
+        copy->operands = (SpasmOperand*)malloc(instr->num_operands * sizeof(SpasmOperand));
+        memcpy(copy->operands, instr->operands, instr->num_operands * sizeof(SpasmOperand));
+
+        scattered[order[i]] = copy;
+    }
+
+    free(order);
+
+    return scattered;
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_instructions = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+    uint32_t num_passes = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20;
+
+    if(num_instructions < 2 || num_passes == 0)
+    {
+        fprintf(stderr, "Usage: bench_instruction_layout [num_instructions] [num_passes]\n");
+        return 1;
+    }
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    push_instructions(&instructions, num_instructions);
+
+    ScatteredInstruction** scattered = make_scattered(&instructions);
+
+    printf("instructions: %zu, passes: %u, instruction record: %zu bytes\n",
+           num_instructions,
+           num_passes,
+           sizeof(SpasmInstruction));
+
+    size_t contiguous_pairs = 0;
+    size_t scattered_pairs = 0;
+
+    uint64_t start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_passes; i++)
+        contiguous_pairs += scan_contiguous(&instructions);
+
+    const uint64_t contiguous_ns = spasm_get_timestamp_ns() - start;
+
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t i = 0; i < num_passes; i++)
+        scattered_pairs += scan_scattered(scattered, num_instructions);
+
+    const uint64_t scattered_ns = spasm_get_timestamp_ns() - start;
+
+    if(contiguous_pairs != scattered_pairs)
+    {
+        fprintf(stderr, "Scans do not match (%zu != %zu)\n", contiguous_pairs, scattered_pairs);
+        return 1;
+    }
+
+    printf("scan contiguous | %8.3f ms/pass | %6.2f ns/instr\n",
+           (double)contiguous_ns / 1e6 / num_passes,
+           (double)contiguous_ns / (double)num_instructions / num_passes);
+    printf("scan scattered  | %8.3f ms/pass | %6.2f ns/instr | contiguous speedup: %.2fx\n",
+           (double)scattered_ns / 1e6 / num_passes,
+           (double)scattered_ns / (double)num_instructions / num_passes,
+           (double)scattered_ns / (double)contiguous_ns);
+
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    start = spasm_get_timestamp_ns();
+
+    bool res = spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL);
+
+    const uint64_t encode_ns = spasm_get_timestamp_ns() - start;
+
+    printf("encode          | %8.3f ms      | %6.2f ns/instr | %zu bytes\n",
+           (double)encode_ns / 1e6,
+           (double)encode_ns / (double)num_instructions,
+           spasm_bytecode_size(&bytecode));
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        free(scattered[i]->operands);
+        free(scattered[i]);
+    }
+
+    free(scattered);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+
+    return res ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Instruction lengths computed without emission, compared to a full encoding of the same
+    instructions: one instruction at a time (spasm_x86_64_instruction_length against
+    spasm_x86_64_try_encode_instruction), and for the whole stream (spasm_x86_64_instructions_offsets
+    against spasm_x86_64_encode_instructions, sequential).
+
+    Usage: bench_instruction_length [num_instructions] [num_passes]
+*/
+
+#include "spasm/bytecode.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+static void push_instructions(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        switch(i % 5)
+        {
+            case 0:
+                spasm_instructions_push(instructions,
+                                        SpasmMnemonic_x86_64_MOV,
+                                        SpasmOpReg(SpasmRegister_x86_64_R10),
+                                        SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, (i % 64) * 8, 1));
+                break;
+            case 1:
+                spasm_instructions_push(instructions,
+                                        SpasmMnemonic_x86_64_ADD,
+                                        SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                        SpasmOpImm32(i));
+                break;
+            case 2:
+                spasm_instructions_push(instructions,
+                                        SpasmMnemonic_x86_64_VADDPS,
+                                        SpasmOpReg(SpasmRegister_x86_64_YMM0),
+                                        SpasmOpReg(SpasmRegister_x86_64_YMM1),
+                                        SpasmOpReg(SpasmRegister_x86_64_YMM2));
+                break;
+            case 3:
+                spasm_instructions_push(instructions,
+                                        SpasmMnemonic_x86_64_MOV,
+                                        SpasmOpMemory(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_RCX, 16, 8),
+                                        SpasmOpReg(SpasmRegister_x86_64_RAX));
+                break;
+            default:
+                spasm_instructions_push(instructions,
+                                        SpasmMnemonic_x86_64_SUB,
+                                        SpasmOpReg(SpasmRegister_x86_64_RCX),
+                                        SpasmOpReg(SpasmRegister_x86_64_RDX));
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_instructions = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 100000;
+    uint32_t num_passes = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20;
+
+    if(num_instructions == 0 || num_passes == 0)
+    {
+        fprintf(stderr, "Usage: bench_instruction_length [num_instructions] [num_passes]\n");
+        return 1;
+    }
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_max_encoding_threads(&ctx, 1);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    push_instructions(&instructions, num_instructions);
+
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    size_t* offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+
+    size_t length_total = 0;
+    size_t encode_total = 0;
+
+    /* One instruction at a time */
+    uint64_t start = spasm_get_timestamp_ns();
+
+    for(uint32_t p = 0; p < num_passes; p++)
+        for(size_t i = 0; i < num_instructions; i++)
+            length_total += spasm_x86_64_instruction_length(spasm_instructions_at(&instructions, i));
+
+    const uint64_t length_ns = spasm_get_timestamp_ns() - start;
+
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t p = 0; p < num_passes; p++)
+    {
+        for(size_t i = 0; i < num_instructions; i++)
+        {
+            spasm_bytecode_reset(&bytecode);
+            spasm_x86_64_try_encode_instruction(NULL, spasm_instructions_at(&instructions, i), &bytecode, NULL);
+            encode_total += spasm_bytecode_size(&bytecode);
+        }
+    }
+
+    const uint64_t encode_ns = spasm_get_timestamp_ns() - start;
+
+    /* Whole stream */
+    bool res = true;
+
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t p = 0; p < num_passes; p++)
+        res &= spasm_x86_64_instructions_offsets(&ctx, &instructions, offsets);
+
+    const uint64_t offsets_ns = spasm_get_timestamp_ns() - start;
+
+    start = spasm_get_timestamp_ns();
+
+    for(uint32_t p = 0; p < num_passes; p++)
+    {
+        spasm_bytecode_reset(&bytecode);
+        res &= spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, offsets);
+    }
+
+    const uint64_t stream_ns = spasm_get_timestamp_ns() - start;
+
+    if(!res || length_total != encode_total || offsets[num_instructions - 1] != spasm_bytecode_size(&bytecode))
+    {
+        fprintf(stderr, "Lengths do not match the encoding\n");
+        return 1;
+    }
+
+    const double num_total = (double)num_instructions * (double)num_passes;
+
+    printf("instructions: %zu, passes: %u, code size: %zu bytes\n",
+           num_instructions,
+           num_passes,
+           spasm_bytecode_size(&bytecode));
+    printf("instruction length | %6.2f ns/instr\n", (double)length_ns / num_total);
+    printf("instruction encode | %6.2f ns/instr | length speedup: %.2fx\n",
+           (double)encode_ns / num_total,
+           (double)encode_ns / (double)length_ns);
+    printf("stream offsets     | %6.2f ns/instr\n", (double)offsets_ns / num_total);
+    printf("stream encode      | %6.2f ns/instr | offsets speedup: %.2fx\n",
+           (double)stream_ns / num_total,
+           (double)stream_ns / (double)offsets_ns);
+
+    free(offsets);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Parallel encoding benchmark: encodes a single large instruction stream with 1 to N encoding
+    threads and checks the output is identical to the sequential encoding.
+
+    Usage: bench_parallel_encoding [num_instructions] [max_threads]
+*/
+
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void push_stream(SpasmInstructions* instructions, size_t num_instructions)
+{
+    for(size_t i = 0; i < num_instructions / 4; i++)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RCX),
+                                     SpasmOpImm32((int32_t)i));
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1),
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_instructions = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 400000;
+
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    push_stream(&instructions, num_instructions);
+
+    const uint32_t num_cpus = spasm_get_num_cpus();
+    const uint32_t max_threads = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : num_cpus;
+
+    printf("cpus: %u, instructions: %zu, min chunk: %u\n",
+           num_cpus,
+           num_instructions,
+           (uint32_t)SPASM_X86_64_PARALLEL_ENCODING_MIN_CHUNK);
+
+    SpasmByteCode reference = spasm_bytecode_new(NULL);
+    double sequential_ms = 0.0;
+
+    for(uint32_t num_threads = 1; num_threads <= max_threads; num_threads <<= 1)
+    {
+        SpasmContext ctx;
+        spasm_context_init(&ctx);
+        spasm_context_set_max_encoding_threads(&ctx, num_threads);
+
+        SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+        uint64_t start = spasm_get_timestamp_ns();
+
+        if(!spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL))
+        {
+            fprintf(stderr, "Encoding failed with %u threads\n", num_threads);
+            return 1;
+        }
+
+        double elapsed_ms = (double)(spasm_get_timestamp_ns() - start) / 1e6;
+
+        size_t size = 0;
+        const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+        if(num_threads == 1)
+        {
+            sequential_ms = elapsed_ms;
+            spasm_bytecode_push_bytes(&reference, bytes, size);
+        }
+        else
+        {
+            size_t reference_size = 0;
+            const SpasmByte* reference_bytes = spasm_bytecode_get(&reference, &reference_size);
+
+            if(size != reference_size || memcmp(bytes, reference_bytes, size) != 0)
+            {
+                fprintf(stderr, "Parallel encoding with %u threads differs from the sequential encoding\n", num_threads);
+                return 1;
+            }
+        }
+
+        printf("threads: %2u | time: %9.3f ms | %12.0f instr/s | speedup: %5.2fx\n",
+               num_threads,
+               elapsed_ms,
+               (double)num_instructions / (elapsed_ms / 1e3),
+               sequential_ms / elapsed_ms);
+
+        spasm_bytecode_destroy(&bytecode);
+        spasm_context_release(&ctx);
+    }
+
+    spasm_bytecode_destroy(&reference);
+    spasm_instructions_destroy(&instructions);
+
+    return 0;
+}
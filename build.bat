@@ -10,6 +10,8 @@ call :LogInfo "Building spasm"
 
 set BUILDTYPE=Release
 set RUNTESTS=0
+set BUILDBENCHMARKS=0
+set BUILDTOOLS=0
 set REMOVEOLDDIR=0
 set ARCH=x64
 set VERSION="0.0.0"
@@ -42,7 +44,7 @@ if %REMOVEOLDDIR% equ 1 (
 call :LogInfo "Build type: %BUILDTYPE%"
 call :LogInfo "Build version: %VERSION%"
 
-cmake -S . -B build -DRUN_TESTS=%RUNTESTS% -A="%ARCH%" -DVERSION=%VERSION%
+cmake -S . -B build -DRUN_TESTS=%RUNTESTS% -DBUILD_BENCHMARKS=%BUILDBENCHMARKS% -DBUILD_TOOLS=%BUILDTOOLS% -A="%ARCH%" -DVERSION=%VERSION%
 
 if %errorlevel% neq 0 (
     call :LogError "Error caught during CMake configuration"
@@ -94,6 +96,10 @@ if "%~1" equ "--reldebug" set BUILDTYPE=RelWithDebInfo
 
 if "%~1" equ "--tests" set RUNTESTS=1
 
+if "%~1" equ "--benchmarks" set BUILDBENCHMARKS=1
+
+if "%~1" equ "--tools" set BUILDTOOLS=1
+
 if "%~1" equ "--clean" set REMOVEOLDDIR=1
 
 if "%~1" equ "--install" set INSTALL=1
@@ -62,4 +62,12 @@ SPASM_API size_t get_call_max_args_fp_registers(SpasmABI abi);
 SPASM_API const SpasmRegister* get_call_args_gp_registers(SpasmABI abi, size_t* num_registers);
 SPASM_API const SpasmRegister* get_call_args_fp_registers(SpasmABI abi, size_t* num_registers);
 
+/* 
+    Returns the registers a function call preserves (callee-saved), the others are clobbered.
+    The number of registers is passed to the parameter num_registers, it can be 0 (no vector
+    register is preserved on Linux)
+*/
+SPASM_API const SpasmRegister* get_callee_saved_gp_registers(SpasmABI abi, size_t* num_registers);
+SPASM_API const SpasmRegister* get_callee_saved_fp_registers(SpasmABI abi, size_t* num_registers);
+
 #endif /* !defined(__SPASM_ABI) */
\ No newline at end of file
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_ALLOCATOR)
+#define __SPASM_ALLOCATOR
+
+#include "spasm/common.h"
+
+/*
+    Allocator
+
+    Every allocation made by the library on behalf of an object (instructions, bytecode, data
+    tables, symbol references, object file buffers...) goes through the allocator of the context
+    the object is bound to (see spasm_context_set_allocator), or through the default allocator
+    (malloc/realloc/free) if there is none. The exceptions are the native handles of threads,
+    mutexes and condition variables (malloc/free, see spasm/thread.h), the buffers of the chunks of
+    a stream encoded in parallel (default allocator, they are filled by other threads) and
+    executable memory, mapped from the system (see spasm_executable_memory_alloc).
+
+    The size of the block is always passed back on realloc and free, so allocators do not need
+    to store it (arenas, pools) and can account memory exactly.
+    An allocator is only called from the thread using the context it is installed in.
+*/
+
+typedef struct
+{
+    void* (*alloc)(size_t size, void* user_data);
+    void* (*realloc)(void* ptr, size_t old_size, size_t new_size, void* user_data);
+    void (*free)(void* ptr, size_t size, void* user_data);
+    void* user_data;
+} SpasmAllocator;
+
+/*
+ * malloc/realloc/free
+ */
+SPASM_API const SpasmAllocator* spasm_get_default_allocator(void);
+
+static SPASM_FORCE_INLINE void* spasm_allocator_alloc(const SpasmAllocator* allocator, size_t size)
+{
+    return allocator->alloc(size, allocator->user_data);
+}
+
+static SPASM_FORCE_INLINE void* spasm_allocator_realloc(const SpasmAllocator* allocator,
+                                                        void* ptr,
+                                                        size_t old_size,
+                                                        size_t new_size)
+{
+    return allocator->realloc(ptr, old_size, new_size, allocator->user_data);
+}
+
+static SPASM_FORCE_INLINE void spasm_allocator_free(const SpasmAllocator* allocator,
+                                                    void* ptr,
+                                                    size_t size)
+{
+    if(ptr != NULL)
+        allocator->free(ptr, size, allocator->user_data);
+}
+
+/*
+    Tracking allocator, forwards to a parent allocator and counts the allocations and the
+    memory in use, to get the exact memory footprint of a compilation
+*/
+
+typedef struct
+{
+    SpasmAllocator allocator; /* Pass &tracking->allocator to the context */
+    const SpasmAllocator* parent;
+
+    uint64_t num_allocs;
+    uint64_t num_reallocs;
+    uint64_t num_frees;
+    size_t bytes_in_use;
+    size_t peak_bytes_in_use;
+} SpasmTrackingAllocator;
+
+/*
+ * parent can be NULL to use the default allocator
+ */
+SPASM_API void spasm_tracking_allocator_init(SpasmTrackingAllocator* tracking,
+                                             const SpasmAllocator* parent);
+
+SPASM_API void spasm_tracking_allocator_reset_counters(SpasmTrackingAllocator* tracking);
+
+#endif /* !defined(__SPASM_ALLOCATOR) */
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_ARENA)
+#define __SPASM_ARENA
+
+#include "spasm/allocator.h"
+
+/* Bump allocator over blocks obtained from a SpasmAllocator, everything is freed at once */
+
+#define SPASM_ARENA_DEFAULT_BLOCK_SIZE 4096
+
+typedef struct SpasmArenaBlock
+{
+    struct SpasmArenaBlock* next;
+    size_t size;
+    size_t used;
+} SpasmArenaBlock;
+
+typedef struct
+{
+    SpasmArenaBlock* head;
+    SpasmArenaBlock* free_blocks; /* Blocks kept by spasm_arena_reset, reused before allocating */
+    size_t block_size;
+    const SpasmAllocator* allocator;
+} SpasmArena;
+
+/*
+ * Nothing is allocated until the first push. allocator can be NULL to use the default allocator
+ */
+SPASM_API void spasm_arena_init(SpasmArena* arena, size_t block_size, const SpasmAllocator* allocator);
+
+/*
+ * Returns a 16 bytes aligned pointer to size bytes, or NULL on allocation failure
+ */
+SPASM_API void* spasm_arena_push(SpasmArena* arena, size_t size);
+
+/*
+ * Invalidates everything pushed so far but keeps the blocks for the next pushes
+ */
+SPASM_API void spasm_arena_reset(SpasmArena* arena);
+
+SPASM_API void spasm_arena_release(SpasmArena* arena);
+
+#endif /* !defined(__SPASM_ARENA) */
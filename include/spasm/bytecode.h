@@ -8,26 +8,37 @@
 #define __SPASM_BYTE
 
 #include "spasm/common.h"
-
-#include "libromano/vector.h"
+#include "spasm/context.h"
+#include "spasm/vector.h"
 
 typedef uint8_t SpasmByte;
 
 typedef struct
 {
-    Vector data;
+    SpasmVector data;
+    SpasmContext* ctx;
 } SpasmByteCode;
 
-SPASM_API SpasmByteCode spasm_bytecode_new(void);
+/*
+ * ctx can be NULL (see spasm/context.h)
+ */
+SPASM_API SpasmByteCode spasm_bytecode_new(SpasmContext* ctx);
 
 SPASM_API void spasm_bytecode_push_back(SpasmByteCode* bytecode, SpasmByte byte);
 
+SPASM_API void spasm_bytecode_push_bytes(SpasmByteCode* bytecode, const SpasmByte* bytes, size_t size);
+
 SPASM_API void spasm_bytecode_debug(SpasmByteCode* bytecode);
 
 SPASM_API size_t spasm_bytecode_size(SpasmByteCode* bytecode);
 
 SPASM_API SpasmByte* spasm_bytecode_get(SpasmByteCode* bytecode, size_t* size);
 
+/*
+ * Removes all the bytes but keeps the memory for the next ones
+ */
+SPASM_API void spasm_bytecode_reset(SpasmByteCode* bytecode);
+
 SPASM_API void spasm_bytecode_destroy(SpasmByteCode* bytecode);
 
 #define BYTE(x) ((SpasmByte)x)
@@ -138,14 +138,11 @@
 #define SPASM_ASSERT(expr, message)
 #endif /* defined(DEBUG_BUILD) */
 
-#define SPASM_STATIC_ASSERT(expr)        \
-    struct CONCAT(__outscope_assert_, __COUNTER__)      \
-    {                                                   \
-        char                                            \
-        outscope_assert                                 \
-        [2*(expr)-1];                                   \
-                                                        \
-    } CONCAT(__outscope_assert_, __COUNTER__)
+#if defined(__cplusplus)
+#define SPASM_STATIC_ASSERT(expr, message) static_assert(expr, message)
+#else
+#define SPASM_STATIC_ASSERT(expr, message) _Static_assert(expr, message)
+#endif /* defined(__cplusplus) */
 
 #define SPASM_NOT_IMPLEMENTED fprintf(stderr, "Function " SPASM_FUNCTION " not implemented"); exit(1);
 
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_COMPILE_QUEUE)
+#define __SPASM_COMPILE_QUEUE
+
+#include "spasm/abi.h"
+#include "spasm/bytecode.h"
+#include "spasm/context.h"
+#include "spasm/data.h"
+#include "spasm/instruction.h"
+
+/*
+    Background compilation queue
+
+    Jobs (instructions + data -> bytecode) are assembled on a pool of worker threads with the jit
+    assembler of the queue abi. Each worker owns a deque per priority and idle workers steal from
+    the others, always looking at higher priorities first so hot jobs jump ahead of speculative ones
+    queued anywhere in the pool.
+
+    Until a job is finished, its instructions, data and bytecode belong to the worker running it
+    (and so do the contexts they are bound to): the submitting thread must not touch them before
+    spasm_compile_job_poll/wait reports the job as finished.
+*/
+
+typedef enum
+{
+    SpasmCompilePriority_High,
+    SpasmCompilePriority_Normal,
+    SpasmCompilePriority_Low,
+    SpasmCompilePriority_COUNT,
+} SpasmCompilePriority;
+
+typedef enum
+{
+    SpasmCompileJobStatus_Pending,
+    SpasmCompileJobStatus_Running,
+    SpasmCompileJobStatus_Done,
+    SpasmCompileJobStatus_Failed,
+} SpasmCompileJobStatus;
+
+typedef struct
+{
+    uint64_t queued_ns; /* Time spent in the queue before a worker picked the job */
+    uint64_t run_ns;    /* Time spent assembling */
+    uint64_t total_ns;  /* Latency from submission to completion */
+} SpasmCompileJobTimings;
+
+typedef struct SpasmCompileQueue SpasmCompileQueue;
+
+typedef struct SpasmCompileJob SpasmCompileJob;
+
+/*
+ * Pass 0 as num_workers to use one worker per cpu. Returns NULL on failure.
+ * The queue and its jobs are allocated with the allocator of ctx (which can be NULL for the default
+ * one), and ctx must outlive the queue. The allocator is called by the threads creating the queue,
+ * submitting, releasing the jobs and destroying the queue, never by the workers
+ */
+SPASM_API SpasmCompileQueue* spasm_compile_queue_new(SpasmContext* ctx, SpasmABI abi, uint32_t num_workers);
+
+SPASM_API uint32_t spasm_compile_queue_num_workers(SpasmCompileQueue* queue);
+
+/*
+ * Returns a handle to poll or wait on, that must be released with spasm_compile_job_release.
+ * Returns NULL on failure
+ */
+SPASM_API SpasmCompileJob* spasm_compile_queue_submit(SpasmCompileQueue* queue,
+                                                      SpasmInstructions* instructions,
+                                                      SpasmData* data,
+                                                      SpasmByteCode* bytecode,
+                                                      SpasmCompilePriority priority);
+
+/*
+ * Non-blocking
+ */
+SPASM_API SpasmCompileJobStatus spasm_compile_job_poll(SpasmCompileJob* job);
+
+/*
+ * Blocks until the job is done or failed
+ */
+SPASM_API SpasmCompileJobStatus spasm_compile_job_wait(SpasmCompileJob* job);
+
+/*
+ * Only valid once the job is finished
+ */
+SPASM_API SpasmCompileJobTimings spasm_compile_job_get_timings(SpasmCompileJob* job);
+
+/*
+ * Waits for the job if it is not finished yet, and frees it
+ */
+SPASM_API void spasm_compile_job_release(SpasmCompileJob* job);
+
+/*
+ * Finishes all the submitted jobs, then stops the workers and frees the queue
+ */
+SPASM_API void spasm_compile_queue_destroy(SpasmCompileQueue* queue);
+
+#endif /* !defined(__SPASM_COMPILE_QUEUE) */
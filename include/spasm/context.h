@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_CONTEXT)
+#define __SPASM_CONTEXT
+
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+
+/*
+    A context holds everything that would otherwise be shared mutable state in the library
+    (error sink, statistics...). SpasmInstructions, SpasmByteCode and SpasmData are bound to a
+    context when they are created, and every operation on them reports through it.
+
+    Threading rules:
+        - a context must only be used by one thread at a time
+        - objects bound to different contexts can be used concurrently without any locking
+        - passing a NULL context uses the default behavior (errors are printed to stderr and
+          no statistics are recorded), which is safe to share between threads
+
+    Errors:
+        errors are reported as SpasmError records (see spasm/error.h). A context counts them and
+        keeps the last one, and forwards them to the error callback if one is installed. Nothing is
+        formatted nor printed unless the callback does it (with spasm_error_format)
+*/
+
+typedef void (*SpasmErrorCallback)(const SpasmError* error, void* user_data);
+
+typedef struct
+{
+    uint64_t num_instructions_pushed;
+    uint64_t num_instructions_encoded;
+    uint64_t num_bytes_encoded;
+    uint64_t num_errors;
+} SpasmStats;
+
+typedef struct
+{
+    SpasmErrorCallback error_callback;
+    void* error_user_data;
+
+    /* NULL uses the default allocator */
+    const SpasmAllocator* allocator;
+
+    /* Maximum number of threads used to encode a single large stream, 0 and 1 encode sequentially */
+    uint32_t max_encoding_threads;
+
+    SpasmStats stats;
+
+    SpasmError last_error;
+} SpasmContext;
+
+SPASM_API void spasm_context_init(SpasmContext* ctx);
+
+/*
+ * Installs a callback receiving the error records, pass NULL to only record them
+ */
+SPASM_API void spasm_context_set_error_callback(SpasmContext* ctx,
+                                                SpasmErrorCallback callback,
+                                                void* user_data);
+
+/*
+ * Installs the allocator used by all the objects bound to this context (see spasm/allocator.h),
+ * it must be set before creating them and stay alive until they are destroyed. Pass NULL to use
+ * the default allocator
+ */
+SPASM_API void spasm_context_set_allocator(SpasmContext* ctx, const SpasmAllocator* allocator);
+
+/*
+ * Returns the default allocator if ctx is NULL or has no allocator
+ */
+SPASM_API const SpasmAllocator* spasm_context_get_allocator(SpasmContext* ctx);
+
+/*
+ * Large instruction streams can be split in chunks encoded in parallel on up to max_threads
+ * threads (spasm_get_num_cpus() for one per cpu). Encoding is sequential on the calling thread by
+ * default, and always for the jobs of a SpasmCompileQueue, whose workers already run in parallel
+ */
+SPASM_API void spasm_context_set_max_encoding_threads(SpasmContext* ctx, uint32_t max_threads);
+
+/*
+ * Reports an error through the context error sink. ctx can be NULL, the error is then
+ * formatted and printed to stderr
+ */
+SPASM_API void spasm_context_report(SpasmContext* ctx, const SpasmError* error);
+
+/*
+ * Shorthand to report errors that only carry a code and an optional name
+ */
+SPASM_API void spasm_context_report_code(SpasmContext* ctx,
+                                         SpasmErrorCode code,
+                                         const char* name,
+                                         size_t name_len);
+
+/*
+ * Returns the last reported error, its code is SpasmErrorCode_None if no error has been reported
+ */
+SPASM_API const SpasmError* spasm_context_get_last_error(SpasmContext* ctx);
+
+SPASM_API void spasm_context_reset_stats(SpasmContext* ctx);
+
+SPASM_API void spasm_context_release(SpasmContext* ctx);
+
+#define SPASM_CONTEXT_STAT_ADD(ctx, stat, value) if((ctx) != NULL) { (ctx)->stats.stat += (value); }
+
+#endif /* !defined(__SPASM_CONTEXT) */
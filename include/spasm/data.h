@@ -8,9 +8,9 @@
 #define __SPASM_DATA
 
 #include "spasm/common.h"
-
-#include "libromano/hashmap.h"
-#include "libromano/vector.h"
+#include "spasm/context.h"
+#include "spasm/hashmap.h"
+#include "spasm/vector.h"
 
 typedef enum
 {
@@ -57,6 +57,8 @@ typedef enum {
                     "internal"
 
     symbols_index: shared by all the tables to assign a unique index for each symbol
+
+    refs_pool: symbol refs vectors emptied by spasm_data_reset, reused by the next symbols
 */
 
 typedef struct
@@ -68,7 +70,7 @@ typedef struct
 typedef struct
 {
     void* runtime_address; /* For jit-execution */
-    Vector* refs;
+    SpasmVector refs;
     uint32_t index;
 } SpasmExternSymbol;
 
@@ -81,7 +83,7 @@ typedef struct
 typedef struct
 {
     size_t start_offset;
-    Vector* refs;
+    SpasmVector refs;
     uint32_t index;
 } SpasmExportSymbol;
 
@@ -94,25 +96,30 @@ typedef struct
 typedef struct
 {
     size_t start_offset;
-    Vector* refs;
+    SpasmVector refs;
 } SpasmInternSymbol;
 
 typedef struct
 {
-    HashMap* rodata;
-    HashMap* data;
-    HashMap* bss;
-    HashMap* extern_symbols;
-    HashMap* export_symbols;
-    HashMap* intern_symbols;
+    SpasmHashMap rodata;
+    SpasmHashMap data;
+    SpasmHashMap bss;
+    SpasmHashMap extern_symbols;
+    SpasmHashMap export_symbols;
+    SpasmHashMap intern_symbols;
 
     uint32_t symbols_index;
+
+    SpasmVector refs_pool;
+
+    SpasmContext* ctx;
 } SpasmData;
 
 /*
- * Returns false on failure (memory allocation from HashMap members)
+ * Returns false on failure. Nothing is allocated until data or symbols are added
+ * ctx can be NULL (see spasm/context.h)
  */
-SPASM_API bool spasm_data_init(SpasmData* data);
+SPASM_API bool spasm_data_init(SpasmData* data, SpasmContext* ctx);
 
 SPASM_API void spasm_data_add_bytes(SpasmData* data,
                                     const char* data_name,
@@ -137,7 +144,7 @@ typedef struct
     const char* name;
     uint32_t name_sz;
     SpasmExternSymbol* symbol;
-    HashMapIterator hashmap_it;
+    SpasmHashMapIterator hashmap_it;
 } SpasmDataExternSymbolIterator;
 
 SPASM_API void spasm_data_extern_symbol_iterator_init(SpasmDataExternSymbolIterator* it);
@@ -167,7 +174,7 @@ typedef struct
     const char* name;
     uint32_t name_sz;
     SpasmExportSymbol* symbol;
-    HashMapIterator hashmap_it;
+    SpasmHashMapIterator hashmap_it;
 } SpasmDataExportSymbolIterator;
 
 SPASM_API void spasm_data_export_symbol_iterator_init(SpasmDataExportSymbolIterator* it);
@@ -195,7 +202,7 @@ typedef struct
     const char* name;
     uint32_t name_sz;
     SpasmInternSymbol* symbol;
-    HashMapIterator hashmap_it;
+    SpasmHashMapIterator hashmap_it;
 } SpasmDataInternSymbolIterator;
 
 SPASM_API void spasm_data_intern_symbol_iterator_init(SpasmDataInternSymbolIterator* it);
@@ -203,7 +210,13 @@ SPASM_API void spasm_data_intern_symbol_iterator_init(SpasmDataInternSymbolItera
 SPASM_API bool spasm_data_iterate_intern_symbols(SpasmData* data,
                                                  SpasmDataInternSymbolIterator* it);
 
-/* Destructor */
+/* Reset / Destructor */
+
+/*
+ * Removes all the data and symbols but keeps the memory, so the next compile using data does
+ * not allocate as long as it does not need more than the previous ones
+ */
+SPASM_API void spasm_data_reset(SpasmData* data);
 
 SPASM_API void spasm_data_release(SpasmData* data);
 
@@ -17,6 +17,69 @@
 #define SPASM_ERROR_BUFFER_MAX_SZ 4096
 #endif /* !defined(SPASM_ERROR_BUFFER_MAX_SZ) */
 
+/*
+    Structured errors
+
+    Errors are reported as a small record (code + pointers to what failed) that is never formatted
+    by the library itself, so failing is cheap (no formatting, no io). A message can be built from
+    the record with spasm_error_format, typically from an error callback (see spasm/context.h).
+*/
+
+typedef enum
+{
+    SpasmErrorCode_None,
+    SpasmErrorCode_UnknownInstruction, /* No encoding form matches the mnemonic and operands */
+    SpasmErrorCode_SymbolAlreadyExported,
+    SpasmErrorCode_SymbolNotExported,
+    SpasmErrorCode_SymbolNotFound,
+    SpasmErrorCode_UnsupportedABI,
+    SpasmErrorCode_InvalidByteCode,
+    SpasmErrorCode_OutOfMemory,
+    SpasmErrorCode_FileOpen,
+    SpasmErrorCode_FileWrite,
+    SpasmErrorCode_TooManyOperands, /* More than SPASM_MAX_OPERANDS operands pushed */
+    SpasmErrorCode_UnknownMnemonic, /* Mnemonic string not found in the mnemonic table */
+    SpasmErrorCode_InvalidLabel, /* Label not created by the stream, never bound or bound twice */
+    SpasmErrorCode_BranchOutOfRange, /* Branch target too far for the forms of the mnemonic */
+    SpasmErrorCode_InvalidAlignment, /* Invalid alignment or boundary (not a power of two, too large...) */
+    SpasmErrorCode_InvalidVirtualRegister, /* Virtual register not created by the stream, or seen with two register files */
+    SpasmErrorCode_TooManySpills, /* Not enough scratch registers for the spilled operands of an instruction */
+    SpasmErrorCode_UnsupportedUarch, /* Microarchitecture without a cost profile */
+    SpasmErrorCode_InvalidCallArgument, /* Call argument or return value not matching its type, or too many arguments */
+    SpasmErrorCode_COUNT,
+} SpasmErrorCode;
+
+typedef struct SpasmError SpasmError;
+
+typedef size_t (*SpasmErrorFormatFunc)(const SpasmError* error, char* buffer, size_t buffer_size);
+
+/*
+    The pointers are borrowed from the objects that failed, and are only valid as long as
+    these objects are not modified or destroyed
+*/
+struct SpasmError
+{
+    SpasmErrorCode code;
+
+    /* Instruction that failed (SpasmInstruction*), for instruction errors */
+    const void* instruction;
+
+    /* Symbol, file or abi name (not null-terminated) */
+    const char* name;
+    size_t name_len;
+
+    /* Formats the instruction, set by the backend reporting an instruction error */
+    SpasmErrorFormatFunc format_instruction;
+};
+
+SPASM_API const char* spasm_error_code_as_string(SpasmErrorCode code);
+
+/*
+ * Formats a human readable message for the error, returns the length of the message
+ * (truncated to buffer_size - 1)
+ */
+SPASM_API size_t spasm_error_format(const SpasmError* error, char* buffer, size_t buffer_size);
+
 static void spasm_warning(const char* format, ...)
 {
     va_list val;
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_FFI)
+#define __SPASM_FFI
+
+#include "spasm/common.h"
+#include "spasm/context.h"
+
+/*
+    Foreign function call thunks
+
+    A thunk calls a C function of a given signature with its arguments read from an array of 64 bits
+    slots, the way an interpreter holds them:
+
+        double add(int64_t a, double b);
+
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature); // Double(Int, Double)
+        uint64_t args[2]; // args[0] = a, args[1] = the bits of b
+        double result;
+        thunk((SpasmFFIFunction)add, args, &result);
+
+    Int slots hold integers and pointers, passed with 64 bits (the callee only reads its width).
+    Float slots hold the bits of the float in their low 32 bits, Double slots the bits of the double.
+    The result is stored with the size of the return type (8 bytes for Int).
+
+    Each thunk is generated once per signature with spasm_x86_64_emit_call for the current ABI, and
+    cached by the hash of the signature. Lookups do not lock and the thunks are never freed before
+    the cache, so the cache and its thunks can be shared by any number of threads. Thunks for new
+    signatures are generated under a lock, in executable memory (see spasm/platform.h)
+*/
+
+#define SPASM_FFI_MAX_ARGS 16
+
+typedef enum
+{
+    SpasmFFIType_Void, /* Return type only */
+    SpasmFFIType_Int, /* Integers and pointers up to 64 bits */
+    SpasmFFIType_Float,
+    SpasmFFIType_Double,
+} SpasmFFIType;
+
+typedef struct
+{
+    uint8_t return_type; /* SpasmFFIType */
+    uint8_t num_args;
+    uint8_t arg_types[SPASM_FFI_MAX_ARGS]; /* SpasmFFIType, only the first num_args are read */
+} SpasmFFISignature;
+
+/* Functions of any signature are passed as this type, and cast back to theirs by the thunk */
+typedef void (*SpasmFFIFunction)(void);
+
+typedef void (*SpasmFFIThunk)(SpasmFFIFunction function, const uint64_t* args, void* result);
+
+typedef struct SpasmFFICache SpasmFFICache;
+
+/*
+ * The cache holds up to capacity signatures (256 if 0). Returns NULL on failure, or if thunks cannot
+ * be generated for the current ABI.
+ * The cache memory comes from the allocator of ctx (which can be NULL for the default one), and ctx
+ * must outlive the cache. Thunks are generated under the cache lock by the thread requesting them,
+ * so the allocator is called from one thread at a time but not always the same one
+ */
+SPASM_API SpasmFFICache* spasm_ffi_cache_new(SpasmContext* ctx, uint32_t capacity);
+
+/*
+ * Returns the thunk of the signature, generated on the first request. Returns NULL for an invalid
+ * signature (a Void argument, more than SPASM_FFI_MAX_ARGS arguments), when the cache is full or if
+ * the thunk could not be generated
+ */
+SPASM_API SpasmFFIThunk spasm_ffi_cache_get(SpasmFFICache* cache, const SpasmFFISignature* signature);
+
+/*
+ * Number of thunks generated so far
+ */
+SPASM_API uint32_t spasm_ffi_cache_size(SpasmFFICache* cache);
+
+/*
+ * Frees the cache and all its thunks, no thread must be using them anymore
+ */
+SPASM_API void spasm_ffi_cache_destroy(SpasmFFICache* cache);
+
+#endif /* !defined(__SPASM_FFI) */
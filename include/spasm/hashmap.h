@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_HASHMAP)
+#define __SPASM_HASHMAP
+
+#include "spasm/allocator.h"
+#include "spasm/arena.h"
+
+/*
+    Hashmap with byte-string keys allocating through a SpasmAllocator.
+
+    Keys and values are copied in a single block per entry, pushed to an arena owned by the map,
+    so the value pointers stay valid until the map is cleared or released (data used by jitted
+    code points into them). Replacing an entry does not reclaim its previous block until then.
+    Iteration follows the insertion order.
+*/
+
+typedef struct
+{
+    void* key;
+    void* value;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t hash;
+} SpasmHashMapEntry;
+
+typedef struct
+{
+    SpasmHashMapEntry* entries;
+    uint32_t* buckets; /* Linear probing, entry index + 1, 0 if empty */
+    uint32_t size;
+    uint32_t entries_capacity;
+    uint32_t buckets_capacity;
+    SpasmArena blocks;
+    const SpasmAllocator* allocator;
+} SpasmHashMap;
+
+typedef uint32_t SpasmHashMapIterator;
+
+/*
+ * Nothing is allocated until the first insertion. allocator can be NULL to use the
+ * default allocator
+ */
+SPASM_API void spasm_hashmap_init(SpasmHashMap* map, const SpasmAllocator* allocator);
+
+/*
+ * Returns NULL if the key is not in the map
+ */
+SPASM_API void* spasm_hashmap_get(SpasmHashMap* map,
+                                  const void* key,
+                                  uint32_t key_size,
+                                  uint32_t* value_size);
+
+/*
+ * Inserts or replaces the value, returns a pointer to the stored value or NULL on
+ * allocation failure
+ */
+SPASM_API void* spasm_hashmap_insert(SpasmHashMap* map,
+                                     const void* key,
+                                     uint32_t key_size,
+                                     const void* value,
+                                     uint32_t value_size);
+
+static SPASM_FORCE_INLINE uint32_t spasm_hashmap_size(const SpasmHashMap* map)
+{
+    return map->size;
+}
+
+/*
+ * The iterator must be initialized to 0, returns false once all the entries have been visited
+ */
+SPASM_API bool spasm_hashmap_iterate(SpasmHashMap* map,
+                                     SpasmHashMapIterator* it,
+                                     void** key,
+                                     uint32_t* key_size,
+                                     void** value,
+                                     uint32_t* value_size);
+
+/*
+ * Removes all the entries but keeps the buckets, entries and blocks memory for reuse
+ */
+SPASM_API void spasm_hashmap_clear(SpasmHashMap* map);
+
+SPASM_API void spasm_hashmap_release(SpasmHashMap* map);
+
+#endif /* !defined(__SPASM_HASHMAP) */
@@ -8,27 +8,89 @@
 #define __SPASM_INSTRUCTION
 
 #include "spasm/operand.h"
+#include "spasm/mnemonic.h"
 #include "spasm/args_count.h"
 #include "spasm/abi.h"
+#include "spasm/context.h"
+#include "spasm/vector.h"
 
-#include "libromano/arena.h"
-#include "libromano/vector.h"
+#define SPASM_MAX_OPERANDS 4
 
-typedef SPASM_PACKED_STRUCT(struct
+/*
+    Instructions are fixed-size records with their operands inline, stored contiguously so passes
+    over the stream are a linear walk. Pointers to instructions are invalidated when pushing
+*/
+typedef struct
 {
-    const char* mnemonic;
-    SpasmOperand* operands;
-    uint8_t mnemonic_len;
+    uint16_t mnemonic; /* SpasmMnemonic */
     uint8_t num_operands;
-}) SpasmInstruction;
+    uint16_t form; /* Backend instruction table index + 1, 0 if the encoder matches the operands */
+    SpasmOperand operands[SPASM_MAX_OPERANDS];
+} SpasmInstruction;
+
+/*
+    Labels are branch targets local to a stream: created with spasm_instructions_new_label, used as
+    SpasmOpLabel operands of jmp/jcc/call, and bound to a position of the stream with
+    spasm_instructions_bind_label (a SpasmMnemonic_Label pseudo-instruction, so passes moving
+    instructions keep the bindings). Branches are sized when the stream is encoded
+*/
+typedef uint32_t SpasmLabel;
+
+/*
+    Virtual registers stand for values not given a register yet: created with
+    spasm_instructions_new_virtual_register and used as SpasmOpVirtualReg or SpasmOpVirtualMemory
+    operands, they are mapped to registers (or stack slots) by a register allocator such as
+    spasm_x86_64_allocate_registers before the stream is encoded
+*/
+typedef uint32_t SpasmVirtualRegister;
+
+/*
+    Code alignment is also a pseudo-instruction (SpasmMnemonic_Align), sized when the stream is
+    encoded from its offset in the bytecode. The padding is made of the recommended multi-byte NOPs,
+    or with SpasmAlignPadding_Prefixes, of redundant segment prefixes added to the instructions
+    before it where that is legal (the rest is still NOPs, so there are fewer instructions to decode).
+    Alignments hold in memory as long as the code is loaded at an address aligned as much
+*/
+#define SPASM_MAX_CODE_ALIGNMENT 256
+
+/*
+    Boundary records (SpasmMnemonic_Boundary, inserted by layout passes such as
+    spasm_x86_64_layout_branches) keep the next instructions from crossing or ending on a boundary:
+    operands are the boundary, the SpasmAlignPadding and the number of instructions covered (a
+    jump, or a macro-fused pair). They are only padded when needed, like an alignment
+*/
+#define SPASM_MAX_BOUNDARY_RECORDS 2
+
+typedef enum
+{
+    SpasmAlignPadding_Nops,
+    SpasmAlignPadding_Prefixes,
+} SpasmAlignPadding;
 
 typedef struct
 {
-    Vector instructions;
-    Arena instructions_data;
+    SpasmVector instructions;
+    SpasmContext* ctx;
+    uint32_t num_labels;
+    uint32_t num_paddings; /* Alignment and boundary records */
+    uint32_t num_virtual_registers;
 } SpasmInstructions;
 
-SPASM_API SpasmInstructions spasm_instructions_new(void);
+/*
+ * ctx can be NULL (see spasm/context.h)
+ */
+SPASM_API SpasmInstructions spasm_instructions_new(SpasmContext* ctx);
+
+static SPASM_FORCE_INLINE size_t spasm_instructions_size(const SpasmInstructions* instructions)
+{
+    return spasm_vector_size(&instructions->instructions);
+}
+
+static SPASM_FORCE_INLINE SpasmInstruction* spasm_instructions_at(const SpasmInstructions* instructions,
+                                                                  size_t index)
+{
+    return (SpasmInstruction*)spasm_vector_at(&instructions->instructions, index);
+}
 
 /*
  * Returns NULL if no data operand is found
@@ -47,7 +109,84 @@ SPASM_API SpasmOperand* spasm_instruction_has_data_operand(SpasmInstruction* ins
 SPASM_API SpasmOperand* spasm_instruction_has_symbol_operand(SpasmInstruction* instruction);
 
 /*
- * Implementation of the instruction_push_back, use the macro instead
+ * Reserves the record at the end of the stream (its form is 0), the operands are filled by the
+ * caller. Returns NULL on failure, after reporting the error
+ */
+SPASM_API SpasmInstruction* __spasm_instructions_push_record(SpasmInstructions* instructions,
+                                                             SpasmMnemonic mnemonic,
+                                                             uint8_t num_operands);
+
+/*
+ * Reserves a record carrying a pre-resolved form, the encoder then skips the operands matching.
+ * Meant for the generated typed builders (spasm/x86_64_emit.h), which fill the operands
+ */
+static SPASM_FORCE_INLINE SpasmInstruction* spasm_instructions_push_form(SpasmInstructions* instructions,
+                                                                         SpasmMnemonic mnemonic,
+                                                                         uint16_t form,
+                                                                         uint8_t num_operands)
+{
+    SpasmVector* vector = &instructions->instructions;
+
+    SpasmInstruction* instr = NULL;
+
+    if(vector->size < vector->capacity)
+    {
+        instr = (SpasmInstruction*)vector->data + vector->size;
+        vector->size++;
+
+        instr->mnemonic = (uint16_t)mnemonic;
+        instr->num_operands = num_operands;
+
+        SPASM_CONTEXT_STAT_ADD(instructions->ctx, num_instructions_pushed, 1);
+    }
+    else
+    {
+        instr = __spasm_instructions_push_record(instructions, mnemonic, num_operands);
+
+        if(instr == NULL)
+            return NULL;
+    }
+
+    instr->form = form;
+
+    return instr;
+}
+
+/*
+ * Returns a new label, not bound yet. Labels are numbered from 0 in creation order
+ */
+SPASM_API SpasmLabel spasm_instructions_new_label(SpasmInstructions* instructions);
+
+/*
+ * Binds the label to the current end of the stream (the next instruction pushed). A label must be
+ * bound exactly once before the stream is encoded
+ */
+SPASM_API bool spasm_instructions_bind_label(SpasmInstructions* instructions, SpasmLabel label);
+
+/*
+ * Returns a new virtual register. Virtual registers are numbered from 0 in creation order
+ */
+SPASM_API SpasmVirtualRegister spasm_instructions_new_virtual_register(SpasmInstructions* instructions);
+
+/*
+ * Aligns the next instruction pushed on alignment bytes (a power of two, at most
+ * SPASM_MAX_CODE_ALIGNMENT), reports SpasmErrorCode_InvalidAlignment otherwise
+ */
+SPASM_API bool spasm_instructions_align(SpasmInstructions* instructions,
+                                        uint32_t alignment,
+                                        SpasmAlignPadding padding);
+
+/*
+ * Implementation of the instructions_push macros, use the macros instead
+ */
+SPASM_API bool __spasm_instructions_push(SpasmInstructions* instructions,
+                                         SpasmMnemonic mnemonic,
+                                         uint8_t num_operands,
+                                         ...);
+
+/*
+ * Implementation of the instructions_push_back macros, use the macros instead. The mnemonic is
+ * looked up, unknown mnemonics are reported (SpasmErrorCode_UnknownMnemonic) and not pushed
  */
 SPASM_API bool __spasm_instructions_push_back(SpasmInstructions* instructions,
                                               const char* mnemonic,
@@ -56,7 +195,41 @@ SPASM_API bool __spasm_instructions_push_back(SpasmInstructions* instructions,
                                               ...);
 
 /*
- * Pushes an instruction (you need to pass the mnemonic length)
+ * Pushes an instruction from its mnemonic id and an array of num_operands operands, without
+ * any varargs marshalling
+ */
+SPASM_API bool spasm_instructions_push_array(SpasmInstructions* instructions,
+                                             SpasmMnemonic mnemonic,
+                                             const SpasmOperand* operands,
+                                             uint8_t num_operands);
+
+/*
+ * Appends count instructions at once (a single copy, nothing is validated), typically records
+ * prepared by a generator or taken from another stream
+ */
+SPASM_API bool spasm_instructions_append(SpasmInstructions* instructions,
+                                         const SpasmInstruction* src,
+                                         size_t count);
+
+/*
+ * Pushes an instruction from its mnemonic id (SpasmMnemonic_x86_64_MOV...)
+ */
+#define spasm_instructions_push(instructions, mnemonic, ...)    \
+    __spasm_instructions_push(instructions,                     \
+                              mnemonic,                         \
+                              (uint8_t)SPASM_NARG(__VA_ARGS__), \
+                              __VA_ARGS__)
+
+/*
+ * Pushes an instruction without any operands from its mnemonic id
+ */
+#define spasm_instructions_pushz(instructions, mnemonic) \
+    __spasm_instructions_push(instructions,              \
+                              mnemonic,                  \
+                              (uint8_t)0)
+
+/*
+ * Pushes an instruction from its mnemonic string (you need to pass the mnemonic length)
  */
 #define spasm_instructions_push_backv(instructions, mnemonic, mnemonic_len, ...) \
     __spasm_instructions_push_back(instructions,                                 \
@@ -66,7 +239,7 @@ SPASM_API bool __spasm_instructions_push_back(SpasmInstructions* instructions,
                                    __VA_ARGS__)
 
 /*
- * Pushes an instruction (mnemonic length is calculated by strlen)
+ * Pushes an instruction from its mnemonic string (mnemonic length is calculated by strlen)
  */
 #define spasm_instructions_push_back(instructions, mnemonic, ...)    \
     __spasm_instructions_push_back(instructions,                     \
@@ -76,7 +249,7 @@ SPASM_API bool __spasm_instructions_push_back(SpasmInstructions* instructions,
                                    __VA_ARGS__)
 
 /*
- * Pushes and instruction without any operands
+ * Pushes and instruction without any operands from its mnemonic string
  */
 #define spasm_instructions_push_backz(instructions, mnemonic)  \
      __spasm_instructions_push_back(instructions,              \
@@ -88,6 +261,11 @@ SPASM_API void spasm_instructions_debug(SpasmInstructions* instructions,
                                         SpasmABI abi,
                                         int32_t fd);
 
+/*
+ * Removes all the instructions, labels and virtual registers but keeps the memory for the next ones
+ */
+SPASM_API void spasm_instructions_reset(SpasmInstructions* instructions);
+
 SPASM_API void spasm_instructions_destroy(SpasmInstructions* instructions);
 
 #endif /* !defined(__SPASM_INSTRUCTION) */
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_MNEMONIC)
+#define __SPASM_MNEMONIC
+
+#include "spasm/common.h"
+
+#if defined(SPASM_ENABLE_X86_64)
+#include "spasm/x86_64_mnemonics.h"
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+/*
+    Mnemonics are identified by an enum generated from the instruction tables, strings are only
+    used at the edges (text input, debug output) through spasm_mnemonic_from_string and
+    spasm_mnemonic_as_string
+*/
+
+#define SPASM_MNEMONIC_ENUM_x86_64(id, name) SpasmMnemonic_x86_64_##id,
+
+typedef enum
+{
+    SpasmMnemonic_Invalid,
+
+    /* x86_64 mnemonics, generated by x86_64/generate.py */
+#if defined(SPASM_ENABLE_X86_64)
+    SPASM_X86_64_MNEMONICS(SPASM_MNEMONIC_ENUM_x86_64)
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+    /* Pseudo-instructions, resolved by the assembler and never encoded themselves */
+    SpasmMnemonic_Label, /* Binds its label operand to the next instruction */
+    SpasmMnemonic_Align, /* Pads the code up to the next multiple of its alignment operand */
+    SpasmMnemonic_Boundary, /* Pads the next instructions if they would cross or end on a boundary */
+
+    SpasmMnemonic_COUNT,
+} SpasmMnemonic;
+
+#undef SPASM_MNEMONIC_ENUM_x86_64
+
+/*
+ * Returns SpasmMnemonic_Invalid if the mnemonic is unknown. The lookup is a binary search, resolve
+ * the mnemonics once rather than for each instruction when possible
+ */
+SPASM_API SpasmMnemonic spasm_mnemonic_from_string(const char* s, size_t s_sz);
+
+/*
+ * Returns an empty string for SpasmMnemonic_Invalid, pseudo-instructions have names too
+ */
+SPASM_API const char* spasm_mnemonic_as_string(SpasmMnemonic mnemonic);
+
+static SPASM_FORCE_INLINE bool spasm_mnemonic_is_pseudo(uint16_t mnemonic)
+{
+    return mnemonic >= SpasmMnemonic_Label && mnemonic < SpasmMnemonic_COUNT;
+}
+
+#endif /* !defined(__SPASM_MNEMONIC) */
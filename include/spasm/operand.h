@@ -20,41 +20,55 @@ typedef enum
     SpasmOperandType_Imm64,
     SpasmOperandType_Data,
     SpasmOperandType_Symbol,
+    SpasmOperandType_Label, /* Branch target, resolved when encoding the stream */
+    SpasmOperandType_VirtualRegister, /* Mapped to a register (or spilled) by the register allocator */
 } SpasmOperandType;
 
 /*
-    Operand is 128 bits. Maybe we can limit imm_value to be 56 bits and pack an operand into 64 bits,
-    or find a way to encode the 64 bits imm_value better
+    Virtual registers are numbered per stream (see spasm_instructions_new_virtual_register). A
+    virtual register operand keeps in reg the register giving the file and width it is seen with
+    (SpasmRegister_x86_64_RAX for a 64 bits general purpose view, EAX for 32 bits, XMM0, YMM0...).
+    Memory operands can use a virtual base or index: mem_reg or mem_index is then
+    SPASM_VIRTUAL_REGISTER, and the virtual register is in mem_vregs
+*/
+#define SPASM_VIRTUAL_REGISTER 0xFF
+
+/*
+    Operand is 128 bits: a one byte tag, the register/memory fields and a 64 bits payload shared
+    by the immediate value, the data/symbol names, the label and the virtual registers (an operand
+    only ever uses one of them), so the 4 operands of an instruction fit in a cache line. Register
+    operands use reg, memory operands use mem_reg (both share the same byte), mem_index, mem_scale
+    and mem_displacement.
 */
 typedef struct
 {
-    SpasmOperandType type;
-
-    union {
-        int64_t imm_value;
-    };
+    uint8_t type; /* SpasmOperandType */
 
     union {
         uint8_t reg;
+        uint8_t mem_reg;
     };
 
-    union { struct {
-        uint8_t mem_reg;
-        uint8_t mem_index;
-        int32_t mem_displacement;
-        uint8_t mem_scale;
-    }; };
+    uint8_t mem_index;
+    uint8_t mem_scale;
+    int32_t mem_displacement;
 
     union {
+        int64_t imm_value;
         const char* data_id;
-    };
-
-    union {
         const char* symbol_name;
-    };
+        uint32_t label; /* SpasmLabel */
+        uint32_t vreg; /* SpasmVirtualRegister */
 
+        struct {
+            uint32_t base;
+            uint32_t index;
+        } mem_vregs; /* SpasmVirtualRegister base and index */
+    };
 } SpasmOperand;
 
+SPASM_STATIC_ASSERT(sizeof(SpasmOperand) == 16, "SpasmOperand must stay 16 bytes");
+
 #define SpasmOpImm8(val) ((SpasmOperand){ \
     .type = SpasmOperandType_Imm8,      \
     .imm_value = (int64_t)(val)})
@@ -102,4 +116,28 @@ typedef struct
     .type = SpasmOperandType_Symbol,       \
     .symbol_name = (const char*)(name)})
 
+#define SpasmOpLabel(l) ((SpasmOperand){ \
+    .type = SpasmOperandType_Label,    \
+    .label = (uint32_t)(l)})
+
+#define SpasmOpVirtualReg(v, r) ((SpasmOperand){ \
+    .type = SpasmOperandType_VirtualRegister, \
+    .reg = (uint8_t)(r),                      \
+    .vreg = (uint32_t)(v)})
+
+#define SpasmOpVirtualMemory(v, disp) ((SpasmOperand){ \
+    .type = SpasmOperandType_Mem,                     \
+    .mem_reg = SPASM_VIRTUAL_REGISTER,                \
+    .mem_displacement = (int32_t)(disp),              \
+    .mem_scale = 1,                                   \
+    .mem_vregs = { (uint32_t)(v), 0 }})
+
+#define SpasmOpVirtualMemoryIndex(v, idx, disp, scale) ((SpasmOperand){ \
+    .type = SpasmOperandType_Mem,                                      \
+    .mem_reg = SPASM_VIRTUAL_REGISTER,                                 \
+    .mem_index = SPASM_VIRTUAL_REGISTER,                               \
+    .mem_displacement = (int32_t)(disp),                               \
+    .mem_scale = (uint8_t)(scale),                                     \
+    .mem_vregs = { (uint32_t)(v), (uint32_t)(idx) }})
+
 #endif /* !defined(__SPASM_OPERAND) */
@@ -37,4 +37,35 @@ SPASM_API SpasmISA spasm_get_current_isa();
 
 SPASM_API const char* spasm_get_isa_as_string(SpasmISA isa);
 
+/* Returns the number of logical cpus available on the machine */
+SPASM_API uint32_t spasm_get_num_cpus(void);
+
+/* Returns a monotonic timestamp in nanoseconds */
+SPASM_API uint64_t spasm_get_timestamp_ns(void);
+
+/* Returns the size of a virtual memory page */
+SPASM_API size_t spasm_get_page_size(void);
+
+/*
+    Executable memory
+
+    The same pages are mapped twice: code is written through the writable view and run from the
+    executable one, so no mapping is ever both writable and executable (W^X), and code can be added
+    to a block while other threads run the code already in it. On macOS, both views are the same
+    read-write-execute mapping
+*/
+typedef struct
+{
+    uint8_t* writable;
+    uint8_t* executable;
+    size_t size;
+} SpasmExecutableMemory;
+
+/*
+ * size is rounded up to the page size. Returns false on failure
+ */
+SPASM_API bool spasm_executable_memory_alloc(SpasmExecutableMemory* memory, size_t size);
+
+SPASM_API void spasm_executable_memory_release(SpasmExecutableMemory* memory);
+
 #endif /* !defined(__SPASM_PLATFORM) */
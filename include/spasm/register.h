@@ -11,19 +11,23 @@
 
 typedef enum
 {
-    /* x86_64 Registers https://wiki.osdev.org/CPU_Registers_x86-64 */
+    /*
+        x86_64 Registers https://wiki.osdev.org/CPU_Registers_x86-64
+        Each width lists the registers in the order of their hardware codes, the encoder takes the
+        code from the position in the width
+    */
 #if defined(SPASM_ENABLE_X86_64)
     SpasmRegister_x86_64_NONE,
 
     /* 8-bit low */
     SpasmRegister_x86_64_AL,
-    SpasmRegister_x86_64_BL,
     SpasmRegister_x86_64_CL,
     SpasmRegister_x86_64_DL,
-    SpasmRegister_x86_64_SIL,
-    SpasmRegister_x86_64_DIL,
+    SpasmRegister_x86_64_BL,
     SpasmRegister_x86_64_SPL,
     SpasmRegister_x86_64_BPL,
+    SpasmRegister_x86_64_SIL,
+    SpasmRegister_x86_64_DIL,
     SpasmRegister_x86_64_R8B,
     SpasmRegister_x86_64_R9B,
     SpasmRegister_x86_64_R10B,
@@ -35,13 +39,13 @@ typedef enum
 
     /* 16-bit */
     SpasmRegister_x86_64_AX,
-    SpasmRegister_x86_64_BX,
     SpasmRegister_x86_64_CX,
     SpasmRegister_x86_64_DX,
-    SpasmRegister_x86_64_SI,
-    SpasmRegister_x86_64_DI,
+    SpasmRegister_x86_64_BX,
     SpasmRegister_x86_64_SP,
     SpasmRegister_x86_64_BP,
+    SpasmRegister_x86_64_SI,
+    SpasmRegister_x86_64_DI,
     SpasmRegister_x86_64_R8W,
     SpasmRegister_x86_64_R9W,
     SpasmRegister_x86_64_R10W,
@@ -53,13 +57,13 @@ typedef enum
 
     /* 32-bit */
     SpasmRegister_x86_64_EAX,
-    SpasmRegister_x86_64_EBX,
     SpasmRegister_x86_64_ECX,
     SpasmRegister_x86_64_EDX,
-    SpasmRegister_x86_64_ESI,
-    SpasmRegister_x86_64_EDI,
+    SpasmRegister_x86_64_EBX,
     SpasmRegister_x86_64_ESP,
     SpasmRegister_x86_64_EBP,
+    SpasmRegister_x86_64_ESI,
+    SpasmRegister_x86_64_EDI,
     SpasmRegister_x86_64_R8D,
     SpasmRegister_x86_64_R9D,
     SpasmRegister_x86_64_R10D,
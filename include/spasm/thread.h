@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_THREAD)
+#define __SPASM_THREAD
+
+#include "spasm/common.h"
+
+/* Thin wrappers over the native threading apis (Win32 threads / pthreads) */
+
+typedef void (*SpasmThreadFunc)(void* arg);
+
+typedef struct
+{
+    void* handle;
+    SpasmThreadFunc func;
+    void* arg;
+} SpasmThread;
+
+/*
+ * Returns false if the thread could not be started. The thread struct must stay alive
+ * until spasm_thread_join returns
+ */
+SPASM_API bool spasm_thread_start(SpasmThread* thread, SpasmThreadFunc func, void* arg);
+
+SPASM_API void spasm_thread_join(SpasmThread* thread);
+
+/*
+ * Gives the rest of the time slice of the calling thread to another ready thread
+ */
+SPASM_API void spasm_thread_yield(void);
+
+typedef struct
+{
+    void* handle;
+} SpasmMutex;
+
+SPASM_API bool spasm_mutex_init(SpasmMutex* mutex);
+
+SPASM_API void spasm_mutex_lock(SpasmMutex* mutex);
+
+SPASM_API void spasm_mutex_unlock(SpasmMutex* mutex);
+
+SPASM_API void spasm_mutex_release(SpasmMutex* mutex);
+
+typedef struct
+{
+    void* handle;
+} SpasmCondVar;
+
+SPASM_API bool spasm_condvar_init(SpasmCondVar* condvar);
+
+/*
+ * The mutex must be locked by the calling thread, it is locked again when the function returns
+ */
+SPASM_API void spasm_condvar_wait(SpasmCondVar* condvar, SpasmMutex* mutex);
+
+SPASM_API void spasm_condvar_signal(SpasmCondVar* condvar);
+
+SPASM_API void spasm_condvar_broadcast(SpasmCondVar* condvar);
+
+SPASM_API void spasm_condvar_release(SpasmCondVar* condvar);
+
+/* Atomics (sequentially consistent) */
+
+#if defined(SPASM_MSVC)
+#include <intrin.h>
+#define spasm_atomic_load_32(ptr) ((uint32_t)_InterlockedOr((volatile long*)(ptr), 0))
+#define spasm_atomic_store_32(ptr, value) ((void)_InterlockedExchange((volatile long*)(ptr), (long)(value)))
+#define spasm_atomic_fetch_add_32(ptr, value) ((uint32_t)_InterlockedExchangeAdd((volatile long*)(ptr), (long)(value)))
+#define spasm_atomic_fetch_add_64(ptr, value) ((uint64_t)_InterlockedExchangeAdd64((volatile long long*)(ptr), (long long)(value)))
+#else
+#define spasm_atomic_load_32(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define spasm_atomic_store_32(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define spasm_atomic_fetch_add_32(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_SEQ_CST)
+#define spasm_atomic_fetch_add_64(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_SEQ_CST)
+#endif /* defined(SPASM_MSVC) */
+
+/* Spin-wait hint, lets the sibling hyperthread run and saves power while polling */
+
+#if defined(SPASM_X86_64) && defined(SPASM_MSVC)
+#define spasm_cpu_pause() _mm_pause()
+#elif defined(SPASM_X86_64)
+#define spasm_cpu_pause() __builtin_ia32_pause()
+#elif defined(SPASM_AARCH64) && defined(SPASM_MSVC)
+#define spasm_cpu_pause() __yield()
+#elif defined(SPASM_AARCH64)
+#define spasm_cpu_pause() __asm__ __volatile__("yield")
+#else
+#define spasm_cpu_pause() ((void)0)
+#endif /* defined(SPASM_X86_64) && defined(SPASM_MSVC) */
+
+#endif /* !defined(__SPASM_THREAD) */
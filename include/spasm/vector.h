@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#pragma once
+
+#if !defined(__SPASM_VECTOR)
+#define __SPASM_VECTOR
+
+#include "spasm/allocator.h"
+
+#include <string.h>
+
+/* Growable array allocating through a SpasmAllocator */
+
+typedef struct
+{
+    void* data;
+    size_t size;
+    size_t capacity;
+    size_t element_size;
+    const SpasmAllocator* allocator;
+} SpasmVector;
+
+/*
+ * Nothing is allocated if capacity is 0. allocator can be NULL to use the default allocator.
+ * Returns false on allocation failure
+ */
+SPASM_API bool spasm_vector_init(SpasmVector* vector,
+                                 size_t capacity,
+                                 size_t element_size,
+                                 const SpasmAllocator* allocator);
+
+SPASM_API bool spasm_vector_reserve(SpasmVector* vector, size_t capacity);
+
+/*
+ * Appends count elements (copied from elements if not NULL), returns a pointer to the first one
+ * or NULL on allocation failure
+ */
+SPASM_API void* spasm_vector_push_back_n(SpasmVector* vector, const void* elements, size_t count);
+
+static SPASM_FORCE_INLINE void* spasm_vector_push_back(SpasmVector* vector, const void* element)
+{
+    if(vector->size == vector->capacity)
+        return spasm_vector_push_back_n(vector, element, 1);
+
+    void* slot = (char*)vector->data + vector->size * vector->element_size;
+
+    if(element != NULL)
+        memcpy(slot, element, vector->element_size);
+
+    vector->size++;
+
+    return slot;
+}
+
+static SPASM_FORCE_INLINE void* spasm_vector_at(const SpasmVector* vector, size_t index)
+{
+    return (char*)vector->data + index * vector->element_size;
+}
+
+static SPASM_FORCE_INLINE size_t spasm_vector_size(const SpasmVector* vector)
+{
+    return vector->size;
+}
+
+/*
+ * Removes all the elements but keeps the capacity
+ */
+static SPASM_FORCE_INLINE void spasm_vector_clear(SpasmVector* vector)
+{
+    vector->size = 0;
+}
+
+/*
+ * Frees the memory, the vector can be initialized again afterwards
+ */
+SPASM_API void spasm_vector_release(SpasmVector* vector);
+
+#endif /* !defined(__SPASM_VECTOR) */
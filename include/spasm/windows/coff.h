@@ -480,6 +480,10 @@ typedef enum {
 
 SPASM_API SpasmCoffMachineType spasm_abi_to_coff_machine_type(SpasmABI abi);
 
+/*
+ * The output buffer is allocated through the allocator of the data context, and must be
+ * freed with it (the size is out_size)
+ */
 SPASM_API uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
                                        SpasmData* data,
                                        SpasmCoffMachineType machine,
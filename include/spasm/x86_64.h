@@ -81,28 +81,697 @@ typedef enum
 
 typedef struct
 {
-    const char* mnemonic;
-    uint8_t mnemonic_len;
+    uint16_t mnemonic; /* SpasmMnemonic */
     uint8_t operand_types[4];
     uint16_t operand_sizes[4];
     uint8_t opcode[4];
     uint8_t opcode_len;
     uint8_t needs_modrm;
     uint8_t prefix;
-    uint8_t pp;
+    uint8_t pp; /* VEX/EVEX pp, for legacy forms their mandatory prefix with the same values (1: 66, 2: F3, 3: F2) */
     uint8_t mmmmm;
     uint8_t cpu_flag;
     bool reg_in_opcode;
-    bool reg_in_modrm_reg;
+    bool reg_in_modrm_reg; /* /digit forms, ModR/M.reg holds the digit modrm_reg_operand */
     uint8_t modrm_reg_operand;
-    bool reg_in_modrm_rm;
+    bool reg_in_modrm_rm; /* Legacy forms with ModR/M, ModR/M.rm holds the operand modrm_rm_operand */
     uint8_t modrm_rm_operand;
     bool force_rex_w;
 } Spasm_x86_64_InstructionInfo;
 
-SPASM_API bool spasm_x86_64_encode_instruction(SpasmInstruction* instr,
+/*
+    Forms of a mnemonic are contiguous in the instruction table, the mnemonic table (indexed by
+    SpasmMnemonic) gives their range
+*/
+typedef struct
+{
+    const char* name;
+    uint8_t name_len;
+    uint16_t first_form;
+    uint16_t num_forms;
+} Spasm_x86_64_MnemonicInfo;
+
+/*
+    Registers and flags accessed by the forms. Register sets are bit masks over the register codes:
+    general purpose registers in bits 0-15 (whatever their width), vector registers in bits 16-31
+    (XMM, YMM and ZMM views are the same register) and the flags from bit 32. Opmask, MMX, segment
+    registers and RIP are not tracked
+*/
+typedef uint64_t Spasm_x86_64_RegisterSet;
+
+#define SPASM_X86_64_REGISTER_SET_GP(code) ((Spasm_x86_64_RegisterSet)1 << (code))
+#define SPASM_X86_64_REGISTER_SET_VECTOR(code) ((Spasm_x86_64_RegisterSet)1 << (16 + (code)))
+#define SPASM_X86_64_REGISTER_SET_FLAGS(flags) ((Spasm_x86_64_RegisterSet)(flags) << 32)
+
+typedef enum
+{
+    Spasm_x86_64_Flag_CF = 1 << 0,
+    Spasm_x86_64_Flag_PF = 1 << 1,
+    Spasm_x86_64_Flag_AF = 1 << 2,
+    Spasm_x86_64_Flag_ZF = 1 << 3,
+    Spasm_x86_64_Flag_SF = 1 << 4,
+    Spasm_x86_64_Flag_OF = 1 << 5,
+    Spasm_x86_64_Flag_DF = 1 << 6,
+} Spasm_x86_64_Flag;
+
+#define SPASM_X86_64_STATUS_FLAGS 0x3F
+
+/*
+    Generated with the instruction table and indexed like it. Flags left undefined by a form count
+    as written
+*/
+typedef struct
+{
+    uint8_t read; /* Bit i set if operand i is read (memory operands always read their base and index) */
+    uint8_t written; /* Bit i set if operand i is written */
+    uint8_t flags_read; /* Spasm_x86_64_Flag */
+    uint8_t flags_written;
+    uint32_t implicit_read; /* Registers accessed without being operands (rdx:rax of div, rsp of push...) */
+    uint32_t implicit_written;
+} Spasm_x86_64_FormAccess;
+
+/*
+    Cost model of the scheduler, generated with the instruction table: each form has a cost class,
+    and each microarchitecture profile gives the latency and the execution ports of the classes.
+    Latencies are register to register, the profile load latency is added to the forms reading
+    memory. Port masks are local to a profile (bit i is port i of its model)
+*/
+typedef enum
+{
+    Spasm_x86_64_CostClass_Other,
+    Spasm_x86_64_CostClass_Move,
+    Spasm_x86_64_CostClass_Alu,
+    Spasm_x86_64_CostClass_Shift,
+    Spasm_x86_64_CostClass_Complex, /* Integer multiplier port: imul, popcnt, lzcnt, pdep... */
+    Spasm_x86_64_CostClass_Divide,
+    Spasm_x86_64_CostClass_Branch,
+    Spasm_x86_64_CostClass_VectorMove,
+    Spasm_x86_64_CostClass_VectorAlu,
+    Spasm_x86_64_CostClass_VectorShuffle,
+    Spasm_x86_64_CostClass_VectorMultiply,
+    Spasm_x86_64_CostClass_FloatAdd,
+    Spasm_x86_64_CostClass_FloatMultiply,
+    Spasm_x86_64_CostClass_FloatFma,
+    Spasm_x86_64_CostClass_FloatDivide,
+    Spasm_x86_64_CostClass_FloatSqrt,
+    Spasm_x86_64_CostClass_Convert,
+    Spasm_x86_64_CostClass_COUNT,
+} Spasm_x86_64_CostClass;
+
+typedef enum
+{
+    Spasm_x86_64_Uarch_Generic,
+    Spasm_x86_64_Uarch_Skylake,
+    Spasm_x86_64_Uarch_Zen4,
+    Spasm_x86_64_Uarch_COUNT,
+} Spasm_x86_64_Uarch;
+
+typedef struct
+{
+    uint8_t latency;
+    uint8_t ports;
+} Spasm_x86_64_ClassCost;
+
+typedef struct
+{
+    const char* name;
+    uint8_t issue_width; /* Instructions issued per cycle */
+    uint8_t load_latency;
+    uint8_t num_load_ports;
+    uint8_t num_store_ports;
+    Spasm_x86_64_ClassCost classes[Spasm_x86_64_CostClass_COUNT];
+} Spasm_x86_64_UarchProfile;
+
+/*
+ * Encodes a single instruction at the end of out, without reporting anything on failure: returns
+ * the error code and fills error (if not NULL), and nothing is written to out.
+ * Meant for code generators probing forms that may not exist. ctx is only used for the statistics
+ * and can be NULL
+ */
+SPASM_API SpasmErrorCode spasm_x86_64_try_encode_instruction(SpasmContext* ctx,
+                                                             SpasmInstruction* instr,
+                                                             SpasmByteCode* out,
+                                                             SpasmError* error);
+
+/*
+ * Encodes a single instruction at the end of out. Errors are reported through ctx,
+ * which can be NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_encode_instruction(SpasmContext* ctx,
+                                               SpasmInstruction* instr,
                                                SpasmByteCode* out);
 
+/*
+ * Writes size bytes of padding at the end of out, as the fewest recommended multi-byte NOPs
+ * (0F 1F /0 forms, up to 15 bytes each)
+ */
+SPASM_API void spasm_x86_64_encode_nops(SpasmByteCode* out, size_t size);
+
+/*
+ * Returns the exact encoded length of the instruction in bytes, computed from its form and
+ * operands without writing anything. Returns 0 if no form matches (pseudo-instructions have no
+ * bytes either), spasm_x86_64_try_encode_instruction gives the error. Label branches and
+ * alignments have no length on their own, their size depends on the stream layout (see
+ * spasm_x86_64_instructions_offsets)
+ */
+SPASM_API size_t spasm_x86_64_instruction_length(const SpasmInstruction* instr);
+
+/*
+ * Fills instr_end_offsets with the offset of the end of each instruction, as
+ * spasm_x86_64_encode_instructions would encode the stream in an empty buffer, without encoding
+ * it. Label branches are relaxed and alignments padded to get their size. Errors are reported through ctx, which can be
+ * NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_instructions_offsets(SpasmContext* ctx,
+                                                 SpasmInstructions* instructions,
+                                                 size_t* instr_end_offsets);
+
+/*
+    Branch layout
+
+    On Skylake-derived cores with the JCC erratum microcode update, jumps (jcc, jmp, call, ret)
+    that cross or end on a 32 bytes boundary are not cached in the decoded icache, and a cmp/test
+    and the jcc following it are only macro-fused as long as nothing is inserted between them.
+*/
+typedef struct
+{
+    size_t num_jumps; /* Jumps given a boundary record */
+    size_t num_fused_pairs; /* Among them, jumps kept together with their macro-fused instruction */
+    size_t num_padded_sites; /* Boundary records padded in the stream layout */
+    size_t num_padding_bytes; /* Bytes of padding they add */
+} Spasm_x86_64_BranchLayoutStats;
+
+/*
+ * Inserts a SpasmMnemonic_Boundary record before every jump of the stream (before its
+ * macro-fused instruction, so the pair moves as a whole) that does not have one yet. The encoder
+ * only pads the ones that would cross or end on a 32 bytes boundary, with NOPs or prefixes as
+ * given by padding. If stats is not NULL, the stream is laid out (as encoded in an empty buffer,
+ * without encoding it) to count the padded sites and bytes. Errors are reported through ctx,
+ * which can be NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_layout_branches(SpasmContext* ctx,
+                                            SpasmInstructions* instructions,
+                                            SpasmAlignPadding padding,
+                                            Spasm_x86_64_BranchLayoutStats* stats);
+
+/*
+    Peephole optimizer
+
+    Table-driven rewrites of short instruction sequences, applied in one pass over the stream
+    before encoding. A rule only matches instructions that are adjacent in the stream: labels,
+    alignments and boundary records are barriers. Rules needing the flags to be dead only apply
+    when the next instructions overwrite them before any read (in a short window, control flow
+    and unknown instructions count as reads)
+*/
+typedef enum
+{
+    Spasm_x86_64_PeepholeRule_ZeroIdiom, /* mov r32/r64, 0 -> xor r32, r32, flags dead */
+    Spasm_x86_64_PeepholeRule_SelfMove, /* mov r, r and SSE register moves to themselves are dropped (not mov r32, r32, it zero-extends) */
+    Spasm_x86_64_PeepholeRule_StoreLoad, /* mov [m], r then mov r2, [m] -> mov r2, r (dropped if it is a no-op) */
+    Spasm_x86_64_PeepholeRule_AddChain, /* add/sub r, imm chains fold into one (dropped if they cancel, mov r32, r32 for 32 bits), flags dead */
+    Spasm_x86_64_PeepholeRule_LeaChain, /* lea r, [m] then lea r, [r + d] -> lea r, [m + d] */
+    Spasm_x86_64_PeepholeRule_COUNT,
+} Spasm_x86_64_PeepholeRule;
+
+#define SPASM_X86_64_PEEPHOLE_ALL_RULES ((1u << Spasm_x86_64_PeepholeRule_COUNT) - 1)
+
+typedef struct
+{
+    size_t hits[Spasm_x86_64_PeepholeRule_COUNT]; /* Times each rule was applied */
+    size_t num_removed; /* Instructions removed from the stream */
+} Spasm_x86_64_PeepholeStats;
+
+SPASM_API const char* spasm_x86_64_peephole_rule_name(Spasm_x86_64_PeepholeRule rule);
+
+/*
+ * Rewrites the stream in place with the rules enabled in the rules mask (bit
+ * 1 << Spasm_x86_64_PeepholeRule_X, SPASM_X86_64_PEEPHOLE_ALL_RULES for all of them). If stats is
+ * not NULL, the hits and removed instructions are added to it. Meant to run before the layout
+ * passes (spasm_x86_64_layout_branches), labels and pseudo-instructions are kept as they are
+ */
+SPASM_API void spasm_x86_64_peephole(SpasmInstructions* instructions,
+                                     uint32_t rules,
+                                     Spasm_x86_64_PeepholeStats* stats);
+
+/*
+    Register allocation
+
+    Linear scan over the live intervals of the virtual registers (from their first to their last
+    occurrence in the stream, extended over the loops they are live around), in one pass. Virtual
+    registers get the call argument registers of the ABI (get_call_args_gp_registers and
+    get_call_args_fp_registers, as many as get_max_available_gp_registers and
+    get_max_available_fp_registers give), which are all caller-saved so nothing has to be saved in
+    the prologue. The registers used explicitly by the stream are not given to the virtual registers
+    live around these uses, and calls clobber them: values live across a call are spilled.
+    Spilled virtual registers live in stack slots, their operands are replaced by the slot when the
+    instruction has a form for it, or loaded in a scratch register and stored back after. R10, R11
+    and the last two vector registers given by the ABI (XMM4/XMM5 on Windows, XMM6/XMM7 on Linux)
+    are kept for that and must not be used explicitly by streams with virtual registers. Implicit
+    register operands (mul, div, shifts by cl, string instructions...) are not seen, such
+    instructions must be given physical registers. Slots addressed from RSP expect the stream not
+    to move it (push, pop), a frame pointer should be used otherwise
+*/
+typedef struct
+{
+    SpasmABI abi;
+    SpasmRegister frame_register; /* Register the spill slots are addressed from (RSP, or RBP with a frame pointer) */
+    int32_t frame_offset; /* Offset of the spill area from frame_register */
+} Spasm_x86_64_RegisterAllocationConfig;
+
+typedef struct
+{
+    uint32_t num_virtual_registers; /* Virtual registers used by the stream */
+    uint32_t num_spilled;
+    uint32_t spill_size; /* Bytes of the spill area the frame must provide, a multiple of 16 */
+    size_t num_spill_instructions; /* Loads, stores and address computations inserted */
+} Spasm_x86_64_RegisterAllocationStats;
+
+/*
+ * Replaces the virtual registers of the stream by registers, and spills the ones that do not fit
+ * to the spill area (stats->spill_size bytes at config->frame_register + config->frame_offset).
+ * config can be NULL to use the current ABI and slots addressed from RSP. Errors are reported
+ * through ctx, which can be NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_allocate_registers(SpasmContext* ctx,
+                                               SpasmInstructions* instructions,
+                                               const Spasm_x86_64_RegisterAllocationConfig* config,
+                                               Spasm_x86_64_RegisterAllocationStats* stats);
+
+/*
+ * Returns the accesses of the form encoding the instruction, NULL if it has none (pseudo-instructions,
+ * operands matching no form)
+ */
+SPASM_API const Spasm_x86_64_FormAccess* spasm_x86_64_instruction_access(const SpasmInstruction* instr);
+
+/*
+ * Returns the register set bit of a register, 0 if it is not tracked
+ */
+SPASM_API Spasm_x86_64_RegisterSet spasm_x86_64_register_set(SpasmRegister reg);
+
+/*
+ * Fills the registers and flags the instruction writes (defs) and reads (uses), implicit operands
+ * included. Writes to 8 and 16-bit registers also use them (the rest of the register is kept), and
+ * zero idioms (xor r, r, pxor x, x...) do not use their operands. Virtual registers are not
+ * tracked. Pseudo-instructions access nothing, returns false if the instruction has no form
+ */
+SPASM_API bool spasm_x86_64_instruction_def_use(const SpasmInstruction* instr,
+                                                Spasm_x86_64_RegisterSet* defs,
+                                                Spasm_x86_64_RegisterSet* uses);
+
+/*
+    Liveness
+
+    Backward dataflow over the basic blocks of the stream, which start at labels and after
+    branches. Branches to labels link the blocks, calls use the argument registers of the ABI and
+    clobber the caller-saved ones (and the flags). At a ret, and at the end of the stream, the
+    return registers, the callee-saved registers and RSP are live. The direction flag is live at
+    calls and exits, the ABIs require it clear there. Jumps to something else than a label (jmp
+    rax, tail calls to symbols) keep everything live, as do instructions with no form. Calls do not
+    use RAX by default, so writes to it before a call are dead. On System V, variadic callees read
+    the number of vector arguments from al: SPASM_X86_64_LIVENESS_VARIADIC_CALLS makes all the calls
+    use RAX (the liveness tracks whole registers), it has no effect on Windows
+*/
+#define SPASM_X86_64_LIVENESS_VARIADIC_CALLS 0x1
+
+typedef struct
+{
+    const SpasmAllocator* allocator;
+    Spasm_x86_64_RegisterSet* live_out; /* Registers and flags live after each instruction */
+    size_t num_instructions;
+    size_t* block_starts; /* First instruction of each block, followed by num_instructions */
+    size_t num_blocks;
+} Spasm_x86_64_Liveness;
+
+/*
+ * Computes the registers and flags live after each instruction of the stream, for the ABI of the
+ * calls and of the function exits (SpasmABI_Invalid for the current one). flags is a mask of
+ * SPASM_X86_64_LIVENESS_* options, 0 for none. Virtual registers must be allocated first to be
+ * seen. Errors are reported through ctx, which can be NULL (see spasm/context.h). The liveness
+ * must be released with spasm_x86_64_liveness_release
+ */
+SPASM_API bool spasm_x86_64_liveness(SpasmContext* ctx,
+                                     const SpasmInstructions* instructions,
+                                     SpasmABI abi,
+                                     uint32_t flags,
+                                     Spasm_x86_64_Liveness* liveness);
+
+SPASM_API void spasm_x86_64_liveness_release(Spasm_x86_64_Liveness* liveness);
+
+/*
+    Dead code elimination
+
+    Removes the instructions no path reaches from the start of the stream (or from a label called
+    by the stream), the instructions whose registers and flags are never read, and the stores
+    overwritten by a store of the same size to the same address before any other memory access.
+    Instructions with side effects are kept: branches, calls, memory writes, stack pointer updates,
+    system instructions and writes to registers the liveness does not track (opmasks, MMX). Labels,
+    alignments and boundary records are kept too
+*/
+typedef struct
+{
+    size_t num_dead; /* Instructions whose results were never read */
+    size_t num_dead_stores;
+    size_t num_unreachable;
+    size_t num_passes; /* Liveness computations, removals can make more instructions dead */
+} Spasm_x86_64_DeadCodeStats;
+
+/*
+ * Removes the dead instructions of the stream in place, with the calls and function exits of
+ * the ABI (SpasmABI_Invalid for the current one) and the liveness flags (see spasm_x86_64_liveness,
+ * SPASM_X86_64_LIVENESS_VARIADIC_CALLS keeps the al setup of variadic calls). If stats is not NULL,
+ * the removed instructions are added to it. Errors are reported through ctx, which can be NULL
+ * (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_eliminate_dead_code(SpasmContext* ctx,
+                                                SpasmInstructions* instructions,
+                                                SpasmABI abi,
+                                                uint32_t flags,
+                                                Spasm_x86_64_DeadCodeStats* stats);
+
+/*
+    Instruction scheduling
+
+    List scheduling of the straight-line runs of the stream, driven by the cost model of a
+    microarchitecture profile: instructions are issued cycle by cycle, as soon as their operands are
+    ready and a port is free, the ones on the longest latency path first. Dependencies follow the
+    registers and flags read and written (writes whose result is dead do not order each other), and
+    memory accesses stay ordered with the stores. Labels, branches, calls, pseudo-instructions and
+    system instructions (fences, cpuid, mxcsr...) are barriers that nothing moves across. A run is
+    only reordered if the model finds it faster than the original order
+*/
+typedef struct
+{
+    uint8_t latency; /* Load latency included */
+    uint8_t ports;
+    bool load;
+    bool store;
+} Spasm_x86_64_InstructionCost;
+
+/*
+ * Returns the profile of the microarchitecture, NULL if it is not a Spasm_x86_64_Uarch
+ */
+SPASM_API const Spasm_x86_64_UarchProfile* spasm_x86_64_get_uarch_profile(Spasm_x86_64_Uarch uarch);
+
+/*
+ * Returns the microarchitecture named by its profile name ("generic", "skylake", "zen4"),
+ * Spasm_x86_64_Uarch_COUNT if there is none
+ */
+SPASM_API Spasm_x86_64_Uarch spasm_x86_64_uarch_from_string(const char* name);
+
+/*
+ * Fills the cost of the instruction on the microarchitecture, returns false if the instruction has
+ * no form
+ */
+SPASM_API bool spasm_x86_64_instruction_cost(const SpasmInstruction* instr,
+                                             Spasm_x86_64_Uarch uarch,
+                                             Spasm_x86_64_InstructionCost* cost);
+
+#if !defined(SPASM_X86_64_SCHEDULE_MAX_REGION)
+#define SPASM_X86_64_SCHEDULE_MAX_REGION 128
+#endif /* !defined(SPASM_X86_64_SCHEDULE_MAX_REGION) */
+
+typedef struct
+{
+    Spasm_x86_64_Uarch uarch;
+    SpasmABI abi; /* For the liveness at calls and function exits */
+} Spasm_x86_64_ScheduleConfig;
+
+typedef struct
+{
+    size_t num_regions; /* Straight-line runs of more than one instruction */
+    size_t num_reordered;
+    size_t cycles_before; /* Cycles estimated by the model, over all the runs */
+    size_t cycles_after;
+} Spasm_x86_64_ScheduleStats;
+
+/*
+ * Reorders the instructions of the stream in place. Runs longer than
+ * SPASM_X86_64_SCHEDULE_MAX_REGION instructions are split. config can be NULL to use the generic
+ * profile and the current ABI. If stats is not NULL, the counts are added to it. Errors are
+ * reported through ctx, which can be NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_schedule(SpasmContext* ctx,
+                                     SpasmInstructions* instructions,
+                                     const Spasm_x86_64_ScheduleConfig* config,
+                                     Spasm_x86_64_ScheduleStats* stats);
+
+/*
+    Throughput analysis
+
+    Static estimate of the cycles per iteration of a loop body, with the cost model of the
+    scheduler. The body is unrolled num_iterations times and simulated cycle by cycle: up to
+    issue_width instructions enter a window of SPASM_X86_64_ANALYSIS_WINDOW instructions per cycle,
+    and execute out of order once their operands are ready and one of their ports is free.
+    Registers are renamed (only true dependencies wait, across iterations too), loads are assumed
+    not to alias the stores, and every instruction holds its port for one cycle. Labels and other
+    pseudo-instructions are ignored, branches cost their class like any other instruction
+*/
+#if !defined(SPASM_X86_64_ANALYSIS_WINDOW)
+#define SPASM_X86_64_ANALYSIS_WINDOW 128
+#endif /* !defined(SPASM_X86_64_ANALYSIS_WINDOW) */
+
+#if !defined(SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS)
+#define SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS 100
+#endif /* !defined(SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS) */
+
+#define SPASM_X86_64_ANALYSIS_MAX_PORTS 8
+
+typedef enum
+{
+    Spasm_x86_64_Bottleneck_Dependencies, /* Latency of the critical chain */
+    Spasm_x86_64_Bottleneck_Issue, /* Issue width of the front end */
+    Spasm_x86_64_Bottleneck_Ports, /* Execution ports (see bottleneck_ports) */
+    Spasm_x86_64_Bottleneck_Loads,
+    Spasm_x86_64_Bottleneck_Stores,
+    Spasm_x86_64_Bottleneck_COUNT,
+} Spasm_x86_64_Bottleneck;
+
+typedef struct
+{
+    Spasm_x86_64_Uarch uarch;
+    size_t num_iterations; /* 0 for SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS */
+} Spasm_x86_64_AnalysisConfig;
+
+typedef struct
+{
+    const SpasmAllocator* allocator;
+    Spasm_x86_64_Uarch uarch;
+
+    size_t num_instructions; /* Per iteration, pseudo-instructions excluded */
+    size_t num_iterations;
+    size_t total_cycles;
+    double cycles_per_iteration;
+    double ipc;
+
+    /* Lower bounds of the cycles per iteration, the largest one is the bottleneck */
+    double bounds[Spasm_x86_64_Bottleneck_COUNT];
+    Spasm_x86_64_Bottleneck bottleneck;
+
+    /* Average cycles per iteration each port of the profile executes something */
+    double port_pressure[SPASM_X86_64_ANALYSIS_MAX_PORTS];
+    uint8_t bottleneck_ports; /* Busiest ports */
+
+    /*
+        Critical dependency chain: indices in the stream of its instructions, in order. For a
+        loop-carried chain it is one turn of the recurrence, otherwise the longest chain of one
+        iteration
+    */
+    size_t* critical_path;
+    size_t critical_path_size;
+    uint32_t critical_path_latency;
+} Spasm_x86_64_Analysis;
+
+/*
+ * Estimates the throughput of instructions used as a loop body. config can be NULL to use the
+ * generic profile. analysis has to be released with spasm_x86_64_analysis_release. Instructions
+ * with no form are reported as SpasmErrorCode_UnknownInstruction. Errors are reported through ctx,
+ * which can be NULL (see spasm/context.h)
+ */
+SPASM_API bool spasm_x86_64_analyze(SpasmContext* ctx,
+                                    const SpasmInstructions* instructions,
+                                    const Spasm_x86_64_AnalysisConfig* config,
+                                    Spasm_x86_64_Analysis* analysis);
+
+SPASM_API void spasm_x86_64_analysis_release(Spasm_x86_64_Analysis* analysis);
+
+/*
+ * Writes a human readable report of the analysis to stream: throughput, bounds, port pressure and
+ * critical chain
+ */
+SPASM_API void spasm_x86_64_analysis_print(const Spasm_x86_64_Analysis* analysis,
+                                           const SpasmInstructions* instructions,
+                                           FILE* stream);
+
+/*
+    Stack frames
+
+    Prologue and epilogue of a function for the registers, locals and calls of its body, following
+    the ABI. The frame, from the return address down:
+
+        return address
+        saved RBP                   (frame pointer only)
+        pushed callee-saved registers
+        padding
+        saved vector registers      (XMM6-XMM15 on Windows, 16-byte aligned)
+        locals                      (locals_size, aligned to alignment)
+        shadow space                (Windows, body with calls)  <- RSP after the prologue
+
+    General purpose registers are saved with push/pop, vector registers with movaps to their slots.
+    The frame pointer (RBP) is omitted unless asked or needed to realign RSP for locals aligned to
+    more than 16 bytes. Bodies with calls get RSP aligned to 16 and, on Windows, the 32 bytes of
+    shadow space of the callees. Leaf functions on System V keep up to SPASM_X86_64_FRAME_RED_ZONE
+    bytes of locals in the red zone below RSP, without moving it. The stack is not probed: on
+    Windows, bodies with more than a page of locals have to touch them from the top first
+*/
+#define SPASM_X86_64_FRAME_RED_ZONE 128
+
+#define SPASM_X86_64_FRAME_MAX_CFI 32
+
+typedef struct
+{
+    SpasmABI abi; /* SpasmABI_Invalid for the current one */
+    Spasm_x86_64_RegisterSet used_registers; /* Registers written by the body, the callee-saved ones are saved */
+    uint32_t locals_size; /* Bytes of locals and spill slots (spill_size of Spasm_x86_64_RegisterAllocationStats) */
+    uint32_t alignment; /* Alignment of the locals, a power of two, 16 if 0 */
+    bool has_calls; /* The body calls other functions */
+    bool frame_pointer; /* Sets up RBP even if the frame does not need it */
+} Spasm_x86_64_FrameConfig;
+
+/*
+    Call frame information of the prologue, in the terms of the DWARF CFA rules (the canonical frame
+    address is the value of RSP before the call, return address at CFA - 8). Every record holds
+    after the prologue instruction it refers to, and maps to a Windows unwind code as well:
+    DefCfaOffset after a push or a sub rsp, DefCfaRegister after mov rbp, rsp and SaveRegister after
+    a push or a movaps
+*/
+typedef enum
+{
+    Spasm_x86_64_CFIOp_DefCfaOffset, /* CFA = RSP + offset */
+    Spasm_x86_64_CFIOp_DefCfaRegister, /* CFA = reg + offset */
+    Spasm_x86_64_CFIOp_SaveRegister, /* reg saved at CFA + offset */
+} Spasm_x86_64_CFIOp;
+
+typedef struct
+{
+    uint32_t instruction; /* Index of the instruction in the prologue */
+    uint8_t op; /* Spasm_x86_64_CFIOp */
+    uint8_t reg; /* SpasmRegister */
+    int32_t offset;
+} Spasm_x86_64_CFIRecord;
+
+typedef struct
+{
+    SpasmABI abi;
+    Spasm_x86_64_RegisterSet saved_registers; /* Registers restored by the epilogue, RBP included */
+    uint32_t alignment;
+    bool has_frame_pointer;
+    bool uses_red_zone;
+    uint32_t push_size; /* Bytes pushed below the return address */
+    uint32_t stack_size; /* Bytes allocated with sub rsp after the pushes */
+    int32_t locals_offset; /* Offset of the locals from RSP after the prologue, negative in the red zone */
+    int32_t vector_save_offset; /* Offset of the saved vector registers from the CFA */
+    uint32_t num_prologue_instructions;
+    Spasm_x86_64_CFIRecord cfi[SPASM_X86_64_FRAME_MAX_CFI];
+    uint32_t num_cfi;
+} Spasm_x86_64_Frame;
+
+/*
+ * Lays out the frame of a function. If body is not NULL, the registers it writes and its calls are
+ * added to the ones of config, which can be NULL for a leaf function of the current ABI. Errors are
+ * reported through ctx, which can be NULL (see spasm/context.h): SpasmErrorCode_UnsupportedABI,
+ * SpasmErrorCode_InvalidAlignment, or SpasmErrorCode_UnknownInstruction for an instruction of the
+ * body with no form
+ */
+SPASM_API bool spasm_x86_64_frame_build(SpasmContext* ctx,
+                                        const Spasm_x86_64_FrameConfig* config,
+                                        const SpasmInstructions* body,
+                                        Spasm_x86_64_Frame* frame);
+
+/*
+ * Pushes the prologue of the frame (frame->num_prologue_instructions instructions, described by
+ * frame->cfi). With a realigned frame, it ends with an and rsp that needs no CFI record
+ */
+SPASM_API bool spasm_x86_64_frame_emit_prologue(const Spasm_x86_64_Frame* frame,
+                                                SpasmInstructions* instructions);
+
+/*
+ * Pushes the epilogue of the frame, ret included, in the form the Windows unwinder expects (add rsp
+ * or lea rsp, [rbp - n], then the pops). A function can have several of them
+ */
+SPASM_API bool spasm_x86_64_frame_emit_epilogue(const Spasm_x86_64_Frame* frame,
+                                                SpasmInstructions* instructions);
+
+/*
+    Calls
+
+    Lowering of a call to a function of the ABI (a C function...). The arguments go to the argument
+    registers of the ABI (positional on Windows, integer and vector ones counted apart on System V)
+    and the others to stack slots. The register shuffle is solved as a parallel move: every move is
+    emitted once the register it writes is not read by another one anymore, and cycles are broken
+    through a scratch register, a cycle of n registers taking n + 1 moves. Registers that already
+    hold their argument are not moved.
+    The stack arguments and the Windows shadow space are reserved with a sub rsp before the moves and
+    released after the call, RSP has to be aligned to 16 before the call sequence (see
+    Spasm_x86_64_FrameConfig::has_calls). Memory operands based on RSP are adjusted for it.
+    Variadic System V callees, which expect the number of vector registers in AL, are not supported
+*/
+typedef enum
+{
+    Spasm_x86_64_CallArgType_Int, /* Integers and pointers up to 64 bits, in general purpose registers */
+    Spasm_x86_64_CallArgType_Float, /* float, in the low lane of a vector register */
+    Spasm_x86_64_CallArgType_Double, /* double, in the low lane of a vector register */
+} Spasm_x86_64_CallArgType;
+
+/*
+    The value is a register of the type, a memory operand (read as 64 bits for Int), or an immediate
+    for Int. Narrower integer registers are moved with their width, the upper bits of the argument
+    register are undefined as the ABIs allow
+*/
+typedef struct
+{
+    SpasmOperand value;
+    uint8_t type; /* Spasm_x86_64_CallArgType */
+} Spasm_x86_64_CallArg;
+
+#define SPASM_X86_64_CALL_MAX_ARGS 32
+
+/*
+ * Pushes the call of target with the arguments, then moves the return value (RAX or XMM0) to
+ * result->value (register or memory) if result is not NULL. target is a register, a memory operand,
+ * a label, a symbol, or an immediate holding the absolute address of the function (called through
+ * R11). Errors are reported through ctx, which can be NULL (see spasm/context.h):
+ * SpasmErrorCode_UnsupportedABI, or SpasmErrorCode_InvalidCallArgument for an operand that does not
+ * match its type, a virtual register, or more than SPASM_X86_64_CALL_MAX_ARGS arguments
+ */
+SPASM_API bool spasm_x86_64_emit_call(SpasmContext* ctx,
+                                      SpasmInstructions* instructions,
+                                      SpasmABI abi,
+                                      SpasmOperand target,
+                                      const Spasm_x86_64_CallArg* args,
+                                      size_t num_args,
+                                      const Spasm_x86_64_CallArg* result);
+
+/*
+ * Minimum number of instructions per chunk when encoding a stream in parallel, smaller streams
+ * are always encoded sequentially
+ */
+#if !defined(SPASM_X86_64_PARALLEL_ENCODING_MIN_CHUNK)
+#define SPASM_X86_64_PARALLEL_ENCODING_MIN_CHUNK 8192
+#endif /* !defined(SPASM_X86_64_PARALLEL_ENCODING_MIN_CHUNK) */
+
+/*
+ * Encodes all the instructions at the end of out. If the context allows it (see
+ * spasm_context_set_max_encoding_threads), large streams are split in chunks encoded in parallel
+ * into separate buffers and concatenated, the result is byte-identical to encoding them one by one.
+ * If instr_end_offsets is not NULL, it receives the offset in out of the end of each instruction,
+ * to fix up the references that depend on the final layout (symbol relocations...). The offsets
+ * are only meaningful if the function succeeds. Alignments are relative to the start of out
+ */
+SPASM_API bool spasm_x86_64_encode_instructions(SpasmContext* ctx,
+                                                SpasmInstructions* instructions,
+                                                SpasmByteCode* out,
+                                                size_t* instr_end_offsets);
+
 #endif /* !defined(__SPASM_X86_64) */
 
 #endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,644 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#pragma once
+
+#if !defined(__SPASM_X86_64_ENCODER_HPP)
+#define __SPASM_X86_64_ENCODER_HPP
+
+/*
+    C++17 constexpr x86_64 encoder, for fixed instruction sequences (trampolines, stubs...) known at
+    compile time: they are encoded by the compiler into a std::array and become static data.
+
+    It walks the same generated forms (spasm/x86_64_forms.inc) as spasm_x86_64_encode_instruction
+    and follows the same encoding rules, so both produce the same bytes:
+
+        static constexpr spasm::x86_64::Instruction stub[] = {
+            { SpasmMnemonic_x86_64_MOV, spasm::x86_64::reg(SpasmRegister_x86_64_RAX), spasm::x86_64::imm64(0) },
+            { SpasmMnemonic_x86_64_JMP, spasm::x86_64::reg(SpasmRegister_x86_64_RAX) },
+        };
+
+        static constexpr auto stub_code = spasm::x86_64::encode<stub>(); // std::array<uint8_t, N>
+
+    An instruction without a matching form fails the compilation (no_matching_form is called
+    during the constant evaluation). Data and symbol operands are not supported, they need the
+    assembler.
+*/
+
+extern "C" {
+#include "spasm/x86_64.h"
+}
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace spasm {
+namespace x86_64 {
+
+#define SPASM_X86_64_FORM(mnemonic_, t0, t1, t2, t3, s0, s1, s2, s3, o0, o1, o2, o3, opcode_len_, needs_modrm_, \
+                          prefix_, pp_, mmmmm_, cpu_flag_, reg_in_opcode_, reg_in_modrm_reg_, modrm_reg_operand_, \
+                          reg_in_modrm_rm_, modrm_rm_operand_, force_rex_w_)                                    \
+    {                                                                                                      \
+        SpasmMnemonic_x86_64_##mnemonic_,                                                                  \
+        { SpasmOperandType_##t0, SpasmOperandType_##t1, SpasmOperandType_##t2, SpasmOperandType_##t3 },    \
+        { s0, s1, s2, s3 },                                                                                \
+        { o0, o1, o2, o3 },                                                                                \
+        opcode_len_,                                                                                       \
+        needs_modrm_,                                                                                      \
+        Spasm_x86_64_PrefixType_##prefix_,                                                                 \
+        pp_,                                                                                               \
+        mmmmm_,                                                                                            \
+        Spasm_x86_64_CPUFlag_##cpu_flag_,                                                                  \
+        reg_in_opcode_,                                                                                    \
+        reg_in_modrm_reg_,                                                                                 \
+        modrm_reg_operand_,                                                                                \
+        reg_in_modrm_rm_,                                                                                  \
+        modrm_rm_operand_,                                                                                 \
+        force_rex_w_,                                                                                      \
+    },
+
+/* Same content and order as spasm_x86_64_instruction_table */
+inline constexpr Spasm_x86_64_InstructionInfo forms[] = {
+#include "spasm/x86_64_forms.inc"
+};
+
+#undef SPASM_X86_64_FORM
+
+inline constexpr size_t num_forms = sizeof(forms) / sizeof(forms[0]);
+
+/* Prefix (4) + opcode (4) + ModR/M + SIB + displacement (4) + immediates (4 * 8) */
+inline constexpr size_t max_instruction_size = 46;
+
+struct Operand
+{
+    uint8_t type = SpasmOperandType_None; /* SpasmOperandType */
+    uint8_t reg = 0; /* Register operands, base register of memory operands */
+    uint8_t mem_index = 0;
+    uint8_t mem_scale = 0;
+    int32_t mem_displacement = 0;
+    int64_t imm_value = 0;
+};
+
+constexpr Operand reg(SpasmRegister r) noexcept
+{
+    Operand operand;
+    operand.type = SpasmOperandType_Register;
+    operand.reg = static_cast<uint8_t>(r);
+    return operand;
+}
+
+/* Same arguments as SpasmOpMemory */
+constexpr Operand mem(SpasmRegister base, SpasmRegister index, int32_t displacement, uint8_t scale) noexcept
+{
+    Operand operand;
+    operand.type = SpasmOperandType_Mem;
+    operand.reg = static_cast<uint8_t>(base);
+    operand.mem_index = static_cast<uint8_t>(index);
+    operand.mem_displacement = displacement;
+    operand.mem_scale = scale;
+    return operand;
+}
+
+constexpr Operand imm(SpasmOperandType type, int64_t value) noexcept
+{
+    Operand operand;
+    operand.type = static_cast<uint8_t>(type);
+    operand.imm_value = value;
+    return operand;
+}
+
+constexpr Operand imm8(int64_t value) noexcept { return imm(SpasmOperandType_Imm8, value); }
+constexpr Operand imm16(int64_t value) noexcept { return imm(SpasmOperandType_Imm16, value); }
+constexpr Operand imm32(int64_t value) noexcept { return imm(SpasmOperandType_Imm32, value); }
+constexpr Operand imm64(int64_t value) noexcept { return imm(SpasmOperandType_Imm64, value); }
+
+struct Instruction
+{
+    SpasmMnemonic mnemonic = SpasmMnemonic_Invalid;
+    uint8_t num_operands = 0;
+    Operand operands[SPASM_MAX_OPERANDS] = {};
+
+    constexpr Instruction() noexcept = default;
+
+    template<typename... Operands>
+    constexpr Instruction(SpasmMnemonic mnemonic_, Operands... operands_) noexcept
+        : mnemonic(mnemonic_),
+          num_operands(static_cast<uint8_t>(sizeof...(Operands))),
+          operands{ operands_... }
+    {
+        static_assert(sizeof...(Operands) <= SPASM_MAX_OPERANDS, "too many operands");
+    }
+};
+
+struct EncodedInstruction
+{
+    uint8_t bytes[max_instruction_size] = {};
+    uint8_t size = 0;
+    bool ok = false;
+
+    constexpr void push_back(uint8_t byte) noexcept { bytes[size++] = byte; }
+};
+
+namespace detail {
+
+/*
+    Register and operand helpers, computed as in x86_64.c (the register enum is unsigned there,
+    SpasmRegister_x86_64_NONE wraps around)
+*/
+
+constexpr uint8_t register_code(uint32_t r) noexcept
+{
+    return static_cast<uint8_t>((r - 1u) % 16u);
+}
+
+constexpr uint8_t register_rm(uint32_t r) noexcept
+{
+    return register_code(r) & 0x7;
+}
+
+constexpr uint32_t register_size(uint32_t r) noexcept
+{
+    return 8u << ((r - 1u) / 16u);
+}
+
+constexpr bool is_register_64(uint32_t r) noexcept
+{
+    /* Spasm_x86_64_RegisterWidth_64 */
+    return (r - 1u) / 16u + 1u == 4u;
+}
+
+constexpr uint32_t operand_size(const Operand& operand, uint32_t default_value) noexcept
+{
+    switch(operand.type)
+    {
+        case SpasmOperandType_Register:
+            return register_size(operand.reg);
+        case SpasmOperandType_Mem:
+            return default_value;
+        case SpasmOperandType_Imm8:
+            return 8;
+        case SpasmOperandType_Imm16:
+            return 16;
+        case SpasmOperandType_Imm32:
+            return 32;
+        case SpasmOperandType_Imm64:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+constexpr bool is_vex_or_evex(const Spasm_x86_64_InstructionInfo& form) noexcept
+{
+    return form.prefix == Spasm_x86_64_PrefixType_EVEX ||
+           form.prefix == Spasm_x86_64_PrefixType_VEX2 ||
+           form.prefix == Spasm_x86_64_PrefixType_VEX3;
+}
+
+constexpr bool is_default_64(uint32_t mnemonic) noexcept
+{
+    return mnemonic == SpasmMnemonic_x86_64_PUSH ||
+           mnemonic == SpasmMnemonic_x86_64_POP ||
+           mnemonic == SpasmMnemonic_x86_64_CALL ||
+           mnemonic == SpasmMnemonic_x86_64_JMP;
+}
+
+enum class RegisterField { None, Reg, Rm };
+
+/* As spasm_x86_64_legacy_register_field */
+constexpr RegisterField legacy_register_field(const Spasm_x86_64_InstructionInfo& form, uint8_t i) noexcept
+{
+    if(form.reg_in_opcode)
+        return i == 0 ? RegisterField::Rm : RegisterField::None;
+
+    if(!form.reg_in_modrm_rm || i > 1)
+        return RegisterField::None;
+
+    if(i == form.modrm_rm_operand)
+        return RegisterField::Rm;
+
+    return form.reg_in_modrm_reg ? RegisterField::None : RegisterField::Reg;
+}
+
+/* As spasm_x86_64_is_operand_size_16 */
+constexpr bool is_operand_size_16(const Spasm_x86_64_InstructionInfo& form) noexcept
+{
+    if(form.operand_types[0] == SpasmOperandType_Register && form.operand_sizes[0] == 16)
+        return true;
+
+    if(form.operand_types[0] == SpasmOperandType_Mem && form.operand_types[1] == SpasmOperandType_Imm16)
+        return true;
+
+    if(form.operand_types[0] == SpasmOperandType_Mem &&
+       form.operand_types[1] == SpasmOperandType_Register &&
+       form.operand_sizes[1] == 16)
+        return true;
+
+    return form.mnemonic == SpasmMnemonic_x86_64_CRC32 && form.operand_sizes[1] == 16;
+}
+
+/* Forms are sorted by mnemonic, returns the first one of the mnemonic */
+constexpr size_t lower_bound_form(uint16_t mnemonic) noexcept
+{
+    size_t low = 0;
+    size_t high = num_forms;
+
+    while(low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+
+        if(forms[mid].mnemonic < mnemonic)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+constexpr const Spasm_x86_64_InstructionInfo* find_form(const Instruction& instr) noexcept
+{
+    for(size_t i = lower_bound_form(static_cast<uint16_t>(instr.mnemonic));
+        i < num_forms && forms[i].mnemonic == instr.mnemonic;
+        i++)
+    {
+        const Spasm_x86_64_InstructionInfo& form = forms[i];
+
+        bool match = true;
+
+        for(uint8_t j = 0; j < instr.num_operands; j++)
+        {
+            if(instr.operands[j].type != form.operand_types[j] ||
+               (form.operand_sizes[j] != 0 &&
+                operand_size(instr.operands[j], form.operand_sizes[j]) != form.operand_sizes[j]))
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if(match)
+            return &form;
+    }
+
+    return nullptr;
+}
+
+constexpr void encode_prefix(const Instruction& instr,
+                             const Spasm_x86_64_InstructionInfo& form,
+                             EncodedInstruction& out) noexcept
+{
+    bool needs_rex = false;
+
+    for(uint8_t i = 0; i < instr.num_operands; i++)
+        needs_rex |= instr.operands[i].type == SpasmOperandType_Register &&
+                     register_code(instr.operands[i].reg) > 7;
+
+    needs_rex |= form.prefix == Spasm_x86_64_PrefixType_REX;
+
+    const uint8_t vector_len = form.operand_sizes[0] == 512 ? 2 : form.operand_sizes[0] == 256 ? 1 : 0;
+
+    uint8_t R = 0, X = 0, B = 0, W = 0, vvvv = 0, aaa = 0;
+    bool needs_empty_rex = false;
+
+    if(!is_vex_or_evex(form) && form.force_rex_w)
+        W = 1;
+
+    for(uint8_t i = 0; i < instr.num_operands; i++)
+    {
+        const Operand& operand = instr.operands[i];
+
+        if(operand.type == SpasmOperandType_Register)
+        {
+            const uint8_t code = register_code(operand.reg);
+
+            if(is_vex_or_evex(form))
+            {
+                if(code > 7)
+                {
+                    if(i == 0)
+                        R = 1;
+                    else if(i == 1)
+                        vvvv = code & 0xF;
+                    else if(i == 2)
+                        B = 1;
+                }
+
+                /* Spasm_x86_64_RegisterWidth_OpMask */
+                if(form.prefix == Spasm_x86_64_PrefixType_EVEX && register_size(operand.reg) == 8)
+                    aaa = code & 0x7;
+            }
+            else
+            {
+                if(code > 7)
+                {
+                    const RegisterField field = legacy_register_field(form, i);
+
+                    if(field == RegisterField::Reg)
+                        R = 1;
+                    else if(field == RegisterField::Rm)
+                        B = 1;
+                }
+
+                if(register_size(operand.reg) == 8 && code >= 4 && code <= 7)
+                    needs_empty_rex = true;
+            }
+
+            if(is_register_64(operand.reg) && (is_vex_or_evex(form) || !is_default_64(instr.mnemonic)))
+                W = 1;
+        }
+
+        if(operand.type == SpasmOperandType_Mem)
+        {
+            if(register_code(operand.reg) > 7)
+                B = 1;
+
+            if(operand.mem_index != SpasmRegister_x86_64_NONE && register_code(operand.mem_index) > 7)
+                X = 1;
+        }
+    }
+
+    if(form.prefix == Spasm_x86_64_PrefixType_EVEX)
+    {
+        out.push_back(0x62);
+        out.push_back(static_cast<uint8_t>((R << 7) | (X << 6) | (B << 5) | form.mmmmm));
+        out.push_back(static_cast<uint8_t>((W << 7) | (vvvv << 3) | (1 << 2) | form.pp));
+        out.push_back(static_cast<uint8_t>((vector_len << 5) | aaa));
+    }
+    else if(form.prefix == Spasm_x86_64_PrefixType_VEX2 || form.prefix == Spasm_x86_64_PrefixType_VEX3)
+    {
+        const uint8_t L = vector_len & 0x1;
+
+        if(form.prefix == Spasm_x86_64_PrefixType_VEX3 || X || B || form.mmmmm != 0x01 || W)
+        {
+            out.push_back(0xC4);
+            out.push_back(static_cast<uint8_t>((R << 7) | (X << 6) | (B << 5) | form.mmmmm));
+            out.push_back(static_cast<uint8_t>((W << 7) | (vvvv << 3) | (L << 2) | form.pp));
+        }
+        else
+        {
+            out.push_back(0xC5);
+            out.push_back(static_cast<uint8_t>((R << 7) | (vvvv << 3) | (L << 2) | form.pp));
+        }
+    }
+    else
+    {
+        /* Operand size prefix of the 16 bits forms, before REX */
+        if(is_operand_size_16(form))
+            out.push_back(0x66);
+
+        /* Mandatory prefix of the legacy SSE forms, pp as in VEX (66, F3, F2), before REX */
+        if(form.pp != 0)
+            out.push_back(form.pp == 1 ? 0x66 : form.pp == 2 ? 0xF3 : 0xF2);
+
+        if(needs_rex && (W || R || X || B || needs_empty_rex))
+            out.push_back(static_cast<uint8_t>(0x40 | (W << 3) | (R << 2) | (X << 1) | B));
+    }
+}
+
+struct ModRMSibOffset
+{
+    uint8_t modrm = 0;
+    uint8_t sib = 0;
+    bool has_sib = false;
+    bool has_disp8 = false;
+    bool has_disp32 = false;
+    uint8_t disp8 = 0;
+    int32_t disp32 = 0;
+};
+
+constexpr ModRMSibOffset encode_modrm_sib_offset(const Operand& dst,
+                                                 const Operand& src,
+                                                 const Spasm_x86_64_InstructionInfo& form) noexcept
+{
+    ModRMSibOffset result;
+
+    const bool has_digit = form.reg_in_modrm_reg && !is_vex_or_evex(form);
+
+    if(dst.type == SpasmOperandType_Register && src.type == SpasmOperandType_Register && !has_digit)
+    {
+        if(form.reg_in_modrm_rm)
+        {
+            const Operand& rm_operand = form.modrm_rm_operand == 0 ? dst : src;
+            const Operand& reg_operand = form.modrm_rm_operand == 0 ? src : dst;
+
+            result.modrm = static_cast<uint8_t>(0xC0 | (register_rm(reg_operand.reg) << 3) | register_rm(rm_operand.reg));
+        }
+        else if(form.operand_sizes[0] > 64)
+            result.modrm = static_cast<uint8_t>(0xC0 | (register_rm(dst.reg) << 3) | register_rm(src.reg));
+        else
+            result.modrm = static_cast<uint8_t>(0xC0 | (register_rm(src.reg) << 3) | register_rm(dst.reg));
+
+        return result;
+    }
+
+    if(dst.type == SpasmOperandType_Register && src.type != SpasmOperandType_Mem)
+    {
+        result.modrm = static_cast<uint8_t>(0xC0 | register_rm(dst.reg));
+
+        if(form.reg_in_modrm_reg)
+            result.modrm |= static_cast<uint8_t>(form.modrm_reg_operand << 3);
+
+        return result;
+    }
+
+    const Operand& mem_operand = dst.type == SpasmOperandType_Mem ? dst : src;
+    const Operand& reg_operand = dst.type == SpasmOperandType_Mem ? src : dst;
+
+    const uint32_t base = mem_operand.reg;
+    const uint32_t index = mem_operand.mem_index;
+    const uint8_t scale = mem_operand.mem_scale;
+    const int32_t disp = mem_operand.mem_displacement;
+
+    uint8_t scale_bits = 0;
+
+    if(scale == 2)
+        scale_bits = 1;
+    else if(scale == 4)
+        scale_bits = 2;
+    else if(scale == 8)
+        scale_bits = 3;
+    else if(scale != 1 && scale != 0)
+        return result;
+
+    uint8_t mod = 0;
+
+    if(disp == 0 && base != SpasmRegister_x86_64_RBP && base != SpasmRegister_x86_64_R13)
+    {
+        mod = 0;
+    }
+    else if(disp >= -128 && disp <= 127)
+    {
+        mod = 1;
+        result.has_disp8 = true;
+        result.disp8 = static_cast<uint8_t>(disp);
+    }
+    else
+    {
+        mod = 2;
+        result.has_disp32 = true;
+        result.disp32 = disp;
+    }
+
+    uint8_t rm = 0;
+
+    if(index != SpasmRegister_x86_64_NONE ||
+       scale != 1 ||
+       base == SpasmRegister_x86_64_RSP ||
+       base == SpasmRegister_x86_64_R12)
+    {
+        result.has_sib = true;
+        rm = 4;
+
+        if(index == SpasmRegister_x86_64_NONE)
+            result.sib = static_cast<uint8_t>((scale_bits << 6) | (4 << 3) | register_rm(base));
+        else
+            result.sib = static_cast<uint8_t>((scale_bits << 6) | (register_rm(index) << 3) | register_rm(base));
+    }
+    else if(base == SpasmRegister_x86_64_RIP || base == SpasmRegister_x86_64_NONE)
+    {
+        mod = 0;
+        rm = 5;
+        result.has_disp32 = true;
+        result.disp32 = disp;
+    }
+    else
+    {
+        rm = register_rm(base);
+    }
+
+    const uint8_t reg = has_digit ? form.modrm_reg_operand :
+                        reg_operand.type == SpasmOperandType_Register ? register_rm(reg_operand.reg) : 0;
+
+    result.modrm = static_cast<uint8_t>((mod << 6) | (reg << 3) | rm);
+
+    return result;
+}
+
+/* Called when no form matches an instruction, which stops the constant evaluation */
+inline void no_matching_form() noexcept {}
+
+} /* namespace detail */
+
+/*
+ * Encodes a single instruction, ok is false if no form matches. Usable at compile time and at
+ * run time
+ */
+constexpr EncodedInstruction encode_instruction(const Instruction& instr) noexcept
+{
+    EncodedInstruction out;
+
+    const Spasm_x86_64_InstructionInfo* form = detail::find_form(instr);
+
+    if(form == nullptr)
+        return out;
+
+    detail::encode_prefix(instr, *form, out);
+
+    for(uint8_t i = 0; i < form->opcode_len; i++)
+    {
+        uint8_t opcode = form->opcode[i];
+
+        /* +r, the register is added to the last opcode byte */
+        if(form->reg_in_opcode && !detail::is_vex_or_evex(*form) && i == form->opcode_len - 1)
+            opcode = static_cast<uint8_t>(form->opcode[i] + (detail::register_code(instr.operands[0].reg) & 0x7));
+
+        out.push_back(opcode);
+    }
+
+    if(form->needs_modrm)
+    {
+        detail::ModRMSibOffset modrm_sib = detail::encode_modrm_sib_offset(instr.operands[0],
+                                                                           instr.operands[1],
+                                                                           *form);
+
+        out.push_back(modrm_sib.modrm);
+
+        if(modrm_sib.has_sib)
+            out.push_back(modrm_sib.sib);
+
+        if(modrm_sib.has_disp8)
+        {
+            out.push_back(modrm_sib.disp8);
+        }
+        else if(modrm_sib.has_disp32)
+        {
+            for(uint32_t j = 0; j < 4; j++)
+                out.push_back(static_cast<uint8_t>((static_cast<uint32_t>(modrm_sib.disp32) >> (j * 8)) & 0xFF));
+        }
+    }
+
+    for(uint8_t i = 0; i < instr.num_operands; i++)
+    {
+        const Operand& operand = instr.operands[i];
+
+        if(operand.type >= SpasmOperandType_Imm8 && operand.type <= SpasmOperandType_Imm64)
+        {
+            const uint32_t num_bytes = 1u << (operand.type - SpasmOperandType_Imm8);
+
+            for(uint32_t j = 0; j < num_bytes; j++)
+                out.push_back(static_cast<uint8_t>((static_cast<uint64_t>(operand.imm_value) >> (j * 8)) & 0xFF));
+        }
+    }
+
+    out.ok = true;
+
+    return out;
+}
+
+/*
+ * Size of the encoded instructions. An instruction without a matching form stops the constant
+ * evaluation (and returns 0 at run time)
+ */
+template<size_t N>
+constexpr size_t encoded_size(const Instruction (&instructions)[N]) noexcept
+{
+    size_t size = 0;
+
+    for(size_t i = 0; i < N; i++)
+    {
+        const EncodedInstruction encoded = encode_instruction(instructions[i]);
+
+        if(!encoded.ok)
+        {
+            detail::no_matching_form();
+            return 0;
+        }
+
+        size += encoded.size;
+    }
+
+    return size;
+}
+
+/*
+ * Encodes a static array of instructions into a std::array holding exactly the encoded bytes
+ */
+template<const auto& Instructions>
+constexpr auto encode() noexcept
+{
+    std::array<uint8_t, encoded_size(Instructions)> bytes{};
+
+    size_t offset = 0;
+
+    for(const Instruction& instr : Instructions)
+    {
+        const EncodedInstruction encoded = encode_instruction(instr);
+
+        for(uint8_t i = 0; i < encoded.size; i++)
+            bytes[offset++] = encoded.bytes[i];
+    }
+
+    return bytes;
+}
+
+} /* namespace x86_64 */
+} /* namespace spasm */
+
+#endif /* !defined(__SPASM_X86_64_ENCODER_HPP) */
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
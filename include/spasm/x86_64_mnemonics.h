@@ -0,0 +1,1242 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/* Auto-generated file, don't modify it */
+
+#pragma once
+
+#if !defined(__SPASM_X86_64_MNEMONICS)
+#define __SPASM_X86_64_MNEMONICS
+
+#define SPASM_X86_64_NUM_MNEMONICS 1225
+
+/* X(enum suffix, mnemonic string), sorted by mnemonic */
+#define SPASM_X86_64_MNEMONICS(X) \
+    X(ADC, "adc") \
+    X(ADCX, "adcx") \
+    X(ADD, "add") \
+    X(ADDPD, "addpd") \
+    X(ADDPS, "addps") \
+    X(ADDSD, "addsd") \
+    X(ADDSS, "addss") \
+    X(ADDSUBPD, "addsubpd") \
+    X(ADDSUBPS, "addsubps") \
+    X(ADOX, "adox") \
+    X(AESDEC, "aesdec") \
+    X(AESDECLAST, "aesdeclast") \
+    X(AESENC, "aesenc") \
+    X(AESENCLAST, "aesenclast") \
+    X(AESIMC, "aesimc") \
+    X(AESKEYGENASSIST, "aeskeygenassist") \
+    X(AND, "and") \
+    X(ANDN, "andn") \
+    X(ANDNPD, "andnpd") \
+    X(ANDNPS, "andnps") \
+    X(ANDPD, "andpd") \
+    X(ANDPS, "andps") \
+    X(BEXTR, "bextr") \
+    X(BLCFILL, "blcfill") \
+    X(BLCI, "blci") \
+    X(BLCIC, "blcic") \
+    X(BLCMSK, "blcmsk") \
+    X(BLCS, "blcs") \
+    X(BLENDPD, "blendpd") \
+    X(BLENDPS, "blendps") \
+    X(BLENDVPD, "blendvpd") \
+    X(BLENDVPS, "blendvps") \
+    X(BLSFILL, "blsfill") \
+    X(BLSI, "blsi") \
+    X(BLSIC, "blsic") \
+    X(BLSMSK, "blsmsk") \
+    X(BLSR, "blsr") \
+    X(BSF, "bsf") \
+    X(BSR, "bsr") \
+    X(BSWAP, "bswap") \
+    X(BT, "bt") \
+    X(BTC, "btc") \
+    X(BTR, "btr") \
+    X(BTS, "bts") \
+    X(BZHI, "bzhi") \
+    X(CALL, "call") \
+    X(CBW, "cbw") \
+    X(CDQ, "cdq") \
+    X(CDQE, "cdqe") \
+    X(CLC, "clc") \
+    X(CLD, "cld") \
+    X(CLFLUSH, "clflush") \
+    X(CLFLUSHOPT, "clflushopt") \
+    X(CLWB, "clwb") \
+    X(CLZERO, "clzero") \
+    X(CMC, "cmc") \
+    X(CMOVA, "cmova") \
+    X(CMOVAE, "cmovae") \
+    X(CMOVB, "cmovb") \
+    X(CMOVBE, "cmovbe") \
+    X(CMOVC, "cmovc") \
+    X(CMOVE, "cmove") \
+    X(CMOVG, "cmovg") \
+    X(CMOVGE, "cmovge") \
+    X(CMOVL, "cmovl") \
+    X(CMOVLE, "cmovle") \
+    X(CMOVNA, "cmovna") \
+    X(CMOVNAE, "cmovnae") \
+    X(CMOVNB, "cmovnb") \
+    X(CMOVNBE, "cmovnbe") \
+    X(CMOVNC, "cmovnc") \
+    X(CMOVNE, "cmovne") \
+    X(CMOVNG, "cmovng") \
+    X(CMOVNGE, "cmovnge") \
+    X(CMOVNL, "cmovnl") \
+    X(CMOVNLE, "cmovnle") \
+    X(CMOVNO, "cmovno") \
+    X(CMOVNP, "cmovnp") \
+    X(CMOVNS, "cmovns") \
+    X(CMOVNZ, "cmovnz") \
+    X(CMOVO, "cmovo") \
+    X(CMOVP, "cmovp") \
+    X(CMOVPE, "cmovpe") \
+    X(CMOVPO, "cmovpo") \
+    X(CMOVS, "cmovs") \
+    X(CMOVZ, "cmovz") \
+    X(CMP, "cmp") \
+    X(CMPPD, "cmppd") \
+    X(CMPPS, "cmpps") \
+    X(CMPSD, "cmpsd") \
+    X(CMPSS, "cmpss") \
+    X(CMPXCHG, "cmpxchg") \
+    X(CMPXCHG16B, "cmpxchg16b") \
+    X(CMPXCHG8B, "cmpxchg8b") \
+    X(COMISD, "comisd") \
+    X(COMISS, "comiss") \
+    X(CPUID, "cpuid") \
+    X(CQO, "cqo") \
+    X(CRC32, "crc32") \
+    X(CVTDQ2PD, "cvtdq2pd") \
+    X(CVTDQ2PS, "cvtdq2ps") \
+    X(CVTPD2DQ, "cvtpd2dq") \
+    X(CVTPD2PI, "cvtpd2pi") \
+    X(CVTPD2PS, "cvtpd2ps") \
+    X(CVTPI2PD, "cvtpi2pd") \
+    X(CVTPI2PS, "cvtpi2ps") \
+    X(CVTPS2DQ, "cvtps2dq") \
+    X(CVTPS2PD, "cvtps2pd") \
+    X(CVTPS2PI, "cvtps2pi") \
+    X(CVTSD2SI, "cvtsd2si") \
+    X(CVTSD2SS, "cvtsd2ss") \
+    X(CVTSI2SD, "cvtsi2sd") \
+    X(CVTSI2SS, "cvtsi2ss") \
+    X(CVTSS2SD, "cvtss2sd") \
+    X(CVTSS2SI, "cvtss2si") \
+    X(CVTTPD2DQ, "cvttpd2dq") \
+    X(CVTTPD2PI, "cvttpd2pi") \
+    X(CVTTPS2DQ, "cvttps2dq") \
+    X(CVTTPS2PI, "cvttps2pi") \
+    X(CVTTSD2SI, "cvttsd2si") \
+    X(CVTTSS2SI, "cvttss2si") \
+    X(CWD, "cwd") \
+    X(CWDE, "cwde") \
+    X(DEC, "dec") \
+    X(DIV, "div") \
+    X(DIVPD, "divpd") \
+    X(DIVPS, "divps") \
+    X(DIVSD, "divsd") \
+    X(DIVSS, "divss") \
+    X(DPPD, "dppd") \
+    X(DPPS, "dpps") \
+    X(EMMS, "emms") \
+    X(EXTRACTPS, "extractps") \
+    X(EXTRQ, "extrq") \
+    X(FEMMS, "femms") \
+    X(HADDPD, "haddpd") \
+    X(HADDPS, "haddps") \
+    X(HSUBPD, "hsubpd") \
+    X(HSUBPS, "hsubps") \
+    X(IDIV, "idiv") \
+    X(IMUL, "imul") \
+    X(INC, "inc") \
+    X(INSERTPS, "insertps") \
+    X(INSERTQ, "insertq") \
+    X(INT, "int") \
+    X(JA, "ja") \
+    X(JAE, "jae") \
+    X(JB, "jb") \
+    X(JBE, "jbe") \
+    X(JC, "jc") \
+    X(JE, "je") \
+    X(JECXZ, "jecxz") \
+    X(JG, "jg") \
+    X(JGE, "jge") \
+    X(JL, "jl") \
+    X(JLE, "jle") \
+    X(JMP, "jmp") \
+    X(JNA, "jna") \
+    X(JNAE, "jnae") \
+    X(JNB, "jnb") \
+    X(JNBE, "jnbe") \
+    X(JNC, "jnc") \
+    X(JNE, "jne") \
+    X(JNG, "jng") \
+    X(JNGE, "jnge") \
+    X(JNL, "jnl") \
+    X(JNLE, "jnle") \
+    X(JNO, "jno") \
+    X(JNP, "jnp") \
+    X(JNS, "jns") \
+    X(JNZ, "jnz") \
+    X(JO, "jo") \
+    X(JP, "jp") \
+    X(JPE, "jpe") \
+    X(JPO, "jpo") \
+    X(JRCXZ, "jrcxz") \
+    X(JS, "js") \
+    X(JZ, "jz") \
+    X(KADDB, "kaddb") \
+    X(KADDD, "kaddd") \
+    X(KADDQ, "kaddq") \
+    X(KADDW, "kaddw") \
+    X(KANDB, "kandb") \
+    X(KANDD, "kandd") \
+    X(KANDNB, "kandnb") \
+    X(KANDND, "kandnd") \
+    X(KANDNQ, "kandnq") \
+    X(KANDNW, "kandnw") \
+    X(KANDQ, "kandq") \
+    X(KANDW, "kandw") \
+    X(KMOVB, "kmovb") \
+    X(KMOVD, "kmovd") \
+    X(KMOVQ, "kmovq") \
+    X(KMOVW, "kmovw") \
+    X(KNOTB, "knotb") \
+    X(KNOTD, "knotd") \
+    X(KNOTQ, "knotq") \
+    X(KNOTW, "knotw") \
+    X(KORB, "korb") \
+    X(KORD, "kord") \
+    X(KORQ, "korq") \
+    X(KORTESTB, "kortestb") \
+    X(KORTESTD, "kortestd") \
+    X(KORTESTQ, "kortestq") \
+    X(KORTESTW, "kortestw") \
+    X(KORW, "korw") \
+    X(KSHIFTLB, "kshiftlb") \
+    X(KSHIFTLD, "kshiftld") \
+    X(KSHIFTLQ, "kshiftlq") \
+    X(KSHIFTLW, "kshiftlw") \
+    X(KSHIFTRB, "kshiftrb") \
+    X(KSHIFTRD, "kshiftrd") \
+    X(KSHIFTRQ, "kshiftrq") \
+    X(KSHIFTRW, "kshiftrw") \
+    X(KTESTB, "ktestb") \
+    X(KTESTD, "ktestd") \
+    X(KTESTQ, "ktestq") \
+    X(KTESTW, "ktestw") \
+    X(KUNPCKBW, "kunpckbw") \
+    X(KUNPCKDQ, "kunpckdq") \
+    X(KUNPCKWD, "kunpckwd") \
+    X(KXNORB, "kxnorb") \
+    X(KXNORD, "kxnord") \
+    X(KXNORQ, "kxnorq") \
+    X(KXNORW, "kxnorw") \
+    X(KXORB, "kxorb") \
+    X(KXORD, "kxord") \
+    X(KXORQ, "kxorq") \
+    X(KXORW, "kxorw") \
+    X(LDDQU, "lddqu") \
+    X(LDMXCSR, "ldmxcsr") \
+    X(LEA, "lea") \
+    X(LFENCE, "lfence") \
+    X(LZCNT, "lzcnt") \
+    X(MASKMOVDQU, "maskmovdqu") \
+    X(MASKMOVQ, "maskmovq") \
+    X(MAXPD, "maxpd") \
+    X(MAXPS, "maxps") \
+    X(MAXSD, "maxsd") \
+    X(MAXSS, "maxss") \
+    X(MFENCE, "mfence") \
+    X(MINPD, "minpd") \
+    X(MINPS, "minps") \
+    X(MINSD, "minsd") \
+    X(MINSS, "minss") \
+    X(MONITOR, "monitor") \
+    X(MONITORX, "monitorx") \
+    X(MOV, "mov") \
+    X(MOVAPD, "movapd") \
+    X(MOVAPS, "movaps") \
+    X(MOVBE, "movbe") \
+    X(MOVD, "movd") \
+    X(MOVDDUP, "movddup") \
+    X(MOVDQ2Q, "movdq2q") \
+    X(MOVDQA, "movdqa") \
+    X(MOVDQU, "movdqu") \
+    X(MOVHLPS, "movhlps") \
+    X(MOVHPD, "movhpd") \
+    X(MOVHPS, "movhps") \
+    X(MOVLHPS, "movlhps") \
+    X(MOVLPD, "movlpd") \
+    X(MOVLPS, "movlps") \
+    X(MOVMSKPD, "movmskpd") \
+    X(MOVMSKPS, "movmskps") \
+    X(MOVNTDQ, "movntdq") \
+    X(MOVNTDQA, "movntdqa") \
+    X(MOVNTI, "movnti") \
+    X(MOVNTPD, "movntpd") \
+    X(MOVNTPS, "movntps") \
+    X(MOVNTQ, "movntq") \
+    X(MOVNTSD, "movntsd") \
+    X(MOVNTSS, "movntss") \
+    X(MOVQ, "movq") \
+    X(MOVQ2DQ, "movq2dq") \
+    X(MOVSD, "movsd") \
+    X(MOVSHDUP, "movshdup") \
+    X(MOVSLDUP, "movsldup") \
+    X(MOVSS, "movss") \
+    X(MOVSX, "movsx") \
+    X(MOVSXD, "movsxd") \
+    X(MOVUPD, "movupd") \
+    X(MOVUPS, "movups") \
+    X(MOVZX, "movzx") \
+    X(MPSADBW, "mpsadbw") \
+    X(MUL, "mul") \
+    X(MULPD, "mulpd") \
+    X(MULPS, "mulps") \
+    X(MULSD, "mulsd") \
+    X(MULSS, "mulss") \
+    X(MULX, "mulx") \
+    X(MWAIT, "mwait") \
+    X(MWAITX, "mwaitx") \
+    X(NEG, "neg") \
+    X(NOP, "nop") \
+    X(NOT, "not") \
+    X(OR, "or") \
+    X(ORPD, "orpd") \
+    X(ORPS, "orps") \
+    X(PABSB, "pabsb") \
+    X(PABSD, "pabsd") \
+    X(PABSW, "pabsw") \
+    X(PACKSSDW, "packssdw") \
+    X(PACKSSWB, "packsswb") \
+    X(PACKUSDW, "packusdw") \
+    X(PACKUSWB, "packuswb") \
+    X(PADDB, "paddb") \
+    X(PADDD, "paddd") \
+    X(PADDQ, "paddq") \
+    X(PADDSB, "paddsb") \
+    X(PADDSW, "paddsw") \
+    X(PADDUSB, "paddusb") \
+    X(PADDUSW, "paddusw") \
+    X(PADDW, "paddw") \
+    X(PALIGNR, "palignr") \
+    X(PAND, "pand") \
+    X(PANDN, "pandn") \
+    X(PAUSE, "pause") \
+    X(PAVGB, "pavgb") \
+    X(PAVGUSB, "pavgusb") \
+    X(PAVGW, "pavgw") \
+    X(PBLENDVB, "pblendvb") \
+    X(PBLENDW, "pblendw") \
+    X(PCLMULQDQ, "pclmulqdq") \
+    X(PCMPEQB, "pcmpeqb") \
+    X(PCMPEQD, "pcmpeqd") \
+    X(PCMPEQQ, "pcmpeqq") \
+    X(PCMPEQW, "pcmpeqw") \
+    X(PCMPESTRI, "pcmpestri") \
+    X(PCMPESTRM, "pcmpestrm") \
+    X(PCMPGTB, "pcmpgtb") \
+    X(PCMPGTD, "pcmpgtd") \
+    X(PCMPGTQ, "pcmpgtq") \
+    X(PCMPGTW, "pcmpgtw") \
+    X(PCMPISTRI, "pcmpistri") \
+    X(PCMPISTRM, "pcmpistrm") \
+    X(PDEP, "pdep") \
+    X(PEXT, "pext") \
+    X(PEXTRB, "pextrb") \
+    X(PEXTRD, "pextrd") \
+    X(PEXTRQ, "pextrq") \
+    X(PEXTRW, "pextrw") \
+    X(PF2ID, "pf2id") \
+    X(PF2IW, "pf2iw") \
+    X(PFACC, "pfacc") \
+    X(PFADD, "pfadd") \
+    X(PFCMPEQ, "pfcmpeq") \
+    X(PFCMPGE, "pfcmpge") \
+    X(PFCMPGT, "pfcmpgt") \
+    X(PFMAX, "pfmax") \
+    X(PFMIN, "pfmin") \
+    X(PFMUL, "pfmul") \
+    X(PFNACC, "pfnacc") \
+    X(PFPNACC, "pfpnacc") \
+    X(PFRCP, "pfrcp") \
+    X(PFRCPIT1, "pfrcpit1") \
+    X(PFRCPIT2, "pfrcpit2") \
+    X(PFRSQIT1, "pfrsqit1") \
+    X(PFRSQRT, "pfrsqrt") \
+    X(PFSUB, "pfsub") \
+    X(PFSUBR, "pfsubr") \
+    X(PHADDD, "phaddd") \
+    X(PHADDSW, "phaddsw") \
+    X(PHADDW, "phaddw") \
+    X(PHMINPOSUW, "phminposuw") \
+    X(PHSUBD, "phsubd") \
+    X(PHSUBSW, "phsubsw") \
+    X(PHSUBW, "phsubw") \
+    X(PI2FD, "pi2fd") \
+    X(PI2FW, "pi2fw") \
+    X(PINSRB, "pinsrb") \
+    X(PINSRD, "pinsrd") \
+    X(PINSRQ, "pinsrq") \
+    X(PINSRW, "pinsrw") \
+    X(PMADDUBSW, "pmaddubsw") \
+    X(PMADDWD, "pmaddwd") \
+    X(PMAXSB, "pmaxsb") \
+    X(PMAXSD, "pmaxsd") \
+    X(PMAXSW, "pmaxsw") \
+    X(PMAXUB, "pmaxub") \
+    X(PMAXUD, "pmaxud") \
+    X(PMAXUW, "pmaxuw") \
+    X(PMINSB, "pminsb") \
+    X(PMINSD, "pminsd") \
+    X(PMINSW, "pminsw") \
+    X(PMINUB, "pminub") \
+    X(PMINUD, "pminud") \
+    X(PMINUW, "pminuw") \
+    X(PMOVMSKB, "pmovmskb") \
+    X(PMOVSXBD, "pmovsxbd") \
+    X(PMOVSXBQ, "pmovsxbq") \
+    X(PMOVSXBW, "pmovsxbw") \
+    X(PMOVSXDQ, "pmovsxdq") \
+    X(PMOVSXWD, "pmovsxwd") \
+    X(PMOVSXWQ, "pmovsxwq") \
+    X(PMOVZXBD, "pmovzxbd") \
+    X(PMOVZXBQ, "pmovzxbq") \
+    X(PMOVZXBW, "pmovzxbw") \
+    X(PMOVZXDQ, "pmovzxdq") \
+    X(PMOVZXWD, "pmovzxwd") \
+    X(PMOVZXWQ, "pmovzxwq") \
+    X(PMULDQ, "pmuldq") \
+    X(PMULHRSW, "pmulhrsw") \
+    X(PMULHRW, "pmulhrw") \
+    X(PMULHUW, "pmulhuw") \
+    X(PMULHW, "pmulhw") \
+    X(PMULLD, "pmulld") \
+    X(PMULLW, "pmullw") \
+    X(PMULUDQ, "pmuludq") \
+    X(POP, "pop") \
+    X(POPCNT, "popcnt") \
+    X(POR, "por") \
+    X(PREFETCH, "prefetch") \
+    X(PREFETCHNTA, "prefetchnta") \
+    X(PREFETCHT0, "prefetcht0") \
+    X(PREFETCHT1, "prefetcht1") \
+    X(PREFETCHT2, "prefetcht2") \
+    X(PREFETCHW, "prefetchw") \
+    X(PREFETCHWT1, "prefetchwt1") \
+    X(PSADBW, "psadbw") \
+    X(PSHUFB, "pshufb") \
+    X(PSHUFD, "pshufd") \
+    X(PSHUFHW, "pshufhw") \
+    X(PSHUFLW, "pshuflw") \
+    X(PSHUFW, "pshufw") \
+    X(PSIGNB, "psignb") \
+    X(PSIGND, "psignd") \
+    X(PSIGNW, "psignw") \
+    X(PSLLD, "pslld") \
+    X(PSLLDQ, "pslldq") \
+    X(PSLLQ, "psllq") \
+    X(PSLLW, "psllw") \
+    X(PSRAD, "psrad") \
+    X(PSRAW, "psraw") \
+    X(PSRLD, "psrld") \
+    X(PSRLDQ, "psrldq") \
+    X(PSRLQ, "psrlq") \
+    X(PSRLW, "psrlw") \
+    X(PSUBB, "psubb") \
+    X(PSUBD, "psubd") \
+    X(PSUBQ, "psubq") \
+    X(PSUBSB, "psubsb") \
+    X(PSUBSW, "psubsw") \
+    X(PSUBUSB, "psubusb") \
+    X(PSUBUSW, "psubusw") \
+    X(PSUBW, "psubw") \
+    X(PSWAPD, "pswapd") \
+    X(PTEST, "ptest") \
+    X(PUNPCKHBW, "punpckhbw") \
+    X(PUNPCKHDQ, "punpckhdq") \
+    X(PUNPCKHQDQ, "punpckhqdq") \
+    X(PUNPCKHWD, "punpckhwd") \
+    X(PUNPCKLBW, "punpcklbw") \
+    X(PUNPCKLDQ, "punpckldq") \
+    X(PUNPCKLQDQ, "punpcklqdq") \
+    X(PUNPCKLWD, "punpcklwd") \
+    X(PUSH, "push") \
+    X(PXOR, "pxor") \
+    X(RCL, "rcl") \
+    X(RCPPS, "rcpps") \
+    X(RCPSS, "rcpss") \
+    X(RCR, "rcr") \
+    X(RDRAND, "rdrand") \
+    X(RDSEED, "rdseed") \
+    X(RDTSC, "rdtsc") \
+    X(RDTSCP, "rdtscp") \
+    X(RET, "ret") \
+    X(ROL, "rol") \
+    X(ROR, "ror") \
+    X(RORX, "rorx") \
+    X(ROUNDPD, "roundpd") \
+    X(ROUNDPS, "roundps") \
+    X(ROUNDSD, "roundsd") \
+    X(ROUNDSS, "roundss") \
+    X(RSQRTPS, "rsqrtps") \
+    X(RSQRTSS, "rsqrtss") \
+    X(SAL, "sal") \
+    X(SAR, "sar") \
+    X(SARX, "sarx") \
+    X(SBB, "sbb") \
+    X(SETA, "seta") \
+    X(SETAE, "setae") \
+    X(SETB, "setb") \
+    X(SETBE, "setbe") \
+    X(SETC, "setc") \
+    X(SETE, "sete") \
+    X(SETG, "setg") \
+    X(SETGE, "setge") \
+    X(SETL, "setl") \
+    X(SETLE, "setle") \
+    X(SETNA, "setna") \
+    X(SETNAE, "setnae") \
+    X(SETNB, "setnb") \
+    X(SETNBE, "setnbe") \
+    X(SETNC, "setnc") \
+    X(SETNE, "setne") \
+    X(SETNG, "setng") \
+    X(SETNGE, "setnge") \
+    X(SETNL, "setnl") \
+    X(SETNLE, "setnle") \
+    X(SETNO, "setno") \
+    X(SETNP, "setnp") \
+    X(SETNS, "setns") \
+    X(SETNZ, "setnz") \
+    X(SETO, "seto") \
+    X(SETP, "setp") \
+    X(SETPE, "setpe") \
+    X(SETPO, "setpo") \
+    X(SETS, "sets") \
+    X(SETZ, "setz") \
+    X(SFENCE, "sfence") \
+    X(SHA1MSG1, "sha1msg1") \
+    X(SHA1MSG2, "sha1msg2") \
+    X(SHA1NEXTE, "sha1nexte") \
+    X(SHA1RNDS4, "sha1rnds4") \
+    X(SHA256MSG1, "sha256msg1") \
+    X(SHA256MSG2, "sha256msg2") \
+    X(SHA256RNDS2, "sha256rnds2") \
+    X(SHL, "shl") \
+    X(SHLD, "shld") \
+    X(SHLX, "shlx") \
+    X(SHR, "shr") \
+    X(SHRD, "shrd") \
+    X(SHRX, "shrx") \
+    X(SHUFPD, "shufpd") \
+    X(SHUFPS, "shufps") \
+    X(SQRTPD, "sqrtpd") \
+    X(SQRTPS, "sqrtps") \
+    X(SQRTSD, "sqrtsd") \
+    X(SQRTSS, "sqrtss") \
+    X(STC, "stc") \
+    X(STD, "std") \
+    X(STMXCSR, "stmxcsr") \
+    X(SUB, "sub") \
+    X(SUBPD, "subpd") \
+    X(SUBPS, "subps") \
+    X(SUBSD, "subsd") \
+    X(SUBSS, "subss") \
+    X(SYSCALL, "syscall") \
+    X(T1MSKC, "t1mskc") \
+    X(TEST, "test") \
+    X(TZCNT, "tzcnt") \
+    X(TZMSK, "tzmsk") \
+    X(UCOMISD, "ucomisd") \
+    X(UCOMISS, "ucomiss") \
+    X(UD2, "ud2") \
+    X(UNPCKHPD, "unpckhpd") \
+    X(UNPCKHPS, "unpckhps") \
+    X(UNPCKLPD, "unpcklpd") \
+    X(UNPCKLPS, "unpcklps") \
+    X(VADDPD, "vaddpd") \
+    X(VADDPS, "vaddps") \
+    X(VADDSD, "vaddsd") \
+    X(VADDSS, "vaddss") \
+    X(VADDSUBPD, "vaddsubpd") \
+    X(VADDSUBPS, "vaddsubps") \
+    X(VAESDEC, "vaesdec") \
+    X(VAESDECLAST, "vaesdeclast") \
+    X(VAESENC, "vaesenc") \
+    X(VAESENCLAST, "vaesenclast") \
+    X(VAESIMC, "vaesimc") \
+    X(VAESKEYGENASSIST, "vaeskeygenassist") \
+    X(VALIGND, "valignd") \
+    X(VALIGNQ, "valignq") \
+    X(VANDNPD, "vandnpd") \
+    X(VANDNPS, "vandnps") \
+    X(VANDPD, "vandpd") \
+    X(VANDPS, "vandps") \
+    X(VBLENDMPD, "vblendmpd") \
+    X(VBLENDMPS, "vblendmps") \
+    X(VBLENDPD, "vblendpd") \
+    X(VBLENDPS, "vblendps") \
+    X(VBLENDVPD, "vblendvpd") \
+    X(VBLENDVPS, "vblendvps") \
+    X(VBROADCASTF128, "vbroadcastf128") \
+    X(VBROADCASTF32X2, "vbroadcastf32x2") \
+    X(VBROADCASTF32X4, "vbroadcastf32x4") \
+    X(VBROADCASTF32X8, "vbroadcastf32x8") \
+    X(VBROADCASTF64X2, "vbroadcastf64x2") \
+    X(VBROADCASTF64X4, "vbroadcastf64x4") \
+    X(VBROADCASTI128, "vbroadcasti128") \
+    X(VBROADCASTI32X2, "vbroadcasti32x2") \
+    X(VBROADCASTI32X4, "vbroadcasti32x4") \
+    X(VBROADCASTI32X8, "vbroadcasti32x8") \
+    X(VBROADCASTI64X2, "vbroadcasti64x2") \
+    X(VBROADCASTI64X4, "vbroadcasti64x4") \
+    X(VBROADCASTSD, "vbroadcastsd") \
+    X(VBROADCASTSS, "vbroadcastss") \
+    X(VCMPPD, "vcmppd") \
+    X(VCMPPS, "vcmpps") \
+    X(VCMPSD, "vcmpsd") \
+    X(VCMPSS, "vcmpss") \
+    X(VCOMISD, "vcomisd") \
+    X(VCOMISS, "vcomiss") \
+    X(VCOMPRESSPD, "vcompresspd") \
+    X(VCOMPRESSPS, "vcompressps") \
+    X(VCVTDQ2PD, "vcvtdq2pd") \
+    X(VCVTDQ2PS, "vcvtdq2ps") \
+    X(VCVTPD2DQ, "vcvtpd2dq") \
+    X(VCVTPD2PS, "vcvtpd2ps") \
+    X(VCVTPD2QQ, "vcvtpd2qq") \
+    X(VCVTPD2UDQ, "vcvtpd2udq") \
+    X(VCVTPD2UQQ, "vcvtpd2uqq") \
+    X(VCVTPH2PS, "vcvtph2ps") \
+    X(VCVTPS2DQ, "vcvtps2dq") \
+    X(VCVTPS2PD, "vcvtps2pd") \
+    X(VCVTPS2PH, "vcvtps2ph") \
+    X(VCVTPS2QQ, "vcvtps2qq") \
+    X(VCVTPS2UDQ, "vcvtps2udq") \
+    X(VCVTPS2UQQ, "vcvtps2uqq") \
+    X(VCVTQQ2PD, "vcvtqq2pd") \
+    X(VCVTQQ2PS, "vcvtqq2ps") \
+    X(VCVTSD2SI, "vcvtsd2si") \
+    X(VCVTSD2SS, "vcvtsd2ss") \
+    X(VCVTSD2USI, "vcvtsd2usi") \
+    X(VCVTSI2SD, "vcvtsi2sd") \
+    X(VCVTSI2SS, "vcvtsi2ss") \
+    X(VCVTSS2SD, "vcvtss2sd") \
+    X(VCVTSS2SI, "vcvtss2si") \
+    X(VCVTSS2USI, "vcvtss2usi") \
+    X(VCVTTPD2DQ, "vcvttpd2dq") \
+    X(VCVTTPD2QQ, "vcvttpd2qq") \
+    X(VCVTTPD2UDQ, "vcvttpd2udq") \
+    X(VCVTTPD2UQQ, "vcvttpd2uqq") \
+    X(VCVTTPS2DQ, "vcvttps2dq") \
+    X(VCVTTPS2QQ, "vcvttps2qq") \
+    X(VCVTTPS2UDQ, "vcvttps2udq") \
+    X(VCVTTPS2UQQ, "vcvttps2uqq") \
+    X(VCVTTSD2SI, "vcvttsd2si") \
+    X(VCVTTSD2USI, "vcvttsd2usi") \
+    X(VCVTTSS2SI, "vcvttss2si") \
+    X(VCVTTSS2USI, "vcvttss2usi") \
+    X(VCVTUDQ2PD, "vcvtudq2pd") \
+    X(VCVTUDQ2PS, "vcvtudq2ps") \
+    X(VCVTUQQ2PD, "vcvtuqq2pd") \
+    X(VCVTUQQ2PS, "vcvtuqq2ps") \
+    X(VCVTUSI2SD, "vcvtusi2sd") \
+    X(VCVTUSI2SS, "vcvtusi2ss") \
+    X(VDBPSADBW, "vdbpsadbw") \
+    X(VDIVPD, "vdivpd") \
+    X(VDIVPS, "vdivps") \
+    X(VDIVSD, "vdivsd") \
+    X(VDIVSS, "vdivss") \
+    X(VDPPD, "vdppd") \
+    X(VDPPS, "vdpps") \
+    X(VEXP2PD, "vexp2pd") \
+    X(VEXP2PS, "vexp2ps") \
+    X(VEXPANDPD, "vexpandpd") \
+    X(VEXPANDPS, "vexpandps") \
+    X(VEXTRACTF128, "vextractf128") \
+    X(VEXTRACTF32X4, "vextractf32x4") \
+    X(VEXTRACTF32X8, "vextractf32x8") \
+    X(VEXTRACTF64X2, "vextractf64x2") \
+    X(VEXTRACTF64X4, "vextractf64x4") \
+    X(VEXTRACTI128, "vextracti128") \
+    X(VEXTRACTI32X4, "vextracti32x4") \
+    X(VEXTRACTI32X8, "vextracti32x8") \
+    X(VEXTRACTI64X2, "vextracti64x2") \
+    X(VEXTRACTI64X4, "vextracti64x4") \
+    X(VEXTRACTPS, "vextractps") \
+    X(VFIXUPIMMPD, "vfixupimmpd") \
+    X(VFIXUPIMMPS, "vfixupimmps") \
+    X(VFIXUPIMMSD, "vfixupimmsd") \
+    X(VFIXUPIMMSS, "vfixupimmss") \
+    X(VFMADD132PD, "vfmadd132pd") \
+    X(VFMADD132PS, "vfmadd132ps") \
+    X(VFMADD132SD, "vfmadd132sd") \
+    X(VFMADD132SS, "vfmadd132ss") \
+    X(VFMADD213PD, "vfmadd213pd") \
+    X(VFMADD213PS, "vfmadd213ps") \
+    X(VFMADD213SD, "vfmadd213sd") \
+    X(VFMADD213SS, "vfmadd213ss") \
+    X(VFMADD231PD, "vfmadd231pd") \
+    X(VFMADD231PS, "vfmadd231ps") \
+    X(VFMADD231SD, "vfmadd231sd") \
+    X(VFMADD231SS, "vfmadd231ss") \
+    X(VFMADDPD, "vfmaddpd") \
+    X(VFMADDPS, "vfmaddps") \
+    X(VFMADDSD, "vfmaddsd") \
+    X(VFMADDSS, "vfmaddss") \
+    X(VFMADDSUB132PD, "vfmaddsub132pd") \
+    X(VFMADDSUB132PS, "vfmaddsub132ps") \
+    X(VFMADDSUB213PD, "vfmaddsub213pd") \
+    X(VFMADDSUB213PS, "vfmaddsub213ps") \
+    X(VFMADDSUB231PD, "vfmaddsub231pd") \
+    X(VFMADDSUB231PS, "vfmaddsub231ps") \
+    X(VFMADDSUBPD, "vfmaddsubpd") \
+    X(VFMADDSUBPS, "vfmaddsubps") \
+    X(VFMSUB132PD, "vfmsub132pd") \
+    X(VFMSUB132PS, "vfmsub132ps") \
+    X(VFMSUB132SD, "vfmsub132sd") \
+    X(VFMSUB132SS, "vfmsub132ss") \
+    X(VFMSUB213PD, "vfmsub213pd") \
+    X(VFMSUB213PS, "vfmsub213ps") \
+    X(VFMSUB213SD, "vfmsub213sd") \
+    X(VFMSUB213SS, "vfmsub213ss") \
+    X(VFMSUB231PD, "vfmsub231pd") \
+    X(VFMSUB231PS, "vfmsub231ps") \
+    X(VFMSUB231SD, "vfmsub231sd") \
+    X(VFMSUB231SS, "vfmsub231ss") \
+    X(VFMSUBADD132PD, "vfmsubadd132pd") \
+    X(VFMSUBADD132PS, "vfmsubadd132ps") \
+    X(VFMSUBADD213PD, "vfmsubadd213pd") \
+    X(VFMSUBADD213PS, "vfmsubadd213ps") \
+    X(VFMSUBADD231PD, "vfmsubadd231pd") \
+    X(VFMSUBADD231PS, "vfmsubadd231ps") \
+    X(VFMSUBADDPD, "vfmsubaddpd") \
+    X(VFMSUBADDPS, "vfmsubaddps") \
+    X(VFMSUBPD, "vfmsubpd") \
+    X(VFMSUBPS, "vfmsubps") \
+    X(VFMSUBSD, "vfmsubsd") \
+    X(VFMSUBSS, "vfmsubss") \
+    X(VFNMADD132PD, "vfnmadd132pd") \
+    X(VFNMADD132PS, "vfnmadd132ps") \
+    X(VFNMADD132SD, "vfnmadd132sd") \
+    X(VFNMADD132SS, "vfnmadd132ss") \
+    X(VFNMADD213PD, "vfnmadd213pd") \
+    X(VFNMADD213PS, "vfnmadd213ps") \
+    X(VFNMADD213SD, "vfnmadd213sd") \
+    X(VFNMADD213SS, "vfnmadd213ss") \
+    X(VFNMADD231PD, "vfnmadd231pd") \
+    X(VFNMADD231PS, "vfnmadd231ps") \
+    X(VFNMADD231SD, "vfnmadd231sd") \
+    X(VFNMADD231SS, "vfnmadd231ss") \
+    X(VFNMADDPD, "vfnmaddpd") \
+    X(VFNMADDPS, "vfnmaddps") \
+    X(VFNMADDSD, "vfnmaddsd") \
+    X(VFNMADDSS, "vfnmaddss") \
+    X(VFNMSUB132PD, "vfnmsub132pd") \
+    X(VFNMSUB132PS, "vfnmsub132ps") \
+    X(VFNMSUB132SD, "vfnmsub132sd") \
+    X(VFNMSUB132SS, "vfnmsub132ss") \
+    X(VFNMSUB213PD, "vfnmsub213pd") \
+    X(VFNMSUB213PS, "vfnmsub213ps") \
+    X(VFNMSUB213SD, "vfnmsub213sd") \
+    X(VFNMSUB213SS, "vfnmsub213ss") \
+    X(VFNMSUB231PD, "vfnmsub231pd") \
+    X(VFNMSUB231PS, "vfnmsub231ps") \
+    X(VFNMSUB231SD, "vfnmsub231sd") \
+    X(VFNMSUB231SS, "vfnmsub231ss") \
+    X(VFNMSUBPD, "vfnmsubpd") \
+    X(VFNMSUBPS, "vfnmsubps") \
+    X(VFNMSUBSD, "vfnmsubsd") \
+    X(VFNMSUBSS, "vfnmsubss") \
+    X(VFPCLASSPD, "vfpclasspd") \
+    X(VFPCLASSPS, "vfpclassps") \
+    X(VFPCLASSSD, "vfpclasssd") \
+    X(VFPCLASSSS, "vfpclassss") \
+    X(VFRCZPD, "vfrczpd") \
+    X(VFRCZPS, "vfrczps") \
+    X(VFRCZSD, "vfrczsd") \
+    X(VFRCZSS, "vfrczss") \
+    X(VGATHERDPD, "vgatherdpd") \
+    X(VGATHERDPS, "vgatherdps") \
+    X(VGATHERPF0DPD, "vgatherpf0dpd") \
+    X(VGATHERPF0DPS, "vgatherpf0dps") \
+    X(VGATHERPF0QPD, "vgatherpf0qpd") \
+    X(VGATHERPF0QPS, "vgatherpf0qps") \
+    X(VGATHERPF1DPD, "vgatherpf1dpd") \
+    X(VGATHERPF1DPS, "vgatherpf1dps") \
+    X(VGATHERPF1QPD, "vgatherpf1qpd") \
+    X(VGATHERPF1QPS, "vgatherpf1qps") \
+    X(VGATHERQPD, "vgatherqpd") \
+    X(VGATHERQPS, "vgatherqps") \
+    X(VGETEXPPD, "vgetexppd") \
+    X(VGETEXPPS, "vgetexpps") \
+    X(VGETEXPSD, "vgetexpsd") \
+    X(VGETEXPSS, "vgetexpss") \
+    X(VGETMANTPD, "vgetmantpd") \
+    X(VGETMANTPS, "vgetmantps") \
+    X(VGETMANTSD, "vgetmantsd") \
+    X(VGETMANTSS, "vgetmantss") \
+    X(VHADDPD, "vhaddpd") \
+    X(VHADDPS, "vhaddps") \
+    X(VHSUBPD, "vhsubpd") \
+    X(VHSUBPS, "vhsubps") \
+    X(VINSERTF128, "vinsertf128") \
+    X(VINSERTF32X4, "vinsertf32x4") \
+    X(VINSERTF32X8, "vinsertf32x8") \
+    X(VINSERTF64X2, "vinsertf64x2") \
+    X(VINSERTF64X4, "vinsertf64x4") \
+    X(VINSERTI128, "vinserti128") \
+    X(VINSERTI32X4, "vinserti32x4") \
+    X(VINSERTI32X8, "vinserti32x8") \
+    X(VINSERTI64X2, "vinserti64x2") \
+    X(VINSERTI64X4, "vinserti64x4") \
+    X(VINSERTPS, "vinsertps") \
+    X(VLDDQU, "vlddqu") \
+    X(VLDMXCSR, "vldmxcsr") \
+    X(VMASKMOVDQU, "vmaskmovdqu") \
+    X(VMASKMOVPD, "vmaskmovpd") \
+    X(VMASKMOVPS, "vmaskmovps") \
+    X(VMAXPD, "vmaxpd") \
+    X(VMAXPS, "vmaxps") \
+    X(VMAXSD, "vmaxsd") \
+    X(VMAXSS, "vmaxss") \
+    X(VMINPD, "vminpd") \
+    X(VMINPS, "vminps") \
+    X(VMINSD, "vminsd") \
+    X(VMINSS, "vminss") \
+    X(VMOVAPD, "vmovapd") \
+    X(VMOVAPS, "vmovaps") \
+    X(VMOVD, "vmovd") \
+    X(VMOVDDUP, "vmovddup") \
+    X(VMOVDQA, "vmovdqa") \
+    X(VMOVDQA32, "vmovdqa32") \
+    X(VMOVDQA64, "vmovdqa64") \
+    X(VMOVDQU, "vmovdqu") \
+    X(VMOVDQU16, "vmovdqu16") \
+    X(VMOVDQU32, "vmovdqu32") \
+    X(VMOVDQU64, "vmovdqu64") \
+    X(VMOVDQU8, "vmovdqu8") \
+    X(VMOVHLPS, "vmovhlps") \
+    X(VMOVHPD, "vmovhpd") \
+    X(VMOVHPS, "vmovhps") \
+    X(VMOVLHPS, "vmovlhps") \
+    X(VMOVLPD, "vmovlpd") \
+    X(VMOVLPS, "vmovlps") \
+    X(VMOVMSKPD, "vmovmskpd") \
+    X(VMOVMSKPS, "vmovmskps") \
+    X(VMOVNTDQ, "vmovntdq") \
+    X(VMOVNTDQA, "vmovntdqa") \
+    X(VMOVNTPD, "vmovntpd") \
+    X(VMOVNTPS, "vmovntps") \
+    X(VMOVQ, "vmovq") \
+    X(VMOVSD, "vmovsd") \
+    X(VMOVSHDUP, "vmovshdup") \
+    X(VMOVSLDUP, "vmovsldup") \
+    X(VMOVSS, "vmovss") \
+    X(VMOVUPD, "vmovupd") \
+    X(VMOVUPS, "vmovups") \
+    X(VMPSADBW, "vmpsadbw") \
+    X(VMULPD, "vmulpd") \
+    X(VMULPS, "vmulps") \
+    X(VMULSD, "vmulsd") \
+    X(VMULSS, "vmulss") \
+    X(VORPD, "vorpd") \
+    X(VORPS, "vorps") \
+    X(VPABSB, "vpabsb") \
+    X(VPABSD, "vpabsd") \
+    X(VPABSQ, "vpabsq") \
+    X(VPABSW, "vpabsw") \
+    X(VPACKSSDW, "vpackssdw") \
+    X(VPACKSSWB, "vpacksswb") \
+    X(VPACKUSDW, "vpackusdw") \
+    X(VPACKUSWB, "vpackuswb") \
+    X(VPADDB, "vpaddb") \
+    X(VPADDD, "vpaddd") \
+    X(VPADDQ, "vpaddq") \
+    X(VPADDSB, "vpaddsb") \
+    X(VPADDSW, "vpaddsw") \
+    X(VPADDUSB, "vpaddusb") \
+    X(VPADDUSW, "vpaddusw") \
+    X(VPADDW, "vpaddw") \
+    X(VPALIGNR, "vpalignr") \
+    X(VPAND, "vpand") \
+    X(VPANDD, "vpandd") \
+    X(VPANDN, "vpandn") \
+    X(VPANDND, "vpandnd") \
+    X(VPANDNQ, "vpandnq") \
+    X(VPANDQ, "vpandq") \
+    X(VPAVGB, "vpavgb") \
+    X(VPAVGW, "vpavgw") \
+    X(VPBLENDD, "vpblendd") \
+    X(VPBLENDMB, "vpblendmb") \
+    X(VPBLENDMD, "vpblendmd") \
+    X(VPBLENDMQ, "vpblendmq") \
+    X(VPBLENDMW, "vpblendmw") \
+    X(VPBLENDVB, "vpblendvb") \
+    X(VPBLENDW, "vpblendw") \
+    X(VPBROADCASTB, "vpbroadcastb") \
+    X(VPBROADCASTD, "vpbroadcastd") \
+    X(VPBROADCASTMB2Q, "vpbroadcastmb2q") \
+    X(VPBROADCASTMW2D, "vpbroadcastmw2d") \
+    X(VPBROADCASTQ, "vpbroadcastq") \
+    X(VPBROADCASTW, "vpbroadcastw") \
+    X(VPCLMULQDQ, "vpclmulqdq") \
+    X(VPCMOV, "vpcmov") \
+    X(VPCMPB, "vpcmpb") \
+    X(VPCMPD, "vpcmpd") \
+    X(VPCMPEQB, "vpcmpeqb") \
+    X(VPCMPEQD, "vpcmpeqd") \
+    X(VPCMPEQQ, "vpcmpeqq") \
+    X(VPCMPEQW, "vpcmpeqw") \
+    X(VPCMPESTRI, "vpcmpestri") \
+    X(VPCMPESTRM, "vpcmpestrm") \
+    X(VPCMPGTB, "vpcmpgtb") \
+    X(VPCMPGTD, "vpcmpgtd") \
+    X(VPCMPGTQ, "vpcmpgtq") \
+    X(VPCMPGTW, "vpcmpgtw") \
+    X(VPCMPISTRI, "vpcmpistri") \
+    X(VPCMPISTRM, "vpcmpistrm") \
+    X(VPCMPQ, "vpcmpq") \
+    X(VPCMPUB, "vpcmpub") \
+    X(VPCMPUD, "vpcmpud") \
+    X(VPCMPUQ, "vpcmpuq") \
+    X(VPCMPUW, "vpcmpuw") \
+    X(VPCMPW, "vpcmpw") \
+    X(VPCOMB, "vpcomb") \
+    X(VPCOMD, "vpcomd") \
+    X(VPCOMPRESSD, "vpcompressd") \
+    X(VPCOMPRESSQ, "vpcompressq") \
+    X(VPCOMQ, "vpcomq") \
+    X(VPCOMUB, "vpcomub") \
+    X(VPCOMUD, "vpcomud") \
+    X(VPCOMUQ, "vpcomuq") \
+    X(VPCOMUW, "vpcomuw") \
+    X(VPCOMW, "vpcomw") \
+    X(VPCONFLICTD, "vpconflictd") \
+    X(VPCONFLICTQ, "vpconflictq") \
+    X(VPERM2F128, "vperm2f128") \
+    X(VPERM2I128, "vperm2i128") \
+    X(VPERMB, "vpermb") \
+    X(VPERMD, "vpermd") \
+    X(VPERMI2B, "vpermi2b") \
+    X(VPERMI2D, "vpermi2d") \
+    X(VPERMI2PD, "vpermi2pd") \
+    X(VPERMI2PS, "vpermi2ps") \
+    X(VPERMI2Q, "vpermi2q") \
+    X(VPERMI2W, "vpermi2w") \
+    X(VPERMILPD, "vpermilpd") \
+    X(VPERMILPS, "vpermilps") \
+    X(VPERMPD, "vpermpd") \
+    X(VPERMPS, "vpermps") \
+    X(VPERMQ, "vpermq") \
+    X(VPERMT2B, "vpermt2b") \
+    X(VPERMT2D, "vpermt2d") \
+    X(VPERMT2PD, "vpermt2pd") \
+    X(VPERMT2PS, "vpermt2ps") \
+    X(VPERMT2Q, "vpermt2q") \
+    X(VPERMT2W, "vpermt2w") \
+    X(VPERMW, "vpermw") \
+    X(VPEXPANDD, "vpexpandd") \
+    X(VPEXPANDQ, "vpexpandq") \
+    X(VPEXTRB, "vpextrb") \
+    X(VPEXTRD, "vpextrd") \
+    X(VPEXTRQ, "vpextrq") \
+    X(VPEXTRW, "vpextrw") \
+    X(VPGATHERDD, "vpgatherdd") \
+    X(VPGATHERDQ, "vpgatherdq") \
+    X(VPGATHERQD, "vpgatherqd") \
+    X(VPGATHERQQ, "vpgatherqq") \
+    X(VPHADDBD, "vphaddbd") \
+    X(VPHADDBQ, "vphaddbq") \
+    X(VPHADDBW, "vphaddbw") \
+    X(VPHADDD, "vphaddd") \
+    X(VPHADDDQ, "vphadddq") \
+    X(VPHADDSW, "vphaddsw") \
+    X(VPHADDUBD, "vphaddubd") \
+    X(VPHADDUBQ, "vphaddubq") \
+    X(VPHADDUBW, "vphaddubw") \
+    X(VPHADDUDQ, "vphaddudq") \
+    X(VPHADDUWD, "vphadduwd") \
+    X(VPHADDUWQ, "vphadduwq") \
+    X(VPHADDW, "vphaddw") \
+    X(VPHADDWD, "vphaddwd") \
+    X(VPHADDWQ, "vphaddwq") \
+    X(VPHMINPOSUW, "vphminposuw") \
+    X(VPHSUBBW, "vphsubbw") \
+    X(VPHSUBD, "vphsubd") \
+    X(VPHSUBDQ, "vphsubdq") \
+    X(VPHSUBSW, "vphsubsw") \
+    X(VPHSUBW, "vphsubw") \
+    X(VPHSUBWD, "vphsubwd") \
+    X(VPINSRB, "vpinsrb") \
+    X(VPINSRD, "vpinsrd") \
+    X(VPINSRQ, "vpinsrq") \
+    X(VPINSRW, "vpinsrw") \
+    X(VPLZCNTD, "vplzcntd") \
+    X(VPLZCNTQ, "vplzcntq") \
+    X(VPMACSDD, "vpmacsdd") \
+    X(VPMACSDQH, "vpmacsdqh") \
+    X(VPMACSDQL, "vpmacsdql") \
+    X(VPMACSSDD, "vpmacssdd") \
+    X(VPMACSSDQH, "vpmacssdqh") \
+    X(VPMACSSDQL, "vpmacssdql") \
+    X(VPMACSSWD, "vpmacsswd") \
+    X(VPMACSSWW, "vpmacssww") \
+    X(VPMACSWD, "vpmacswd") \
+    X(VPMACSWW, "vpmacsww") \
+    X(VPMADCSSWD, "vpmadcsswd") \
+    X(VPMADCSWD, "vpmadcswd") \
+    X(VPMADD52HUQ, "vpmadd52huq") \
+    X(VPMADD52LUQ, "vpmadd52luq") \
+    X(VPMADDUBSW, "vpmaddubsw") \
+    X(VPMADDWD, "vpmaddwd") \
+    X(VPMASKMOVD, "vpmaskmovd") \
+    X(VPMASKMOVQ, "vpmaskmovq") \
+    X(VPMAXSB, "vpmaxsb") \
+    X(VPMAXSD, "vpmaxsd") \
+    X(VPMAXSQ, "vpmaxsq") \
+    X(VPMAXSW, "vpmaxsw") \
+    X(VPMAXUB, "vpmaxub") \
+    X(VPMAXUD, "vpmaxud") \
+    X(VPMAXUQ, "vpmaxuq") \
+    X(VPMAXUW, "vpmaxuw") \
+    X(VPMINSB, "vpminsb") \
+    X(VPMINSD, "vpminsd") \
+    X(VPMINSQ, "vpminsq") \
+    X(VPMINSW, "vpminsw") \
+    X(VPMINUB, "vpminub") \
+    X(VPMINUD, "vpminud") \
+    X(VPMINUQ, "vpminuq") \
+    X(VPMINUW, "vpminuw") \
+    X(VPMOVB2M, "vpmovb2m") \
+    X(VPMOVD2M, "vpmovd2m") \
+    X(VPMOVDB, "vpmovdb") \
+    X(VPMOVDW, "vpmovdw") \
+    X(VPMOVM2B, "vpmovm2b") \
+    X(VPMOVM2D, "vpmovm2d") \
+    X(VPMOVM2Q, "vpmovm2q") \
+    X(VPMOVM2W, "vpmovm2w") \
+    X(VPMOVMSKB, "vpmovmskb") \
+    X(VPMOVQ2M, "vpmovq2m") \
+    X(VPMOVQB, "vpmovqb") \
+    X(VPMOVQD, "vpmovqd") \
+    X(VPMOVQW, "vpmovqw") \
+    X(VPMOVSDB, "vpmovsdb") \
+    X(VPMOVSDW, "vpmovsdw") \
+    X(VPMOVSQB, "vpmovsqb") \
+    X(VPMOVSQD, "vpmovsqd") \
+    X(VPMOVSQW, "vpmovsqw") \
+    X(VPMOVSWB, "vpmovswb") \
+    X(VPMOVSXBD, "vpmovsxbd") \
+    X(VPMOVSXBQ, "vpmovsxbq") \
+    X(VPMOVSXBW, "vpmovsxbw") \
+    X(VPMOVSXDQ, "vpmovsxdq") \
+    X(VPMOVSXWD, "vpmovsxwd") \
+    X(VPMOVSXWQ, "vpmovsxwq") \
+    X(VPMOVUSDB, "vpmovusdb") \
+    X(VPMOVUSDW, "vpmovusdw") \
+    X(VPMOVUSQB, "vpmovusqb") \
+    X(VPMOVUSQD, "vpmovusqd") \
+    X(VPMOVUSQW, "vpmovusqw") \
+    X(VPMOVUSWB, "vpmovuswb") \
+    X(VPMOVW2M, "vpmovw2m") \
+    X(VPMOVWB, "vpmovwb") \
+    X(VPMOVZXBD, "vpmovzxbd") \
+    X(VPMOVZXBQ, "vpmovzxbq") \
+    X(VPMOVZXBW, "vpmovzxbw") \
+    X(VPMOVZXDQ, "vpmovzxdq") \
+    X(VPMOVZXWD, "vpmovzxwd") \
+    X(VPMOVZXWQ, "vpmovzxwq") \
+    X(VPMULDQ, "vpmuldq") \
+    X(VPMULHRSW, "vpmulhrsw") \
+    X(VPMULHUW, "vpmulhuw") \
+    X(VPMULHW, "vpmulhw") \
+    X(VPMULLD, "vpmulld") \
+    X(VPMULLQ, "vpmullq") \
+    X(VPMULLW, "vpmullw") \
+    X(VPMULTISHIFTQB, "vpmultishiftqb") \
+    X(VPMULUDQ, "vpmuludq") \
+    X(VPOPCNTD, "vpopcntd") \
+    X(VPOPCNTQ, "vpopcntq") \
+    X(VPOR, "vpor") \
+    X(VPORD, "vpord") \
+    X(VPORQ, "vporq") \
+    X(VPPERM, "vpperm") \
+    X(VPROLD, "vprold") \
+    X(VPROLQ, "vprolq") \
+    X(VPROLVD, "vprolvd") \
+    X(VPROLVQ, "vprolvq") \
+    X(VPRORD, "vprord") \
+    X(VPRORQ, "vprorq") \
+    X(VPRORVD, "vprorvd") \
+    X(VPRORVQ, "vprorvq") \
+    X(VPROTB, "vprotb") \
+    X(VPROTD, "vprotd") \
+    X(VPROTQ, "vprotq") \
+    X(VPROTW, "vprotw") \
+    X(VPSADBW, "vpsadbw") \
+    X(VPSCATTERDD, "vpscatterdd") \
+    X(VPSCATTERDQ, "vpscatterdq") \
+    X(VPSCATTERQD, "vpscatterqd") \
+    X(VPSCATTERQQ, "vpscatterqq") \
+    X(VPSHAB, "vpshab") \
+    X(VPSHAD, "vpshad") \
+    X(VPSHAQ, "vpshaq") \
+    X(VPSHAW, "vpshaw") \
+    X(VPSHLB, "vpshlb") \
+    X(VPSHLD, "vpshld") \
+    X(VPSHLQ, "vpshlq") \
+    X(VPSHLW, "vpshlw") \
+    X(VPSHUFB, "vpshufb") \
+    X(VPSHUFD, "vpshufd") \
+    X(VPSHUFHW, "vpshufhw") \
+    X(VPSHUFLW, "vpshuflw") \
+    X(VPSIGNB, "vpsignb") \
+    X(VPSIGND, "vpsignd") \
+    X(VPSIGNW, "vpsignw") \
+    X(VPSLLD, "vpslld") \
+    X(VPSLLDQ, "vpslldq") \
+    X(VPSLLQ, "vpsllq") \
+    X(VPSLLVD, "vpsllvd") \
+    X(VPSLLVQ, "vpsllvq") \
+    X(VPSLLVW, "vpsllvw") \
+    X(VPSLLW, "vpsllw") \
+    X(VPSRAD, "vpsrad") \
+    X(VPSRAQ, "vpsraq") \
+    X(VPSRAVD, "vpsravd") \
+    X(VPSRAVQ, "vpsravq") \
+    X(VPSRAVW, "vpsravw") \
+    X(VPSRAW, "vpsraw") \
+    X(VPSRLD, "vpsrld") \
+    X(VPSRLDQ, "vpsrldq") \
+    X(VPSRLQ, "vpsrlq") \
+    X(VPSRLVD, "vpsrlvd") \
+    X(VPSRLVQ, "vpsrlvq") \
+    X(VPSRLVW, "vpsrlvw") \
+    X(VPSRLW, "vpsrlw") \
+    X(VPSUBB, "vpsubb") \
+    X(VPSUBD, "vpsubd") \
+    X(VPSUBQ, "vpsubq") \
+    X(VPSUBSB, "vpsubsb") \
+    X(VPSUBSW, "vpsubsw") \
+    X(VPSUBUSB, "vpsubusb") \
+    X(VPSUBUSW, "vpsubusw") \
+    X(VPSUBW, "vpsubw") \
+    X(VPTERNLOGD, "vpternlogd") \
+    X(VPTERNLOGQ, "vpternlogq") \
+    X(VPTEST, "vptest") \
+    X(VPTESTMB, "vptestmb") \
+    X(VPTESTMD, "vptestmd") \
+    X(VPTESTMQ, "vptestmq") \
+    X(VPTESTMW, "vptestmw") \
+    X(VPTESTNMB, "vptestnmb") \
+    X(VPTESTNMD, "vptestnmd") \
+    X(VPTESTNMQ, "vptestnmq") \
+    X(VPTESTNMW, "vptestnmw") \
+    X(VPUNPCKHBW, "vpunpckhbw") \
+    X(VPUNPCKHDQ, "vpunpckhdq") \
+    X(VPUNPCKHQDQ, "vpunpckhqdq") \
+    X(VPUNPCKHWD, "vpunpckhwd") \
+    X(VPUNPCKLBW, "vpunpcklbw") \
+    X(VPUNPCKLDQ, "vpunpckldq") \
+    X(VPUNPCKLQDQ, "vpunpcklqdq") \
+    X(VPUNPCKLWD, "vpunpcklwd") \
+    X(VPXOR, "vpxor") \
+    X(VPXORD, "vpxord") \
+    X(VPXORQ, "vpxorq") \
+    X(VRANGEPD, "vrangepd") \
+    X(VRANGEPS, "vrangeps") \
+    X(VRANGESD, "vrangesd") \
+    X(VRANGESS, "vrangess") \
+    X(VRCP14PD, "vrcp14pd") \
+    X(VRCP14PS, "vrcp14ps") \
+    X(VRCP14SD, "vrcp14sd") \
+    X(VRCP14SS, "vrcp14ss") \
+    X(VRCP28PD, "vrcp28pd") \
+    X(VRCP28PS, "vrcp28ps") \
+    X(VRCP28SD, "vrcp28sd") \
+    X(VRCP28SS, "vrcp28ss") \
+    X(VRCPPS, "vrcpps") \
+    X(VRCPSS, "vrcpss") \
+    X(VREDUCEPD, "vreducepd") \
+    X(VREDUCEPS, "vreduceps") \
+    X(VREDUCESD, "vreducesd") \
+    X(VREDUCESS, "vreducess") \
+    X(VRNDSCALEPD, "vrndscalepd") \
+    X(VRNDSCALEPS, "vrndscaleps") \
+    X(VRNDSCALESD, "vrndscalesd") \
+    X(VRNDSCALESS, "vrndscaless") \
+    X(VROUNDPD, "vroundpd") \
+    X(VROUNDPS, "vroundps") \
+    X(VROUNDSD, "vroundsd") \
+    X(VROUNDSS, "vroundss") \
+    X(VRSQRT14PD, "vrsqrt14pd") \
+    X(VRSQRT14PS, "vrsqrt14ps") \
+    X(VRSQRT14SD, "vrsqrt14sd") \
+    X(VRSQRT14SS, "vrsqrt14ss") \
+    X(VRSQRT28PD, "vrsqrt28pd") \
+    X(VRSQRT28PS, "vrsqrt28ps") \
+    X(VRSQRT28SD, "vrsqrt28sd") \
+    X(VRSQRT28SS, "vrsqrt28ss") \
+    X(VRSQRTPS, "vrsqrtps") \
+    X(VRSQRTSS, "vrsqrtss") \
+    X(VSCALEFPD, "vscalefpd") \
+    X(VSCALEFPS, "vscalefps") \
+    X(VSCALEFSD, "vscalefsd") \
+    X(VSCALEFSS, "vscalefss") \
+    X(VSCATTERDPD, "vscatterdpd") \
+    X(VSCATTERDPS, "vscatterdps") \
+    X(VSCATTERPF0DPD, "vscatterpf0dpd") \
+    X(VSCATTERPF0DPS, "vscatterpf0dps") \
+    X(VSCATTERPF0QPD, "vscatterpf0qpd") \
+    X(VSCATTERPF0QPS, "vscatterpf0qps") \
+    X(VSCATTERPF1DPD, "vscatterpf1dpd") \
+    X(VSCATTERPF1DPS, "vscatterpf1dps") \
+    X(VSCATTERPF1QPD, "vscatterpf1qpd") \
+    X(VSCATTERPF1QPS, "vscatterpf1qps") \
+    X(VSCATTERQPD, "vscatterqpd") \
+    X(VSCATTERQPS, "vscatterqps") \
+    X(VSHUFF32X4, "vshuff32x4") \
+    X(VSHUFF64X2, "vshuff64x2") \
+    X(VSHUFI32X4, "vshufi32x4") \
+    X(VSHUFI64X2, "vshufi64x2") \
+    X(VSHUFPD, "vshufpd") \
+    X(VSHUFPS, "vshufps") \
+    X(VSQRTPD, "vsqrtpd") \
+    X(VSQRTPS, "vsqrtps") \
+    X(VSQRTSD, "vsqrtsd") \
+    X(VSQRTSS, "vsqrtss") \
+    X(VSTMXCSR, "vstmxcsr") \
+    X(VSUBPD, "vsubpd") \
+    X(VSUBPS, "vsubps") \
+    X(VSUBSD, "vsubsd") \
+    X(VSUBSS, "vsubss") \
+    X(VTESTPD, "vtestpd") \
+    X(VTESTPS, "vtestps") \
+    X(VUCOMISD, "vucomisd") \
+    X(VUCOMISS, "vucomiss") \
+    X(VUNPCKHPD, "vunpckhpd") \
+    X(VUNPCKHPS, "vunpckhps") \
+    X(VUNPCKLPD, "vunpcklpd") \
+    X(VUNPCKLPS, "vunpcklps") \
+    X(VXORPD, "vxorpd") \
+    X(VXORPS, "vxorps") \
+    X(VZEROALL, "vzeroall") \
+    X(VZEROUPPER, "vzeroupper") \
+    X(XADD, "xadd") \
+    X(XCHG, "xchg") \
+    X(XGETBV, "xgetbv") \
+    X(XLATB, "xlatb") \
+    X(XOR, "xor") \
+    X(XORPD, "xorpd") \
+    X(XORPS, "xorps") \
+
+#endif /* !defined(__SPASM_X86_64_MNEMONICS) */
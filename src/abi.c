@@ -59,7 +59,7 @@ size_t get_max_available_gp_registers(SpasmABI abi)
     {
 #if defined(SPASM_ENABLE_X86_64)
         case SpasmABI_WindowsX64: return 4; /* RCX, RDX, R8, R9 */
-        case SpasmABI_LinuxX64: return 6; /* RSI, RDI, RCX, RDX, R8, R9 */
+        case SpasmABI_LinuxX64: return 6; /* RDI, RSI, RDX, RCX, R8, R9 */
 #endif /* defined(SPASM_ENABLE_X86_64) */
 
         /* TODO: apple */
@@ -119,7 +119,7 @@ size_t get_call_max_args_gp_registers(SpasmABI abi)
     {
 #if defined(SPASM_ENABLE_X86_64)
         case SpasmABI_WindowsX64: return 4; /* RCX, RDX, R8, R9 */
-        case SpasmABI_LinuxX64: return 6; /* RSI, RDI, RCX, RDX, R8, R9 */
+        case SpasmABI_LinuxX64: return 6; /* RDI, RSI, RDX, RCX, R8, R9 */
 #endif /* defined(SPASM_ENABLE_X86_64) */
 
         /* TODO: apple */
@@ -133,7 +133,7 @@ size_t get_call_max_args_fp_registers(SpasmABI abi)
     switch(abi)
     {
 #if defined(SPASM_ENABLE_X86_64)
-        case SpasmABI_WindowsX64: return 5; /* XMM0-XMM4 */
+        case SpasmABI_WindowsX64: return 4; /* XMM0-XMM3, in the slots of RCX, RDX, R8, R9 */
         case SpasmABI_LinuxX64: return 8; /* XMM0-XMM7 */
 #endif /* defined(SPASM_ENABLE_X86_64) */
 
@@ -164,10 +164,10 @@ const SpasmRegister* get_call_args_gp_registers(SpasmABI abi, size_t* num_regist
         case SpasmABI_LinuxX64:
         {
             static SpasmRegister regs[6] = {
-                SpasmRegister_x86_64_RSI,
                 SpasmRegister_x86_64_RDI,
-                SpasmRegister_x86_64_RCX,
+                SpasmRegister_x86_64_RSI,
                 SpasmRegister_x86_64_RDX,
+                SpasmRegister_x86_64_RCX,
                 SpasmRegister_x86_64_R8,
                 SpasmRegister_x86_64_R9,
             };
@@ -228,3 +228,88 @@ const SpasmRegister* get_call_args_fp_registers(SpasmABI abi, size_t* num_regist
         default: return 0;
     }
 }
+
+const SpasmRegister* get_callee_saved_gp_registers(SpasmABI abi, size_t* num_registers)
+{
+    switch(abi)
+    {
+#if defined(SPASM_ENABLE_X86_64)
+        case SpasmABI_WindowsX64:
+        {
+            static const SpasmRegister regs[8] = {
+                SpasmRegister_x86_64_RBX,
+                SpasmRegister_x86_64_RBP,
+                SpasmRegister_x86_64_RDI,
+                SpasmRegister_x86_64_RSI,
+                SpasmRegister_x86_64_R12,
+                SpasmRegister_x86_64_R13,
+                SpasmRegister_x86_64_R14,
+                SpasmRegister_x86_64_R15,
+            };
+
+            *num_registers = 8;
+
+            return regs;
+        }
+        case SpasmABI_LinuxX64:
+        {
+            static const SpasmRegister regs[6] = {
+                SpasmRegister_x86_64_RBX,
+                SpasmRegister_x86_64_RBP,
+                SpasmRegister_x86_64_R12,
+                SpasmRegister_x86_64_R13,
+                SpasmRegister_x86_64_R14,
+                SpasmRegister_x86_64_R15,
+            };
+
+            *num_registers = 6;
+
+            return regs;
+        }
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+        /* TODO: apple */
+
+        default: return 0;
+    }
+}
+
+const SpasmRegister* get_callee_saved_fp_registers(SpasmABI abi, size_t* num_registers)
+{
+    switch(abi)
+    {
+#if defined(SPASM_ENABLE_X86_64)
+        case SpasmABI_WindowsX64:
+        {
+            static const SpasmRegister regs[10] = {
+                SpasmRegister_x86_64_XMM6,
+                SpasmRegister_x86_64_XMM7,
+                SpasmRegister_x86_64_XMM8,
+                SpasmRegister_x86_64_XMM9,
+                SpasmRegister_x86_64_XMM10,
+                SpasmRegister_x86_64_XMM11,
+                SpasmRegister_x86_64_XMM12,
+                SpasmRegister_x86_64_XMM13,
+                SpasmRegister_x86_64_XMM14,
+                SpasmRegister_x86_64_XMM15,
+            };
+
+            *num_registers = 10;
+
+            return regs;
+        }
+        case SpasmABI_LinuxX64:
+        {
+            static const SpasmRegister regs[1] = { 0 };
+
+            *num_registers = 0;
+
+            return regs;
+        }
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+        /* TODO: apple */
+
+        default: return 0;
+    }
+}
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Default allocator */
+
+static void* spasm_default_alloc(size_t size, void* user_data)
+{
+    SPASM_UNUSED(user_data);
+
+    return malloc(size);
+}
+
+static void* spasm_default_realloc(void* ptr, size_t old_size, size_t new_size, void* user_data)
+{
+    SPASM_UNUSED(old_size);
+    SPASM_UNUSED(user_data);
+
+    return realloc(ptr, new_size);
+}
+
+static void spasm_default_free(void* ptr, size_t size, void* user_data)
+{
+    SPASM_UNUSED(size);
+    SPASM_UNUSED(user_data);
+
+    free(ptr);
+}
+
+static const SpasmAllocator spasm_default_allocator = {
+    spasm_default_alloc,
+    spasm_default_realloc,
+    spasm_default_free,
+    NULL,
+};
+
+const SpasmAllocator* spasm_get_default_allocator(void)
+{
+    return &spasm_default_allocator;
+}
+
+/* Tracking allocator */
+
+static void spasm_tracking_allocator_add(SpasmTrackingAllocator* tracking, size_t size)
+{
+    tracking->bytes_in_use += size;
+
+    if(tracking->bytes_in_use > tracking->peak_bytes_in_use)
+        tracking->peak_bytes_in_use = tracking->bytes_in_use;
+}
+
+static void* spasm_tracking_alloc(size_t size, void* user_data)
+{
+    SpasmTrackingAllocator* tracking = (SpasmTrackingAllocator*)user_data;
+
+    void* ptr = spasm_allocator_alloc(tracking->parent, size);
+
+    if(ptr != NULL)
+    {
+        tracking->num_allocs++;
+        spasm_tracking_allocator_add(tracking, size);
+    }
+
+    return ptr;
+}
+
+static void* spasm_tracking_realloc(void* ptr, size_t old_size, size_t new_size, void* user_data)
+{
+    SpasmTrackingAllocator* tracking = (SpasmTrackingAllocator*)user_data;
+
+    void* new_ptr = spasm_allocator_realloc(tracking->parent, ptr, old_size, new_size);
+
+    if(new_ptr != NULL)
+    {
+        tracking->num_reallocs++;
+        tracking->bytes_in_use -= old_size;
+        spasm_tracking_allocator_add(tracking, new_size);
+    }
+
+    return new_ptr;
+}
+
+static void spasm_tracking_free(void* ptr, size_t size, void* user_data)
+{
+    SpasmTrackingAllocator* tracking = (SpasmTrackingAllocator*)user_data;
+
+    spasm_allocator_free(tracking->parent, ptr, size);
+
+    tracking->num_frees++;
+    tracking->bytes_in_use -= size;
+}
+
+void spasm_tracking_allocator_init(SpasmTrackingAllocator* tracking, const SpasmAllocator* parent)
+{
+    SPASM_ASSERT(tracking != NULL, "tracking is NULL");
+
+    memset(tracking, 0, sizeof(SpasmTrackingAllocator));
+
+    tracking->allocator.alloc = spasm_tracking_alloc;
+    tracking->allocator.realloc = spasm_tracking_realloc;
+    tracking->allocator.free = spasm_tracking_free;
+    tracking->allocator.user_data = tracking;
+    tracking->parent = parent != NULL ? parent : spasm_get_default_allocator();
+}
+
+void spasm_tracking_allocator_reset_counters(SpasmTrackingAllocator* tracking)
+{
+    SPASM_ASSERT(tracking != NULL, "tracking is NULL");
+
+    tracking->num_allocs = 0;
+    tracking->num_reallocs = 0;
+    tracking->num_frees = 0;
+    tracking->peak_bytes_in_use = tracking->bytes_in_use;
+}
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/arena.h"
+
+#include <stdlib.h>
+
+#define SPASM_ARENA_ALIGN(x) (((size_t)(x) + 15) & ~(size_t)15)
+
+#define SPASM_ARENA_HEADER_SIZE SPASM_ARENA_ALIGN(sizeof(SpasmArenaBlock))
+
+void spasm_arena_init(SpasmArena* arena, size_t block_size, const SpasmAllocator* allocator)
+{
+    SPASM_ASSERT(arena != NULL, "arena is NULL");
+
+    arena->head = NULL;
+    arena->free_blocks = NULL;
+    arena->block_size = block_size > 0 ? block_size : SPASM_ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocator = allocator != NULL ? allocator : spasm_get_default_allocator();
+}
+
+/* Takes the first free block large enough, if any */
+static SpasmArenaBlock* spasm_arena_take_free_block(SpasmArena* arena, size_t size)
+{
+    SpasmArenaBlock** link = &arena->free_blocks;
+
+    while(*link != NULL)
+    {
+        SpasmArenaBlock* block = *link;
+
+        if(block->size >= size)
+        {
+            *link = block->next;
+            return block;
+        }
+
+        link = &block->next;
+    }
+
+    return NULL;
+}
+
+void* spasm_arena_push(SpasmArena* arena, size_t size)
+{
+    SPASM_ASSERT(arena != NULL, "arena is NULL");
+
+    size = SPASM_ARENA_ALIGN(size);
+
+    if(arena->head == NULL || arena->head->used + size > arena->head->size)
+    {
+        SpasmArenaBlock* block = spasm_arena_take_free_block(arena, size);
+
+        if(block == NULL)
+        {
+            const size_t block_size = size > arena->block_size ? size : arena->block_size;
+
+            block = (SpasmArenaBlock*)spasm_allocator_alloc(arena->allocator,
+                                                            SPASM_ARENA_HEADER_SIZE + block_size);
+
+            if(block == NULL)
+                return NULL;
+
+            block->size = block_size;
+        }
+
+        block->next = arena->head;
+        block->used = 0;
+
+        arena->head = block;
+    }
+
+    void* ptr = (char*)arena->head + SPASM_ARENA_HEADER_SIZE + arena->head->used;
+    arena->head->used += size;
+
+    return ptr;
+}
+
+void spasm_arena_reset(SpasmArena* arena)
+{
+    SPASM_ASSERT(arena != NULL, "arena is NULL");
+
+    while(arena->head != NULL)
+    {
+        SpasmArenaBlock* next = arena->head->next;
+
+        arena->head->next = arena->free_blocks;
+        arena->free_blocks = arena->head;
+
+        arena->head = next;
+    }
+}
+
+void spasm_arena_release(SpasmArena* arena)
+{
+    SPASM_ASSERT(arena != NULL, "arena is NULL");
+
+    spasm_arena_reset(arena);
+
+    while(arena->free_blocks != NULL)
+    {
+        SpasmArenaBlock* next = arena->free_blocks->next;
+
+        spasm_allocator_free(arena->allocator,
+                             arena->free_blocks,
+                             SPASM_ARENA_HEADER_SIZE + arena->free_blocks->size);
+
+        arena->free_blocks = next;
+    }
+}
@@ -14,7 +14,7 @@ extern bool spasm_windows_x64_assembler(SpasmInstructions*, SpasmByteCode*, Spas
 extern bool spasm_linux_x64_assembler(SpasmInstructions*, SpasmByteCode*, SpasmData*);
 #endif /* defined(SPASM_ENABLE_X86_64) */
 
-static SpasmAssembler g_assemblers[SpasmABI_COUNT] = {
+static const SpasmAssembler g_assemblers[SpasmABI_COUNT] = {
     NULL,
 
 #if defined(SPASM_ENABLE_X86_64)
@@ -49,7 +49,7 @@ extern bool spasm_windows_x64_jit(SpasmInstructions*, SpasmByteCode*, SpasmData*
 extern bool spasm_linux_x64_jit(SpasmInstructions*, SpasmByteCode*, SpasmData*);
 #endif /* defined(SPASM_ENABLE_X86_64) */
 
-static SpasmJitAssembler g_jit_assemblers[SpasmABI_COUNT] = {
+static const SpasmJitAssembler g_jit_assemblers[SpasmABI_COUNT] = {
     NULL,
 
 #if defined(SPASM_ENABLE_X86_64)
@@ -3,28 +3,40 @@
 /* All rights reserved. */
 
 #include "spasm/bytecode.h"
-#include "libromano/vector.h"
 
 #include <stdio.h>
 
-SpasmByteCode spasm_bytecode_new()
+SpasmByteCode spasm_bytecode_new(SpasmContext* ctx)
 {
     SpasmByteCode bytecode;
-    vector_init(&bytecode.data, 128, sizeof(SpasmByte));
+    bytecode.ctx = ctx;
+
+    if(!spasm_vector_init(&bytecode.data, 128, sizeof(SpasmByte), spasm_context_get_allocator(ctx)))
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
 
     return bytecode;
 }
 
 void spasm_bytecode_push_back(SpasmByteCode* bytecode, SpasmByte byte)
 {
-    vector_push_back(&bytecode->data, &byte);
+    if(spasm_vector_push_back(&bytecode->data, &byte) == NULL)
+        spasm_context_report_code(bytecode->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+}
+
+void spasm_bytecode_push_bytes(SpasmByteCode* bytecode, const SpasmByte* bytes, size_t size)
+{
+    if(size == 0)
+        return;
+
+    if(spasm_vector_push_back_n(&bytecode->data, bytes, size) == NULL)
+        spasm_context_report_code(bytecode->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
 }
 
 void spasm_bytecode_debug(SpasmByteCode* bytecode)
 {
-    for(size_t i = 0; i < vector_size(&bytecode->data); i++)
+    for(size_t i = 0; i < spasm_vector_size(&bytecode->data); i++)
     {
-        printf("%02x", *(SpasmByte*)vector_at(&bytecode->data, i));
+        printf("%02x", *(SpasmByte*)spasm_vector_at(&bytecode->data, i));
     }
 
     printf("\n");
@@ -34,19 +46,24 @@ void spasm_bytecode_debug(SpasmByteCode* bytecode)
 
 size_t spasm_bytecode_size(SpasmByteCode* bytecode)
 {
-    return vector_size(&bytecode->data);
+    return spasm_vector_size(&bytecode->data);
 }
 
 SpasmByte* spasm_bytecode_get(SpasmByteCode* bytecode, size_t* size)
 {
     SPASM_ASSERT(bytecode != NULL, "bytecode is NULL");
 
-    *size = vector_size(&bytecode->data);
+    *size = spasm_vector_size(&bytecode->data);
+
+    return (SpasmByte*)bytecode->data.data;
+}
 
-    return (SpasmByte*)vector_at(&bytecode->data, 0);
+void spasm_bytecode_reset(SpasmByteCode* bytecode)
+{
+    spasm_vector_clear(&bytecode->data);
 }
 
 void spasm_bytecode_destroy(SpasmByteCode* bytecode)
 {
-    vector_release(&bytecode->data);
+    spasm_vector_release(&bytecode->data);
 }
@@ -0,0 +1,497 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/compile_queue.h"
+#include "spasm/allocator.h"
+#include "spasm/assembler.h"
+#include "spasm/platform.h"
+#include "spasm/thread.h"
+
+#include <string.h>
+
+#define SPASM_COMPILE_DEQUE_INITIAL_CAPACITY 64
+
+/* Finding the reserved job spins with a cpu pause this many times, then yields between attempts */
+#define SPASM_COMPILE_WORKER_SPINS 64
+
+struct SpasmCompileJob
+{
+    const SpasmAllocator* allocator;
+
+    SpasmInstructions* instructions;
+    SpasmData* data;
+    SpasmByteCode* bytecode;
+
+    uint32_t status;
+
+    uint64_t submit_ns;
+    uint64_t start_ns;
+    uint64_t end_ns;
+
+    SpasmMutex done_mutex;
+    SpasmCondVar done_condvar;
+};
+
+/*
+    Ring buffer deque, the owner worker pops from the front and thieves steal from the back.
+    Each deque is protected by its own mutex: jobs are coarse (a whole function assembling) so the
+    lock is never contended long enough to justify a lock-free Chase-Lev deque
+*/
+typedef struct
+{
+    SpasmCompileJob** jobs;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t size;
+    SpasmMutex mutex;
+} SpasmCompileDeque;
+
+typedef struct
+{
+    SpasmThread thread;
+    SpasmCompileQueue* queue;
+    uint32_t index;
+    SpasmCompileDeque deques[SpasmCompilePriority_COUNT];
+} SpasmCompileWorker;
+
+struct SpasmCompileQueue
+{
+    const SpasmAllocator* allocator;
+    SpasmJitAssembler assembler;
+
+    SpasmCompileWorker* workers;
+    uint32_t num_workers;
+    uint32_t next_worker;
+
+    /* Number of submitted jobs not yet picked by a worker */
+    uint32_t num_pending;
+    bool stop;
+
+    SpasmMutex work_mutex;
+    SpasmCondVar work_condvar;
+};
+
+/* Deque */
+
+static bool spasm_compile_deque_init(SpasmCompileDeque* deque, const SpasmAllocator* allocator)
+{
+    deque->jobs = (SpasmCompileJob**)spasm_allocator_alloc(allocator,
+                                                          SPASM_COMPILE_DEQUE_INITIAL_CAPACITY * sizeof(SpasmCompileJob*));
+
+    if(deque->jobs == NULL)
+        return false;
+
+    deque->capacity = SPASM_COMPILE_DEQUE_INITIAL_CAPACITY;
+    deque->head = 0;
+    deque->size = 0;
+
+    if(!spasm_mutex_init(&deque->mutex))
+    {
+        spasm_allocator_free(allocator, deque->jobs, deque->capacity * sizeof(SpasmCompileJob*));
+        deque->jobs = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static bool spasm_compile_deque_push(SpasmCompileDeque* deque,
+                                     const SpasmAllocator* allocator,
+                                     SpasmCompileJob* job)
+{
+    spasm_mutex_lock(&deque->mutex);
+
+    if(deque->size == deque->capacity)
+    {
+        uint32_t new_capacity = deque->capacity * 2;
+        SpasmCompileJob** new_jobs = (SpasmCompileJob**)spasm_allocator_alloc(allocator,
+                                                                              new_capacity * sizeof(SpasmCompileJob*));
+
+        if(new_jobs == NULL)
+        {
+            spasm_mutex_unlock(&deque->mutex);
+            return false;
+        }
+
+        for(uint32_t i = 0; i < deque->size; i++)
+            new_jobs[i] = deque->jobs[(deque->head + i) % deque->capacity];
+
+        spasm_allocator_free(allocator, deque->jobs, deque->capacity * sizeof(SpasmCompileJob*));
+
+        deque->jobs = new_jobs;
+        deque->capacity = new_capacity;
+        deque->head = 0;
+    }
+
+    deque->jobs[(deque->head + deque->size) % deque->capacity] = job;
+    deque->size++;
+
+    spasm_mutex_unlock(&deque->mutex);
+
+    return true;
+}
+
+static SpasmCompileJob* spasm_compile_deque_pop_front(SpasmCompileDeque* deque)
+{
+    SpasmCompileJob* job = NULL;
+
+    spasm_mutex_lock(&deque->mutex);
+
+    if(deque->size > 0)
+    {
+        job = deque->jobs[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->size--;
+    }
+
+    spasm_mutex_unlock(&deque->mutex);
+
+    return job;
+}
+
+static SpasmCompileJob* spasm_compile_deque_pop_back(SpasmCompileDeque* deque)
+{
+    SpasmCompileJob* job = NULL;
+
+    spasm_mutex_lock(&deque->mutex);
+
+    if(deque->size > 0)
+    {
+        deque->size--;
+        job = deque->jobs[(deque->head + deque->size) % deque->capacity];
+    }
+
+    spasm_mutex_unlock(&deque->mutex);
+
+    return job;
+}
+
+static void spasm_compile_deque_release(SpasmCompileDeque* deque, const SpasmAllocator* allocator)
+{
+    if(deque->jobs == NULL)
+        return;
+
+    spasm_mutex_release(&deque->mutex);
+    spasm_allocator_free(allocator, deque->jobs, deque->capacity * sizeof(SpasmCompileJob*));
+    deque->jobs = NULL;
+}
+
+/* Workers */
+
+static SpasmCompileJob* spasm_compile_worker_find_job(SpasmCompileWorker* worker)
+{
+    SpasmCompileQueue* queue = worker->queue;
+
+    for(uint32_t priority = 0; priority < SpasmCompilePriority_COUNT; priority++)
+    {
+        SpasmCompileJob* job = spasm_compile_deque_pop_front(&worker->deques[priority]);
+
+        if(job != NULL)
+            return job;
+
+        for(uint32_t i = 1; i < queue->num_workers; i++)
+        {
+            SpasmCompileWorker* victim = &queue->workers[(worker->index + i) % queue->num_workers];
+
+            job = spasm_compile_deque_pop_back(&victim->deques[priority]);
+
+            if(job != NULL)
+                return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void spasm_compile_job_run(SpasmCompileQueue* queue, SpasmCompileJob* job)
+{
+    job->start_ns = spasm_get_timestamp_ns();
+    spasm_atomic_store_32(&job->status, (uint32_t)SpasmCompileJobStatus_Running);
+
+    /* The workers already keep the cpus busy, encoding threads would only oversubscribe them */
+    SpasmContext* ctx = job->instructions->ctx;
+    const uint32_t max_encoding_threads = ctx != NULL ? ctx->max_encoding_threads : 0;
+
+    if(ctx != NULL)
+        ctx->max_encoding_threads = 1;
+
+    bool res = queue->assembler(job->instructions, job->bytecode, job->data);
+
+    if(ctx != NULL)
+        ctx->max_encoding_threads = max_encoding_threads;
+
+    job->end_ns = spasm_get_timestamp_ns();
+
+    spasm_mutex_lock(&job->done_mutex);
+    spasm_atomic_store_32(&job->status,
+                          (uint32_t)(res ? SpasmCompileJobStatus_Done : SpasmCompileJobStatus_Failed));
+    spasm_condvar_broadcast(&job->done_condvar);
+    spasm_mutex_unlock(&job->done_mutex);
+}
+
+static void spasm_compile_worker_loop(void* arg)
+{
+    SpasmCompileWorker* worker = (SpasmCompileWorker*)arg;
+    SpasmCompileQueue* queue = worker->queue;
+
+    while(true)
+    {
+        spasm_mutex_lock(&queue->work_mutex);
+
+        while(queue->num_pending == 0 && !queue->stop)
+            spasm_condvar_wait(&queue->work_condvar, &queue->work_mutex);
+
+        if(queue->num_pending == 0)
+        {
+            spasm_mutex_unlock(&queue->work_mutex);
+            return;
+        }
+
+        /*
+            Reserve a job, it has been pushed to a deque before num_pending was incremented so it
+            will be found, possibly after another reserving worker took the one we saw first
+        */
+        queue->num_pending--;
+
+        spasm_mutex_unlock(&queue->work_mutex);
+
+        SpasmCompileJob* job = NULL;
+
+        for(uint32_t spins = 0; (job = spasm_compile_worker_find_job(worker)) == NULL; spins++)
+        {
+            if(spins < SPASM_COMPILE_WORKER_SPINS)
+                spasm_cpu_pause();
+            else
+                spasm_thread_yield();
+        }
+
+        spasm_compile_job_run(queue, job);
+    }
+}
+
+/* Queue */
+
+static void spasm_compile_queue_free(SpasmCompileQueue* queue, uint32_t num_started_workers)
+{
+    spasm_mutex_lock(&queue->work_mutex);
+    queue->stop = true;
+    spasm_condvar_broadcast(&queue->work_condvar);
+    spasm_mutex_unlock(&queue->work_mutex);
+
+    for(uint32_t i = 0; i < num_started_workers; i++)
+        spasm_thread_join(&queue->workers[i].thread);
+
+    for(uint32_t i = 0; i < queue->num_workers; i++)
+        for(uint32_t p = 0; p < SpasmCompilePriority_COUNT; p++)
+            spasm_compile_deque_release(&queue->workers[i].deques[p], queue->allocator);
+
+    spasm_condvar_release(&queue->work_condvar);
+    spasm_mutex_release(&queue->work_mutex);
+
+    const SpasmAllocator* allocator = queue->allocator;
+
+    spasm_allocator_free(allocator, queue->workers, queue->num_workers * sizeof(SpasmCompileWorker));
+    spasm_allocator_free(allocator, queue, sizeof(SpasmCompileQueue));
+}
+
+SpasmCompileQueue* spasm_compile_queue_new(SpasmContext* ctx, SpasmABI abi, uint32_t num_workers)
+{
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(abi);
+
+    if(assembler == NULL)
+        return NULL;
+
+    if(num_workers == 0)
+        num_workers = spasm_get_num_cpus();
+
+    const SpasmAllocator* allocator = spasm_context_get_allocator(ctx);
+
+    SpasmCompileQueue* queue = (SpasmCompileQueue*)spasm_allocator_alloc(allocator, sizeof(SpasmCompileQueue));
+
+    if(queue == NULL)
+        return NULL;
+
+    memset(queue, 0, sizeof(SpasmCompileQueue));
+
+    queue->allocator = allocator;
+    queue->assembler = assembler;
+    queue->workers = (SpasmCompileWorker*)spasm_allocator_alloc(allocator, num_workers * sizeof(SpasmCompileWorker));
+
+    if(queue->workers != NULL)
+    {
+        memset(queue->workers, 0, num_workers * sizeof(SpasmCompileWorker));
+        queue->num_workers = num_workers;
+    }
+
+    if(queue->workers == NULL ||
+       !spasm_mutex_init(&queue->work_mutex) ||
+       !spasm_condvar_init(&queue->work_condvar))
+    {
+        spasm_compile_queue_free(queue, 0);
+        return NULL;
+    }
+
+    for(uint32_t i = 0; i < num_workers; i++)
+    {
+        queue->workers[i].queue = queue;
+        queue->workers[i].index = i;
+
+        for(uint32_t p = 0; p < SpasmCompilePriority_COUNT; p++)
+        {
+            if(!spasm_compile_deque_init(&queue->workers[i].deques[p], allocator))
+            {
+                spasm_compile_queue_free(queue, 0);
+                return NULL;
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < num_workers; i++)
+    {
+        if(!spasm_thread_start(&queue->workers[i].thread, spasm_compile_worker_loop, &queue->workers[i]))
+        {
+            spasm_compile_queue_free(queue, i);
+            return NULL;
+        }
+    }
+
+    return queue;
+}
+
+uint32_t spasm_compile_queue_num_workers(SpasmCompileQueue* queue)
+{
+    SPASM_ASSERT(queue != NULL, "queue is NULL");
+
+    return queue->num_workers;
+}
+
+SpasmCompileJob* spasm_compile_queue_submit(SpasmCompileQueue* queue,
+                                            SpasmInstructions* instructions,
+                                            SpasmData* data,
+                                            SpasmByteCode* bytecode,
+                                            SpasmCompilePriority priority)
+{
+    SPASM_ASSERT(queue != NULL, "queue is NULL");
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+    SPASM_ASSERT(data != NULL, "data is NULL");
+    SPASM_ASSERT(bytecode != NULL, "bytecode is NULL");
+    SPASM_ASSERT(priority < SpasmCompilePriority_COUNT, "invalid priority");
+
+    SpasmCompileJob* job = (SpasmCompileJob*)spasm_allocator_alloc(queue->allocator, sizeof(SpasmCompileJob));
+
+    if(job == NULL)
+        return NULL;
+
+    memset(job, 0, sizeof(SpasmCompileJob));
+
+    if(!spasm_mutex_init(&job->done_mutex))
+    {
+        spasm_allocator_free(queue->allocator, job, sizeof(SpasmCompileJob));
+        return NULL;
+    }
+
+    if(!spasm_condvar_init(&job->done_condvar))
+    {
+        spasm_mutex_release(&job->done_mutex);
+        spasm_allocator_free(queue->allocator, job, sizeof(SpasmCompileJob));
+        return NULL;
+    }
+
+    job->allocator = queue->allocator;
+    job->instructions = instructions;
+    job->data = data;
+    job->bytecode = bytecode;
+    job->status = (uint32_t)SpasmCompileJobStatus_Pending;
+    job->submit_ns = spasm_get_timestamp_ns();
+
+    uint32_t worker_index = spasm_atomic_fetch_add_32(&queue->next_worker, 1) % queue->num_workers;
+
+    if(!spasm_compile_deque_push(&queue->workers[worker_index].deques[priority], queue->allocator, job))
+    {
+        spasm_condvar_release(&job->done_condvar);
+        spasm_mutex_release(&job->done_mutex);
+        spasm_allocator_free(queue->allocator, job, sizeof(SpasmCompileJob));
+        return NULL;
+    }
+
+    spasm_mutex_lock(&queue->work_mutex);
+    queue->num_pending++;
+    spasm_condvar_signal(&queue->work_condvar);
+    spasm_mutex_unlock(&queue->work_mutex);
+
+    return job;
+}
+
+void spasm_compile_queue_destroy(SpasmCompileQueue* queue)
+{
+    if(queue == NULL)
+        return;
+
+    /* Workers only exit once num_pending reaches 0, so every submitted job is finished */
+    spasm_compile_queue_free(queue, queue->num_workers);
+}
+
+/* Jobs */
+
+static SPASM_FORCE_INLINE bool spasm_compile_job_status_finished(uint32_t status)
+{
+    return status == SpasmCompileJobStatus_Done || status == SpasmCompileJobStatus_Failed;
+}
+
+SpasmCompileJobStatus spasm_compile_job_poll(SpasmCompileJob* job)
+{
+    SPASM_ASSERT(job != NULL, "job is NULL");
+
+    return (SpasmCompileJobStatus)spasm_atomic_load_32(&job->status);
+}
+
+SpasmCompileJobStatus spasm_compile_job_wait(SpasmCompileJob* job)
+{
+    SPASM_ASSERT(job != NULL, "job is NULL");
+
+    uint32_t status = spasm_atomic_load_32(&job->status);
+
+    if(spasm_compile_job_status_finished(status))
+        return (SpasmCompileJobStatus)status;
+
+    spasm_mutex_lock(&job->done_mutex);
+
+    while(!spasm_compile_job_status_finished(status = spasm_atomic_load_32(&job->status)))
+        spasm_condvar_wait(&job->done_condvar, &job->done_mutex);
+
+    spasm_mutex_unlock(&job->done_mutex);
+
+    return (SpasmCompileJobStatus)status;
+}
+
+SpasmCompileJobTimings spasm_compile_job_get_timings(SpasmCompileJob* job)
+{
+    SPASM_ASSERT(job != NULL, "job is NULL");
+    SPASM_ASSERT(spasm_compile_job_status_finished(spasm_atomic_load_32(&job->status)),
+                 "job is not finished");
+
+    SpasmCompileJobTimings timings;
+    timings.queued_ns = job->start_ns - job->submit_ns;
+    timings.run_ns = job->end_ns - job->start_ns;
+    timings.total_ns = job->end_ns - job->submit_ns;
+
+    return timings;
+}
+
+void spasm_compile_job_release(SpasmCompileJob* job)
+{
+    if(job == NULL)
+        return;
+
+    spasm_compile_job_wait(job);
+
+    /* The worker may still be inside the broadcast, wait for it to leave the critical section */
+    spasm_mutex_lock(&job->done_mutex);
+    spasm_mutex_unlock(&job->done_mutex);
+
+    spasm_condvar_release(&job->done_condvar);
+    spasm_mutex_release(&job->done_mutex);
+
+    spasm_allocator_free(job->allocator, job, sizeof(SpasmCompileJob));
+}
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/context.h"
+#include "spasm/error.h"
+
+#include <string.h>
+
+void spasm_context_init(SpasmContext* ctx)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    memset(ctx, 0, sizeof(SpasmContext));
+}
+
+void spasm_context_set_error_callback(SpasmContext* ctx,
+                                      SpasmErrorCallback callback,
+                                      void* user_data)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    ctx->error_callback = callback;
+    ctx->error_user_data = user_data;
+}
+
+void spasm_context_set_allocator(SpasmContext* ctx, const SpasmAllocator* allocator)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    ctx->allocator = allocator;
+}
+
+const SpasmAllocator* spasm_context_get_allocator(SpasmContext* ctx)
+{
+    if(ctx == NULL || ctx->allocator == NULL)
+        return spasm_get_default_allocator();
+
+    return ctx->allocator;
+}
+
+void spasm_context_set_max_encoding_threads(SpasmContext* ctx, uint32_t max_threads)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    ctx->max_encoding_threads = max_threads;
+}
+
+void spasm_context_report(SpasmContext* ctx, const SpasmError* error)
+{
+    SPASM_ASSERT(error != NULL, "error is NULL");
+
+    if(ctx == NULL)
+    {
+        char buffer[SPASM_ERROR_BUFFER_MAX_SZ];
+        spasm_error_format(error, buffer, SPASM_ERROR_BUFFER_MAX_SZ);
+
+        fprintf(stderr, "ERROR: spasm: %s\n", buffer);
+        return;
+    }
+
+    ctx->stats.num_errors++;
+    ctx->last_error = *error;
+
+    if(ctx->error_callback != NULL)
+        ctx->error_callback(error, ctx->error_user_data);
+}
+
+void spasm_context_report_code(SpasmContext* ctx,
+                               SpasmErrorCode code,
+                               const char* name,
+                               size_t name_len)
+{
+    SpasmError error;
+    memset(&error, 0, sizeof(SpasmError));
+
+    error.code = code;
+    error.name = name;
+    error.name_len = name_len;
+
+    spasm_context_report(ctx, &error);
+}
+
+const SpasmError* spasm_context_get_last_error(SpasmContext* ctx)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    return &ctx->last_error;
+}
+
+void spasm_context_reset_stats(SpasmContext* ctx)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    memset(&ctx->stats, 0, sizeof(SpasmStats));
+}
+
+void spasm_context_release(SpasmContext* ctx)
+{
+    SPASM_ASSERT(ctx != NULL, "ctx is NULL");
+
+    memset(ctx, 0, sizeof(SpasmContext));
+}
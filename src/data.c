@@ -4,48 +4,69 @@
 
 #include "spasm/data.h"
 
-#include "libromano/hashmap.h"
-#include "libromano/vector.h"
 #include "spasm/error.h"
 
 #include <stdint.h>
 #include <string.h>
 
-bool spasm_data_init(SpasmData* data)
+bool spasm_data_init(SpasmData* data, SpasmContext* ctx)
 {
-    data->rodata = hashmap_new(16);
+    SPASM_ASSERT(data != NULL, "data is NULL");
 
-    if(data->rodata == NULL)
-        return false;
+    const SpasmAllocator* allocator = spasm_context_get_allocator(ctx);
 
-    data->data = hashmap_new(16);
+    data->ctx = ctx;
 
-    if(data->data == NULL)
-        return false;
+    spasm_hashmap_init(&data->rodata, allocator);
+    spasm_hashmap_init(&data->data, allocator);
+    spasm_hashmap_init(&data->bss, allocator);
+    spasm_hashmap_init(&data->extern_symbols, allocator);
+    spasm_hashmap_init(&data->export_symbols, allocator);
+    spasm_hashmap_init(&data->intern_symbols, allocator);
 
-    data->bss = hashmap_new(16);
+    data->symbols_index = 0;
 
-    if(data->bss == NULL)
-        return false;
+    spasm_vector_init(&data->refs_pool, 0, sizeof(SpasmVector), allocator);
 
-    data->extern_symbols = hashmap_new(16);
+    return true;
+}
 
-    if(data->extern_symbols == NULL)
-        return false;
+/* Reports allocation failures of the tables */
+static void* spasm_data_check_alloc(SpasmData* data, void* ptr)
+{
+    if(ptr == NULL)
+        spasm_context_report_code(data->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
 
-    data->export_symbols = hashmap_new(16);
+    return ptr;
+}
 
-    if(data->export_symbols == NULL)
-        return false;
+/* Symbol refs vectors are taken from the pool filled by spasm_data_reset when possible */
+static void spasm_data_init_refs(SpasmData* data, SpasmVector* refs, size_t element_size)
+{
+    while(spasm_vector_size(&data->refs_pool) > 0)
+    {
+        data->refs_pool.size--;
 
-    data->intern_symbols = hashmap_new(16);
+        SpasmVector* pooled = (SpasmVector*)spasm_vector_at(&data->refs_pool, data->refs_pool.size);
 
-    if(data->intern_symbols == NULL)
-        return false;
+        if(pooled->element_size == element_size)
+        {
+            *refs = *pooled;
+            return;
+        }
 
-    data->symbols_index = 0;
+        spasm_vector_release(pooled);
+    }
 
-    return true;
+    spasm_vector_init(refs, 0, element_size, data->refs_pool.allocator);
+}
+
+static void spasm_data_pool_refs(SpasmData* data, SpasmVector* refs)
+{
+    spasm_vector_clear(refs);
+
+    if(spasm_vector_push_back(&data->refs_pool, refs) == NULL)
+        spasm_vector_release(refs);
 }
 
 void spasm_data_add_bytes(SpasmData* data,
@@ -59,10 +80,18 @@ void spasm_data_add_bytes(SpasmData* data,
     switch(type)
     {
         case SpasmDataType_Data:
-            hashmap_insert(data->data, data_name, data_name_sz, (void*)bytes, (uint32_t)data_sz);
+            spasm_data_check_alloc(data, spasm_hashmap_insert(&data->data,
+                                                              data_name,
+                                                              data_name_sz,
+                                                              bytes,
+                                                              (uint32_t)data_sz));
             break;
         case SpasmDataType_ROData:
-            hashmap_insert(data->rodata, data_name, data_name_sz, (void*)bytes, (uint32_t)data_sz);
+            spasm_data_check_alloc(data, spasm_hashmap_insert(&data->rodata,
+                                                              data_name,
+                                                              data_name_sz,
+                                                              bytes,
+                                                              (uint32_t)data_sz));
             break;
         default:
             break;
@@ -74,7 +103,7 @@ uintptr_t spasm_data_get_jit_address(SpasmData* data, SpasmDataId data_name)
     uint32_t data_name_sz = (uint32_t)strlen(data_name);
 
     /* TODO: do it for ROData too */
-    void* value = hashmap_get(data->data, data_name, data_name_sz, NULL);
+    void* value = spasm_hashmap_get(&data->data, data_name, data_name_sz, NULL);
 
     return (uintptr_t)value;
 }
@@ -83,7 +112,7 @@ uintptr_t spasm_data_get_jit_address(SpasmData* data, SpasmDataId data_name)
 
 size_t spasm_data_num_externs(SpasmData* data)
 {
-    return (size_t)hashmap_size(data->extern_symbols);
+    return (size_t)spasm_hashmap_size(&data->extern_symbols);
 }
 
 void spasm_data_add_extern_symbol(SpasmData* data,
@@ -93,45 +122,37 @@ void spasm_data_add_extern_symbol(SpasmData* data,
                                   SpasmRelocType reloc_type)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->extern_symbols != NULL, "data->extern_symbols is NULL");
 
     if(symbol_name_sz == 0)
         symbol_name_sz = (uint32_t)strlen(symbol_name);
 
-    SpasmExternSymbol* sym = hashmap_get(data->extern_symbols,
-                                         (const void*)symbol_name,
-                                         (const uint32_t)symbol_name_sz,
-                                         NULL);
+    SpasmExternSymbol* sym = spasm_hashmap_get(&data->extern_symbols,
+                                               (const void*)symbol_name,
+                                               symbol_name_sz,
+                                               NULL);
 
     if(sym == NULL)
     {
         SpasmExternSymbol new_sym;
         new_sym.runtime_address = NULL;
-        new_sym.refs = vector_new(8, sizeof(SpasmExternSymbolRef));
+        spasm_data_init_refs(data, &new_sym.refs, sizeof(SpasmExternSymbolRef));
         new_sym.index = data->symbols_index++;
 
-        SpasmExternSymbolRef ref;
-        ref.offset = bytecode_offset;
-        ref.reloc_type = reloc_type;
+        sym = spasm_data_check_alloc(data, spasm_hashmap_insert(&data->extern_symbols,
+                                                                (const void*)symbol_name,
+                                                                symbol_name_sz,
+                                                                &new_sym,
+                                                                sizeof(SpasmExternSymbol)));
 
-        vector_push_back(new_sym.refs, &ref);
-
-        hashmap_insert(data->extern_symbols,
-                       (const void*)symbol_name,
-                       (const uint32_t)symbol_name_sz,
-                       &new_sym,
-                       sizeof(SpasmExternSymbol));
+        if(sym == NULL)
+            return;
     }
-    else
-    {
-        SPASM_ASSERT(sym->refs != NULL, "sym->refs is NULL");
 
-        SpasmExternSymbolRef ref;
-        ref.offset = bytecode_offset;
-        ref.reloc_type = reloc_type;
+    SpasmExternSymbolRef ref;
+    ref.offset = bytecode_offset;
+    ref.reloc_type = reloc_type;
 
-        vector_push_back(sym->refs, &ref);
-    }
+    spasm_data_check_alloc(data, spasm_vector_push_back(&sym->refs, &ref));
 }
 
 void spasm_data_extern_symbol_iterator_init(SpasmDataExternSymbolIterator* it)
@@ -147,20 +168,18 @@ bool spasm_data_iterate_extern_symbols(SpasmData* data,
                                        SpasmDataExternSymbolIterator* it)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->extern_symbols != NULL, "data->extern_symbols is NULL");
-
-    return hashmap_iterate(data->extern_symbols,
-                           &it->hashmap_it,
-                           (void**)&it->name,
-                           &it->name_sz,
-                           (void**)&it->symbol,
-                           NULL);
+
+    return spasm_hashmap_iterate(&data->extern_symbols,
+                                 &it->hashmap_it,
+                                 (void**)&it->name,
+                                 &it->name_sz,
+                                 (void**)&it->symbol,
+                                 NULL);
 }
 
 size_t spasm_data_extern_num_relocations(SpasmData* data)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->extern_symbols != NULL, "data->extern_symbols is NULL");
 
     size_t num = 0;
 
@@ -168,7 +187,7 @@ size_t spasm_data_extern_num_relocations(SpasmData* data)
     spasm_data_extern_symbol_iterator_init(&it);
 
     while(spasm_data_iterate_extern_symbols(data, &it))
-        num += (size_t)vector_size(it.symbol->refs);
+        num += spasm_vector_size(&it.symbol->refs);
 
     return num;
 }
@@ -178,9 +197,8 @@ size_t spasm_data_extern_num_relocations(SpasmData* data)
 size_t spasm_data_num_exports(SpasmData* data)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->export_symbols != NULL, "data->export_symbols is NULL");
 
-    return (size_t)hashmap_size(data->export_symbols);
+    return (size_t)spasm_hashmap_size(&data->export_symbols);
 }
 
 void spasm_data_export_symbol_iterator_init(SpasmDataExportSymbolIterator* it)
@@ -195,12 +213,12 @@ void spasm_data_export_symbol_iterator_init(SpasmDataExportSymbolIterator* it)
 bool spasm_data_iterate_export_symbols(SpasmData* data,
                                        SpasmDataExportSymbolIterator* it)
 {
-    return hashmap_iterate(data->export_symbols,
-                           &it->hashmap_it,
-                           (void**)&it->name,
-                           &it->name_sz,
-                           (void**)&it->symbol,
-                           NULL);
+    return spasm_hashmap_iterate(&data->export_symbols,
+                                 &it->hashmap_it,
+                                 (void**)&it->name,
+                                 &it->name_sz,
+                                 (void**)&it->symbol,
+                                 NULL);
 }
 
 void spasm_data_add_export_symbol(SpasmData* data,
@@ -209,32 +227,34 @@ void spasm_data_add_export_symbol(SpasmData* data,
                                   size_t bytecode_start_offset)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->export_symbols != NULL, "data->export_symbols != NULL");
 
     if(symbol_name_sz == 0)
         symbol_name_sz = (uint32_t)strlen(symbol_name);
 
-    SpasmExportSymbol* sym = hashmap_get(data->export_symbols,
-                                         (const void*)symbol_name,
-                                         (const uint32_t)symbol_name_sz,
-                                         NULL);
+    SpasmExportSymbol* sym = spasm_hashmap_get(&data->export_symbols,
+                                               (const void*)symbol_name,
+                                               symbol_name_sz,
+                                               NULL);
 
     if(sym == NULL)
     {
         SpasmExportSymbol new_sym;
         new_sym.start_offset = bytecode_start_offset;
-        new_sym.refs = vector_new(8, sizeof(SpasmExportSymbolRef));
+        spasm_data_init_refs(data, &new_sym.refs, sizeof(SpasmExportSymbolRef));
         new_sym.index = data->symbols_index++;
 
-        hashmap_insert(data->export_symbols,
-                       (const void*)symbol_name,
-                       (const uint32_t)symbol_name_sz,
-                        &new_sym,
-                        sizeof(SpasmExportSymbol));
+        spasm_data_check_alloc(data, spasm_hashmap_insert(&data->export_symbols,
+                                                          (const void*)symbol_name,
+                                                          symbol_name_sz,
+                                                          &new_sym,
+                                                          sizeof(SpasmExportSymbol)));
     }
     else
     {
-        spasm_error("Symbol \"%s\" is already added in export symbols table");
+        spasm_context_report_code(data->ctx,
+                                  SpasmErrorCode_SymbolAlreadyExported,
+                                  symbol_name,
+                                  symbol_name_sz);
     }
 }
 
@@ -245,29 +265,29 @@ void spasm_data_add_export_symbol_ref(SpasmData* data,
                                       SpasmRelocType reloc_type)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->export_symbols != NULL, "data->export_symbols is NULL");
 
     if(symbol_name_sz == 0)
         symbol_name_sz = (uint32_t)strlen(symbol_name);
 
-    SpasmExportSymbol* sym = hashmap_get(data->export_symbols,
-                                         (const void*)symbol_name,
-                                         (const uint32_t)symbol_name_sz,
-                                         NULL);
+    SpasmExportSymbol* sym = spasm_hashmap_get(&data->export_symbols,
+                                               (const void*)symbol_name,
+                                               symbol_name_sz,
+                                               NULL);
 
     if(sym == NULL)
     {
-        spasm_error("Symbol \"%s\" is not present in export symbols table");
+        spasm_context_report_code(data->ctx,
+                                  SpasmErrorCode_SymbolNotExported,
+                                  symbol_name,
+                                  symbol_name_sz);
     }
     else
     {
-        SPASM_ASSERT(sym->refs != NULL, "sym->refs is NULL");
-
         SpasmExportSymbolRef ref;
         ref.offset = bytecode_offset;
         ref.reloc_type = reloc_type;
 
-        vector_push_back(sym->refs, &ref);
+        spasm_data_check_alloc(data, spasm_vector_push_back(&sym->refs, &ref));
     }
 }
 
@@ -276,9 +296,8 @@ void spasm_data_add_export_symbol_ref(SpasmData* data,
 size_t spasm_data_num_interns(SpasmData* data)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->intern_symbols != NULL, "data->intern_symbols is NULL");
 
-    return hashmap_size(data->intern_symbols);
+    return spasm_hashmap_size(&data->intern_symbols);
 }
 
 void spasm_data_add_intern_symbol(SpasmData* data,
@@ -287,28 +306,27 @@ void spasm_data_add_intern_symbol(SpasmData* data,
                                   size_t bytecode_start_offset)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->intern_symbols != NULL, "data->intern_symbols is NULL");
 
     if(symbol_name_sz == 0)
         symbol_name_sz = (uint32_t)strlen(symbol_name);
 
-    void* exists = hashmap_get(data->intern_symbols,
-                               (const void*)symbol_name,
-                               symbol_name_sz,
-                               NULL);
+    void* exists = spasm_hashmap_get(&data->intern_symbols,
+                                     (const void*)symbol_name,
+                                     symbol_name_sz,
+                                     NULL);
 
     if(exists != NULL)
         return;
 
     SpasmInternSymbol sym;
     sym.start_offset = bytecode_start_offset;
-    sym.refs = vector_new(8, sizeof(SpasmInternSymbolRef));
+    spasm_data_init_refs(data, &sym.refs, sizeof(SpasmInternSymbolRef));
 
-    hashmap_insert(data->intern_symbols,
-                   (const void*)symbol_name,
-                   symbol_name_sz,
-                   (void*)&sym,
-                   (uint32_t)sizeof(SpasmInternSymbol));
+    spasm_data_check_alloc(data, spasm_hashmap_insert(&data->intern_symbols,
+                                                      (const void*)symbol_name,
+                                                      symbol_name_sz,
+                                                      &sym,
+                                                      (uint32_t)sizeof(SpasmInternSymbol)));
 }
 
 void spasm_data_add_intern_symbol_ref(SpasmData* data,
@@ -318,30 +336,29 @@ void spasm_data_add_intern_symbol_ref(SpasmData* data,
                                       uint8_t rel_sz)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
-    SPASM_ASSERT(data->intern_symbols != NULL, "data->intern_symbols is NULL");
 
     if(symbol_name_sz == 0)
         symbol_name_sz = (uint32_t)strlen(symbol_name);
 
-    SpasmInternSymbol* sym = (SpasmInternSymbol*)hashmap_get(data->intern_symbols,
-                                                             (const void*)symbol_name,
-                                                             symbol_name_sz,
-                                                             NULL);
+    SpasmInternSymbol* sym = (SpasmInternSymbol*)spasm_hashmap_get(&data->intern_symbols,
+                                                                   (const void*)symbol_name,
+                                                                   symbol_name_sz,
+                                                                   NULL);
 
     if(sym == NULL)
     {
-        spasm_error("Cannot add reference to intern symbol. Cannot find symbol: \"%s\"",
-                    symbol_name);
+        spasm_context_report_code(data->ctx,
+                                  SpasmErrorCode_SymbolNotFound,
+                                  symbol_name,
+                                  symbol_name_sz);
         return;
     }
 
-    SPASM_ASSERT(sym->refs != NULL, "sym->refs is NULL");
-
     SpasmInternSymbolRef ref;
     ref.offset = bytecode_offset;
     ref.rel_sz = rel_sz;
 
-    vector_push_back(sym->refs, &ref);
+    spasm_data_check_alloc(data, spasm_vector_push_back(&sym->refs, &ref));
 }
 
 void spasm_data_intern_symbol_iterator_init(SpasmDataInternSymbolIterator* it)
@@ -358,50 +375,68 @@ bool spasm_data_iterate_intern_symbols(SpasmData* data,
     SPASM_ASSERT(data != NULL, "data is NULL");
     SPASM_ASSERT(it != NULL, "it is NULL");
 
-    SPASM_ASSERT(data->intern_symbols != NULL, "data->intern_symbols is NULL");
 
-    return hashmap_iterate(data->intern_symbols,
-                           &it->hashmap_it,
-                           (void**)&it->name,
-                           &it->name_sz,
-                           (void**)&it->symbol, NULL);
+    return spasm_hashmap_iterate(&data->intern_symbols,
+                                 &it->hashmap_it,
+                                 (void**)&it->name,
+                                 &it->name_sz,
+                                 (void**)&it->symbol,
+                                 NULL);
 }
 
-/* Destructor */
+/* Reset / Destructor */
 
-void spasm_data_release(SpasmData* data)
+void spasm_data_reset(SpasmData* data)
 {
     SPASM_ASSERT(data != NULL, "data is NULL");
 
-    hashmap_free(data->rodata);
-    hashmap_free(data->data);
-    hashmap_free(data->bss);
+    spasm_hashmap_clear(&data->rodata);
+    spasm_hashmap_clear(&data->data);
+    spasm_hashmap_clear(&data->bss);
 
     SpasmDataExternSymbolIterator extern_it;
     spasm_data_extern_symbol_iterator_init(&extern_it);
 
     while(spasm_data_iterate_extern_symbols(data, &extern_it))
-    {
-        vector_free(extern_it.symbol->refs);
-    }
+        spasm_data_pool_refs(data, &extern_it.symbol->refs);
 
-    hashmap_free(data->extern_symbols);
+    spasm_hashmap_clear(&data->extern_symbols);
 
     SpasmDataExportSymbolIterator export_it;
     spasm_data_export_symbol_iterator_init(&export_it);
 
     while(spasm_data_iterate_export_symbols(data, &export_it))
-    {
-        vector_free(export_it.symbol->refs);
-    }
+        spasm_data_pool_refs(data, &export_it.symbol->refs);
 
-    hashmap_free(data->export_symbols);
+    spasm_hashmap_clear(&data->export_symbols);
 
     SpasmDataInternSymbolIterator intern_it;
     spasm_data_intern_symbol_iterator_init(&intern_it);
 
     while(spasm_data_iterate_intern_symbols(data, &intern_it))
-        vector_free(intern_it.symbol->refs);
+        spasm_data_pool_refs(data, &intern_it.symbol->refs);
+
+    spasm_hashmap_clear(&data->intern_symbols);
+
+    data->symbols_index = 0;
+}
+
+void spasm_data_release(SpasmData* data)
+{
+    SPASM_ASSERT(data != NULL, "data is NULL");
+
+    /* Moves all the refs vectors to the pool, releasing them at once */
+    spasm_data_reset(data);
+
+    for(size_t i = 0; i < spasm_vector_size(&data->refs_pool); i++)
+        spasm_vector_release((SpasmVector*)spasm_vector_at(&data->refs_pool, i));
+
+    spasm_vector_release(&data->refs_pool);
 
-    hashmap_free(data->intern_symbols);
+    spasm_hashmap_release(&data->rodata);
+    spasm_hashmap_release(&data->data);
+    spasm_hashmap_release(&data->bss);
+    spasm_hashmap_release(&data->extern_symbols);
+    spasm_hashmap_release(&data->export_symbols);
+    spasm_hashmap_release(&data->intern_symbols);
 }
@@ -0,0 +1,185 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/error.h"
+
+static const char* spasm_error_codes_as_string[SpasmErrorCode_COUNT] = {
+    "None",
+    "UnknownInstruction",
+    "SymbolAlreadyExported",
+    "SymbolNotExported",
+    "SymbolNotFound",
+    "UnsupportedABI",
+    "InvalidByteCode",
+    "OutOfMemory",
+    "FileOpen",
+    "FileWrite",
+    "TooManyOperands",
+    "UnknownMnemonic",
+    "InvalidLabel",
+    "BranchOutOfRange",
+    "InvalidAlignment",
+    "InvalidVirtualRegister",
+    "TooManySpills",
+    "UnsupportedUarch",
+    "InvalidCallArgument",
+};
+
+const char* spasm_error_code_as_string(SpasmErrorCode code)
+{
+    if(code >= SpasmErrorCode_COUNT)
+        return "Unknown";
+
+    return spasm_error_codes_as_string[code];
+}
+
+static size_t spasm_error_clamp_format_size(int format_size, size_t buffer_size)
+{
+    if(format_size < 0)
+        return 0;
+
+    return (size_t)format_size < buffer_size ? (size_t)format_size : buffer_size - 1;
+}
+
+/* Writes the message followed by the instruction of the error, when it has one */
+static size_t spasm_error_format_with_instruction(const SpasmError* error,
+                                                  char* buffer,
+                                                  size_t buffer_size,
+                                                  const char* message)
+{
+    const int format_size = snprintf(buffer, buffer_size, "%s", message);
+
+    size_t size = spasm_error_clamp_format_size(format_size, buffer_size);
+
+    if(error->format_instruction != NULL && error->instruction != NULL)
+        size += error->format_instruction(error, buffer + size, buffer_size - size);
+
+    return size < buffer_size ? size : buffer_size - 1;
+}
+
+size_t spasm_error_format(const SpasmError* error, char* buffer, size_t buffer_size)
+{
+    SPASM_ASSERT(error != NULL, "error is NULL");
+    SPASM_ASSERT(buffer != NULL, "buffer is NULL");
+
+    if(buffer_size == 0)
+        return 0;
+
+    const int name_len = (int)error->name_len;
+
+    int format_size = 0;
+
+    switch(error->code)
+    {
+        case SpasmErrorCode_None:
+            format_size = snprintf(buffer, buffer_size, "No error");
+            break;
+
+        case SpasmErrorCode_UnknownInstruction:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Cannot find encoding info for instruction: ");
+
+        case SpasmErrorCode_InvalidLabel:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Invalid label (unknown, not bound or bound twice) in instruction: ");
+
+        case SpasmErrorCode_BranchOutOfRange:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Branch target out of range for instruction: ");
+
+        case SpasmErrorCode_InvalidAlignment:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Invalid alignment (not a power of two or too large): ");
+
+        case SpasmErrorCode_InvalidVirtualRegister:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Invalid virtual register (unknown or seen with two register files) in instruction: ");
+
+        case SpasmErrorCode_TooManySpills:
+            return spasm_error_format_with_instruction(error,
+                                                       buffer,
+                                                       buffer_size,
+                                                       "Not enough scratch registers for the spilled operands of instruction: ");
+
+        case SpasmErrorCode_SymbolAlreadyExported:
+            format_size = snprintf(buffer,
+                                   buffer_size,
+                                   "Symbol \"%.*s\" is already added in export symbols table",
+                                   name_len,
+                                   error->name);
+            break;
+
+        case SpasmErrorCode_SymbolNotExported:
+            format_size = snprintf(buffer,
+                                   buffer_size,
+                                   "Symbol \"%.*s\" is not present in export symbols table",
+                                   name_len,
+                                   error->name);
+            break;
+
+        case SpasmErrorCode_SymbolNotFound:
+            format_size = snprintf(buffer,
+                                   buffer_size,
+                                   "Cannot add reference to intern symbol. Cannot find symbol: \"%.*s\"",
+                                   name_len,
+                                   error->name);
+            break;
+
+        case SpasmErrorCode_UnsupportedABI:
+            format_size = snprintf(buffer, buffer_size, "Unsupported ABI: %.*s", name_len, error->name);
+            break;
+
+        case SpasmErrorCode_InvalidByteCode:
+            format_size = snprintf(buffer, buffer_size, "Invalid bytecode");
+            break;
+
+        case SpasmErrorCode_OutOfMemory:
+            format_size = snprintf(buffer, buffer_size, "Out of memory");
+            break;
+
+        case SpasmErrorCode_FileOpen:
+            format_size = snprintf(buffer, buffer_size, "Cannot open file: %.*s", name_len, error->name);
+            break;
+
+        case SpasmErrorCode_FileWrite:
+            format_size = snprintf(buffer, buffer_size, "Cannot write to file: %.*s", name_len, error->name);
+            break;
+
+        case SpasmErrorCode_TooManyOperands:
+            format_size = snprintf(buffer,
+                                   buffer_size,
+                                   "Too many operands for instruction: %.*s",
+                                   name_len,
+                                   error->name);
+            break;
+
+        case SpasmErrorCode_UnknownMnemonic:
+            format_size = snprintf(buffer, buffer_size, "Unknown mnemonic: %.*s", name_len, error->name);
+            break;
+
+        case SpasmErrorCode_UnsupportedUarch:
+            format_size = snprintf(buffer, buffer_size, "Unsupported microarchitecture");
+            break;
+
+        case SpasmErrorCode_InvalidCallArgument:
+            format_size = snprintf(buffer, buffer_size, "Invalid call argument (type, operand or count)");
+            break;
+
+        default:
+            format_size = snprintf(buffer, buffer_size, "Unknown error (code: %d)", (int)error->code);
+            break;
+    }
+
+    return spasm_error_clamp_format_size(format_size, buffer_size);
+}
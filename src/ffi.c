@@ -0,0 +1,380 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/ffi.h"
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/bytecode.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/register.h"
+#include "spasm/thread.h"
+#include "spasm/x86_64.h"
+
+#include <string.h>
+
+#define SPASM_FFI_DEFAULT_CAPACITY 256
+
+/* Thunks are packed in blocks of executable memory */
+#define SPASM_FFI_CODE_BLOCK_SIZE 65536
+
+#define SPASM_FFI_THUNK_ALIGNMENT 16
+
+typedef struct
+{
+    uint32_t ready; /* Stored last (atomically) once the other fields are written */
+    uint32_t hash;
+    SpasmFFISignature signature;
+    SpasmFFIThunk thunk;
+} SpasmFFICacheEntry;
+
+struct SpasmFFICache
+{
+    SpasmABI abi;
+    const SpasmAllocator* allocator;
+
+    /* Open addressing table, at most half full. Entries are only added, never moved nor removed */
+    SpasmFFICacheEntry* entries;
+    uint32_t mask;
+    uint32_t capacity;
+    uint32_t size;
+
+    /* Everything below belongs to the thread holding the mutex */
+    SpasmMutex mutex;
+    SpasmExecutableMemory* blocks;
+    uint32_t num_blocks;
+    uint32_t blocks_capacity;
+    size_t block_used;
+    SpasmInstructions instructions;
+    SpasmByteCode bytecode;
+};
+
+/* Signatures */
+
+static bool spasm_ffi_signature_is_valid(const SpasmFFISignature* signature)
+{
+    if(signature->return_type > SpasmFFIType_Double || signature->num_args > SPASM_FFI_MAX_ARGS)
+        return false;
+
+    for(uint32_t i = 0; i < signature->num_args; i++)
+        if(signature->arg_types[i] == SpasmFFIType_Void || signature->arg_types[i] > SpasmFFIType_Double)
+            return false;
+
+    return true;
+}
+
+/* FNV-1a over the bytes in use, the unused argument types can hold anything */
+static uint32_t spasm_ffi_signature_hash(const SpasmFFISignature* signature)
+{
+    const uint8_t* bytes = (const uint8_t*)signature;
+    const size_t size = offsetof(SpasmFFISignature, arg_types) + signature->num_args;
+
+    uint32_t hash = 2166136261u;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool spasm_ffi_signature_equal(const SpasmFFISignature* a, const SpasmFFISignature* b)
+{
+    return a->return_type == b->return_type &&
+           a->num_args == b->num_args &&
+           memcmp(a->arg_types, b->arg_types, a->num_args) == 0;
+}
+
+/* Code generation */
+
+#if defined(SPASM_ENABLE_X86_64)
+static uint8_t spasm_ffi_call_arg_type(uint8_t type)
+{
+    switch(type)
+    {
+        case SpasmFFIType_Float: return Spasm_x86_64_CallArgType_Float;
+        case SpasmFFIType_Double: return Spasm_x86_64_CallArgType_Double;
+        default: return Spasm_x86_64_CallArgType_Int;
+    }
+}
+
+/*
+    The thunk is a function of the ABI itself: the function, the arguments and the result pointer
+    come in the first three integer argument registers. The result pointer is kept in RBX across the
+    call, and pushing RBX also aligns RSP to 16 for the call. spasm_x86_64_emit_call reserves the
+    shadow space and the stack arguments itself, so the frame is built as a leaf one
+*/
+static bool spasm_ffi_emit_thunk(SpasmFFICache* cache, const SpasmFFISignature* signature)
+{
+    SpasmInstructions* instructions = &cache->instructions;
+    spasm_instructions_reset(instructions);
+
+    size_t num_int_registers;
+    const SpasmRegister* int_registers = get_call_args_gp_registers(cache->abi, &num_int_registers);
+
+    const SpasmRegister function = int_registers[0];
+    const SpasmRegister args = int_registers[1];
+    const SpasmRegister result = int_registers[2];
+
+    Spasm_x86_64_FrameConfig config;
+    memset(&config, 0, sizeof(Spasm_x86_64_FrameConfig));
+    config.abi = cache->abi;
+    config.used_registers = spasm_x86_64_register_set(SpasmRegister_x86_64_RBX);
+
+    Spasm_x86_64_Frame frame;
+
+    if(!spasm_x86_64_frame_build(NULL, &config, NULL, &frame))
+        return false;
+
+    SPASM_ASSERT((8 + frame.push_size + frame.stack_size) % 16 == 0, "Thunk frame leaves RSP unaligned");
+
+    spasm_x86_64_frame_emit_prologue(&frame, instructions);
+
+    if(signature->return_type != SpasmFFIType_Void)
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_RBX),
+                                SpasmOpReg(result));
+
+    Spasm_x86_64_CallArg call_args[SPASM_FFI_MAX_ARGS];
+
+    for(uint32_t i = 0; i < signature->num_args; i++)
+    {
+        call_args[i].value = SpasmOpMemory(args, SpasmRegister_x86_64_NONE, 8 * i, 1);
+        call_args[i].type = spasm_ffi_call_arg_type(signature->arg_types[i]);
+    }
+
+    Spasm_x86_64_CallArg call_result;
+    call_result.value = SpasmOpMemory(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_NONE, 0, 1);
+    call_result.type = spasm_ffi_call_arg_type(signature->return_type);
+
+    if(!spasm_x86_64_emit_call(NULL,
+                               instructions,
+                               cache->abi,
+                               SpasmOpReg(function),
+                               call_args,
+                               signature->num_args,
+                               signature->return_type != SpasmFFIType_Void ? &call_result : NULL))
+        return false;
+
+    spasm_x86_64_frame_emit_epilogue(&frame, instructions);
+
+    spasm_bytecode_reset(&cache->bytecode);
+
+    return spasm_x86_64_encode_instructions(NULL, instructions, &cache->bytecode, NULL);
+}
+
+/* Copies the code of the thunk in the current block, or in a new one if it does not fit */
+static SpasmFFIThunk spasm_ffi_cache_place_code(SpasmFFICache* cache, const uint8_t* code, size_t size)
+{
+    if(cache->num_blocks == 0 || cache->block_used + size > cache->blocks[cache->num_blocks - 1].size)
+    {
+        if(cache->num_blocks == cache->blocks_capacity)
+        {
+            SpasmExecutableMemory* blocks = (SpasmExecutableMemory*)spasm_allocator_realloc(cache->allocator,
+                                                                                            cache->blocks,
+                                                                                            cache->blocks_capacity * sizeof(SpasmExecutableMemory),
+                                                                                            (cache->blocks_capacity + 1) * sizeof(SpasmExecutableMemory));
+
+            if(blocks == NULL)
+                return NULL;
+
+            cache->blocks = blocks;
+            cache->blocks_capacity++;
+        }
+
+        if(!spasm_executable_memory_alloc(&cache->blocks[cache->num_blocks],
+                                          size > SPASM_FFI_CODE_BLOCK_SIZE ? size : SPASM_FFI_CODE_BLOCK_SIZE))
+            return NULL;
+
+        cache->num_blocks++;
+        cache->block_used = 0;
+    }
+
+    SpasmExecutableMemory* block = &cache->blocks[cache->num_blocks - 1];
+
+    memcpy(block->writable + cache->block_used, code, size);
+
+    /* ISO C has no cast from an object pointer to a function pointer */
+    const uint8_t* address = block->executable + cache->block_used;
+    SpasmFFIThunk thunk;
+    memcpy(&thunk, &address, sizeof(SpasmFFIThunk));
+
+    cache->block_used = (cache->block_used + size + SPASM_FFI_THUNK_ALIGNMENT - 1) & ~(size_t)(SPASM_FFI_THUNK_ALIGNMENT - 1);
+
+    return thunk;
+}
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+static SpasmFFIThunk spasm_ffi_cache_generate(SpasmFFICache* cache, const SpasmFFISignature* signature)
+{
+#if defined(SPASM_ENABLE_X86_64)
+    if(!spasm_ffi_emit_thunk(cache, signature))
+        return NULL;
+
+    size_t size;
+    const uint8_t* code = spasm_bytecode_get(&cache->bytecode, &size);
+
+    return spasm_ffi_cache_place_code(cache, code, size);
+#else
+    SPASM_UNUSED(cache);
+    SPASM_UNUSED(signature);
+
+    return NULL;
+#endif /* defined(SPASM_ENABLE_X86_64) */
+}
+
+/* Cache */
+
+/*
+ * Returns the thunk of the signature, or NULL with the index of the empty entry ending the probe.
+ * Entries are published with an atomic store of ready, so this does not need the mutex
+ */
+static SpasmFFIThunk spasm_ffi_cache_find(SpasmFFICache* cache,
+                                          const SpasmFFISignature* signature,
+                                          uint32_t hash,
+                                          uint32_t* empty_index)
+{
+    for(uint32_t i = hash & cache->mask;; i = (i + 1) & cache->mask)
+    {
+        SpasmFFICacheEntry* entry = &cache->entries[i];
+
+        if(spasm_atomic_load_32(&entry->ready) == 0)
+        {
+            *empty_index = i;
+            return NULL;
+        }
+
+        if(entry->hash == hash && spasm_ffi_signature_equal(&entry->signature, signature))
+            return entry->thunk;
+    }
+}
+
+SpasmFFICache* spasm_ffi_cache_new(SpasmContext* ctx, uint32_t capacity)
+{
+    const SpasmABI abi = spasm_get_current_abi();
+
+#if defined(SPASM_ENABLE_X86_64)
+    if(abi != SpasmABI_LinuxX64 && abi != SpasmABI_WindowsX64)
+        return NULL;
+#else
+    return NULL;
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+    if(capacity == 0)
+        capacity = SPASM_FFI_DEFAULT_CAPACITY;
+
+    if(capacity > (1u << 30))
+        return NULL;
+
+    uint32_t num_entries = 16;
+
+    while(num_entries < 2 * capacity)
+        num_entries <<= 1;
+
+    const SpasmAllocator* allocator = spasm_context_get_allocator(ctx);
+
+    SpasmFFICache* cache = (SpasmFFICache*)spasm_allocator_alloc(allocator, sizeof(SpasmFFICache));
+
+    if(cache == NULL)
+        return NULL;
+
+    memset(cache, 0, sizeof(SpasmFFICache));
+
+    cache->entries = (SpasmFFICacheEntry*)spasm_allocator_alloc(allocator, num_entries * sizeof(SpasmFFICacheEntry));
+
+    if(cache->entries == NULL || !spasm_mutex_init(&cache->mutex))
+    {
+        spasm_allocator_free(allocator, cache->entries, num_entries * sizeof(SpasmFFICacheEntry));
+        spasm_allocator_free(allocator, cache, sizeof(SpasmFFICache));
+        return NULL;
+    }
+
+    memset(cache->entries, 0, num_entries * sizeof(SpasmFFICacheEntry));
+
+    cache->abi = abi;
+    cache->allocator = allocator;
+    cache->mask = num_entries - 1;
+    cache->capacity = capacity;
+    cache->instructions = spasm_instructions_new(ctx);
+    cache->bytecode = spasm_bytecode_new(ctx);
+
+    return cache;
+}
+
+SpasmFFIThunk spasm_ffi_cache_get(SpasmFFICache* cache, const SpasmFFISignature* signature)
+{
+    SPASM_ASSERT(cache != NULL, "cache is NULL");
+    SPASM_ASSERT(signature != NULL, "signature is NULL");
+
+    if(!spasm_ffi_signature_is_valid(signature))
+        return NULL;
+
+    const uint32_t hash = spasm_ffi_signature_hash(signature);
+    uint32_t index = 0;
+
+    SpasmFFIThunk thunk = spasm_ffi_cache_find(cache, signature, hash, &index);
+
+    if(thunk != NULL)
+        return thunk;
+
+    spasm_mutex_lock(&cache->mutex);
+
+    /* Another thread may have added it since the lookup */
+    thunk = spasm_ffi_cache_find(cache, signature, hash, &index);
+
+    if(thunk == NULL && cache->size < cache->capacity)
+    {
+        thunk = spasm_ffi_cache_generate(cache, signature);
+
+        if(thunk != NULL)
+        {
+            SpasmFFICacheEntry* entry = &cache->entries[index];
+
+            memset(&entry->signature, 0, sizeof(SpasmFFISignature));
+            entry->signature.return_type = signature->return_type;
+            entry->signature.num_args = signature->num_args;
+            memcpy(entry->signature.arg_types, signature->arg_types, signature->num_args);
+            entry->hash = hash;
+            entry->thunk = thunk;
+
+            spasm_atomic_store_32(&entry->ready, 1);
+            spasm_atomic_store_32(&cache->size, cache->size + 1);
+        }
+    }
+
+    spasm_mutex_unlock(&cache->mutex);
+
+    return thunk;
+}
+
+uint32_t spasm_ffi_cache_size(SpasmFFICache* cache)
+{
+    SPASM_ASSERT(cache != NULL, "cache is NULL");
+
+    return spasm_atomic_load_32(&cache->size);
+}
+
+void spasm_ffi_cache_destroy(SpasmFFICache* cache)
+{
+    if(cache == NULL)
+        return;
+
+    for(uint32_t i = 0; i < cache->num_blocks; i++)
+        spasm_executable_memory_release(&cache->blocks[i]);
+
+    spasm_instructions_destroy(&cache->instructions);
+    spasm_bytecode_destroy(&cache->bytecode);
+    spasm_mutex_release(&cache->mutex);
+
+    const SpasmAllocator* allocator = cache->allocator;
+
+    spasm_allocator_free(allocator, cache->blocks, cache->blocks_capacity * sizeof(SpasmExecutableMemory));
+    spasm_allocator_free(allocator, cache->entries, (cache->mask + 1) * sizeof(SpasmFFICacheEntry));
+    spasm_allocator_free(allocator, cache, sizeof(SpasmFFICache));
+}
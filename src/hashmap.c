@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/hashmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPASM_HASHMAP_INITIAL_CAPACITY 16
+
+/* Values are stored after the key, aligned for any type */
+#define SPASM_HASHMAP_VALUE_OFFSET(key_size) (((size_t)(key_size) + 15) & ~(size_t)15)
+
+/* FNV-1a */
+static uint32_t spasm_hashmap_hash(const void* key, uint32_t key_size)
+{
+    const uint8_t* bytes = (const uint8_t*)key;
+
+    uint32_t hash = 2166136261u;
+
+    for(uint32_t i = 0; i < key_size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+#define SPASM_HASHMAP_BLOCKS_SIZE 4096
+
+void spasm_hashmap_init(SpasmHashMap* map, const SpasmAllocator* allocator)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+
+    memset(map, 0, sizeof(SpasmHashMap));
+    map->allocator = allocator != NULL ? allocator : spasm_get_default_allocator();
+
+    spasm_arena_init(&map->blocks, SPASM_HASHMAP_BLOCKS_SIZE, map->allocator);
+}
+
+/* Returns the bucket holding the key, or the empty bucket where it would be inserted */
+static uint32_t spasm_hashmap_find_bucket(const SpasmHashMap* map,
+                                          const void* key,
+                                          uint32_t key_size,
+                                          uint32_t hash)
+{
+    const uint32_t mask = map->buckets_capacity - 1;
+
+    uint32_t bucket = hash & mask;
+
+    while(map->buckets[bucket] != 0)
+    {
+        const SpasmHashMapEntry* entry = &map->entries[map->buckets[bucket] - 1];
+
+        if(entry->hash == hash &&
+           entry->key_size == key_size &&
+           memcmp(entry->key, key, key_size) == 0)
+            break;
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    return bucket;
+}
+
+static bool spasm_hashmap_grow(SpasmHashMap* map)
+{
+    const uint32_t entries_capacity = map->entries_capacity == 0 ? SPASM_HASHMAP_INITIAL_CAPACITY :
+                                                                   map->entries_capacity * 2;
+
+    /* Keep the load factor under 0.5 */
+    const uint32_t buckets_capacity = entries_capacity * 2;
+
+    uint32_t* buckets = (uint32_t*)spasm_allocator_alloc(map->allocator,
+                                                         buckets_capacity * sizeof(uint32_t));
+
+    if(buckets == NULL)
+        return false;
+
+    SpasmHashMapEntry* entries = NULL;
+
+    if(map->entries == NULL)
+        entries = (SpasmHashMapEntry*)spasm_allocator_alloc(map->allocator,
+                                                            entries_capacity * sizeof(SpasmHashMapEntry));
+    else
+        entries = (SpasmHashMapEntry*)spasm_allocator_realloc(map->allocator,
+                                                              map->entries,
+                                                              map->entries_capacity * sizeof(SpasmHashMapEntry),
+                                                              entries_capacity * sizeof(SpasmHashMapEntry));
+
+    if(entries == NULL)
+    {
+        spasm_allocator_free(map->allocator, buckets, buckets_capacity * sizeof(uint32_t));
+        return false;
+    }
+
+    spasm_allocator_free(map->allocator, map->buckets, map->buckets_capacity * sizeof(uint32_t));
+
+    memset(buckets, 0, buckets_capacity * sizeof(uint32_t));
+
+    map->entries = entries;
+    map->entries_capacity = entries_capacity;
+    map->buckets = buckets;
+    map->buckets_capacity = buckets_capacity;
+
+    for(uint32_t i = 0; i < map->size; i++)
+    {
+        const SpasmHashMapEntry* entry = &map->entries[i];
+
+        uint32_t bucket = spasm_hashmap_find_bucket(map, entry->key, entry->key_size, entry->hash);
+        map->buckets[bucket] = i + 1;
+    }
+
+    return true;
+}
+
+void* spasm_hashmap_get(SpasmHashMap* map,
+                        const void* key,
+                        uint32_t key_size,
+                        uint32_t* value_size)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+
+    if(map->size == 0)
+        return NULL;
+
+    const uint32_t hash = spasm_hashmap_hash(key, key_size);
+    const uint32_t bucket = spasm_hashmap_find_bucket(map, key, key_size, hash);
+
+    if(map->buckets[bucket] == 0)
+        return NULL;
+
+    const SpasmHashMapEntry* entry = &map->entries[map->buckets[bucket] - 1];
+
+    if(value_size != NULL)
+        *value_size = entry->value_size;
+
+    return entry->value;
+}
+
+void* spasm_hashmap_insert(SpasmHashMap* map,
+                           const void* key,
+                           uint32_t key_size,
+                           const void* value,
+                           uint32_t value_size)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+
+    if(map->size == map->entries_capacity && !spasm_hashmap_grow(map))
+        return NULL;
+
+    const uint32_t hash = spasm_hashmap_hash(key, key_size);
+    const uint32_t bucket = spasm_hashmap_find_bucket(map, key, key_size, hash);
+
+    SpasmHashMapEntry new_entry;
+    new_entry.key_size = key_size;
+    new_entry.value_size = value_size;
+    new_entry.hash = hash;
+
+    char* block = (char*)spasm_arena_push(&map->blocks,
+                                          SPASM_HASHMAP_VALUE_OFFSET(key_size) + (size_t)value_size);
+
+    if(block == NULL)
+        return NULL;
+
+    new_entry.key = block;
+    new_entry.value = block + SPASM_HASHMAP_VALUE_OFFSET(key_size);
+
+    memcpy(new_entry.key, key, key_size);
+
+    if(value != NULL)
+        memcpy(new_entry.value, value, value_size);
+
+    if(map->buckets[bucket] != 0)
+    {
+        map->entries[map->buckets[bucket] - 1] = new_entry;
+    }
+    else
+    {
+        map->entries[map->size] = new_entry;
+        map->size++;
+        map->buckets[bucket] = map->size;
+    }
+
+    return new_entry.value;
+}
+
+bool spasm_hashmap_iterate(SpasmHashMap* map,
+                           SpasmHashMapIterator* it,
+                           void** key,
+                           uint32_t* key_size,
+                           void** value,
+                           uint32_t* value_size)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+    SPASM_ASSERT(it != NULL, "it is NULL");
+
+    if(*it >= map->size)
+        return false;
+
+    const SpasmHashMapEntry* entry = &map->entries[*it];
+
+    if(key != NULL)
+        *key = entry->key;
+
+    if(key_size != NULL)
+        *key_size = entry->key_size;
+
+    if(value != NULL)
+        *value = entry->value;
+
+    if(value_size != NULL)
+        *value_size = entry->value_size;
+
+    (*it)++;
+
+    return true;
+}
+
+void spasm_hashmap_clear(SpasmHashMap* map)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+
+    if(map->buckets != NULL)
+        memset(map->buckets, 0, map->buckets_capacity * sizeof(uint32_t));
+
+    map->size = 0;
+
+    spasm_arena_reset(&map->blocks);
+}
+
+void spasm_hashmap_release(SpasmHashMap* map)
+{
+    SPASM_ASSERT(map != NULL, "map is NULL");
+
+    spasm_arena_release(&map->blocks);
+
+    spasm_allocator_free(map->allocator,
+                         map->entries,
+                         map->entries_capacity * sizeof(SpasmHashMapEntry));
+    spasm_allocator_free(map->allocator, map->buckets, map->buckets_capacity * sizeof(uint32_t));
+
+    const SpasmAllocator* allocator = map->allocator;
+
+    spasm_hashmap_init(map, allocator);
+}
@@ -8,9 +8,6 @@
 #include "spasm/instruction.h"
 #include "spasm/error.h"
 
-#include "libromano/arena.h"
-#include "libromano/vector.h"
-
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -24,11 +21,17 @@
 
 /* Ctor/ Dtor */
 
-SpasmInstructions spasm_instructions_new(void)
+SpasmInstructions spasm_instructions_new(SpasmContext* ctx)
 {
     SpasmInstructions instructions;
-    vector_init(&instructions.instructions, 32, sizeof(SpasmInstructions*));
-    arena_init(&instructions.instructions_data, ARENA_BLOCK_SIZE);
+    spasm_vector_init(&instructions.instructions,
+                      0,
+                      sizeof(SpasmInstruction),
+                      spasm_context_get_allocator(ctx));
+    instructions.ctx = ctx;
+    instructions.num_labels = 0;
+    instructions.num_paddings = 0;
+    instructions.num_virtual_registers = 0;
 
     return instructions;
 }
@@ -57,55 +60,198 @@ SpasmOperand* spasm_instruction_has_symbol_operand(SpasmInstruction* instruction
     return spasm_instruction_has_operand_type(instruction, SpasmOperandType_Symbol);
 }
 
+void spasm_instructions_reset(SpasmInstructions* instructions)
+{
+    spasm_vector_clear(&instructions->instructions);
+    instructions->num_labels = 0;
+    instructions->num_paddings = 0;
+    instructions->num_virtual_registers = 0;
+}
+
 void spasm_instructions_destroy(SpasmInstructions* instructions)
 {
-    vector_release(&instructions->instructions);
-    arena_release(&instructions->instructions_data);
+    spasm_vector_release(&instructions->instructions);
 }
 
 /* Push back function to add instructions, does most of the job */
 
 /* TODO: add num operands check per instruction to validate */
 
-bool __spasm_instructions_push_back(SpasmInstructions* instructions,
-                                    const char* mnemonic,
-                                    uint8_t mnemonic_len,
-                                    uint8_t num_operands,
-                                    ...)
+SpasmInstruction* __spasm_instructions_push_record(SpasmInstructions* instructions,
+                                                  SpasmMnemonic mnemonic,
+                                                  uint8_t num_operands)
 {
-    va_list args;
-
-    size_t total_byte_size = sizeof(SpasmInstructions) + num_operands * sizeof(SpasmOperand);
+    if(num_operands > SPASM_MAX_OPERANDS)
+    {
+        const char* mnemonic_name = spasm_mnemonic_as_string(mnemonic);
 
-    void* block = arena_push(&instructions->instructions_data, NULL, total_byte_size);
+        spasm_context_report_code(instructions->ctx,
+                                  SpasmErrorCode_TooManyOperands,
+                                  mnemonic_name,
+                                  strlen(mnemonic_name));
+        return NULL;
+    }
 
-    SpasmOperand* operand_block = NULL;
+    SpasmInstruction* instr = (SpasmInstruction*)spasm_vector_push_back(&instructions->instructions, NULL);
 
-    if(num_operands > 0)
-        operand_block = (SpasmOperand*)((char*)block + sizeof(SpasmInstruction));
+    if(instr == NULL)
+    {
+        spasm_context_report_code(instructions->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return NULL;
+    }
 
-    SpasmInstruction* instr = (SpasmInstruction*)block;
-    instr->mnemonic = mnemonic;
-    instr->mnemonic_len = mnemonic_len;
+    instr->mnemonic = (uint16_t)mnemonic;
     instr->num_operands = num_operands;
-    instr->operands = operand_block;
+    instr->form = 0;
 
-    va_start(args, num_operands);
+    SPASM_CONTEXT_STAT_ADD(instructions->ctx, num_instructions_pushed, 1);
+
+    return instr;
+}
+
+static bool spasm_instructions_push_va(SpasmInstructions* instructions,
+                                       SpasmMnemonic mnemonic,
+                                       uint8_t num_operands,
+                                       va_list args)
+{
+    SpasmInstruction* instr = __spasm_instructions_push_record(instructions, mnemonic, num_operands);
+
+    if(instr == NULL)
+        return false;
 
     for(size_t i = 0; i < num_operands; i++)
+        instr->operands[i] = va_arg(args, SpasmOperand);
+
+    return true;
+}
+
+bool spasm_instructions_push_array(SpasmInstructions* instructions,
+                                   SpasmMnemonic mnemonic,
+                                   const SpasmOperand* operands,
+                                   uint8_t num_operands)
+{
+    SpasmInstruction* instr = __spasm_instructions_push_record(instructions, mnemonic, num_operands);
+
+    if(instr == NULL)
+        return false;
+
+    if(num_operands > 0)
+        memcpy(instr->operands, operands, num_operands * sizeof(SpasmOperand));
+
+    return true;
+}
+
+bool spasm_instructions_append(SpasmInstructions* instructions,
+                               const SpasmInstruction* src,
+                               size_t count)
+{
+    if(count == 0)
+        return true;
+
+    if(spasm_vector_push_back_n(&instructions->instructions, src, count) == NULL)
     {
-        SpasmOperand operand = va_arg(args, SpasmOperand);
+        spasm_context_report_code(instructions->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    SPASM_CONTEXT_STAT_ADD(instructions->ctx, num_instructions_pushed, count);
+
+    return true;
+}
+
+/* Labels */
+
+SpasmLabel spasm_instructions_new_label(SpasmInstructions* instructions)
+{
+    return instructions->num_labels++;
+}
 
-        memcpy(&operand_block[i], &operand, sizeof(SpasmOperand));
+bool spasm_instructions_bind_label(SpasmInstructions* instructions, SpasmLabel label)
+{
+    SPASM_ASSERT(label < instructions->num_labels, "label has not been created by this stream");
+
+    SpasmInstruction* instr = __spasm_instructions_push_record(instructions, SpasmMnemonic_Label, 1);
+
+    if(instr == NULL)
+        return false;
+
+    instr->operands[0] = SpasmOpLabel(label);
+
+    return true;
+}
+
+/* Virtual registers */
+
+SpasmVirtualRegister spasm_instructions_new_virtual_register(SpasmInstructions* instructions)
+{
+    return instructions->num_virtual_registers++;
+}
+
+/* Alignment */
+
+bool spasm_instructions_align(SpasmInstructions* instructions, uint32_t alignment, SpasmAlignPadding padding)
+{
+    if(alignment == 0 || alignment > SPASM_MAX_CODE_ALIGNMENT || (alignment & (alignment - 1)) != 0)
+    {
+        spasm_context_report_code(instructions->ctx, SpasmErrorCode_InvalidAlignment, NULL, 0);
+        return false;
     }
 
-    va_end(args);
+    SpasmInstruction* instr = __spasm_instructions_push_record(instructions, SpasmMnemonic_Align, 2);
+
+    if(instr == NULL)
+        return false;
+
+    instr->operands[0] = SpasmOpImm16(alignment);
+    instr->operands[1] = SpasmOpImm8(padding);
 
-    vector_push_back(&instructions->instructions, &instr);
+    instructions->num_paddings++;
 
     return true;
 }
 
+bool __spasm_instructions_push(SpasmInstructions* instructions,
+                               SpasmMnemonic mnemonic,
+                               uint8_t num_operands,
+                               ...)
+{
+    va_list args;
+    va_start(args, num_operands);
+
+    bool res = spasm_instructions_push_va(instructions, mnemonic, num_operands, args);
+
+    va_end(args);
+
+    return res;
+}
+
+bool __spasm_instructions_push_back(SpasmInstructions* instructions,
+                                    const char* mnemonic,
+                                    uint8_t mnemonic_len,
+                                    uint8_t num_operands,
+                                    ...)
+{
+    const SpasmMnemonic mnemonic_id = spasm_mnemonic_from_string(mnemonic, mnemonic_len);
+
+    if(mnemonic_id == SpasmMnemonic_Invalid)
+    {
+        spasm_context_report_code(instructions->ctx,
+                                  SpasmErrorCode_UnknownMnemonic,
+                                  mnemonic,
+                                  mnemonic_len);
+        return false;
+    }
+
+    va_list args;
+    va_start(args, num_operands);
+
+    bool res = spasm_instructions_push_va(instructions, mnemonic_id, num_operands, args);
+
+    va_end(args);
+
+    return res;
+}
+
 /* x86_64 */
 
 #if defined(SPASM_ENABLE_X86_64)
@@ -140,12 +286,18 @@ void spasm_instructions_debug(SpasmInstructions* instructions,
             break;
 #endif /* defined(SPASM_ENABLE_AARCH64) */
         default:
-            spasm_error("Cannot debug instructions: abi not supported");
+        {
+            const char* abi_name = spasm_get_abi_as_string(abi);
+            spasm_context_report_code(instructions->ctx,
+                                      SpasmErrorCode_UnsupportedABI,
+                                      abi_name,
+                                      strlen(abi_name));
 #if defined(SPASM_MSVC)
             _write(fd, "spasm_instructions_debug error: abi not supported", 50);
 #elif defined(SPASM_GCC) || defined(SPASM_CLANG)
             write(fd, "spasm_instructions_debug error: abi not supported", 50);
 #endif /* defined(SPASM_MSVC) */
             break;
+        }
     }
 }
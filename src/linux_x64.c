@@ -19,11 +19,9 @@ bool spasm_linux_x64_assembler(SpasmInstructions* instructions, SpasmByteCode* b
 
 bool spasm_linux_x64_jit(SpasmInstructions* instructions, SpasmByteCode* bytecode, SpasmData* data)
 {
-    (void)data;
-
-    for(size_t i = 0; i < vector_size(&instructions->instructions); i++)
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
     {
-        SpasmInstruction* instr = *(SpasmInstruction**)vector_at(&instructions->instructions, i);
+        SpasmInstruction* instr = spasm_instructions_at(instructions, i);
 
         SpasmOperand* data_operand = spasm_instruction_has_data_operand(instr);
 
@@ -34,14 +32,9 @@ bool spasm_linux_x64_jit(SpasmInstructions* instructions, SpasmByteCode* bytecod
             data_operand->type = SpasmOperandType_Imm64;
             data_operand->imm_value = spasm_data_get_jit_address(data, data_id);
         }
-
-        if(!spasm_x86_64_encode_instruction(instr, bytecode))
-        {
-            return false;
-        }
     }
 
-    return true;
+    return spasm_x86_64_encode_instructions(instructions->ctx, instructions, bytecode, NULL);
 }
 
 #endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/mnemonic.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+#include "spasm/x86_64.h"
+
+extern const Spasm_x86_64_MnemonicInfo spasm_x86_64_mnemonic_table[SPASM_X86_64_NUM_MNEMONICS + 1];
+
+/* Binary search in the sorted mnemonic table */
+static SpasmMnemonic spasm_x86_64_mnemonic_from_string(const char* s, size_t s_sz)
+{
+    size_t low = 1;
+    size_t high = SPASM_X86_64_NUM_MNEMONICS + 1;
+
+    while(low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+        const Spasm_x86_64_MnemonicInfo* info = &spasm_x86_64_mnemonic_table[mid];
+
+        const size_t cmp_sz = s_sz < info->name_len ? s_sz : info->name_len;
+
+        int cmp = memcmp(s, info->name, cmp_sz);
+
+        if(cmp == 0)
+            cmp = (s_sz > info->name_len) - (s_sz < info->name_len);
+
+        if(cmp == 0)
+            return (SpasmMnemonic)mid;
+
+        if(cmp < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return SpasmMnemonic_Invalid;
+}
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+/* Pseudo-instructions, from SpasmMnemonic_Label */
+static const char* spasm_pseudo_mnemonics[SpasmMnemonic_COUNT - SpasmMnemonic_Label] = {
+    "label",
+    "align",
+    "boundary",
+};
+
+SpasmMnemonic spasm_mnemonic_from_string(const char* s, size_t s_sz)
+{
+    SPASM_ASSERT(s != NULL, "s is NULL");
+
+#if defined(SPASM_ENABLE_X86_64)
+    const SpasmMnemonic mnemonic = spasm_x86_64_mnemonic_from_string(s, s_sz);
+
+    if(mnemonic != SpasmMnemonic_Invalid)
+        return mnemonic;
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+    for(size_t i = 0; i < SpasmMnemonic_COUNT - SpasmMnemonic_Label; i++)
+        if(strlen(spasm_pseudo_mnemonics[i]) == s_sz && memcmp(spasm_pseudo_mnemonics[i], s, s_sz) == 0)
+            return (SpasmMnemonic)(SpasmMnemonic_Label + i);
+
+    return SpasmMnemonic_Invalid;
+}
+
+const char* spasm_mnemonic_as_string(SpasmMnemonic mnemonic)
+{
+#if defined(SPASM_ENABLE_X86_64)
+    if((size_t)mnemonic <= SPASM_X86_64_NUM_MNEMONICS)
+        return spasm_x86_64_mnemonic_table[mnemonic].name;
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+    if(mnemonic >= SpasmMnemonic_Label && mnemonic < SpasmMnemonic_COUNT)
+        return spasm_pseudo_mnemonics[mnemonic - SpasmMnemonic_Label];
+
+    return "";
+}
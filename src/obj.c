@@ -6,6 +6,8 @@
 #include "spasm/error.h"
 #include "spasm/windows/coff.h"
 
+#include <string.h>
+
 SpasmObjType spasm_abi_to_obj_type(SpasmABI abi)
 {
     switch(abi)
@@ -57,30 +59,34 @@ bool spasm_obj_write_file(const char* filename,
         }
         default:
         {
-            spasm_error("Unsupported ABI: %s", spasm_get_abi_as_string(abi));
+            const char* abi_name = spasm_get_abi_as_string(abi);
+            spasm_context_report_code(data->ctx,
+                                      SpasmErrorCode_UnsupportedABI,
+                                      abi_name,
+                                      strlen(abi_name));
             return false;
         }
     }
 
-    if(data == NULL)
+    if(out_data == NULL)
         return false;
 
     FILE* f = fopen(filename, "wb");
 
     if(f == NULL)
     {
-        spasm_error("Cannot open file: %s", filename);
-        free(out_data);
+        spasm_context_report_code(data->ctx, SpasmErrorCode_FileOpen, filename, strlen(filename));
+        spasm_allocator_free(spasm_context_get_allocator(data->ctx), out_data, out_sz);
         return -1;
     }
 
     size_t written = fwrite(out_data, 1, out_sz, f);
 
     if(written != out_sz)
-        spasm_error("Cannot write to file: %s", filename);
+        spasm_context_report_code(data->ctx, SpasmErrorCode_FileWrite, filename, strlen(filename));
 
     fclose(f);
-    free(out_data);
+    spasm_allocator_free(spasm_context_get_allocator(data->ctx), out_data, out_sz);
 
     return written == out_sz;
 }
@@ -2,8 +2,23 @@
 /* Copyright (c) 2025 - Present Romain Augier */
 /* All rights reserved. */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* memfd_create */
+#endif /* defined(__linux__) && !defined(_GNU_SOURCE) */
+
 #include "spasm/platform.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(SPASM_WIN)
+#include <Windows.h>
+#elif defined(SPASM_LINUX) || defined(SPASM_MACOS)
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif /* defined(SPASM_WIN) */
+
 SpasmPlatform spasm_get_current_platform()
 {
 #if defined(SPASM_WIN)
@@ -53,4 +68,157 @@ const char* spasm_get_isa_as_string(SpasmISA isa)
 
         default: return "invalid";
     }
-}
\ No newline at end of file
+}
+
+uint32_t spasm_get_num_cpus(void)
+{
+#if defined(SPASM_WIN)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (uint32_t)info.dwNumberOfProcessors;
+#else
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return num_cpus > 0 ? (uint32_t)num_cpus : 1;
+#endif /* defined(SPASM_WIN) */
+}
+
+uint64_t spasm_get_timestamp_ns(void)
+{
+#if defined(SPASM_WIN)
+    static LARGE_INTEGER frequency = { 0 };
+
+    if(frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)((double)counter.QuadPart * (1000000000.0 / (double)frequency.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif /* defined(SPASM_WIN) */
+}
+
+size_t spasm_get_page_size(void)
+{
+#if defined(SPASM_WIN)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (size_t)info.dwPageSize;
+#else
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    return page_size > 0 ? (size_t)page_size : 4096;
+#endif /* defined(SPASM_WIN) */
+}
+
+bool spasm_executable_memory_alloc(SpasmExecutableMemory* memory, size_t size)
+{
+    SPASM_ASSERT(memory != NULL, "memory is NULL");
+
+    memset(memory, 0, sizeof(SpasmExecutableMemory));
+
+    const size_t page_size = spasm_get_page_size();
+    size = (size + page_size - 1) & ~(page_size - 1);
+
+    if(size == 0)
+        return false;
+
+#if defined(SPASM_WIN)
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE,
+                                        NULL,
+                                        PAGE_EXECUTE_READWRITE,
+                                        (DWORD)((uint64_t)size >> 32),
+                                        (DWORD)size,
+                                        NULL);
+
+    if(mapping == NULL)
+        return false;
+
+    void* writable = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    void* executable = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, size);
+
+    /* The views keep the section alive */
+    CloseHandle(mapping);
+
+    if(writable == NULL || executable == NULL)
+    {
+        if(writable != NULL)
+            UnmapViewOfFile(writable);
+
+        if(executable != NULL)
+            UnmapViewOfFile(executable);
+
+        return false;
+    }
+#elif defined(SPASM_LINUX)
+    int fd = memfd_create("spasm_code", MFD_CLOEXEC);
+
+    if(fd < 0)
+        return false;
+
+    if(ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* writable = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void* executable = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+
+    /* The mappings keep the file alive */
+    close(fd);
+
+    if(writable == MAP_FAILED || executable == MAP_FAILED)
+    {
+        if(writable != MAP_FAILED)
+            munmap(writable, size);
+
+        if(executable != MAP_FAILED)
+            munmap(executable, size);
+
+        return false;
+    }
+#elif defined(SPASM_MACOS)
+    void* writable = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    if(writable == MAP_FAILED)
+        return false;
+
+    void* executable = writable;
+#else
+    return false;
+#endif /* defined(SPASM_WIN) */
+
+    memory->writable = (uint8_t*)writable;
+    memory->executable = (uint8_t*)executable;
+    memory->size = size;
+
+    return true;
+}
+
+void spasm_executable_memory_release(SpasmExecutableMemory* memory)
+{
+    SPASM_ASSERT(memory != NULL, "memory is NULL");
+
+    if(memory->size == 0)
+        return;
+
+#if defined(SPASM_WIN)
+    UnmapViewOfFile(memory->writable);
+    UnmapViewOfFile(memory->executable);
+#elif defined(SPASM_LINUX) || defined(SPASM_MACOS)
+    if(memory->executable != memory->writable)
+        munmap(memory->executable, memory->size);
+
+    munmap(memory->writable, memory->size);
+#endif /* defined(SPASM_WIN) */
+
+    memset(memory, 0, sizeof(SpasmExecutableMemory));
+}
@@ -4,7 +4,22 @@
 
 #include "spasm/register.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+extern const char* spasm_x86_64_get_register_as_string(SpasmRegister reg);
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
 SpasmRegister spasm_register_from_string(const char* s)
 {
+    SPASM_ASSERT(s != NULL, "s is NULL");
+
+#if defined(SPASM_ENABLE_X86_64)
+    for(int reg = SpasmRegister_x86_64_AL; reg <= SpasmRegister_x86_64_RIP; reg++)
+        if(strcmp(spasm_x86_64_get_register_as_string((SpasmRegister)reg), s) == 0)
+            return (SpasmRegister)reg;
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
     return SpasmRegister_Invalid;
 }
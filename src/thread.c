@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/thread.h"
+
+#include <stdlib.h>
+
+#if defined(SPASM_WIN)
+#include <Windows.h>
+#elif defined(SPASM_LINUX) || defined(SPASM_MACOS)
+#include <pthread.h>
+#include <sched.h>
+#endif /* defined(SPASM_WIN) */
+
+#if defined(SPASM_WIN)
+static DWORD WINAPI spasm_thread_entry(LPVOID arg)
+{
+    SpasmThread* thread = (SpasmThread*)arg;
+    thread->func(thread->arg);
+
+    return 0;
+}
+#else
+static void* spasm_thread_entry(void* arg)
+{
+    SpasmThread* thread = (SpasmThread*)arg;
+    thread->func(thread->arg);
+
+    return NULL;
+}
+#endif /* defined(SPASM_WIN) */
+
+bool spasm_thread_start(SpasmThread* thread, SpasmThreadFunc func, void* arg)
+{
+    SPASM_ASSERT(thread != NULL, "thread is NULL");
+    SPASM_ASSERT(func != NULL, "func is NULL");
+
+    thread->func = func;
+    thread->arg = arg;
+
+#if defined(SPASM_WIN)
+    thread->handle = (void*)CreateThread(NULL, 0, spasm_thread_entry, thread, 0, NULL);
+
+    return thread->handle != NULL;
+#else
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+
+    if(handle == NULL)
+        return false;
+
+    if(pthread_create(handle, NULL, spasm_thread_entry, thread) != 0)
+    {
+        free(handle);
+        thread->handle = NULL;
+        return false;
+    }
+
+    thread->handle = (void*)handle;
+
+    return true;
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_thread_join(SpasmThread* thread)
+{
+    SPASM_ASSERT(thread != NULL, "thread is NULL");
+
+    if(thread->handle == NULL)
+        return;
+
+#if defined(SPASM_WIN)
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+#else
+    pthread_join(*(pthread_t*)thread->handle, NULL);
+    free(thread->handle);
+#endif /* defined(SPASM_WIN) */
+
+    thread->handle = NULL;
+}
+
+void spasm_thread_yield(void)
+{
+#if defined(SPASM_WIN)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif /* defined(SPASM_WIN) */
+}
+
+/* Mutex */
+
+bool spasm_mutex_init(SpasmMutex* mutex)
+{
+    SPASM_ASSERT(mutex != NULL, "mutex is NULL");
+
+#if defined(SPASM_WIN)
+    SRWLOCK* lock = (SRWLOCK*)malloc(sizeof(SRWLOCK));
+
+    if(lock == NULL)
+        return false;
+
+    InitializeSRWLock(lock);
+    mutex->handle = (void*)lock;
+#else
+    pthread_mutex_t* lock = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+
+    if(lock == NULL)
+        return false;
+
+    if(pthread_mutex_init(lock, NULL) != 0)
+    {
+        free(lock);
+        return false;
+    }
+
+    mutex->handle = (void*)lock;
+#endif /* defined(SPASM_WIN) */
+
+    return true;
+}
+
+void spasm_mutex_lock(SpasmMutex* mutex)
+{
+#if defined(SPASM_WIN)
+    AcquireSRWLockExclusive((SRWLOCK*)mutex->handle);
+#else
+    pthread_mutex_lock((pthread_mutex_t*)mutex->handle);
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_mutex_unlock(SpasmMutex* mutex)
+{
+#if defined(SPASM_WIN)
+    ReleaseSRWLockExclusive((SRWLOCK*)mutex->handle);
+#else
+    pthread_mutex_unlock((pthread_mutex_t*)mutex->handle);
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_mutex_release(SpasmMutex* mutex)
+{
+    if(mutex->handle == NULL)
+        return;
+
+#if !defined(SPASM_WIN)
+    pthread_mutex_destroy((pthread_mutex_t*)mutex->handle);
+#endif /* !defined(SPASM_WIN) */
+
+    free(mutex->handle);
+    mutex->handle = NULL;
+}
+
+/* Condition variable */
+
+bool spasm_condvar_init(SpasmCondVar* condvar)
+{
+    SPASM_ASSERT(condvar != NULL, "condvar is NULL");
+
+#if defined(SPASM_WIN)
+    CONDITION_VARIABLE* cond = (CONDITION_VARIABLE*)malloc(sizeof(CONDITION_VARIABLE));
+
+    if(cond == NULL)
+        return false;
+
+    InitializeConditionVariable(cond);
+    condvar->handle = (void*)cond;
+#else
+    pthread_cond_t* cond = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
+
+    if(cond == NULL)
+        return false;
+
+    if(pthread_cond_init(cond, NULL) != 0)
+    {
+        free(cond);
+        return false;
+    }
+
+    condvar->handle = (void*)cond;
+#endif /* defined(SPASM_WIN) */
+
+    return true;
+}
+
+void spasm_condvar_wait(SpasmCondVar* condvar, SpasmMutex* mutex)
+{
+#if defined(SPASM_WIN)
+    SleepConditionVariableSRW((CONDITION_VARIABLE*)condvar->handle,
+                              (SRWLOCK*)mutex->handle,
+                              INFINITE,
+                              0);
+#else
+    pthread_cond_wait((pthread_cond_t*)condvar->handle, (pthread_mutex_t*)mutex->handle);
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_condvar_signal(SpasmCondVar* condvar)
+{
+#if defined(SPASM_WIN)
+    WakeConditionVariable((CONDITION_VARIABLE*)condvar->handle);
+#else
+    pthread_cond_signal((pthread_cond_t*)condvar->handle);
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_condvar_broadcast(SpasmCondVar* condvar)
+{
+#if defined(SPASM_WIN)
+    WakeAllConditionVariable((CONDITION_VARIABLE*)condvar->handle);
+#else
+    pthread_cond_broadcast((pthread_cond_t*)condvar->handle);
+#endif /* defined(SPASM_WIN) */
+}
+
+void spasm_condvar_release(SpasmCondVar* condvar)
+{
+    if(condvar->handle == NULL)
+        return;
+
+#if !defined(SPASM_WIN)
+    pthread_cond_destroy((pthread_cond_t*)condvar->handle);
+#endif /* !defined(SPASM_WIN) */
+
+    free(condvar->handle);
+    condvar->handle = NULL;
+}
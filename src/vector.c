@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/vector.h"
+
+#include <stdlib.h>
+
+bool spasm_vector_init(SpasmVector* vector,
+                       size_t capacity,
+                       size_t element_size,
+                       const SpasmAllocator* allocator)
+{
+    SPASM_ASSERT(vector != NULL, "vector is NULL");
+    SPASM_ASSERT(element_size > 0, "element_size is 0");
+
+    vector->data = NULL;
+    vector->size = 0;
+    vector->capacity = 0;
+    vector->element_size = element_size;
+    vector->allocator = allocator != NULL ? allocator : spasm_get_default_allocator();
+
+    return spasm_vector_reserve(vector, capacity);
+}
+
+bool spasm_vector_reserve(SpasmVector* vector, size_t capacity)
+{
+    SPASM_ASSERT(vector != NULL, "vector is NULL");
+
+    if(capacity <= vector->capacity)
+        return true;
+
+    void* data = NULL;
+
+    if(vector->data == NULL)
+        data = spasm_allocator_alloc(vector->allocator, capacity * vector->element_size);
+    else
+        data = spasm_allocator_realloc(vector->allocator,
+                                       vector->data,
+                                       vector->capacity * vector->element_size,
+                                       capacity * vector->element_size);
+
+    if(data == NULL)
+        return false;
+
+    vector->data = data;
+    vector->capacity = capacity;
+
+    return true;
+}
+
+void* spasm_vector_push_back_n(SpasmVector* vector, const void* elements, size_t count)
+{
+    SPASM_ASSERT(vector != NULL, "vector is NULL");
+
+    if(vector->size + count > vector->capacity)
+    {
+        size_t new_capacity = vector->capacity < 8 ? 8 : vector->capacity * 2;
+
+        while(new_capacity < vector->size + count)
+            new_capacity *= 2;
+
+        if(!spasm_vector_reserve(vector, new_capacity))
+            return NULL;
+    }
+
+    void* first = (char*)vector->data + vector->size * vector->element_size;
+
+    if(elements != NULL)
+        memcpy(first, elements, count * vector->element_size);
+
+    vector->size += count;
+
+    return first;
+}
+
+void spasm_vector_release(SpasmVector* vector)
+{
+    SPASM_ASSERT(vector != NULL, "vector is NULL");
+
+    spasm_allocator_free(vector->allocator, vector->data, vector->capacity * vector->element_size);
+
+    vector->data = NULL;
+    vector->size = 0;
+    vector->capacity = 0;
+}
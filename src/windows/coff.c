@@ -117,7 +117,7 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
 
     if(code == NULL)
     {
-        spasm_error("Error during COFF output: invalid bytecode");
+        spasm_context_report_code(data->ctx, SpasmErrorCode_InvalidByteCode, NULL, 0);
         return NULL;
     }
 
@@ -139,7 +139,7 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
     while(spasm_data_iterate_extern_symbols(data, &extern_it))
     {
         string_table_size += extern_it.name_sz >= 8 ? (size_t)extern_it.name_sz + 1 : 0;
-        num_relocs += vector_size(extern_it.symbol->refs);
+        num_relocs += spasm_vector_size(&extern_it.symbol->refs);
     }
 
     SpasmDataExportSymbolIterator export_it;
@@ -148,7 +148,7 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
     while(spasm_data_iterate_export_symbols(data, &export_it))
     {
         string_table_size += export_it.name_sz >= 8 ? (size_t)export_it.name_sz  + 1: 0;
-        num_relocs += vector_size(export_it.symbol->refs);
+        num_relocs += spasm_vector_size(&export_it.symbol->refs);
     }
 
     size_t header_offset = 0;
@@ -162,14 +162,16 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
                            (num_symbols * sizeof(SpasmCoffSymbol));
     size_t total_size = string_offset + string_table_size;
 
-    uint8_t* output = calloc(1, total_size);
+    uint8_t* output = (uint8_t*)spasm_allocator_alloc(spasm_context_get_allocator(data->ctx), total_size);
 
     if(!output)
     {
-        spasm_error("Error during COFF output: failed to allocate output buffer");
+        spasm_context_report_code(data->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
         return NULL;
     }
 
+    memset(output, 0, total_size);
+
     SpasmCoffHeader* header = (SpasmCoffHeader*)(output + header_offset);
     header->machine = machine;
     header->number_of_sections = num_sections;
@@ -209,9 +211,9 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
     {
         uint32_t symbol_index = global_symbol_index + export_it.symbol->index;
 
-        for(size_t i = 0; i < vector_size(export_it.symbol->refs); i++)
+        for(size_t i = 0; i < spasm_vector_size(&export_it.symbol->refs); i++)
         {
-            SpasmExportSymbolRef* ref = (SpasmExportSymbolRef*)vector_at(export_it.symbol->refs, i);
+            SpasmExportSymbolRef* ref = (SpasmExportSymbolRef*)spasm_vector_at(&export_it.symbol->refs, i);
 
             relocs[reloc_idx].virtual_address = (uint32_t)ref->offset;
             relocs[reloc_idx].symbol_table_index = symbol_index;
@@ -256,9 +258,9 @@ uint8_t* spasm_generate_coff(SpasmByteCode* bytecode,
     {
         uint32_t symbol_index = global_symbol_index + extern_it.symbol->index;
 
-        for(size_t i = 0; i < vector_size(extern_it.symbol->refs); i++)
+        for(size_t i = 0; i < spasm_vector_size(&extern_it.symbol->refs); i++)
         {
-            SpasmExternSymbolRef* ref = (SpasmExternSymbolRef*)vector_at(extern_it.symbol->refs, i);
+            SpasmExternSymbolRef* ref = (SpasmExternSymbolRef*)spasm_vector_at(&extern_it.symbol->refs, i);
 
             relocs[reloc_idx].virtual_address = (uint32_t)ref->offset;
             relocs[reloc_idx].symbol_table_index = symbol_index;
@@ -8,39 +8,88 @@
 #include "spasm/data.h"
 #include "spasm/error.h"
 
+#include <string.h>
+
 /* Assembler */
 
 bool spasm_windows_x64_assembler(SpasmInstructions* instructions,
                                  SpasmByteCode* bytecode,
                                  SpasmData* data)
 {
-    for(size_t i = 0; i < vector_size(&instructions->instructions); i++)
+    const SpasmAllocator* allocator = spasm_context_get_allocator(instructions->ctx);
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    /* Symbol operands are encoded as a zero rel32, patched by the linker */
+    const char** sym_names = NULL;
+
+    for(size_t i = 0; i < num_instructions; i++)
     {
-        SpasmInstruction* instr = *(SpasmInstruction**)vector_at(&instructions->instructions, i);
+        SpasmInstruction* instr = spasm_instructions_at(instructions, i);
 
         SpasmOperand* sym_op = spasm_instruction_has_symbol_operand(instr);
-        const char* sym_name = NULL;
 
         if(sym_op != NULL)
         {
-            sym_name = sym_op->symbol_name;
+            if(sym_names == NULL)
+            {
+                sym_names = (const char**)spasm_allocator_alloc(allocator,
+                                                                num_instructions * sizeof(const char*));
+
+                if(sym_names == NULL)
+                {
+                    spasm_context_report_code(instructions->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+                    return false;
+                }
+
+                memset(sym_names, 0, num_instructions * sizeof(const char*));
+            }
+
+            sym_names[i] = sym_op->symbol_name;
 
             sym_op->type = SpasmOperandType_Imm32;
             sym_op->imm_value = 0;
         }
+    }
 
-        if(!spasm_x86_64_encode_instruction(instr, bytecode))
+    size_t* instr_end_offsets = NULL;
+
+    if(sym_names != NULL)
+    {
+        instr_end_offsets = (size_t*)spasm_allocator_alloc(allocator, num_instructions * sizeof(size_t));
+
+        if(instr_end_offsets == NULL)
         {
+            spasm_context_report_code(instructions->ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            spasm_allocator_free(allocator, sym_names, num_instructions * sizeof(const char*));
             return false;
         }
+    }
 
-        if(sym_name != NULL)
+    bool res = spasm_x86_64_encode_instructions(instructions->ctx,
+                                                instructions,
+                                                bytecode,
+                                                instr_end_offsets);
+
+    /* Relocations, the rel32 is the last 4 bytes of the instruction */
+    if(res && sym_names != NULL)
+    {
+        for(size_t i = 0; i < num_instructions; i++)
         {
-            size_t offset = spasm_bytecode_size(bytecode) - 4;
-            spasm_data_add_extern_symbol(data, sym_name, 0, offset, SpasmReloctype_REL32);
+            if(sym_names[i] != NULL)
+            {
+                size_t offset = instr_end_offsets[i] - 4;
+                spasm_data_add_extern_symbol(data, sym_names[i], 0, offset, SpasmReloctype_REL32);
+            }
         }
     }
 
+    spasm_allocator_free(allocator, instr_end_offsets, num_instructions * sizeof(size_t));
+    spasm_allocator_free(allocator, sym_names, num_instructions * sizeof(const char*));
+
+    if(!res)
+        return false;
+
     if(spasm_data_num_exports(data) == 0)
     {
         spasm_warning("Could not find any exported symbol, adding symbol main starting at offset 0x0");
@@ -57,24 +106,7 @@ bool spasm_windows_x64_jit(SpasmInstructions* instructions, SpasmByteCode* bytec
 {
     (void)data;
 
-    for(size_t i = 0; i < vector_size(&instructions->instructions); i++)
-    {
-        SpasmInstruction* instr = *(SpasmInstruction**)vector_at(&instructions->instructions, i);
-
-        SpasmOperand* sym_op = spasm_instruction_has_symbol_operand(instr);
-
-        if(sym_op != NULL)
-        {
-
-        }
-
-        if(!spasm_x86_64_encode_instruction(instr, bytecode))
-        {
-            return false;
-        }
-    }
-
-    return true;
+    return spasm_x86_64_encode_instructions(instructions->ctx, instructions, bytecode, NULL);
 }
 
 #endif /* defined(SPASM_ENABLE_X86_64) */
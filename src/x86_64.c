@@ -9,7 +9,11 @@
 #include "spasm/operand.h"
 #include "spasm/register.h"
 #include "spasm/error.h"
+#include "spasm/thread.h"
 
+#include "x86_64_internal.h"
+
+#include <stdlib.h>
 #include <string.h>
 
 #if defined(SPASM_MSVC)
@@ -23,12 +27,16 @@
 /* Generated table */
 extern const Spasm_x86_64_InstructionInfo spasm_x86_64_instruction_table[];
 extern const size_t spasm_x86_64_instruction_table_size;
+extern const Spasm_x86_64_MnemonicInfo spasm_x86_64_mnemonic_table[];
+extern const Spasm_x86_64_FormAccess spasm_x86_64_form_access_table[];
+extern const uint8_t spasm_x86_64_form_cost_class_table[];
+extern const Spasm_x86_64_UarchProfile spasm_x86_64_uarch_profiles[];
 
 /* Debug funcs */
 
 const char* spasm_x86_64_get_register_as_string(SpasmRegister reg)
 {
-    SPASM_ASSERT(reg >= SpasmRegister_x86_64_NONE && reg < SpasmRegister_x86_64_COUNT,
+    SPASM_ASSERT(reg >= SpasmRegister_x86_64_NONE && reg <= SpasmRegister_x86_64_RIP,
                  "reg is not an x86_64 register");
 
     switch(reg)
@@ -169,7 +177,24 @@ size_t spasm_x86_64_operand_debug(SpasmOperand* operand, char* fmt_buf, size_t m
                                     "%s",
                                     spasm_x86_64_get_register_as_string(operand->reg));
         case SpasmOperandType_Mem:
-            if(operand->mem_index == 0)
+            if(operand->mem_reg == SPASM_VIRTUAL_REGISTER)
+            {
+                if(operand->mem_index == SPASM_VIRTUAL_REGISTER)
+                    return (size_t)snprintf(fmt_buf,
+                                            max_fmt_sz,
+                                            "[v%u + v%u * %d + %d]",
+                                            operand->mem_vregs.base,
+                                            operand->mem_vregs.index,
+                                            (int32_t)operand->mem_scale,
+                                            operand->mem_displacement);
+
+                return (size_t)snprintf(fmt_buf,
+                                        max_fmt_sz,
+                                        "[v%u + %d]",
+                                        operand->mem_vregs.base,
+                                        operand->mem_displacement);
+            }
+            else if(operand->mem_index == 0)
             {
                 if(operand->mem_displacement == 0)
                     return (size_t)snprintf(fmt_buf,
@@ -210,6 +235,10 @@ size_t spasm_x86_64_operand_debug(SpasmOperand* operand, char* fmt_buf, size_t m
             return (size_t)snprintf(fmt_buf, max_fmt_sz, "0x%zx", operand->imm_value);
         case SpasmOperandType_Symbol:
             return (size_t)snprintf(fmt_buf, max_fmt_sz, "%s", operand->symbol_name);
+        case SpasmOperandType_Label:
+            return (size_t)snprintf(fmt_buf, max_fmt_sz, "L%u", operand->label);
+        case SpasmOperandType_VirtualRegister:
+            return (size_t)snprintf(fmt_buf, max_fmt_sz, "v%u", operand->vreg);
         default:
             return (size_t)snprintf(fmt_buf, max_fmt_sz, "???");
     }
@@ -224,11 +253,28 @@ size_t spasm_x86_64_instruction_debug(SpasmInstruction* instr, char* fmt_buf, si
 {
     size_t sz = 0;
 
+    if(instr->mnemonic == SpasmMnemonic_Label)
+        return (size_t)snprintf(fmt_buf, max_fmt_sz, "L%u:", instr->operands[0].label);
+
+    if(instr->mnemonic == SpasmMnemonic_Align)
+        return (size_t)snprintf(fmt_buf,
+                                max_fmt_sz,
+                                "align %u%s",
+                                (uint32_t)instr->operands[0].imm_value,
+                                instr->operands[1].imm_value == SpasmAlignPadding_Prefixes ? ", prefixes" : "");
+
+    if(instr->mnemonic == SpasmMnemonic_Boundary)
+        return (size_t)snprintf(fmt_buf,
+                                max_fmt_sz,
+                                "boundary %u, %u%s",
+                                (uint32_t)instr->operands[0].imm_value,
+                                (uint32_t)instr->operands[2].imm_value,
+                                instr->operands[1].imm_value == SpasmAlignPadding_Prefixes ? ", prefixes" : "");
+
     sz += (size_t)snprintf(fmt_buf + sz,
                            max_fmt_sz - sz,
-                           "%.*s ",
-                           instr->mnemonic_len,
-                           instr->mnemonic);
+                           "%s ",
+                           spasm_mnemonic_as_string((SpasmMnemonic)instr->mnemonic));
 
     for(uint8_t i = 0; i < instr->num_operands; i++)
     {
@@ -241,20 +287,33 @@ size_t spasm_x86_64_instruction_debug(SpasmInstruction* instr, char* fmt_buf, si
 
 void spasm_x86_64_instructions_debug(SpasmInstructions* instructions, int32_t fd)
 {
+    const SpasmAllocator* allocator = spasm_context_get_allocator(instructions->ctx);
+
     size_t buffer_size = 0;
     size_t buffer_capacity = 1024;
-    char* buffer = (char*)malloc(buffer_capacity);
+    char* buffer = (char*)spasm_allocator_alloc(allocator, buffer_capacity);
+
+    if(buffer == NULL)
+        return;
 
-    for(size_t i = 0; i < vector_size(&instructions->instructions); i++)
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
     {
-        SpasmInstruction* instr = *(SpasmInstruction**)vector_at(&instructions->instructions, i);
+        SpasmInstruction* instr = spasm_instructions_at(instructions, i);
 
         buffer_size += spasm_x86_64_instruction_debug(instr, buffer + buffer_size, 128);
 
         if(buffer_size >= ((size_t)((float)buffer_capacity * 0.90f)))
         {
+            char* new_buffer = (char*)spasm_allocator_realloc(allocator,
+                                                              buffer,
+                                                              buffer_capacity,
+                                                              buffer_capacity << 1);
+
+            if(new_buffer == NULL)
+                break;
+
+            buffer = new_buffer;
             buffer_capacity <<= 1;
-            buffer = (char*)realloc(buffer, buffer_capacity);
         }
 
         snprintf(buffer + buffer_size, 3, "\n\r");
@@ -268,7 +327,7 @@ void spasm_x86_64_instructions_debug(SpasmInstructions* instructions, int32_t fd
     write(fd, buffer, buffer_size);
 #endif /* defined(SPASM_MSVC) */
 
-    free(buffer);
+    spasm_allocator_free(allocator, buffer, buffer_capacity);
 }
 
 /* Encoding funcs */
@@ -328,7 +387,7 @@ SPASM_FORCE_INLINE size_t spasm_x86_64_get_register_size(SpasmRegister reg)
     return 8 << ((reg - 1) / 16);
 }
 
-size_t spasm_x86_64_get_operand_size(SpasmOperand* operand, size_t default_value)
+static size_t spasm_x86_64_get_operand_size(SpasmOperand* operand, size_t default_value)
 {
     switch(operand->type)
     {
@@ -349,14 +408,14 @@ size_t spasm_x86_64_get_operand_size(SpasmOperand* operand, size_t default_value
     }
 }
 
-bool spasm_x86_64_needs_rex(SpasmInstruction* instr)
+static bool spasm_x86_64_needs_rex(SpasmInstruction* instr)
 {
     bool needs_rex = false;
 
     for(int i = 0; i < instr->num_operands; i++)
     {
-        needs_rex = instr->operands[i].type == SpasmOperandType_Register &&
-                    spasm_x86_64_get_register_code(instr->operands[i].reg) > 7;
+        needs_rex |= instr->operands[i].type == SpasmOperandType_Register &&
+                     spasm_x86_64_get_register_code(instr->operands[i].reg) > 7;
     }
 
     return needs_rex;
@@ -368,6 +427,64 @@ typedef struct
     uint32_t len;
 } Spasm_x86_64_PrefixBytes;
 
+/* Near branches, push and pop default to 64-bit operands in long mode, without REX.W */
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_default_64(uint16_t mnemonic)
+{
+    return mnemonic == SpasmMnemonic_x86_64_PUSH ||
+           mnemonic == SpasmMnemonic_x86_64_POP ||
+           mnemonic == SpasmMnemonic_x86_64_CALL ||
+           mnemonic == SpasmMnemonic_x86_64_JMP;
+}
+
+typedef enum
+{
+    Spasm_x86_64_RegisterField_None,
+    Spasm_x86_64_RegisterField_Reg, /* ModR/M.reg, extended by REX.R */
+    Spasm_x86_64_RegisterField_Rm, /* ModR/M.rm or the register added to the opcode, extended by REX.B */
+} Spasm_x86_64_RegisterField;
+
+/*
+    Field holding the register operand i of a legacy (REX) form, as spasm_x86_64_operands_as_modrm_sib_offset
+    places it. ModR/M.rm holds the operand modrm_rm_operand, ModR/M.reg the other one of the first two
+    operands, or the digit of /digit forms (a second register operand is then implicit, like cl for
+    shifts)
+*/
+static Spasm_x86_64_RegisterField spasm_x86_64_legacy_register_field(const Spasm_x86_64_InstructionInfo* info,
+                                                                     uint8_t i)
+{
+    if(info->reg_in_opcode)
+        return i == 0 ? Spasm_x86_64_RegisterField_Rm : Spasm_x86_64_RegisterField_None;
+
+    if(!info->reg_in_modrm_rm || i > 1)
+        return Spasm_x86_64_RegisterField_None;
+
+    if(i == info->modrm_rm_operand)
+        return Spasm_x86_64_RegisterField_Rm;
+
+    return info->reg_in_modrm_reg ? Spasm_x86_64_RegisterField_None : Spasm_x86_64_RegisterField_Reg;
+}
+
+/*
+    16 bits operand size, selected by a 66 prefix: the general purpose forms of a 16 bits register or
+    immediate destination, the memory destination forms of a 16 bits register source, and crc32 of a
+    16 bits source
+*/
+static bool spasm_x86_64_is_operand_size_16(const Spasm_x86_64_InstructionInfo* info)
+{
+    if(info->operand_types[0] == SpasmOperandType_Register && info->operand_sizes[0] == 16)
+        return true;
+
+    if(info->operand_types[0] == SpasmOperandType_Mem && info->operand_types[1] == SpasmOperandType_Imm16)
+        return true;
+
+    if(info->operand_types[0] == SpasmOperandType_Mem &&
+       info->operand_types[1] == SpasmOperandType_Register &&
+       info->operand_sizes[1] == 16)
+        return true;
+
+    return info->mnemonic == SpasmMnemonic_x86_64_CRC32 && info->operand_sizes[1] == 16;
+}
+
 typedef struct
 {
     bool needs_rex;
@@ -382,7 +499,7 @@ typedef struct
     bool z;
 } Spasm_x86_64_PrefixInfo;
 
-Spasm_x86_64_PrefixBytes spasm_encode_x86_64_prefix(Spasm_x86_64_PrefixInfo info,
+static Spasm_x86_64_PrefixBytes spasm_encode_x86_64_prefix(Spasm_x86_64_PrefixInfo info,
                                                     const Spasm_x86_64_InstructionInfo* instr_info,
                                                     SpasmOperand* operands,
                                                     uint8_t num_operands)
@@ -390,6 +507,16 @@ Spasm_x86_64_PrefixBytes spasm_encode_x86_64_prefix(Spasm_x86_64_PrefixInfo info
     Spasm_x86_64_PrefixBytes result;
     memset(&result, 0, sizeof(Spasm_x86_64_PrefixBytes));
 
+    /* Operand size prefix of the 16 bits forms, it goes before REX */
+    if(!info.needs_evex && !info.needs_vex2 && !info.needs_vex3 && spasm_x86_64_is_operand_size_16(instr_info))
+        result.bytes[result.len++] = 0x66;
+
+    /* Mandatory prefix of the legacy SSE forms, pp as in VEX (66, F3, F2). It goes after 66 and before REX */
+    static const SpasmByte mandatory_prefixes[4] = { 0x00, 0x66, 0xF3, 0xF2 };
+
+    if(!info.needs_evex && !info.needs_vex2 && !info.needs_vex3 && info.pp != 0)
+        result.bytes[result.len++] = mandatory_prefixes[info.pp & 0x3];
+
     if(info.needs_evex)
     {
         SpasmByte R = 0, X = 0, B = 0, R_prime = 0, W = 0, V_prime = 0, b = 0;
@@ -508,34 +635,37 @@ Spasm_x86_64_PrefixBytes spasm_encode_x86_64_prefix(Spasm_x86_64_PrefixInfo info
     }
     else if(info.needs_rex)
     {
-        SpasmByte W = 0, R = 0, X = 0, B = 0;
+        SpasmByte W = instr_info->force_rex_w ? 1 : 0, R = 0, X = 0, B = 0;
+        bool needs_empty_rex = false;
 
         for(uint8_t i = 0; i < num_operands; i++)
         {
             if(operands[i].type == SpasmOperandType_Register)
             {
                 SpasmByte code = spasm_x86_64_get_register_code(operands[i].reg);
-
-                if(instr_info->force_rex_w)
-                    W = 1;
+                const Spasm_x86_64_RegisterWidth width = spasm_x86_64_get_register_width(operands[i].reg);
 
                 if(code > 7)
                 {
-                    if(instr_info->reg_in_opcode)
+                    switch(spasm_x86_64_legacy_register_field(instr_info, i))
                     {
-                        B = 1;
-                        result.bytes[0] += code & 7;
+                        case Spasm_x86_64_RegisterField_Reg:
+                            R = 1;
+                            break;
+                        case Spasm_x86_64_RegisterField_Rm:
+                            B = 1;
+                            break;
+                        default:
+                            break;
                     }
-
-                    if(instr_info->reg_in_modrm_reg && i  == instr_info->modrm_reg_operand)
-                        R = 1;
-
-                    if(instr_info->reg_in_modrm_rm && i == instr_info->modrm_rm_operand)
-                        B = 1;
                 }
 
-                if(spasm_x86_64_get_register_width(operands[i].reg) == Spasm_x86_64_RegisterWidth_64)
+                if(width == Spasm_x86_64_RegisterWidth_64 && !spasm_x86_64_is_default_64(instr_info->mnemonic))
                     W = 1;
+
+                /* spl, bpl, sil and dil need a REX prefix, even without any bit set */
+                if(width == Spasm_x86_64_RegisterWidth_8 && code >= 4 && code <= 7)
+                    needs_empty_rex = true;
             }
 
             if(operands[i].type == SpasmOperandType_Mem)
@@ -555,8 +685,9 @@ Spasm_x86_64_PrefixBytes spasm_encode_x86_64_prefix(Spasm_x86_64_PrefixInfo info
             }
         }
 
-        result.bytes[0] = 0x40 | (W << 3) | (R << 2) | (X << 1) | B;
-        result.len = (W || R || X || B) ? 1 : 0; /* Omit REX if not needed */
+        /* Omit REX if not needed */
+        if(W || R || X || B || needs_empty_rex)
+            result.bytes[result.len++] = 0x40 | (W << 3) | (R << 2) | (X << 1) | B;
     }
 
     return result;
@@ -589,24 +720,39 @@ typedef struct
     int32_t disp32;
 } Spasm_x86_64_ModRMSibOffset;
 
-SpasmByte spasm_x86_64_get_rm(SpasmRegister reg)
+static SpasmByte spasm_x86_64_get_rm(SpasmRegister reg)
 {
     SpasmByte code = spasm_x86_64_get_register_code(reg);
     return code & 0x7;
 }
 
-Spasm_x86_64_ModRMSibOffset spasm_x86_64_operands_as_modrm_sib_offset(SpasmOperand* dst,
+static Spasm_x86_64_ModRMSibOffset spasm_x86_64_operands_as_modrm_sib_offset(SpasmOperand* dst,
                                                                       SpasmOperand* src,
                                                                       Spasm_x86_64_PrefixInfo* prefix_info,
                                                                       const Spasm_x86_64_InstructionInfo* instr_info)
 {
     Spasm_x86_64_ModRMSibOffset result = { 0 };
 
-    if(dst->type == SpasmOperandType_Register && src->type == SpasmOperandType_Register)
+    /* /digit forms take the digit in ModR/M.reg (a second register operand is implicit) */
+    const bool has_digit = instr_info->reg_in_modrm_reg &&
+                           !prefix_info->needs_vex2 &&
+                           !prefix_info->needs_vex3 &&
+                           !prefix_info->needs_evex;
+
+    if(dst->type == SpasmOperandType_Register && src->type == SpasmOperandType_Register && !has_digit)
     {
         /* mod=11 (register-direct) */
 
-        if(instr_info->operand_sizes[0] > 64)
+        if(instr_info->reg_in_modrm_rm)
+        {
+            const SpasmOperand* rm_operand = instr_info->modrm_rm_operand == 0 ? dst : src;
+            const SpasmOperand* reg_operand = instr_info->modrm_rm_operand == 0 ? src : dst;
+
+            result.modrm = (0x3 << 6) |
+                           (spasm_x86_64_get_rm(reg_operand->reg) << 3) |
+                           spasm_x86_64_get_rm(rm_operand->reg);
+        }
+        else if(instr_info->operand_sizes[0] > 64)
             result.modrm = (0x3 << 6) |
                            (spasm_x86_64_get_rm(dst->reg) << 3) |
                            spasm_x86_64_get_rm(src->reg);
@@ -618,7 +764,7 @@ Spasm_x86_64_ModRMSibOffset spasm_x86_64_operands_as_modrm_sib_offset(SpasmOpera
         return result;
     }
 
-    if(dst->type == SpasmOperandType_Register && src->type >= SpasmOperandType_Imm8)
+    if(dst->type == SpasmOperandType_Register && src->type != SpasmOperandType_Mem)
     {
         /* mod=11 (register-direct) */
         result.modrm = (0x3 << 6) |
@@ -709,7 +855,10 @@ Spasm_x86_64_ModRMSibOffset spasm_x86_64_operands_as_modrm_sib_offset(SpasmOpera
     }
 
     /* Set ModR/M: mod, reg, rm */
-    result.modrm = (mod << 6) | (spasm_x86_64_get_rm(reg_operand->reg) << 3) | rm;
+    const SpasmByte reg = has_digit ? instr_info->modrm_reg_operand :
+                          reg_operand->type == SpasmOperandType_Register ? spasm_x86_64_get_rm(reg_operand->reg) : 0;
+
+    result.modrm = (mod << 6) | (reg << 3) | rm;
 
     /* Adjust for VEX/EVEX vvvv field if src is memory */
     if(mem_is_dest && prefix_info->needs_vex2 || prefix_info->needs_vex3 || prefix_info->needs_evex)
@@ -718,56 +867,96 @@ Spasm_x86_64_ModRMSibOffset spasm_x86_64_operands_as_modrm_sib_offset(SpasmOpera
     return result;
 }
 
-bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out)
+static size_t spasm_x86_64_format_error_instruction(const SpasmError* error,
+                                                    char* buffer,
+                                                    size_t buffer_size)
+{
+    char instr_buffer[256];
+    size_t instr_buffer_len = spasm_x86_64_instruction_debug((SpasmInstruction*)error->instruction,
+                                                             instr_buffer,
+                                                             sizeof(instr_buffer));
+
+    if(instr_buffer_len >= sizeof(instr_buffer))
+        instr_buffer_len = sizeof(instr_buffer) - 1;
+
+    if(instr_buffer_len >= buffer_size)
+        instr_buffer_len = buffer_size - 1;
+
+    memcpy(buffer, instr_buffer, instr_buffer_len);
+    buffer[instr_buffer_len] = '\0';
+
+    return instr_buffer_len;
+}
+
+/* Returns the form encoding the instruction, NULL if none matches */
+static const Spasm_x86_64_InstructionInfo* spasm_x86_64_find_instruction_form(const SpasmInstruction* instr)
 {
-    const Spasm_x86_64_InstructionInfo* info = NULL;
+    /* Pre-resolved forms (typed builders) skip the matching, if they belong to the mnemonic */
+    if(instr->form != 0 &&
+       instr->form <= spasm_x86_64_instruction_table_size &&
+       spasm_x86_64_instruction_table[instr->form - 1].mnemonic == instr->mnemonic)
+        return &spasm_x86_64_instruction_table[instr->form - 1];
 
-    for(size_t i = 0; i < spasm_x86_64_instruction_table_size; i++)
+    if(instr->mnemonic > SPASM_X86_64_NUM_MNEMONICS)
+        return NULL;
+
+    /* Only the forms of the mnemonic are matched against the operands */
+    const size_t first_form = spasm_x86_64_mnemonic_table[instr->mnemonic].first_form;
+    const size_t end_form = first_form + spasm_x86_64_mnemonic_table[instr->mnemonic].num_forms;
+
+    for(size_t i = first_form; i < end_form; i++)
     {
         const Spasm_x86_64_InstructionInfo* current_instr = &spasm_x86_64_instruction_table[i];
 
-        if(instr->mnemonic_len == current_instr->mnemonic_len && strcmp(instr->mnemonic, current_instr->mnemonic) == 0)
-        {
-            bool match = true;
+        bool match = true;
 
-            for(uint8_t j = 0; j < instr->num_operands; j++)
+        for(uint8_t j = 0; j < instr->num_operands; j++)
+        {
+            if(instr->operands[j].type != current_instr->operand_types[j])
             {
-                if(instr->operands[j].type != current_instr->operand_types[j])
-                {
-                    match = false;
-                    break;
-                }
-
-                const size_t operand_size = spasm_x86_64_get_operand_size(&instr->operands[j],
-                                                                          current_instr->operand_sizes[j]);
+                match = false;
+                break;
+            }
 
-                if(current_instr->operand_sizes[j] != 0 &&
-                   operand_size != current_instr->operand_sizes[j])
-                {
-                    match = false;
-                    break;
-                }
+            /* Virtual registers have to be allocated first (see spasm_x86_64_allocate_registers) */
+            if(instr->operands[j].type == SpasmOperandType_Mem &&
+               (instr->operands[j].mem_reg == SPASM_VIRTUAL_REGISTER ||
+                instr->operands[j].mem_index == SPASM_VIRTUAL_REGISTER))
+            {
+                match = false;
+                break;
             }
 
-            if(match)
+            const size_t operand_size = spasm_x86_64_get_operand_size((SpasmOperand*)&instr->operands[j],
+                                                                      current_instr->operand_sizes[j]);
+
+            if(current_instr->operand_sizes[j] != 0 &&
+               operand_size != current_instr->operand_sizes[j])
             {
-                info = current_instr;
+                match = false;
                 break;
             }
         }
-    }
 
-    if(info == NULL)
-    {
-        spasm_error("Cannot find encoding info for instruction: %s", instr->mnemonic);
+        if(match)
+            return current_instr;
+    }
 
-        char instr_buffer[64];
-        const size_t instr_buffer_len = spasm_x86_64_instruction_debug(instr, instr_buffer, 64);
+    return NULL;
+}
 
-        spasm_error("Instruction: %.*s", (int)instr_buffer_len, instr_buffer);
+/* Everything computed from the form and the operands before writing any byte */
+typedef struct
+{
+    Spasm_x86_64_PrefixBytes prefix;
+    Spasm_x86_64_ModRMSibOffset modrm_sib;
+} Spasm_x86_64_EncodingParts;
 
-        return false;
-    }
+static void spasm_x86_64_prepare_encoding(const SpasmInstruction* instr,
+                                          const Spasm_x86_64_InstructionInfo* info,
+                                          Spasm_x86_64_EncodingParts* parts)
+{
+    SpasmOperand* operands = (SpasmOperand*)instr->operands;
 
     /*
         A REX prefix must be encoded when:
@@ -776,7 +965,7 @@ bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out
             - using one of the uniform byte registers SPL, BPL, SIL or DIL
     */
 
-    bool needs_rex = spasm_x86_64_needs_rex(instr);
+    bool needs_rex = spasm_x86_64_needs_rex((SpasmInstruction*)instr);
 
     Spasm_x86_64_PrefixInfo prefix_info =
     {
@@ -790,19 +979,89 @@ bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out
                       (info->operand_sizes[0] == 256) ? 1 : 0,
     };
 
-    Spasm_x86_64_PrefixBytes prefix = spasm_encode_x86_64_prefix(prefix_info,
-                                                                 info,
-                                                                 instr->operands,
-                                                                 instr->num_operands);
+    parts->prefix = spasm_encode_x86_64_prefix(prefix_info, info, operands, instr->num_operands);
 
-    Spasm_x86_64_ModRMSibOffset modrm_sib;
-    memset(&modrm_sib, 0, sizeof(Spasm_x86_64_ModRMSibOffset));
+    memset(&parts->modrm_sib, 0, sizeof(Spasm_x86_64_ModRMSibOffset));
+
+    /* Missing operands are read as empty ones, rather than whatever the record holds */
+    SpasmOperand none_operand;
+    memset(&none_operand, 0, sizeof(SpasmOperand));
+
+    if(info->needs_modrm)
+        parts->modrm_sib = spasm_x86_64_operands_as_modrm_sib_offset(instr->num_operands > 0 ? &operands[0] : &none_operand,
+                                                                     instr->num_operands > 1 ? &operands[1] : &none_operand,
+                                                                     &prefix_info,
+                                                                     info);
+}
+
+static SPASM_FORCE_INLINE size_t spasm_x86_64_encoding_length(const SpasmInstruction* instr,
+                                                              const Spasm_x86_64_InstructionInfo* info,
+                                                              const Spasm_x86_64_EncodingParts* parts)
+{
+    size_t length = parts->prefix.len + info->opcode_len;
 
     if(info->needs_modrm)
-        modrm_sib = spasm_x86_64_operands_as_modrm_sib_offset(&instr->operands[0],
-                                                              &instr->operands[1],
-                                                              &prefix_info,
-                                                              info);
+        length += 1 +
+                  (size_t)parts->modrm_sib.has_sib +
+                  (parts->modrm_sib.has_disp8 ? 1 : parts->modrm_sib.has_disp32 ? 4 : 0);
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+        if(instr->operands[i].type >= SpasmOperandType_Imm8 &&
+           instr->operands[i].type <= SpasmOperandType_Imm64)
+            length += (size_t)1 << (instr->operands[i].type - SpasmOperandType_Imm8);
+
+    return length;
+}
+
+size_t spasm_x86_64_instruction_length(const SpasmInstruction* instr)
+{
+    SPASM_ASSERT(instr != NULL, "instr is NULL");
+
+    if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+        return 0;
+
+    const Spasm_x86_64_InstructionInfo* info = spasm_x86_64_find_instruction_form(instr);
+
+    if(info == NULL)
+        return 0;
+
+    Spasm_x86_64_EncodingParts parts;
+    spasm_x86_64_prepare_encoding(instr, info, &parts);
+
+    return spasm_x86_64_encoding_length(instr, info, &parts);
+}
+
+SpasmErrorCode spasm_x86_64_try_encode_instruction(SpasmContext* ctx,
+                                                   SpasmInstruction* instr,
+                                                   SpasmByteCode* out,
+                                                   SpasmError* error)
+{
+    /* Pseudo-instructions have no bytes */
+    if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+        return SpasmErrorCode_None;
+
+    const Spasm_x86_64_InstructionInfo* info = spasm_x86_64_find_instruction_form(instr);
+
+    if(info == NULL)
+    {
+        if(error != NULL)
+        {
+            memset(error, 0, sizeof(SpasmError));
+            error->code = SpasmErrorCode_UnknownInstruction;
+            error->instruction = instr;
+            error->format_instruction = spasm_x86_64_format_error_instruction;
+        }
+
+        return SpasmErrorCode_UnknownInstruction;
+    }
+
+    const size_t start_size = spasm_bytecode_size(out);
+
+    Spasm_x86_64_EncodingParts parts;
+    spasm_x86_64_prepare_encoding(instr, info, &parts);
+
+    const Spasm_x86_64_PrefixBytes prefix = parts.prefix;
+    Spasm_x86_64_ModRMSibOffset modrm_sib = parts.modrm_sib;
 
     for(uint8_t i = 0; i < prefix.len; i++)
     {
@@ -813,7 +1072,12 @@ bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out
     {
         SpasmByte opcode = info->opcode[i];
 
-        if(info->opcode[i] == 0x00 && i == 0) // Handle +r
+        /* +r, the register is added to the last opcode byte */
+        if(info->reg_in_opcode &&
+           info->prefix != Spasm_x86_64_PrefixType_VEX2 &&
+           info->prefix != Spasm_x86_64_PrefixType_VEX3 &&
+           info->prefix != Spasm_x86_64_PrefixType_EVEX &&
+           i == info->opcode_len - 1)
             opcode = info->opcode[i] + (spasm_x86_64_get_register_code(instr->operands[0].reg) & 0x7);
 
         spasm_bytecode_push_back(out, opcode);
@@ -821,11 +1085,6 @@ bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out
 
     if(info->needs_modrm)
     {
-        /* Adjust ModR/M for /0, /1, etc. */
-        if(info->opcode[info->opcode_len - 1] != 0x00 &&
-           (info->opcode[info->opcode_len - 1] & 0xF0) == 0x00)
-            modrm_sib.modrm |= (info->opcode[info->opcode_len - 1] << 3); /* Set reg field for /0, /1, etc. */
-
         spasm_bytecode_push_back(out, modrm_sib.modrm);
 
         if(modrm_sib.has_sib)
@@ -858,7 +1117,1431 @@ bool spasm_x86_64_encode_instruction(SpasmInstruction* instr, SpasmByteCode* out
         }
     }
 
+    SPASM_CONTEXT_STAT_ADD(ctx, num_instructions_encoded, 1);
+    SPASM_CONTEXT_STAT_ADD(ctx, num_bytes_encoded, spasm_bytecode_size(out) - start_size);
+
+    return SpasmErrorCode_None;
+}
+
+bool spasm_x86_64_encode_instruction(SpasmContext* ctx,
+                                     SpasmInstruction* instr,
+                                     SpasmByteCode* out)
+{
+    SpasmError error;
+
+    if(spasm_x86_64_try_encode_instruction(ctx, instr, out, &error) != SpasmErrorCode_None)
+    {
+        spasm_context_report(ctx, &error);
+        return false;
+    }
+
+    return true;
+}
+
+/* Padding */
+
+/*
+    Recommended multi-byte NOPs (Intel SDM, NOP instruction), the longer ones are the 10 bytes
+    form with more 0x66 prefixes, as decoded without penalty by current cores
+*/
+#define SPASM_X86_64_MAX_NOP_SIZE 15
+
+static const SpasmByte spasm_x86_64_nops[10][10] = {
+    { 0x90 },
+    { 0x66, 0x90 },
+    { 0x0F, 0x1F, 0x00 },
+    { 0x0F, 0x1F, 0x40, 0x00 },
+    { 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+    { 0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+    { 0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00 },
+    { 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+};
+
+void spasm_x86_64_encode_nops(SpasmByteCode* out, size_t size)
+{
+    SPASM_ASSERT(out != NULL, "out is NULL");
+
+    while(size > 0)
+    {
+        const size_t nop_size = size < SPASM_X86_64_MAX_NOP_SIZE ? size : SPASM_X86_64_MAX_NOP_SIZE;
+
+        for(size_t i = 10; i < nop_size; i++)
+            spasm_bytecode_push_back(out, 0x66);
+
+        const size_t base_size = nop_size < 10 ? nop_size : 10;
+
+        spasm_bytecode_push_bytes(out, spasm_x86_64_nops[base_size - 1], base_size);
+
+        size -= nop_size;
+    }
+}
+
+/* Stream encoding */
+
+typedef struct
+{
+    SpasmInstructions* instructions;
+    size_t start;
+    size_t end;
+
+    /* Chunk local, the error is replayed on the caller context after the join */
+    SpasmContext ctx;
+    SpasmByteCode bytecode;
+    size_t* instr_end_offsets;
+    bool skip_label_branches;
+
+    bool ok;
+} Spasm_x86_64_EncodingChunk;
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_label_branch(const SpasmInstruction* instr)
+{
+    return !spasm_mnemonic_is_pseudo(instr->mnemonic) &&
+           instr->num_operands == 1 &&
+           instr->operands[0].type == SpasmOperandType_Label;
+}
+
+/*
+ * Label branches are left out (no bytes) when skip_label_branches is set, they are encoded once
+ * the stream layout is known
+ */
+static bool spasm_x86_64_encode_range(SpasmContext* ctx,
+                                      SpasmInstructions* instructions,
+                                      size_t start,
+                                      size_t end,
+                                      SpasmByteCode* out,
+                                      size_t* instr_end_offsets,
+                                      bool skip_label_branches)
+{
+    for(size_t i = start; i < end; i++)
+    {
+        SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(!(skip_label_branches && spasm_x86_64_is_label_branch(instr)) &&
+           !spasm_x86_64_encode_instruction(ctx, instr, out))
+            return false;
+
+        if(instr_end_offsets != NULL)
+            instr_end_offsets[i] = spasm_bytecode_size(out);
+    }
+
     return true;
 }
 
+static void spasm_x86_64_encoding_chunk_thread(void* arg)
+{
+    Spasm_x86_64_EncodingChunk* chunk = (Spasm_x86_64_EncodingChunk*)arg;
+
+    chunk->ok = spasm_x86_64_encode_range(&chunk->ctx,
+                                          chunk->instructions,
+                                          chunk->start,
+                                          chunk->end,
+                                          &chunk->bytecode,
+                                          chunk->instr_end_offsets,
+                                          chunk->skip_label_branches);
+}
+
+static bool spasm_x86_64_encode_stream(SpasmContext* ctx,
+                                       SpasmInstructions* instructions,
+                                       SpasmByteCode* out,
+                                       size_t* instr_end_offsets,
+                                       bool skip_label_branches)
+{
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    const uint32_t max_threads = ctx != NULL ? ctx->max_encoding_threads : 1;
+
+    size_t num_chunks = num_instructions / SPASM_X86_64_PARALLEL_ENCODING_MIN_CHUNK;
+
+    if(num_chunks > (size_t)max_threads)
+        num_chunks = (size_t)max_threads;
+
+    if(num_chunks <= 1)
+        return spasm_x86_64_encode_range(ctx,
+                                         instructions,
+                                         0,
+                                         num_instructions,
+                                         out,
+                                         instr_end_offsets,
+                                         skip_label_branches);
+
+    /*
+        The chunk arrays are allocated from the calling thread through the context allocator, the
+        chunk buffers are filled by the worker threads and use the default allocator as user
+        allocators are not required to be thread-safe
+    */
+    const SpasmAllocator* allocator = spasm_context_get_allocator(ctx);
+
+    Spasm_x86_64_EncodingChunk* chunks = (Spasm_x86_64_EncodingChunk*)spasm_allocator_alloc(
+        allocator, num_chunks * sizeof(Spasm_x86_64_EncodingChunk));
+    SpasmThread* threads = (SpasmThread*)spasm_allocator_alloc(allocator, num_chunks * sizeof(SpasmThread));
+
+    if(chunks == NULL || threads == NULL)
+    {
+        spasm_allocator_free(allocator, chunks, num_chunks * sizeof(Spasm_x86_64_EncodingChunk));
+        spasm_allocator_free(allocator, threads, num_chunks * sizeof(SpasmThread));
+
+        return spasm_x86_64_encode_range(ctx,
+                                         instructions,
+                                         0,
+                                         num_instructions,
+                                         out,
+                                         instr_end_offsets,
+                                         skip_label_branches);
+    }
+
+    /*
+        The first chunk is encoded by the calling thread directly at the end of out, the others
+        into their own buffers with offsets relative to the start of their buffer
+    */
+    memset(chunks, 0, num_chunks * sizeof(Spasm_x86_64_EncodingChunk));
+    memset(threads, 0, num_chunks * sizeof(SpasmThread));
+
+    const size_t chunk_size = (num_instructions + num_chunks - 1) / num_chunks;
+
+    for(size_t c = 0; c < num_chunks; c++)
+    {
+        Spasm_x86_64_EncodingChunk* chunk = &chunks[c];
+
+        chunk->instructions = instructions;
+        chunk->start = c * chunk_size;
+        chunk->end = chunk->start + chunk_size < num_instructions ? chunk->start + chunk_size :
+                                                                    num_instructions;
+        chunk->instr_end_offsets = instr_end_offsets;
+        chunk->skip_label_branches = skip_label_branches;
+
+        if(c == 0)
+            continue;
+
+        spasm_context_init(&chunk->ctx);
+        chunk->bytecode = spasm_bytecode_new(&chunk->ctx);
+
+        if(!spasm_thread_start(&threads[c], spasm_x86_64_encoding_chunk_thread, chunk))
+            spasm_x86_64_encoding_chunk_thread(chunk);
+    }
+
+    bool res = spasm_x86_64_encode_range(ctx,
+                                         instructions,
+                                         chunks[0].start,
+                                         chunks[0].end,
+                                         out,
+                                         instr_end_offsets,
+                                         skip_label_branches);
+
+    for(size_t c = 1; c < num_chunks; c++)
+        spasm_thread_join(&threads[c]);
+
+    /*
+        Concatenation and relocation pass: chunks are appended in order, and their instruction end
+        offsets rebased on the final position of the chunk. The stream stops at the first failing
+        chunk, leaving out, the stats and the reported error as the sequential encoding would
+    */
+    for(size_t c = 1; c < num_chunks && res; c++)
+    {
+        Spasm_x86_64_EncodingChunk* chunk = &chunks[c];
+
+        const size_t base = spasm_bytecode_size(out);
+
+        size_t chunk_bytes_size = 0;
+        const SpasmByte* chunk_bytes = spasm_bytecode_get(&chunk->bytecode, &chunk_bytes_size);
+
+        spasm_bytecode_push_bytes(out, chunk_bytes, chunk_bytes_size);
+
+        if(instr_end_offsets != NULL)
+            for(size_t i = chunk->start; i < chunk->end; i++)
+                instr_end_offsets[i] += base;
+
+        SPASM_CONTEXT_STAT_ADD(ctx, num_instructions_encoded, chunk->ctx.stats.num_instructions_encoded);
+        SPASM_CONTEXT_STAT_ADD(ctx, num_bytes_encoded, chunk->ctx.stats.num_bytes_encoded);
+
+        if(!chunk->ok)
+        {
+            spasm_context_report(ctx, spasm_context_get_last_error(&chunk->ctx));
+            res = false;
+        }
+    }
+
+    for(size_t c = 1; c < num_chunks; c++)
+    {
+        spasm_bytecode_destroy(&chunks[c].bytecode);
+        spasm_context_release(&chunks[c].ctx);
+    }
+
+    spasm_allocator_free(allocator, threads, num_chunks * sizeof(SpasmThread));
+    spasm_allocator_free(allocator, chunks, num_chunks * sizeof(Spasm_x86_64_EncodingChunk));
+
+    return res;
+}
+
+
+/* Labels, alignments and branch relaxation */
+
+/*
+    Branches to labels start with their rel8 form (if the mnemonic has one) and are only widened
+    to rel32 when their displacement does not fit. Widening only ever grows the code, so the
+    process converges, and each branch is widened at most once.
+
+    The record offsets are kept in a Fenwick tree over the record sizes, so a displacement is
+    computed in O(log n) at any time. When a branch widens, only the short branches spanning it
+    can go out of range, and a short branch spans at most 128 bytes: they are found by scanning
+    the records around the widened one, and queued again. The whole pass is O(n log n), instead of
+    re-walking the stream until nothing changes.
+
+    Alignments and boundaries are sized from their offset once the branches are stable, and the
+    short branches around the ones that changed are checked again. Their padding can shrink, but
+    branches are never narrowed, so each round either widens a branch or ends the relaxation.
+*/
+
+#define SPASM_X86_64_REL8_SPAN 128
+
+#define SPASM_X86_64_MAX_INSTRUCTION_SIZE 15
+
+/* Same limit as the assemblers aligning code with prefixes, more can stall the legacy decoders */
+#define SPASM_X86_64_MAX_PADDING_PREFIXES 5
+
+/* CS segment override, ignored in 64-bit mode */
+#define SPASM_X86_64_PADDING_PREFIX 0x2E
+
+typedef struct
+{
+    size_t record;
+    uint32_t label;
+    uint16_t short_form; /* Table index + 1 of the rel8 form, 0 if the mnemonic has none */
+    uint16_t long_form; /* Table index + 1 of the rel32 form, 0 if the mnemonic has none */
+    uint8_t short_size;
+    uint8_t long_size;
+    bool queued;
+} Spasm_x86_64_Branch;
+
+typedef struct
+{
+    const SpasmAllocator* allocator;
+
+    size_t num_records;
+    size_t num_labels;
+    size_t num_branches;
+    size_t num_paddings;
+
+    size_t base; /* Offset of the stream in the bytecode, alignments are relative to its start */
+
+    size_t* label_records; /* Record binding each label, SIZE_MAX if not bound */
+    uint32_t* record_branches; /* Branch of each record, UINT32_MAX if not a label branch */
+    size_t* scratch_end_offsets; /* End offsets of the records encoded without the branches */
+    uint8_t* sizes; /* Current size of each record */
+    size_t* tree; /* Fenwick tree over the sizes (1-based) */
+    Spasm_x86_64_Branch* branches;
+    uint32_t* worklist;
+    size_t worklist_size;
+    size_t* padding_records; /* Records of the alignments, in stream order */
+    uint8_t* prefixes; /* Padding prefixes added to each record, NULL if there are no alignments */
+} Spasm_x86_64_Relaxation;
+
+void spasm_x86_64_report_instruction_error(SpasmContext* ctx,
+                                           SpasmErrorCode code,
+                                           const SpasmInstruction* instr)
+{
+    SpasmError error;
+    memset(&error, 0, sizeof(SpasmError));
+
+    error.code = code;
+    error.instruction = instr;
+    error.format_instruction = spasm_x86_64_format_error_instruction;
+
+    spasm_context_report(ctx, &error);
+}
+
+static void spasm_x86_64_relaxation_release(Spasm_x86_64_Relaxation* relax)
+{
+    spasm_allocator_free(relax->allocator, relax->label_records, relax->num_labels * sizeof(size_t));
+    spasm_allocator_free(relax->allocator, relax->record_branches, relax->num_records * sizeof(uint32_t));
+    spasm_allocator_free(relax->allocator, relax->scratch_end_offsets, relax->num_records * sizeof(size_t));
+    spasm_allocator_free(relax->allocator, relax->sizes, relax->num_records * sizeof(uint8_t));
+    spasm_allocator_free(relax->allocator, relax->tree, (relax->num_records + 1) * sizeof(size_t));
+    spasm_allocator_free(relax->allocator,
+                         relax->branches,
+                         relax->num_branches * sizeof(Spasm_x86_64_Branch));
+    spasm_allocator_free(relax->allocator, relax->worklist, relax->num_branches * sizeof(uint32_t));
+    spasm_allocator_free(relax->allocator, relax->padding_records, relax->num_paddings * sizeof(size_t));
+
+    if(relax->prefixes != NULL)
+        spasm_allocator_free(relax->allocator, relax->prefixes, relax->num_records * sizeof(uint8_t));
+}
+
+static SPASM_FORCE_INLINE void spasm_x86_64_relaxation_grow(Spasm_x86_64_Relaxation* relax,
+                                                           size_t record,
+                                                           size_t delta)
+{
+    for(size_t i = record + 1; i <= relax->num_records; i += i & (~i + 1))
+        relax->tree[i] += delta;
+}
+
+/* Offset of the start of the record (record == num_records gives the size of the code) */
+static SPASM_FORCE_INLINE size_t spasm_x86_64_relaxation_offset(const Spasm_x86_64_Relaxation* relax,
+                                                                size_t record)
+{
+    size_t offset = 0;
+
+    for(size_t i = record; i > 0; i -= i & (~i + 1))
+        offset += relax->tree[i];
+
+    return offset;
+}
+
+static SPASM_FORCE_INLINE int64_t spasm_x86_64_relaxation_displacement(const Spasm_x86_64_Relaxation* relax,
+                                                                       const Spasm_x86_64_Branch* branch)
+{
+    return (int64_t)spasm_x86_64_relaxation_offset(relax, relax->label_records[branch->label]) -
+           (int64_t)spasm_x86_64_relaxation_offset(relax, branch->record + 1);
+}
+
+static SPASM_FORCE_INLINE void spasm_x86_64_relaxation_queue(Spasm_x86_64_Relaxation* relax,
+                                                            size_t record)
+{
+    const uint32_t b = relax->record_branches[record];
+
+    if(b == UINT32_MAX)
+        return;
+
+    Spasm_x86_64_Branch* branch = &relax->branches[b];
+
+    if(branch->queued || relax->sizes[record] != branch->short_size)
+        return;
+
+    branch->queued = true;
+    relax->worklist[relax->worklist_size++] = b;
+}
+
+/* Queues the short branches spanning the record, whose end or start is at most a rel8 span away */
+static void spasm_x86_64_relaxation_queue_around(Spasm_x86_64_Relaxation* relax, size_t record)
+{
+    size_t distance = 0;
+
+    for(size_t i = record; i-- > 0 && distance <= SPASM_X86_64_REL8_SPAN;)
+    {
+        spasm_x86_64_relaxation_queue(relax, i);
+        distance += relax->sizes[i];
+    }
+
+    distance = 0;
+
+    for(size_t i = record + 1; i < relax->num_records && distance <= SPASM_X86_64_REL8_SPAN; i++)
+    {
+        spasm_x86_64_relaxation_queue(relax, i);
+        distance += relax->sizes[i];
+    }
+}
+
+/* Finds the rel8/rel32 forms of the branch, returns false if the mnemonic has none */
+static bool spasm_x86_64_find_branch_forms(const SpasmInstruction* instr, Spasm_x86_64_Branch* branch)
+{
+    branch->short_form = 0;
+    branch->long_form = 0;
+    branch->short_size = 0;
+    branch->long_size = 0;
+
+    if(instr->mnemonic > SPASM_X86_64_NUM_MNEMONICS)
+        return false;
+
+    const size_t first_form = spasm_x86_64_mnemonic_table[instr->mnemonic].first_form;
+    const size_t end_form = first_form + spasm_x86_64_mnemonic_table[instr->mnemonic].num_forms;
+
+    for(size_t i = first_form; i < end_form; i++)
+    {
+        const Spasm_x86_64_InstructionInfo* info = &spasm_x86_64_instruction_table[i];
+
+        if(info->operand_types[1] != SpasmOperandType_None ||
+           info->prefix != Spasm_x86_64_PrefixType_NONE)
+            continue;
+
+        if(info->operand_types[0] == SpasmOperandType_Imm8 && branch->short_form == 0)
+        {
+            branch->short_form = (uint16_t)(i + 1);
+            branch->short_size = info->opcode_len + 1;
+        }
+        else if(info->operand_types[0] == SpasmOperandType_Imm32 && branch->long_form == 0)
+        {
+            branch->long_form = (uint16_t)(i + 1);
+            branch->long_size = info->opcode_len + 4;
+        }
+    }
+
+    return branch->short_form != 0 || branch->long_form != 0;
+}
+
+const Spasm_x86_64_FormAccess* spasm_x86_64_instruction_access(const SpasmInstruction* instr)
+{
+    /* Label branches are sized with the layout, their rel8 and rel32 forms access the same things */
+    if(spasm_x86_64_is_label_branch(instr))
+    {
+        Spasm_x86_64_Branch branch;
+
+        if(!spasm_x86_64_find_branch_forms(instr, &branch))
+            return NULL;
+
+        return &spasm_x86_64_form_access_table[(branch.long_form != 0 ? branch.long_form : branch.short_form) - 1];
+    }
+
+    const Spasm_x86_64_InstructionInfo* info = spasm_x86_64_find_instruction_form(instr);
+
+    if(info == NULL)
+        return NULL;
+
+    return &spasm_x86_64_form_access_table[info - spasm_x86_64_instruction_table];
+}
+
+const Spasm_x86_64_UarchProfile* spasm_x86_64_get_uarch_profile(Spasm_x86_64_Uarch uarch)
+{
+    if((size_t)uarch >= Spasm_x86_64_Uarch_COUNT)
+        return NULL;
+
+    return &spasm_x86_64_uarch_profiles[uarch];
+}
+
+Spasm_x86_64_Uarch spasm_x86_64_uarch_from_string(const char* name)
+{
+    for(size_t i = 0; i < Spasm_x86_64_Uarch_COUNT; i++)
+        if(strcmp(spasm_x86_64_uarch_profiles[i].name, name) == 0)
+            return (Spasm_x86_64_Uarch)i;
+
+    return Spasm_x86_64_Uarch_COUNT;
+}
+
+bool spasm_x86_64_instruction_cost(const SpasmInstruction* instr,
+                                   Spasm_x86_64_Uarch uarch,
+                                   Spasm_x86_64_InstructionCost* cost)
+{
+    const Spasm_x86_64_UarchProfile* profile = spasm_x86_64_get_uarch_profile(uarch);
+    const Spasm_x86_64_FormAccess* access = spasm_x86_64_instruction_access(instr);
+
+    if(profile == NULL || access == NULL)
+        return false;
+
+    const size_t form = (size_t)(access - spasm_x86_64_form_access_table);
+    const Spasm_x86_64_ClassCost* class_cost = &profile->classes[spasm_x86_64_form_cost_class_table[form]];
+
+    cost->latency = class_cost->latency;
+    cost->ports = class_cost->ports;
+    cost->load = false;
+    cost->store = false;
+
+    /* lea only computes the address */
+    if(instr->mnemonic != SpasmMnemonic_x86_64_LEA)
+    {
+        for(uint8_t i = 0; i < instr->num_operands; i++)
+        {
+            const uint8_t type = instr->operands[i].type;
+
+            if(type != SpasmOperandType_Mem && type != SpasmOperandType_Data && type != SpasmOperandType_Symbol)
+                continue;
+
+            cost->load |= (access->read & (1u << i)) != 0;
+            cost->store |= (access->written & (1u << i)) != 0;
+        }
+    }
+
+    /* push and pop go through the stack */
+    if((access->implicit_read | access->implicit_written) & spasm_x86_64_register_set(SpasmRegister_x86_64_RSP))
+    {
+        cost->load = true;
+        cost->store = true;
+    }
+
+    if(cost->load)
+        cost->latency += profile->load_latency;
+
+    return true;
+}
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_padding(const SpasmInstruction* instr)
+{
+    return instr->mnemonic == SpasmMnemonic_Align || instr->mnemonic == SpasmMnemonic_Boundary;
+}
+
+/* Alignment and boundary records, a boundary must be followed by the instructions it covers */
+static bool spasm_x86_64_is_valid_padding(SpasmInstructions* instructions, size_t record)
+{
+    const SpasmInstruction* instr = spasm_instructions_at(instructions, record);
+    const int64_t alignment = instr->operands[0].imm_value;
+
+    if(alignment <= 0 || alignment > SPASM_MAX_CODE_ALIGNMENT || (alignment & (alignment - 1)) != 0)
+        return false;
+
+    if(instr->mnemonic == SpasmMnemonic_Align)
+        return instr->num_operands == 2;
+
+    const int64_t count = instr->operands[2].imm_value;
+
+    if(instr->num_operands != 3 ||
+       count < 1 ||
+       count > SPASM_MAX_BOUNDARY_RECORDS ||
+       record + (size_t)count >= spasm_instructions_size(instructions))
+        return false;
+
+    for(size_t i = record + 1; i <= record + (size_t)count; i++)
+        if(spasm_mnemonic_is_pseudo(spasm_instructions_at(instructions, i)->mnemonic))
+            return false;
+
+    return true;
+}
+
+/* Binds the labels and collects the branches and paddings, reports the first invalid one */
+static bool spasm_x86_64_relaxation_collect(SpasmContext* ctx,
+                                            SpasmInstructions* instructions,
+                                            Spasm_x86_64_Relaxation* relax)
+{
+    for(size_t i = 0; i < relax->num_labels; i++)
+        relax->label_records[i] = SIZE_MAX;
+
+    size_t num_branches = 0;
+    size_t num_paddings = 0;
+
+    for(size_t i = 0; i < relax->num_records; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Label)
+        {
+            const uint32_t label = instr->operands[0].label;
+
+            if(label >= relax->num_labels || relax->label_records[label] != SIZE_MAX)
+            {
+                spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_InvalidLabel, instr);
+                return false;
+            }
+
+            relax->label_records[label] = i;
+        }
+        else if(spasm_x86_64_is_padding(instr))
+        {
+            if(!spasm_x86_64_is_valid_padding(instructions, i))
+            {
+                spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_InvalidAlignment, instr);
+                return false;
+            }
+
+            num_paddings++;
+        }
+
+        num_branches += (size_t)spasm_x86_64_is_label_branch(instr);
+    }
+
+    if(num_paddings > 0)
+    {
+        relax->padding_records = (size_t*)spasm_allocator_alloc(relax->allocator, num_paddings * sizeof(size_t));
+        relax->num_paddings = num_paddings;
+
+        relax->prefixes = (uint8_t*)spasm_allocator_alloc(relax->allocator, relax->num_records * sizeof(uint8_t));
+
+        if(relax->padding_records == NULL || relax->prefixes == NULL)
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            return false;
+        }
+
+        memset(relax->prefixes, 0, relax->num_records * sizeof(uint8_t));
+    }
+
+    if(num_branches >= UINT32_MAX)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    relax->branches = (Spasm_x86_64_Branch*)spasm_allocator_alloc(relax->allocator,
+                                                                  num_branches * sizeof(Spasm_x86_64_Branch));
+    relax->worklist = (uint32_t*)spasm_allocator_alloc(relax->allocator, num_branches * sizeof(uint32_t));
+    relax->num_branches = num_branches;
+
+    if(num_branches > 0 && (relax->branches == NULL || relax->worklist == NULL))
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    uint32_t b = 0;
+    size_t a = 0;
+
+    for(size_t i = 0; i < relax->num_records; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(spasm_x86_64_is_padding(instr))
+            relax->padding_records[a++] = i;
+
+        if(!spasm_x86_64_is_label_branch(instr))
+        {
+            relax->record_branches[i] = UINT32_MAX;
+            continue;
+        }
+
+        Spasm_x86_64_Branch* branch = &relax->branches[b];
+        branch->record = i;
+        branch->label = instr->operands[0].label;
+        branch->queued = false;
+
+        if(!spasm_x86_64_find_branch_forms(instr, branch))
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+            return false;
+        }
+
+        if(branch->label >= relax->num_labels || relax->label_records[branch->label] == SIZE_MAX)
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_InvalidLabel, instr);
+            return false;
+        }
+
+        relax->record_branches[i] = b++;
+    }
+
+    return true;
+}
+
+static void spasm_x86_64_relaxation_build_tree(Spasm_x86_64_Relaxation* relax)
+{
+    relax->tree[0] = 0;
+
+    for(size_t i = 1; i <= relax->num_records; i++)
+        relax->tree[i] = relax->sizes[i - 1];
+
+    for(size_t i = 1; i <= relax->num_records; i++)
+    {
+        const size_t parent = i + (i & (~i + 1));
+
+        if(parent <= relax->num_records)
+            relax->tree[parent] += relax->tree[i];
+    }
+}
+
+/*
+ * Padding of an alignment or boundary record at offset. A boundary is only padded when the
+ * records it covers would cross or end on it, they are then moved to its start
+ */
+static SPASM_FORCE_INLINE uint8_t spasm_x86_64_relaxation_padding(SpasmInstructions* instructions,
+                                                                  const Spasm_x86_64_Relaxation* relax,
+                                                                  size_t record,
+                                                                  size_t offset)
+{
+    const SpasmInstruction* instr = spasm_instructions_at(instructions, record);
+    const size_t alignment = (size_t)instr->operands[0].imm_value;
+    const size_t padding = (alignment - offset % alignment) % alignment;
+
+    if(instr->mnemonic == SpasmMnemonic_Align)
+        return (uint8_t)padding;
+
+    size_t size = 0;
+
+    for(size_t i = record + 1; i <= record + (size_t)instr->operands[2].imm_value; i++)
+        size += relax->sizes[i];
+
+    return padding > 0 && size >= padding && size < alignment ? (uint8_t)padding : 0;
+}
+
+/*
+ * Sizes the alignments and boundaries from their current offset, in stream order so each one
+ * sees the padding of the previous ones. Returns true if short branches around a resized one
+ * were queued
+ */
+static bool spasm_x86_64_relaxation_pad(SpasmInstructions* instructions, Spasm_x86_64_Relaxation* relax)
+{
+    for(size_t a = 0; a < relax->num_paddings; a++)
+    {
+        const size_t record = relax->padding_records[a];
+        const size_t offset = relax->base + spasm_x86_64_relaxation_offset(relax, record);
+        const uint8_t padding = spasm_x86_64_relaxation_padding(instructions, relax, record, offset);
+
+        if(padding == relax->sizes[record])
+            continue;
+
+        /* The delta wraps around when the padding shrinks, the sums in the tree stay exact */
+        spasm_x86_64_relaxation_grow(relax, record, (size_t)padding - (size_t)relax->sizes[record]);
+        relax->sizes[record] = padding;
+
+        spasm_x86_64_relaxation_queue_around(relax, record);
+    }
+
+    return relax->worklist_size > 0;
+}
+
+bool spasm_x86_64_is_branch(uint16_t mnemonic)
+{
+    if(mnemonic == SpasmMnemonic_Invalid || mnemonic > SPASM_X86_64_NUM_MNEMONICS)
+        return false;
+
+    return spasm_x86_64_mnemonic_table[mnemonic].name[0] == 'j';
+}
+
+/* jcc, jmp, call and ret, direct or indirect */
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_jump(uint16_t mnemonic)
+{
+    return spasm_x86_64_is_branch(mnemonic) ||
+           mnemonic == SpasmMnemonic_x86_64_CALL ||
+           mnemonic == SpasmMnemonic_x86_64_RET;
+}
+
+/* Relative jmp/jcc/call/loop/jrcxz/xbegin forms, their displacement is tied to their position */
+static bool spasm_x86_64_is_relative_branch(const Spasm_x86_64_InstructionInfo* info)
+{
+    if(info->operand_types[0] != SpasmOperandType_Imm8 && info->operand_types[0] != SpasmOperandType_Imm32)
+        return false;
+
+    const SpasmByte opcode = info->opcode[0];
+
+    if(info->opcode_len == 1)
+        return (opcode >= 0x70 && opcode <= 0x7F) ||
+               (opcode >= 0xE0 && opcode <= 0xE3) ||
+               opcode == 0xE8 ||
+               opcode == 0xE9 ||
+               opcode == 0xEB;
+
+    return (opcode == 0x0F && info->opcode[1] >= 0x80 && info->opcode[1] <= 0x8F) ||
+           (opcode == 0xC7 && info->opcode[1] == 0xF8);
+}
+
+/*
+ * Instructions whose encoding depends on where they are, they cannot be moved by padding. Jumps
+ * are not padded either, the prefixes are branch hints or notrack for them, and their boundary
+ * records are sized with their length
+ */
+static bool spasm_x86_64_is_position_dependent(const SpasmInstruction* instr,
+                                               const Spasm_x86_64_InstructionInfo* info)
+{
+    if(spasm_x86_64_is_jump(instr->mnemonic) || spasm_x86_64_is_relative_branch(info))
+        return true;
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        const SpasmOperand* operand = &instr->operands[i];
+
+        if(operand->type == SpasmOperandType_Data ||
+           operand->type == SpasmOperandType_Symbol ||
+           operand->type == SpasmOperandType_Label ||
+           (operand->type == SpasmOperandType_Mem && operand->mem_reg == SpasmRegister_x86_64_RIP))
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Moves the padding of the SpasmAlignPadding_Prefixes alignments and boundaries into redundant
+ * segment prefixes on the instructions right before them. Only the straight-line code after the
+ * last label, padding or position-dependent instruction is padded: it moves as a block, so no
+ * displacement changes and the relaxed layout stays valid. What does not fit in prefixes is left
+ * as NOPs. Runs once the layout is final
+ */
+static void spasm_x86_64_relaxation_pad_prefixes(SpasmInstructions* instructions,
+                                                 Spasm_x86_64_Relaxation* relax)
+{
+    bool padded = false;
+
+    for(size_t a = 0; a < relax->num_paddings; a++)
+    {
+        const size_t record = relax->padding_records[a];
+
+        if(spasm_instructions_at(instructions, record)->operands[1].imm_value != SpasmAlignPadding_Prefixes)
+            continue;
+
+        for(size_t i = record; i-- > 0 && relax->sizes[record] > 0;)
+        {
+            const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+            if(relax->record_branches[i] != UINT32_MAX || spasm_mnemonic_is_pseudo(instr->mnemonic))
+                break;
+
+            const Spasm_x86_64_InstructionInfo* info = spasm_x86_64_find_instruction_form(instr);
+
+            if(info == NULL || spasm_x86_64_is_position_dependent(instr, info))
+                break;
+
+            size_t count = SPASM_X86_64_MAX_INSTRUCTION_SIZE - relax->sizes[i];
+
+            if(count > SPASM_X86_64_MAX_PADDING_PREFIXES)
+                count = SPASM_X86_64_MAX_PADDING_PREFIXES;
+
+            if(count > relax->sizes[record])
+                count = relax->sizes[record];
+
+            relax->prefixes[i] = (uint8_t)count;
+            relax->sizes[i] += (uint8_t)count;
+            relax->sizes[record] -= (uint8_t)count;
+
+            padded |= count > 0;
+        }
+    }
+
+    if(padded)
+        spasm_x86_64_relaxation_build_tree(relax);
+}
+
+/* The sizes of the records other than the label branches and paddings must be filled */
+static bool spasm_x86_64_relaxation_run(SpasmContext* ctx,
+                                        SpasmInstructions* instructions,
+                                        Spasm_x86_64_Relaxation* relax)
+{
+    for(size_t i = 0; i < relax->num_branches; i++)
+    {
+        const Spasm_x86_64_Branch* branch = &relax->branches[i];
+        relax->sizes[branch->record] = branch->short_form != 0 ? branch->short_size : branch->long_size;
+    }
+
+    for(size_t a = 0; a < relax->num_paddings; a++)
+        relax->sizes[relax->padding_records[a]] = 0;
+
+    spasm_x86_64_relaxation_build_tree(relax);
+
+    /* Queued in reverse so the branches are first checked in stream order */
+    relax->worklist_size = 0;
+
+    for(size_t i = relax->num_branches; i-- > 0;)
+        spasm_x86_64_relaxation_queue(relax, relax->branches[i].record);
+
+    spasm_x86_64_relaxation_pad(instructions, relax);
+
+    do
+    {
+        while(relax->worklist_size > 0)
+        {
+            Spasm_x86_64_Branch* branch = &relax->branches[relax->worklist[--relax->worklist_size]];
+            branch->queued = false;
+
+            const int64_t displacement = spasm_x86_64_relaxation_displacement(relax, branch);
+
+            if(displacement >= INT8_MIN && displacement <= INT8_MAX)
+                continue;
+
+            if(branch->long_form == 0)
+            {
+                spasm_x86_64_report_instruction_error(ctx,
+                                                      SpasmErrorCode_BranchOutOfRange,
+                                                      spasm_instructions_at(instructions, branch->record));
+                return false;
+            }
+
+            const size_t record = branch->record;
+
+            relax->sizes[record] = branch->long_size;
+            spasm_x86_64_relaxation_grow(relax, record, (size_t)(branch->long_size - branch->short_size));
+
+            spasm_x86_64_relaxation_queue_around(relax, record);
+        }
+    }
+    while(spasm_x86_64_relaxation_pad(instructions, relax));
+
+    return true;
+}
+
+/*
+ * Copies the encoded records and encodes the branches with their final displacement, the
+ * alignments and padding prefixes are written in between
+ */
+static bool spasm_x86_64_relaxation_emit(SpasmContext* ctx,
+                                         SpasmInstructions* instructions,
+                                         Spasm_x86_64_Relaxation* relax,
+                                         const SpasmByte* scratch,
+                                         SpasmByteCode* out,
+                                         size_t* instr_end_offsets)
+{
+    size_t run_start = 0;
+    size_t end_offset = relax->base;
+    size_t next_padding = 0;
+
+    for(size_t i = 0; i < relax->num_records; i++)
+    {
+        end_offset += relax->sizes[i];
+
+        if(instr_end_offsets != NULL)
+            instr_end_offsets[i] = end_offset;
+
+        if(relax->prefixes != NULL && relax->prefixes[i] > 0)
+        {
+            const size_t record_start = i > 0 ? relax->scratch_end_offsets[i - 1] : 0;
+
+            spasm_bytecode_push_bytes(out, scratch + run_start, record_start - run_start);
+            run_start = record_start;
+
+            for(uint8_t p = 0; p < relax->prefixes[i]; p++)
+                spasm_bytecode_push_back(out, SPASM_X86_64_PADDING_PREFIX);
+        }
+
+        if(next_padding < relax->num_paddings && relax->padding_records[next_padding] == i)
+        {
+            spasm_bytecode_push_bytes(out, scratch + run_start, relax->scratch_end_offsets[i] - run_start);
+            run_start = relax->scratch_end_offsets[i];
+
+            spasm_x86_64_encode_nops(out, relax->sizes[i]);
+            next_padding++;
+
+            continue;
+        }
+
+        const uint32_t b = relax->record_branches[i];
+
+        if(b == UINT32_MAX)
+            continue;
+
+        const Spasm_x86_64_Branch* branch = &relax->branches[b];
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        spasm_bytecode_push_bytes(out, scratch + run_start, relax->scratch_end_offsets[i] - run_start);
+        run_start = relax->scratch_end_offsets[i];
+
+        const int64_t displacement = spasm_x86_64_relaxation_displacement(relax, branch);
+
+        if(displacement < INT32_MIN || displacement > INT32_MAX)
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_BranchOutOfRange, instr);
+            return false;
+        }
+
+        const bool is_short = relax->sizes[i] == branch->short_size && branch->short_form != 0;
+
+        SpasmInstruction encoded = *instr;
+        encoded.form = is_short ? branch->short_form : branch->long_form;
+        encoded.operands[0] = is_short ? SpasmOpImm8(displacement) : SpasmOpImm32(displacement);
+
+        if(spasm_x86_64_try_encode_instruction(ctx, &encoded, out, NULL) != SpasmErrorCode_None)
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+            return false;
+        }
+
+        SPASM_ASSERT(spasm_bytecode_size(out) == end_offset, "branch size does not match its layout");
+    }
+
+    if(relax->num_records > 0)
+        spasm_bytecode_push_bytes(out,
+                                  scratch + run_start,
+                                  relax->scratch_end_offsets[relax->num_records - 1] - run_start);
+
+    return true;
+}
+
+/* Allocates the relaxation state and collects the labels and branches of the stream */
+static bool spasm_x86_64_relaxation_init(SpasmContext* ctx,
+                                         SpasmInstructions* instructions,
+                                         Spasm_x86_64_Relaxation* relax)
+{
+    memset(relax, 0, sizeof(Spasm_x86_64_Relaxation));
+
+    relax->allocator = spasm_context_get_allocator(ctx);
+    relax->num_records = spasm_instructions_size(instructions);
+    relax->num_labels = instructions->num_labels;
+
+    relax->label_records = (size_t*)spasm_allocator_alloc(relax->allocator, relax->num_labels * sizeof(size_t));
+    relax->record_branches = (uint32_t*)spasm_allocator_alloc(relax->allocator,
+                                                              relax->num_records * sizeof(uint32_t));
+    relax->sizes = (uint8_t*)spasm_allocator_alloc(relax->allocator, relax->num_records * sizeof(uint8_t));
+    relax->tree = (size_t*)spasm_allocator_alloc(relax->allocator, (relax->num_records + 1) * sizeof(size_t));
+
+    if(relax->label_records == NULL ||
+       relax->record_branches == NULL ||
+       relax->sizes == NULL ||
+       relax->tree == NULL)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    return spasm_x86_64_relaxation_collect(ctx, instructions, relax);
+}
+
+/*
+ * The records are first encoded without the label branches (in parallel for large streams),
+ * which gives the size of everything else, then the branches and alignments are sized and the
+ * final code is assembled from the encoded runs, the branches and the padding
+ */
+static bool spasm_x86_64_encode_with_layout(SpasmContext* ctx,
+                                            SpasmInstructions* instructions,
+                                            SpasmByteCode* out,
+                                            size_t* instr_end_offsets)
+{
+    if(spasm_instructions_size(instructions) == 0)
+        return true;
+
+    Spasm_x86_64_Relaxation relax;
+
+    bool res = spasm_x86_64_relaxation_init(ctx, instructions, &relax);
+
+    relax.base = spasm_bytecode_size(out);
+
+    if(res)
+    {
+        relax.scratch_end_offsets = (size_t*)spasm_allocator_alloc(relax.allocator,
+                                                                   relax.num_records * sizeof(size_t));
+
+        if(relax.scratch_end_offsets == NULL)
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            res = false;
+        }
+    }
+
+    SpasmByteCode scratch = spasm_bytecode_new(ctx);
+
+    res = res && spasm_x86_64_encode_stream(ctx,
+                                            instructions,
+                                            &scratch,
+                                            relax.scratch_end_offsets,
+                                            true);
+
+    if(res)
+    {
+        size_t previous_end = 0;
+
+        for(size_t i = 0; i < relax.num_records; i++)
+        {
+            relax.sizes[i] = (uint8_t)(relax.scratch_end_offsets[i] - previous_end);
+            previous_end = relax.scratch_end_offsets[i];
+        }
+    }
+
+    res = res && spasm_x86_64_relaxation_run(ctx, instructions, &relax);
+
+    if(res && relax.prefixes != NULL)
+        spasm_x86_64_relaxation_pad_prefixes(instructions, &relax);
+
+    if(res)
+    {
+        size_t scratch_size = 0;
+        const SpasmByte* scratch_bytes = spasm_bytecode_get(&scratch, &scratch_size);
+
+        res = spasm_x86_64_relaxation_emit(ctx,
+                                           instructions,
+                                           &relax,
+                                           scratch_bytes,
+                                           out,
+                                           instr_end_offsets);
+    }
+
+    spasm_bytecode_destroy(&scratch);
+    spasm_x86_64_relaxation_release(&relax);
+
+    return res;
+}
+
+bool spasm_x86_64_encode_instructions(SpasmContext* ctx,
+                                      SpasmInstructions* instructions,
+                                      SpasmByteCode* out,
+                                      size_t* instr_end_offsets)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+    SPASM_ASSERT(out != NULL, "out is NULL");
+
+    if(instructions->num_labels > 0 || instructions->num_paddings > 0)
+        return spasm_x86_64_encode_with_layout(ctx, instructions, out, instr_end_offsets);
+
+    return spasm_x86_64_encode_stream(ctx, instructions, out, instr_end_offsets, false);
+}
+
+/* Instruction offsets */
+
+/*
+ * Fills the sizes of the records other than the label branches (alignments are sized by the
+ * relaxation), reports the first unknown one
+ */
+static bool spasm_x86_64_instructions_lengths(SpasmContext* ctx,
+                                              SpasmInstructions* instructions,
+                                              uint8_t* sizes,
+                                              const uint32_t* record_branches)
+{
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(record_branches != NULL && record_branches[i] != UINT32_MAX)
+            continue;
+
+        sizes[i] = (uint8_t)spasm_x86_64_instruction_length(instr);
+
+        if(sizes[i] == 0 && !spasm_mnemonic_is_pseudo(instr->mnemonic))
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool spasm_x86_64_instructions_offsets(SpasmContext* ctx,
+                                       SpasmInstructions* instructions,
+                                       size_t* instr_end_offsets)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+    SPASM_ASSERT(instr_end_offsets != NULL, "instr_end_offsets is NULL");
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    if(instructions->num_labels == 0 && instructions->num_paddings == 0)
+    {
+        size_t offset = 0;
+
+        for(size_t i = 0; i < num_instructions; i++)
+        {
+            const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+            const size_t length = spasm_x86_64_instruction_length(instr);
+
+            if(length == 0 && !spasm_mnemonic_is_pseudo(instr->mnemonic))
+            {
+                spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+                return false;
+            }
+
+            offset += length;
+            instr_end_offsets[i] = offset;
+        }
+
+        return true;
+    }
+
+    if(num_instructions == 0)
+        return true;
+
+    Spasm_x86_64_Relaxation relax;
+
+    bool res = spasm_x86_64_relaxation_init(ctx, instructions, &relax);
+
+    res = res && spasm_x86_64_instructions_lengths(ctx, instructions, relax.sizes, relax.record_branches);
+    res = res && spasm_x86_64_relaxation_run(ctx, instructions, &relax);
+
+    if(res && relax.prefixes != NULL)
+        spasm_x86_64_relaxation_pad_prefixes(instructions, &relax);
+
+    if(res)
+    {
+        size_t offset = 0;
+
+        for(size_t i = 0; i < num_instructions; i++)
+        {
+            offset += relax.sizes[i];
+            instr_end_offsets[i] = offset;
+        }
+    }
+
+    spasm_x86_64_relaxation_release(&relax);
+
+    return res;
+}
+
+/* Branch layout */
+
+#define SPASM_X86_64_JUMP_BOUNDARY 32
+
+/* Condition code of a jcc (its rel8 opcode is 0x70 + cc), -1 for the other jumps */
+static int spasm_x86_64_jcc_condition(uint16_t mnemonic)
+{
+    const size_t first_form = spasm_x86_64_mnemonic_table[mnemonic].first_form;
+    const size_t end_form = first_form + spasm_x86_64_mnemonic_table[mnemonic].num_forms;
+
+    for(size_t i = first_form; i < end_form; i++)
+    {
+        const Spasm_x86_64_InstructionInfo* info = &spasm_x86_64_instruction_table[i];
+
+        if(info->opcode_len == 1 &&
+           info->operand_types[0] == SpasmOperandType_Imm8 &&
+           info->opcode[0] >= 0x70 &&
+           info->opcode[0] <= 0x7F)
+            return info->opcode[0] - 0x70;
+    }
+
+    return -1;
+}
+
+/*
+ * Whether the instruction macro-fuses with a following jcc of condition cc (Sandy Bridge and
+ * later): test/and with any condition, cmp/add/sub with the carry, zero and signed compare ones,
+ * inc/dec with the zero and signed compare ones. A memory operand with an immediate, or a memory
+ * destination for the arithmetic ones, prevents the fusion
+ */
+static bool spasm_x86_64_macro_fuses(const SpasmInstruction* instr, int cc)
+{
+    uint16_t conditions = 0;
+
+    switch(instr->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_TEST:
+        case SpasmMnemonic_x86_64_AND:
+            conditions = 0xFFFF;
+            break;
+        case SpasmMnemonic_x86_64_CMP:
+        case SpasmMnemonic_x86_64_ADD:
+        case SpasmMnemonic_x86_64_SUB:
+            conditions = 0xF0FC;
+            break;
+        case SpasmMnemonic_x86_64_INC:
+        case SpasmMnemonic_x86_64_DEC:
+            conditions = 0xF030;
+            break;
+        default:
+            return false;
+    }
+
+    if(((conditions >> cc) & 1) == 0)
+        return false;
+
+    bool has_memory = false;
+    bool has_immediate = false;
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        const uint8_t type = instr->operands[i].type;
+
+        has_memory |= type == SpasmOperandType_Mem || type == SpasmOperandType_Data;
+        has_immediate |= type >= SpasmOperandType_Imm8 && type <= SpasmOperandType_Imm64;
+    }
+
+    if(has_memory && has_immediate)
+        return false;
+
+    return instr->mnemonic == SpasmMnemonic_x86_64_TEST ||
+           instr->mnemonic == SpasmMnemonic_x86_64_CMP ||
+           instr->operands[0].type == SpasmOperandType_Register;
+}
+
+/*
+ * Number of records covered by the jump ending at record (2 for a macro-fused pair), 0 if it is
+ * not a jump or already has its boundary record
+ */
+static size_t spasm_x86_64_jump_site(SpasmInstructions* instructions, size_t record, bool* fused)
+{
+    const SpasmInstruction* instr = spasm_instructions_at(instructions, record);
+
+    *fused = false;
+
+    if(!spasm_x86_64_is_jump(instr->mnemonic))
+        return 0;
+
+    if(record > 0)
+    {
+        const SpasmInstruction* previous = spasm_instructions_at(instructions, record - 1);
+        const int cc = spasm_x86_64_jcc_condition(instr->mnemonic);
+
+        *fused = cc >= 0 && spasm_x86_64_macro_fuses(previous, cc);
+    }
+
+    const size_t start = record - (size_t)*fused;
+
+    if(start > 0 && spasm_instructions_at(instructions, start - 1)->mnemonic == SpasmMnemonic_Boundary)
+        return 0;
+
+    return (size_t)*fused + 1;
+}
+
+/* Fills the padding statistics from the layout of the stream in an empty buffer */
+static bool spasm_x86_64_branch_layout_stats(SpasmContext* ctx,
+                                             SpasmInstructions* instructions,
+                                             Spasm_x86_64_BranchLayoutStats* stats)
+{
+    Spasm_x86_64_Relaxation relax;
+
+    bool res = spasm_x86_64_relaxation_init(ctx, instructions, &relax);
+
+    res = res && spasm_x86_64_instructions_lengths(ctx, instructions, relax.sizes, relax.record_branches);
+    res = res && spasm_x86_64_relaxation_run(ctx, instructions, &relax);
+
+    for(size_t a = 0; res && a < relax.num_paddings; a++)
+    {
+        const size_t record = relax.padding_records[a];
+
+        if(spasm_instructions_at(instructions, record)->mnemonic != SpasmMnemonic_Boundary ||
+           relax.sizes[record] == 0)
+            continue;
+
+        stats->num_padded_sites++;
+        stats->num_padding_bytes += relax.sizes[record];
+    }
+
+    spasm_x86_64_relaxation_release(&relax);
+
+    return res;
+}
+
+bool spasm_x86_64_layout_branches(SpasmContext* ctx,
+                                  SpasmInstructions* instructions,
+                                  SpasmAlignPadding padding,
+                                  Spasm_x86_64_BranchLayoutStats* stats)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+
+    Spasm_x86_64_BranchLayoutStats layout_stats;
+    memset(&layout_stats, 0, sizeof(Spasm_x86_64_BranchLayoutStats));
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    size_t num_sites = 0;
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        bool fused = false;
+        const size_t covered = spasm_x86_64_jump_site(instructions, i, &fused);
+
+        num_sites += (size_t)(covered > 0);
+        layout_stats.num_jumps += (size_t)(covered > 0);
+        layout_stats.num_fused_pairs += (size_t)(covered > 0 && fused);
+    }
+
+    if(num_sites > 0)
+    {
+        if(!spasm_vector_reserve(&instructions->instructions, num_instructions + num_sites))
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            return false;
+        }
+
+        SpasmInstruction boundary;
+        memset(&boundary, 0, sizeof(SpasmInstruction));
+
+        boundary.mnemonic = SpasmMnemonic_Boundary;
+        boundary.num_operands = 3;
+        boundary.operands[0] = SpasmOpImm16(SPASM_X86_64_JUMP_BOUNDARY);
+        boundary.operands[1] = SpasmOpImm8(padding);
+
+        /*
+            In place from the end: each run of records moves up by the number of boundary records
+            still to insert before it, the records before it are not moved yet
+        */
+        SpasmInstruction* records = (SpasmInstruction*)instructions->instructions.data;
+
+        size_t remaining = num_sites;
+        size_t write_end = num_instructions + num_sites;
+
+        for(size_t end = num_instructions; end > 0 && remaining > 0;)
+        {
+            size_t start = end - 1;
+
+            bool fused = false;
+            const size_t covered = spasm_x86_64_jump_site(instructions, start, &fused);
+
+            start -= covered > 0 ? covered - 1 : 0;
+
+            write_end -= end - start;
+            memmove(&records[write_end], &records[start], (end - start) * sizeof(SpasmInstruction));
+
+            if(covered > 0)
+            {
+                boundary.operands[2] = SpasmOpImm8(covered);
+                records[--write_end] = boundary;
+                remaining--;
+            }
+
+            end = start;
+        }
+
+        instructions->instructions.size = num_instructions + num_sites;
+        instructions->num_paddings += (uint32_t)num_sites;
+
+        SPASM_CONTEXT_STAT_ADD(instructions->ctx, num_instructions_pushed, num_sites);
+    }
+
+    if(stats == NULL)
+        return true;
+
+    *stats = layout_stats;
+
+    return spasm_x86_64_branch_layout_stats(ctx, instructions, stats);
+}
+
 #endif /* defined(SPASM_ENABLE_X86_64) */
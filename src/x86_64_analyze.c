@@ -0,0 +1,690 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_ANALYSIS_NOT_ISSUED UINT32_MAX
+#define SPASM_X86_64_ANALYSIS_NO_PRODUCER UINT32_MAX
+
+/*
+    Instruction of the body producing a value read by another one, distance iterations earlier.
+    Registers read along a load (not its address) are only needed advance cycles after the issue
+*/
+typedef struct
+{
+    uint32_t producer;
+    uint16_t distance;
+    uint16_t advance;
+} Spasm_x86_64_AnalysisDependency;
+
+typedef struct
+{
+    const SpasmAllocator* allocator;
+    const Spasm_x86_64_UarchProfile* profile;
+
+    size_t num_instructions;
+    size_t num_iterations;
+    size_t trace_size;
+
+    size_t* stream_indices; /* Index in the stream of each instruction of the body */
+    Spasm_x86_64_InstructionCost* costs;
+    size_t* dependency_starts; /* Dependencies of instruction i, followed by the total */
+    Spasm_x86_64_AnalysisDependency* dependencies;
+    size_t num_dependencies;
+
+    /* Unrolled trace, instruction i of iteration k at k * num_instructions + i */
+    uint32_t* complete; /* Cycle the result is ready, when simulated with the ports */
+    uint32_t* chain_complete; /* Same with unlimited resources */
+    uint32_t* chain_producers; /* Producer the instruction waits for last, with unlimited resources */
+} Spasm_x86_64_Analyzer;
+
+static void spasm_x86_64_analyzer_release(Spasm_x86_64_Analyzer* analyzer)
+{
+    const size_t n = analyzer->num_instructions;
+
+    spasm_allocator_free(analyzer->allocator, analyzer->stream_indices, n * sizeof(size_t));
+    spasm_allocator_free(analyzer->allocator, analyzer->costs, n * sizeof(Spasm_x86_64_InstructionCost));
+    spasm_allocator_free(analyzer->allocator, analyzer->dependency_starts, (n + 1) * sizeof(size_t));
+    spasm_allocator_free(analyzer->allocator,
+                         analyzer->dependencies,
+                         analyzer->num_dependencies * sizeof(Spasm_x86_64_AnalysisDependency));
+    spasm_allocator_free(analyzer->allocator, analyzer->complete, analyzer->trace_size * sizeof(uint32_t));
+    spasm_allocator_free(analyzer->allocator, analyzer->chain_complete, analyzer->trace_size * sizeof(uint32_t));
+    spasm_allocator_free(analyzer->allocator, analyzer->chain_producers, analyzer->trace_size * sizeof(uint32_t));
+}
+
+/*
+    Each register or flag read depends on the last write before it in the body, or on the last write
+    of the previous iteration. Writes without reads in between are renamed away. Returns the number
+    of dependencies, only counted if dependencies is NULL (duplicates included)
+*/
+static size_t spasm_x86_64_analyzer_collect_dependencies(Spasm_x86_64_Analyzer* analyzer,
+                                                         const SpasmInstructions* instructions,
+                                                         Spasm_x86_64_AnalysisDependency* dependencies)
+{
+    uint32_t last_writers[64];
+    uint32_t writers[64];
+
+    for(size_t b = 0; b < 64; b++)
+    {
+        last_writers[b] = SPASM_X86_64_ANALYSIS_NO_PRODUCER;
+        writers[b] = SPASM_X86_64_ANALYSIS_NO_PRODUCER;
+    }
+
+    for(size_t i = 0; i < analyzer->num_instructions; i++)
+    {
+        Spasm_x86_64_RegisterSet defs;
+        Spasm_x86_64_RegisterSet uses;
+
+        spasm_x86_64_instruction_def_use(spasm_instructions_at(instructions, analyzer->stream_indices[i]), &defs, &uses);
+
+        for(size_t b = 0; b < 64; b++)
+            if(defs & ((Spasm_x86_64_RegisterSet)1 << b))
+                last_writers[b] = (uint32_t)i;
+    }
+
+    size_t num_dependencies = 0;
+
+    for(size_t i = 0; i < analyzer->num_instructions; i++)
+    {
+        Spasm_x86_64_RegisterSet defs;
+        Spasm_x86_64_RegisterSet uses;
+
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, analyzer->stream_indices[i]);
+
+        spasm_x86_64_instruction_def_use(instr, &defs, &uses);
+
+        Spasm_x86_64_RegisterSet address = 0;
+
+        for(uint8_t o = 0; o < instr->num_operands; o++)
+            if(instr->operands[o].type == SpasmOperandType_Mem)
+                address |= spasm_x86_64_register_set(instr->operands[o].mem_reg) |
+                           spasm_x86_64_register_set(instr->operands[o].mem_index);
+
+        const uint16_t advance = analyzer->costs[i].load ? analyzer->profile->load_latency : 0;
+
+        const size_t first = num_dependencies;
+
+        analyzer->dependency_starts[i] = first;
+
+        for(size_t b = 0; b < 64; b++)
+        {
+            if(!(uses & ((Spasm_x86_64_RegisterSet)1 << b)))
+                continue;
+
+            const uint16_t bit_advance = address & ((Spasm_x86_64_RegisterSet)1 << b) ? 0 : advance;
+
+            Spasm_x86_64_AnalysisDependency dependency = { writers[b], 0, bit_advance };
+
+            if(dependency.producer == SPASM_X86_64_ANALYSIS_NO_PRODUCER)
+                dependency = (Spasm_x86_64_AnalysisDependency){ last_writers[b], 1, bit_advance };
+
+            if(dependency.producer == SPASM_X86_64_ANALYSIS_NO_PRODUCER)
+                continue;
+
+            size_t found = SIZE_MAX;
+
+            if(dependencies != NULL)
+                for(size_t d = first; d < num_dependencies && found == SIZE_MAX; d++)
+                    if(dependencies[d].producer == dependency.producer && dependencies[d].distance == dependency.distance)
+                        found = d;
+
+            /* A value used as an address and as data is needed for the address */
+            if(found != SIZE_MAX)
+            {
+                dependencies[found].advance = SPASM_MIN(dependencies[found].advance, dependency.advance);
+                continue;
+            }
+
+            if(dependencies != NULL)
+                dependencies[num_dependencies] = dependency;
+
+            num_dependencies++;
+        }
+
+        for(size_t b = 0; b < 64; b++)
+            if(defs & ((Spasm_x86_64_RegisterSet)1 << b))
+                writers[b] = (uint32_t)i;
+    }
+
+    analyzer->dependency_starts[analyzer->num_instructions] = num_dependencies;
+
+    return num_dependencies;
+}
+
+/* Trace index of the producer of a dependency of trace instruction t, NO_PRODUCER before the first iteration */
+static SPASM_FORCE_INLINE uint32_t spasm_x86_64_analyzer_producer(const Spasm_x86_64_Analyzer* analyzer,
+                                                                  size_t t,
+                                                                  const Spasm_x86_64_AnalysisDependency* dependency)
+{
+    const size_t iteration = t / analyzer->num_instructions;
+
+    if(dependency->distance > iteration)
+        return SPASM_X86_64_ANALYSIS_NO_PRODUCER;
+
+    return (uint32_t)((iteration - dependency->distance) * analyzer->num_instructions + dependency->producer);
+}
+
+/*
+    Cycle by cycle: retire the completed instructions in order, dispatch up to issue_width in the
+    window, and issue the ready ones, oldest first, on the lowest free port of their class. Returns
+    the cycle the last result is ready
+*/
+static uint32_t spasm_x86_64_analyzer_simulate(Spasm_x86_64_Analyzer* analyzer, size_t* port_cycles)
+{
+    const Spasm_x86_64_UarchProfile* profile = analyzer->profile;
+    const size_t n = analyzer->num_instructions;
+
+    for(size_t t = 0; t < analyzer->trace_size; t++)
+        analyzer->complete[t] = SPASM_X86_64_ANALYSIS_NOT_ISSUED;
+
+    uint32_t cycle = 0;
+    uint32_t end = 0;
+    size_t head = 0;
+    size_t dispatched = 0;
+
+    while(head < analyzer->trace_size)
+    {
+        while(head < dispatched && analyzer->complete[head] <= cycle)
+            head++;
+
+        for(uint8_t i = 0; i < profile->issue_width; i++)
+        {
+            if(dispatched == analyzer->trace_size || dispatched - head == SPASM_X86_64_ANALYSIS_WINDOW)
+                break;
+
+            dispatched++;
+        }
+
+        uint8_t ports_used = 0;
+        uint8_t loads_used = 0;
+        uint8_t stores_used = 0;
+
+        for(size_t t = head; t < dispatched; t++)
+        {
+            if(analyzer->complete[t] != SPASM_X86_64_ANALYSIS_NOT_ISSUED)
+                continue;
+
+            const size_t i = t % n;
+            const Spasm_x86_64_InstructionCost* cost = &analyzer->costs[i];
+
+            const uint8_t free_ports = cost->ports & ~ports_used;
+
+            if(free_ports == 0 ||
+               (cost->load && loads_used == profile->num_load_ports) ||
+               (cost->store && stores_used == profile->num_store_ports))
+                continue;
+
+            bool ready = true;
+
+            for(size_t d = analyzer->dependency_starts[i]; d < analyzer->dependency_starts[i + 1] && ready; d++)
+            {
+                const uint32_t producer = spasm_x86_64_analyzer_producer(analyzer, t, &analyzer->dependencies[d]);
+
+                ready = producer == SPASM_X86_64_ANALYSIS_NO_PRODUCER ||
+                        (analyzer->complete[producer] != SPASM_X86_64_ANALYSIS_NOT_ISSUED &&
+                         analyzer->complete[producer] <= cycle + analyzer->dependencies[d].advance);
+            }
+
+            if(!ready)
+                continue;
+
+            const uint8_t port = free_ports & (uint8_t)-free_ports;
+
+            ports_used |= port;
+            loads_used += cost->load;
+            stores_used += cost->store;
+
+            for(size_t p = 0; p < SPASM_X86_64_ANALYSIS_MAX_PORTS; p++)
+                port_cycles[p] += (port >> p) & 1;
+
+            analyzer->complete[t] = cycle + cost->latency;
+
+            if(analyzer->complete[t] > end)
+                end = analyzer->complete[t];
+        }
+
+        cycle++;
+    }
+
+    return end;
+}
+
+/* Completion of each instruction with unlimited resources, only waiting for its operands */
+static void spasm_x86_64_analyzer_chains(Spasm_x86_64_Analyzer* analyzer)
+{
+    const size_t n = analyzer->num_instructions;
+
+    for(size_t t = 0; t < analyzer->trace_size; t++)
+    {
+        const size_t i = t % n;
+
+        uint32_t start = 0;
+        uint32_t last_producer = SPASM_X86_64_ANALYSIS_NO_PRODUCER;
+
+        for(size_t d = analyzer->dependency_starts[i]; d < analyzer->dependency_starts[i + 1]; d++)
+        {
+            const uint32_t producer = spasm_x86_64_analyzer_producer(analyzer, t, &analyzer->dependencies[d]);
+
+            if(producer == SPASM_X86_64_ANALYSIS_NO_PRODUCER)
+                continue;
+
+            const uint32_t advance = analyzer->dependencies[d].advance;
+            const uint32_t ready = analyzer->chain_complete[producer] > advance ?
+                                       analyzer->chain_complete[producer] - advance : 0;
+
+            if(ready > start || last_producer == SPASM_X86_64_ANALYSIS_NO_PRODUCER)
+            {
+                start = ready;
+                last_producer = producer;
+            }
+        }
+
+        analyzer->chain_complete[t] = start + analyzer->costs[i].latency;
+        analyzer->chain_producers[t] = last_producer;
+    }
+}
+
+static uint32_t spasm_x86_64_analyzer_iteration_end(const Spasm_x86_64_Analyzer* analyzer, size_t iteration, size_t* last)
+{
+    const size_t n = analyzer->num_instructions;
+
+    uint32_t end = 0;
+
+    for(size_t t = iteration * n; t < (iteration + 1) * n; t++)
+    {
+        if(analyzer->chain_complete[t] >= end)
+        {
+            end = analyzer->chain_complete[t];
+
+            if(last != NULL)
+                *last = t;
+        }
+    }
+
+    return end;
+}
+
+/*
+    Walks back the producers from the last result of the last iteration. Reaching the same
+    instruction of the body again closes a recurrence, which is the chain reported. Otherwise it is
+    the whole path walked
+*/
+static bool spasm_x86_64_analyzer_critical_path(Spasm_x86_64_Analyzer* analyzer, Spasm_x86_64_Analysis* analysis)
+{
+    const size_t n = analyzer->num_instructions;
+
+    size_t* path = (size_t*)spasm_allocator_alloc(analyzer->allocator, analyzer->trace_size * sizeof(size_t));
+    size_t* seen = (size_t*)spasm_allocator_alloc(analyzer->allocator, n * sizeof(size_t));
+
+    if(path == NULL || seen == NULL)
+    {
+        spasm_allocator_free(analyzer->allocator, path, analyzer->trace_size * sizeof(size_t));
+        spasm_allocator_free(analyzer->allocator, seen, n * sizeof(size_t));
+        return false;
+    }
+
+    for(size_t i = 0; i < n; i++)
+        seen[i] = SIZE_MAX;
+
+    size_t last = 0;
+    spasm_x86_64_analyzer_iteration_end(analyzer, analyzer->num_iterations - 1, &last);
+
+    size_t path_size = 0;
+    size_t cycle_start = SIZE_MAX;
+    uint32_t t = (uint32_t)last;
+
+    while(t != SPASM_X86_64_ANALYSIS_NO_PRODUCER)
+    {
+        if(seen[t % n] != SIZE_MAX)
+        {
+            cycle_start = seen[t % n];
+            break;
+        }
+
+        seen[t % n] = path_size;
+        path[path_size++] = t;
+        t = analyzer->chain_producers[t];
+    }
+
+    /* The path goes backwards, the recurrence is path[cycle_start..path_size[ */
+    const size_t first = cycle_start == SIZE_MAX ? 0 : cycle_start;
+    const size_t size = path_size - first;
+
+    analysis->critical_path = (size_t*)spasm_allocator_alloc(analyzer->allocator, size * sizeof(size_t));
+
+    if(analysis->critical_path == NULL)
+    {
+        spasm_allocator_free(analyzer->allocator, path, analyzer->trace_size * sizeof(size_t));
+        spasm_allocator_free(analyzer->allocator, seen, n * sizeof(size_t));
+        return false;
+    }
+
+    analysis->critical_path_size = size;
+
+    for(size_t i = 0; i < size; i++)
+        analysis->critical_path[i] = analyzer->stream_indices[path[path_size - 1 - i] % n];
+
+    /* One turn of the recurrence ends where the previous one did, t is the end of the previous turn */
+    analysis->critical_path_latency = analyzer->chain_complete[path[first]] -
+                                      (cycle_start == SIZE_MAX ? 0 : analyzer->chain_complete[t]);
+
+    spasm_allocator_free(analyzer->allocator, path, analyzer->trace_size * sizeof(size_t));
+    spasm_allocator_free(analyzer->allocator, seen, n * sizeof(size_t));
+
+    return true;
+}
+
+/*
+    Port bound: the instructions whose ports are all in a set of ports need at least their count
+    divided by the size of the set cycles, the worst set gives the bound (and the bottleneck ports)
+*/
+static void spasm_x86_64_analyzer_port_bound(const Spasm_x86_64_Analyzer* analyzer, Spasm_x86_64_Analysis* analysis)
+{
+    size_t counts[256];
+    memset(counts, 0, sizeof(counts));
+
+    for(size_t i = 0; i < analyzer->num_instructions; i++)
+        counts[analyzer->costs[i].ports]++;
+
+    double bound = 0.0;
+    uint8_t bound_ports = 0;
+
+    for(size_t set = 1; set < 256; set++)
+    {
+        size_t count = 0;
+        size_t set_size = 0;
+
+        for(size_t mask = 1; mask < 256; mask++)
+            if((mask & ~set) == 0)
+                count += counts[mask];
+
+        for(size_t p = 0; p < SPASM_X86_64_ANALYSIS_MAX_PORTS; p++)
+            set_size += (set >> p) & 1;
+
+        const double set_bound = (double)count / (double)set_size;
+
+        if(set_bound > bound)
+        {
+            bound = set_bound;
+            bound_ports = (uint8_t)set;
+        }
+    }
+
+    analysis->bounds[Spasm_x86_64_Bottleneck_Ports] = bound;
+    analysis->bottleneck_ports = bound_ports;
+}
+
+bool spasm_x86_64_analyze(SpasmContext* ctx,
+                          const SpasmInstructions* instructions,
+                          const Spasm_x86_64_AnalysisConfig* config,
+                          Spasm_x86_64_Analysis* analysis)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+    SPASM_ASSERT(analysis != NULL, "analysis is NULL");
+
+    memset(analysis, 0, sizeof(Spasm_x86_64_Analysis));
+
+    const Spasm_x86_64_Uarch uarch = config != NULL ? config->uarch : Spasm_x86_64_Uarch_Generic;
+    const Spasm_x86_64_UarchProfile* profile = spasm_x86_64_get_uarch_profile(uarch);
+
+    if(profile == NULL)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedUarch, NULL, 0);
+        return false;
+    }
+
+    Spasm_x86_64_Analyzer analyzer;
+    memset(&analyzer, 0, sizeof(Spasm_x86_64_Analyzer));
+
+    analyzer.allocator = spasm_context_get_allocator(instructions->ctx);
+    analyzer.profile = profile;
+    analyzer.num_iterations = config != NULL && config->num_iterations != 0 ? config->num_iterations :
+                                                                               SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS;
+
+    analysis->allocator = analyzer.allocator;
+    analysis->uarch = uarch;
+    analysis->num_iterations = analyzer.num_iterations;
+
+    const size_t num_stream_instructions = spasm_instructions_size(instructions);
+
+    for(size_t i = 0; i < num_stream_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+            continue;
+
+        if(spasm_x86_64_instruction_access(instr) == NULL)
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+            return false;
+        }
+
+        analyzer.num_instructions++;
+    }
+
+    const size_t n = analyzer.num_instructions;
+
+    if(n == 0)
+        return true;
+
+    analyzer.trace_size = n * analyzer.num_iterations;
+
+    analyzer.stream_indices = (size_t*)spasm_allocator_alloc(analyzer.allocator, n * sizeof(size_t));
+    analyzer.costs = (Spasm_x86_64_InstructionCost*)spasm_allocator_alloc(analyzer.allocator,
+                                                                          n * sizeof(Spasm_x86_64_InstructionCost));
+    analyzer.dependency_starts = (size_t*)spasm_allocator_alloc(analyzer.allocator, (n + 1) * sizeof(size_t));
+    analyzer.complete = (uint32_t*)spasm_allocator_alloc(analyzer.allocator, analyzer.trace_size * sizeof(uint32_t));
+    analyzer.chain_complete = (uint32_t*)spasm_allocator_alloc(analyzer.allocator, analyzer.trace_size * sizeof(uint32_t));
+    analyzer.chain_producers = (uint32_t*)spasm_allocator_alloc(analyzer.allocator, analyzer.trace_size * sizeof(uint32_t));
+
+    if(analyzer.stream_indices == NULL ||
+       analyzer.costs == NULL ||
+       analyzer.dependency_starts == NULL ||
+       analyzer.complete == NULL ||
+       analyzer.chain_complete == NULL ||
+       analyzer.chain_producers == NULL)
+    {
+        spasm_x86_64_analyzer_release(&analyzer);
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    size_t num_loads = 0;
+    size_t num_stores = 0;
+
+    for(size_t i = 0, body_index = 0; i < num_stream_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+            continue;
+
+        analyzer.stream_indices[body_index] = i;
+        spasm_x86_64_instruction_cost(instr, uarch, &analyzer.costs[body_index]);
+
+        num_loads += analyzer.costs[body_index].load;
+        num_stores += analyzer.costs[body_index].store;
+
+        body_index++;
+    }
+
+    analyzer.num_dependencies = spasm_x86_64_analyzer_collect_dependencies(&analyzer, instructions, NULL);
+
+    if(analyzer.num_dependencies > 0)
+    {
+        analyzer.dependencies = (Spasm_x86_64_AnalysisDependency*)spasm_allocator_alloc(
+            analyzer.allocator,
+            analyzer.num_dependencies * sizeof(Spasm_x86_64_AnalysisDependency));
+
+        if(analyzer.dependencies == NULL)
+        {
+            analyzer.num_dependencies = 0;
+            spasm_x86_64_analyzer_release(&analyzer);
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            return false;
+        }
+    }
+
+    spasm_x86_64_analyzer_collect_dependencies(&analyzer, instructions, analyzer.dependencies);
+
+    size_t port_cycles[SPASM_X86_64_ANALYSIS_MAX_PORTS];
+    memset(port_cycles, 0, sizeof(port_cycles));
+
+    const double num_iterations = (double)analyzer.num_iterations;
+
+    analysis->num_instructions = n;
+    analysis->total_cycles = spasm_x86_64_analyzer_simulate(&analyzer, port_cycles);
+    analysis->cycles_per_iteration = (double)analysis->total_cycles / num_iterations;
+    analysis->ipc = (double)analyzer.trace_size / (double)analysis->total_cycles;
+
+    for(size_t p = 0; p < SPASM_X86_64_ANALYSIS_MAX_PORTS; p++)
+        analysis->port_pressure[p] = (double)port_cycles[p] / num_iterations;
+
+    /* The dependency bound is the growth of the chains per iteration, over the second half */
+    spasm_x86_64_analyzer_chains(&analyzer);
+
+    if(analyzer.num_iterations == 1)
+    {
+        analysis->bounds[Spasm_x86_64_Bottleneck_Dependencies] = spasm_x86_64_analyzer_iteration_end(&analyzer, 0, NULL);
+    }
+    else
+    {
+        const size_t half = analyzer.num_iterations / 2;
+        const uint32_t half_end = spasm_x86_64_analyzer_iteration_end(&analyzer, half - 1, NULL);
+        const uint32_t end = spasm_x86_64_analyzer_iteration_end(&analyzer, analyzer.num_iterations - 1, NULL);
+
+        analysis->bounds[Spasm_x86_64_Bottleneck_Dependencies] = (double)(end - half_end) /
+                                                                 (double)(analyzer.num_iterations - half);
+    }
+
+    analysis->bounds[Spasm_x86_64_Bottleneck_Issue] = (double)n / (double)profile->issue_width;
+    analysis->bounds[Spasm_x86_64_Bottleneck_Loads] = (double)num_loads / (double)profile->num_load_ports;
+    analysis->bounds[Spasm_x86_64_Bottleneck_Stores] = (double)num_stores / (double)profile->num_store_ports;
+
+    spasm_x86_64_analyzer_port_bound(&analyzer, analysis);
+
+    analysis->bottleneck = Spasm_x86_64_Bottleneck_Dependencies;
+
+    for(size_t b = 0; b < Spasm_x86_64_Bottleneck_COUNT; b++)
+        if(analysis->bounds[b] > analysis->bounds[analysis->bottleneck])
+            analysis->bottleneck = (Spasm_x86_64_Bottleneck)b;
+
+    const bool res = spasm_x86_64_analyzer_critical_path(&analyzer, analysis);
+
+    spasm_x86_64_analyzer_release(&analyzer);
+
+    if(!res)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    return true;
+}
+
+void spasm_x86_64_analysis_release(Spasm_x86_64_Analysis* analysis)
+{
+    SPASM_ASSERT(analysis != NULL, "analysis is NULL");
+
+    spasm_allocator_free(analysis->allocator, analysis->critical_path, analysis->critical_path_size * sizeof(size_t));
+
+    analysis->critical_path = NULL;
+    analysis->critical_path_size = 0;
+}
+
+static const char* spasm_x86_64_bottleneck_as_string[Spasm_x86_64_Bottleneck_COUNT] = {
+    "dependencies",
+    "issue",
+    "ports",
+    "loads",
+    "stores",
+};
+
+void spasm_x86_64_analysis_print(const Spasm_x86_64_Analysis* analysis,
+                                 const SpasmInstructions* instructions,
+                                 FILE* stream)
+{
+    SPASM_ASSERT(analysis != NULL, "analysis is NULL");
+    SPASM_ASSERT(stream != NULL, "stream is NULL");
+
+    const Spasm_x86_64_UarchProfile* profile = spasm_x86_64_get_uarch_profile(analysis->uarch);
+
+    if(profile == NULL)
+        return;
+
+    fprintf(stream, "Microarchitecture:    %s\n", profile->name);
+    fprintf(stream, "Iterations:           %zu\n", analysis->num_iterations);
+    fprintf(stream, "Instructions:         %zu\n", analysis->num_instructions * analysis->num_iterations);
+    fprintf(stream, "Total cycles:         %zu\n", analysis->total_cycles);
+    fprintf(stream, "Cycles per iteration: %.2f\n", analysis->cycles_per_iteration);
+    fprintf(stream, "IPC:                  %.2f\n", analysis->ipc);
+    fprintf(stream, "Bottleneck:           %s\n", spasm_x86_64_bottleneck_as_string[analysis->bottleneck]);
+
+    fprintf(stream, "\nBounds (cycles per iteration):\n");
+
+    for(size_t b = 0; b < Spasm_x86_64_Bottleneck_COUNT; b++)
+    {
+        fprintf(stream, "  %-13s %.2f", spasm_x86_64_bottleneck_as_string[b], analysis->bounds[b]);
+
+        if(b == Spasm_x86_64_Bottleneck_Ports)
+        {
+            fprintf(stream, " (");
+
+            for(size_t p = 0, first = 1; p < SPASM_X86_64_ANALYSIS_MAX_PORTS; p++)
+            {
+                if(!((analysis->bottleneck_ports >> p) & 1))
+                    continue;
+
+                fprintf(stream, first ? "p%zu" : " p%zu", p);
+                first = 0;
+            }
+
+            fprintf(stream, ")");
+        }
+
+        fprintf(stream, "\n");
+    }
+
+    uint8_t profile_ports = 0;
+
+    for(size_t c = 0; c < Spasm_x86_64_CostClass_COUNT; c++)
+        profile_ports |= profile->classes[c].ports;
+
+    fprintf(stream, "\nPort pressure (cycles per iteration):\n");
+
+    for(size_t p = 0; p < SPASM_X86_64_ANALYSIS_MAX_PORTS; p++)
+        if((profile_ports >> p) & 1)
+            fprintf(stream, "  p%zu %.2f\n", p, analysis->port_pressure[p]);
+
+    fprintf(stream, "\nCritical chain (latency %u):\n", analysis->critical_path_latency);
+
+    for(size_t i = 0; i < analysis->critical_path_size; i++)
+    {
+        char buffer[256];
+
+        const size_t index = analysis->critical_path[i];
+
+        const size_t size = spasm_x86_64_instruction_debug(spasm_instructions_at(instructions, index),
+                                                           buffer,
+                                                           sizeof(buffer));
+
+        fprintf(stream, "  %4zu  %.*s\n", index, (int)SPASM_MIN(size, sizeof(buffer) - 1), buffer);
+    }
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,571 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/abi.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_CALL_SHADOW_SPACE 32
+
+/* Move of a value to the register it is passed in */
+typedef struct
+{
+    SpasmOperand src;
+    SpasmRegister dst; /* View of the destination register with the width of the move */
+    uint8_t type; /* Spasm_x86_64_CallArgType */
+    bool address; /* lea of src, for values of RSP */
+    Spasm_x86_64_RegisterSet reads;
+} Spasm_x86_64_CallMove;
+
+typedef struct
+{
+    SpasmInstructions* instructions;
+    Spasm_x86_64_CallMove moves[SPASM_X86_64_CALL_MAX_ARGS + 1];
+    size_t num_moves;
+    SpasmRegister gp_scratch;
+    SpasmRegister vector_scratch;
+    bool missing_scratch; /* The arguments read all the scratch candidates */
+    bool ok;
+} Spasm_x86_64_CallLowering;
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_call_is_gp(SpasmRegister reg)
+{
+    return reg >= SpasmRegister_x86_64_AL && reg <= SpasmRegister_x86_64_R15;
+}
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_call_is_vector(SpasmRegister reg)
+{
+    return reg >= SpasmRegister_x86_64_XMM0 && reg <= SpasmRegister_x86_64_ZMM15;
+}
+
+/* View of the register of reg in the width starting at first (AL, AX, EAX, RAX or XMM0) */
+static SPASM_FORCE_INLINE SpasmRegister spasm_x86_64_call_view(SpasmRegister reg, SpasmRegister first)
+{
+    const SpasmRegister base = spasm_x86_64_call_is_gp(reg) ? SpasmRegister_x86_64_AL : SpasmRegister_x86_64_XMM0;
+
+    return (SpasmRegister)(first + (reg - base) % 16);
+}
+
+/* First register of the width of a general purpose register */
+static SPASM_FORCE_INLINE SpasmRegister spasm_x86_64_call_width(SpasmRegister reg)
+{
+    return (SpasmRegister)(SpasmRegister_x86_64_AL + (reg - SpasmRegister_x86_64_AL) / 16 * 16);
+}
+
+static Spasm_x86_64_RegisterSet spasm_x86_64_call_reads(const SpasmOperand* operand)
+{
+    switch(operand->type)
+    {
+        case SpasmOperandType_Register:
+            return spasm_x86_64_register_set(operand->reg);
+        case SpasmOperandType_Mem:
+            return spasm_x86_64_register_set(operand->mem_reg) | spasm_x86_64_register_set(operand->mem_index);
+        default:
+            return 0;
+    }
+}
+
+static bool spasm_x86_64_call_is_immediate(const SpasmOperand* operand)
+{
+    return operand->type >= SpasmOperandType_Imm8 && operand->type <= SpasmOperandType_Imm64;
+}
+
+static bool spasm_x86_64_call_check(const Spasm_x86_64_CallArg* arg, bool immediate_allowed)
+{
+    const SpasmOperand* value = &arg->value;
+
+    if(value->type == SpasmOperandType_Mem)
+        return value->mem_reg != SPASM_VIRTUAL_REGISTER && value->mem_index != SPASM_VIRTUAL_REGISTER;
+
+    switch(arg->type)
+    {
+        case Spasm_x86_64_CallArgType_Int:
+            return (value->type == SpasmOperandType_Register && spasm_x86_64_call_is_gp(value->reg)) ||
+                   (immediate_allowed && spasm_x86_64_call_is_immediate(value));
+        case Spasm_x86_64_CallArgType_Float:
+        case Spasm_x86_64_CallArgType_Double:
+            return value->type == SpasmOperandType_Register && spasm_x86_64_call_is_vector(value->reg);
+        default:
+            return false;
+    }
+}
+
+static SpasmMnemonic spasm_x86_64_call_scalar_move(uint8_t type)
+{
+    return type == Spasm_x86_64_CallArgType_Float ? SpasmMnemonic_x86_64_MOVSS : SpasmMnemonic_x86_64_MOVSD;
+}
+
+/* Shortest sequence for an integer constant: xor, zero-extended mov r32 or sign-extended mov r64 */
+static bool spasm_x86_64_call_emit_immediate(SpasmInstructions* instructions, SpasmRegister reg, int64_t value)
+{
+    const SpasmOperand reg32 = SpasmOpReg(spasm_x86_64_call_view(reg, SpasmRegister_x86_64_EAX));
+    const SpasmOperand reg64 = SpasmOpReg(spasm_x86_64_call_view(reg, SpasmRegister_x86_64_RAX));
+
+    if(value == 0)
+        return spasm_instructions_push(instructions, SpasmMnemonic_x86_64_XOR, reg32, reg32);
+
+    if(value > 0 && value <= (int64_t)UINT32_MAX)
+        return spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, reg32, SpasmOpImm32((int32_t)(uint32_t)value));
+
+    if(value >= INT32_MIN && value < 0)
+        return spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, reg64, SpasmOpImm32(value));
+
+    return spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, reg64, SpasmOpImm64(value));
+}
+
+static bool spasm_x86_64_call_emit_move(SpasmInstructions* instructions, const Spasm_x86_64_CallMove* move)
+{
+    const SpasmOperand dst = SpasmOpReg(move->dst);
+
+    switch(move->src.type)
+    {
+        case SpasmOperandType_Register:
+            return spasm_instructions_push(instructions,
+                                           move->type == Spasm_x86_64_CallArgType_Int ? SpasmMnemonic_x86_64_MOV :
+                                                                                        SpasmMnemonic_x86_64_MOVAPS,
+                                           dst,
+                                           move->src);
+        case SpasmOperandType_Mem:
+            return spasm_instructions_push(instructions,
+                                           move->address ? SpasmMnemonic_x86_64_LEA :
+                                           move->type == Spasm_x86_64_CallArgType_Int ? SpasmMnemonic_x86_64_MOV :
+                                                                                        spasm_x86_64_call_scalar_move(move->type),
+                                           dst,
+                                           move->src);
+        default:
+            return spasm_x86_64_call_emit_immediate(instructions, move->dst, move->src.imm_value);
+    }
+}
+
+/* Value of an argument, RSP moved down by area */
+static void spasm_x86_64_call_source(const Spasm_x86_64_CallArg* arg,
+                                     uint32_t area,
+                                     SpasmOperand* src,
+                                     bool* address)
+{
+    *src = arg->value;
+    *address = false;
+
+    if(src->type == SpasmOperandType_Register && src->reg == SpasmRegister_x86_64_RSP)
+    {
+        *src = SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 0);
+        *address = true;
+    }
+
+    if(src->type == SpasmOperandType_Mem && src->mem_reg == SpasmRegister_x86_64_RSP)
+        src->mem_displacement += (int32_t)area;
+}
+
+static void spasm_x86_64_call_add_move(Spasm_x86_64_CallLowering* lowering,
+                                       const Spasm_x86_64_CallArg* arg,
+                                       SpasmRegister reg,
+                                       uint32_t area)
+{
+    Spasm_x86_64_CallMove* move = &lowering->moves[lowering->num_moves];
+    spasm_x86_64_call_source(arg, area, &move->src, &move->address);
+
+    move->type = arg->type;
+    move->reads = spasm_x86_64_call_reads(&move->src);
+
+    if(move->type != Spasm_x86_64_CallArgType_Int)
+        move->dst = spasm_x86_64_call_view(reg, SpasmRegister_x86_64_XMM0);
+    else if(move->src.type == SpasmOperandType_Register)
+        move->dst = spasm_x86_64_call_view(reg, spasm_x86_64_call_width(move->src.reg));
+    else
+        move->dst = spasm_x86_64_call_view(reg, SpasmRegister_x86_64_RAX);
+
+    /* Already in place */
+    if(move->src.type == SpasmOperandType_Register &&
+       move->reads == spasm_x86_64_register_set(move->dst))
+        return;
+
+    if(move->type != Spasm_x86_64_CallArgType_Int && move->src.type == SpasmOperandType_Register)
+        move->src.reg = (uint8_t)spasm_x86_64_call_view(move->src.reg, SpasmRegister_x86_64_XMM0);
+
+    lowering->num_moves++;
+}
+
+/* Stores an argument passed on the stack, before any argument register is written */
+static void spasm_x86_64_call_store(Spasm_x86_64_CallLowering* lowering,
+                                    const Spasm_x86_64_CallArg* arg,
+                                    int32_t offset,
+                                    uint32_t area)
+{
+    SpasmInstructions* instructions = lowering->instructions;
+    const SpasmOperand slot = SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, offset, 0);
+
+    if(arg->value.type == SpasmOperandType_Register && arg->value.reg != SpasmRegister_x86_64_RSP)
+    {
+        if(arg->type == Spasm_x86_64_CallArgType_Int)
+            lowering->ok &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, slot, arg->value);
+        else
+            lowering->ok &= spasm_instructions_push(instructions,
+                                                    spasm_x86_64_call_scalar_move(arg->type),
+                                                    slot,
+                                                    SpasmOpReg(spasm_x86_64_call_view(arg->value.reg, SpasmRegister_x86_64_XMM0)));
+        return;
+    }
+
+    /* Memory to memory, through the scratch register */
+    if(lowering->gp_scratch == SpasmRegister_x86_64_NONE)
+    {
+        lowering->missing_scratch = true;
+        lowering->ok = false;
+        return;
+    }
+
+    Spasm_x86_64_CallMove move;
+    spasm_x86_64_call_source(arg, area, &move.src, &move.address);
+
+    move.type = Spasm_x86_64_CallArgType_Int;
+    move.dst = spasm_x86_64_call_view(lowering->gp_scratch,
+                                      arg->type == Spasm_x86_64_CallArgType_Float ? SpasmRegister_x86_64_EAX :
+                                                                                    SpasmRegister_x86_64_RAX);
+
+    lowering->ok &= spasm_x86_64_call_emit_move(instructions, &move) &&
+                    spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, slot, SpasmOpReg(move.dst));
+}
+
+/* Makes the moves reading reg read the scratch register instead */
+static void spasm_x86_64_call_rename(Spasm_x86_64_CallLowering* lowering, SpasmRegister reg, SpasmRegister scratch)
+{
+    const Spasm_x86_64_RegisterSet set = spasm_x86_64_register_set(reg);
+
+    for(size_t i = 0; i < lowering->num_moves; i++)
+    {
+        Spasm_x86_64_CallMove* move = &lowering->moves[i];
+
+        if(!(move->reads & set))
+            continue;
+
+        if(move->src.type == SpasmOperandType_Register)
+        {
+            const SpasmRegister width = spasm_x86_64_call_is_gp(move->src.reg) ? spasm_x86_64_call_width(move->src.reg) :
+                                                                                 SpasmRegister_x86_64_XMM0;
+            move->src.reg = (uint8_t)spasm_x86_64_call_view(scratch, width);
+        }
+        else
+        {
+            if(spasm_x86_64_register_set(move->src.mem_reg) & set)
+                move->src.mem_reg = (uint8_t)spasm_x86_64_call_view(scratch, SpasmRegister_x86_64_RAX);
+
+            if(spasm_x86_64_register_set(move->src.mem_index) & set)
+                move->src.mem_index = (uint8_t)spasm_x86_64_call_view(scratch, SpasmRegister_x86_64_RAX);
+        }
+
+        move->reads = (move->reads & ~set) | spasm_x86_64_register_set(scratch);
+    }
+}
+
+/*
+    Emits the moves once nothing pending reads the register they write. When all of them are
+    blocked, the pending moves form cycles: the register written by the first one is copied to the
+    scratch register, and its readers are renamed to read the copy
+*/
+static void spasm_x86_64_call_parallel_move(Spasm_x86_64_CallLowering* lowering)
+{
+    while(lowering->ok && lowering->num_moves > 0)
+    {
+        bool progress = false;
+
+        for(size_t i = 0; i < lowering->num_moves;)
+        {
+            const Spasm_x86_64_RegisterSet written = spasm_x86_64_register_set(lowering->moves[i].dst);
+
+            bool blocked = false;
+
+            for(size_t j = 0; j < lowering->num_moves && !blocked; j++)
+                blocked = j != i && (lowering->moves[j].reads & written);
+
+            if(blocked)
+            {
+                i++;
+                continue;
+            }
+
+            lowering->ok &= spasm_x86_64_call_emit_move(lowering->instructions, &lowering->moves[i]);
+
+            /* Kept in argument order */
+            memmove(&lowering->moves[i], &lowering->moves[i + 1], (--lowering->num_moves - i) * sizeof(Spasm_x86_64_CallMove));
+            progress = true;
+        }
+
+        if(progress || lowering->num_moves == 0)
+            continue;
+
+        const Spasm_x86_64_CallMove* move = &lowering->moves[0];
+        const bool vector = move->type != Spasm_x86_64_CallArgType_Int;
+        const SpasmRegister scratch = vector ? lowering->vector_scratch : lowering->gp_scratch;
+
+        Spasm_x86_64_RegisterSet pending_reads = 0;
+
+        for(size_t i = 0; i < lowering->num_moves; i++)
+            pending_reads |= lowering->moves[i].reads;
+
+        /* A load of a previous cycle can still read the copy */
+        if(scratch == SpasmRegister_x86_64_NONE || (pending_reads & spasm_x86_64_register_set(scratch)))
+        {
+            lowering->missing_scratch = true;
+            lowering->ok = false;
+            break;
+        }
+
+        const SpasmRegister first = vector ? SpasmRegister_x86_64_XMM0 : SpasmRegister_x86_64_RAX;
+        const SpasmRegister reg = spasm_x86_64_call_view(move->dst, first);
+
+        lowering->ok &= spasm_instructions_push(lowering->instructions,
+                                                vector ? SpasmMnemonic_x86_64_MOVAPS : SpasmMnemonic_x86_64_MOV,
+                                                SpasmOpReg(spasm_x86_64_call_view(scratch, first)),
+                                                SpasmOpReg(reg));
+
+        spasm_x86_64_call_rename(lowering, reg, scratch);
+    }
+}
+
+/*
+    Caller-saved register that no argument is passed in and no move reads: the registers never used
+    for arguments first, then the argument registers left free by this call
+*/
+static SpasmRegister spasm_x86_64_call_scratch(const SpasmRegister* candidates,
+                                               size_t num_candidates,
+                                               Spasm_x86_64_RegisterSet excluded)
+{
+    for(size_t i = 0; i < num_candidates; i++)
+        if(!(spasm_x86_64_register_set(candidates[i]) & excluded))
+            return candidates[i];
+
+    return SpasmRegister_x86_64_NONE;
+}
+
+bool spasm_x86_64_emit_call(SpasmContext* ctx,
+                            SpasmInstructions* instructions,
+                            SpasmABI abi,
+                            SpasmOperand target,
+                            const Spasm_x86_64_CallArg* args,
+                            size_t num_args,
+                            const Spasm_x86_64_CallArg* result)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+    SPASM_ASSERT(args != NULL || num_args == 0, "args is NULL");
+
+    if(abi == SpasmABI_Invalid)
+        abi = spasm_get_current_abi();
+
+    if(abi != SpasmABI_WindowsX64 && abi != SpasmABI_LinuxX64)
+    {
+        const char* abi_name = spasm_get_abi_as_string(abi);
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedABI, abi_name, strlen(abi_name));
+        return false;
+    }
+
+    bool valid = num_args <= SPASM_X86_64_CALL_MAX_ARGS && (result == NULL || spasm_x86_64_call_check(result, false));
+
+    for(size_t i = 0; valid && i < num_args; i++)
+        valid = spasm_x86_64_call_check(&args[i], true);
+
+    switch(target.type)
+    {
+        case SpasmOperandType_Register:
+            valid &= target.reg >= SpasmRegister_x86_64_RAX && target.reg <= SpasmRegister_x86_64_R15;
+            break;
+        case SpasmOperandType_Mem:
+            valid &= target.mem_reg != SPASM_VIRTUAL_REGISTER && target.mem_index != SPASM_VIRTUAL_REGISTER;
+            break;
+        case SpasmOperandType_Label:
+        case SpasmOperandType_Symbol:
+            break;
+        default:
+            valid &= spasm_x86_64_call_is_immediate(&target);
+            break;
+    }
+
+    if(!valid)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_InvalidCallArgument, NULL, 0);
+        return false;
+    }
+
+    size_t num_gp = 0;
+    size_t num_fp = 0;
+    const SpasmRegister* gp = get_call_args_gp_registers(abi, &num_gp);
+    const SpasmRegister* fp = get_call_args_fp_registers(abi, &num_fp);
+    num_fp = SPASM_MIN(num_fp, get_call_max_args_fp_registers(abi));
+
+    const bool windows = abi == SpasmABI_WindowsX64;
+
+    /* Register of each argument (NONE on the stack), Windows slots are shared by the two files */
+    SpasmRegister arg_registers[SPASM_X86_64_CALL_MAX_ARGS];
+    size_t used_gp = 0;
+    size_t used_fp = 0;
+    size_t num_stack = 0;
+
+    Spasm_x86_64_RegisterSet written = 0;
+    Spasm_x86_64_RegisterSet read = 0;
+
+    for(size_t i = 0; i < num_args; i++)
+    {
+        const bool vector = args[i].type != Spasm_x86_64_CallArgType_Int;
+        const size_t position = windows ? i : vector ? used_fp : used_gp;
+
+        arg_registers[i] = SpasmRegister_x86_64_NONE;
+
+        if(vector && position < num_fp)
+            arg_registers[i] = fp[position];
+        else if(!vector && position < num_gp)
+            arg_registers[i] = gp[position];
+
+        if(arg_registers[i] == SpasmRegister_x86_64_NONE)
+            num_stack++;
+        else if(vector)
+            used_fp++;
+        else
+            used_gp++;
+
+        written |= spasm_x86_64_register_set(arg_registers[i]);
+        read |= spasm_x86_64_call_reads(&args[i].value);
+    }
+
+    const uint32_t shadow_size = windows ? SPASM_X86_64_CALL_SHADOW_SPACE : 0;
+    const uint32_t area = (shadow_size + 8 * (uint32_t)num_stack + 15) & ~15u;
+
+    Spasm_x86_64_CallLowering lowering;
+    lowering.instructions = instructions;
+    lowering.num_moves = 0;
+    lowering.missing_scratch = false;
+    lowering.ok = true;
+
+    /* A target read from an argument register, or an absolute address, is moved to R11 first */
+    SpasmOperand call_target = target;
+    const Spasm_x86_64_RegisterSet target_reads = spasm_x86_64_call_reads(&target);
+
+    if(target.type == SpasmOperandType_Mem && target.mem_reg == SpasmRegister_x86_64_RSP)
+        call_target.mem_displacement += (int32_t)area;
+
+    SpasmRegister gp_candidates[16] = { SpasmRegister_x86_64_R11, SpasmRegister_x86_64_R10, SpasmRegister_x86_64_RAX };
+    size_t num_gp_candidates = 3;
+
+    for(size_t i = num_gp; i > 0; i--)
+        gp_candidates[num_gp_candidates++] = gp[i - 1];
+
+    const bool target_moved = (target_reads & written) || spasm_x86_64_call_is_immediate(&target);
+
+    if(target_moved)
+    {
+        const SpasmRegister reg = spasm_x86_64_call_scratch(gp_candidates, num_gp_candidates, written | read);
+
+        if(reg == SpasmRegister_x86_64_NONE)
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_InvalidCallArgument, NULL, 0);
+            return false;
+        }
+
+        const Spasm_x86_64_CallArg target_arg = { call_target, Spasm_x86_64_CallArgType_Int };
+        spasm_x86_64_call_add_move(&lowering, &target_arg, reg, 0);
+
+        call_target = SpasmOpReg(reg);
+        read |= spasm_x86_64_register_set(reg);
+    }
+    else
+    {
+        read |= target_reads;
+    }
+
+    lowering.gp_scratch = spasm_x86_64_call_scratch(gp_candidates, num_gp_candidates, written | read);
+
+    SpasmRegister vector_candidates[16];
+    size_t num_vector_candidates = 0;
+
+    /* XMM6-XMM15 are callee-saved on Windows */
+    if(windows)
+    {
+        vector_candidates[num_vector_candidates++] = SpasmRegister_x86_64_XMM5;
+        vector_candidates[num_vector_candidates++] = SpasmRegister_x86_64_XMM4;
+    }
+    else
+    {
+        for(size_t i = 16; i > 8; i--)
+            vector_candidates[num_vector_candidates++] = (SpasmRegister)(SpasmRegister_x86_64_XMM0 + i - 1);
+    }
+
+    for(size_t i = num_fp; i > 0; i--)
+        vector_candidates[num_vector_candidates++] = fp[i - 1];
+
+    lowering.vector_scratch = spasm_x86_64_call_scratch(vector_candidates, num_vector_candidates, written | read);
+
+    if(area > 0)
+        lowering.ok &= spasm_instructions_push(instructions,
+                                               SpasmMnemonic_x86_64_SUB,
+                                               SpasmOpReg(SpasmRegister_x86_64_RSP),
+                                               area <= INT8_MAX ? SpasmOpImm8(area) : SpasmOpImm32(area));
+
+    int32_t stack_offset = (int32_t)shadow_size;
+
+    for(size_t i = 0; i < num_args; i++)
+    {
+        if(arg_registers[i] != SpasmRegister_x86_64_NONE)
+        {
+            spasm_x86_64_call_add_move(&lowering, &args[i], arg_registers[i], area);
+            continue;
+        }
+
+        spasm_x86_64_call_store(&lowering, &args[i], stack_offset, area);
+        stack_offset += 8;
+    }
+
+    spasm_x86_64_call_parallel_move(&lowering);
+
+    lowering.ok &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_CALL, call_target);
+
+    if(area > 0)
+        lowering.ok &= spasm_instructions_push(instructions,
+                                               SpasmMnemonic_x86_64_ADD,
+                                               SpasmOpReg(SpasmRegister_x86_64_RSP),
+                                               area <= INT8_MAX ? SpasmOpImm8(area) : SpasmOpImm32(area));
+
+    if(result != NULL && result->type == Spasm_x86_64_CallArgType_Int)
+    {
+        if(result->value.type == SpasmOperandType_Mem)
+            lowering.ok &= spasm_instructions_push(instructions,
+                                                   SpasmMnemonic_x86_64_MOV,
+                                                   result->value,
+                                                   SpasmOpReg(get_call_return_value_gp_register(abi)));
+        else if(spasm_x86_64_register_set(result->value.reg) != spasm_x86_64_register_set(get_call_return_value_gp_register(abi)))
+            lowering.ok &= spasm_instructions_push(instructions,
+                                                   SpasmMnemonic_x86_64_MOV,
+                                                   result->value,
+                                                   SpasmOpReg(spasm_x86_64_call_view(get_call_return_value_gp_register(abi),
+                                                                                     spasm_x86_64_call_width(result->value.reg))));
+    }
+    else if(result != NULL)
+    {
+        const SpasmRegister xmm = get_call_return_value_fp_register(abi);
+
+        if(result->value.type == SpasmOperandType_Mem)
+            lowering.ok &= spasm_instructions_push(instructions,
+                                                   spasm_x86_64_call_scalar_move(result->type),
+                                                   result->value,
+                                                   SpasmOpReg(xmm));
+        else if(spasm_x86_64_register_set(result->value.reg) != spasm_x86_64_register_set(xmm))
+            lowering.ok &= spasm_instructions_push(instructions,
+                                                   SpasmMnemonic_x86_64_MOVAPS,
+                                                   SpasmOpReg(spasm_x86_64_call_view(result->value.reg, SpasmRegister_x86_64_XMM0)),
+                                                   SpasmOpReg(xmm));
+    }
+
+    if(lowering.missing_scratch)
+        spasm_context_report_code(ctx, SpasmErrorCode_InvalidCallArgument, NULL, 0);
+
+    return lowering.ok;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
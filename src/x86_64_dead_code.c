@@ -0,0 +1,462 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_DEAD_CODE_NO_BLOCK UINT32_MAX
+
+typedef enum
+{
+    Spasm_x86_64_Removal_Kept,
+    Spasm_x86_64_Removal_Dead,
+    Spasm_x86_64_Removal_DeadStore,
+    Spasm_x86_64_Removal_Unreachable,
+} Spasm_x86_64_Removal;
+
+typedef struct
+{
+    SpasmContext* ctx;
+    SpasmInstructions* instructions;
+    const SpasmAllocator* allocator;
+    Spasm_x86_64_Liveness liveness;
+    uint8_t* removals; /* Spasm_x86_64_Removal of each instruction */
+    uint32_t* label_blocks;
+    uint32_t* worklist;
+    bool* reachable;
+} Spasm_x86_64_DeadCode;
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_dead_code_falls_through(uint16_t mnemonic)
+{
+    return mnemonic != SpasmMnemonic_x86_64_JMP &&
+           mnemonic != SpasmMnemonic_x86_64_RET &&
+           mnemonic != SpasmMnemonic_x86_64_UD2;
+}
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_dead_code_is_memory(const SpasmOperand* operand)
+{
+    return operand->type == SpasmOperandType_Mem ||
+           operand->type == SpasmOperandType_Data ||
+           operand->type == SpasmOperandType_Symbol;
+}
+
+/*
+    Instructions kept even when the registers and flags they write are dead: control flow, memory
+    writes (explicit, or through the stack pointer), writes to registers the liveness does not
+    track, and system instructions
+*/
+static bool spasm_x86_64_has_side_effects(const SpasmInstruction* instr, const Spasm_x86_64_FormAccess* access)
+{
+    if(access == NULL)
+        return true;
+
+    switch(instr->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_CALL:
+        case SpasmMnemonic_x86_64_RET:
+        case SpasmMnemonic_x86_64_UD2:
+        case SpasmMnemonic_x86_64_SYSCALL:
+        case SpasmMnemonic_x86_64_INT:
+        case SpasmMnemonic_x86_64_CPUID:
+        case SpasmMnemonic_x86_64_VZEROALL:
+            return true;
+        default:
+            break;
+    }
+
+    if(spasm_x86_64_is_branch(instr->mnemonic))
+        return true;
+
+    if(access->implicit_written & spasm_x86_64_register_set(SpasmRegister_x86_64_RSP))
+        return true;
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        if(!(access->written & (1u << i)))
+            continue;
+
+        const SpasmOperand* operand = &instr->operands[i];
+
+        if(spasm_x86_64_dead_code_is_memory(operand))
+            return true;
+
+        if(operand->type == SpasmOperandType_Register && spasm_x86_64_register_set(operand->reg) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static void spasm_x86_64_dead_code_release(Spasm_x86_64_DeadCode* dc)
+{
+    const size_t num_instructions = dc->liveness.num_instructions;
+
+    spasm_allocator_free(dc->allocator, dc->removals, num_instructions * sizeof(uint8_t));
+    spasm_allocator_free(dc->allocator, dc->label_blocks, dc->instructions->num_labels * sizeof(uint32_t));
+    spasm_allocator_free(dc->allocator, dc->worklist, num_instructions * sizeof(uint32_t));
+    spasm_allocator_free(dc->allocator, dc->reachable, num_instructions * sizeof(bool));
+
+    dc->removals = NULL;
+    dc->label_blocks = NULL;
+    dc->worklist = NULL;
+    dc->reachable = NULL;
+
+    spasm_x86_64_liveness_release(&dc->liveness);
+}
+
+/*
+    Blocks are reachable from the start of the stream, and from the labels called (the return
+    address is pushed, so they are entered like functions). Branches to something else than a label
+    can not reach a label of the stream
+*/
+static size_t spasm_x86_64_mark_unreachable(Spasm_x86_64_DeadCode* dc)
+{
+    const Spasm_x86_64_Liveness* liveness = &dc->liveness;
+    const uint32_t num_labels = dc->instructions->num_labels;
+
+    if(liveness->num_blocks == 0)
+        return 0;
+
+    if(num_labels > 0)
+        memset(dc->label_blocks, 0xFF, num_labels * sizeof(uint32_t));
+
+    memset(dc->reachable, 0, liveness->num_blocks * sizeof(bool));
+
+    size_t worklist_size = 0;
+
+    dc->reachable[0] = true;
+    dc->worklist[worklist_size++] = 0;
+
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        const SpasmInstruction* first = spasm_instructions_at(dc->instructions, liveness->block_starts[b]);
+
+        if(first->mnemonic == SpasmMnemonic_Label && first->operands[0].label < num_labels)
+            dc->label_blocks[first->operands[0].label] = (uint32_t)b;
+    }
+
+    for(size_t i = 0; i < liveness->num_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(dc->instructions, i);
+
+        if(instr->mnemonic != SpasmMnemonic_x86_64_CALL ||
+           instr->num_operands != 1 ||
+           instr->operands[0].type != SpasmOperandType_Label ||
+           instr->operands[0].label >= num_labels)
+            continue;
+
+        const uint32_t target = dc->label_blocks[instr->operands[0].label];
+
+        if(target != SPASM_X86_64_DEAD_CODE_NO_BLOCK && !dc->reachable[target])
+        {
+            dc->reachable[target] = true;
+            dc->worklist[worklist_size++] = target;
+        }
+    }
+
+    while(worklist_size > 0)
+    {
+        const uint32_t b = dc->worklist[--worklist_size];
+        const SpasmInstruction* last = spasm_instructions_at(dc->instructions, liveness->block_starts[b + 1] - 1);
+
+        uint32_t successors[2];
+        size_t num_successors = 0;
+
+        if(spasm_x86_64_dead_code_falls_through(last->mnemonic) && b + 1 < liveness->num_blocks)
+            successors[num_successors++] = b + 1;
+
+        if(spasm_x86_64_is_branch(last->mnemonic) &&
+           last->num_operands == 1 &&
+           last->operands[0].type == SpasmOperandType_Label &&
+           last->operands[0].label < num_labels &&
+           dc->label_blocks[last->operands[0].label] != SPASM_X86_64_DEAD_CODE_NO_BLOCK)
+            successors[num_successors++] = dc->label_blocks[last->operands[0].label];
+
+        for(size_t s = 0; s < num_successors; s++)
+        {
+            if(!dc->reachable[successors[s]])
+            {
+                dc->reachable[successors[s]] = true;
+                dc->worklist[worklist_size++] = successors[s];
+            }
+        }
+    }
+
+    size_t num_unreachable = 0;
+
+    /* Labels and padding records stay, other passes and the encoder expect them */
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        if(dc->reachable[b])
+            continue;
+
+        for(size_t i = liveness->block_starts[b]; i < liveness->block_starts[b + 1]; i++)
+        {
+            if(!spasm_mnemonic_is_pseudo(spasm_instructions_at(dc->instructions, i)->mnemonic))
+            {
+                dc->removals[i] = Spasm_x86_64_Removal_Unreachable;
+                num_unreachable++;
+            }
+        }
+    }
+
+    return num_unreachable;
+}
+
+/*
+    Walks each block backward from the registers and flags live at its end. Removed instructions do
+    not make anything live, so chains of dead instructions go in one walk. Calls, returns and
+    instructions with no form keep the liveness computed for the whole stream (which can only hold
+    more registers)
+*/
+static size_t spasm_x86_64_mark_dead(Spasm_x86_64_DeadCode* dc)
+{
+    const Spasm_x86_64_Liveness* liveness = &dc->liveness;
+
+    size_t num_dead = 0;
+
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        const size_t start = liveness->block_starts[b];
+        const size_t end = liveness->block_starts[b + 1];
+
+        Spasm_x86_64_RegisterSet live = liveness->live_out[end - 1];
+
+        for(size_t i = end; i-- > start;)
+        {
+            if(dc->removals[i] != Spasm_x86_64_Removal_Kept)
+                continue;
+
+            const SpasmInstruction* instr = spasm_instructions_at(dc->instructions, i);
+
+            if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+                continue;
+
+            const Spasm_x86_64_FormAccess* access = spasm_x86_64_instruction_access(instr);
+
+            Spasm_x86_64_RegisterSet defs = 0;
+            Spasm_x86_64_RegisterSet uses = 0;
+
+            if(access == NULL ||
+               instr->mnemonic == SpasmMnemonic_x86_64_CALL ||
+               instr->mnemonic == SpasmMnemonic_x86_64_RET)
+            {
+                live = i > start ? liveness->live_out[i - 1] : 0;
+                continue;
+            }
+
+            spasm_x86_64_instruction_def_use(instr, &defs, &uses);
+
+            if(defs != 0 && (defs & live) == 0 && !spasm_x86_64_has_side_effects(instr, access))
+            {
+                dc->removals[i] = Spasm_x86_64_Removal_Dead;
+                num_dead++;
+                continue;
+            }
+
+            live = uses | (live & ~defs);
+        }
+    }
+
+    return num_dead;
+}
+
+/* Stores only writing their memory operand, with no register or flag written */
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_plain_store(const SpasmInstruction* instr,
+                                                           const Spasm_x86_64_FormAccess* access)
+{
+    return access != NULL &&
+           instr->num_operands == 2 &&
+           instr->operands[0].type == SpasmOperandType_Mem &&
+           instr->operands[0].mem_reg != SpasmRegister_x86_64_RIP &&
+           instr->operands[0].mem_reg != SPASM_VIRTUAL_REGISTER &&
+           instr->operands[0].mem_index != SPASM_VIRTUAL_REGISTER &&
+           access->written == 0x1 &&
+           (access->read & 0x1) == 0 &&
+           access->flags_written == 0 &&
+           access->implicit_written == 0;
+}
+
+/*
+    A store is dead when a store of the same form (so of the same size) to the same address follows
+    it in the block, with no memory access in between and the address registers unchanged
+*/
+static size_t spasm_x86_64_mark_dead_stores(Spasm_x86_64_DeadCode* dc)
+{
+    const Spasm_x86_64_Liveness* liveness = &dc->liveness;
+
+    size_t num_dead_stores = 0;
+
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        const size_t end = liveness->block_starts[b + 1];
+
+        for(size_t i = liveness->block_starts[b]; i < end; i++)
+        {
+            if(dc->removals[i] != Spasm_x86_64_Removal_Kept)
+                continue;
+
+            const SpasmInstruction* store = spasm_instructions_at(dc->instructions, i);
+            const Spasm_x86_64_FormAccess* access = spasm_x86_64_instruction_access(store);
+
+            if(!spasm_x86_64_is_plain_store(store, access))
+                continue;
+
+            const SpasmOperand* address = &store->operands[0];
+            const Spasm_x86_64_RegisterSet address_registers = spasm_x86_64_register_set(address->mem_reg) |
+                                                               spasm_x86_64_register_set(address->mem_index);
+
+            for(size_t j = i + 1; j < end; j++)
+            {
+                if(dc->removals[j] != Spasm_x86_64_Removal_Kept)
+                    continue;
+
+                const SpasmInstruction* next = spasm_instructions_at(dc->instructions, j);
+
+                if(spasm_mnemonic_is_pseudo(next->mnemonic))
+                    continue;
+
+                const Spasm_x86_64_FormAccess* next_access = spasm_x86_64_instruction_access(next);
+
+                if(next_access == access &&
+                   address->mem_reg == next->operands[0].mem_reg &&
+                   address->mem_index == next->operands[0].mem_index &&
+                   (address->mem_index == 0 || address->mem_scale == next->operands[0].mem_scale) &&
+                   address->mem_displacement == next->operands[0].mem_displacement)
+                {
+                    dc->removals[i] = Spasm_x86_64_Removal_DeadStore;
+                    num_dead_stores++;
+                    break;
+                }
+
+                Spasm_x86_64_RegisterSet defs = 0;
+                Spasm_x86_64_RegisterSet uses = 0;
+
+                if(next_access == NULL ||
+                   spasm_x86_64_has_side_effects(next, next_access) ||
+                   (next_access->implicit_read & spasm_x86_64_register_set(SpasmRegister_x86_64_RSP)) ||
+                   !spasm_x86_64_instruction_def_use(next, &defs, &uses) ||
+                   (defs & address_registers))
+                    break;
+
+                bool accesses_memory = false;
+
+                if(next->mnemonic != SpasmMnemonic_x86_64_LEA)
+                    for(uint8_t k = 0; k < next->num_operands; k++)
+                        accesses_memory |= spasm_x86_64_dead_code_is_memory(&next->operands[k]);
+
+                if(accesses_memory)
+                    break;
+            }
+        }
+    }
+
+    return num_dead_stores;
+}
+
+static void spasm_x86_64_dead_code_compact(Spasm_x86_64_DeadCode* dc)
+{
+    SpasmInstructions* instructions = dc->instructions;
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    size_t num_kept = 0;
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        if(dc->removals[i] != Spasm_x86_64_Removal_Kept)
+            continue;
+
+        if(num_kept != i)
+            *spasm_instructions_at(instructions, num_kept) = *spasm_instructions_at(instructions, i);
+
+        num_kept++;
+    }
+
+    instructions->instructions.size = num_kept;
+}
+
+bool spasm_x86_64_eliminate_dead_code(SpasmContext* ctx,
+                                      SpasmInstructions* instructions,
+                                      SpasmABI abi,
+                                      uint32_t flags,
+                                      Spasm_x86_64_DeadCodeStats* stats)
+{
+    Spasm_x86_64_DeadCode dc;
+    memset(&dc, 0, sizeof(Spasm_x86_64_DeadCode));
+
+    dc.ctx = ctx;
+    dc.instructions = instructions;
+    dc.allocator = spasm_context_get_allocator(instructions->ctx);
+
+    Spasm_x86_64_DeadCodeStats total;
+    memset(&total, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    /* Removing instructions can make the ones feeding them dead in other blocks, so this runs to a fixpoint */
+    bool changed = true;
+
+    while(changed)
+    {
+        if(!spasm_x86_64_liveness(ctx, instructions, abi, flags, &dc.liveness))
+            return false;
+
+        const size_t num_instructions = dc.liveness.num_instructions;
+
+        dc.removals = (uint8_t*)spasm_allocator_alloc(dc.allocator, num_instructions * sizeof(uint8_t));
+        dc.label_blocks = (uint32_t*)spasm_allocator_alloc(dc.allocator, instructions->num_labels * sizeof(uint32_t));
+        dc.worklist = (uint32_t*)spasm_allocator_alloc(dc.allocator, num_instructions * sizeof(uint32_t));
+        dc.reachable = (bool*)spasm_allocator_alloc(dc.allocator, num_instructions * sizeof(bool));
+
+        if((num_instructions > 0 && (dc.removals == NULL || dc.worklist == NULL || dc.reachable == NULL)) ||
+           (instructions->num_labels > 0 && dc.label_blocks == NULL))
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            spasm_x86_64_dead_code_release(&dc);
+            return false;
+        }
+
+        if(num_instructions > 0)
+            memset(dc.removals, Spasm_x86_64_Removal_Kept, num_instructions * sizeof(uint8_t));
+
+        const size_t num_unreachable = spasm_x86_64_mark_unreachable(&dc);
+        const size_t num_dead_stores = spasm_x86_64_mark_dead_stores(&dc);
+        const size_t num_dead = spasm_x86_64_mark_dead(&dc);
+
+        total.num_unreachable += num_unreachable;
+        total.num_dead_stores += num_dead_stores;
+        total.num_dead += num_dead;
+        total.num_passes++;
+
+        changed = num_unreachable + num_dead_stores + num_dead > 0;
+
+        if(changed)
+            spasm_x86_64_dead_code_compact(&dc);
+
+        spasm_x86_64_dead_code_release(&dc);
+    }
+
+    if(stats != NULL)
+    {
+        stats->num_dead += total.num_dead;
+        stats->num_dead_stores += total.num_dead_stores;
+        stats->num_unreachable += total.num_unreachable;
+        stats->num_passes += total.num_passes;
+    }
+
+    return true;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
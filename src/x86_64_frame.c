@@ -0,0 +1,344 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/abi.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_FRAME_SHADOW_SPACE 32
+
+static SPASM_FORCE_INLINE uint32_t spasm_x86_64_frame_round_up(uint32_t size, uint32_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static SPASM_FORCE_INLINE SpasmOperand spasm_x86_64_frame_imm(int64_t value)
+{
+    return value >= INT8_MIN && value <= INT8_MAX ? SpasmOpImm8(value) : SpasmOpImm32(value);
+}
+
+static SPASM_FORCE_INLINE int32_t spasm_x86_64_frame_locals_end(const Spasm_x86_64_Frame* frame)
+{
+    /* From RSP after the sub, where the vector registers are saved */
+    return (int32_t)(frame->vector_save_offset + 8 + frame->push_size + frame->stack_size);
+}
+
+/* Callee-saved registers of the ABI in the set, in the order of the ABI tables */
+static size_t spasm_x86_64_frame_saved(const Spasm_x86_64_Frame* frame,
+                                       bool vector,
+                                       SpasmRegister* regs)
+{
+    size_t num_callee_saved = 0;
+    const SpasmRegister* callee_saved = vector ? get_callee_saved_fp_registers(frame->abi, &num_callee_saved) :
+                                                 get_callee_saved_gp_registers(frame->abi, &num_callee_saved);
+
+    size_t num_regs = 0;
+
+    for(size_t i = 0; i < num_callee_saved; i++)
+    {
+        /* RBP is saved first as the frame pointer */
+        if(frame->has_frame_pointer && callee_saved[i] == SpasmRegister_x86_64_RBP)
+            continue;
+
+        if(frame->saved_registers & spasm_x86_64_register_set(callee_saved[i]))
+            regs[num_regs++] = callee_saved[i];
+    }
+
+    return num_regs;
+}
+
+static void spasm_x86_64_frame_add_cfi(Spasm_x86_64_Frame* frame,
+                                       uint32_t instruction,
+                                       Spasm_x86_64_CFIOp op,
+                                       SpasmRegister reg,
+                                       int32_t offset)
+{
+    SPASM_ASSERT(frame->num_cfi < SPASM_X86_64_FRAME_MAX_CFI, "Too many CFI records");
+
+    Spasm_x86_64_CFIRecord* record = &frame->cfi[frame->num_cfi++];
+    record->instruction = instruction;
+    record->op = (uint8_t)op;
+    record->reg = (uint8_t)reg;
+    record->offset = offset;
+}
+
+/*
+    Walks the prologue of the frame: pushes it to instructions if not NULL, records its CFI in
+    cfi_frame if not NULL. Returns the number of instructions, 0 if a push failed
+*/
+static uint32_t spasm_x86_64_frame_prologue(const Spasm_x86_64_Frame* frame,
+                                            SpasmInstructions* instructions,
+                                            Spasm_x86_64_Frame* cfi_frame)
+{
+    const SpasmOperand rsp = SpasmOpReg(SpasmRegister_x86_64_RSP);
+
+    uint32_t num_instructions = 0;
+    int32_t cfa_offset = 8;
+    bool res = true;
+
+    if(frame->has_frame_pointer)
+    {
+        if(instructions != NULL)
+        {
+            res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_PUSH, SpasmOpReg(SpasmRegister_x86_64_RBP));
+            res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RBP), rsp);
+        }
+
+        cfa_offset += 8;
+
+        if(cfi_frame != NULL)
+        {
+            spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions, Spasm_x86_64_CFIOp_DefCfaOffset, 0, cfa_offset);
+            spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions, Spasm_x86_64_CFIOp_SaveRegister, SpasmRegister_x86_64_RBP, -cfa_offset);
+            spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions + 1, Spasm_x86_64_CFIOp_DefCfaRegister, SpasmRegister_x86_64_RBP, cfa_offset);
+        }
+
+        num_instructions += 2;
+    }
+
+    SpasmRegister regs[16];
+    size_t num_regs = spasm_x86_64_frame_saved(frame, false, regs);
+
+    for(size_t i = 0; i < num_regs; i++)
+    {
+        if(instructions != NULL)
+            res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_PUSH, SpasmOpReg(regs[i]));
+
+        cfa_offset += 8;
+
+        if(cfi_frame != NULL)
+        {
+            /* With a frame pointer the CFA does not follow RSP anymore */
+            if(!frame->has_frame_pointer)
+                spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions, Spasm_x86_64_CFIOp_DefCfaOffset, 0, cfa_offset);
+
+            spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions, Spasm_x86_64_CFIOp_SaveRegister, regs[i], -cfa_offset);
+        }
+
+        num_instructions++;
+    }
+
+    if(frame->stack_size > 0)
+    {
+        if(instructions != NULL)
+            res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_SUB, rsp, spasm_x86_64_frame_imm(frame->stack_size));
+
+        cfa_offset += (int32_t)frame->stack_size;
+
+        if(cfi_frame != NULL && !frame->has_frame_pointer)
+            spasm_x86_64_frame_add_cfi(cfi_frame, num_instructions, Spasm_x86_64_CFIOp_DefCfaOffset, 0, cfa_offset);
+
+        num_instructions++;
+    }
+
+    /* Saved from RSP before it is realigned, so the slots stay at a fixed distance from the CFA */
+    const int32_t locals_end = spasm_x86_64_frame_locals_end(frame);
+
+    num_regs = spasm_x86_64_frame_saved(frame, true, regs);
+
+    for(size_t i = 0; i < num_regs; i++)
+    {
+        if(instructions != NULL)
+            res &= spasm_instructions_push(instructions,
+                                           SpasmMnemonic_x86_64_MOVAPS,
+                                           SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, locals_end + 16 * (int32_t)i, 0),
+                                           SpasmOpReg(regs[i]));
+
+        if(cfi_frame != NULL)
+            spasm_x86_64_frame_add_cfi(cfi_frame,
+                                       num_instructions,
+                                       Spasm_x86_64_CFIOp_SaveRegister,
+                                       regs[i],
+                                       frame->vector_save_offset + 16 * (int32_t)i);
+
+        num_instructions++;
+    }
+
+    if(frame->alignment > 16)
+    {
+        if(instructions != NULL)
+            res &= spasm_instructions_push(instructions,
+                                           SpasmMnemonic_x86_64_AND,
+                                           rsp,
+                                           spasm_x86_64_frame_imm(-(int64_t)frame->alignment));
+
+        num_instructions++;
+    }
+
+    return res ? num_instructions : 0;
+}
+
+bool spasm_x86_64_frame_build(SpasmContext* ctx,
+                              const Spasm_x86_64_FrameConfig* config,
+                              const SpasmInstructions* body,
+                              Spasm_x86_64_Frame* frame)
+{
+    SPASM_ASSERT(frame != NULL, "frame is NULL");
+
+    Spasm_x86_64_FrameConfig default_config;
+
+    if(config == NULL)
+    {
+        memset(&default_config, 0, sizeof(Spasm_x86_64_FrameConfig));
+        config = &default_config;
+    }
+
+    memset(frame, 0, sizeof(Spasm_x86_64_Frame));
+
+    frame->abi = config->abi == SpasmABI_Invalid ? spasm_get_current_abi() : config->abi;
+    frame->alignment = config->alignment == 0 ? 16 : SPASM_MAX(config->alignment, 16);
+
+    if(frame->abi != SpasmABI_WindowsX64 && frame->abi != SpasmABI_LinuxX64)
+    {
+        const char* abi_name = spasm_get_abi_as_string(frame->abi);
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedABI, abi_name, strlen(abi_name));
+        return false;
+    }
+
+    /* and rsp, imm8 reaches 128, larger alignments are not useful for stack data */
+    if((config->alignment & (config->alignment - 1)) != 0 || frame->alignment > 128)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_InvalidAlignment, NULL, 0);
+        return false;
+    }
+
+    Spasm_x86_64_RegisterSet used_registers = config->used_registers;
+    bool has_calls = config->has_calls;
+
+    for(size_t i = 0; body != NULL && i < spasm_instructions_size(body); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(body, i);
+
+        Spasm_x86_64_RegisterSet defs;
+        Spasm_x86_64_RegisterSet uses;
+
+        if(!spasm_x86_64_instruction_def_use(instr, &defs, &uses))
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_UnknownInstruction, instr);
+            return false;
+        }
+
+        used_registers |= defs;
+        has_calls |= instr->mnemonic == SpasmMnemonic_x86_64_CALL;
+    }
+
+    /* Realigning RSP loses its distance to the CFA, which is then kept in RBP */
+    frame->has_frame_pointer = config->frame_pointer || frame->alignment > 16;
+
+    size_t num_callee_saved = 0;
+    const SpasmRegister* callee_saved = get_callee_saved_gp_registers(frame->abi, &num_callee_saved);
+
+    for(size_t i = 0; i < num_callee_saved; i++)
+        frame->saved_registers |= used_registers & spasm_x86_64_register_set(callee_saved[i]);
+
+    callee_saved = get_callee_saved_fp_registers(frame->abi, &num_callee_saved);
+
+    for(size_t i = 0; i < num_callee_saved; i++)
+        frame->saved_registers |= used_registers & spasm_x86_64_register_set(callee_saved[i]);
+
+    if(frame->has_frame_pointer)
+        frame->saved_registers |= spasm_x86_64_register_set(SpasmRegister_x86_64_RBP);
+
+    SpasmRegister regs[16];
+    const uint32_t num_pushed = (uint32_t)spasm_x86_64_frame_saved(frame, false, regs) + (uint32_t)frame->has_frame_pointer;
+    const uint32_t num_vectors = (uint32_t)spasm_x86_64_frame_saved(frame, true, regs);
+
+    frame->push_size = 8 * num_pushed;
+
+    /* The CFA is 16-byte aligned, RSP is at CFA - pushed after the pushes */
+    const uint32_t pushed = 8 + frame->push_size;
+    const uint32_t locals_size = spasm_x86_64_frame_round_up(config->locals_size, 16);
+    const uint32_t vectors_size = 16 * num_vectors;
+
+    if(frame->abi == SpasmABI_LinuxX64 && !has_calls && !frame->has_frame_pointer && num_vectors == 0 &&
+       locals_size + (pushed % 16) <= SPASM_X86_64_FRAME_RED_ZONE)
+    {
+        frame->uses_red_zone = locals_size > 0;
+        frame->locals_offset = -(int32_t)(locals_size + (pushed % 16));
+        frame->vector_save_offset = -(int32_t)pushed;
+    }
+    else
+    {
+        const uint32_t shadow_size = frame->abi == SpasmABI_WindowsX64 && has_calls ? SPASM_X86_64_FRAME_SHADOW_SPACE : 0;
+        const uint32_t locals_offset = frame->alignment > 16 ? spasm_x86_64_frame_round_up(shadow_size, frame->alignment) : shadow_size;
+        const uint32_t frame_size = locals_offset + locals_size + vectors_size;
+
+        if(frame_size > 0 || has_calls)
+            frame->stack_size = frame_size + (16 - (pushed + frame_size) % 16) % 16;
+
+        frame->locals_offset = (int32_t)locals_offset;
+        frame->vector_save_offset = -(int32_t)(pushed + frame->stack_size - locals_offset - locals_size);
+    }
+
+    frame->num_prologue_instructions = spasm_x86_64_frame_prologue(frame, NULL, frame);
+
+    return true;
+}
+
+bool spasm_x86_64_frame_emit_prologue(const Spasm_x86_64_Frame* frame,
+                                      SpasmInstructions* instructions)
+{
+    SPASM_ASSERT(frame != NULL, "frame is NULL");
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+
+    return frame->num_prologue_instructions == 0 ||
+           spasm_x86_64_frame_prologue(frame, instructions, NULL) == frame->num_prologue_instructions;
+}
+
+bool spasm_x86_64_frame_emit_epilogue(const Spasm_x86_64_Frame* frame,
+                                      SpasmInstructions* instructions)
+{
+    SPASM_ASSERT(frame != NULL, "frame is NULL");
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+
+    const SpasmOperand rsp = SpasmOpReg(SpasmRegister_x86_64_RSP);
+
+    SpasmRegister regs[16];
+    size_t num_regs = spasm_x86_64_frame_saved(frame, true, regs);
+
+    bool res = true;
+
+    /* RSP may have moved (realignment, dynamic allocations), the slots are found from RBP */
+    for(size_t i = 0; i < num_regs; i++)
+    {
+        const SpasmOperand slot = frame->has_frame_pointer ?
+            SpasmOpMemory(SpasmRegister_x86_64_RBP, 0, frame->vector_save_offset + 16 + 16 * (int32_t)i, 0) :
+            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, spasm_x86_64_frame_locals_end(frame) + 16 * (int32_t)i, 0);
+
+        res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_MOVAPS, SpasmOpReg(regs[i]), slot);
+    }
+
+    num_regs = spasm_x86_64_frame_saved(frame, false, regs);
+
+    if(frame->has_frame_pointer)
+        res &= spasm_instructions_push(instructions,
+                                       SpasmMnemonic_x86_64_LEA,
+                                       rsp,
+                                       SpasmOpMemory(SpasmRegister_x86_64_RBP, 0, -8 * (int32_t)num_regs, 0));
+    else if(frame->stack_size > 0)
+        res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_ADD, rsp, spasm_x86_64_frame_imm(frame->stack_size));
+
+    for(size_t i = num_regs; i > 0; i--)
+        res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_POP, SpasmOpReg(regs[i - 1]));
+
+    if(frame->has_frame_pointer)
+        res &= spasm_instructions_push(instructions, SpasmMnemonic_x86_64_POP, SpasmOpReg(SpasmRegister_x86_64_RBP));
+
+    res &= spasm_instructions_pushz(instructions, SpasmMnemonic_x86_64_RET);
+
+    return res;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/* Private to the x86_64 sources, shared by x86_64.c and the passes in x86_64_*.c */
+
+#pragma once
+
+#if !defined(__SPASM_X86_64_INTERNAL)
+#define __SPASM_X86_64_INTERNAL
+
+#include "spasm/x86_64.h"
+#include "spasm/context.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+
+#if defined(SPASM_ENABLE_X86_64)
+
+/* Reports an error about instr to the context of the stream */
+void spasm_x86_64_report_instruction_error(SpasmContext* ctx,
+                                           SpasmErrorCode code,
+                                           const SpasmInstruction* instr);
+
+/* Formats instr to fmt_buf, returns the size of the formatted string (see snprintf) */
+size_t spasm_x86_64_instruction_debug(SpasmInstruction* instr, char* fmt_buf, size_t max_fmt_sz);
+
+/* jcc and jmp, direct or indirect */
+bool spasm_x86_64_is_branch(uint16_t mnemonic);
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
+
+#endif /* !defined(__SPASM_X86_64_INTERNAL) */
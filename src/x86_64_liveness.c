@@ -0,0 +1,403 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_LIVENESS_NO_BLOCK UINT32_MAX
+
+#define SPASM_X86_64_REGISTER_SET_ALL_GP ((Spasm_x86_64_RegisterSet)0xFFFF)
+#define SPASM_X86_64_REGISTER_SET_ALL_VECTOR ((Spasm_x86_64_RegisterSet)0xFFFF << 16)
+#define SPASM_X86_64_REGISTER_SET_ALL (SPASM_X86_64_REGISTER_SET_ALL_GP |     \
+                                       SPASM_X86_64_REGISTER_SET_ALL_VECTOR | \
+                                       SPASM_X86_64_REGISTER_SET_FLAGS(SPASM_X86_64_STATUS_FLAGS | Spasm_x86_64_Flag_DF))
+
+Spasm_x86_64_RegisterSet spasm_x86_64_register_set(SpasmRegister reg)
+{
+    if(reg >= SpasmRegister_x86_64_AL && reg <= SpasmRegister_x86_64_R15)
+        return SPASM_X86_64_REGISTER_SET_GP((reg - SpasmRegister_x86_64_AL) % 16);
+
+    if(reg >= SpasmRegister_x86_64_XMM0 && reg <= SpasmRegister_x86_64_ZMM15)
+        return SPASM_X86_64_REGISTER_SET_VECTOR((reg - SpasmRegister_x86_64_XMM0) % 16);
+
+    return 0;
+}
+
+/* Writes to 8 and 16-bit views keep the rest of the register, writes to 32-bit views zero it */
+static SPASM_FORCE_INLINE bool spasm_x86_64_is_partial_register(SpasmRegister reg)
+{
+    return reg >= SpasmRegister_x86_64_AL && reg < SpasmRegister_x86_64_EAX;
+}
+
+/* xor r, r and friends do not depend on the previous value of r */
+static bool spasm_x86_64_is_zero_idiom(const SpasmInstruction* instr)
+{
+    uint8_t first;
+
+    switch(instr->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_XOR:
+        case SpasmMnemonic_x86_64_SUB:
+        case SpasmMnemonic_x86_64_PXOR:
+        case SpasmMnemonic_x86_64_XORPS:
+        case SpasmMnemonic_x86_64_XORPD:
+            if(instr->num_operands != 2)
+                return false;
+
+            first = 0;
+            break;
+        case SpasmMnemonic_x86_64_VPXOR:
+        case SpasmMnemonic_x86_64_VPXORD:
+        case SpasmMnemonic_x86_64_VPXORQ:
+        case SpasmMnemonic_x86_64_VXORPS:
+        case SpasmMnemonic_x86_64_VXORPD:
+            if(instr->num_operands != 3)
+                return false;
+
+            first = 1;
+            break;
+        default:
+            return false;
+    }
+
+    return instr->operands[first].type == SpasmOperandType_Register &&
+           instr->operands[first + 1].type == SpasmOperandType_Register &&
+           instr->operands[first].reg == instr->operands[first + 1].reg;
+}
+
+bool spasm_x86_64_instruction_def_use(const SpasmInstruction* instr,
+                                      Spasm_x86_64_RegisterSet* defs,
+                                      Spasm_x86_64_RegisterSet* uses)
+{
+    *defs = 0;
+    *uses = 0;
+
+    if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+        return true;
+
+    const Spasm_x86_64_FormAccess* access = spasm_x86_64_instruction_access(instr);
+
+    if(access == NULL)
+        return false;
+
+    const bool zero_idiom = spasm_x86_64_is_zero_idiom(instr);
+
+    Spasm_x86_64_RegisterSet d = access->implicit_written | SPASM_X86_64_REGISTER_SET_FLAGS(access->flags_written);
+    Spasm_x86_64_RegisterSet u = access->implicit_read | SPASM_X86_64_REGISTER_SET_FLAGS(access->flags_read);
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        const SpasmOperand* operand = &instr->operands[i];
+
+        switch(operand->type)
+        {
+            case SpasmOperandType_Register:
+            {
+                const Spasm_x86_64_RegisterSet reg = spasm_x86_64_register_set(operand->reg);
+
+                if(access->read & (1u << i) && !zero_idiom)
+                    u |= reg;
+
+                if(access->written & (1u << i))
+                {
+                    d |= reg;
+
+                    if(spasm_x86_64_is_partial_register(operand->reg))
+                        u |= reg;
+                }
+
+                break;
+            }
+            case SpasmOperandType_Mem:
+                u |= spasm_x86_64_register_set(operand->mem_reg) | spasm_x86_64_register_set(operand->mem_index);
+                break;
+            default:
+                break;
+        }
+    }
+
+    *defs = d;
+    *uses = u;
+
+    return true;
+}
+
+/* Liveness */
+
+typedef enum
+{
+    Spasm_x86_64_BlockExit_FallThrough = 1 << 0,
+    Spasm_x86_64_BlockExit_Label = 1 << 1, /* Branch to the target block */
+    Spasm_x86_64_BlockExit_Unknown = 1 << 2, /* Branch to something else than a label */
+} Spasm_x86_64_BlockExit;
+
+typedef struct
+{
+    Spasm_x86_64_RegisterSet gen; /* Used before being defined in the block */
+    Spasm_x86_64_RegisterSet kill;
+    Spasm_x86_64_RegisterSet in;
+    Spasm_x86_64_RegisterSet out;
+    uint32_t target;
+    uint8_t exits;
+} Spasm_x86_64_Block;
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_ends_block(uint16_t mnemonic)
+{
+    return spasm_x86_64_is_branch(mnemonic) ||
+           mnemonic == SpasmMnemonic_x86_64_RET ||
+           mnemonic == SpasmMnemonic_x86_64_UD2;
+}
+
+static Spasm_x86_64_RegisterSet spasm_x86_64_registers_set(const SpasmRegister* regs, size_t num_regs)
+{
+    Spasm_x86_64_RegisterSet set = 0;
+
+    for(size_t i = 0; i < num_regs; i++)
+        set |= spasm_x86_64_register_set(regs[i]);
+
+    return set;
+}
+
+void spasm_x86_64_liveness_release(Spasm_x86_64_Liveness* liveness)
+{
+    if(liveness->allocator == NULL)
+        return;
+
+    spasm_allocator_free(liveness->allocator,
+                         liveness->live_out,
+                         liveness->num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    spasm_allocator_free(liveness->allocator,
+                         liveness->block_starts,
+                         (liveness->num_instructions + 1) * sizeof(size_t));
+
+    memset(liveness, 0, sizeof(Spasm_x86_64_Liveness));
+}
+
+bool spasm_x86_64_liveness(SpasmContext* ctx,
+                           const SpasmInstructions* instructions,
+                           SpasmABI abi,
+                           uint32_t flags,
+                           Spasm_x86_64_Liveness* liveness)
+{
+    memset(liveness, 0, sizeof(Spasm_x86_64_Liveness));
+
+    if(abi == SpasmABI_Invalid)
+        abi = spasm_get_current_abi();
+
+    size_t num_args_gp = 0;
+    size_t num_args_fp = 0;
+    size_t num_saved_gp = 0;
+    size_t num_saved_fp = 0;
+    const SpasmRegister* args_gp = get_call_args_gp_registers(abi, &num_args_gp);
+    const SpasmRegister* args_fp = get_call_args_fp_registers(abi, &num_args_fp);
+    const SpasmRegister* saved_gp = get_callee_saved_gp_registers(abi, &num_saved_gp);
+    const SpasmRegister* saved_fp = get_callee_saved_fp_registers(abi, &num_saved_fp);
+
+    if(args_gp == NULL || args_fp == NULL || saved_gp == NULL || saved_fp == NULL)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedABI, NULL, 0);
+        return false;
+    }
+
+    const Spasm_x86_64_RegisterSet rsp = spasm_x86_64_register_set(SpasmRegister_x86_64_RSP);
+    /* The direction flag must be clear at calls and returns */
+    const Spasm_x86_64_RegisterSet df = SPASM_X86_64_REGISTER_SET_FLAGS(Spasm_x86_64_Flag_DF);
+    const Spasm_x86_64_RegisterSet saved = spasm_x86_64_registers_set(saved_gp, num_saved_gp) |
+                                           spasm_x86_64_registers_set(saved_fp, num_saved_fp);
+    /* On System V, al holds the number of vector arguments of variadic calls */
+    const bool variadic_calls = (flags & SPASM_X86_64_LIVENESS_VARIADIC_CALLS) && abi != SpasmABI_WindowsX64;
+    const Spasm_x86_64_RegisterSet variadic = variadic_calls ? spasm_x86_64_register_set(SpasmRegister_x86_64_RAX) : 0;
+    const Spasm_x86_64_RegisterSet call_uses = spasm_x86_64_registers_set(args_gp, num_args_gp) |
+                                               spasm_x86_64_registers_set(args_fp, num_args_fp) |
+                                               variadic |
+                                               rsp |
+                                               df;
+    const Spasm_x86_64_RegisterSet call_defs = ((SPASM_X86_64_REGISTER_SET_ALL_GP | SPASM_X86_64_REGISTER_SET_ALL_VECTOR) &
+                                                ~(saved | rsp)) |
+                                               SPASM_X86_64_REGISTER_SET_FLAGS(SPASM_X86_64_STATUS_FLAGS);
+    const Spasm_x86_64_RegisterSet exit_uses = spasm_x86_64_register_set(get_call_return_value_gp_register(abi)) |
+                                               spasm_x86_64_register_set(get_call_return_value_fp_register(abi)) |
+                                               saved |
+                                               rsp |
+                                               df;
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+    const SpasmAllocator* allocator = spasm_context_get_allocator(instructions->ctx);
+
+    liveness->allocator = allocator;
+    liveness->num_instructions = num_instructions;
+    liveness->live_out = (Spasm_x86_64_RegisterSet*)spasm_allocator_alloc(allocator,
+                                                                          num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    liveness->block_starts = (size_t*)spasm_allocator_alloc(allocator, (num_instructions + 1) * sizeof(size_t));
+
+    /* Defs and uses of each instruction, computed once for the blocks and for the final pass */
+    Spasm_x86_64_RegisterSet* defs = (Spasm_x86_64_RegisterSet*)spasm_allocator_alloc(allocator,
+                                                                                      num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    Spasm_x86_64_RegisterSet* uses = (Spasm_x86_64_RegisterSet*)spasm_allocator_alloc(allocator,
+                                                                                      num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    Spasm_x86_64_Block* blocks = (Spasm_x86_64_Block*)spasm_allocator_alloc(allocator,
+                                                                            num_instructions * sizeof(Spasm_x86_64_Block));
+    uint32_t* label_blocks = (uint32_t*)spasm_allocator_alloc(allocator, instructions->num_labels * sizeof(uint32_t));
+
+    bool res = false;
+
+    if((num_instructions > 0 &&
+        (liveness->live_out == NULL || defs == NULL || uses == NULL || blocks == NULL)) ||
+       liveness->block_starts == NULL ||
+       (instructions->num_labels > 0 && label_blocks == NULL))
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        goto cleanup;
+    }
+
+    if(instructions->num_labels > 0)
+        memset(label_blocks, 0xFF, instructions->num_labels * sizeof(uint32_t));
+
+    /* Blocks start at labels and after branches, ret and ud2 */
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(i == 0 ||
+           instr->mnemonic == SpasmMnemonic_Label ||
+           spasm_x86_64_ends_block(spasm_instructions_at(instructions, i - 1)->mnemonic))
+            liveness->block_starts[liveness->num_blocks++] = i;
+
+        if(instr->mnemonic == SpasmMnemonic_Label &&
+           instr->num_operands == 1 &&
+           instr->operands[0].label < instructions->num_labels)
+            label_blocks[instr->operands[0].label] = (uint32_t)(liveness->num_blocks - 1);
+
+        if(!spasm_x86_64_instruction_def_use(instr, &defs[i], &uses[i]))
+        {
+            /* Unknown accesses, everything may be read */
+            defs[i] = 0;
+            uses[i] = SPASM_X86_64_REGISTER_SET_ALL;
+        }
+        else if(instr->mnemonic == SpasmMnemonic_x86_64_CALL)
+        {
+            defs[i] |= call_defs;
+            uses[i] |= call_uses;
+        }
+        else if(instr->mnemonic == SpasmMnemonic_x86_64_RET)
+        {
+            uses[i] |= exit_uses;
+        }
+    }
+
+    liveness->block_starts[liveness->num_blocks] = num_instructions;
+
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        Spasm_x86_64_Block* block = &blocks[b];
+        const size_t last = liveness->block_starts[b + 1] - 1;
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, last);
+
+        block->gen = 0;
+        block->kill = 0;
+        block->in = 0;
+        block->out = 0;
+        block->target = SPASM_X86_64_LIVENESS_NO_BLOCK;
+        block->exits = 0;
+
+        for(size_t i = last + 1; i-- > liveness->block_starts[b];)
+        {
+            block->gen = uses[i] | (block->gen & ~defs[i]);
+            block->kill |= defs[i];
+        }
+
+        if(instr->mnemonic != SpasmMnemonic_x86_64_JMP &&
+           instr->mnemonic != SpasmMnemonic_x86_64_RET &&
+           instr->mnemonic != SpasmMnemonic_x86_64_UD2)
+            block->exits |= Spasm_x86_64_BlockExit_FallThrough;
+
+        if(spasm_x86_64_is_branch(instr->mnemonic))
+        {
+            if(instr->num_operands == 1 &&
+               instr->operands[0].type == SpasmOperandType_Label &&
+               instr->operands[0].label < instructions->num_labels &&
+               label_blocks[instr->operands[0].label] != SPASM_X86_64_LIVENESS_NO_BLOCK)
+            {
+                block->exits |= Spasm_x86_64_BlockExit_Label;
+                block->target = label_blocks[instr->operands[0].label];
+            }
+            else
+            {
+                block->exits |= Spasm_x86_64_BlockExit_Unknown;
+            }
+        }
+    }
+
+    /* Backward dataflow, the blocks are visited from the last one so most edges converge in one round */
+    bool changed = true;
+
+    while(changed)
+    {
+        changed = false;
+
+        for(size_t b = liveness->num_blocks; b-- > 0;)
+        {
+            Spasm_x86_64_Block* block = &blocks[b];
+
+            Spasm_x86_64_RegisterSet out = 0;
+
+            if(block->exits & Spasm_x86_64_BlockExit_FallThrough)
+                out |= b + 1 < liveness->num_blocks ? blocks[b + 1].in : exit_uses;
+
+            if(block->exits & Spasm_x86_64_BlockExit_Label)
+                out |= blocks[block->target].in;
+
+            if(block->exits & Spasm_x86_64_BlockExit_Unknown)
+                out = SPASM_X86_64_REGISTER_SET_ALL;
+
+            const Spasm_x86_64_RegisterSet in = block->gen | (out & ~block->kill);
+
+            if(in != block->in || out != block->out)
+            {
+                block->in = in;
+                block->out = out;
+                changed = true;
+            }
+        }
+    }
+
+    for(size_t b = 0; b < liveness->num_blocks; b++)
+    {
+        Spasm_x86_64_RegisterSet live = blocks[b].out;
+
+        for(size_t i = liveness->block_starts[b + 1]; i-- > liveness->block_starts[b];)
+        {
+            liveness->live_out[i] = live;
+            live = uses[i] | (live & ~defs[i]);
+        }
+    }
+
+    res = true;
+
+cleanup:
+    spasm_allocator_free(allocator, defs, num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    spasm_allocator_free(allocator, uses, num_instructions * sizeof(Spasm_x86_64_RegisterSet));
+    spasm_allocator_free(allocator, blocks, num_instructions * sizeof(Spasm_x86_64_Block));
+    spasm_allocator_free(allocator, label_blocks, instructions->num_labels * sizeof(uint32_t));
+
+    if(!res)
+        spasm_x86_64_liveness_release(liveness);
+
+    return res;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
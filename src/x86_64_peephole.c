@@ -0,0 +1,430 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/common.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+/* Instructions looked at after a rewrite to know if the flags are dead, past it they are live */
+#define SPASM_X86_64_PEEPHOLE_FLAGS_WINDOW 16
+
+/* Registers */
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_peephole_is_gp(const SpasmOperand* operand, size_t width)
+{
+    const SpasmRegister first = width == 64 ? SpasmRegister_x86_64_RAX : SpasmRegister_x86_64_EAX;
+
+    return operand->type == SpasmOperandType_Register &&
+           operand->reg >= first &&
+           operand->reg < first + 16;
+}
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_peephole_is_imm(const SpasmOperand* operand)
+{
+    return operand->type == SpasmOperandType_Imm8 || operand->type == SpasmOperandType_Imm32;
+}
+
+/* Immediate as the cpu sees it, sign-extended to the operand size */
+static SPASM_FORCE_INLINE int64_t spasm_x86_64_peephole_imm(const SpasmOperand* operand)
+{
+    return operand->type == SpasmOperandType_Imm8 ? (int64_t)(int8_t)operand->imm_value :
+                                                    (int64_t)(int32_t)operand->imm_value;
+}
+
+static SPASM_FORCE_INLINE SpasmOperand spasm_x86_64_peephole_make_imm(int64_t value)
+{
+    return value >= INT8_MIN && value <= INT8_MAX ? SpasmOpImm8(value) : SpasmOpImm32(value);
+}
+
+/* Virtual addresses are not compared, the pass is meant to run after register allocation */
+static SPASM_FORCE_INLINE bool spasm_x86_64_peephole_same_memory(const SpasmOperand* a,
+                                                                 const SpasmOperand* b)
+{
+    return a->type == SpasmOperandType_Mem &&
+           b->type == SpasmOperandType_Mem &&
+           a->mem_reg != SpasmRegister_x86_64_RIP &&
+           a->mem_reg != SPASM_VIRTUAL_REGISTER &&
+           a->mem_index != SPASM_VIRTUAL_REGISTER &&
+           a->mem_reg == b->mem_reg &&
+           a->mem_index == b->mem_index &&
+           (a->mem_index == 0 || a->mem_scale == b->mem_scale) &&
+           a->mem_displacement == b->mem_displacement;
+}
+
+/* Flags */
+
+typedef enum
+{
+    Spasm_x86_64_FlagsUse_Preserves,
+    Spasm_x86_64_FlagsUse_Clobbers, /* Writes all the status flags without reading them */
+    Spasm_x86_64_FlagsUse_MayRead,
+} Spasm_x86_64_FlagsUse;
+
+static Spasm_x86_64_FlagsUse spasm_x86_64_peephole_flags_use(const SpasmInstruction* instr)
+{
+    switch(instr->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_ADD:
+        case SpasmMnemonic_x86_64_SUB:
+        case SpasmMnemonic_x86_64_AND:
+        case SpasmMnemonic_x86_64_OR:
+        case SpasmMnemonic_x86_64_XOR:
+        case SpasmMnemonic_x86_64_CMP:
+        case SpasmMnemonic_x86_64_TEST:
+        case SpasmMnemonic_x86_64_NEG:
+            return Spasm_x86_64_FlagsUse_Clobbers;
+        case SpasmMnemonic_x86_64_MOV:
+        case SpasmMnemonic_x86_64_MOVZX:
+        case SpasmMnemonic_x86_64_MOVSX:
+        case SpasmMnemonic_x86_64_MOVSXD:
+        case SpasmMnemonic_x86_64_LEA:
+        case SpasmMnemonic_x86_64_PUSH:
+        case SpasmMnemonic_x86_64_POP:
+        case SpasmMnemonic_x86_64_NOP:
+        case SpasmMnemonic_x86_64_MOVAPS:
+        case SpasmMnemonic_x86_64_MOVAPD:
+        case SpasmMnemonic_x86_64_MOVUPS:
+        case SpasmMnemonic_x86_64_MOVUPD:
+        case SpasmMnemonic_x86_64_MOVDQA:
+        case SpasmMnemonic_x86_64_MOVDQU:
+        case SpasmMnemonic_Align:
+        case SpasmMnemonic_Boundary:
+            return Spasm_x86_64_FlagsUse_Preserves;
+        default:
+            /* Labels and jumps included, the flags may be read on the other path */
+            return Spasm_x86_64_FlagsUse_MayRead;
+    }
+}
+
+static bool spasm_x86_64_peephole_flags_dead(const SpasmInstruction* next, const SpasmInstruction* end)
+{
+    if(end - next > SPASM_X86_64_PEEPHOLE_FLAGS_WINDOW)
+        end = next + SPASM_X86_64_PEEPHOLE_FLAGS_WINDOW;
+
+    for(; next < end; next++)
+    {
+        switch(spasm_x86_64_peephole_flags_use(next))
+        {
+            case Spasm_x86_64_FlagsUse_Clobbers:
+                return true;
+            case Spasm_x86_64_FlagsUse_MayRead:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    return false;
+}
+
+/* Rules */
+
+/*
+    The pass copies the stream over itself, and after each instruction copied tries the rules on
+    the instructions copied so far, ending with it. Rules rewrite or remove them, and can look at
+    the instructions not copied yet (next to end) to know what is live
+*/
+typedef struct
+{
+    SpasmInstruction* records;
+    size_t num_records;
+    const SpasmInstruction* next;
+    const SpasmInstruction* end;
+} Spasm_x86_64_PeepholeWindow;
+
+typedef struct
+{
+    const char* name;
+    uint8_t num_instructions; /* Window size, ending with the last instruction copied */
+    bool (*apply)(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs);
+} Spasm_x86_64_PeepholeRuleInfo;
+
+static bool spasm_x86_64_peephole_zero_idiom(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs)
+{
+    SpasmInstruction* mov = &instrs[0];
+
+    if(mov->mnemonic != SpasmMnemonic_x86_64_MOV || mov->num_operands != 2)
+        return false;
+
+    const bool is_64 = spasm_x86_64_peephole_is_gp(&mov->operands[0], 64);
+
+    if(!is_64 && !spasm_x86_64_peephole_is_gp(&mov->operands[0], 32))
+        return false;
+
+    const SpasmOperandType type = mov->operands[1].type;
+
+    if(type < SpasmOperandType_Imm8 || type > SpasmOperandType_Imm64 || mov->operands[1].imm_value != 0)
+        return false;
+
+    if(!spasm_x86_64_peephole_flags_dead(window->next, window->end))
+        return false;
+
+    /* Same register code, writing the 32 bits register zeroes the upper half */
+    const uint8_t reg = is_64 ? (uint8_t)(mov->operands[0].reg - SpasmRegister_x86_64_RAX + SpasmRegister_x86_64_EAX) :
+                                mov->operands[0].reg;
+
+    mov->mnemonic = SpasmMnemonic_x86_64_XOR;
+    mov->form = 0;
+    mov->operands[0] = SpasmOpReg(reg);
+    mov->operands[1] = SpasmOpReg(reg);
+
+    return true;
+}
+
+static bool spasm_x86_64_peephole_self_move(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs)
+{
+    const SpasmInstruction* mov = &instrs[0];
+
+    switch(mov->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_MOV:
+            /* mov r32, r32 clears the upper half, it is not a no-op */
+            if(spasm_x86_64_peephole_is_gp(&mov->operands[0], 32))
+                return false;
+            break;
+        case SpasmMnemonic_x86_64_MOVAPS:
+        case SpasmMnemonic_x86_64_MOVAPD:
+        case SpasmMnemonic_x86_64_MOVUPS:
+        case SpasmMnemonic_x86_64_MOVUPD:
+        case SpasmMnemonic_x86_64_MOVDQA:
+        case SpasmMnemonic_x86_64_MOVDQU:
+            break;
+        default:
+            return false;
+    }
+
+    if(mov->num_operands != 2 ||
+       mov->operands[0].type != SpasmOperandType_Register ||
+       mov->operands[1].type != SpasmOperandType_Register ||
+       mov->operands[0].reg != mov->operands[1].reg)
+        return false;
+
+    window->num_records--;
+
+    return true;
+}
+
+static bool spasm_x86_64_peephole_store_load(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs)
+{
+    const SpasmInstruction* store = &instrs[0];
+    SpasmInstruction* load = &instrs[1];
+
+    if(store->mnemonic != SpasmMnemonic_x86_64_MOV ||
+       load->mnemonic != SpasmMnemonic_x86_64_MOV ||
+       store->num_operands != 2 ||
+       load->num_operands != 2 ||
+       store->operands[1].type != SpasmOperandType_Register ||
+       load->operands[0].type != SpasmOperandType_Register ||
+       !spasm_x86_64_peephole_same_memory(&store->operands[0], &load->operands[1]))
+        return false;
+
+    const uint8_t stored = store->operands[1].reg;
+    const uint8_t loaded = load->operands[0].reg;
+
+    /* Same width, and general purpose registers of the same group */
+    if(stored < SpasmRegister_x86_64_AL ||
+       stored > SpasmRegister_x86_64_R15 ||
+       loaded < SpasmRegister_x86_64_AL ||
+       loaded > SpasmRegister_x86_64_R15 ||
+       (stored - SpasmRegister_x86_64_AL) / 16 != (loaded - SpasmRegister_x86_64_AL) / 16)
+        return false;
+
+    /* Reloading a 32 bits register still zero-extends it, keep it as a register move */
+    if(stored == loaded && !spasm_x86_64_peephole_is_gp(&load->operands[0], 32))
+    {
+        window->num_records--;
+        return true;
+    }
+
+    load->form = 0;
+    load->operands[1] = SpasmOpReg(stored);
+
+    return true;
+}
+
+static bool spasm_x86_64_peephole_add_chain(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs)
+{
+    SpasmInstruction* first = &instrs[0];
+    const SpasmInstruction* second = &instrs[1];
+
+    if((first->mnemonic != SpasmMnemonic_x86_64_ADD && first->mnemonic != SpasmMnemonic_x86_64_SUB) ||
+       (second->mnemonic != SpasmMnemonic_x86_64_ADD && second->mnemonic != SpasmMnemonic_x86_64_SUB) ||
+       first->num_operands != 2 ||
+       second->num_operands != 2 ||
+       first->operands[0].type != SpasmOperandType_Register ||
+       second->operands[0].type != SpasmOperandType_Register ||
+       first->operands[0].reg != second->operands[0].reg ||
+       !spasm_x86_64_peephole_is_imm(&first->operands[1]) ||
+       !spasm_x86_64_peephole_is_imm(&second->operands[1]))
+        return false;
+
+    const bool is_64 = spasm_x86_64_peephole_is_gp(&first->operands[0], 64);
+
+    if(!is_64 && !spasm_x86_64_peephole_is_gp(&first->operands[0], 32))
+        return false;
+
+    int64_t sum = first->mnemonic == SpasmMnemonic_x86_64_ADD ? spasm_x86_64_peephole_imm(&first->operands[1]) :
+                                                                -spasm_x86_64_peephole_imm(&first->operands[1]);
+
+    sum += second->mnemonic == SpasmMnemonic_x86_64_ADD ? spasm_x86_64_peephole_imm(&second->operands[1]) :
+                                                          -spasm_x86_64_peephole_imm(&second->operands[1]);
+
+    /* 32 bits additions wrap, 64 bits ones need the sum to fit the sign-extended imm32 */
+    if(!is_64)
+        sum = (int64_t)(int32_t)(uint32_t)sum;
+    else if(sum < INT32_MIN || sum > INT32_MAX)
+        return false;
+
+    /* The carry and overflow of the chain differ from the ones of a single addition */
+    if(!spasm_x86_64_peephole_flags_dead(window->next, window->end))
+        return false;
+
+    /* A 32 bits chain still zero-extends the register, it cancels into a mov r32, r32 */
+    if(sum == 0 && is_64)
+    {
+        window->num_records -= 2;
+        return true;
+    }
+
+    if(sum == 0)
+    {
+        first->mnemonic = SpasmMnemonic_x86_64_MOV;
+        first->form = 0;
+        first->operands[1] = first->operands[0];
+
+        window->num_records--;
+
+        return true;
+    }
+
+    first->mnemonic = SpasmMnemonic_x86_64_ADD;
+    first->form = 0;
+    first->operands[1] = spasm_x86_64_peephole_make_imm(sum);
+
+    window->num_records--;
+
+    return true;
+}
+
+static bool spasm_x86_64_peephole_lea_chain(Spasm_x86_64_PeepholeWindow* window, SpasmInstruction* instrs)
+{
+    SpasmInstruction* first = &instrs[0];
+    const SpasmInstruction* second = &instrs[1];
+
+    if(first->mnemonic != SpasmMnemonic_x86_64_LEA ||
+       second->mnemonic != SpasmMnemonic_x86_64_LEA ||
+       first->num_operands != 2 ||
+       second->num_operands != 2 ||
+       !spasm_x86_64_peephole_is_gp(&first->operands[0], 64) ||
+       second->operands[0].type != SpasmOperandType_Register ||
+       second->operands[0].reg != first->operands[0].reg ||
+       first->operands[1].type != SpasmOperandType_Mem ||
+       first->operands[1].mem_reg == SpasmRegister_x86_64_RIP ||
+       second->operands[1].type != SpasmOperandType_Mem ||
+       second->operands[1].mem_reg != first->operands[0].reg ||
+       second->operands[1].mem_index != 0)
+        return false;
+
+    const int64_t displacement = (int64_t)first->operands[1].mem_displacement +
+                                 (int64_t)second->operands[1].mem_displacement;
+
+    if(displacement < INT32_MIN || displacement > INT32_MAX)
+        return false;
+
+    first->form = 0;
+    first->operands[1].mem_displacement = (int32_t)displacement;
+
+    window->num_records--;
+
+    return true;
+}
+
+static const Spasm_x86_64_PeepholeRuleInfo spasm_x86_64_peephole_rules[Spasm_x86_64_PeepholeRule_COUNT] = {
+    { "zero-idiom", 1, spasm_x86_64_peephole_zero_idiom },
+    { "self-move", 1, spasm_x86_64_peephole_self_move },
+    { "store-load", 2, spasm_x86_64_peephole_store_load },
+    { "add-chain", 2, spasm_x86_64_peephole_add_chain },
+    { "lea-chain", 2, spasm_x86_64_peephole_lea_chain },
+};
+
+const char* spasm_x86_64_peephole_rule_name(Spasm_x86_64_PeepholeRule rule)
+{
+    return rule < Spasm_x86_64_PeepholeRule_COUNT ? spasm_x86_64_peephole_rules[rule].name : "unknown";
+}
+
+/* Peephole pass */
+
+void spasm_x86_64_peephole(SpasmInstructions* instructions,
+                           uint32_t rules,
+                           Spasm_x86_64_PeepholeStats* stats)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    Spasm_x86_64_PeepholeWindow window;
+    window.records = (SpasmInstruction*)instructions->instructions.data;
+    window.num_records = 0;
+    window.end = window.records + num_instructions;
+
+    size_t hits[Spasm_x86_64_PeepholeRule_COUNT];
+    memset(hits, 0, sizeof(hits));
+
+    for(size_t i = 0; i < num_instructions; i++)
+    {
+        if(window.num_records != i)
+            window.records[window.num_records] = window.records[i];
+
+        window.num_records++;
+        window.next = window.records + i + 1;
+
+        /* A rewrite can make the instructions before it match, retry until nothing applies */
+        bool applied = true;
+
+        while(applied)
+        {
+            applied = false;
+
+            for(uint32_t r = 0; r < Spasm_x86_64_PeepholeRule_COUNT && !applied; r++)
+            {
+                const Spasm_x86_64_PeepholeRuleInfo* rule = &spasm_x86_64_peephole_rules[r];
+
+                if((rules & (1u << r)) == 0 || window.num_records < rule->num_instructions)
+                    continue;
+
+                SpasmInstruction* instrs = window.records + window.num_records - rule->num_instructions;
+
+                /* Pseudo-instructions are never rewritten, so they are barriers */
+                bool has_pseudo = false;
+
+                for(uint8_t j = 0; j < rule->num_instructions; j++)
+                    has_pseudo |= spasm_mnemonic_is_pseudo(instrs[j].mnemonic);
+
+                if(has_pseudo || !rule->apply(&window, instrs))
+                    continue;
+
+                hits[r]++;
+                applied = true;
+            }
+        }
+    }
+
+    instructions->instructions.size = window.num_records;
+
+    if(stats == NULL)
+        return;
+
+    for(uint32_t r = 0; r < Spasm_x86_64_PeepholeRule_COUNT; r++)
+        stats->hits[r] += hits[r];
+
+    stats->num_removed += num_instructions - window.num_records;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,1137 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+#include "spasm/vector.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_REGALLOC_NO_POSITION UINT32_MAX
+#define SPASM_X86_64_REGALLOC_SPILLED 0xFF
+#define SPASM_X86_64_REGALLOC_NUM_SCRATCH 2
+
+/* Spill code around one instruction: base/index loads, their lea, and two operand loads */
+#define SPASM_X86_64_REGALLOC_MAX_BEFORE 5
+
+typedef enum
+{
+    Spasm_x86_64_RegisterFile_None,
+    Spasm_x86_64_RegisterFile_GP,
+    Spasm_x86_64_RegisterFile_Vector,
+} Spasm_x86_64_RegisterFile;
+
+/*
+    Positions are instruction indices times two, the odd position after a call is where it clobbers
+    the caller-saved registers, so a value defined by the call (its return value) does not conflict
+    with the values the call kills
+*/
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+} Spasm_x86_64_LiveRange;
+
+/*
+    Ranges where a register of the pool is used explicitly by the stream, from the previous use
+    (or the start of the stream for incoming arguments, or the call for return values) to the use,
+    sorted and disjoint. The cursor moves forward with the linear scan
+*/
+typedef struct
+{
+    SpasmVector ranges;
+    size_t cursor;
+    uint32_t open;
+    bool in_pool;
+    bool incoming; /* Not used nor clobbered yet, may hold an argument of the stream */
+} Spasm_x86_64_FixedTrack;
+
+typedef struct
+{
+    SpasmContext* ctx;
+    const SpasmAllocator* allocator;
+    const Spasm_x86_64_RegisterAllocationConfig* config;
+
+    uint32_t num_vregs;
+    uint32_t num_used;
+    uint32_t* starts;
+    uint32_t* ends;
+    uint32_t* order; /* Used virtual registers by first occurrence, so sorted by start */
+    int32_t* slots;
+    uint8_t* files;
+    uint8_t* sizes; /* Bytes of the widest view */
+    uint8_t* codes;
+
+    /* Loop heads (labels branched to from below) and the furthest branch back to them */
+    uint32_t num_labels;
+    uint32_t* label_positions;
+    uint32_t num_instructions;
+    uint32_t* head_ends;
+    uint32_t num_heads;
+    uint32_t* first_head; /* First loop head at or after an instruction */
+    uint32_t num_levels;
+    uint32_t* sparse; /* num_levels * num_heads, max of the ends over 2^level heads */
+
+    Spasm_x86_64_FixedTrack tracks[2][16];
+
+    uint8_t pool[2][16];
+    size_t pool_size[2];
+    uint8_t scratch[2][SPASM_X86_64_REGALLOC_NUM_SCRATCH];
+} Spasm_x86_64_RegisterAllocation;
+
+/* Registers */
+
+static SPASM_FORCE_INLINE uint8_t spasm_x86_64_regalloc_code(uint8_t reg)
+{
+    return (uint8_t)((reg - 1) % 16);
+}
+
+static SPASM_FORCE_INLINE Spasm_x86_64_RegisterFile spasm_x86_64_regalloc_file(uint8_t reg)
+{
+    if(reg >= SpasmRegister_x86_64_AL && reg <= SpasmRegister_x86_64_R15)
+        return Spasm_x86_64_RegisterFile_GP;
+
+    if(reg >= SpasmRegister_x86_64_XMM0 && reg <= SpasmRegister_x86_64_ZMM15)
+        return Spasm_x86_64_RegisterFile_Vector;
+
+    return Spasm_x86_64_RegisterFile_None;
+}
+
+static SPASM_FORCE_INLINE uint8_t spasm_x86_64_regalloc_view_size(uint8_t reg)
+{
+    if(spasm_x86_64_regalloc_file(reg) == Spasm_x86_64_RegisterFile_GP)
+        return (uint8_t)(1 << ((reg - 1) / 16));
+
+    return (uint8_t)(16 << ((reg - SpasmRegister_x86_64_XMM0) / 16));
+}
+
+/* Size of the slot a view needs: a full 64 bits register for general purpose views */
+static SPASM_FORCE_INLINE uint8_t spasm_x86_64_regalloc_slot_size(uint8_t reg)
+{
+    if(spasm_x86_64_regalloc_file(reg) == Spasm_x86_64_RegisterFile_GP)
+        return 8;
+
+    return spasm_x86_64_regalloc_view_size(reg);
+}
+
+/* Register of the same width as the view, with the given code */
+static SPASM_FORCE_INLINE SpasmRegister spasm_x86_64_regalloc_view(uint8_t view, uint8_t code)
+{
+    return (SpasmRegister)(view - spasm_x86_64_regalloc_code(view) + code);
+}
+
+/* Live ranges */
+
+static bool spasm_x86_64_regalloc_add_range(SpasmVector* ranges, uint32_t start, uint32_t end)
+{
+    const size_t size = spasm_vector_size(ranges);
+
+    if(size > 0)
+    {
+        Spasm_x86_64_LiveRange* last = (Spasm_x86_64_LiveRange*)spasm_vector_at(ranges, size - 1);
+
+        if(start <= last->end + 1)
+        {
+            if(end > last->end)
+                last->end = end;
+
+            return true;
+        }
+    }
+
+    const Spasm_x86_64_LiveRange range = { start, end };
+
+    return spasm_vector_push_back(ranges, &range) != NULL;
+}
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_regalloc_fixed_use(Spasm_x86_64_FixedTrack* track,
+                                                               uint32_t position)
+{
+    if(!track->in_pool)
+        return true;
+
+    uint32_t start = position;
+
+    if(track->open != SPASM_X86_64_REGALLOC_NO_POSITION)
+        start = track->open;
+    else if(track->incoming)
+        start = 0;
+
+    track->open = position;
+    track->incoming = false;
+
+    return spasm_x86_64_regalloc_add_range(&track->ranges, start, position);
+}
+
+/* Records the occurrence of a virtual register, seen through the given register view */
+static bool spasm_x86_64_regalloc_use(Spasm_x86_64_RegisterAllocation* ra,
+                                      uint32_t vreg,
+                                      uint8_t view,
+                                      uint32_t position)
+{
+    const Spasm_x86_64_RegisterFile file = spasm_x86_64_regalloc_file(view);
+
+    if(vreg >= ra->num_vregs || file == Spasm_x86_64_RegisterFile_None)
+        return false;
+
+    if(ra->files[vreg] == Spasm_x86_64_RegisterFile_None)
+    {
+        ra->files[vreg] = (uint8_t)file;
+        ra->starts[vreg] = position;
+        ra->order[ra->num_used++] = vreg;
+    }
+    else if(ra->files[vreg] != file)
+    {
+        return false;
+    }
+
+    const uint8_t size = spasm_x86_64_regalloc_slot_size(view);
+
+    if(size > ra->sizes[vreg])
+        ra->sizes[vreg] = size;
+
+    ra->ends[vreg] = position;
+
+    return true;
+}
+
+/* Loops */
+
+static SPASM_FORCE_INLINE uint32_t spasm_x86_64_regalloc_log2(uint32_t x)
+{
+    uint32_t log = 0;
+
+    while(x >>= 1)
+        log++;
+
+    return log;
+}
+
+/* Builds the sparse table answering "furthest branch back to a head in this range" in O(1) */
+static bool spasm_x86_64_regalloc_build_loops(Spasm_x86_64_RegisterAllocation* ra)
+{
+    ra->num_heads = 0;
+
+    for(uint32_t i = 0; i < ra->num_instructions; i++)
+        ra->num_heads += (uint32_t)(ra->head_ends[i] != 0);
+
+    ra->first_head = (uint32_t*)spasm_allocator_alloc(ra->allocator,
+                                                      (ra->num_instructions + 1) * sizeof(uint32_t));
+    ra->num_levels = spasm_x86_64_regalloc_log2(ra->num_heads) + 1;
+    ra->sparse = (uint32_t*)spasm_allocator_alloc(ra->allocator,
+                                                  ra->num_levels * ra->num_heads * sizeof(uint32_t));
+
+    if(ra->first_head == NULL || ra->sparse == NULL)
+        return false;
+
+    uint32_t head = 0;
+
+    for(uint32_t i = 0; i < ra->num_instructions; i++)
+    {
+        ra->first_head[i] = head;
+
+        if(ra->head_ends[i] != 0)
+        {
+            ra->sparse[head] = ra->head_ends[i];
+            head++;
+        }
+    }
+
+    ra->first_head[ra->num_instructions] = head;
+
+    for(uint32_t level = 1; level < ra->num_levels; level++)
+    {
+        const uint32_t* previous = ra->sparse + (level - 1) * ra->num_heads;
+        uint32_t* current = ra->sparse + level * ra->num_heads;
+        const uint32_t half = 1u << (level - 1);
+
+        for(uint32_t i = 0; i + (1u << level) <= ra->num_heads; i++)
+            current[i] = previous[i] > previous[i + half] ? previous[i] : previous[i + half];
+    }
+
+    return true;
+}
+
+/*
+    A value live at a loop head is live on the whole loop: the interval is extended to the furthest
+    branch back to a head it covers, until it is stable (nested and overlapping loops)
+*/
+static uint32_t spasm_x86_64_regalloc_extend(const Spasm_x86_64_RegisterAllocation* ra,
+                                             uint32_t start,
+                                             uint32_t end)
+{
+    if(ra->num_heads == 0)
+        return end;
+
+    while(true)
+    {
+        /*
+            Heads from the start up to the end instruction. Virtual registers never start on a
+            label, and the incoming arguments start at 0 before a head on the first instruction
+        */
+        const uint32_t first = ra->first_head[(start + 1) / 2];
+        const uint32_t last = ra->first_head[end / 2 + 1];
+
+        if(first >= last)
+            return end;
+
+        const uint32_t level = spasm_x86_64_regalloc_log2(last - first);
+        const uint32_t* row = ra->sparse + level * ra->num_heads;
+        const uint32_t a = row[first];
+        const uint32_t b = row[last - (1u << level)];
+        const uint32_t furthest = (a > b ? a : b) * 2;
+
+        if(furthest <= end)
+            return end;
+
+        end = furthest;
+    }
+}
+
+/* Scan */
+
+static SPASM_FORCE_INLINE bool spasm_x86_64_regalloc_is_call(uint16_t mnemonic)
+{
+    return mnemonic == SpasmMnemonic_x86_64_CALL;
+}
+
+static bool spasm_x86_64_regalloc_scan(Spasm_x86_64_RegisterAllocation* ra,
+                                       SpasmInstructions* instructions,
+                                       const SpasmInstruction** error_instr)
+{
+    for(uint32_t i = 0; i < ra->num_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+        const uint32_t position = i * 2;
+
+        *error_instr = instr;
+
+        if(instr->mnemonic == SpasmMnemonic_Label)
+        {
+            if(instr->num_operands == 1 && instr->operands[0].label < ra->num_labels)
+                ra->label_positions[instr->operands[0].label] = i;
+
+            continue;
+        }
+
+        if(spasm_mnemonic_is_pseudo(instr->mnemonic))
+            continue;
+
+        for(uint8_t j = 0; j < instr->num_operands; j++)
+        {
+            const SpasmOperand* operand = &instr->operands[j];
+
+            switch(operand->type)
+            {
+                case SpasmOperandType_VirtualRegister:
+                    if(!spasm_x86_64_regalloc_use(ra, operand->vreg, operand->reg, position))
+                        return false;
+
+                    break;
+
+                case SpasmOperandType_Register:
+                {
+                    const Spasm_x86_64_RegisterFile file = spasm_x86_64_regalloc_file(operand->reg);
+
+                    if(file != Spasm_x86_64_RegisterFile_None &&
+                       !spasm_x86_64_regalloc_fixed_use(&ra->tracks[file - 1][spasm_x86_64_regalloc_code(operand->reg)],
+                                                        position))
+                        return false;
+
+                    break;
+                }
+
+                case SpasmOperandType_Mem:
+                {
+                    if(operand->mem_reg == SPASM_VIRTUAL_REGISTER)
+                    {
+                        if(!spasm_x86_64_regalloc_use(ra, operand->mem_vregs.base, SpasmRegister_x86_64_RAX, position))
+                            return false;
+                    }
+                    else if(spasm_x86_64_regalloc_file(operand->mem_reg) == Spasm_x86_64_RegisterFile_GP)
+                    {
+                        if(!spasm_x86_64_regalloc_fixed_use(&ra->tracks[0][spasm_x86_64_regalloc_code(operand->mem_reg)],
+                                                            position))
+                            return false;
+                    }
+
+                    if(operand->mem_index == SPASM_VIRTUAL_REGISTER)
+                    {
+                        if(!spasm_x86_64_regalloc_use(ra, operand->mem_vregs.index, SpasmRegister_x86_64_RAX, position))
+                            return false;
+                    }
+                    else if(spasm_x86_64_regalloc_file(operand->mem_index) == Spasm_x86_64_RegisterFile_GP)
+                    {
+                        if(!spasm_x86_64_regalloc_fixed_use(&ra->tracks[0][spasm_x86_64_regalloc_code(operand->mem_index)],
+                                                            position))
+                            return false;
+                    }
+
+                    break;
+                }
+
+                case SpasmOperandType_Label:
+                {
+                    /* Branch to a label bound above: back edge of a loop */
+                    if(operand->label < ra->num_labels &&
+                       ra->label_positions[operand->label] != SPASM_X86_64_REGALLOC_NO_POSITION)
+                    {
+                        uint32_t* head_end = &ra->head_ends[ra->label_positions[operand->label]];
+
+                        if(i > *head_end)
+                            *head_end = i;
+                    }
+
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        if(spasm_x86_64_regalloc_is_call(instr->mnemonic))
+        {
+            /* Arguments are live up to the call, which clobbers the whole pool */
+            for(size_t file = 0; file < 2; file++)
+            {
+                for(size_t code = 0; code < 16; code++)
+                {
+                    Spasm_x86_64_FixedTrack* track = &ra->tracks[file][code];
+
+                    if(!track->in_pool)
+                        continue;
+
+                    if(!spasm_x86_64_regalloc_add_range(&track->ranges,
+                                                        track->open != SPASM_X86_64_REGALLOC_NO_POSITION ? track->open :
+                                                                                                           position,
+                                                        position + 1))
+                        return false;
+
+                    track->open = SPASM_X86_64_REGALLOC_NO_POSITION;
+                    track->incoming = false;
+                }
+            }
+
+            /* Return values are live from the call to their next use */
+            ra->tracks[0][spasm_x86_64_regalloc_code(get_call_return_value_gp_register(ra->config->abi))].open = position + 1;
+            ra->tracks[1][spasm_x86_64_regalloc_code(get_call_return_value_fp_register(ra->config->abi))].open = position + 1;
+        }
+        else if(instr->mnemonic == SpasmMnemonic_x86_64_RET)
+        {
+            /* The return values are read by the caller */
+            Spasm_x86_64_FixedTrack* gp = &ra->tracks[0][spasm_x86_64_regalloc_code(get_call_return_value_gp_register(ra->config->abi))];
+            Spasm_x86_64_FixedTrack* fp = &ra->tracks[1][spasm_x86_64_regalloc_code(get_call_return_value_fp_register(ra->config->abi))];
+
+            if(gp->open != SPASM_X86_64_REGALLOC_NO_POSITION && !spasm_x86_64_regalloc_fixed_use(gp, position))
+                return false;
+
+            if(fp->open != SPASM_X86_64_REGALLOC_NO_POSITION && !spasm_x86_64_regalloc_fixed_use(fp, position))
+                return false;
+        }
+    }
+
+    *error_instr = NULL;
+
+    return true;
+}
+
+/* Extends the fixed ranges over the loops and merges the ones that now overlap */
+static void spasm_x86_64_regalloc_extend_fixed(Spasm_x86_64_RegisterAllocation* ra, SpasmVector* ranges)
+{
+    const size_t size = spasm_vector_size(ranges);
+    Spasm_x86_64_LiveRange* data = (Spasm_x86_64_LiveRange*)ranges->data;
+
+    size_t merged = 0;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        Spasm_x86_64_LiveRange range = data[i];
+        range.end = spasm_x86_64_regalloc_extend(ra, range.start, range.end);
+
+        if(merged > 0 && range.start <= data[merged - 1].end + 1)
+        {
+            if(range.end > data[merged - 1].end)
+                data[merged - 1].end = range.end;
+        }
+        else
+        {
+            data[merged++] = range;
+        }
+    }
+
+    ranges->size = merged;
+}
+
+/* Linear scan */
+
+static bool spasm_x86_64_regalloc_conflicts(Spasm_x86_64_FixedTrack* track, uint32_t start, uint32_t end)
+{
+    const size_t size = spasm_vector_size(&track->ranges);
+
+    while(track->cursor < size &&
+          ((Spasm_x86_64_LiveRange*)spasm_vector_at(&track->ranges, track->cursor))->end < start)
+        track->cursor++;
+
+    return track->cursor < size &&
+           ((Spasm_x86_64_LiveRange*)spasm_vector_at(&track->ranges, track->cursor))->start <= end;
+}
+
+static void spasm_x86_64_regalloc_linear_scan(Spasm_x86_64_RegisterAllocation* ra)
+{
+    uint32_t active[2][16];
+    size_t num_active[2] = { 0, 0 };
+
+    for(uint32_t i = 0; i < ra->num_used; i++)
+    {
+        const uint32_t vreg = ra->order[i];
+        const size_t file = ra->files[vreg] - 1;
+        const uint32_t start = ra->starts[vreg];
+        const uint32_t end = ra->ends[vreg];
+
+        uint32_t used = 0;
+        size_t kept = 0;
+
+        for(size_t j = 0; j < num_active[file]; j++)
+        {
+            const uint32_t other = active[file][j];
+
+            if(ra->ends[other] >= start)
+            {
+                active[file][kept++] = other;
+                used |= 1u << ra->codes[other];
+            }
+        }
+
+        num_active[file] = kept;
+
+        ra->codes[vreg] = SPASM_X86_64_REGALLOC_SPILLED;
+
+        for(size_t j = 0; j < ra->pool_size[file]; j++)
+        {
+            const uint8_t code = ra->pool[file][j];
+
+            if((used & (1u << code)) == 0 &&
+               !spasm_x86_64_regalloc_conflicts(&ra->tracks[file][code], start, end))
+            {
+                ra->codes[vreg] = code;
+                active[file][num_active[file]++] = vreg;
+                break;
+            }
+        }
+
+        if(ra->codes[vreg] != SPASM_X86_64_REGALLOC_SPILLED)
+            continue;
+
+        /* Spills the active interval ending last if it ends after this one and its register is free */
+        size_t victim = num_active[file];
+
+        for(size_t j = 0; j < num_active[file]; j++)
+        {
+            const uint32_t other = active[file][j];
+
+            if(ra->ends[other] > end &&
+               (victim == num_active[file] || ra->ends[other] > ra->ends[active[file][victim]]) &&
+               !spasm_x86_64_regalloc_conflicts(&ra->tracks[file][ra->codes[other]], start, end))
+                victim = j;
+        }
+
+        if(victim < num_active[file])
+        {
+            const uint32_t other = active[file][victim];
+
+            ra->codes[vreg] = ra->codes[other];
+            ra->codes[other] = SPASM_X86_64_REGALLOC_SPILLED;
+            active[file][victim] = vreg;
+        }
+    }
+}
+
+/* Slots are packed by decreasing size so they all stay naturally aligned */
+static uint32_t spasm_x86_64_regalloc_assign_slots(Spasm_x86_64_RegisterAllocation* ra, uint32_t* num_spilled)
+{
+    uint32_t offset = 0;
+
+    *num_spilled = 0;
+
+    for(uint32_t size = 64; size >= 8; size >>= 1)
+    {
+        for(uint32_t i = 0; i < ra->num_used; i++)
+        {
+            const uint32_t vreg = ra->order[i];
+
+            if(ra->codes[vreg] != SPASM_X86_64_REGALLOC_SPILLED || ra->sizes[vreg] != size)
+                continue;
+
+            ra->slots[vreg] = (int32_t)offset;
+            offset += size;
+            (*num_spilled)++;
+        }
+    }
+
+    return (offset + 15) & ~15u;
+}
+
+/* Rewrite */
+
+static SPASM_FORCE_INLINE SpasmOperand spasm_x86_64_regalloc_slot(const Spasm_x86_64_RegisterAllocation* ra,
+                                                                  uint32_t vreg)
+{
+    return SpasmOpMemory(ra->config->frame_register, 0, ra->config->frame_offset + ra->slots[vreg], 1);
+}
+
+/* Load (or store if store is true) of a spilled virtual register from/to its slot */
+static SpasmInstruction spasm_x86_64_regalloc_move(const Spasm_x86_64_RegisterAllocation* ra,
+                                                   uint32_t vreg,
+                                                   uint8_t code,
+                                                   bool store)
+{
+    SpasmInstruction move;
+    memset(&move, 0, sizeof(SpasmInstruction));
+
+    SpasmRegister reg;
+
+    switch(ra->sizes[vreg])
+    {
+        case 8:
+            move.mnemonic = SpasmMnemonic_x86_64_MOV;
+            reg = (SpasmRegister)(SpasmRegister_x86_64_RAX + code);
+            break;
+        case 16:
+            move.mnemonic = SpasmMnemonic_x86_64_MOVUPS;
+            reg = (SpasmRegister)(SpasmRegister_x86_64_XMM0 + code);
+            break;
+        case 32:
+            move.mnemonic = SpasmMnemonic_x86_64_VMOVUPS;
+            reg = (SpasmRegister)(SpasmRegister_x86_64_YMM0 + code);
+            break;
+        default:
+            move.mnemonic = SpasmMnemonic_x86_64_VMOVUPS;
+            reg = (SpasmRegister)(SpasmRegister_x86_64_ZMM0 + code);
+            break;
+    }
+
+    move.num_operands = 2;
+    move.operands[store ? 0 : 1] = spasm_x86_64_regalloc_slot(ra, vreg);
+    move.operands[store ? 1 : 0] = SpasmOpReg(reg);
+
+    return move;
+}
+
+/*
+    Operands written by instr, bit i for operand i, from the accesses of its form with the spilled
+    registers in scratch registers. All of them if no form matches, storing back an operand that
+    is only read is redundant but correct
+*/
+static uint32_t spasm_x86_64_regalloc_written_operands(const Spasm_x86_64_RegisterAllocation* ra,
+                                                       const SpasmInstruction* instr)
+{
+    SpasmInstruction probe = *instr;
+
+    for(uint8_t i = 0; i < probe.num_operands; i++)
+    {
+        SpasmOperand* operand = &probe.operands[i];
+
+        if(operand->type == SpasmOperandType_VirtualRegister)
+            *operand = SpasmOpReg(spasm_x86_64_regalloc_view(operand->reg, ra->scratch[ra->files[operand->vreg] - 1][0]));
+    }
+
+    const Spasm_x86_64_FormAccess* access = spasm_x86_64_instruction_access(&probe);
+
+    return access != NULL ? access->written : UINT32_MAX;
+}
+
+typedef struct
+{
+    SpasmInstruction before[SPASM_X86_64_REGALLOC_MAX_BEFORE];
+    SpasmInstruction after[SPASM_X86_64_REGALLOC_NUM_SCRATCH];
+    size_t num_before;
+    size_t num_after;
+} Spasm_x86_64_SpillCode;
+
+/*
+    Replaces the spilled register operands of instr by the slot of memory_vreg (if not
+    SPASM_X86_64_REGALLOC_NO_POSITION) and scratch registers loaded before (and stored after for
+    the written operands). Returns false if there are not enough scratch registers
+*/
+static bool spasm_x86_64_regalloc_spill_operands(const Spasm_x86_64_RegisterAllocation* ra,
+                                                 SpasmInstruction* instr,
+                                                 uint32_t memory_vreg,
+                                                 size_t used_scratch[2],
+                                                 Spasm_x86_64_SpillCode* code)
+{
+    /* Scratch registers taken by the address of a memory operand hold no virtual register */
+    uint32_t loaded[2][SPASM_X86_64_REGALLOC_NUM_SCRATCH];
+    memset(loaded, 0xFF, sizeof(loaded));
+
+    const uint32_t written = spasm_x86_64_regalloc_written_operands(ra, instr);
+    bool stored[2][SPASM_X86_64_REGALLOC_NUM_SCRATCH] = { { false } };
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        SpasmOperand* operand = &instr->operands[i];
+
+        if(operand->type != SpasmOperandType_VirtualRegister)
+            continue;
+
+        const uint32_t vreg = operand->vreg;
+
+        if(vreg == memory_vreg)
+        {
+            *operand = spasm_x86_64_regalloc_slot(ra, vreg);
+            continue;
+        }
+
+        const size_t file = ra->files[vreg] - 1;
+        size_t scratch = 0;
+
+        while(scratch < used_scratch[file] && loaded[file][scratch] != vreg)
+            scratch++;
+
+        if(scratch == used_scratch[file])
+        {
+            if(scratch == SPASM_X86_64_REGALLOC_NUM_SCRATCH)
+                return false;
+
+            loaded[file][scratch] = vreg;
+            used_scratch[file]++;
+
+            code->before[code->num_before++] = spasm_x86_64_regalloc_move(ra, vreg, ra->scratch[file][scratch], false);
+        }
+
+        if((written & (1u << i)) && !stored[file][scratch])
+        {
+            code->after[code->num_after++] = spasm_x86_64_regalloc_move(ra, vreg, ra->scratch[file][scratch], true);
+            stored[file][scratch] = true;
+        }
+
+        *operand = SpasmOpReg(spasm_x86_64_regalloc_view(operand->reg, ra->scratch[file][scratch]));
+    }
+
+    return true;
+}
+
+/* Memory operand with virtual base and index, returns false if it needs too many scratch registers */
+static bool spasm_x86_64_regalloc_rewrite_memory(const Spasm_x86_64_RegisterAllocation* ra,
+                                                 SpasmOperand* operand,
+                                                 size_t used_scratch[2],
+                                                 Spasm_x86_64_SpillCode* code)
+{
+    uint8_t* regs[2] = { &operand->mem_reg, &operand->mem_index };
+    const uint32_t vregs[2] = { operand->mem_vregs.base, operand->mem_vregs.index };
+    size_t num_loaded = 0;
+
+    for(size_t i = 0; i < 2; i++)
+    {
+        if(*regs[i] != SPASM_VIRTUAL_REGISTER)
+            continue;
+
+        const uint32_t vreg = vregs[i];
+
+        if(ra->codes[vreg] != SPASM_X86_64_REGALLOC_SPILLED)
+        {
+            *regs[i] = (uint8_t)(SpasmRegister_x86_64_RAX + ra->codes[vreg]);
+            continue;
+        }
+
+        if(used_scratch[0] == SPASM_X86_64_REGALLOC_NUM_SCRATCH)
+            return false;
+
+        const uint8_t scratch = ra->scratch[0][used_scratch[0]++];
+
+        code->before[code->num_before++] = spasm_x86_64_regalloc_move(ra, vreg, scratch, false);
+        *regs[i] = (uint8_t)(SpasmRegister_x86_64_RAX + scratch);
+        num_loaded++;
+    }
+
+    /* Both spilled: the address goes in the base scratch, so the other one stays free */
+    if(num_loaded == 2)
+    {
+        SpasmInstruction* lea = &code->before[code->num_before++];
+        memset(lea, 0, sizeof(SpasmInstruction));
+
+        lea->mnemonic = SpasmMnemonic_x86_64_LEA;
+        lea->num_operands = 2;
+        lea->operands[0] = SpasmOpReg(operand->mem_reg);
+        lea->operands[1] = SpasmOpMemory(operand->mem_reg, operand->mem_index, 0, operand->mem_scale);
+
+        operand->mem_index = 0;
+        operand->mem_scale = 1;
+        used_scratch[0]--;
+    }
+
+    operand->mem_vregs.base = 0;
+    operand->mem_vregs.index = 0;
+
+    return true;
+}
+
+static bool spasm_x86_64_regalloc_rewrite(const Spasm_x86_64_RegisterAllocation* ra,
+                                          const SpasmInstruction* instr,
+                                          SpasmInstruction* rewritten,
+                                          Spasm_x86_64_SpillCode* code)
+{
+    *rewritten = *instr;
+    rewritten->form = 0;
+
+    code->num_before = 0;
+    code->num_after = 0;
+
+    size_t used_scratch[2] = { 0, 0 };
+    bool has_memory = false;
+    bool has_spilled = false;
+
+    for(uint8_t i = 0; i < rewritten->num_operands; i++)
+    {
+        SpasmOperand* operand = &rewritten->operands[i];
+
+        if(operand->type == SpasmOperandType_Mem || operand->type == SpasmOperandType_Data)
+        {
+            has_memory = true;
+
+            if(operand->type == SpasmOperandType_Mem &&
+               !spasm_x86_64_regalloc_rewrite_memory(ra, operand, used_scratch, code))
+                return false;
+        }
+        else if(operand->type == SpasmOperandType_VirtualRegister)
+        {
+            if(ra->codes[operand->vreg] != SPASM_X86_64_REGALLOC_SPILLED)
+                *operand = SpasmOpReg(spasm_x86_64_regalloc_view(operand->reg, ra->codes[operand->vreg]));
+            else
+                has_spilled = true;
+        }
+    }
+
+    if(!has_spilled)
+        return true;
+
+    /* Reads and writes the slot directly when the instruction has a form for it */
+    if(!has_memory)
+    {
+        for(uint8_t i = 0; i < rewritten->num_operands; i++)
+        {
+            const SpasmOperand* operand = &rewritten->operands[i];
+
+            /* Narrower views would leave the rest of the slot stale where the register is zeroed */
+            if(operand->type != SpasmOperandType_VirtualRegister ||
+               spasm_x86_64_regalloc_view_size(operand->reg) != ra->sizes[operand->vreg])
+                continue;
+
+            SpasmInstruction candidate = *rewritten;
+            Spasm_x86_64_SpillCode candidate_code = *code;
+            size_t candidate_scratch[2] = { used_scratch[0], used_scratch[1] };
+
+            if(!spasm_x86_64_regalloc_spill_operands(ra,
+                                                     &candidate,
+                                                     operand->vreg,
+                                                     candidate_scratch,
+                                                     &candidate_code))
+                continue;
+
+            /* The slot must be used once, a memory operand can't appear twice */
+            bool single_use = true;
+
+            for(uint8_t j = 0; j < rewritten->num_operands; j++)
+                single_use &= j == i ||
+                              rewritten->operands[j].type != SpasmOperandType_VirtualRegister ||
+                              rewritten->operands[j].vreg != operand->vreg;
+
+            if(single_use && spasm_x86_64_instruction_length(&candidate) != 0)
+            {
+                *rewritten = candidate;
+                *code = candidate_code;
+                return true;
+            }
+        }
+    }
+
+    return spasm_x86_64_regalloc_spill_operands(ra,
+                                                rewritten,
+                                                SPASM_X86_64_REGALLOC_NO_POSITION,
+                                                used_scratch,
+                                                code);
+}
+
+/* Allocation */
+
+static bool spasm_x86_64_regalloc_has_virtual(const SpasmInstruction* instr)
+{
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        const SpasmOperand* operand = &instr->operands[i];
+
+        if(operand->type == SpasmOperandType_VirtualRegister ||
+           (operand->type == SpasmOperandType_Mem &&
+            (operand->mem_reg == SPASM_VIRTUAL_REGISTER || operand->mem_index == SPASM_VIRTUAL_REGISTER)))
+            return true;
+    }
+
+    return false;
+}
+
+static void spasm_x86_64_regalloc_release(Spasm_x86_64_RegisterAllocation* ra)
+{
+    const SpasmAllocator* allocator = ra->allocator;
+
+    spasm_allocator_free(allocator, ra->starts, ra->num_vregs * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->ends, ra->num_vregs * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->order, ra->num_vregs * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->slots, ra->num_vregs * sizeof(int32_t));
+    spasm_allocator_free(allocator, ra->files, ra->num_vregs * sizeof(uint8_t));
+    spasm_allocator_free(allocator, ra->sizes, ra->num_vregs * sizeof(uint8_t));
+    spasm_allocator_free(allocator, ra->codes, ra->num_vregs * sizeof(uint8_t));
+    spasm_allocator_free(allocator, ra->label_positions, ra->num_labels * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->head_ends, ra->num_instructions * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->first_head, (ra->num_instructions + 1) * sizeof(uint32_t));
+    spasm_allocator_free(allocator, ra->sparse, ra->num_levels * ra->num_heads * sizeof(uint32_t));
+
+    for(size_t file = 0; file < 2; file++)
+        for(size_t code = 0; code < 16; code++)
+            spasm_vector_release(&ra->tracks[file][code].ranges);
+}
+
+static bool spasm_x86_64_regalloc_init(Spasm_x86_64_RegisterAllocation* ra,
+                                       SpasmContext* ctx,
+                                       SpasmInstructions* instructions,
+                                       const Spasm_x86_64_RegisterAllocationConfig* config)
+{
+    memset(ra, 0, sizeof(Spasm_x86_64_RegisterAllocation));
+
+    ra->ctx = ctx;
+    ra->allocator = spasm_context_get_allocator(instructions->ctx);
+    ra->config = config;
+    ra->num_vregs = instructions->num_virtual_registers;
+    ra->num_labels = instructions->num_labels;
+    ra->num_instructions = (uint32_t)spasm_instructions_size(instructions);
+
+    size_t num_gp = 0;
+    size_t num_fp = 0;
+    const SpasmRegister* gp = get_call_args_gp_registers(config->abi, &num_gp);
+    const SpasmRegister* fp = get_call_args_fp_registers(config->abi, &num_fp);
+
+    if(gp == NULL || fp == NULL)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedABI, NULL, 0);
+        return false;
+    }
+
+    if(num_gp > get_max_available_gp_registers(config->abi))
+        num_gp = get_max_available_gp_registers(config->abi);
+
+    if(num_fp > get_max_available_fp_registers(config->abi))
+        num_fp = get_max_available_fp_registers(config->abi);
+
+    ra->scratch[0][0] = spasm_x86_64_regalloc_code(SpasmRegister_x86_64_R10);
+    ra->scratch[0][1] = spasm_x86_64_regalloc_code(SpasmRegister_x86_64_R11);
+
+    for(size_t i = 0; i < num_gp; i++)
+        ra->pool[0][ra->pool_size[0]++] = spasm_x86_64_regalloc_code(gp[i]);
+
+    for(size_t i = 0; i < SPASM_X86_64_REGALLOC_NUM_SCRATCH; i++)
+        ra->scratch[1][i] = spasm_x86_64_regalloc_code(fp[num_fp - SPASM_X86_64_REGALLOC_NUM_SCRATCH + i]);
+
+    for(size_t i = 0; i + SPASM_X86_64_REGALLOC_NUM_SCRATCH < num_fp; i++)
+        ra->pool[1][ra->pool_size[1]++] = spasm_x86_64_regalloc_code(fp[i]);
+
+    for(size_t file = 0; file < 2; file++)
+    {
+        for(size_t code = 0; code < 16; code++)
+        {
+            Spasm_x86_64_FixedTrack* track = &ra->tracks[file][code];
+
+            spasm_vector_init(&track->ranges, 0, sizeof(Spasm_x86_64_LiveRange), ra->allocator);
+            track->open = SPASM_X86_64_REGALLOC_NO_POSITION;
+        }
+
+        /* Incoming arguments are live from the start of the stream to their first use */
+        for(size_t i = 0; i < ra->pool_size[file]; i++)
+        {
+            ra->tracks[file][ra->pool[file][i]].in_pool = true;
+            ra->tracks[file][ra->pool[file][i]].incoming = true;
+        }
+    }
+
+    ra->starts = (uint32_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint32_t));
+    ra->ends = (uint32_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint32_t));
+    ra->order = (uint32_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint32_t));
+    ra->slots = (int32_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(int32_t));
+    ra->files = (uint8_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint8_t));
+    ra->sizes = (uint8_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint8_t));
+    ra->codes = (uint8_t*)spasm_allocator_alloc(ra->allocator, ra->num_vregs * sizeof(uint8_t));
+    ra->label_positions = (uint32_t*)spasm_allocator_alloc(ra->allocator, ra->num_labels * sizeof(uint32_t));
+    ra->head_ends = (uint32_t*)spasm_allocator_alloc(ra->allocator, ra->num_instructions * sizeof(uint32_t));
+
+    if((ra->num_vregs > 0 &&
+        (ra->starts == NULL || ra->ends == NULL || ra->order == NULL || ra->slots == NULL ||
+         ra->files == NULL || ra->sizes == NULL || ra->codes == NULL)) ||
+       (ra->num_labels > 0 && ra->label_positions == NULL) ||
+       (ra->num_instructions > 0 && ra->head_ends == NULL))
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    if(ra->num_vregs > 0)
+    {
+        memset(ra->files, 0, ra->num_vregs * sizeof(uint8_t));
+        memset(ra->sizes, 0, ra->num_vregs * sizeof(uint8_t));
+    }
+
+    if(ra->num_labels > 0)
+        memset(ra->label_positions, 0xFF, ra->num_labels * sizeof(uint32_t));
+
+    if(ra->num_instructions > 0)
+        memset(ra->head_ends, 0, ra->num_instructions * sizeof(uint32_t));
+
+    return true;
+}
+
+bool spasm_x86_64_allocate_registers(SpasmContext* ctx,
+                                     SpasmInstructions* instructions,
+                                     const Spasm_x86_64_RegisterAllocationConfig* config,
+                                     Spasm_x86_64_RegisterAllocationStats* stats)
+{
+    SPASM_ASSERT(instructions != NULL, "instructions is NULL");
+
+    Spasm_x86_64_RegisterAllocationConfig default_config;
+
+    if(config == NULL)
+    {
+        default_config.abi = spasm_get_current_abi();
+        default_config.frame_register = SpasmRegister_x86_64_RSP;
+        default_config.frame_offset = 0;
+        config = &default_config;
+    }
+
+    if(stats != NULL)
+        memset(stats, 0, sizeof(Spasm_x86_64_RegisterAllocationStats));
+
+    Spasm_x86_64_RegisterAllocation ra;
+
+    if(!spasm_x86_64_regalloc_init(&ra, ctx, instructions, config))
+    {
+        spasm_x86_64_regalloc_release(&ra);
+        return false;
+    }
+
+    /* Intervals, fixed ranges and loops */
+    const SpasmInstruction* error_instr = NULL;
+
+    if(!spasm_x86_64_regalloc_scan(&ra, instructions, &error_instr))
+    {
+        if(error_instr != NULL)
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_InvalidVirtualRegister, error_instr);
+        else
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+
+        spasm_x86_64_regalloc_release(&ra);
+        return false;
+    }
+
+    bool has_loops = false;
+
+    for(uint32_t i = 0; i < ra.num_instructions && !has_loops; i++)
+        has_loops = ra.head_ends[i] != 0;
+
+    if(has_loops)
+    {
+        if(!spasm_x86_64_regalloc_build_loops(&ra))
+        {
+            spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+            spasm_x86_64_regalloc_release(&ra);
+            return false;
+        }
+
+        for(uint32_t i = 0; i < ra.num_used; i++)
+            ra.ends[ra.order[i]] = spasm_x86_64_regalloc_extend(&ra, ra.starts[ra.order[i]], ra.ends[ra.order[i]]);
+
+        for(size_t file = 0; file < 2; file++)
+            for(size_t code = 0; code < 16; code++)
+                spasm_x86_64_regalloc_extend_fixed(&ra, &ra.tracks[file][code].ranges);
+    }
+
+    spasm_x86_64_regalloc_linear_scan(&ra);
+
+    uint32_t num_spilled = 0;
+    const uint32_t spill_size = spasm_x86_64_regalloc_assign_slots(&ra, &num_spilled);
+
+    /* Rewrite in a new stream, spill code only grows it where spilled operands are */
+    SpasmVector rewritten;
+
+    if(!spasm_vector_init(&rewritten, ra.num_instructions, sizeof(SpasmInstruction), ra.allocator))
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        spasm_x86_64_regalloc_release(&ra);
+        return false;
+    }
+
+    size_t num_spill_instructions = 0;
+
+    for(uint32_t i = 0; i < ra.num_instructions; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(spasm_mnemonic_is_pseudo(instr->mnemonic) || !spasm_x86_64_regalloc_has_virtual(instr))
+        {
+            if(spasm_vector_push_back(&rewritten, instr) == NULL)
+                goto out_of_memory;
+
+            continue;
+        }
+
+        SpasmInstruction new_instr;
+        Spasm_x86_64_SpillCode code;
+
+        if(!spasm_x86_64_regalloc_rewrite(&ra, instr, &new_instr, &code))
+        {
+            spasm_x86_64_report_instruction_error(ctx, SpasmErrorCode_TooManySpills, instr);
+            spasm_vector_release(&rewritten);
+            spasm_x86_64_regalloc_release(&ra);
+            return false;
+        }
+
+        if((code.num_before > 0 && spasm_vector_push_back_n(&rewritten, code.before, code.num_before) == NULL) ||
+           spasm_vector_push_back(&rewritten, &new_instr) == NULL ||
+           (code.num_after > 0 && spasm_vector_push_back_n(&rewritten, code.after, code.num_after) == NULL))
+            goto out_of_memory;
+
+        num_spill_instructions += code.num_before + code.num_after;
+    }
+
+    spasm_vector_release(&instructions->instructions);
+    instructions->instructions = rewritten;
+
+    SPASM_CONTEXT_STAT_ADD(instructions->ctx, num_instructions_pushed, num_spill_instructions);
+
+    if(stats != NULL)
+    {
+        stats->num_virtual_registers = ra.num_used;
+        stats->num_spilled = num_spilled;
+        stats->spill_size = spill_size;
+        stats->num_spill_instructions = num_spill_instructions;
+    }
+
+    spasm_x86_64_regalloc_release(&ra);
+
+    return true;
+
+out_of_memory:
+    spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+    spasm_vector_release(&rewritten);
+    spasm_x86_64_regalloc_release(&ra);
+    return false;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
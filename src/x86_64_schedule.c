@@ -0,0 +1,371 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64.h"
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/common.h"
+#include "spasm/error.h"
+#include "spasm/instruction.h"
+#include "spasm/mnemonic.h"
+#include "spasm/operand.h"
+#include "spasm/register.h"
+
+#include "x86_64_internal.h"
+
+#include <string.h>
+
+#if defined(SPASM_ENABLE_X86_64)
+
+#define SPASM_X86_64_SCHEDULE_NO_EDGE -1
+
+typedef struct
+{
+    Spasm_x86_64_InstructionCost cost;
+    Spasm_x86_64_RegisterSet defs;
+    Spasm_x86_64_RegisterSet uses;
+    Spasm_x86_64_RegisterSet live_out;
+    uint32_t height; /* Longest latency path to the end of the region */
+    uint32_t earliest; /* Cycle its operands are ready, once its predecessors are issued */
+    uint32_t num_preds; /* Predecessors not issued yet */
+    bool issued;
+} Spasm_x86_64_ScheduleNode;
+
+typedef struct
+{
+    SpasmInstructions* instructions;
+    const Spasm_x86_64_UarchProfile* profile;
+    Spasm_x86_64_Uarch uarch;
+    const Spasm_x86_64_Liveness* liveness;
+
+    Spasm_x86_64_ScheduleNode nodes[SPASM_X86_64_SCHEDULE_MAX_REGION];
+    int16_t* edges; /* Latency of the edge from node i to node j at i * MAX_REGION + j */
+    uint32_t order[SPASM_X86_64_SCHEDULE_MAX_REGION];
+    SpasmInstruction buffer[SPASM_X86_64_SCHEDULE_MAX_REGION];
+    size_t start;
+    size_t size;
+} Spasm_x86_64_Scheduler;
+
+/*
+    Barriers end the runs: control flow, instructions with no form (virtual registers), and the ones
+    with effects the register sets do not show (fences, serializing instructions, mxcsr, implicit
+    memory operands, opmask and MMX registers)
+*/
+static bool spasm_x86_64_is_schedule_barrier(const SpasmInstruction* instr)
+{
+    if(spasm_mnemonic_is_pseudo(instr->mnemonic) || instr->mnemonic > SPASM_X86_64_NUM_MNEMONICS)
+        return true;
+
+    switch(instr->mnemonic)
+    {
+        case SpasmMnemonic_x86_64_CALL:
+        case SpasmMnemonic_x86_64_RET:
+        case SpasmMnemonic_x86_64_UD2:
+        case SpasmMnemonic_x86_64_SYSCALL:
+        case SpasmMnemonic_x86_64_INT:
+        case SpasmMnemonic_x86_64_CPUID:
+        case SpasmMnemonic_x86_64_LFENCE:
+        case SpasmMnemonic_x86_64_MFENCE:
+        case SpasmMnemonic_x86_64_SFENCE:
+        case SpasmMnemonic_x86_64_PAUSE:
+        case SpasmMnemonic_x86_64_RDTSC:
+        case SpasmMnemonic_x86_64_RDTSCP:
+        case SpasmMnemonic_x86_64_LDMXCSR:
+        case SpasmMnemonic_x86_64_STMXCSR:
+        case SpasmMnemonic_x86_64_VLDMXCSR:
+        case SpasmMnemonic_x86_64_VSTMXCSR:
+        case SpasmMnemonic_x86_64_VZEROUPPER:
+        case SpasmMnemonic_x86_64_VZEROALL:
+        case SpasmMnemonic_x86_64_EMMS:
+        case SpasmMnemonic_x86_64_RDRAND:
+        case SpasmMnemonic_x86_64_RDSEED:
+        case SpasmMnemonic_x86_64_CLFLUSH:
+        case SpasmMnemonic_x86_64_CLFLUSHOPT:
+        case SpasmMnemonic_x86_64_CLWB:
+        case SpasmMnemonic_x86_64_MASKMOVQ:
+        case SpasmMnemonic_x86_64_MASKMOVDQU:
+        case SpasmMnemonic_x86_64_VMASKMOVDQU:
+        case SpasmMnemonic_x86_64_XLATB:
+            return true;
+        default:
+            break;
+    }
+
+    if(spasm_x86_64_is_branch(instr->mnemonic))
+        return true;
+
+    if(spasm_x86_64_instruction_access(instr) == NULL)
+        return true;
+
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+        if(instr->operands[i].type == SpasmOperandType_Register &&
+           spasm_x86_64_register_set(instr->operands[i].reg) == 0)
+            return true;
+
+    return false;
+}
+
+/*
+    Edge latencies: a read waits for the write it reads, a write waits for the reads of the previous
+    value (same cycle), and two writes of a value read later keep their order. Stores are ordered
+    with all the memory accesses, loads can pass each other
+*/
+static void spasm_x86_64_schedule_build(Spasm_x86_64_Scheduler* scheduler)
+{
+    for(size_t i = 0; i < scheduler->size; i++)
+    {
+        Spasm_x86_64_ScheduleNode* node = &scheduler->nodes[i];
+        const SpasmInstruction* instr = spasm_instructions_at(scheduler->instructions, scheduler->start + i);
+
+        spasm_x86_64_instruction_cost(instr, scheduler->uarch, &node->cost);
+        spasm_x86_64_instruction_def_use(instr, &node->defs, &node->uses);
+
+        node->live_out = scheduler->liveness->live_out[scheduler->start + i];
+        node->num_preds = 0;
+        node->height = 0;
+    }
+
+    for(size_t j = 0; j < scheduler->size; j++)
+    {
+        const Spasm_x86_64_ScheduleNode* to = &scheduler->nodes[j];
+
+        for(size_t i = 0; i < j; i++)
+        {
+            const Spasm_x86_64_ScheduleNode* from = &scheduler->nodes[i];
+
+            int16_t latency = SPASM_X86_64_SCHEDULE_NO_EDGE;
+
+            if(from->defs & to->uses)
+                latency = from->cost.latency;
+            else if((from->defs & to->defs & to->live_out) || (from->cost.store && (to->cost.load || to->cost.store)))
+                latency = 1;
+            else if((from->uses & to->defs) || (from->cost.load && to->cost.store))
+                latency = 0;
+
+            scheduler->edges[i * SPASM_X86_64_SCHEDULE_MAX_REGION + j] = latency;
+
+            if(latency != SPASM_X86_64_SCHEDULE_NO_EDGE)
+                scheduler->nodes[j].num_preds++;
+        }
+    }
+
+    for(size_t i = scheduler->size; i-- > 0;)
+    {
+        Spasm_x86_64_ScheduleNode* node = &scheduler->nodes[i];
+
+        uint32_t height = node->cost.latency;
+
+        for(size_t j = i + 1; j < scheduler->size; j++)
+        {
+            const int16_t latency = scheduler->edges[i * SPASM_X86_64_SCHEDULE_MAX_REGION + j];
+
+            if(latency != SPASM_X86_64_SCHEDULE_NO_EDGE && (uint32_t)latency + scheduler->nodes[j].height > height)
+                height = (uint32_t)latency + scheduler->nodes[j].height;
+        }
+
+        node->height = height;
+    }
+}
+
+/*
+    Issues the region cycle by cycle and returns the cycle the last result is ready. In order, only
+    the next instruction of the original order can issue, otherwise the ready instruction with the
+    longest path to the end goes first (the earliest in the stream on ties)
+*/
+static uint32_t spasm_x86_64_schedule_simulate(Spasm_x86_64_Scheduler* scheduler, bool in_order)
+{
+    const Spasm_x86_64_UarchProfile* profile = scheduler->profile;
+
+    uint32_t num_preds[SPASM_X86_64_SCHEDULE_MAX_REGION];
+
+    for(size_t i = 0; i < scheduler->size; i++)
+    {
+        num_preds[i] = scheduler->nodes[i].num_preds;
+        scheduler->nodes[i].earliest = 0;
+        scheduler->nodes[i].issued = false;
+    }
+
+    uint32_t cycle = 0;
+    uint32_t end = 0;
+    size_t num_issued = 0;
+
+    while(num_issued < scheduler->size)
+    {
+        uint8_t ports_used = 0;
+        uint8_t loads_used = 0;
+        uint8_t stores_used = 0;
+        uint8_t issued_this_cycle = 0;
+
+        while(issued_this_cycle < profile->issue_width)
+        {
+            size_t best = SIZE_MAX;
+
+            for(size_t i = in_order ? num_issued : 0; i < scheduler->size; i++)
+            {
+                const Spasm_x86_64_ScheduleNode* node = &scheduler->nodes[i];
+
+                if(!node->issued &&
+                   num_preds[i] == 0 &&
+                   node->earliest <= cycle &&
+                   (node->cost.ports & ~ports_used) != 0 &&
+                   (!node->cost.load || loads_used < profile->num_load_ports) &&
+                   (!node->cost.store || stores_used < profile->num_store_ports) &&
+                   (best == SIZE_MAX || node->height > scheduler->nodes[best].height))
+                    best = i;
+
+                if(in_order)
+                    break;
+            }
+
+            if(best == SIZE_MAX)
+                break;
+
+            Spasm_x86_64_ScheduleNode* node = &scheduler->nodes[best];
+
+            /* Lowest free port of the class */
+            const uint8_t free_ports = node->cost.ports & ~ports_used;
+            ports_used |= free_ports & (uint8_t)-free_ports;
+
+            loads_used += node->cost.load;
+            stores_used += node->cost.store;
+
+            node->issued = true;
+            scheduler->order[num_issued++] = (uint32_t)best;
+            issued_this_cycle++;
+
+            if(cycle + node->cost.latency > end)
+                end = cycle + node->cost.latency;
+
+            for(size_t j = best + 1; j < scheduler->size; j++)
+            {
+                const int16_t latency = scheduler->edges[best * SPASM_X86_64_SCHEDULE_MAX_REGION + j];
+
+                if(latency == SPASM_X86_64_SCHEDULE_NO_EDGE)
+                    continue;
+
+                num_preds[j]--;
+
+                if(cycle + (uint32_t)latency > scheduler->nodes[j].earliest)
+                    scheduler->nodes[j].earliest = cycle + (uint32_t)latency;
+            }
+        }
+
+        cycle++;
+    }
+
+    return end;
+}
+
+static void spasm_x86_64_schedule_region(Spasm_x86_64_Scheduler* scheduler, Spasm_x86_64_ScheduleStats* stats)
+{
+    spasm_x86_64_schedule_build(scheduler);
+
+    const uint32_t cycles_before = spasm_x86_64_schedule_simulate(scheduler, true);
+    const uint32_t cycles_after = spasm_x86_64_schedule_simulate(scheduler, false);
+
+    stats->num_regions++;
+    stats->cycles_before += cycles_before;
+
+    if(cycles_after >= cycles_before)
+    {
+        stats->cycles_after += cycles_before;
+        return;
+    }
+
+    stats->cycles_after += cycles_after;
+    stats->num_reordered++;
+
+    for(size_t i = 0; i < scheduler->size; i++)
+        scheduler->buffer[i] = *spasm_instructions_at(scheduler->instructions, scheduler->start + scheduler->order[i]);
+
+    for(size_t i = 0; i < scheduler->size; i++)
+        *spasm_instructions_at(scheduler->instructions, scheduler->start + i) = scheduler->buffer[i];
+}
+
+bool spasm_x86_64_schedule(SpasmContext* ctx,
+                           SpasmInstructions* instructions,
+                           const Spasm_x86_64_ScheduleConfig* config,
+                           Spasm_x86_64_ScheduleStats* stats)
+{
+    Spasm_x86_64_ScheduleConfig default_config = { Spasm_x86_64_Uarch_Generic, SpasmABI_Invalid };
+
+    if(config == NULL)
+        config = &default_config;
+
+    const Spasm_x86_64_UarchProfile* profile = spasm_x86_64_get_uarch_profile(config->uarch);
+
+    if(profile == NULL)
+    {
+        spasm_context_report_code(ctx, SpasmErrorCode_UnsupportedUarch, NULL, 0);
+        return false;
+    }
+
+    Spasm_x86_64_Liveness liveness;
+
+    if(!spasm_x86_64_liveness(ctx, instructions, config->abi, 0, &liveness))
+        return false;
+
+    const SpasmAllocator* allocator = spasm_context_get_allocator(instructions->ctx);
+
+    const size_t edges_size = SPASM_X86_64_SCHEDULE_MAX_REGION * SPASM_X86_64_SCHEDULE_MAX_REGION * sizeof(int16_t);
+
+    Spasm_x86_64_Scheduler* scheduler = (Spasm_x86_64_Scheduler*)spasm_allocator_alloc(allocator, sizeof(Spasm_x86_64_Scheduler));
+    int16_t* edges = (int16_t*)spasm_allocator_alloc(allocator, edges_size);
+
+    if(scheduler == NULL || edges == NULL)
+    {
+        spasm_allocator_free(allocator, scheduler, sizeof(Spasm_x86_64_Scheduler));
+        spasm_allocator_free(allocator, edges, edges_size);
+        spasm_x86_64_liveness_release(&liveness);
+        spasm_context_report_code(ctx, SpasmErrorCode_OutOfMemory, NULL, 0);
+        return false;
+    }
+
+    scheduler->instructions = instructions;
+    scheduler->profile = profile;
+    scheduler->uarch = config->uarch;
+    scheduler->liveness = &liveness;
+    scheduler->edges = edges;
+
+    Spasm_x86_64_ScheduleStats region_stats;
+    memset(&region_stats, 0, sizeof(Spasm_x86_64_ScheduleStats));
+
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    size_t start = 0;
+
+    for(size_t i = 0; i <= num_instructions; i++)
+    {
+        const bool barrier = i == num_instructions ||
+                             spasm_x86_64_is_schedule_barrier(spasm_instructions_at(instructions, i));
+
+        if(!barrier && i - start < SPASM_X86_64_SCHEDULE_MAX_REGION)
+            continue;
+
+        if(i - start > 1)
+        {
+            scheduler->start = start;
+            scheduler->size = i - start;
+            spasm_x86_64_schedule_region(scheduler, &region_stats);
+        }
+
+        start = barrier ? i + 1 : i;
+    }
+
+    spasm_allocator_free(allocator, scheduler, sizeof(Spasm_x86_64_Scheduler));
+    spasm_allocator_free(allocator, edges, edges_size);
+    spasm_x86_64_liveness_release(&liveness);
+
+    if(stats != NULL)
+    {
+        stats->num_regions += region_stats.num_regions;
+        stats->num_reordered += region_stats.num_reordered;
+        stats->cycles_before += region_stats.cycles_before;
+        stats->cycles_after += region_stats.cycles_after;
+    }
+
+    return true;
+}
+
+#endif /* defined(SPASM_ENABLE_X86_64) */
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/abi.h"
+
+/* Argument registers tables of the calling conventions, in the order the arguments are placed */
+
+void test_abi_linux_x64(void)
+{
+    const SpasmRegister expected_gp[6] = {
+        SpasmRegister_x86_64_RDI,
+        SpasmRegister_x86_64_RSI,
+        SpasmRegister_x86_64_RDX,
+        SpasmRegister_x86_64_RCX,
+        SpasmRegister_x86_64_R8,
+        SpasmRegister_x86_64_R9,
+    };
+
+    size_t num_gp;
+    const SpasmRegister* gp = get_call_args_gp_registers(SpasmABI_LinuxX64, &num_gp);
+
+    SPASM_ASSERT(num_gp == 6, "invalid number of gp argument registers");
+    SPASM_ASSERT(get_call_max_args_gp_registers(SpasmABI_LinuxX64) == num_gp, "invalid max gp arguments");
+
+    for(size_t i = 0; i < num_gp; i++)
+        SPASM_ASSERT(gp[i] == expected_gp[i], "invalid gp argument register order");
+
+    size_t num_fp;
+    const SpasmRegister* fp = get_call_args_fp_registers(SpasmABI_LinuxX64, &num_fp);
+
+    SPASM_ASSERT(num_fp == 8, "invalid number of fp argument registers");
+    SPASM_ASSERT(get_call_max_args_fp_registers(SpasmABI_LinuxX64) == num_fp, "invalid max fp arguments");
+
+    for(size_t i = 0; i < num_fp; i++)
+        SPASM_ASSERT(fp[i] == SpasmRegister_x86_64_XMM0 + i, "invalid fp argument register order");
+
+    SPASM_ASSERT(get_call_return_value_gp_register(SpasmABI_LinuxX64) == SpasmRegister_x86_64_RAX,
+                 "invalid gp return register");
+    SPASM_ASSERT(get_call_return_value_fp_register(SpasmABI_LinuxX64) == SpasmRegister_x86_64_XMM0,
+                 "invalid fp return register");
+
+    SPASM_UNUSED(expected_gp);
+    SPASM_UNUSED(gp);
+    SPASM_UNUSED(fp);
+}
+
+void test_abi_windows_x64(void)
+{
+    const SpasmRegister expected_gp[4] = {
+        SpasmRegister_x86_64_RCX,
+        SpasmRegister_x86_64_RDX,
+        SpasmRegister_x86_64_R8,
+        SpasmRegister_x86_64_R9,
+    };
+
+    size_t num_gp;
+    const SpasmRegister* gp = get_call_args_gp_registers(SpasmABI_WindowsX64, &num_gp);
+
+    SPASM_ASSERT(num_gp == 4, "invalid number of gp argument registers");
+    SPASM_ASSERT(get_call_max_args_gp_registers(SpasmABI_WindowsX64) == num_gp, "invalid max gp arguments");
+
+    for(size_t i = 0; i < num_gp; i++)
+        SPASM_ASSERT(gp[i] == expected_gp[i], "invalid gp argument register order");
+
+    /* The four argument slots are shared, the n-th argument goes in XMMn when it is a float */
+    size_t num_fp;
+    const SpasmRegister* fp = get_call_args_fp_registers(SpasmABI_WindowsX64, &num_fp);
+
+    SPASM_ASSERT(get_call_max_args_fp_registers(SpasmABI_WindowsX64) == 4, "invalid max fp arguments");
+    SPASM_ASSERT(num_fp >= 4, "invalid number of fp argument registers");
+
+    for(size_t i = 0; i < 4; i++)
+        SPASM_ASSERT(fp[i] == SpasmRegister_x86_64_XMM0 + i, "invalid fp argument register order");
+
+    SPASM_UNUSED(expected_gp);
+    SPASM_UNUSED(gp);
+    SPASM_UNUSED(num_fp);
+    SPASM_UNUSED(fp);
+}
+
+int main(void)
+{
+    test_abi_linux_x64();
+    test_abi_windows_x64();
+
+    return 0;
+}
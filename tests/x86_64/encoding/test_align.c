@@ -0,0 +1,389 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+static bool bytecode_equals(SpasmByteCode* bytecode, const uint8_t* expected, size_t expected_size)
+{
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(bytecode, &size);
+
+    if(size == expected_size && memcmp(bytes, expected, expected_size) == 0)
+        return true;
+
+    spasm_bytecode_debug(bytecode);
+
+    return false;
+}
+
+static void push_add(SpasmInstructions* instructions)
+{
+    spasm_instructions_push(instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RBX));
+}
+
+void test_align_nops(void)
+{
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    const uint8_t nop1[] = { 0x90 };
+    spasm_x86_64_encode_nops(&bytecode, 1);
+    bool res = bytecode_equals(&bytecode, nop1, sizeof(nop1));
+    SPASM_ASSERT(res, "invalid 1 byte nop");
+
+    const uint8_t nop5[] = { 0x0F, 0x1F, 0x44, 0x00, 0x00 };
+    spasm_bytecode_reset(&bytecode);
+    spasm_x86_64_encode_nops(&bytecode, 5);
+    res = bytecode_equals(&bytecode, nop5, sizeof(nop5));
+    SPASM_ASSERT(res, "invalid 5 bytes nop");
+
+    const uint8_t nop9[] = { 0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    spasm_bytecode_reset(&bytecode);
+    spasm_x86_64_encode_nops(&bytecode, 9);
+    res = bytecode_equals(&bytecode, nop9, sizeof(nop9));
+    SPASM_ASSERT(res, "invalid 9 bytes nop");
+
+    /* Longest nop, then the rest */
+    const uint8_t nop17[] = { 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00,
+                              0x66, 0x90 };
+    spasm_bytecode_reset(&bytecode);
+    spasm_x86_64_encode_nops(&bytecode, 17);
+    res = bytecode_equals(&bytecode, nop17, sizeof(nop17));
+    SPASM_ASSERT(res, "invalid 17 bytes padding");
+
+    /* Every size, with the fewest nops */
+    for(size_t size = 0; size < 100; size++)
+    {
+        spasm_bytecode_reset(&bytecode);
+        spasm_x86_64_encode_nops(&bytecode, size);
+
+        size_t bytes_size = 0;
+        const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &bytes_size);
+
+        size_t num_nops = 0;
+
+        for(size_t i = 0; i < bytes_size; i++)
+            num_nops += (size_t)(bytes[i] == 0x90 || bytes[i] == 0x1F);
+
+        res = bytes_size == size;
+        SPASM_ASSERT(res, "invalid padding size");
+        res = num_nops == (size + 14) / 15;
+        SPASM_ASSERT(res, "padding is not made of the fewest nops");
+    }
+
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+}
+
+void test_align_stream(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    size_t end_offsets[8];
+    size_t offsets[8];
+
+    /* Nops */
+    push_add(&instructions);
+    bool res = spasm_instructions_align(&instructions, 16, SpasmAlignPadding_Nops);
+    SPASM_ASSERT(res, "align failed");
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    const uint8_t expected_nops[] = {
+        0x48, 0x01, 0xD8,
+        0x66, 0x66, 0x66, 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xC3,
+    };
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, end_offsets);
+    SPASM_ASSERT(res, "encoding failed");
+    res = bytecode_equals(&bytecode, expected_nops, sizeof(expected_nops));
+    SPASM_ASSERT(res, "invalid nop padding");
+    res = end_offsets[0] == 3 && end_offsets[1] == 16 && end_offsets[2] == 17;
+    SPASM_ASSERT(res, "invalid end offsets");
+
+    res = spasm_x86_64_instructions_offsets(NULL, &instructions, offsets) &&
+          memcmp(offsets, end_offsets, 3 * sizeof(size_t)) == 0;
+    SPASM_ASSERT(res, "offsets do not match the encoding");
+
+    /* Alignments are relative to the start of the bytecode, not of the stream */
+    spasm_instructions_reset(&instructions);
+    spasm_bytecode_reset(&bytecode);
+
+    const SpasmByte int3[5] = { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC };
+    spasm_bytecode_push_bytes(&bytecode, int3, sizeof(int3));
+
+    spasm_instructions_align(&instructions, 8, SpasmAlignPadding_Nops);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    const uint8_t expected_base[] = { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0x0F, 0x1F, 0x00, 0xC3 };
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, end_offsets);
+    SPASM_ASSERT(res, "encoding failed");
+    res = bytecode_equals(&bytecode, expected_base, sizeof(expected_base));
+    SPASM_ASSERT(res, "invalid padding after base");
+    res = end_offsets[0] == 8 && end_offsets[1] == 9;
+    SPASM_ASSERT(res, "invalid end offsets after base");
+
+    /* Prefixes, on the instructions closest to the alignment first */
+    spasm_instructions_reset(&instructions);
+    spasm_bytecode_reset(&bytecode);
+
+    push_add(&instructions);
+    push_add(&instructions);
+    push_add(&instructions);
+    spasm_instructions_align(&instructions, 16, SpasmAlignPadding_Prefixes);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    const uint8_t expected_prefixes[] = {
+        0x48, 0x01, 0xD8,
+        0x2E, 0x2E, 0x48, 0x01, 0xD8,
+        0x2E, 0x2E, 0x2E, 0x2E, 0x2E, 0x48, 0x01, 0xD8,
+        0xC3,
+    };
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, end_offsets);
+    SPASM_ASSERT(res, "encoding failed");
+    res = bytecode_equals(&bytecode, expected_prefixes, sizeof(expected_prefixes));
+    SPASM_ASSERT(res, "invalid prefix padding");
+    res = end_offsets[0] == 3 && end_offsets[1] == 8 && end_offsets[2] == 16 && end_offsets[3] == 16;
+    SPASM_ASSERT(res, "invalid end offsets with prefixes");
+
+    res = spasm_x86_64_instructions_offsets(NULL, &instructions, offsets) &&
+          memcmp(offsets, end_offsets, 5 * sizeof(size_t)) == 0;
+    SPASM_ASSERT(res, "offsets do not match the encoding");
+
+    /* Labels stop the prefixes, the rest is padded with nops */
+    spasm_instructions_reset(&instructions);
+    spasm_bytecode_reset(&bytecode);
+
+    const SpasmLabel label = spasm_instructions_new_label(&instructions);
+
+    push_add(&instructions);
+    spasm_instructions_bind_label(&instructions, label);
+    push_add(&instructions);
+    spasm_instructions_align(&instructions, 16, SpasmAlignPadding_Prefixes);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(label));
+
+    const uint8_t expected_label[] = {
+        0x48, 0x01, 0xD8,
+        0x2E, 0x2E, 0x2E, 0x2E, 0x2E, 0x48, 0x01, 0xD8,
+        0x0F, 0x1F, 0x44, 0x00, 0x00,
+        0xEB, 0xF1,
+    };
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, NULL);
+    SPASM_ASSERT(res, "encoding failed");
+    res = bytecode_equals(&bytecode, expected_label, sizeof(expected_label));
+    SPASM_ASSERT(res, "invalid padding after label");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+/*
+ * Checks that every alignment ends on its boundary and every label branch lands on its label,
+ * from the encoded bytes
+ */
+static bool check_layout(SpasmInstructions* instructions, const SpasmByte* bytes, const size_t* end_offsets)
+{
+    size_t* label_offsets = (size_t*)malloc(instructions->num_labels * sizeof(size_t));
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Label)
+            label_offsets[instr->operands[0].label] = end_offsets[i];
+    }
+
+    bool res = true;
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions) && res; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Align)
+        {
+            res &= end_offsets[i] % (size_t)instr->operands[0].imm_value == 0;
+            continue;
+        }
+
+        if(instr->mnemonic == SpasmMnemonic_Label || instr->operands[0].type != SpasmOperandType_Label)
+            continue;
+
+        const size_t start = i > 0 ? end_offsets[i - 1] : 0;
+
+        int64_t displacement = 0;
+
+        if(end_offsets[i] - start == 2)
+        {
+            displacement = (int8_t)bytes[start + 1];
+        }
+        else
+        {
+            int32_t rel32 = 0;
+            memcpy(&rel32, bytes + end_offsets[i] - 4, sizeof(int32_t));
+            displacement = rel32;
+        }
+
+        res &= (int64_t)end_offsets[i] + displacement == (int64_t)label_offsets[instr->operands[0].label];
+    }
+
+    free(label_offsets);
+
+    return res;
+}
+
+void test_align_with_branches(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    const uint32_t num_labels = 2048;
+    const size_t num_blocks = 24000;
+
+    for(uint32_t i = 0; i < num_labels; i++)
+        spasm_instructions_new_label(&instructions);
+
+    srand(7);
+
+    uint32_t next_label = 0;
+
+    for(size_t i = 0; i < num_blocks; i++)
+    {
+        if(next_label < num_labels && (uint32_t)rand() % (num_blocks / num_labels) == 0)
+        {
+            const uint32_t alignment = 1u << (2 + (uint32_t)rand() % 5);
+
+            spasm_instructions_align(&instructions,
+                                     alignment,
+                                     rand() % 2 == 0 ? SpasmAlignPadding_Nops : SpasmAlignPadding_Prefixes);
+            spasm_instructions_bind_label(&instructions, next_label++);
+        }
+
+        const uint32_t spread = i % 8 == 0 ? num_labels : 4;
+        const uint32_t base = next_label > 2 ? next_label - 2 : 0;
+        const uint32_t target = (base + (uint32_t)rand() % spread) % num_labels;
+
+        spasm_instructions_push(&instructions,
+                                i % 2 == 0 ? SpasmMnemonic_x86_64_JNE : SpasmMnemonic_x86_64_JMP,
+                                SpasmOpLabel(target));
+
+        for(uint32_t f = (uint32_t)rand() % 6; f > 0; f--)
+            push_add(&instructions);
+
+        if(rand() % 4 == 0)
+            spasm_instructions_align(&instructions, 16, SpasmAlignPadding_Prefixes);
+    }
+
+    while(next_label < num_labels)
+        spasm_instructions_bind_label(&instructions, next_label++);
+
+    push_add(&instructions);
+
+    const size_t num_instructions = spasm_instructions_size(&instructions);
+
+    size_t* end_offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+    size_t* offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+
+    /* Parallel and sequential encodings must match */
+    SpasmByteCode parallel = spasm_bytecode_new(&ctx);
+    SpasmByteCode sequential = spasm_bytecode_new(&ctx);
+
+    spasm_context_set_max_encoding_threads(&ctx, 4);
+
+    bool res = spasm_x86_64_encode_instructions(&ctx, &instructions, &parallel, end_offsets);
+    SPASM_ASSERT(res, "encoding failed");
+
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(&parallel, &size);
+
+    res = end_offsets[num_instructions - 1] == size;
+    SPASM_ASSERT(res, "invalid code size");
+    res = check_layout(&instructions, bytes, end_offsets);
+    SPASM_ASSERT(res, "invalid layout");
+
+    res = spasm_x86_64_instructions_offsets(&ctx, &instructions, offsets) &&
+          memcmp(offsets, end_offsets, num_instructions * sizeof(size_t)) == 0;
+    SPASM_ASSERT(res, "offsets do not match the encoding");
+
+    spasm_context_set_max_encoding_threads(&ctx, 1);
+
+    res = spasm_x86_64_encode_instructions(&ctx, &instructions, &sequential, NULL);
+    SPASM_ASSERT(res, "encoding failed");
+
+    size_t sequential_size = 0;
+    const SpasmByte* sequential_bytes = spasm_bytecode_get(&sequential, &sequential_size);
+
+    res = sequential_size == size && memcmp(sequential_bytes, bytes, size) == 0;
+    SPASM_ASSERT(res, "parallel and sequential encodings differ");
+    SPASM_UNUSED(res);
+
+    free(offsets);
+    free(end_offsets);
+
+    spasm_bytecode_destroy(&sequential);
+    spasm_bytecode_destroy(&parallel);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+void test_align_errors(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    bool res = !spasm_instructions_align(&instructions, 24, SpasmAlignPadding_Nops) &&
+               ctx.last_error.code == SpasmErrorCode_InvalidAlignment;
+    SPASM_ASSERT(res, "invalid alignment not reported");
+    res = !spasm_instructions_align(&instructions, 512, SpasmAlignPadding_Nops) &&
+          spasm_instructions_size(&instructions) == 0;
+    SPASM_ASSERT(res, "invalid alignments were pushed");
+
+    /* Records appended as is are checked when encoding */
+    SpasmInstruction align;
+    memset(&align, 0, sizeof(SpasmInstruction));
+    align.mnemonic = SpasmMnemonic_Align;
+    align.num_operands = 2;
+    align.operands[0] = SpasmOpImm16(12);
+    align.operands[1] = SpasmOpImm8(SpasmAlignPadding_Nops);
+
+    push_add(&instructions);
+    spasm_instructions_align(&instructions, 16, SpasmAlignPadding_Nops);
+    spasm_instructions_append(&instructions, &align, 1);
+
+    res = !spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL) &&
+          ctx.last_error.code == SpasmErrorCode_InvalidAlignment;
+    SPASM_ASSERT(res, "invalid alignment not reported");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+int main(void)
+{
+    test_align_nops();
+    test_align_stream();
+    test_align_with_branches();
+    test_align_errors();
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define RAX SpasmRegister_x86_64_RAX
+#define RCX SpasmRegister_x86_64_RCX
+#define RDX SpasmRegister_x86_64_RDX
+#define RSI SpasmRegister_x86_64_RSI
+#define RDI SpasmRegister_x86_64_RDI
+
+#define YMM(n) (SpasmRegister_x86_64_YMM0 + (n))
+
+static bool nearly(double value, double expected)
+{
+    return value > expected - 0.25 && value < expected + 0.25;
+}
+
+/* Sum of ymm4..ymm7 in num_accumulators registers, as a counted loop */
+static void push_sum(SpasmInstructions* instructions, size_t num_accumulators)
+{
+    const SpasmLabel loop = spasm_instructions_new_label(instructions);
+
+    spasm_instructions_bind_label(instructions, loop);
+
+    for(size_t i = 0; i < 4; i++)
+        spasm_instructions_push(instructions,
+                                SpasmMnemonic_x86_64_VADDPS,
+                                SpasmOpReg(YMM(i % num_accumulators)),
+                                SpasmOpReg(YMM(i % num_accumulators)),
+                                SpasmOpReg(YMM(4 + i)));
+
+    spasm_instructions_push(instructions, SpasmMnemonic_x86_64_DEC, SpasmOpReg(RCX));
+    spasm_instructions_push(instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(loop));
+}
+
+void test_analyze_dependencies(void)
+{
+    SpasmInstructions one_accumulator = spasm_instructions_new(NULL);
+    SpasmInstructions four_accumulators = spasm_instructions_new(NULL);
+
+    push_sum(&one_accumulator, 1);
+    push_sum(&four_accumulators, 4);
+
+    const Spasm_x86_64_AnalysisConfig config = { Spasm_x86_64_Uarch_Skylake, 0 };
+    const Spasm_x86_64_UarchProfile* skylake = spasm_x86_64_get_uarch_profile(Spasm_x86_64_Uarch_Skylake);
+    const uint8_t add_latency = skylake->classes[Spasm_x86_64_CostClass_FloatAdd].latency;
+
+    Spasm_x86_64_Analysis analysis;
+
+    bool res = spasm_x86_64_analyze(NULL, &one_accumulator, &config, &analysis);
+    SPASM_ASSERT(res, "Analysis failed");
+
+    res = analysis.num_instructions == 6 &&
+          analysis.num_iterations == SPASM_X86_64_ANALYSIS_DEFAULT_ITERATIONS &&
+          analysis.bottleneck == Spasm_x86_64_Bottleneck_Dependencies &&
+          nearly(analysis.bounds[Spasm_x86_64_Bottleneck_Dependencies], 4.0 * add_latency) &&
+          nearly(analysis.cycles_per_iteration, 4.0 * add_latency);
+    SPASM_ASSERT(res, "One accumulator throughput");
+
+    /* The chain is the four adds, one turn of the recurrence */
+    res = analysis.critical_path_size == 4 &&
+          analysis.critical_path[0] == 1 &&
+          analysis.critical_path[3] == 4 &&
+          analysis.critical_path_latency == 4 * add_latency;
+    SPASM_ASSERT(res, "One accumulator critical path");
+
+    const double one_accumulator_cycles = analysis.cycles_per_iteration;
+
+    spasm_x86_64_analysis_release(&analysis);
+
+    res = spasm_x86_64_analyze(NULL, &four_accumulators, &config, &analysis);
+    SPASM_ASSERT(res, "Analysis failed");
+
+    res = nearly(analysis.bounds[Spasm_x86_64_Bottleneck_Dependencies], add_latency) &&
+          analysis.cycles_per_iteration < one_accumulator_cycles / 2.0 &&
+          analysis.critical_path_size == 1 &&
+          analysis.critical_path_latency == add_latency;
+    SPASM_ASSERT(res, "Four accumulators throughput");
+
+    spasm_x86_64_analysis_release(&analysis);
+
+    /* The accumulator of a fma from memory is read after the load, only the fma latency is carried */
+    spasm_instructions_reset(&one_accumulator);
+    spasm_instructions_push(&one_accumulator,
+                            SpasmMnemonic_x86_64_VFMADD231PS,
+                            SpasmOpReg(YMM(0)),
+                            SpasmOpReg(YMM(1)),
+                            SpasmOpMemory(RSI, RCX, 0, 4));
+    spasm_instructions_push(&one_accumulator, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RCX), SpasmOpImm8(8));
+
+    res = spasm_x86_64_analyze(NULL, &one_accumulator, &config, &analysis);
+    SPASM_ASSERT(res, "Analysis failed");
+
+    res = nearly(analysis.bounds[Spasm_x86_64_Bottleneck_Dependencies],
+                 skylake->classes[Spasm_x86_64_CostClass_FloatFma].latency) &&
+          analysis.critical_path_size == 1 &&
+          analysis.critical_path[0] == 0;
+    SPASM_ASSERT(res, "Load latency off the accumulator chain");
+    SPASM_UNUSED(res);
+
+    spasm_x86_64_analysis_release(&analysis);
+
+    spasm_instructions_destroy(&one_accumulator);
+    spasm_instructions_destroy(&four_accumulators);
+}
+
+void test_analyze_resources(void)
+{
+    const Spasm_x86_64_AnalysisConfig config = { Spasm_x86_64_Uarch_Skylake, 50 };
+
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* Independent popcnt all go to the multiplier port */
+    for(size_t i = 0; i < 6; i++)
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_POPCNT,
+                                SpasmOpReg(SpasmRegister_x86_64_R8 + i),
+                                SpasmOpReg(RSI));
+
+    Spasm_x86_64_Analysis analysis;
+
+    bool res = spasm_x86_64_analyze(NULL, &instructions, &config, &analysis);
+    SPASM_ASSERT(res, "Analysis failed");
+
+    res = analysis.num_iterations == 50 &&
+          analysis.bottleneck == Spasm_x86_64_Bottleneck_Ports &&
+          analysis.bottleneck_ports == 0x02 &&
+          nearly(analysis.bounds[Spasm_x86_64_Bottleneck_Ports], 6.0) &&
+          nearly(analysis.port_pressure[1], 6.0) &&
+          nearly(analysis.cycles_per_iteration, 6.0);
+    SPASM_ASSERT(res, "Port bottleneck");
+
+    spasm_x86_64_analysis_release(&analysis);
+    spasm_instructions_reset(&instructions);
+
+    /* Six loads per iteration on two load ports */
+    for(size_t i = 0; i < 6; i++)
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_R8 + i),
+                                SpasmOpMemory(RDI, 0, 8 * i, 0));
+
+    res = spasm_x86_64_analyze(NULL, &instructions, &config, &analysis);
+    SPASM_ASSERT(res, "Analysis failed");
+
+    res = analysis.bottleneck == Spasm_x86_64_Bottleneck_Loads &&
+          nearly(analysis.bounds[Spasm_x86_64_Bottleneck_Loads], 3.0) &&
+          analysis.cycles_per_iteration >= 3.0;
+    SPASM_ASSERT(res, "Load bottleneck");
+    SPASM_UNUSED(res);
+
+    spasm_x86_64_analysis_release(&analysis);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_analyze_errors(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    Spasm_x86_64_Analysis analysis;
+
+    /* Labels only, nothing to simulate */
+    spasm_instructions_bind_label(&instructions, spasm_instructions_new_label(&instructions));
+
+    bool res = spasm_x86_64_analyze(NULL, &instructions, NULL, &analysis) &&
+               analysis.num_instructions == 0 &&
+               analysis.total_cycles == 0;
+    SPASM_ASSERT(res, "Empty analysis");
+
+    spasm_x86_64_analysis_release(&analysis);
+
+    const Spasm_x86_64_AnalysisConfig config = { Spasm_x86_64_Uarch_COUNT, 0 };
+
+    res = !spasm_x86_64_analyze(NULL, &instructions, &config, &analysis);
+    SPASM_ASSERT(res, "Unsupported uarch");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpReg(SpasmRegister_x86_64_XMM0));
+
+    res = !spasm_x86_64_analyze(NULL, &instructions, NULL, &analysis);
+    SPASM_ASSERT(res, "Instruction with no form");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_analyze_dependencies();
+    test_analyze_resources();
+    test_analyze_errors();
+
+    return 0;
+}
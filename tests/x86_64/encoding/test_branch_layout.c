@@ -0,0 +1,334 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+static void push_filler(SpasmInstructions* instructions, uint32_t i)
+{
+    switch(i % 4)
+    {
+        case 0:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_ADD,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpReg(SpasmRegister_x86_64_RBX));
+            break;
+        case 1:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_MOV,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+            break;
+        case 2:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_MOV,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpImm64(i));
+            break;
+        default:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_VADDPS,
+                                    SpasmOpReg(SpasmRegister_x86_64_YMM0),
+                                    SpasmOpReg(SpasmRegister_x86_64_YMM1),
+                                    SpasmOpReg(SpasmRegister_x86_64_YMM2));
+            break;
+    }
+}
+
+void test_branch_layout_fused_pair(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    const SpasmLabel top = spasm_instructions_new_label(&instructions);
+
+    /* 29 bytes, the cmp/jne pair would cross the first 32 bytes boundary */
+    spasm_instructions_bind_label(&instructions, top);
+    push_filler(&instructions, 2);
+    push_filler(&instructions, 2);
+    push_filler(&instructions, 0);
+    push_filler(&instructions, 0);
+    push_filler(&instructions, 0);
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_CMP,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RBX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(top));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_BranchLayoutStats stats;
+
+    bool res = spasm_x86_64_layout_branches(NULL, &instructions, SpasmAlignPadding_Nops, &stats);
+    SPASM_ASSERT(res, "branch layout failed");
+    res = stats.num_jumps == 2 && stats.num_fused_pairs == 1;
+    SPASM_ASSERT(res, "invalid number of jumps");
+    res = stats.num_padded_sites == 1 && stats.num_padding_bytes == 3;
+    SPASM_ASSERT(res, "invalid padding");
+
+    /* The boundary record comes before the cmp, the pair stays adjacent */
+    res = spasm_instructions_at(&instructions, 6)->mnemonic == SpasmMnemonic_Boundary &&
+          spasm_instructions_at(&instructions, 7)->mnemonic == SpasmMnemonic_x86_64_CMP &&
+          spasm_instructions_at(&instructions, 8)->mnemonic == SpasmMnemonic_x86_64_JNE;
+    SPASM_ASSERT(res, "invalid boundary record position");
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, NULL);
+    SPASM_ASSERT(res, "encoding failed");
+
+    const uint8_t expected_tail[] = {
+        0x0F, 0x1F, 0x00,
+        0x48, 0x39, 0xD8,
+        0x75, 0xDB,
+    };
+
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    /* The ret crosses nothing, but its boundary record is laid out too */
+    res = size == 38;
+    SPASM_ASSERT(res, "invalid code size");
+    res = memcmp(bytes + 29, expected_tail, sizeof(expected_tail)) == 0;
+    SPASM_ASSERT(res, "invalid padding before the fused pair");
+    res = bytes[37] == 0xC3;
+    SPASM_ASSERT(res, "invalid ret");
+
+    /* Laying out again does not add anything */
+    res = spasm_x86_64_layout_branches(NULL, &instructions, SpasmAlignPadding_Nops, &stats);
+    SPASM_ASSERT(res, "branch layout failed");
+    res = stats.num_jumps == 0 && stats.num_padded_sites == 1;
+    SPASM_ASSERT(res, "jumps laid out twice");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_branch_layout_fusion_rules(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel label = spasm_instructions_new_label(&instructions);
+    spasm_instructions_bind_label(&instructions, label);
+
+    /* Memory and immediate, no fusion */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_CMP,
+                            SpasmOpMemory(SpasmRegister_x86_64_RAX, 0, 0, 1),
+                            SpasmOpImm8(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(label));
+
+    /* inc does not fuse with jo */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_INC, SpasmOpReg(SpasmRegister_x86_64_RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JO, SpasmOpLabel(label));
+
+    /* test fuses with anything */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_TEST,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JS, SpasmOpLabel(label));
+
+    /* Memory destination, no fusion */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_SUB,
+                            SpasmOpMemory(SpasmRegister_x86_64_RAX, 0, 0, 1),
+                            SpasmOpReg(SpasmRegister_x86_64_RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JE, SpasmOpLabel(label));
+
+    /* dec fuses with jne */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_DEC, SpasmOpReg(SpasmRegister_x86_64_RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(label));
+
+    Spasm_x86_64_BranchLayoutStats stats;
+
+    bool res = spasm_x86_64_layout_branches(NULL, &instructions, SpasmAlignPadding_Nops, &stats);
+    SPASM_ASSERT(res, "branch layout failed");
+    res = stats.num_jumps == 5 && stats.num_fused_pairs == 2;
+    SPASM_ASSERT(res, "invalid macro-fusion detection");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+/*
+ * Checks that no jump (with its fused instruction) crosses or ends on a boundary, that the label
+ * branches land on their labels and that the padding matches the statistics
+ */
+static bool check_layout(SpasmInstructions* instructions,
+                         const SpasmByte* bytes,
+                         const size_t* end_offsets,
+                         const Spasm_x86_64_BranchLayoutStats* stats,
+                         bool nops)
+{
+    size_t* label_offsets = (size_t*)malloc(instructions->num_labels * sizeof(size_t));
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Label)
+            label_offsets[instr->operands[0].label] = end_offsets[i];
+    }
+
+    bool res = true;
+
+    size_t num_padding_bytes = 0;
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions) && res; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+        const size_t start = i > 0 ? end_offsets[i - 1] : 0;
+
+        if(instr->mnemonic == SpasmMnemonic_Boundary)
+        {
+            const size_t covered = (size_t)instr->operands[2].imm_value;
+            const size_t size = end_offsets[i + covered] - end_offsets[i];
+
+            res &= end_offsets[i] % 32 + size < 32;
+            num_padding_bytes += end_offsets[i] - start;
+
+            continue;
+        }
+
+        if(instr->mnemonic == SpasmMnemonic_Label || instr->operands[0].type != SpasmOperandType_Label)
+            continue;
+
+        int64_t displacement = 0;
+
+        if(end_offsets[i] - start == 2)
+        {
+            displacement = (int8_t)bytes[start + 1];
+        }
+        else
+        {
+            int32_t rel32 = 0;
+            memcpy(&rel32, bytes + end_offsets[i] - 4, sizeof(int32_t));
+            displacement = rel32;
+        }
+
+        res &= (int64_t)end_offsets[i] + displacement == (int64_t)label_offsets[instr->operands[0].label];
+    }
+
+    /* With prefixes, part of the padding is in the instructions before the boundaries */
+    res &= nops ? num_padding_bytes == stats->num_padding_bytes : num_padding_bytes <= stats->num_padding_bytes;
+
+    free(label_offsets);
+
+    return res;
+}
+
+static void run_random_layout(SpasmAlignPadding padding)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    const uint32_t num_labels = 1024;
+    const size_t num_blocks = 20000;
+
+    for(uint32_t i = 0; i < num_labels; i++)
+        spasm_instructions_new_label(&instructions);
+
+    srand(11);
+
+    uint32_t next_label = 0;
+
+    for(size_t i = 0; i < num_blocks; i++)
+    {
+        if(next_label < num_labels && (uint32_t)rand() % (num_blocks / num_labels) == 0)
+            spasm_instructions_bind_label(&instructions, next_label++);
+
+        for(uint32_t f = (uint32_t)rand() % 5; f > 0; f--)
+            push_filler(&instructions, (uint32_t)rand());
+
+        const uint32_t spread = i % 8 == 0 ? num_labels : 4;
+        const uint32_t base = next_label > 2 ? next_label - 2 : 0;
+        const uint32_t target = (base + (uint32_t)rand() % spread) % num_labels;
+
+        switch(rand() % 4)
+        {
+            case 0:
+                spasm_instructions_push(&instructions,
+                                        SpasmMnemonic_x86_64_CMP,
+                                        SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                        SpasmOpImm32(i));
+                spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JL, SpasmOpLabel(target));
+                break;
+            case 1:
+                spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(target));
+                break;
+            case 2:
+                spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(SpasmRegister_x86_64_RAX));
+                break;
+            default:
+                spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_DEC, SpasmOpReg(SpasmRegister_x86_64_RCX));
+                spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(target));
+                break;
+        }
+    }
+
+    while(next_label < num_labels)
+        spasm_instructions_bind_label(&instructions, next_label++);
+
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_BranchLayoutStats stats;
+
+    bool res = spasm_x86_64_layout_branches(&ctx, &instructions, padding, &stats);
+    SPASM_ASSERT(res, "branch layout failed");
+    res = stats.num_jumps == num_blocks + 1;
+    SPASM_ASSERT(res, "invalid number of jumps");
+    res = stats.num_padded_sites > 0 && stats.num_padding_bytes >= stats.num_padded_sites;
+    SPASM_ASSERT(res, "nothing padded");
+
+    const size_t num_instructions = spasm_instructions_size(&instructions);
+
+    size_t* end_offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+    size_t* offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    res = spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, end_offsets);
+    SPASM_ASSERT(res, "encoding failed");
+
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    res = end_offsets[num_instructions - 1] == size;
+    SPASM_ASSERT(res, "invalid code size");
+    res = check_layout(&instructions, bytes, end_offsets, &stats, padding == SpasmAlignPadding_Nops);
+    SPASM_ASSERT(res, "invalid branch layout");
+
+    res = spasm_x86_64_instructions_offsets(&ctx, &instructions, offsets) &&
+          memcmp(offsets, end_offsets, num_instructions * sizeof(size_t)) == 0;
+    SPASM_ASSERT(res, "offsets do not match the encoding");
+    SPASM_UNUSED(res);
+
+    free(offsets);
+    free(end_offsets);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+void test_branch_layout_random(void)
+{
+    run_random_layout(SpasmAlignPadding_Nops);
+    run_random_layout(SpasmAlignPadding_Prefixes);
+}
+
+int main(void)
+{
+    test_branch_layout_fused_pair();
+    test_branch_layout_fusion_rules();
+    test_branch_layout_random();
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define RAX SpasmRegister_x86_64_RAX
+#define RCX SpasmRegister_x86_64_RCX
+#define RDX SpasmRegister_x86_64_RDX
+#define RBX SpasmRegister_x86_64_RBX
+#define RSP SpasmRegister_x86_64_RSP
+#define RSI SpasmRegister_x86_64_RSI
+#define RDI SpasmRegister_x86_64_RDI
+#define R8 SpasmRegister_x86_64_R8
+#define R9 SpasmRegister_x86_64_R9
+#define R10 SpasmRegister_x86_64_R10
+#define R11 SpasmRegister_x86_64_R11
+
+#define XMM(n) (SpasmRegister_x86_64_XMM0 + (n))
+
+#define INT(operand) { operand, Spasm_x86_64_CallArgType_Int }
+#define FLOAT(operand) { operand, Spasm_x86_64_CallArgType_Float }
+#define DOUBLE(operand) { operand, Spasm_x86_64_CallArgType_Double }
+
+static bool encodes_like(SpasmInstructions* instructions, SpasmInstructions* expected)
+{
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+    SpasmByteCode expected_bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_encode_instructions(NULL, instructions, &bytecode, NULL) &&
+               spasm_x86_64_encode_instructions(NULL, expected, &expected_bytecode, NULL);
+
+    size_t size;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    size_t expected_size;
+    const SpasmByte* expected_bytes = spasm_bytecode_get(&expected_bytecode, &expected_size);
+
+    res = res && size == expected_size && memcmp(bytes, expected_bytes, size) == 0;
+
+    if(!res)
+    {
+        spasm_bytecode_debug(&bytecode);
+        spasm_bytecode_debug(&expected_bytecode);
+    }
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_bytecode_destroy(&expected_bytecode);
+
+    return res;
+}
+
+void test_call_system_v(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    /* Swapped arguments: a cycle of two registers, broken through a scratch register */
+    const Spasm_x86_64_CallArg swapped[] = { INT(SpasmOpReg(RSI)), INT(SpasmOpReg(RDI)) };
+
+    bool res = spasm_x86_64_emit_call(NULL, &instructions, SpasmABI_LinuxX64, SpasmOpReg(R11), swapped, 2, NULL);
+    SPASM_ASSERT(res, "Call lowering failed");
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(R10), SpasmOpReg(RDI));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDI), SpasmOpReg(RSI));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RSI), SpasmOpReg(R10));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "Swapped arguments");
+
+    /* A chain needs no scratch register, arguments in place are not moved */
+    spasm_instructions_reset(&instructions);
+    spasm_instructions_reset(&expected);
+
+    const Spasm_x86_64_CallArg chain[] = {
+        INT(SpasmOpReg(RSI)),
+        INT(SpasmOpReg(RDX)),
+        INT(SpasmOpImm8(7)),
+        INT(SpasmOpReg(RCX)),
+        DOUBLE(SpasmOpReg(XMM(1))),
+        FLOAT(SpasmOpReg(SpasmRegister_x86_64_YMM1)),
+    };
+    const Spasm_x86_64_CallArg result = DOUBLE(SpasmOpReg(XMM(3)));
+
+    res = spasm_x86_64_emit_call(NULL, &instructions, SpasmABI_LinuxX64, SpasmOpReg(RAX), chain, 6, &result);
+    SPASM_ASSERT(res, "Call lowering failed");
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDI), SpasmOpReg(RSI));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RSI), SpasmOpReg(RDX));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_EDX), SpasmOpImm32(7));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOVAPS, SpasmOpReg(XMM(0)), SpasmOpReg(XMM(1)));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_CALL, SpasmOpReg(RAX));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOVAPS, SpasmOpReg(XMM(3)), SpasmOpReg(XMM(0)));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "Chained arguments");
+
+    /* Seven integers: the last one goes to the stack, with RSP kept aligned to 16 */
+    spasm_instructions_reset(&instructions);
+    spasm_instructions_reset(&expected);
+
+    const Spasm_x86_64_CallArg many[] = {
+        INT(SpasmOpImm8(0)),
+        INT(SpasmOpImm8(1)),
+        INT(SpasmOpImm8(2)),
+        INT(SpasmOpImm8(3)),
+        INT(SpasmOpImm8(4)),
+        INT(SpasmOpImm8(5)),
+        INT(SpasmOpMemory(RSP, 0, 8, 0)),
+    };
+    const Spasm_x86_64_CallArg stored_result = INT(SpasmOpMemory(RBX, 0, 16, 0));
+
+    res = spasm_x86_64_emit_call(NULL, &instructions, SpasmABI_LinuxX64, SpasmOpLabel(0), many, 7, &stored_result);
+    SPASM_ASSERT(res, "Call lowering failed");
+
+    const SpasmInstruction* first = spasm_instructions_at(&instructions, 0);
+    const SpasmInstruction* load = spasm_instructions_at(&instructions, 1);
+    const SpasmInstruction* last = spasm_instructions_at(&instructions, spasm_instructions_size(&instructions) - 1);
+
+    /* sub, the store through the scratch register, 6 moves, call, add, store of the result */
+    res = spasm_instructions_size(&instructions) == 12 &&
+          first->mnemonic == SpasmMnemonic_x86_64_SUB && first->operands[1].imm_value == 16 &&
+          load->operands[1].mem_reg == RSP && load->operands[1].mem_displacement == 24 &&
+          spasm_instructions_at(&instructions, 2)->operands[0].mem_displacement == 0 &&
+          spasm_instructions_at(&instructions, 9)->mnemonic == SpasmMnemonic_x86_64_CALL &&
+          last->mnemonic == SpasmMnemonic_x86_64_MOV && last->operands[0].mem_reg == RBX;
+    SPASM_ASSERT(res, "Stack arguments");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_call_windows(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    /* Positional slots, two stack arguments after the shadow space, target through R11 */
+    const Spasm_x86_64_CallArg args[] = {
+        INT(SpasmOpReg(RDX)),
+        DOUBLE(SpasmOpReg(XMM(1))),
+        INT(SpasmOpImm8(0)),
+        INT(SpasmOpMemory(RSP, 0, 8, 0)),
+        INT(SpasmOpReg(RCX)),
+        FLOAT(SpasmOpMemory(RAX, 0, 0, 0)),
+    };
+
+    bool res = spasm_x86_64_emit_call(NULL, &instructions, SpasmABI_WindowsX64, SpasmOpImm64(0x12345678), args, 6, NULL);
+    SPASM_ASSERT(res, "Call lowering failed");
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_SUB, SpasmOpReg(RSP), SpasmOpImm8(48));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RSP, 0, 32, 0), SpasmOpReg(RCX));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R10D), SpasmOpMemory(RAX, 0, 0, 0));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RSP, 0, 40, 0), SpasmOpReg(SpasmRegister_x86_64_R10D));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R11D), SpasmOpImm32(0x12345678));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RCX), SpasmOpReg(RDX));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_XOR, SpasmOpReg(SpasmRegister_x86_64_R8D), SpasmOpReg(SpasmRegister_x86_64_R8D));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(R9), SpasmOpMemory(RSP, 0, 56, 0));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RSP), SpasmOpImm8(48));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "Windows call");
+
+    /* Target in an argument register, moved out before it is overwritten */
+    spasm_instructions_reset(&instructions);
+
+    const Spasm_x86_64_CallArg arg = INT(SpasmOpReg(R8));
+
+    res = spasm_x86_64_emit_call(NULL, &instructions, SpasmABI_WindowsX64, SpasmOpReg(RCX), &arg, 1, NULL);
+
+    res = res &&
+          spasm_instructions_at(&instructions, 1)->operands[0].reg == R11 &&
+          spasm_instructions_at(&instructions, 1)->operands[1].reg == RCX &&
+          spasm_instructions_at(&instructions, 3)->operands[0].reg == R11;
+    SPASM_ASSERT(res, "Target in an argument register");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_call_errors(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    const Spasm_x86_64_CallArg mismatch = FLOAT(SpasmOpReg(RAX));
+
+    bool res = !spasm_x86_64_emit_call(&ctx, &instructions, SpasmABI_LinuxX64, SpasmOpReg(R11), &mismatch, 1, NULL) &&
+               spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_InvalidCallArgument;
+    SPASM_ASSERT(res, "Argument type mismatch");
+
+    const Spasm_x86_64_CallArg immediate_result = INT(SpasmOpImm8(0));
+
+    res = !spasm_x86_64_emit_call(&ctx, &instructions, SpasmABI_LinuxX64, SpasmOpReg(R11), NULL, 0, &immediate_result);
+    SPASM_ASSERT(res, "Immediate result");
+
+    res = !spasm_x86_64_emit_call(&ctx, &instructions, SpasmABI_MacOSX64, SpasmOpReg(R11), NULL, 0, NULL) &&
+          spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_UnsupportedABI;
+    SPASM_ASSERT(res, "Unsupported ABI");
+    SPASM_UNUSED(res);
+
+    SPASM_ASSERT(spasm_instructions_size(&instructions) == 0, "Failed calls should not push instructions");
+
+    spasm_context_release(&ctx);
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_call_system_v();
+    test_call_windows();
+    test_call_errors();
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/x86_64_encoder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace x64 = spasm::x86_64;
+
+/* Stub loading an address and jumping to it, encoded by the compiler */
+static constexpr x64::Instruction stub[] = {
+    { SpasmMnemonic_x86_64_MOV, x64::reg(SpasmRegister_x86_64_RAX), x64::imm64(0x1122334455667788) },
+    { SpasmMnemonic_x86_64_MOV, x64::reg(SpasmRegister_x86_64_R10), x64::mem(SpasmRegister_x86_64_RSP, SpasmRegister_x86_64_NONE, 8, 1) },
+    { SpasmMnemonic_x86_64_ADD, x64::reg(SpasmRegister_x86_64_RSP), x64::imm8(16) },
+    { SpasmMnemonic_x86_64_VADDPS, x64::reg(SpasmRegister_x86_64_YMM0), x64::reg(SpasmRegister_x86_64_YMM1), x64::reg(SpasmRegister_x86_64_YMM2) },
+    { SpasmMnemonic_x86_64_MOVSD, x64::reg(SpasmRegister_x86_64_XMM9), x64::mem(SpasmRegister_x86_64_RSP, SpasmRegister_x86_64_NONE, 8, 1) },
+    { SpasmMnemonic_x86_64_JMP, x64::reg(SpasmRegister_x86_64_RAX) },
+};
+
+static constexpr auto stub_code = x64::encode<stub>();
+
+static_assert(stub_code.size() == x64::encoded_size(stub), "invalid stub size");
+static_assert(stub_code[0] == 0x48, "the stub is not encoded at compile time");
+
+static SpasmInstruction to_runtime_instruction(const x64::Instruction& instr)
+{
+    SpasmInstruction result;
+    std::memset(&result, 0, sizeof(SpasmInstruction));
+
+    result.mnemonic = static_cast<uint16_t>(instr.mnemonic);
+    result.num_operands = instr.num_operands;
+
+    for(uint8_t i = 0; i < instr.num_operands; i++)
+    {
+        result.operands[i].type = instr.operands[i].type;
+        result.operands[i].reg = instr.operands[i].reg;
+        result.operands[i].mem_index = instr.operands[i].mem_index;
+        result.operands[i].mem_scale = instr.operands[i].mem_scale;
+        result.operands[i].mem_displacement = instr.operands[i].mem_displacement;
+        result.operands[i].imm_value = instr.operands[i].imm_value;
+    }
+
+    return result;
+}
+
+/* Returns false if the runtime encoder disagrees (bytes or success) */
+static bool compare_with_runtime(const x64::Instruction& instr, const uint8_t* bytes, size_t size, bool ok)
+{
+    SpasmInstruction runtime_instr = to_runtime_instruction(instr);
+
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    const bool runtime_ok = spasm_x86_64_try_encode_instruction(NULL,
+                                                                &runtime_instr,
+                                                                &bytecode,
+                                                                NULL) == SpasmErrorCode_None;
+
+    size_t runtime_size = 0;
+    const SpasmByte* runtime_bytes = spasm_bytecode_get(&bytecode, &runtime_size);
+
+    bool res = runtime_ok == ok;
+
+    if(res && ok)
+        res = runtime_size == size && std::memcmp(runtime_bytes, bytes, size) == 0;
+
+    if(!res)
+    {
+        std::fprintf(stderr, "Mismatch encoding %s:\n", spasm_mnemonic_as_string(instr.mnemonic));
+        spasm_bytecode_debug(&bytecode);
+    }
+
+    spasm_bytecode_destroy(&bytecode);
+
+    return res;
+}
+
+void test_constexpr_stub(void)
+{
+    size_t offset = 0;
+
+    bool res = true;
+
+    for(const x64::Instruction& instr : stub)
+    {
+        const x64::EncodedInstruction encoded = x64::encode_instruction(instr);
+
+        res &= compare_with_runtime(instr, stub_code.data() + offset, encoded.size, true);
+
+        offset += encoded.size;
+    }
+
+    res &= offset == stub_code.size();
+
+    SPASM_ASSERT(res, "the constexpr stub does not match the runtime encoder");
+    SPASM_UNUSED(res);
+}
+
+/* 16 bits register sources stored to memory, 66 prefixed like the runtime encoder does */
+static constexpr x64::Instruction memory_operand_size_16[] = {
+    { SpasmMnemonic_x86_64_ADC, x64::mem(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_RSI, 0x10, 4), x64::reg(SpasmRegister_x86_64_DX) },
+    { SpasmMnemonic_x86_64_XCHG, x64::mem(SpasmRegister_x86_64_R8, SpasmRegister_x86_64_NONE, 0, 1), x64::reg(SpasmRegister_x86_64_R9W) },
+};
+
+static constexpr auto memory_operand_size_16_code = x64::encode<memory_operand_size_16>();
+
+static_assert(memory_operand_size_16_code.size() == 9, "invalid 16 bits memory forms size");
+static_assert(memory_operand_size_16_code[0] == 0x66 && memory_operand_size_16_code[1] == 0x11,
+              "adc m16, r16 misses the operand size prefix");
+static_assert(memory_operand_size_16_code[5] == 0x66 && memory_operand_size_16_code[6] == 0x45,
+              "xchg m16, r16 misses the operand size prefix");
+
+void test_constexpr_memory_operand_size_16(void)
+{
+    const uint8_t expected[] = { 0x66, 0x11, 0x54, 0xB3, 0x10, 0x66, 0x45, 0x87, 0x08 };
+
+    bool res = std::memcmp(memory_operand_size_16_code.data(), expected, sizeof(expected)) == 0;
+
+    size_t offset = 0;
+
+    for(const x64::Instruction& instr : memory_operand_size_16)
+    {
+        const x64::EncodedInstruction encoded = x64::encode_instruction(instr);
+
+        res &= compare_with_runtime(instr, memory_operand_size_16_code.data() + offset, encoded.size, true);
+
+        offset += encoded.size;
+    }
+
+    SPASM_ASSERT(res, "invalid 16 bits memory forms encoding");
+    SPASM_UNUSED(res);
+}
+
+/* Operand of the kind expected by a form, varying the registers and addressing modes */
+static x64::Operand make_operand(uint8_t type, uint16_t size, size_t seed)
+{
+    struct RegisterGroup
+    {
+        SpasmRegister first;
+        uint32_t count;
+    };
+
+    static const RegisterGroup register_groups[] = {
+        { SpasmRegister_x86_64_AL, 16 },
+        { SpasmRegister_x86_64_AX, 16 },
+        { SpasmRegister_x86_64_EAX, 16 },
+        { SpasmRegister_x86_64_RAX, 16 },
+        { SpasmRegister_x86_64_XMM0, 16 },
+        { SpasmRegister_x86_64_YMM0, 16 },
+        { SpasmRegister_x86_64_ZMM0, 16 },
+        { SpasmRegister_x86_64_K0, 8 },
+    };
+
+    static const int32_t displacements[] = { 0, 16, -8, 4096 };
+    static const uint8_t scales[] = { 1, 2, 4, 8 };
+
+    switch(type)
+    {
+        case SpasmOperandType_Register:
+        {
+            const size_t group = size == 8 ? 0 : size == 16 ? 1 : size == 32 ? 2 : size == 64 ? 3 :
+                                 size == 128 ? 4 : size == 256 ? 5 : size == 512 ? 6 : 7;
+
+            return x64::reg(static_cast<SpasmRegister>(register_groups[group].first +
+                                                       seed % register_groups[group].count));
+        }
+        case SpasmOperandType_Mem:
+            return x64::mem(static_cast<SpasmRegister>(SpasmRegister_x86_64_RAX + seed % 16),
+                            seed % 3 == 0 ? static_cast<SpasmRegister>(SpasmRegister_x86_64_RAX + (seed / 3) % 16) :
+                                            SpasmRegister_x86_64_NONE,
+                            displacements[seed % 4],
+                            scales[(seed / 4) % 4]);
+        default:
+            return x64::imm(static_cast<SpasmOperandType>(type),
+                            static_cast<int64_t>(0x0123456789ABCDEFull * (seed + 1)));
+    }
+}
+
+void test_constexpr_all_forms(void)
+{
+    size_t num_mismatches = 0;
+
+    for(size_t i = 0; i < x64::num_forms; i++)
+    {
+        const Spasm_x86_64_InstructionInfo& form = x64::forms[i];
+
+        for(size_t variant = 0; variant < 3; variant++)
+        {
+            x64::Instruction instr;
+            instr.mnemonic = static_cast<SpasmMnemonic>(form.mnemonic);
+
+            for(uint8_t j = 0; j < SPASM_MAX_OPERANDS && form.operand_types[j] != SpasmOperandType_None; j++)
+            {
+                instr.operands[j] = make_operand(form.operand_types[j],
+                                                 form.operand_sizes[j],
+                                                 i * 7 + variant * 5 + j * 3);
+                instr.num_operands++;
+            }
+
+            const x64::EncodedInstruction encoded = x64::encode_instruction(instr);
+
+            if(!compare_with_runtime(instr, encoded.bytes, encoded.size, encoded.ok))
+                num_mismatches++;
+        }
+    }
+
+    /* No form */
+    const x64::Instruction invalid(SpasmMnemonic_x86_64_MOV,
+                                   x64::reg(SpasmRegister_x86_64_RAX),
+                                   x64::reg(SpasmRegister_x86_64_XMM0));
+
+    const x64::EncodedInstruction encoded = x64::encode_instruction(invalid);
+
+    SPASM_ASSERT(!encoded.ok, "mov rax, xmm0 should not be encoded");
+
+    if(!compare_with_runtime(invalid, encoded.bytes, encoded.size, encoded.ok))
+        num_mismatches++;
+
+    SPASM_ASSERT(num_mismatches == 0, "the constexpr encoder does not match the runtime encoder");
+    SPASM_UNUSED(num_mismatches);
+}
+
+int main(void)
+{
+    test_constexpr_stub();
+    test_constexpr_memory_operand_size_16();
+    test_constexpr_all_forms();
+
+    return 0;
+}
@@ -0,0 +1,269 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define RAX SpasmRegister_x86_64_RAX
+#define RCX SpasmRegister_x86_64_RCX
+#define RDX SpasmRegister_x86_64_RDX
+#define RSI SpasmRegister_x86_64_RSI
+#define RDI SpasmRegister_x86_64_RDI
+#define RSP SpasmRegister_x86_64_RSP
+#define R11 SpasmRegister_x86_64_R11
+
+static bool mnemonics_are(SpasmInstructions* instructions, const uint16_t* mnemonics, size_t num_mnemonics)
+{
+    if(spasm_instructions_size(instructions) != num_mnemonics)
+        return false;
+
+    for(size_t i = 0; i < num_mnemonics; i++)
+        if(spasm_instructions_at(instructions, i)->mnemonic != mnemonics[i])
+            return false;
+
+    return true;
+}
+
+void test_dead_code_registers(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* rdx chain is dead, the cmp flags are overwritten by the add, rcx feeds the result */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDX), SpasmOpReg(RSI));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RDX), SpasmOpImm8(4));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMP, SpasmOpReg(RSI), SpasmOpImm8(0));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RCX), SpasmOpReg(RDI));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpReg(RSI));
+    /* Stores and stack updates have side effects */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 8, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_PUSH, SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_POP, SpasmOpReg(RCX));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_DeadCodeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, &stats);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    const uint16_t expected[] = {
+        SpasmMnemonic_x86_64_MOV,
+        SpasmMnemonic_x86_64_MOV,
+        SpasmMnemonic_x86_64_ADD,
+        SpasmMnemonic_x86_64_MOV,
+        SpasmMnemonic_x86_64_PUSH,
+        SpasmMnemonic_x86_64_POP,
+        SpasmMnemonic_x86_64_RET,
+    };
+
+    res = mnemonics_are(&instructions, expected, 7) && stats.num_dead == 3 && stats.num_unreachable == 0;
+    SPASM_ASSERT(res, "Dead registers");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_dead_code_flags(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel done = spasm_instructions_new_label(&instructions);
+
+    /* The flags of the sub are read by the jne, the ones of the first cmp are not */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMP, SpasmOpReg(RSI), SpasmOpReg(RDI));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_SUB, SpasmOpReg(RSI), SpasmOpImm8(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(done));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpImm32(1));
+    spasm_instructions_bind_label(&instructions, done);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_DeadCodeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, &stats);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    const uint16_t expected[] = {
+        SpasmMnemonic_x86_64_SUB,
+        SpasmMnemonic_x86_64_JNE,
+        SpasmMnemonic_x86_64_MOV,
+        SpasmMnemonic_Label,
+        SpasmMnemonic_x86_64_RET,
+    };
+
+    res = mnemonics_are(&instructions, expected, 5) && stats.num_dead == 1;
+    SPASM_ASSERT(res, "Dead flags");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_dead_code_unreachable(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel skip = spasm_instructions_new_label(&instructions);
+    const SpasmLabel orphan = spasm_instructions_new_label(&instructions);
+    const SpasmLabel function = spasm_instructions_new_label(&instructions);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpLabel(function));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(skip));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 0, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpImm32(2));
+    spasm_instructions_bind_label(&instructions, orphan);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpImm32(3));
+    spasm_instructions_bind_label(&instructions, skip);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpImm32(4));
+    spasm_instructions_bind_label(&instructions, function);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpImm32(5));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_DeadCodeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, &stats);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    const uint16_t expected[] = {
+        SpasmMnemonic_x86_64_CALL,
+        SpasmMnemonic_x86_64_JMP,
+        SpasmMnemonic_Label,
+        SpasmMnemonic_Label,
+        SpasmMnemonic_x86_64_RET,
+        SpasmMnemonic_Label,
+        SpasmMnemonic_x86_64_MOV,
+        SpasmMnemonic_x86_64_RET,
+    };
+
+    res = mnemonics_are(&instructions, expected, 8) && stats.num_unreachable == 4;
+    SPASM_ASSERT(res, "Unreachable blocks");
+
+    /* The labels are still bound, the stream encodes */
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, NULL);
+    SPASM_ASSERT(res, "Encoding failed");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_dead_code_stores(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 8, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpImm8(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 8, 0), SpasmOpReg(RAX));
+    /* Read in between, or address changed: kept */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 16, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RCX), SpasmOpMemory(RSI, 0, 0, 0));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 16, 0), SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 24, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RDI), SpasmOpImm8(8));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 24, 0), SpasmOpReg(RAX));
+    /* Different size: kept */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RSI, 0, 0, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RSI, 0, 0, 0), SpasmOpReg(SpasmRegister_x86_64_EAX));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_DeadCodeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, &stats);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    res = spasm_instructions_size(&instructions) == 11 &&
+          stats.num_dead_stores == 1 &&
+          spasm_instructions_at(&instructions, 0)->mnemonic == SpasmMnemonic_x86_64_ADD;
+    SPASM_ASSERT(res, "Dead stores");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_dead_code_calls(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* rdi is an argument, r10 and rcx are clobbered by the call, r12 is callee-saved */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDI), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R10), SpasmOpImm32(2));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R12), SpasmOpImm32(3));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RCX), SpasmOpImm32(4));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_DeadCodeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_DeadCodeStats));
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, &stats);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    res = spasm_instructions_size(&instructions) == 4 &&
+          stats.num_dead == 2 &&
+          spasm_instructions_at(&instructions, 0)->operands[0].reg == RDI &&
+          spasm_instructions_at(&instructions, 1)->operands[0].reg == SpasmRegister_x86_64_R12;
+    SPASM_ASSERT(res, "Calls");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_dead_code_variadic_calls(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* al holds the number of vector arguments of variadic calls, dead unless asked for */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    bool res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, SPASM_X86_64_LIVENESS_VARIADIC_CALLS, NULL);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    res = spasm_instructions_size(&instructions) == 3;
+    SPASM_ASSERT(res, "Variadic calls");
+
+    res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_WindowsX64, SPASM_X86_64_LIVENESS_VARIADIC_CALLS, NULL);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    res = spasm_instructions_size(&instructions) == 2 &&
+          spasm_instructions_at(&instructions, 0)->mnemonic == SpasmMnemonic_x86_64_CALL;
+    SPASM_ASSERT(res, "Variadic calls on Windows");
+
+    spasm_instructions_destroy(&instructions);
+
+    instructions = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    res = spasm_x86_64_eliminate_dead_code(NULL, &instructions, SpasmABI_LinuxX64, 0, NULL);
+    SPASM_ASSERT(res, "Dead code elimination failed");
+
+    res = spasm_instructions_size(&instructions) == 2;
+    SPASM_ASSERT(res, "Non variadic calls");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_dead_code_registers();
+    test_dead_code_flags();
+    test_dead_code_unreachable();
+    test_dead_code_stores();
+    test_dead_code_calls();
+    test_dead_code_variadic_calls();
+
+    return 0;
+}
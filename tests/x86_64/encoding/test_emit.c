@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/x86_64.h"
+#include "spasm/x86_64_emit.h"
+
+static bool encode_and_compare(SpasmInstructions* a, SpasmInstructions* b)
+{
+    SpasmByteCode a_bytecode = spasm_bytecode_new(NULL);
+    SpasmByteCode b_bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_encode_instructions(NULL, a, &a_bytecode, NULL);
+    res &= spasm_x86_64_encode_instructions(NULL, b, &b_bytecode, NULL);
+
+    size_t a_size = 0;
+    size_t b_size = 0;
+
+    const SpasmByte* a_bytes = spasm_bytecode_get(&a_bytecode, &a_size);
+    const SpasmByte* b_bytes = spasm_bytecode_get(&b_bytecode, &b_size);
+
+    res &= a_size > 0 && a_size == b_size && memcmp(a_bytes, b_bytes, a_size) == 0;
+
+    spasm_bytecode_destroy(&b_bytecode);
+    spasm_bytecode_destroy(&a_bytecode);
+
+    return res;
+}
+
+void test_emit_matches_push(void)
+{
+    SpasmInstructions typed = spasm_instructions_new(NULL);
+    SpasmInstructions pushed = spasm_instructions_new(NULL);
+
+    bool res = spasm_x86_64_mov_r64_r64(&typed, SpasmRegister_x86_64_RAX, SpasmRegister_x86_64_R9);
+    res &= spasm_x86_64_mov_r64_imm32(&typed, SpasmRegister_x86_64_RCX, -1);
+    res &= spasm_x86_64_mov_r64_m(&typed,
+                                  SpasmRegister_x86_64_RDX,
+                                  SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    res &= spasm_x86_64_add_m_r32(&typed,
+                                  SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 256, 1),
+                                  SpasmRegister_x86_64_R10D);
+    res &= spasm_x86_64_add_r64_imm8(&typed, SpasmRegister_x86_64_RSP, 16);
+    res &= spasm_x86_64_movaps_xmm_xmm(&typed, SpasmRegister_x86_64_XMM1, SpasmRegister_x86_64_XMM9);
+    res &= spasm_x86_64_vaddps_ymm_ymm_ymm(&typed,
+                                           SpasmRegister_x86_64_YMM0,
+                                           SpasmRegister_x86_64_YMM1,
+                                           SpasmRegister_x86_64_YMM2);
+    res &= spasm_x86_64_syscall(&typed);
+
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_R9));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RCX),
+                            SpasmOpImm32(-1));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RDX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 256, 1),
+                            SpasmOpReg(SpasmRegister_x86_64_R10D));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RSP),
+                            SpasmOpImm8(16));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_MOVAPS,
+                            SpasmOpReg(SpasmRegister_x86_64_XMM1),
+                            SpasmOpReg(SpasmRegister_x86_64_XMM9));
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_VADDPS,
+                            SpasmOpReg(SpasmRegister_x86_64_YMM0),
+                            SpasmOpReg(SpasmRegister_x86_64_YMM1),
+                            SpasmOpReg(SpasmRegister_x86_64_YMM2));
+    spasm_instructions_pushz(&pushed, SpasmMnemonic_x86_64_SYSCALL);
+
+    SPASM_ASSERT(res, "typed builders failed");
+    SPASM_ASSERT(spasm_instructions_size(&typed) == spasm_instructions_size(&pushed),
+                 "invalid instructions count");
+
+    for(size_t i = 0; i < spasm_instructions_size(&typed); i++)
+    {
+        SPASM_ASSERT(spasm_instructions_at(&typed, i)->form != 0, "typed builder form not resolved");
+        SPASM_ASSERT(spasm_instructions_at(&pushed, i)->form == 0, "generic push form resolved");
+    }
+
+    res = encode_and_compare(&typed, &pushed);
+
+    SPASM_ASSERT(res, "typed builders and generic pushes encode differently");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&pushed);
+    spasm_instructions_destroy(&typed);
+}
+
+void test_emit_invalid_form(void)
+{
+    SpasmInstructions typed = spasm_instructions_new(NULL);
+    SpasmInstructions pushed = spasm_instructions_new(NULL);
+
+    spasm_x86_64_mov_r64_r64(&typed, SpasmRegister_x86_64_RAX, SpasmRegister_x86_64_RBX);
+    spasm_instructions_push(&pushed,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RBX));
+
+    /* A form that does not belong to the mnemonic is ignored, the operands are matched */
+    SpasmInstruction* instr = spasm_instructions_at(&typed, 0);
+    instr->mnemonic = SpasmMnemonic_x86_64_ADD;
+
+    bool res = encode_and_compare(&typed, &pushed);
+
+    instr->form = UINT16_MAX;
+
+    res &= encode_and_compare(&typed, &pushed);
+
+    SPASM_ASSERT(res, "invalid forms should fall back to matching the operands");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&pushed);
+    spasm_instructions_destroy(&typed);
+}
+
+int main(void)
+{
+    test_emit_matches_push();
+    test_emit_invalid_form();
+
+    return 0;
+}
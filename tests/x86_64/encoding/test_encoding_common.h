@@ -23,16 +23,18 @@ static void assemble_and_expect(const char* mnemonic,
     SpasmABI abi = spasm_get_current_abi();
     SpasmJitAssembler assembler = spasm_get_jit_assembler(abi);
 
-    SpasmInstructions instructions = spasm_instructions_new();
-    SpasmByteCode bytecode = spasm_bytecode_new();
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
     SpasmData data;
 
-    SPASM_ASSERT(spasm_data_init(&data), "data init failed");
+    bool res = spasm_data_init(&data, NULL);
+    SPASM_ASSERT(res, "data init failed");
 
     spasm_instructions_push_back(&instructions, mnemonic, a, b);
 
-    SPASM_ASSERT(assembler(&instructions, &bytecode, &data),
-                 "assembler failed");
+    res = assembler(&instructions, &bytecode, &data);
+    SPASM_ASSERT(res, "assembler failed");
+    SPASM_UNUSED(res);
 
     size_t sz;
     const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &sz);
@@ -63,16 +65,18 @@ static void assemble_and_expect_z(const char* mnemonic,
     SpasmABI abi = spasm_get_current_abi();
     SpasmJitAssembler assembler = spasm_get_jit_assembler(abi);
 
-    SpasmInstructions ins = spasm_instructions_new();
-    SpasmByteCode bc = spasm_bytecode_new();
+    SpasmInstructions ins = spasm_instructions_new(NULL);
+    SpasmByteCode bc = spasm_bytecode_new(NULL);
     SpasmData data;
 
-    SPASM_ASSERT(spasm_data_init(&data), "data init failed");
+    bool res = spasm_data_init(&data, NULL);
+    SPASM_ASSERT(res, "data init failed");
 
     spasm_instructions_push_backz(&ins, mnemonic);
 
-    SPASM_ASSERT(assembler(&ins, &bc, &data),
-                 "assembler failed");
+    res = assembler(&ins, &bc, &data);
+    SPASM_ASSERT(res, "assembler failed");
+    SPASM_UNUSED(res);
 
     size_t sz;
     const SpasmByte* bytes = spasm_bytecode_get(&bc, &sz);
@@ -80,6 +84,7 @@ static void assemble_and_expect_z(const char* mnemonic,
     SPASM_ASSERT(sz == expected_size, "invalid bytecode size");
     SPASM_ASSERT(memcmp(bytes, expected, expected_size) == 0,
                  "bytecode mismatch");
+    SPASM_UNUSED(bytes);
 
     spasm_data_release(&data);
     spasm_instructions_destroy(&ins);
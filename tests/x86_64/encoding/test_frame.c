@@ -0,0 +1,243 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define RBX SpasmRegister_x86_64_RBX
+#define RSI SpasmRegister_x86_64_RSI
+#define R12 SpasmRegister_x86_64_R12
+
+#define SET(reg) spasm_x86_64_register_set(reg)
+
+/* Encodes the prologue, a body and the epilogue of the frame */
+static bool encode_function(const Spasm_x86_64_Frame* frame,
+                            const SpasmInstructions* body,
+                            SpasmByteCode* bytecode,
+                            SpasmInstructions* function)
+{
+    spasm_instructions_reset(function);
+
+    return spasm_x86_64_frame_emit_prologue(frame, function) &&
+           (body == NULL || spasm_instructions_append(function,
+                                                      spasm_instructions_at(body, 0),
+                                                      spasm_instructions_size(body))) &&
+           spasm_x86_64_frame_emit_epilogue(frame, function) &&
+           spasm_x86_64_encode_instructions(NULL, function, bytecode, NULL);
+}
+
+static bool has_cfi(const Spasm_x86_64_Frame* frame,
+                    uint32_t instruction,
+                    Spasm_x86_64_CFIOp op,
+                    SpasmRegister reg,
+                    int32_t offset)
+{
+    for(uint32_t i = 0; i < frame->num_cfi; i++)
+        if(frame->cfi[i].instruction == instruction &&
+           frame->cfi[i].op == op &&
+           frame->cfi[i].reg == (uint8_t)reg &&
+           frame->cfi[i].offset == offset)
+            return true;
+
+    return false;
+}
+
+void test_frame_system_v(void)
+{
+    SpasmInstructions body = spasm_instructions_new(NULL);
+    SpasmInstructions function = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    /* Leaf function writing rbx and r12, with its locals in the red zone */
+    spasm_instructions_push(&body, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RBX), SpasmOpReg(SpasmRegister_x86_64_RDI));
+    spasm_instructions_push(&body, SpasmMnemonic_x86_64_MOV, SpasmOpReg(R12), SpasmOpReg(SpasmRegister_x86_64_RDI));
+
+    Spasm_x86_64_FrameConfig config;
+    memset(&config, 0, sizeof(Spasm_x86_64_FrameConfig));
+    config.abi = SpasmABI_LinuxX64;
+    config.locals_size = 12;
+
+    Spasm_x86_64_Frame frame;
+
+    bool res = spasm_x86_64_frame_build(NULL, &config, &body, &frame);
+    SPASM_ASSERT(res, "Frame build failed");
+
+    res = !frame.has_frame_pointer &&
+          frame.uses_red_zone &&
+          frame.saved_registers == (SET(RBX) | SET(R12)) &&
+          frame.push_size == 16 &&
+          frame.stack_size == 0 &&
+          frame.locals_offset == -24 &&
+          frame.num_prologue_instructions == 2;
+    SPASM_ASSERT(res, "Red zone frame layout");
+
+    res = frame.num_cfi == 4 &&
+          has_cfi(&frame, 0, Spasm_x86_64_CFIOp_DefCfaOffset, 0, 16) &&
+          has_cfi(&frame, 0, Spasm_x86_64_CFIOp_SaveRegister, RBX, -16) &&
+          has_cfi(&frame, 1, Spasm_x86_64_CFIOp_DefCfaOffset, 0, 24) &&
+          has_cfi(&frame, 1, Spasm_x86_64_CFIOp_SaveRegister, R12, -24);
+    SPASM_ASSERT(res, "Red zone frame CFI");
+
+    res = encode_function(&frame, NULL, &bytecode, &function);
+    SPASM_ASSERT(res, "Red zone frame encoding");
+
+    /* push rbx, push r12, pop r12, pop rbx, ret */
+    const uint8_t expected[] = { 0x53, 0x41, 0x54, 0x41, 0x5C, 0x5B, 0xC3 };
+
+    size_t size;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    res = size == sizeof(expected) && memcmp(bytes, expected, size) == 0;
+    SPASM_ASSERT(res, "Red zone frame bytes");
+
+    /* A call makes it a non-leaf: RSP is aligned to 16 before the call */
+    spasm_instructions_push(&body, SpasmMnemonic_x86_64_CALL, SpasmOpReg(SpasmRegister_x86_64_RAX));
+
+    res = spasm_x86_64_frame_build(NULL, &config, &body, &frame) &&
+          !frame.uses_red_zone &&
+          frame.locals_offset == 0 &&
+          (8 + frame.push_size + frame.stack_size) % 16 == 0 &&
+          frame.stack_size == 24 &&
+          has_cfi(&frame, 2, Spasm_x86_64_CFIOp_DefCfaOffset, 0, 48);
+    SPASM_ASSERT(res, "Non-leaf frame layout");
+
+    spasm_bytecode_destroy(&bytecode);
+    bytecode = spasm_bytecode_new(NULL);
+
+    res = encode_function(&frame, &body, &bytecode, &function);
+    SPASM_ASSERT(res, "Non-leaf frame encoding");
+
+    /* Locals aligned to 32: RSP is realigned, RBP keeps the frame */
+    config.alignment = 32;
+    config.locals_size = 64;
+
+    res = spasm_x86_64_frame_build(NULL, &config, &body, &frame) &&
+          frame.has_frame_pointer &&
+          frame.saved_registers == (SET(RBX) | SET(R12) | SET(SpasmRegister_x86_64_RBP)) &&
+          frame.locals_offset == 0 &&
+          frame.num_cfi == 5 &&
+          has_cfi(&frame, 1, Spasm_x86_64_CFIOp_DefCfaRegister, SpasmRegister_x86_64_RBP, 16) &&
+          has_cfi(&frame, 3, Spasm_x86_64_CFIOp_SaveRegister, R12, -32);
+    SPASM_ASSERT(res, "Realigned frame layout");
+
+    spasm_instructions_reset(&function);
+
+    res = spasm_x86_64_frame_emit_prologue(&frame, &function) &&
+          spasm_instructions_size(&function) == frame.num_prologue_instructions &&
+          spasm_instructions_at(&function, frame.num_prologue_instructions - 1)->mnemonic == SpasmMnemonic_x86_64_AND;
+    SPASM_ASSERT(res, "Realigned frame prologue");
+
+    spasm_bytecode_destroy(&bytecode);
+    bytecode = spasm_bytecode_new(NULL);
+
+    res = encode_function(&frame, &body, &bytecode, &function);
+    SPASM_ASSERT(res, "Realigned frame encoding");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&function);
+    spasm_instructions_destroy(&body);
+}
+
+void test_frame_windows(void)
+{
+    SpasmInstructions function = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    Spasm_x86_64_FrameConfig config;
+    memset(&config, 0, sizeof(Spasm_x86_64_FrameConfig));
+    config.abi = SpasmABI_WindowsX64;
+    config.used_registers = SET(RSI) |
+                            SET(SpasmRegister_x86_64_RAX) |
+                            SET(SpasmRegister_x86_64_XMM0) |
+                            SET(SpasmRegister_x86_64_XMM6) |
+                            SET(SpasmRegister_x86_64_YMM7);
+    config.locals_size = 40;
+    config.has_calls = true;
+
+    Spasm_x86_64_Frame frame;
+
+    bool res = spasm_x86_64_frame_build(NULL, &config, NULL, &frame);
+    SPASM_ASSERT(res, "Frame build failed");
+
+    /* Shadow space, then the locals, then the two saved vector registers */
+    res = !frame.has_frame_pointer &&
+          frame.saved_registers == (SET(RSI) | SET(SpasmRegister_x86_64_XMM6) | SET(SpasmRegister_x86_64_XMM7)) &&
+          frame.push_size == 8 &&
+          frame.stack_size == 112 &&
+          (8 + frame.push_size + frame.stack_size) % 16 == 0 &&
+          frame.locals_offset == 32 &&
+          frame.vector_save_offset == -48 &&
+          frame.num_prologue_instructions == 4;
+    SPASM_ASSERT(res, "Windows frame layout");
+
+    res = has_cfi(&frame, 0, Spasm_x86_64_CFIOp_SaveRegister, RSI, -16) &&
+          has_cfi(&frame, 1, Spasm_x86_64_CFIOp_DefCfaOffset, 0, 128) &&
+          has_cfi(&frame, 2, Spasm_x86_64_CFIOp_SaveRegister, SpasmRegister_x86_64_XMM6, -48) &&
+          has_cfi(&frame, 3, Spasm_x86_64_CFIOp_SaveRegister, SpasmRegister_x86_64_XMM7, -32);
+    SPASM_ASSERT(res, "Windows frame CFI");
+
+    res = encode_function(&frame, NULL, &bytecode, &function);
+    SPASM_ASSERT(res, "Windows frame encoding");
+
+    /* movaps xmm6, [rsp + 80] restores from the slot the prologue saved to */
+    const SpasmInstruction* restore = spasm_instructions_at(&function, frame.num_prologue_instructions);
+
+    res = restore->mnemonic == SpasmMnemonic_x86_64_MOVAPS &&
+          restore->operands[1].mem_reg == SpasmRegister_x86_64_RSP &&
+          restore->operands[1].mem_displacement == 80;
+    SPASM_ASSERT(res, "Windows frame vector restore");
+
+    /* Leaf function with nothing to save: no prologue, the epilogue is ret */
+    memset(&config, 0, sizeof(Spasm_x86_64_FrameConfig));
+    config.abi = SpasmABI_WindowsX64;
+    config.used_registers = SET(SpasmRegister_x86_64_RAX);
+
+    res = spasm_x86_64_frame_build(NULL, &config, NULL, &frame) &&
+          frame.num_prologue_instructions == 0 &&
+          frame.num_cfi == 0;
+    SPASM_ASSERT(res, "Empty frame");
+
+    spasm_instructions_reset(&function);
+
+    res = spasm_x86_64_frame_emit_prologue(&frame, &function) &&
+          spasm_x86_64_frame_emit_epilogue(&frame, &function) &&
+          spasm_instructions_size(&function) == 1;
+    SPASM_ASSERT(res, "Empty frame epilogue");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&function);
+}
+
+void test_frame_errors(void)
+{
+    Spasm_x86_64_FrameConfig config;
+    memset(&config, 0, sizeof(Spasm_x86_64_FrameConfig));
+    config.abi = SpasmABI_LinuxX64;
+    config.alignment = 24;
+
+    Spasm_x86_64_Frame frame;
+
+    bool res = !spasm_x86_64_frame_build(NULL, &config, NULL, &frame);
+    SPASM_ASSERT(res, "Invalid alignment");
+
+    config.alignment = 0;
+    config.abi = SpasmABI_MacOSX64;
+
+    res = !spasm_x86_64_frame_build(NULL, &config, NULL, &frame);
+    SPASM_ASSERT(res, "Unsupported ABI");
+    SPASM_UNUSED(res);
+}
+
+int main(void)
+{
+    test_frame_system_v();
+    test_frame_windows();
+    test_frame_errors();
+
+    return 0;
+}
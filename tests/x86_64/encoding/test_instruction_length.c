@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+typedef struct
+{
+    SpasmMnemonic mnemonic;
+    SpasmOperandType types[4];
+    uint16_t sizes[4];
+} FormOperands;
+
+#define SPASM_X86_64_FORM(mnemonic, t0, t1, t2, t3, s0, s1, s2, s3, ...) \
+    { SpasmMnemonic_x86_64_##mnemonic,                                  \
+      { SpasmOperandType_##t0, SpasmOperandType_##t1, SpasmOperandType_##t2, SpasmOperandType_##t3 }, \
+      { s0, s1, s2, s3 } },
+
+static const FormOperands forms[] = {
+#include "spasm/x86_64_forms.inc"
+};
+
+#undef SPASM_X86_64_FORM
+
+static SpasmOperand make_operand(SpasmOperandType type, uint16_t size, uint32_t seed)
+{
+    static const SpasmRegister register_groups[] = {
+        SpasmRegister_x86_64_AL,
+        SpasmRegister_x86_64_AX,
+        SpasmRegister_x86_64_EAX,
+        SpasmRegister_x86_64_RAX,
+        SpasmRegister_x86_64_XMM0,
+        SpasmRegister_x86_64_YMM0,
+        SpasmRegister_x86_64_ZMM0,
+    };
+
+    static const int32_t displacements[] = { 0, 16, -8, 4096 };
+    static const uint8_t scales[] = { 1, 2, 4, 8 };
+
+    switch(type)
+    {
+        case SpasmOperandType_Register:
+        {
+            const size_t group = size == 8 ? 0 : size == 16 ? 1 : size == 32 ? 2 : size == 64 ? 3 :
+                                 size == 128 ? 4 : size == 256 ? 5 : 6;
+
+            return SpasmOpReg(register_groups[group] + seed % 16);
+        }
+        case SpasmOperandType_Mem:
+            return SpasmOpMemory(SpasmRegister_x86_64_RAX + seed % 16,
+                                 seed % 3 == 0 ? SpasmRegister_x86_64_RAX + (seed / 3) % 16 : 0,
+                                 displacements[seed % 4],
+                                 scales[(seed / 4) % 4]);
+        default:
+        {
+            SpasmOperand operand = SpasmOpImm64((int64_t)(0x0123456789ABCDEFull * (seed + 1)));
+            operand.type = (uint8_t)type;
+
+            return operand;
+        }
+    }
+}
+
+/* The length of every form, with a few operand variants, matches what the encoder writes */
+void test_instruction_length_forms(void)
+{
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    size_t num_encoded = 0;
+
+    for(size_t i = 0; i < sizeof(forms) / sizeof(FormOperands); i++)
+    {
+        for(uint32_t seed = 0; seed < 3; seed++)
+        {
+            SpasmInstruction instr;
+            memset(&instr, 0, sizeof(SpasmInstruction));
+
+            instr.mnemonic = (uint16_t)forms[i].mnemonic;
+
+            while(instr.num_operands < 4 && forms[i].types[instr.num_operands] != SpasmOperandType_None)
+            {
+                instr.operands[instr.num_operands] = make_operand(forms[i].types[instr.num_operands],
+                                                                  forms[i].sizes[instr.num_operands],
+                                                                  seed + i);
+                instr.num_operands++;
+            }
+
+            spasm_bytecode_reset(&bytecode);
+
+            const SpasmErrorCode code = spasm_x86_64_try_encode_instruction(NULL, &instr, &bytecode, NULL);
+            const size_t length = spasm_x86_64_instruction_length(&instr);
+
+            SPASM_ASSERT(length == (code == SpasmErrorCode_None ? spasm_bytecode_size(&bytecode) : 0),
+                         "instruction length does not match the encoding");
+            SPASM_UNUSED(length);
+
+            num_encoded += (size_t)(code == SpasmErrorCode_None);
+        }
+    }
+
+    SPASM_ASSERT(num_encoded > sizeof(forms) / sizeof(FormOperands), "too few instructions encoded");
+    SPASM_UNUSED(num_encoded);
+
+    spasm_bytecode_destroy(&bytecode);
+}
+
+static bool offsets_match_encoding(SpasmInstructions* instructions)
+{
+    const size_t num_instructions = spasm_instructions_size(instructions);
+
+    size_t* offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+    size_t* encoded_offsets = (size_t*)malloc(num_instructions * sizeof(size_t));
+
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_instructions_offsets(NULL, instructions, offsets);
+    res = res && spasm_x86_64_encode_instructions(NULL, instructions, &bytecode, encoded_offsets);
+    res = res && memcmp(offsets, encoded_offsets, num_instructions * sizeof(size_t)) == 0;
+    res = res && offsets[num_instructions - 1] == spasm_bytecode_size(&bytecode);
+
+    spasm_bytecode_destroy(&bytecode);
+
+    free(encoded_offsets);
+    free(offsets);
+
+    return res;
+}
+
+void test_instruction_length_offsets(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    for(uint32_t i = 0; i < 1000; i++)
+    {
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_R10),
+                                SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, i * 8, 1));
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_VADDPS,
+                                SpasmOpReg(SpasmRegister_x86_64_YMM0),
+                                SpasmOpReg(SpasmRegister_x86_64_YMM1),
+                                SpasmOpReg(SpasmRegister_x86_64_YMM2 + i % 8));
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpImm32(i));
+    }
+
+    bool res = offsets_match_encoding(&instructions);
+    SPASM_ASSERT(res, "offsets do not match the encoding");
+
+    /* Same stream with branches to labels, the offsets are the relaxed ones */
+    SpasmLabel labels[16];
+
+    for(uint32_t i = 0; i < 16; i++)
+        labels[i] = spasm_instructions_new_label(&instructions);
+
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        spasm_instructions_bind_label(&instructions, labels[i]);
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(labels[(i * 7) % 16]));
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpReg(SpasmRegister_x86_64_RBX));
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(labels[0]));
+    }
+
+    res = offsets_match_encoding(&instructions);
+    SPASM_ASSERT(res, "relaxed offsets do not match the encoding");
+
+    /* Unknown instructions are reported */
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_XMM0));
+
+    size_t* offsets = (size_t*)malloc(spasm_instructions_size(&instructions) * sizeof(size_t));
+
+    res = !spasm_x86_64_instructions_offsets(&ctx, &instructions, offsets);
+    SPASM_ASSERT(res, "unknown instruction has a length");
+    SPASM_ASSERT(ctx.last_error.code == SpasmErrorCode_UnknownInstruction, "unknown instruction not reported");
+    SPASM_UNUSED(res);
+
+    free(offsets);
+
+    spasm_context_release(&ctx);
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_instruction_length_forms();
+    test_instruction_length_offsets();
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+
+static const SpasmMnemonic branch_mnemonics[] = {
+    SpasmMnemonic_x86_64_JMP,
+    SpasmMnemonic_x86_64_JNE,
+    SpasmMnemonic_x86_64_JE,
+    SpasmMnemonic_x86_64_JL,
+    SpasmMnemonic_x86_64_JGE,
+};
+
+static void push_filler(SpasmInstructions* instructions, uint32_t i)
+{
+    switch(i % 3)
+    {
+        case 0:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_ADD,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpReg(SpasmRegister_x86_64_RBX));
+            break;
+        case 1:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_MOV,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+            break;
+        default:
+            spasm_instructions_push(instructions,
+                                    SpasmMnemonic_x86_64_MOV,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpImm64(i));
+            break;
+    }
+}
+
+/*
+ * Decodes every label branch from the encoded bytes and checks it lands on its label, and that
+ * the rel32 form is only used when rel8 does not fit
+ */
+static bool check_branches(SpasmInstructions* instructions, const SpasmByte* bytes, const size_t* end_offsets)
+{
+    size_t* label_offsets = (size_t*)malloc(instructions->num_labels * sizeof(size_t));
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions); i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Label)
+            label_offsets[instr->operands[0].label] = end_offsets[i];
+    }
+
+    bool res = true;
+
+    for(size_t i = 0; i < spasm_instructions_size(instructions) && res; i++)
+    {
+        const SpasmInstruction* instr = spasm_instructions_at(instructions, i);
+
+        if(instr->mnemonic == SpasmMnemonic_Label || instr->operands[0].type != SpasmOperandType_Label)
+            continue;
+
+        const size_t start = i > 0 ? end_offsets[i - 1] : 0;
+        const size_t size = end_offsets[i] - start;
+
+        int64_t displacement = 0;
+
+        if(size == 2)
+        {
+            displacement = (int8_t)bytes[start + 1];
+        }
+        else
+        {
+            int32_t rel32 = 0;
+            memcpy(&rel32, bytes + end_offsets[i] - 4, sizeof(int32_t));
+            displacement = rel32;
+
+            res &= displacement < INT8_MIN || displacement > INT8_MAX;
+        }
+
+        res &= (int64_t)end_offsets[i] + displacement == (int64_t)label_offsets[instr->operands[0].label];
+    }
+
+    free(label_offsets);
+
+    return res;
+}
+
+static bool encode_and_check(SpasmContext* ctx, SpasmInstructions* instructions, SpasmByteCode* bytecode)
+{
+    size_t* end_offsets = (size_t*)malloc(spasm_instructions_size(instructions) * sizeof(size_t));
+
+    bool res = spasm_x86_64_encode_instructions(ctx, instructions, bytecode, end_offsets);
+
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(bytecode, &size);
+
+    res = res && end_offsets[spasm_instructions_size(instructions) - 1] == size;
+    res = res && check_branches(instructions, bytes, end_offsets);
+
+    free(end_offsets);
+
+    return res;
+}
+
+void test_labels_short_and_long(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    const SpasmLabel loop = spasm_instructions_new_label(&instructions);
+    const SpasmLabel done = spasm_instructions_new_label(&instructions);
+    const SpasmLabel far = spasm_instructions_new_label(&instructions);
+
+    /* loop: add rax, rbx ; jne loop ; jmp done ; jmp far ; done: (200 x add) ; far: syscall */
+    spasm_instructions_bind_label(&instructions, loop);
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RBX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(loop));
+    spasm_instructions_push_back(&instructions, "jmp", SpasmOpLabel(done));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(far));
+    spasm_instructions_bind_label(&instructions, done);
+
+    for(uint32_t i = 0; i < 200; i++)
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpReg(SpasmRegister_x86_64_RBX));
+
+    spasm_instructions_bind_label(&instructions, far);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_SYSCALL);
+
+    bool res = encode_and_check(NULL, &instructions, &bytecode);
+    SPASM_ASSERT(res, "invalid branches");
+
+    size_t size = 0;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    const SpasmByte expected[] = {
+        0x48, 0x01, 0xD8, /* add rax, rbx */
+        0x75, 0xFB, /* jne loop (-5) */
+        0xEB, 0x05, /* jmp done (+5) */
+        0xE9, 0x58, 0x02, 0x00, 0x00, /* jmp far (+600) */
+    };
+
+    res = size == sizeof(expected) + 600 + 2;
+    SPASM_ASSERT(res, "invalid code size");
+    res = memcmp(bytes, expected, sizeof(expected)) == 0;
+    SPASM_ASSERT(res, "invalid branch encoding");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+/*
+ * A chain of branches each spanning the next one and just in rel8 range: the last one is out of
+ * range, and widening it pushes the previous one out of range, and so on
+ */
+void test_labels_cascade(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    SpasmLabel labels[64];
+
+    for(uint32_t i = 0; i < 64; i++)
+        labels[i] = spasm_instructions_new_label(&instructions);
+
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JE, SpasmOpLabel(labels[i]));
+
+        if(i > 0)
+            spasm_instructions_bind_label(&instructions, labels[i - 1]);
+
+        /* 123 bytes, plus the next rel8 branch the displacement is 125 */
+        for(uint32_t j = 0; j < 41; j++)
+            spasm_instructions_push(&instructions,
+                                    SpasmMnemonic_x86_64_ADD,
+                                    SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                    SpasmOpReg(SpasmRegister_x86_64_RBX));
+    }
+
+    for(uint32_t j = 0; j < 10; j++)
+        push_filler(&instructions, 0);
+
+    spasm_instructions_bind_label(&instructions, labels[63]);
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_SYSCALL);
+
+    bool res = encode_and_check(NULL, &instructions, &bytecode);
+    SPASM_ASSERT(res, "invalid branches");
+
+    /* Every branch ends up widened */
+    res = spasm_bytecode_size(&bytecode) == 64 * (6 + 123) + 10 * 3 + 2;
+    SPASM_ASSERT(res, "invalid code size");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+/* Many branches to random labels, encoded with and without the parallel encoding */
+void test_labels_random(void)
+{
+    const uint32_t num_labels = 4096;
+    const uint32_t num_branches = 40000;
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    for(uint32_t i = 0; i < num_labels; i++)
+        spasm_instructions_new_label(&instructions);
+
+    srand(42);
+
+    uint32_t next_label = 0;
+
+    for(uint32_t i = 0; i < num_branches; i++)
+    {
+        if(next_label < num_labels && (uint32_t)rand() % (num_branches / num_labels) == 0)
+            spasm_instructions_bind_label(&instructions, next_label++);
+
+        /* Mostly near targets, some far ones */
+        const uint32_t spread = i % 8 == 0 ? num_labels : 4;
+        const uint32_t base = next_label > 2 ? next_label - 2 : 0;
+        const uint32_t target = (base + (uint32_t)rand() % spread) % num_labels;
+
+        spasm_instructions_push(&instructions,
+                                branch_mnemonics[i % (sizeof(branch_mnemonics) / sizeof(SpasmMnemonic))],
+                                SpasmOpLabel(target));
+
+        push_filler(&instructions, i);
+    }
+
+    while(next_label < num_labels)
+        spasm_instructions_bind_label(&instructions, next_label++);
+
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_SYSCALL);
+
+    SpasmByteCode parallel = spasm_bytecode_new(&ctx);
+    SpasmByteCode sequential = spasm_bytecode_new(&ctx);
+
+    spasm_context_set_max_encoding_threads(&ctx, 4);
+    bool res = encode_and_check(&ctx, &instructions, &parallel);
+    SPASM_ASSERT(res, "invalid branches");
+
+    spasm_context_set_max_encoding_threads(&ctx, 1);
+    res = encode_and_check(&ctx, &instructions, &sequential);
+    SPASM_ASSERT(res, "invalid branches");
+
+    size_t parallel_size = 0;
+    size_t sequential_size = 0;
+
+    const SpasmByte* parallel_bytes = spasm_bytecode_get(&parallel, &parallel_size);
+    const SpasmByte* sequential_bytes = spasm_bytecode_get(&sequential, &sequential_size);
+
+    res = parallel_size == sequential_size && memcmp(parallel_bytes, sequential_bytes, parallel_size) == 0;
+    SPASM_ASSERT(res, "parallel and sequential encodings differ");
+    SPASM_ASSERT(ctx.stats.num_errors == 0, "errors have been reported");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&sequential);
+    spasm_bytecode_destroy(&parallel);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+static SpasmErrorCode encode_error(SpasmInstructions* instructions)
+{
+    SpasmContext* ctx = instructions->ctx;
+    SpasmByteCode bytecode = spasm_bytecode_new(ctx);
+
+    bool res = spasm_x86_64_encode_instructions(ctx, instructions, &bytecode, NULL);
+
+    spasm_bytecode_destroy(&bytecode);
+
+    return res ? SpasmErrorCode_None : spasm_context_get_last_error(ctx)->code;
+}
+
+void test_labels_errors(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    /* Never bound */
+    SpasmLabel label = spasm_instructions_new_label(&instructions);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpLabel(label));
+
+    SpasmErrorCode code = encode_error(&instructions);
+    SPASM_ASSERT(code == SpasmErrorCode_InvalidLabel, "unbound label not reported");
+
+    /* Bound twice */
+    spasm_instructions_bind_label(&instructions, label);
+    spasm_instructions_bind_label(&instructions, label);
+
+    code = encode_error(&instructions);
+    SPASM_ASSERT(code == SpasmErrorCode_InvalidLabel, "label bound twice not reported");
+
+    /* jrcxz only has a rel8 form */
+    spasm_instructions_reset(&instructions);
+
+    label = spasm_instructions_new_label(&instructions);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JRCXZ, SpasmOpLabel(label));
+
+    for(uint32_t i = 0; i < 100; i++)
+        push_filler(&instructions, 0);
+
+    spasm_instructions_bind_label(&instructions, label);
+
+    code = encode_error(&instructions);
+    SPASM_ASSERT(code == SpasmErrorCode_BranchOutOfRange, "out of range not reported");
+
+    /* Not a branch */
+    spasm_instructions_reset(&instructions);
+
+    label = spasm_instructions_new_label(&instructions);
+    spasm_instructions_bind_label(&instructions, label);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_SYSCALL, SpasmOpLabel(label));
+
+    code = encode_error(&instructions);
+    SPASM_ASSERT(code == SpasmErrorCode_UnknownInstruction, "invalid branch not reported");
+    SPASM_UNUSED(code);
+
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+int main(void)
+{
+    test_labels_short_and_long();
+    test_labels_cascade();
+    test_labels_random();
+    test_labels_errors();
+
+    return 0;
+}
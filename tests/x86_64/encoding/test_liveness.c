@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define GP(r) spasm_x86_64_register_set(SpasmRegister_x86_64_##r)
+#define FLAGS(f) SPASM_X86_64_REGISTER_SET_FLAGS(f)
+
+#define RAX SpasmRegister_x86_64_RAX
+#define RCX SpasmRegister_x86_64_RCX
+#define RDX SpasmRegister_x86_64_RDX
+#define RBX SpasmRegister_x86_64_RBX
+#define RSI SpasmRegister_x86_64_RSI
+#define RDI SpasmRegister_x86_64_RDI
+
+static bool def_use_is(const SpasmInstruction* instr,
+                       Spasm_x86_64_RegisterSet expected_defs,
+                       Spasm_x86_64_RegisterSet expected_uses)
+{
+    Spasm_x86_64_RegisterSet defs;
+    Spasm_x86_64_RegisterSet uses;
+
+    if(!spasm_x86_64_instruction_def_use(instr, &defs, &uses))
+        return false;
+
+    return defs == expected_defs && uses == expected_uses;
+}
+
+static const SpasmInstruction* last(SpasmInstructions* instructions)
+{
+    return spasm_instructions_at(instructions, spasm_instructions_size(instructions) - 1);
+}
+
+void test_liveness_def_use(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    bool res;
+    SPASM_UNUSED(res);
+
+    const Spasm_x86_64_RegisterSet status = FLAGS(SPASM_X86_64_STATUS_FLAGS);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpMemory(RSI, RDI, 8, 4));
+    res = def_use_is(last(&instructions), GP(RAX), GP(RSI) | GP(RDI));
+    SPASM_ASSERT(res, "mov def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpReg(RCX));
+    res = def_use_is(last(&instructions), GP(RAX) | status, GP(RAX) | GP(RCX));
+    SPASM_ASSERT(res, "add def/use");
+
+    /* Partial register write keeps the upper bytes */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_AL), SpasmOpImm8(1));
+    res = def_use_is(last(&instructions), GP(RAX), GP(RAX));
+    SPASM_ASSERT(res, "mov al def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_XOR, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpReg(SpasmRegister_x86_64_EAX));
+    res = def_use_is(last(&instructions), GP(RAX) | status, 0);
+    SPASM_ASSERT(res, "zero idiom def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_DIV, SpasmOpReg(RCX));
+    res = def_use_is(last(&instructions), GP(RAX) | GP(RDX) | status, GP(RAX) | GP(RDX) | GP(RCX));
+    SPASM_ASSERT(res, "div def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMP, SpasmOpReg(RAX), SpasmOpImm32(3));
+    res = def_use_is(last(&instructions), status, GP(RAX));
+    SPASM_ASSERT(res, "cmp def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMOVE, SpasmOpReg(RAX), SpasmOpReg(RBX));
+    res = def_use_is(last(&instructions), GP(RAX), GP(RAX) | GP(RBX) | FLAGS(Spasm_x86_64_Flag_ZF));
+    SPASM_ASSERT(res, "cmove def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_PUSH, SpasmOpReg(RBX));
+    res = def_use_is(last(&instructions), GP(RSP), GP(RSP) | GP(RBX));
+    SPASM_ASSERT(res, "push def/use");
+
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_VADDPS,
+                            SpasmOpReg(SpasmRegister_x86_64_YMM1),
+                            SpasmOpReg(SpasmRegister_x86_64_YMM2),
+                            SpasmOpReg(SpasmRegister_x86_64_YMM3));
+    res = def_use_is(last(&instructions),
+                     spasm_x86_64_register_set(SpasmRegister_x86_64_XMM1),
+                     spasm_x86_64_register_set(SpasmRegister_x86_64_XMM2) | spasm_x86_64_register_set(SpasmRegister_x86_64_XMM3));
+    SPASM_ASSERT(res, "vaddps def/use");
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpReg(SpasmRegister_x86_64_XMM0));
+    res = !spasm_x86_64_instruction_def_use(last(&instructions), &(Spasm_x86_64_RegisterSet){ 0 }, &(Spasm_x86_64_RegisterSet){ 0 });
+    SPASM_ASSERT(res, "no form def/use");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+/*
+    Loop summing rcx values in rax:
+
+        xor eax, eax
+        mov ecx, 10
+    loop:
+        add rax, rcx
+        dec rcx
+        jne loop
+        mov rdx, 1      ; dead, rdx is not live at the exit
+        ret
+*/
+void test_liveness_loop(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel loop = spasm_instructions_new_label(&instructions);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_XOR, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpReg(SpasmRegister_x86_64_EAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_ECX), SpasmOpImm32(10));
+    spasm_instructions_bind_label(&instructions, loop);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_DEC, SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(loop));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDX), SpasmOpImm32(1));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_Liveness liveness;
+
+    bool res = spasm_x86_64_liveness(NULL, &instructions, SpasmABI_LinuxX64, 0, &liveness);
+    SPASM_ASSERT(res, "Liveness failed");
+
+    res = liveness.num_blocks == 3 &&
+          liveness.block_starts[0] == 0 &&
+          liveness.block_starts[1] == 2 &&
+          liveness.block_starts[2] == 6 &&
+          liveness.block_starts[3] == 8;
+    SPASM_ASSERT(res, "Blocks");
+
+    const Spasm_x86_64_RegisterSet callee_saved = GP(RBX) | GP(RBP) | GP(R12) | GP(R13) | GP(R14) | GP(R15) | GP(RSP) | FLAGS(Spasm_x86_64_Flag_DF);
+    const Spasm_x86_64_RegisterSet exit = callee_saved | GP(RAX) | spasm_x86_64_register_set(SpasmRegister_x86_64_XMM0);
+
+    /* rax and rcx live around the loop, the flags only up to the jne */
+    res = (liveness.live_out[1] & ~exit) == GP(RCX) &&
+          (liveness.live_out[4] & ~exit) == (GP(RCX) | FLAGS(Spasm_x86_64_Flag_ZF)) &&
+          (liveness.live_out[5] & ~exit) == GP(RCX) &&
+          (liveness.live_out[3] & GP(RAX)) != 0;
+    SPASM_ASSERT(res, "Loop liveness");
+
+    res = (liveness.live_out[6] & GP(RDX)) == 0 && liveness.live_out[7] == 0;
+    SPASM_ASSERT(res, "Exit liveness");
+    SPASM_UNUSED(res);
+
+    spasm_x86_64_liveness_release(&liveness);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_liveness_calls(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* Arguments are live up to the call, rax is not live before it (the call defines it) */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RBX), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDI), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(SpasmRegister_x86_64_R11));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpReg(RBX));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JMP, SpasmOpReg(RDX));
+
+    Spasm_x86_64_Liveness liveness;
+
+    bool res = spasm_x86_64_liveness(NULL, &instructions, SpasmABI_LinuxX64, 0, &liveness);
+    SPASM_ASSERT(res, "Liveness failed");
+
+    res = (liveness.live_out[1] & GP(RDI)) != 0 &&
+          (liveness.live_out[1] & GP(RAX)) == 0 &&
+          (liveness.live_out[0] & GP(RBX)) != 0 &&
+          (liveness.live_out[2] & (GP(RAX) | GP(RBX))) == (GP(RAX) | GP(RBX)) &&
+          (liveness.live_out[2] & GP(RDI)) == 0;
+    SPASM_ASSERT(res, "Call liveness");
+
+    /* Indirect jumps keep everything live */
+    res = liveness.num_blocks == 2 && (liveness.live_out[5] & GP(RCX)) != 0;
+    SPASM_ASSERT(res, "Indirect jump liveness");
+
+    spasm_x86_64_liveness_release(&liveness);
+
+    res = !spasm_x86_64_liveness(NULL, &instructions, SpasmABI_COUNT, 0, &liveness);
+    SPASM_ASSERT(res, "Unsupported ABI");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_liveness_def_use();
+    test_liveness_loop();
+    test_liveness_calls();
+
+    return 0;
+}
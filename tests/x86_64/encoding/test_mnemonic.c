@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/mnemonic.h"
+#include "spasm/x86_64.h"
+
+void test_mnemonic_lookup(void)
+{
+    SPASM_ASSERT(spasm_mnemonic_from_string("mov", 3) == SpasmMnemonic_x86_64_MOV, "invalid mov lookup");
+    SPASM_ASSERT(spasm_mnemonic_from_string("add", 3) == SpasmMnemonic_x86_64_ADD, "invalid add lookup");
+    SPASM_ASSERT(spasm_mnemonic_from_string("mo", 2) == SpasmMnemonic_Invalid, "prefix should not match");
+    SPASM_ASSERT(spasm_mnemonic_from_string("movv", 4) == SpasmMnemonic_Invalid, "invalid mnemonic matched");
+    SPASM_ASSERT(spasm_mnemonic_from_string("", 0) == SpasmMnemonic_Invalid, "empty mnemonic matched");
+
+    /* Every mnemonic round-trips through its string */
+    for(uint32_t i = SpasmMnemonic_Invalid + 1; i < SpasmMnemonic_COUNT; i++)
+    {
+        const char* name = spasm_mnemonic_as_string((SpasmMnemonic)i);
+
+        SPASM_ASSERT(spasm_mnemonic_from_string(name, strlen(name)) == (SpasmMnemonic)i,
+                     "mnemonic does not round-trip");
+        SPASM_UNUSED(name);
+    }
+}
+
+void test_mnemonic_push(void)
+{
+    SpasmInstructions by_id = spasm_instructions_new(NULL);
+    SpasmInstructions by_string = spasm_instructions_new(NULL);
+
+    SpasmByteCode by_id_bytecode = spasm_bytecode_new(NULL);
+    SpasmByteCode by_string_bytecode = spasm_bytecode_new(NULL);
+
+    spasm_instructions_push(&by_id,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpImm32(1));
+    spasm_instructions_pushz(&by_id, SpasmMnemonic_x86_64_SYSCALL);
+
+    spasm_instructions_push_back(&by_string,
+                                 "mov",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpImm32(1));
+    spasm_instructions_push_backz(&by_string, "syscall");
+
+    bool res = spasm_x86_64_encode_instructions(NULL, &by_id, &by_id_bytecode, NULL);
+    res &= spasm_x86_64_encode_instructions(NULL, &by_string, &by_string_bytecode, NULL);
+
+    size_t by_id_size = 0;
+    size_t by_string_size = 0;
+
+    const SpasmByte* by_id_bytes = spasm_bytecode_get(&by_id_bytecode, &by_id_size);
+    const SpasmByte* by_string_bytes = spasm_bytecode_get(&by_string_bytecode, &by_string_size);
+
+    SPASM_ASSERT(res, "encoding failed");
+    SPASM_ASSERT(by_id_size == 9 && by_id_size == by_string_size, "invalid bytecode size");
+    SPASM_ASSERT(memcmp(by_id_bytes, by_string_bytes, by_id_size) == 0, "bytecode mismatch");
+    SPASM_UNUSED(res);
+    SPASM_UNUSED(by_id_bytes);
+    SPASM_UNUSED(by_string_bytes);
+
+    spasm_bytecode_destroy(&by_string_bytecode);
+    spasm_bytecode_destroy(&by_id_bytecode);
+    spasm_instructions_destroy(&by_string);
+    spasm_instructions_destroy(&by_id);
+}
+
+int main(void)
+{
+    test_mnemonic_lookup();
+    test_mnemonic_push();
+
+    return 0;
+}
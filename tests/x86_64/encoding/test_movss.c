@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+/* Legacy SSE forms with a mandatory prefix (66, F3, F2), placed before REX */
+int main(void)
+{
+    /* movss xmm0, xmm1 */
+    {
+        const uint8_t expected[] = { 0xF3, 0x0F, 0x10, 0xC1 };
+
+        assemble_and_expect("movss",
+            SpasmOpVector(SpasmRegister_x86_64_XMM0),
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            expected, sizeof(expected));
+    }
+
+    /* movss xmm9, dword [rax] */
+    {
+        const uint8_t expected[] = { 0xF3, 0x44, 0x0F, 0x10, 0x08 };
+
+        assemble_and_expect("movss",
+            SpasmOpVector(SpasmRegister_x86_64_XMM9),
+            SpasmOpMemory(SpasmRegister_x86_64_RAX, SpasmRegister_x86_64_NONE, 0, 1),
+            expected, sizeof(expected));
+    }
+
+    /* movsd qword [rbx + 8], xmm0 */
+    {
+        const uint8_t expected[] = { 0xF2, 0x0F, 0x11, 0x43, 0x08 };
+
+        assemble_and_expect("movsd",
+            SpasmOpMemory(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_NONE, 8, 1),
+            SpasmOpVector(SpasmRegister_x86_64_XMM0),
+            expected, sizeof(expected));
+    }
+
+    /* addsd xmm1, xmm2 */
+    {
+        const uint8_t expected[] = { 0xF2, 0x0F, 0x58, 0xCA };
+
+        assemble_and_expect("addsd",
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            SpasmOpVector(SpasmRegister_x86_64_XMM2),
+            expected, sizeof(expected));
+    }
+
+    /* movapd xmm0, xmm1 */
+    {
+        const uint8_t expected[] = { 0x66, 0x0F, 0x28, 0xC1 };
+
+        assemble_and_expect("movapd",
+            SpasmOpVector(SpasmRegister_x86_64_XMM0),
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            expected, sizeof(expected));
+    }
+
+    /* cvtsi2sd xmm0, rax */
+    {
+        const uint8_t expected[] = { 0xF2, 0x48, 0x0F, 0x2A, 0xC0 };
+
+        assemble_and_expect("cvtsi2sd",
+            SpasmOpVector(SpasmRegister_x86_64_XMM0),
+            SpasmOpReg(SpasmRegister_x86_64_RAX),
+            expected, sizeof(expected));
+    }
+
+    /* cvtps2pd xmm0, xmm1, no prefix unlike the other packed double conversions */
+    {
+        const uint8_t expected[] = { 0x0F, 0x5A, 0xC1 };
+
+        assemble_and_expect("cvtps2pd",
+            SpasmOpVector(SpasmRegister_x86_64_XMM0),
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            expected, sizeof(expected));
+    }
+
+    /* cvttsd2si eax, xmm1 */
+    {
+        const uint8_t expected[] = { 0xF2, 0x0F, 0x2C, 0xC1 };
+
+        assemble_and_expect("cvttsd2si",
+            SpasmOpReg(SpasmRegister_x86_64_EAX),
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            expected, sizeof(expected));
+    }
+
+    /* cvtss2si rax, xmm2 */
+    {
+        const uint8_t expected[] = { 0xF3, 0x48, 0x0F, 0x2D, 0xC2 };
+
+        assemble_and_expect("cvtss2si",
+            SpasmOpReg(SpasmRegister_x86_64_RAX),
+            SpasmOpVector(SpasmRegister_x86_64_XMM2),
+            expected, sizeof(expected));
+    }
+
+    /* pmulld xmm1, xmm10 */
+    {
+        const uint8_t expected[] = { 0x66, 0x41, 0x0F, 0x38, 0x40, 0xCA };
+
+        assemble_and_expect("pmulld",
+            SpasmOpVector(SpasmRegister_x86_64_XMM1),
+            SpasmOpVector(SpasmRegister_x86_64_XMM10),
+            expected, sizeof(expected));
+    }
+
+    /* pause */
+    {
+        const uint8_t expected[] = { 0xF3, 0x90 };
+
+        assemble_and_expect_z("pause", expected, sizeof(expected));
+    }
+
+    return 0;
+}
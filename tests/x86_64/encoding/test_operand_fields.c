@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/x86_64.h"
+
+/* Placement of the operands in the opcode, ModR/M and REX fields, and the operand size prefixes */
+
+static void expect_encoding(SpasmMnemonic mnemonic,
+                            const SpasmOperand* operands,
+                            uint8_t num_operands,
+                            const uint8_t* expected,
+                            size_t expected_size)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_instructions_push_array(&instructions, mnemonic, operands, num_operands);
+    SPASM_ASSERT(res, "push failed");
+
+    res = spasm_x86_64_encode_instructions(NULL, &instructions, &bytecode, NULL);
+    SPASM_ASSERT(res, "encoding failed");
+    SPASM_UNUSED(res);
+
+    size_t size;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    if(size != expected_size || memcmp(bytes, expected, expected_size) != 0)
+    {
+        spasm_instructions_debug(&instructions, SpasmABI_LinuxX64, 1);
+        spasm_bytecode_debug(&bytecode);
+        SPASM_ASSERT(0, "bytecode mismatch");
+    }
+
+    SPASM_UNUSED(bytes);
+
+    spasm_instructions_destroy(&instructions);
+    spasm_bytecode_destroy(&bytecode);
+}
+
+#define EXPECT(mnemonic, operands, ...)                                 \
+    do                                                                  \
+    {                                                                   \
+        const uint8_t expected[] = { __VA_ARGS__ };                     \
+        expect_encoding(SpasmMnemonic_x86_64_##mnemonic,                \
+                        operands,                                       \
+                        (uint8_t)(sizeof(operands) / sizeof(SpasmOperand)), \
+                        expected,                                       \
+                        sizeof(expected));                              \
+    } while(0)
+
+#define REG(r) SpasmOpReg(SpasmRegister_x86_64_##r)
+#define XMM(r) SpasmOpVector(SpasmRegister_x86_64_##r)
+
+/* +r forms add the register to the opcode, extended by REX.B. push and pop default to 64 bits */
+void test_register_in_opcode(void)
+{
+    const SpasmOperand push_r12[] = { REG(R12) };
+    EXPECT(PUSH, push_r12, 0x41, 0x54);
+
+    const SpasmOperand pop_rbx[] = { REG(RBX) };
+    EXPECT(POP, pop_rbx, 0x5B);
+
+    const SpasmOperand bswap_r9d[] = { REG(R9D) };
+    EXPECT(BSWAP, bswap_r9d, 0x41, 0x0F, 0xC9);
+
+    const SpasmOperand mov_r10_imm64[] = { REG(R10), SpasmOpImm64(0x1122334455667788) };
+    EXPECT(MOV, mov_r10_imm64, 0x49, 0xBA, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11);
+}
+
+/* /digit forms take their register operand in ModR/M.rm */
+void test_digit(void)
+{
+    const SpasmOperand call_rax[] = { REG(RAX) };
+    EXPECT(CALL, call_rax, 0xFF, 0xD0);
+
+    const SpasmOperand shl_r10[] = { REG(R10), SpasmOpImm8(3) };
+    EXPECT(SHL, shl_r10, 0x49, 0xC1, 0xE2, 0x03);
+}
+
+/* ModR/M.rm holds the r/m operand of the form, the first one of "r/m, r" forms, the second of "r, r/m" ones */
+void test_modrm_operands(void)
+{
+    const SpasmOperand add_rax_rdx[] = { REG(RAX), REG(RDX) };
+    EXPECT(ADD, add_rax_rdx, 0x48, 0x01, 0xD0);
+
+    const SpasmOperand or_ecx_ebx[] = { REG(ECX), REG(EBX) };
+    EXPECT(OR, or_ecx_ebx, 0x09, 0xD9);
+
+    const SpasmOperand mov_r8d_eax[] = { REG(R8D), REG(EAX) };
+    EXPECT(MOV, mov_r8d_eax, 0x41, 0x89, 0xC0);
+
+    const SpasmOperand imul_rax_rcx[] = { REG(RAX), REG(RCX) };
+    EXPECT(IMUL, imul_rax_rcx, 0x48, 0x0F, 0xAF, 0xC1);
+
+    const SpasmOperand imul_r8_rcx[] = { REG(R8), REG(RCX) };
+    EXPECT(IMUL, imul_r8_rcx, 0x4C, 0x0F, 0xAF, 0xC1);
+
+    const SpasmOperand movzx_eax_r9b[] = { REG(EAX), REG(R9B) };
+    EXPECT(MOVZX, movzx_eax_r9b, 0x41, 0x0F, 0xB6, 0xC1);
+
+    const SpasmOperand cmovz_rax_r11[] = { REG(RAX), REG(R11) };
+    EXPECT(CMOVZ, cmovz_rax_r11, 0x49, 0x0F, 0x44, 0xC3);
+
+    const SpasmOperand movaps_xmm1_xmm8[] = { XMM(XMM1), XMM(XMM8) };
+    EXPECT(MOVAPS, movaps_xmm1_xmm8, 0x41, 0x0F, 0x28, 0xC8);
+
+    /* REX is needed if any operand is extended, not only the last one */
+    const SpasmOperand add_r9d_eax[] = { REG(R9D), REG(EAX) };
+    EXPECT(ADD, add_r9d_eax, 0x41, 0x01, 0xC1);
+
+    /* Register forms without a memory operand take the general purpose register in ModR/M.reg */
+    const SpasmOperand movmskps_eax_xmm1[] = { REG(EAX), XMM(XMM1) };
+    EXPECT(MOVMSKPS, movmskps_eax_xmm1, 0x0F, 0x50, 0xC1);
+
+    const SpasmOperand movmskpd_r10d_xmm9[] = { REG(R10D), XMM(XMM9) };
+    EXPECT(MOVMSKPD, movmskpd_r10d_xmm9, 0x66, 0x45, 0x0F, 0x50, 0xD1);
+}
+
+/* spl, bpl, sil and dil need a REX prefix, 16 bits forms a 66 prefix before the mandatory one */
+void test_operand_size(void)
+{
+    const SpasmOperand mov_dil_1[] = { REG(DIL), SpasmOpImm8(1) };
+    EXPECT(MOV, mov_dil_1, 0x40, 0xC6, 0xC7, 0x01);
+
+    const SpasmOperand imul_ax_cx[] = { REG(AX), REG(CX) };
+    EXPECT(IMUL, imul_ax_cx, 0x66, 0x0F, 0xAF, 0xC1);
+
+    const SpasmOperand popcnt_ax_cx[] = { REG(AX), REG(CX) };
+    EXPECT(POPCNT, popcnt_ax_cx, 0x66, 0xF3, 0x0F, 0xB8, 0xC1);
+
+    const SpasmOperand push_r9w[] = { REG(R9W) };
+    EXPECT(PUSH, push_r9w, 0x66, 0x41, 0x51);
+
+    const SpasmOperand crc32_eax_cx[] = { REG(EAX), REG(CX) };
+    EXPECT(CRC32, crc32_eax_cx, 0x66, 0xF2, 0x0F, 0x38, 0xF1, 0xC1);
+}
+
+/* Memory destination forms of a 16 bits register source get the 66 prefix too */
+void test_memory_operand_size(void)
+{
+    const SpasmOperand adc_m_dx[] = { SpasmOpMemory(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_RSI, 0x10, 4), REG(DX) };
+    EXPECT(ADC, adc_m_dx, 0x66, 0x11, 0x54, 0xB3, 0x10);
+
+    const SpasmOperand mov_m_cx[] = { SpasmOpMemory(SpasmRegister_x86_64_RAX, SpasmRegister_x86_64_NONE, 0, 1), REG(CX) };
+    EXPECT(MOV, mov_m_cx, 0x66, 0x89, 0x08);
+
+    const SpasmOperand add_m_r9w[] = { SpasmOpMemory(SpasmRegister_x86_64_R8, SpasmRegister_x86_64_NONE, 0, 1), REG(R9W) };
+    EXPECT(ADD, add_m_r9w, 0x66, 0x45, 0x01, 0x08);
+
+    const SpasmOperand bts_m_ax[] = { SpasmOpMemory(SpasmRegister_x86_64_RDI, SpasmRegister_x86_64_NONE, 0, 1), REG(AX) };
+    EXPECT(BTS, bts_m_ax, 0x66, 0x0F, 0xAB, 0x07);
+
+    /* 32 bits sources keep the default operand size */
+    const SpasmOperand adc_m_edx[] = { SpasmOpMemory(SpasmRegister_x86_64_RBX, SpasmRegister_x86_64_RSI, 0x10, 4), REG(EDX) };
+    EXPECT(ADC, adc_m_edx, 0x11, 0x54, 0xB3, 0x10);
+}
+
+int main(void)
+{
+    test_register_in_opcode();
+    test_digit();
+    test_modrm_operands();
+    test_operand_size();
+    test_memory_operand_size();
+
+    return 0;
+}
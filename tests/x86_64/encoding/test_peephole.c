@@ -0,0 +1,301 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+static bool encodes_as(SpasmInstructions* instructions, const uint8_t* expected, size_t expected_size)
+{
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_encode_instructions(NULL, instructions, &bytecode, NULL);
+
+    size_t size;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    res = res && size == expected_size && memcmp(bytes, expected, expected_size) == 0;
+
+    if(!res)
+        spasm_bytecode_debug(&bytecode);
+
+    spasm_bytecode_destroy(&bytecode);
+
+    return res;
+}
+
+void test_peephole_rules(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* mov rcx, 0 -> xor ecx, ecx, the add after it overwrites the flags */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RCX),
+                            SpasmOpImm32(0));
+
+    /* Self moves, mov eax, eax is kept (it zero-extends) */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RBX),
+                            SpasmOpReg(SpasmRegister_x86_64_RBX));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOVAPS,
+                            SpasmOpReg(SpasmRegister_x86_64_XMM3),
+                            SpasmOpReg(SpasmRegister_x86_64_XMM3));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_EAX),
+                            SpasmOpReg(SpasmRegister_x86_64_EAX));
+
+    /* add rax, 1 chain folded in a single add rax, 3 */
+    for(uint32_t i = 0; i < 3; i++)
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_ADD,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                SpasmOpImm8(1));
+
+    /* Store then reload of the same slot, the load is dropped, then forwarded to rdx */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1),
+                            SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RDX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+
+    /* lea chain folded in lea rsi, [rdi + 24] */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_LEA,
+                            SpasmOpReg(SpasmRegister_x86_64_RSI),
+                            SpasmOpMemory(SpasmRegister_x86_64_RDI, 0, 16, 1));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_LEA,
+                            SpasmOpReg(SpasmRegister_x86_64_RSI),
+                            SpasmOpMemory(SpasmRegister_x86_64_RSI, 0, 8, 1));
+
+    /* add/sub cancelling each other, then the cmp overwrites the flags */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_R8),
+                            SpasmOpImm32(1000));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_SUB,
+                            SpasmOpReg(SpasmRegister_x86_64_R8),
+                            SpasmOpImm32(1000));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_CMP,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpReg(SpasmRegister_x86_64_RDX));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_PeepholeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_PeepholeStats));
+
+    spasm_x86_64_peephole(&instructions, SPASM_X86_64_PEEPHOLE_ALL_RULES, &stats);
+
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_ZeroIdiom] == 1, "invalid zero idiom hits");
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_SelfMove] == 2, "invalid self move hits");
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_StoreLoad] == 2, "invalid store load hits");
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_AddChain] == 3, "invalid add chain hits");
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_LeaChain] == 1, "invalid lea chain hits");
+    SPASM_ASSERT(stats.num_removed == 8 && spasm_instructions_size(&instructions) == 8,
+                 "invalid number of instructions removed");
+
+    const uint8_t expected[] = {
+        0x31, 0xC9,                   /* xor ecx, ecx */
+        0x89, 0xC0,                   /* mov eax, eax */
+        0x48, 0x83, 0xC0, 0x03,       /* add rax, 3 */
+        0x48, 0x89, 0x44, 0x24, 0x08, /* mov [rsp + 8], rax */
+        0x48, 0x89, 0xC2,             /* mov rdx, rax */
+        0x48, 0x8D, 0x77, 0x18,       /* lea rsi, [rdi + 24] */
+        0x48, 0x39, 0xD0,             /* cmp rax, rdx */
+        0xC3,                         /* ret */
+    };
+
+    bool res = encodes_as(&instructions, expected, sizeof(expected));
+    SPASM_ASSERT(res, "invalid rewritten code");
+    SPASM_UNUSED(res);
+
+    /* Nothing left to rewrite */
+    memset(&stats, 0, sizeof(Spasm_x86_64_PeepholeStats));
+
+    spasm_x86_64_peephole(&instructions, SPASM_X86_64_PEEPHOLE_ALL_RULES, &stats);
+
+    SPASM_ASSERT(stats.num_removed == 0 && spasm_instructions_size(&instructions) == 8, "pass is not idempotent");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_peephole_add_chain_32(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* The chain cancels, but it clears the upper half of rax read by the cmp */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_EAX),
+                            SpasmOpImm8(5));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_SUB,
+                            SpasmOpReg(SpasmRegister_x86_64_EAX),
+                            SpasmOpImm8(5));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_CMP,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpImm8(0));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_PeepholeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_PeepholeStats));
+
+    spasm_x86_64_peephole(&instructions, SPASM_X86_64_PEEPHOLE_ALL_RULES, &stats);
+
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_AddChain] == 1, "invalid add chain hits");
+    SPASM_ASSERT(stats.num_removed == 1 && spasm_instructions_size(&instructions) == 3,
+                 "invalid number of instructions removed");
+
+    const uint8_t expected[] = {
+        0x89, 0xC0,             /* mov eax, eax */
+        0x48, 0x83, 0xF8, 0x00, /* cmp rax, 0 */
+        0xC3,                   /* ret */
+    };
+
+    bool res = encodes_as(&instructions, expected, sizeof(expected));
+    SPASM_ASSERT(res, "invalid rewritten code");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_peephole_barriers(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel loop = spasm_instructions_new_label(&instructions);
+
+    /* The flags may be read from the loop jump, the mov is kept */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RCX),
+                            SpasmOpImm32(0));
+    spasm_instructions_bind_label(&instructions, loop);
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RCX),
+                            SpasmOpImm8(1));
+
+    /* The jne reads the flags of the last add, the adds are not folded */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RCX),
+                            SpasmOpImm8(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JNE, SpasmOpLabel(loop));
+
+    /* Different widths, and rip-relative slots are not the same address at each instruction */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1),
+                            SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_EAX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpMemory(SpasmRegister_x86_64_RIP, 0, 64, 1),
+                            SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RIP, 0, 64, 1));
+
+    /* The ret may return the flags */
+    spasm_instructions_push(&instructions,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_EAX),
+                            SpasmOpImm32(0));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    const size_t num_instructions = spasm_instructions_size(&instructions);
+
+    Spasm_x86_64_PeepholeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_PeepholeStats));
+
+    spasm_x86_64_peephole(&instructions, SPASM_X86_64_PEEPHOLE_ALL_RULES, &stats);
+
+    SPASM_ASSERT(spasm_instructions_size(&instructions) == num_instructions && stats.num_removed == 0,
+                 "instructions removed across a barrier");
+
+    SPASM_UNUSED(num_instructions);
+
+    for(uint32_t r = 0; r < Spasm_x86_64_PeepholeRule_COUNT; r++)
+        SPASM_ASSERT(stats.hits[r] == 0, "rule applied across a barrier");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_peephole_toggles(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX + i),
+                                SpasmOpImm32(0));
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_MOV,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX + i),
+                                SpasmOpReg(SpasmRegister_x86_64_RAX + i));
+        spasm_instructions_push(&instructions,
+                                SpasmMnemonic_x86_64_SUB,
+                                SpasmOpReg(SpasmRegister_x86_64_RAX + i),
+                                SpasmOpImm32(i));
+    }
+
+    Spasm_x86_64_PeepholeStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_PeepholeStats));
+
+    /* Only the self moves */
+    spasm_x86_64_peephole(&instructions, 1u << Spasm_x86_64_PeepholeRule_SelfMove, &stats);
+
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_SelfMove] == 4 &&
+                 stats.hits[Spasm_x86_64_PeepholeRule_ZeroIdiom] == 0,
+                 "disabled rule applied");
+    SPASM_ASSERT(spasm_instructions_size(&instructions) == 8, "self moves not removed");
+
+    /* The hits add up over the calls */
+    spasm_x86_64_peephole(&instructions, SPASM_X86_64_PEEPHOLE_ALL_RULES, &stats);
+
+    SPASM_ASSERT(stats.hits[Spasm_x86_64_PeepholeRule_SelfMove] == 4 &&
+                 stats.hits[Spasm_x86_64_PeepholeRule_ZeroIdiom] == 4,
+                 "invalid hits");
+
+    for(size_t i = 0; i < spasm_instructions_size(&instructions); i += 2)
+        SPASM_ASSERT(spasm_instructions_at(&instructions, i)->mnemonic == SpasmMnemonic_x86_64_XOR,
+                     "zero idiom not applied");
+
+    SPASM_ASSERT(strcmp(spasm_x86_64_peephole_rule_name(Spasm_x86_64_PeepholeRule_AddChain), "add-chain") == 0,
+                 "invalid rule name");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_peephole_rules();
+    test_peephole_add_chain_32();
+    test_peephole_barriers();
+    test_peephole_toggles();
+
+    return 0;
+}
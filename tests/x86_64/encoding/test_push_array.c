@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+static bool encode_and_compare(SpasmInstructions* a, SpasmInstructions* b)
+{
+    SpasmByteCode a_bytecode = spasm_bytecode_new(NULL);
+    SpasmByteCode b_bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_encode_instructions(NULL, a, &a_bytecode, NULL);
+    res &= spasm_x86_64_encode_instructions(NULL, b, &b_bytecode, NULL);
+
+    size_t a_size = 0;
+    size_t b_size = 0;
+
+    const SpasmByte* a_bytes = spasm_bytecode_get(&a_bytecode, &a_size);
+    const SpasmByte* b_bytes = spasm_bytecode_get(&b_bytecode, &b_size);
+
+    res &= a_size > 0 && a_size == b_size && memcmp(a_bytes, b_bytes, a_size) == 0;
+
+    spasm_bytecode_destroy(&b_bytecode);
+    spasm_bytecode_destroy(&a_bytecode);
+
+    return res;
+}
+
+int main(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions varargs = spasm_instructions_new(&ctx);
+    SpasmInstructions arrays = spasm_instructions_new(&ctx);
+    SpasmInstructions appended = spasm_instructions_new(&ctx);
+
+    spasm_instructions_push(&varargs,
+                            SpasmMnemonic_x86_64_MOV,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1));
+    spasm_instructions_push(&varargs,
+                            SpasmMnemonic_x86_64_ADD,
+                            SpasmOpReg(SpasmRegister_x86_64_RAX),
+                            SpasmOpImm32(42));
+    spasm_instructions_pushz(&varargs, SpasmMnemonic_x86_64_SYSCALL);
+
+    const SpasmOperand mov_operands[] = {
+        SpasmOpReg(SpasmRegister_x86_64_RAX),
+        SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 8, 1),
+    };
+
+    const SpasmOperand add_operands[] = {
+        SpasmOpReg(SpasmRegister_x86_64_RAX),
+        SpasmOpImm32(42),
+    };
+
+    bool res = spasm_instructions_push_array(&arrays, SpasmMnemonic_x86_64_MOV, mov_operands, 2);
+    res &= spasm_instructions_push_array(&arrays, SpasmMnemonic_x86_64_ADD, add_operands, 2);
+    res &= spasm_instructions_push_array(&arrays, SpasmMnemonic_x86_64_SYSCALL, NULL, 0);
+
+    /* Append the stream twice, in one and in several calls */
+    res &= spasm_instructions_append(&appended,
+                                     spasm_instructions_at(&arrays, 0),
+                                     spasm_instructions_size(&arrays));
+
+    for(size_t i = 0; i < spasm_instructions_size(&arrays); i++)
+        res &= spasm_instructions_append(&appended, spasm_instructions_at(&arrays, i), 1);
+
+    res &= spasm_instructions_append(&varargs,
+                                     spasm_instructions_at(&arrays, 0),
+                                     spasm_instructions_size(&arrays));
+
+    SPASM_ASSERT(res, "pushing instructions failed");
+    SPASM_ASSERT(spasm_instructions_size(&appended) == 6, "invalid appended instructions count");
+    SPASM_ASSERT(ctx.stats.num_instructions_pushed == 15, "invalid pushed instructions count");
+
+    res = encode_and_compare(&varargs, &appended);
+
+    SPASM_ASSERT(res, "array and varargs pushes encode differently");
+
+    /* Too many operands are reported */
+    const SpasmOperand too_many_operands[SPASM_MAX_OPERANDS + 1] = { 0 };
+
+    res = spasm_instructions_push_array(&arrays,
+                                        SpasmMnemonic_x86_64_MOV,
+                                        too_many_operands,
+                                        SPASM_MAX_OPERANDS + 1);
+
+    SPASM_ASSERT(!res, "push should have failed");
+    SPASM_ASSERT(spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_TooManyOperands,
+                 "invalid last error");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&appended);
+    spasm_instructions_destroy(&arrays);
+    spasm_instructions_destroy(&varargs);
+    spasm_context_release(&ctx);
+
+    return 0;
+}
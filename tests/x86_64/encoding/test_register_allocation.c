@@ -0,0 +1,358 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+/* Fixed ABI so the pool is known: rdi, rsi, rdx, rcx, r8, r9 and xmm0-xmm5 */
+static const Spasm_x86_64_RegisterAllocationConfig config = {
+    SpasmABI_LinuxX64,
+    SpasmRegister_x86_64_RSP,
+    0,
+};
+
+#define RAX SpasmRegister_x86_64_RAX
+#define XMM SpasmRegister_x86_64_XMM0
+
+static bool encodes_like(SpasmInstructions* instructions, SpasmInstructions* expected)
+{
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
+    SpasmByteCode expected_bytecode = spasm_bytecode_new(NULL);
+
+    bool res = spasm_x86_64_encode_instructions(NULL, instructions, &bytecode, NULL) &&
+               spasm_x86_64_encode_instructions(NULL, expected, &expected_bytecode, NULL);
+
+    size_t size;
+    const SpasmByte* bytes = spasm_bytecode_get(&bytecode, &size);
+
+    size_t expected_size;
+    const SpasmByte* expected_bytes = spasm_bytecode_get(&expected_bytecode, &expected_size);
+
+    res = res && size == expected_size && memcmp(bytes, expected_bytes, size) == 0;
+
+    if(!res)
+    {
+        spasm_bytecode_debug(&bytecode);
+        spasm_bytecode_debug(&expected_bytecode);
+    }
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_bytecode_destroy(&expected_bytecode);
+
+    return res;
+}
+
+void test_register_allocation_simple(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmVirtualRegister v0 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v1 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v2 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v3 = spasm_instructions_new_virtual_register(&instructions);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v0, RAX), SpasmOpImm32(5));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v1, RAX), SpasmOpVirtualReg(v0, RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpVirtualReg(v1, RAX), SpasmOpVirtualMemory(v0, 8));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADDPS, SpasmOpVirtualReg(v2, XMM), SpasmOpVirtualReg(v3, XMM));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpVirtualReg(v1, SpasmRegister_x86_64_EAX));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_RegisterAllocationStats stats;
+
+    bool res = spasm_x86_64_allocate_registers(NULL, &instructions, &config, &stats);
+
+    SPASM_ASSERT(res, "error during register allocation");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(stats.num_virtual_registers == 4, "invalid virtual registers count");
+    SPASM_ASSERT(stats.num_spilled == 0 && stats.spill_size == 0, "nothing should be spilled");
+    SPASM_ASSERT(stats.num_spill_instructions == 0, "invalid spill instructions count");
+
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RDI), SpasmOpImm32(5));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RSI), SpasmOpReg(SpasmRegister_x86_64_RDI));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpReg(SpasmRegister_x86_64_RSI), SpasmOpMemory(SpasmRegister_x86_64_RDI, 0, 8, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADDPS, SpasmOpReg(SpasmRegister_x86_64_XMM0), SpasmOpReg(SpasmRegister_x86_64_XMM1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_EAX), SpasmOpReg(SpasmRegister_x86_64_ESI));
+    spasm_instructions_pushz(&expected, SpasmMnemonic_x86_64_RET);
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "invalid allocated code");
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_register_allocation_spills(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    SpasmVirtualRegister v[8];
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        v[i] = spasm_instructions_new_virtual_register(&instructions);
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v[i], RAX), SpasmOpImm32(i));
+    }
+
+    for(uint32_t i = 1; i < 8; i++)
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpVirtualReg(v[0], RAX), SpasmOpVirtualReg(v[i], RAX));
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpVirtualMemoryIndex(v[0], v[7], 16, 8));
+
+    Spasm_x86_64_RegisterAllocationStats stats;
+
+    bool res = spasm_x86_64_allocate_registers(NULL, &instructions, &config, &stats);
+
+    /*
+        6 registers for 8 values: v6 takes the register of v0 (live the longest), and v7 has no
+        register free for its whole interval. Both live in the slots, add v0, v7 needs a scratch
+        register and the address using both is computed in one
+    */
+    SPASM_ASSERT(res, "error during register allocation");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(stats.num_spilled == 2, "invalid spilled count");
+    SPASM_ASSERT(stats.spill_size == 16, "invalid spill size");
+    SPASM_ASSERT(stats.num_spill_instructions == 4, "invalid spill instructions count");
+
+    const SpasmRegister registers[8] = {
+        0,
+        SpasmRegister_x86_64_RSI,
+        SpasmRegister_x86_64_RDX,
+        SpasmRegister_x86_64_RCX,
+        SpasmRegister_x86_64_R8,
+        SpasmRegister_x86_64_R9,
+        SpasmRegister_x86_64_RDI,
+        0,
+    };
+
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpImm32(0));
+
+    for(uint32_t i = 1; i < 7; i++)
+        spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(registers[i]), SpasmOpImm32(i));
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1), SpasmOpImm32(7));
+
+    for(uint32_t i = 1; i < 7; i++)
+        spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpReg(registers[i]));
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R10), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpReg(SpasmRegister_x86_64_R10));
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R10), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R11), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_LEA, SpasmOpReg(SpasmRegister_x86_64_R10), SpasmOpMemory(SpasmRegister_x86_64_R10, SpasmRegister_x86_64_R11, 0, 8));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpMemory(SpasmRegister_x86_64_R10, 0, 16, 1));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "invalid spill code");
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_register_allocation_spills_written_operands(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    SpasmVirtualRegister v[8];
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        v[i] = spasm_instructions_new_virtual_register(&instructions);
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v[i], RAX), SpasmOpImm32(i));
+    }
+
+    for(uint32_t i = 1; i < 7; i++)
+        spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpVirtualReg(v[i], RAX), SpasmOpVirtualReg(v[i], RAX));
+
+    /* xadd writes both of its operands, both spilled */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_XADD, SpasmOpVirtualReg(v[0], RAX), SpasmOpVirtualReg(v[7], RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpVirtualReg(v[7], RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpVirtualReg(v[0], RAX));
+
+    Spasm_x86_64_RegisterAllocationStats stats;
+
+    bool res = spasm_x86_64_allocate_registers(NULL, &instructions, &config, &stats);
+
+    SPASM_ASSERT(res, "error during register allocation");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(stats.num_spilled == 2, "invalid spilled count");
+    SPASM_ASSERT(stats.num_spill_instructions == 2, "invalid spill instructions count");
+
+    const SpasmRegister registers[7] = {
+        0,
+        SpasmRegister_x86_64_RSI,
+        SpasmRegister_x86_64_RDX,
+        SpasmRegister_x86_64_RCX,
+        SpasmRegister_x86_64_R8,
+        SpasmRegister_x86_64_R9,
+        SpasmRegister_x86_64_RDI,
+    };
+
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpImm32(0));
+
+    for(uint32_t i = 1; i < 7; i++)
+        spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(registers[i]), SpasmOpImm32(i));
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1), SpasmOpImm32(7));
+
+    for(uint32_t i = 1; i < 7; i++)
+        spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpReg(registers[i]), SpasmOpReg(registers[i]));
+
+    /* The register operand of xadd is stored back to its slot */
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_R10), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_XADD, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpReg(SpasmRegister_x86_64_R10));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1), SpasmOpReg(SpasmRegister_x86_64_R10));
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RAX), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 8, 1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "invalid spill code");
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_register_allocation_constraints(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmVirtualRegister v0 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v1 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v2 = spasm_instructions_new_virtual_register(&instructions);
+
+    /* v0 is live around the use of rdi (the first argument register), it must not get it */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v0, RAX), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RDI), SpasmOpImm32(2));
+
+    /* v1 is live across the call, which clobbers all the registers of the pool */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v1, RAX), SpasmOpVirtualReg(v0, RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(SpasmRegister_x86_64_RAX));
+
+    /* xmm0 holds the return value until it is read, v2 must not get it */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOVAPS, SpasmOpVirtualReg(v2, XMM), SpasmOpVirtualReg(v2, XMM));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADDPS, SpasmOpReg(SpasmRegister_x86_64_XMM0), SpasmOpVirtualReg(v2, XMM));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpVirtualReg(v1, RAX), SpasmOpImm8(3));
+
+    Spasm_x86_64_RegisterAllocationStats stats;
+
+    bool res = spasm_x86_64_allocate_registers(NULL, &instructions, &config, &stats);
+
+    SPASM_ASSERT(res, "error during register allocation");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(stats.num_spilled == 1 && stats.spill_size == 16, "the value live across the call should be spilled");
+
+    SpasmInstructions expected = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RSI), SpasmOpImm32(1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpReg(SpasmRegister_x86_64_RDI), SpasmOpImm32(2));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpReg(SpasmRegister_x86_64_RSI));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_CALL, SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_MOVAPS, SpasmOpReg(SpasmRegister_x86_64_XMM1), SpasmOpReg(SpasmRegister_x86_64_XMM1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADDPS, SpasmOpReg(SpasmRegister_x86_64_XMM0), SpasmOpReg(SpasmRegister_x86_64_XMM1));
+    spasm_instructions_push(&expected, SpasmMnemonic_x86_64_ADD, SpasmOpMemory(SpasmRegister_x86_64_RSP, 0, 0, 1), SpasmOpImm8(3));
+
+    res = encodes_like(&instructions, &expected);
+    SPASM_ASSERT(res, "invalid constrained code");
+
+    spasm_instructions_destroy(&expected);
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_register_allocation_loops(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmVirtualRegister v0 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmVirtualRegister v1 = spasm_instructions_new_virtual_register(&instructions);
+    const SpasmLabel loop = spasm_instructions_new_label(&instructions);
+
+    /* v0 is last used in the loop but read again on the next iteration, v1 can't take its register */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v0, RAX), SpasmOpImm32(10));
+    spasm_instructions_bind_label(&instructions, loop);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(SpasmRegister_x86_64_RAX), SpasmOpVirtualReg(v0, RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v1, RAX), SpasmOpReg(SpasmRegister_x86_64_RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMP, SpasmOpVirtualReg(v1, RAX), SpasmOpImm8(100));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_JL, SpasmOpLabel(loop));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    bool res = spasm_x86_64_allocate_registers(NULL, &instructions, &config, NULL);
+
+    SPASM_ASSERT(res, "error during register allocation");
+    SPASM_UNUSED(res);
+
+    SpasmInstruction* def = spasm_instructions_at(&instructions, 0);
+    SpasmInstruction* loop_def = spasm_instructions_at(&instructions, 3);
+
+    SPASM_ASSERT(def->operands[0].reg == SpasmRegister_x86_64_RDI, "invalid register for v0");
+    SPASM_ASSERT(loop_def->operands[0].reg == SpasmRegister_x86_64_RSI, "v0 is not live over the loop");
+    SPASM_UNUSED(def);
+    SPASM_UNUSED(loop_def);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_register_allocation_errors(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+
+    const SpasmVirtualRegister v0 = spasm_instructions_new_virtual_register(&instructions);
+
+    /* Not created by the stream */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v0 + 1, RAX), SpasmOpImm32(1));
+
+    bool res = spasm_x86_64_allocate_registers(&ctx, &instructions, &config, NULL);
+
+    SPASM_ASSERT(!res, "unknown virtual register should fail");
+    SPASM_ASSERT(spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_InvalidVirtualRegister,
+                 "invalid last error");
+
+    /* Seen as a general purpose and as a vector register */
+    spasm_instructions_reset(&instructions);
+
+    const SpasmVirtualRegister v1 = spasm_instructions_new_virtual_register(&instructions);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpVirtualReg(v1, RAX), SpasmOpImm32(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADDPS, SpasmOpVirtualReg(v1, XMM), SpasmOpReg(SpasmRegister_x86_64_XMM1));
+
+    res = spasm_x86_64_allocate_registers(&ctx, &instructions, &config, NULL);
+
+    SPASM_ASSERT(!res, "virtual register in two files should fail");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(ctx.stats.num_errors == 2, "invalid errors count");
+
+    /* Virtual operands are not encodable before allocation */
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    res = spasm_x86_64_encode_instructions(&ctx, &instructions, &bytecode, NULL);
+
+    SPASM_ASSERT(!res, "virtual operands should not encode");
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_register_allocation_simple();
+    test_register_allocation_spills();
+    test_register_allocation_spills_written_operands();
+    test_register_allocation_constraints();
+    test_register_allocation_loops();
+    test_register_allocation_errors();
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "test_encoding_common.h"
+
+#include "spasm/context.h"
+#include "spasm/x86_64.h"
+
+#define RAX SpasmRegister_x86_64_RAX
+#define RCX SpasmRegister_x86_64_RCX
+#define RDX SpasmRegister_x86_64_RDX
+#define RSI SpasmRegister_x86_64_RSI
+#define RDI SpasmRegister_x86_64_RDI
+#define R11 SpasmRegister_x86_64_R11
+
+#define YMM(n) (SpasmRegister_x86_64_YMM0 + (n))
+
+#define MAX_TEST_INSTRUCTIONS 32
+
+/* Position of each instruction of the original stream in the scheduled one */
+static bool schedule_positions(SpasmInstructions* instructions,
+                               const Spasm_x86_64_ScheduleConfig* config,
+                               Spasm_x86_64_ScheduleStats* stats,
+                               size_t* positions)
+{
+    SpasmInstruction original[MAX_TEST_INSTRUCTIONS];
+
+    const size_t size = spasm_instructions_size(instructions);
+
+    for(size_t i = 0; i < size; i++)
+        original[i] = *spasm_instructions_at(instructions, i);
+
+    if(!spasm_x86_64_schedule(NULL, instructions, config, stats) || spasm_instructions_size(instructions) != size)
+        return false;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        positions[i] = SIZE_MAX;
+
+        for(size_t j = 0; j < size; j++)
+            if(memcmp(&original[i], spasm_instructions_at(instructions, j), sizeof(SpasmInstruction)) == 0)
+                positions[i] = j;
+
+        if(positions[i] == SIZE_MAX)
+            return false;
+    }
+
+    return true;
+}
+
+void test_schedule_chains(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* Two independent multiply-add chains, written one after the other */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(1)), SpasmOpReg(YMM(2)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VADDPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(0)), SpasmOpReg(YMM(3)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(0)), SpasmOpReg(YMM(2)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(4)), SpasmOpReg(YMM(5)), SpasmOpReg(YMM(6)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VADDPS, SpasmOpReg(YMM(4)), SpasmOpReg(YMM(4)), SpasmOpReg(YMM(7)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(4)), SpasmOpReg(YMM(4)), SpasmOpReg(YMM(6)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VADDPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(0)), SpasmOpReg(YMM(4)));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_ScheduleStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_ScheduleStats));
+
+    const Spasm_x86_64_ScheduleConfig config = { Spasm_x86_64_Uarch_Skylake, SpasmABI_LinuxX64 };
+
+    size_t positions[MAX_TEST_INSTRUCTIONS];
+
+    bool res = schedule_positions(&instructions, &config, &stats, positions);
+    SPASM_ASSERT(res, "Scheduling failed");
+
+    res = stats.num_regions == 1 && stats.num_reordered == 1 && stats.cycles_after < stats.cycles_before;
+    SPASM_ASSERT(res, "Schedule stats");
+
+    /* The chains are interleaved, each one keeps its order */
+    res = positions[3] < positions[2] &&
+          positions[0] < positions[1] && positions[1] < positions[2] &&
+          positions[3] < positions[4] && positions[4] < positions[5] &&
+          positions[2] < positions[6] && positions[5] < positions[6] &&
+          positions[7] == 7;
+    SPASM_ASSERT(res, "Interleaved chains");
+
+    /* Already scheduled, nothing moves */
+    memset(&stats, 0, sizeof(Spasm_x86_64_ScheduleStats));
+
+    res = schedule_positions(&instructions, &config, &stats, positions);
+    SPASM_ASSERT(res, "Scheduling failed");
+
+    res = stats.num_reordered == 0 && stats.cycles_after == stats.cycles_before;
+    SPASM_ASSERT(res, "Stable schedule");
+    SPASM_UNUSED(res);
+
+    for(size_t i = 0; i < spasm_instructions_size(&instructions); i++)
+        SPASM_ASSERT(positions[i] == i, "Stable schedule order");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_schedule_memory_flags(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    /* The loads would start early, but not above the store, and the cmp stays between the add and the cmove */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_IMUL, SpasmOpReg(RAX), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_IMUL, SpasmOpReg(RAX), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RSI, 0, 0, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RCX), SpasmOpMemory(RDI, 0, 0, 0));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RCX), SpasmOpImm8(1));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMP, SpasmOpReg(RDX), SpasmOpImm8(0));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CMOVE, SpasmOpReg(RAX), SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpReg(RDX), SpasmOpMemory(RDI, 0, 8, 0));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    size_t positions[MAX_TEST_INSTRUCTIONS];
+
+    bool res = schedule_positions(&instructions, NULL, NULL, positions);
+    SPASM_ASSERT(res, "Scheduling failed");
+
+    res = positions[2] < positions[3] && positions[2] < positions[7] &&
+          positions[4] < positions[5] && positions[5] < positions[6] &&
+          positions[5] < positions[7] && positions[8] == 8;
+    SPASM_ASSERT(res, "Memory and flags ordering");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_schedule_barriers(void)
+{
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    const SpasmLabel label = spasm_instructions_new_label(&instructions);
+
+    /* Nothing crosses the call and the label */
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(0)), SpasmOpReg(YMM(1)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(0)), SpasmOpReg(YMM(0)), SpasmOpReg(YMM(4)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_CALL, SpasmOpReg(R11));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(2)), SpasmOpReg(YMM(2)), SpasmOpReg(YMM(1)));
+    spasm_instructions_bind_label(&instructions, label);
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VADDPS, SpasmOpReg(YMM(3)), SpasmOpReg(YMM(3)), SpasmOpReg(YMM(1)));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_VMULPS, SpasmOpReg(YMM(2)), SpasmOpReg(YMM(2)), SpasmOpReg(YMM(5)));
+    spasm_instructions_pushz(&instructions, SpasmMnemonic_x86_64_RET);
+
+    Spasm_x86_64_ScheduleStats stats;
+    memset(&stats, 0, sizeof(Spasm_x86_64_ScheduleStats));
+
+    size_t positions[MAX_TEST_INSTRUCTIONS];
+
+    bool res = schedule_positions(&instructions, NULL, &stats, positions);
+    SPASM_ASSERT(res, "Scheduling failed");
+
+    for(size_t i = 0; i < 5; i++)
+        SPASM_ASSERT(positions[i] == i, "Barrier order");
+
+    res = stats.num_regions == 2;
+    SPASM_ASSERT(res, "Barrier regions");
+    SPASM_UNUSED(res);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+void test_schedule_cost_model(void)
+{
+    bool res;
+    SPASM_UNUSED(res);
+
+    const Spasm_x86_64_UarchProfile* zen4 = spasm_x86_64_get_uarch_profile(Spasm_x86_64_Uarch_Zen4);
+
+    res = zen4 != NULL && zen4->issue_width == 6 && strcmp(zen4->name, "zen4") == 0;
+    SPASM_ASSERT(res, "Zen4 profile");
+
+    res = spasm_x86_64_get_uarch_profile(Spasm_x86_64_Uarch_COUNT) == NULL &&
+          spasm_x86_64_uarch_from_string("skylake") == Spasm_x86_64_Uarch_Skylake &&
+          spasm_x86_64_uarch_from_string("generic") == Spasm_x86_64_Uarch_Generic &&
+          spasm_x86_64_uarch_from_string("pentium") == Spasm_x86_64_Uarch_COUNT;
+    SPASM_ASSERT(res, "Profile lookup");
+
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpReg(RCX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_ADD, SpasmOpReg(RAX), SpasmOpMemory(RDI, 0, 0, 0));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_MOV, SpasmOpMemory(RDI, 0, 0, 0), SpasmOpReg(RAX));
+    spasm_instructions_push(&instructions, SpasmMnemonic_x86_64_LEA, SpasmOpReg(RAX), SpasmOpMemory(RDI, RCX, 0, 4));
+
+    Spasm_x86_64_InstructionCost reg;
+    Spasm_x86_64_InstructionCost load;
+    Spasm_x86_64_InstructionCost store;
+    Spasm_x86_64_InstructionCost lea;
+
+    res = spasm_x86_64_instruction_cost(spasm_instructions_at(&instructions, 0), Spasm_x86_64_Uarch_Zen4, &reg) &&
+          spasm_x86_64_instruction_cost(spasm_instructions_at(&instructions, 1), Spasm_x86_64_Uarch_Zen4, &load) &&
+          spasm_x86_64_instruction_cost(spasm_instructions_at(&instructions, 2), Spasm_x86_64_Uarch_Zen4, &store) &&
+          spasm_x86_64_instruction_cost(spasm_instructions_at(&instructions, 3), Spasm_x86_64_Uarch_Zen4, &lea);
+    SPASM_ASSERT(res, "Instruction cost");
+
+    res = !reg.load && !reg.store &&
+          load.load && !load.store && load.latency == reg.latency + zen4->load_latency &&
+          !store.load && store.store &&
+          !lea.load && !lea.store;
+    SPASM_ASSERT(res, "Instruction cost values");
+
+    const Spasm_x86_64_ScheduleConfig config = { Spasm_x86_64_Uarch_COUNT, SpasmABI_LinuxX64 };
+
+    res = !spasm_x86_64_schedule(NULL, &instructions, &config, NULL);
+    SPASM_ASSERT(res, "Unsupported uarch");
+
+    spasm_instructions_destroy(&instructions);
+}
+
+int main(void)
+{
+    test_schedule_chains();
+    test_schedule_memory_flags();
+    test_schedule_barriers();
+    test_schedule_cost_model();
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/assembler.h"
+#include "spasm/context.h"
+#include "spasm/data.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/x86_64.h"
+
+static bool assemble_into(SpasmInstructions* instructions, SpasmByteCode* bytecode, SpasmData* data)
+{
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(spasm_get_current_abi());
+
+    spasm_data_add_bytes(data,
+                         "message",
+                         (uint8_t*)"Hello, World!\n",
+                         14,
+                         SpasmDataType_ROData);
+
+    spasm_data_add_intern_symbol(data, "loop", 0, 0);
+
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        spasm_instructions_push_back(instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RSI),
+                                     SpasmOpData("message"));
+        spasm_instructions_push_back(instructions,
+                                     "add",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpReg(SpasmRegister_x86_64_RBX));
+
+        spasm_data_add_intern_symbol_ref(data, "loop", 0, i * 4, 4);
+    }
+
+    spasm_instructions_push_backz(instructions, "syscall");
+
+    return assembler(instructions, bytecode, data);
+}
+
+static bool assemble(SpasmContext* ctx)
+{
+    SpasmData data;
+    spasm_data_init(&data, ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(ctx);
+
+    bool res = assemble_into(&instructions, &bytecode, &data);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_data_release(&data);
+
+    return res;
+}
+
+void test_allocator_tracking(void)
+{
+    SpasmTrackingAllocator tracking;
+    spasm_tracking_allocator_init(&tracking, NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_allocator(&ctx, &tracking.allocator);
+
+    bool res = assemble(&ctx);
+
+    SPASM_ASSERT(res, "assembling failed");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(tracking.num_allocs > 0, "the context allocator has not been used");
+    SPASM_ASSERT(tracking.peak_bytes_in_use > 0, "invalid peak bytes count");
+    SPASM_ASSERT(tracking.bytes_in_use == 0, "memory has been leaked");
+    SPASM_ASSERT(tracking.num_allocs == tracking.num_frees, "allocations and frees do not match");
+
+    spasm_context_release(&ctx);
+}
+
+void test_allocator_reset_reuse(void)
+{
+    SpasmTrackingAllocator tracking;
+    spasm_tracking_allocator_init(&tracking, NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_allocator(&ctx, &tracking.allocator);
+
+    SpasmData data;
+    spasm_data_init(&data, &ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    bool res = assemble_into(&instructions, &bytecode, &data);
+
+    const size_t bytecode_size = spasm_bytecode_size(&bytecode);
+
+    /* The first reset fills the refs pool, then compiles of the same size must not allocate */
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        if(i == 1)
+            spasm_tracking_allocator_reset_counters(&tracking);
+
+        spasm_data_reset(&data);
+        spasm_instructions_reset(&instructions);
+        spasm_bytecode_reset(&bytecode);
+
+        res &= assemble_into(&instructions, &bytecode, &data);
+        res &= spasm_bytecode_size(&bytecode) == bytecode_size;
+        res &= spasm_data_num_interns(&data) == 1;
+    }
+
+    SPASM_ASSERT(res, "assembling after reset failed");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(tracking.num_allocs == 0 && tracking.num_reallocs == 0,
+                 "reset objects should not allocate");
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_data_release(&data);
+
+    SPASM_ASSERT(tracking.bytes_in_use == 0, "memory has been leaked");
+
+    spasm_context_release(&ctx);
+}
+
+typedef struct
+{
+    uint32_t num_allocs_left;
+    SpasmTrackingAllocator tracking;
+} FailingAllocatorData;
+
+static void* failing_alloc(size_t size, void* user_data)
+{
+    FailingAllocatorData* failing = (FailingAllocatorData*)user_data;
+
+    if(failing->num_allocs_left == 0)
+        return NULL;
+
+    failing->num_allocs_left--;
+
+    return spasm_allocator_alloc(&failing->tracking.allocator, size);
+}
+
+static void* failing_realloc(void* ptr, size_t old_size, size_t new_size, void* user_data)
+{
+    FailingAllocatorData* failing = (FailingAllocatorData*)user_data;
+
+    if(failing->num_allocs_left == 0)
+        return NULL;
+
+    failing->num_allocs_left--;
+
+    return spasm_allocator_realloc(&failing->tracking.allocator, ptr, old_size, new_size);
+}
+
+static void failing_free(void* ptr, size_t size, void* user_data)
+{
+    FailingAllocatorData* failing = (FailingAllocatorData*)user_data;
+
+    spasm_allocator_free(&failing->tracking.allocator, ptr, size);
+}
+
+static void record_error(const SpasmError* error, void* user_data)
+{
+    *(SpasmErrorCode*)user_data = error->code;
+}
+
+void test_allocator_out_of_memory(void)
+{
+    /* Fail every allocation in turn, errors must be reported and nothing leaked */
+    for(uint32_t limit = 0; limit < 32; limit++)
+    {
+        FailingAllocatorData failing;
+        failing.num_allocs_left = limit;
+        spasm_tracking_allocator_init(&failing.tracking, NULL);
+
+        SpasmAllocator allocator = { failing_alloc, failing_realloc, failing_free, &failing };
+
+        SpasmErrorCode code = SpasmErrorCode_None;
+
+        SpasmContext ctx;
+        spasm_context_init(&ctx);
+        spasm_context_set_allocator(&ctx, &allocator);
+        spasm_context_set_error_callback(&ctx, record_error, &code);
+
+        bool res = assemble(&ctx);
+
+        SPASM_ASSERT(limit > 0 || code == SpasmErrorCode_OutOfMemory, "out of memory has not been reported");
+        SPASM_ASSERT(res || code == SpasmErrorCode_OutOfMemory, "out of memory has not been reported");
+        SPASM_ASSERT(failing.tracking.bytes_in_use == 0, "memory has been leaked");
+        SPASM_UNUSED(res);
+
+        spasm_context_release(&ctx);
+    }
+}
+
+int main(void)
+{
+    test_allocator_tracking();
+    test_allocator_reset_reuse();
+    test_allocator_out_of_memory();
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/abi.h"
+#include "spasm/allocator.h"
+#include "spasm/compile_queue.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_JOBS 300
+
+static const uint8_t expected[] = {
+    0x48, 0xC7, 0xC0, 0x01, 0x00, 0x00, 0x00, /* mov rax, 1 */
+    0x48, 0x01, 0xD8,                         /* add rax, rbx */
+    0x0F, 0x05,                               /* syscall */
+};
+
+typedef struct
+{
+    SpasmContext ctx;
+    SpasmData data;
+    SpasmInstructions instructions;
+    SpasmByteCode bytecode;
+    SpasmCompileJob* job;
+} Compile;
+
+static void compile_init(Compile* compile, bool valid)
+{
+    spasm_context_init(&compile->ctx);
+    spasm_data_init(&compile->data, &compile->ctx);
+    compile->instructions = spasm_instructions_new(&compile->ctx);
+    compile->bytecode = spasm_bytecode_new(&compile->ctx);
+
+    spasm_instructions_push_back(&compile->instructions,
+                                 "mov",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpImm32(1));
+    spasm_instructions_push_back(&compile->instructions,
+                                 "add",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpReg(SpasmRegister_x86_64_RBX));
+
+    if(valid)
+        spasm_instructions_push_backz(&compile->instructions, "syscall");
+    else
+        spasm_instructions_push_back(&compile->instructions,
+                                     "mov",
+                                     SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                     SpasmOpReg(SpasmRegister_x86_64_XMM0));
+}
+
+static void compile_release(Compile* compile)
+{
+    spasm_compile_job_release(compile->job);
+    spasm_bytecode_destroy(&compile->bytecode);
+    spasm_instructions_destroy(&compile->instructions);
+    spasm_data_release(&compile->data);
+    spasm_context_release(&compile->ctx);
+}
+
+void test_compile_queue_jobs(void)
+{
+    SpasmCompileQueue* queue = spasm_compile_queue_new(NULL, spasm_get_current_abi(), 4);
+
+    SPASM_ASSERT(queue != NULL, "cannot create compile queue");
+    SPASM_ASSERT(spasm_compile_queue_num_workers(queue) == 4, "invalid number of workers");
+
+    Compile* compiles = (Compile*)calloc(NUM_JOBS, sizeof(Compile));
+
+    for(uint32_t i = 0; i < NUM_JOBS; i++)
+    {
+        compile_init(&compiles[i], true);
+
+        compiles[i].job = spasm_compile_queue_submit(queue,
+                                                     &compiles[i].instructions,
+                                                     &compiles[i].data,
+                                                     &compiles[i].bytecode,
+                                                     (SpasmCompilePriority)(i % SpasmCompilePriority_COUNT));
+
+        SPASM_ASSERT(compiles[i].job != NULL, "cannot submit job");
+    }
+
+    for(uint32_t i = 0; i < NUM_JOBS; i++)
+    {
+        SpasmCompileJobStatus status = spasm_compile_job_wait(compiles[i].job);
+
+        SPASM_ASSERT(status == SpasmCompileJobStatus_Done, "job failed");
+        SPASM_ASSERT(spasm_compile_job_poll(compiles[i].job) == status, "poll and wait disagree");
+        SPASM_UNUSED(status);
+
+        size_t sz = 0;
+        const uint8_t* code = (const uint8_t*)spasm_bytecode_get(&compiles[i].bytecode, &sz);
+
+        SPASM_ASSERT(sz == sizeof(expected), "invalid bytecode size");
+        SPASM_ASSERT(memcmp(code, expected, sizeof(expected)) == 0, "invalid bytecode");
+        SPASM_UNUSED(code);
+        SPASM_UNUSED(expected);
+
+        SpasmCompileJobTimings timings = spasm_compile_job_get_timings(compiles[i].job);
+
+        SPASM_ASSERT(timings.total_ns == timings.queued_ns + timings.run_ns, "invalid timings");
+        SPASM_UNUSED(timings);
+
+        compile_release(&compiles[i]);
+    }
+
+    free(compiles);
+
+    spasm_compile_queue_destroy(queue);
+}
+
+void test_compile_queue_failed_job(void)
+{
+    SpasmCompileQueue* queue = spasm_compile_queue_new(NULL, spasm_get_current_abi(), 2);
+
+    SPASM_ASSERT(queue != NULL, "cannot create compile queue");
+
+    Compile compile;
+    compile_init(&compile, false);
+
+    compile.job = spasm_compile_queue_submit(queue,
+                                             &compile.instructions,
+                                             &compile.data,
+                                             &compile.bytecode,
+                                             SpasmCompilePriority_High);
+
+    SpasmCompileJobStatus status = spasm_compile_job_wait(compile.job);
+
+    SPASM_ASSERT(status == SpasmCompileJobStatus_Failed, "job should have failed");
+    SPASM_ASSERT(compile.ctx.stats.num_errors == 1, "invalid errors count");
+    SPASM_UNUSED(status);
+
+    compile_release(&compile);
+
+    spasm_compile_queue_destroy(queue);
+}
+
+void test_compile_queue_destroy_drains(void)
+{
+    SpasmCompileQueue* queue = spasm_compile_queue_new(NULL, spasm_get_current_abi(), 3);
+
+    SPASM_ASSERT(queue != NULL, "cannot create compile queue");
+
+    Compile compiles[32];
+
+    for(uint32_t i = 0; i < 32; i++)
+    {
+        compile_init(&compiles[i], true);
+
+        compiles[i].job = spasm_compile_queue_submit(queue,
+                                                     &compiles[i].instructions,
+                                                     &compiles[i].data,
+                                                     &compiles[i].bytecode,
+                                                     SpasmCompilePriority_Low);
+    }
+
+    spasm_compile_queue_destroy(queue);
+
+    for(uint32_t i = 0; i < 32; i++)
+    {
+        SPASM_ASSERT(spasm_compile_job_poll(compiles[i].job) == SpasmCompileJobStatus_Done,
+                     "job not finished after the queue has been destroyed");
+
+        compile_release(&compiles[i]);
+    }
+}
+
+void test_compile_queue_allocator(void)
+{
+    SpasmTrackingAllocator tracking;
+    spasm_tracking_allocator_init(&tracking, NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_allocator(&ctx, &tracking.allocator);
+
+    SpasmCompileQueue* queue = spasm_compile_queue_new(&ctx, spasm_get_current_abi(), 2);
+
+    SPASM_ASSERT(queue != NULL, "cannot create compile queue");
+    SPASM_ASSERT(tracking.num_allocs > 0, "the queue does not use the context allocator");
+
+    Compile* compiles = (Compile*)malloc(NUM_JOBS * sizeof(Compile));
+
+    SPASM_ASSERT(compiles != NULL, "cannot allocate compiles");
+
+    for(uint32_t i = 0; i < NUM_JOBS; i++)
+    {
+        compile_init(&compiles[i], true);
+
+        compiles[i].job = spasm_compile_queue_submit(queue,
+                                                     &compiles[i].instructions,
+                                                     &compiles[i].data,
+                                                     &compiles[i].bytecode,
+                                                     SpasmCompilePriority_Normal);
+    }
+
+    for(uint32_t i = 0; i < NUM_JOBS; i++)
+    {
+        SpasmCompileJobStatus status = spasm_compile_job_wait(compiles[i].job);
+
+        SPASM_ASSERT(status == SpasmCompileJobStatus_Done, "job failed");
+        SPASM_UNUSED(status);
+
+        compile_release(&compiles[i]);
+    }
+
+    free(compiles);
+
+    spasm_compile_queue_destroy(queue);
+
+    SPASM_ASSERT(tracking.bytes_in_use == 0, "memory has been leaked");
+
+    spasm_context_release(&ctx);
+}
+
+int main(void)
+{
+    test_compile_queue_jobs();
+    test_compile_queue_failed_job();
+    test_compile_queue_destroy_drains();
+    test_compile_queue_allocator();
+
+    return 0;
+}
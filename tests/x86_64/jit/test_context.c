@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/abi.h"
+#include "spasm/assembler.h"
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/thread.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_THREADS 8
+#define NUM_COMPILES 256
+
+static const uint8_t expected[] = {
+    0x48, 0xC7, 0xC0, 0x01, 0x00, 0x00, 0x00, /* mov rax, 1 */
+    0x48, 0x01, 0xD8,                         /* add rax, rbx */
+    0x0F, 0x05,                               /* syscall */
+};
+
+static void push_instructions(SpasmInstructions* instructions)
+{
+    spasm_instructions_push_back(instructions,
+                                 "mov",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpImm32(1));
+    spasm_instructions_push_back(instructions,
+                                 "add",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpReg(SpasmRegister_x86_64_RBX));
+    spasm_instructions_push_backz(instructions, "syscall");
+}
+
+static void count_errors(const SpasmError* error, void* user_data)
+{
+    SPASM_UNUSED(error);
+
+    (*(uint32_t*)user_data)++;
+}
+
+typedef struct
+{
+    SpasmContext ctx;
+    bool ok;
+} ThreadData;
+
+static void assemble_thread(void* arg)
+{
+    ThreadData* thread_data = (ThreadData*)arg;
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(spasm_get_current_abi());
+
+    thread_data->ok = true;
+
+    for(uint32_t i = 0; i < NUM_COMPILES; i++)
+    {
+        SpasmData data;
+        spasm_data_init(&data, &thread_data->ctx);
+
+        SpasmInstructions instructions = spasm_instructions_new(&thread_data->ctx);
+        SpasmByteCode bytecode = spasm_bytecode_new(&thread_data->ctx);
+
+        push_instructions(&instructions);
+
+        size_t sz = 0;
+
+        if(!assembler(&instructions, &bytecode, &data) ||
+           spasm_bytecode_size(&bytecode) != sizeof(expected) ||
+           memcmp(spasm_bytecode_get(&bytecode, &sz), expected, sizeof(expected)) != 0)
+            thread_data->ok = false;
+
+        spasm_bytecode_destroy(&bytecode);
+        spasm_instructions_destroy(&instructions);
+        spasm_data_release(&data);
+    }
+}
+
+void test_context_error_callback(void)
+{
+    uint32_t num_errors = 0;
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_error_callback(&ctx, count_errors, &num_errors);
+
+    SpasmJitAssembler assembler = spasm_get_jit_assembler(spasm_get_current_abi());
+
+    SpasmData data;
+    spasm_data_init(&data, &ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    push_instructions(&instructions);
+    spasm_instructions_push_back(&instructions,
+                                 "mov",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpReg(SpasmRegister_x86_64_XMM0));
+
+    bool res = assembler(&instructions, &bytecode, &data);
+
+    SPASM_ASSERT(!res, "assembler should have failed");
+    SPASM_UNUSED(res);
+    SPASM_ASSERT(num_errors == 1, "error callback has not been called");
+    SPASM_ASSERT(ctx.stats.num_errors == 1, "invalid errors count");
+    SPASM_ASSERT(ctx.stats.num_instructions_pushed == 4, "invalid pushed instructions count");
+    SPASM_ASSERT(ctx.stats.num_instructions_encoded == 3, "invalid encoded instructions count");
+    SPASM_ASSERT(ctx.stats.num_bytes_encoded == sizeof(expected), "invalid encoded bytes count");
+
+    /* Unknown mnemonics are reported when pushing */
+    res = spasm_instructions_push_backz(&instructions, "notaninstruction");
+
+    SPASM_ASSERT(!res, "push should have failed");
+    SPASM_ASSERT(num_errors == 2, "error callback has not been called");
+    SPASM_ASSERT(spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_UnknownMnemonic,
+                 "invalid last error");
+    SPASM_ASSERT(ctx.stats.num_instructions_pushed == 4, "invalid pushed instructions count");
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_data_release(&data);
+    spasm_context_release(&ctx);
+}
+
+static void format_error(const SpasmError* error, void* user_data)
+{
+    spasm_error_format(error, (char*)user_data, 128);
+}
+
+void test_context_error_record(void)
+{
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+
+    SpasmInstructions instructions = spasm_instructions_new(&ctx);
+    SpasmByteCode bytecode = spasm_bytecode_new(&ctx);
+
+    spasm_instructions_push_back(&instructions,
+                                 "mov",
+                                 SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                 SpasmOpReg(SpasmRegister_x86_64_XMM0));
+
+    SpasmInstruction* instr = spasm_instructions_at(&instructions, 0);
+
+    /* Probing does not report anything, nor write to the bytecode */
+    SpasmError error;
+    SpasmErrorCode code = spasm_x86_64_try_encode_instruction(&ctx, instr, &bytecode, &error);
+
+    SPASM_ASSERT(code == SpasmErrorCode_UnknownInstruction, "invalid error code");
+    SPASM_ASSERT(error.code == code && error.instruction == instr, "invalid error record");
+    SPASM_ASSERT(ctx.stats.num_errors == 0, "probing should not report errors");
+    SPASM_ASSERT(spasm_bytecode_size(&bytecode) == 0, "probing should not write to the bytecode");
+    SPASM_UNUSED(code);
+
+    /* Without callback, errors are only recorded */
+    bool res = spasm_x86_64_encode_instruction(&ctx, instr, &bytecode);
+
+    SPASM_ASSERT(!res, "encoding should have failed");
+    SPASM_ASSERT(ctx.stats.num_errors == 1, "invalid errors count");
+    SPASM_ASSERT(spasm_context_get_last_error(&ctx)->code == SpasmErrorCode_UnknownInstruction,
+                 "invalid last error");
+
+    /* Formatting only happens when the callback asks for it */
+    char message[128] = { 0 };
+    spasm_context_set_error_callback(&ctx, format_error, message);
+
+    res = spasm_x86_64_encode_instruction(&ctx, instr, &bytecode);
+
+    SPASM_ASSERT(!res, "encoding should have failed");
+    SPASM_ASSERT(strcmp(message, "Cannot find encoding info for instruction: mov rax, xmm0") == 0,
+                 "invalid formatted error message");
+    SPASM_UNUSED(res);
+
+    spasm_bytecode_destroy(&bytecode);
+    spasm_instructions_destroy(&instructions);
+    spasm_context_release(&ctx);
+}
+
+void test_context_concurrent_assembling(void)
+{
+    SpasmThread threads[NUM_THREADS];
+    ThreadData threads_data[NUM_THREADS];
+
+    for(uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        spasm_context_init(&threads_data[i].ctx);
+
+        bool started = spasm_thread_start(&threads[i], assemble_thread, &threads_data[i]);
+
+        SPASM_ASSERT(started, "cannot start thread");
+        SPASM_UNUSED(started);
+    }
+
+    for(uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        spasm_thread_join(&threads[i]);
+
+        SPASM_ASSERT(threads_data[i].ok, "concurrent assembling produced invalid bytecode");
+        SPASM_ASSERT(threads_data[i].ctx.stats.num_instructions_encoded == NUM_COMPILES * 3,
+                     "invalid encoded instructions count");
+
+        spasm_context_release(&threads_data[i].ctx);
+    }
+}
+
+int main(void)
+{
+    test_context_error_callback();
+    test_context_error_record();
+    test_context_concurrent_assembling();
+
+    return 0;
+}
@@ -0,0 +1,394 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/allocator.h"
+#include "spasm/ffi.h"
+#include "spasm/platform.h"
+#include "spasm/thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_THREADS 8
+
+static uint64_t slot_double(double value)
+{
+    uint64_t slot;
+    memcpy(&slot, &value, sizeof(double));
+
+    return slot;
+}
+
+static uint64_t slot_float(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    return (uint64_t)bits;
+}
+
+static SpasmFFISignature signature_new(uint8_t return_type, uint8_t num_args, const uint8_t* arg_types)
+{
+    SpasmFFISignature signature;
+    memset(&signature, 0, sizeof(SpasmFFISignature));
+    signature.return_type = return_type;
+    signature.num_args = num_args;
+
+    if(num_args > 0)
+        memcpy(signature.arg_types, arg_types, num_args);
+
+    return signature;
+}
+
+/* Callees */
+
+static int64_t add3(int64_t a, int64_t b, int64_t c)
+{
+    return a + b * 10 + c * 100;
+}
+
+static double mix(int64_t a, double b, float c, int32_t d)
+{
+    return (double)a + b * 2.0 + (double)c * (double)d;
+}
+
+static float scale(float x, double y, float z)
+{
+    return x * (float)y - z;
+}
+
+static int64_t sum10(int64_t a0, int64_t a1, int64_t a2, int64_t a3, int64_t a4,
+                     int64_t a5, int64_t a6, int64_t a7, int64_t a8, int64_t a9)
+{
+    return a0 - a1 + a2 * 2 + a3 * 3 + a4 * 4 + a5 * 5 + a6 * 6 + a7 * 7 + a8 * 8 + a9 * 9;
+}
+
+static double poly10(double a0, int64_t a1, double a2, int64_t a3, double a4,
+                     int64_t a5, double a6, int64_t a7, double a8, float a9)
+{
+    return a0 + (double)a1 * 2.0 + a2 * 3.0 + (double)a3 * 4.0 + a4 * 5.0 +
+           (double)a5 * 6.0 + a6 * 7.0 + (double)a7 * 8.0 + a8 * 9.0 + (double)a9 * 10.0;
+}
+
+static void store(int64_t* destination, int64_t value)
+{
+    *destination = value;
+}
+
+static int64_t answer(void)
+{
+    return 42;
+}
+
+void test_executable_memory(void)
+{
+    /* mov eax, 42; ret */
+    static const uint8_t code[] = { 0xB8, 0x2A, 0x00, 0x00, 0x00, 0xC3 };
+
+    SpasmExecutableMemory memory;
+
+    bool res = spasm_executable_memory_alloc(&memory, sizeof(code));
+
+    SPASM_ASSERT(res, "cannot allocate executable memory");
+    SPASM_ASSERT(memory.size == spasm_get_page_size(), "size not rounded to the page size");
+    SPASM_UNUSED(res);
+
+    memcpy(memory.writable, code, sizeof(code));
+
+    int (*function)(void);
+    memcpy(&function, &memory.executable, sizeof(function));
+
+    int value = function();
+
+    SPASM_ASSERT(value == 42, "invalid value returned by the executable memory");
+    SPASM_UNUSED(value);
+
+    spasm_executable_memory_release(&memory);
+}
+
+void test_ffi_calls(void)
+{
+    SpasmFFICache* cache = spasm_ffi_cache_new(NULL, 0);
+
+    SPASM_ASSERT(cache != NULL, "cannot create ffi cache");
+
+    {
+        const uint8_t types[] = { SpasmFFIType_Int, SpasmFFIType_Int, SpasmFFIType_Int };
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Int, 3, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for int(int, int, int)");
+
+        const uint64_t args[] = { 1, 2, (uint64_t)-3 };
+        int64_t result = 0;
+        thunk((SpasmFFIFunction)add3, args, &result);
+
+        SPASM_ASSERT(result == add3(1, 2, -3), "invalid result for add3");
+    }
+
+    {
+        const uint8_t types[] = { SpasmFFIType_Int, SpasmFFIType_Double, SpasmFFIType_Float, SpasmFFIType_Int };
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Double, 4, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for double(int, double, float, int)");
+
+        const uint64_t args[] = { 7, slot_double(1.25), slot_float(0.5f), (uint64_t)-6 };
+        double result = 0.0;
+        thunk((SpasmFFIFunction)mix, args, &result);
+
+        SPASM_ASSERT(result == mix(7, 1.25, 0.5f, -6), "invalid result for mix");
+    }
+
+    {
+        const uint8_t types[] = { SpasmFFIType_Float, SpasmFFIType_Double, SpasmFFIType_Float };
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Float, 3, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for float(float, double, float)");
+
+        const uint64_t args[] = { slot_float(3.0f), slot_double(0.5), slot_float(0.25f) };
+        float result[2] = { 0.0f, -1.0f };
+        thunk((SpasmFFIFunction)scale, args, result);
+
+        SPASM_ASSERT(result[0] == scale(3.0f, 0.5, 0.25f), "invalid result for scale");
+        SPASM_ASSERT(result[1] == -1.0f, "float result written with more than 4 bytes");
+    }
+
+    {
+        uint8_t types[10];
+        memset(types, SpasmFFIType_Int, sizeof(types));
+
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Int, 10, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for int(int x 10)");
+
+        const uint64_t args[] = { 11, 22, 33, 44, 55, 66, 77, 88, 99, 110 };
+        int64_t result = 0;
+        thunk((SpasmFFIFunction)sum10, args, &result);
+
+        SPASM_ASSERT(result == sum10(11, 22, 33, 44, 55, 66, 77, 88, 99, 110), "invalid result for sum10");
+    }
+
+    {
+        const uint8_t types[] = {
+            SpasmFFIType_Double, SpasmFFIType_Int, SpasmFFIType_Double, SpasmFFIType_Int, SpasmFFIType_Double,
+            SpasmFFIType_Int, SpasmFFIType_Double, SpasmFFIType_Int, SpasmFFIType_Double, SpasmFFIType_Float,
+        };
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Double, 10, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for poly10");
+
+        const uint64_t args[] = {
+            slot_double(1.5), 2, slot_double(-3.5), 4, slot_double(5.5),
+            6, slot_double(7.5), 8, slot_double(9.5), slot_float(10.5f),
+        };
+        double result = 0.0;
+        thunk((SpasmFFIFunction)poly10, args, &result);
+
+        SPASM_ASSERT(result == poly10(1.5, 2, -3.5, 4, 5.5, 6, 7.5, 8, 9.5, 10.5f), "invalid result for poly10");
+    }
+
+    {
+        const uint8_t types[] = { SpasmFFIType_Int, SpasmFFIType_Int };
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Void, 2, types);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for void(int, int)");
+
+        int64_t destination = 0;
+        const uint64_t args[] = { (uint64_t)(uintptr_t)&destination, 1234 };
+        thunk((SpasmFFIFunction)store, args, NULL);
+
+        SPASM_ASSERT(destination == 1234, "invalid store through void thunk");
+    }
+
+    {
+        const SpasmFFISignature signature = signature_new(SpasmFFIType_Int, 0, NULL);
+        SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+        SPASM_ASSERT(thunk != NULL, "cannot generate thunk for int(void)");
+
+        int64_t result = 0;
+        thunk((SpasmFFIFunction)answer, NULL, &result);
+
+        SPASM_ASSERT(result == 42, "invalid result for answer");
+    }
+
+    SPASM_ASSERT(spasm_ffi_cache_size(cache) == 7, "invalid number of thunks");
+
+    spasm_ffi_cache_destroy(cache);
+}
+
+void test_ffi_cache(void)
+{
+    SpasmFFICache* cache = spasm_ffi_cache_new(NULL, 2);
+
+    SPASM_ASSERT(cache != NULL, "cannot create ffi cache");
+
+    const uint8_t types[] = { SpasmFFIType_Int, SpasmFFIType_Double };
+    SpasmFFISignature a = signature_new(SpasmFFIType_Int, 2, types);
+    SpasmFFISignature b = a;
+
+    /* Unused argument types are not part of the signature */
+    memset(b.arg_types + 2, 0xFF, SPASM_FFI_MAX_ARGS - 2);
+
+    SpasmFFIThunk thunk_a = spasm_ffi_cache_get(cache, &a);
+    SpasmFFIThunk thunk_b = spasm_ffi_cache_get(cache, &b);
+
+    SPASM_ASSERT(thunk_a != NULL, "cannot generate thunk");
+    SPASM_ASSERT(thunk_a == thunk_b, "same signature generated twice");
+    SPASM_ASSERT(spasm_ffi_cache_size(cache) == 1, "invalid number of thunks");
+
+    SpasmFFISignature c = signature_new(SpasmFFIType_Double, 2, types);
+    SpasmFFIThunk thunk_c = spasm_ffi_cache_get(cache, &c);
+
+    SPASM_ASSERT(thunk_c != NULL && thunk_c != thunk_a, "different signatures share a thunk");
+
+    SpasmFFISignature invalid = signature_new(SpasmFFIType_Int, 2, types);
+    invalid.arg_types[1] = SpasmFFIType_Void;
+
+    SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &invalid);
+    SPASM_ASSERT(thunk == NULL, "void argument accepted");
+
+    invalid = signature_new(SpasmFFIType_Int, 2, types);
+    invalid.num_args = SPASM_FFI_MAX_ARGS + 1;
+
+    thunk = spasm_ffi_cache_get(cache, &invalid);
+    SPASM_ASSERT(thunk == NULL, "too many arguments accepted");
+
+    SpasmFFISignature d = signature_new(SpasmFFIType_Void, 1, types);
+
+    thunk = spasm_ffi_cache_get(cache, &d);
+    SPASM_ASSERT(thunk == NULL, "full cache accepted a new signature");
+    thunk = spasm_ffi_cache_get(cache, &a);
+    SPASM_ASSERT(thunk == thunk_a, "full cache lost a signature");
+    SPASM_ASSERT(spasm_ffi_cache_size(cache) == 2, "invalid number of thunks");
+
+    SPASM_UNUSED(thunk);
+    SPASM_UNUSED(thunk_a);
+    SPASM_UNUSED(thunk_b);
+    SPASM_UNUSED(thunk_c);
+
+    spasm_ffi_cache_destroy(cache);
+}
+
+void test_ffi_allocator(void)
+{
+    SpasmTrackingAllocator tracking;
+    spasm_tracking_allocator_init(&tracking, NULL);
+
+    SpasmContext ctx;
+    spasm_context_init(&ctx);
+    spasm_context_set_allocator(&ctx, &tracking.allocator);
+
+    SpasmFFICache* cache = spasm_ffi_cache_new(&ctx, 0);
+
+    SPASM_ASSERT(cache != NULL, "cannot create ffi cache");
+    SPASM_ASSERT(tracking.num_allocs > 0, "the cache does not use the context allocator");
+
+    const uint8_t types[] = { SpasmFFIType_Int, SpasmFFIType_Int, SpasmFFIType_Int };
+    const SpasmFFISignature signature = signature_new(SpasmFFIType_Int, 3, types);
+    SpasmFFIThunk thunk = spasm_ffi_cache_get(cache, &signature);
+
+    SPASM_ASSERT(thunk != NULL, "cannot generate thunk for int(int, int, int)");
+
+    const uint64_t args[] = { 4, 5, 6 };
+    int64_t result = 0;
+    thunk((SpasmFFIFunction)add3, args, &result);
+
+    SPASM_ASSERT(result == add3(4, 5, 6), "invalid result for add3");
+    SPASM_UNUSED(result);
+
+    spasm_ffi_cache_destroy(cache);
+
+    SPASM_ASSERT(tracking.bytes_in_use == 0, "memory has been leaked");
+
+    spasm_context_release(&ctx);
+}
+
+/* Threads */
+
+#define NUM_SHARED_SIGNATURES 32
+
+typedef struct
+{
+    SpasmFFICache* cache;
+    SpasmFFIThunk thunks[NUM_SHARED_SIGNATURES];
+    int64_t result;
+} ThreadData;
+
+/* Signatures made of i % 8 Int arguments, returning Int, Float, Double or Void */
+static SpasmFFISignature shared_signature(uint32_t i)
+{
+    uint8_t types[8];
+    memset(types, SpasmFFIType_Int, sizeof(types));
+
+    return signature_new((uint8_t)(i / 8), (uint8_t)(i % 8), types);
+}
+
+static void thread_func(void* arg)
+{
+    ThreadData* data = (ThreadData*)arg;
+
+    for(uint32_t i = 0; i < NUM_SHARED_SIGNATURES; i++)
+    {
+        const SpasmFFISignature signature = shared_signature(i);
+        data->thunks[i] = spasm_ffi_cache_get(data->cache, &signature);
+    }
+
+    /* Int(Int, Int, Int) */
+    const uint64_t args[] = { 1, 2, 3 };
+    data->thunks[SpasmFFIType_Int * 8 + 3]((SpasmFFIFunction)add3, args, &data->result);
+}
+
+void test_ffi_threads(void)
+{
+    SpasmFFICache* cache = spasm_ffi_cache_new(NULL, NUM_SHARED_SIGNATURES);
+
+    SPASM_ASSERT(cache != NULL, "cannot create ffi cache");
+
+    SpasmThread threads[NUM_THREADS];
+    ThreadData data[NUM_THREADS];
+    memset(data, 0, sizeof(data));
+
+    for(uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        data[i].cache = cache;
+
+        bool res = spasm_thread_start(&threads[i], thread_func, &data[i]);
+
+        SPASM_ASSERT(res, "cannot start thread");
+        SPASM_UNUSED(res);
+    }
+
+    for(uint32_t i = 0; i < NUM_THREADS; i++)
+        spasm_thread_join(&threads[i]);
+
+    SPASM_ASSERT(spasm_ffi_cache_size(cache) == NUM_SHARED_SIGNATURES, "signatures generated more than once");
+
+    for(uint32_t i = 0; i < NUM_THREADS; i++)
+    {
+        SPASM_ASSERT(data[i].result == add3(1, 2, 3), "invalid result in thread");
+
+        for(uint32_t j = 0; j < NUM_SHARED_SIGNATURES; j++)
+            SPASM_ASSERT(data[i].thunks[j] != NULL && data[i].thunks[j] == data[0].thunks[j],
+                         "threads got different thunks for the same signature");
+    }
+
+    spasm_ffi_cache_destroy(cache);
+}
+
+int main(void)
+{
+    test_executable_memory();
+    test_ffi_calls();
+    test_ffi_cache();
+    test_ffi_allocator();
+    test_ffi_threads();
+
+    return 0;
+}
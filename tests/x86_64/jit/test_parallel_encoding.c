@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+#include "spasm/context.h"
+#include "spasm/instruction.h"
+#include "spasm/operand.h"
+#include "spasm/platform.h"
+#include "spasm/x86_64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_INSTRUCTIONS 40000
+
+static void push_stream(SpasmInstructions* instructions, size_t invalid_at)
+{
+    for(size_t i = 0; i < NUM_INSTRUCTIONS; i++)
+    {
+        if(i == invalid_at)
+        {
+            spasm_instructions_push_back(instructions,
+                                         "mov",
+                                         SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                         SpasmOpReg(SpasmRegister_x86_64_XMM0));
+            continue;
+        }
+
+        switch(i % 5)
+        {
+            case 0:
+                spasm_instructions_push_back(instructions,
+                                             "mov",
+                                             SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                             SpasmOpImm32((int32_t)i));
+                break;
+            case 1:
+                spasm_instructions_push_back(instructions,
+                                             "add",
+                                             SpasmOpReg(SpasmRegister_x86_64_RAX),
+                                             SpasmOpReg(SpasmRegister_x86_64_RBX));
+                break;
+            case 2:
+                spasm_instructions_push_back(instructions,
+                                             "mov",
+                                             SpasmOpReg(SpasmRegister_x86_64_RCX),
+                                             SpasmOpMemory(SpasmRegister_x86_64_RBX, 0, 0, 1));
+                break;
+            case 3:
+                spasm_instructions_push_back(instructions,
+                                             "movaps",
+                                             SpasmOpReg(SpasmRegister_x86_64_XMM1),
+                                             SpasmOpReg(SpasmRegister_x86_64_XMM2));
+                break;
+            default:
+                spasm_instructions_push_backz(instructions, "syscall");
+                break;
+        }
+    }
+}
+
+static void count_errors(const SpasmError* error, void* user_data)
+{
+    SPASM_UNUSED(error);
+
+    (*(uint32_t*)user_data)++;
+}
+
+typedef struct
+{
+    SpasmContext ctx;
+    SpasmByteCode bytecode;
+    size_t* offsets;
+    uint32_t num_errors;
+    bool res;
+} EncodingResult;
+
+static void encode_stream(EncodingResult* result, uint32_t max_threads, size_t invalid_at)
+{
+    spasm_context_init(&result->ctx);
+    spasm_context_set_max_encoding_threads(&result->ctx, max_threads);
+    spasm_context_set_error_callback(&result->ctx, count_errors, &result->num_errors);
+
+    result->num_errors = 0;
+    result->bytecode = spasm_bytecode_new(&result->ctx);
+    result->offsets = (size_t*)calloc(NUM_INSTRUCTIONS, sizeof(size_t));
+
+    SpasmInstructions instructions = spasm_instructions_new(&result->ctx);
+
+    push_stream(&instructions, invalid_at);
+
+    result->res = spasm_x86_64_encode_instructions(&result->ctx,
+                                                   &instructions,
+                                                   &result->bytecode,
+                                                   result->offsets);
+
+    spasm_instructions_destroy(&instructions);
+}
+
+static void release_result(EncodingResult* result)
+{
+    free(result->offsets);
+    spasm_bytecode_destroy(&result->bytecode);
+    spasm_context_release(&result->ctx);
+}
+
+static bool results_equal(EncodingResult* a, EncodingResult* b)
+{
+    size_t a_size = 0;
+    size_t b_size = 0;
+
+    const SpasmByte* a_bytes = spasm_bytecode_get(&a->bytecode, &a_size);
+    const SpasmByte* b_bytes = spasm_bytecode_get(&b->bytecode, &b_size);
+
+    return a->res == b->res &&
+           a_size == b_size &&
+           memcmp(a_bytes, b_bytes, a_size) == 0 &&
+           (!a->res || memcmp(a->offsets, b->offsets, NUM_INSTRUCTIONS * sizeof(size_t)) == 0) &&
+           a->num_errors == b->num_errors &&
+           a->ctx.stats.num_instructions_encoded == b->ctx.stats.num_instructions_encoded &&
+           a->ctx.stats.num_bytes_encoded == b->ctx.stats.num_bytes_encoded;
+}
+
+void test_parallel_encoding_identical(void)
+{
+    EncodingResult sequential;
+    encode_stream(&sequential, 1, (size_t)-1);
+
+    SPASM_ASSERT(sequential.res, "sequential encoding failed");
+    SPASM_ASSERT(sequential.offsets[NUM_INSTRUCTIONS - 1] == spasm_bytecode_size(&sequential.bytecode),
+                 "invalid last instruction offset");
+
+    const uint32_t threads_counts[] = { 2, 3, 4, spasm_get_num_cpus() };
+
+    for(size_t i = 0; i < sizeof(threads_counts) / sizeof(threads_counts[0]); i++)
+    {
+        EncodingResult parallel;
+        encode_stream(&parallel, threads_counts[i], (size_t)-1);
+
+        const bool equal = results_equal(&sequential, &parallel);
+        SPASM_ASSERT(equal, "parallel encoding differs from the sequential encoding");
+        SPASM_UNUSED(equal);
+
+        release_result(&parallel);
+    }
+
+    release_result(&sequential);
+}
+
+void test_parallel_encoding_error(void)
+{
+    /* Fails in the middle of a chunk that is not the first one */
+    const size_t invalid_at = NUM_INSTRUCTIONS - NUM_INSTRUCTIONS / 3;
+
+    EncodingResult sequential;
+    encode_stream(&sequential, 1, invalid_at);
+
+    EncodingResult parallel;
+    encode_stream(&parallel, 8, invalid_at);
+
+    SPASM_ASSERT(!sequential.res, "sequential encoding should have failed");
+    SPASM_ASSERT(sequential.num_errors == 1, "invalid errors count");
+    SPASM_ASSERT(sequential.ctx.stats.num_instructions_encoded == invalid_at,
+                 "invalid encoded instructions count");
+    const bool equal = results_equal(&sequential, &parallel);
+    SPASM_ASSERT(equal, "parallel encoding error differs from the sequential encoding error");
+    SPASM_UNUSED(equal);
+
+    release_result(&parallel);
+    release_result(&sequential);
+}
+
+int main(void)
+{
+    test_parallel_encoding_identical();
+    test_parallel_encoding_error();
+
+    return 0;
+}
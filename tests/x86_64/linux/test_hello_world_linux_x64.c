@@ -21,7 +21,7 @@ int main(void)
 
     SpasmData data;
 
-    if(!spasm_data_init(&data))
+    if(!spasm_data_init(&data, NULL))
     {
         spasm_error("Error while initializing data");
         return 1;
@@ -33,7 +33,7 @@ int main(void)
                          14,
                          SpasmDataType_ROData);
 
-    SpasmInstructions instructions = spasm_instructions_new();
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
 
     /* Print "Hello, World!" to stdout */
     spasm_instructions_push_back(&instructions,
@@ -69,7 +69,7 @@ int main(void)
 
     spasm_instructions_debug(&instructions, abi, 1);
 
-    SpasmByteCode bytecode = spasm_bytecode_new();
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
 
     if(!assembler(&instructions, &bytecode, &data))
     {
@@ -87,7 +87,7 @@ int main(void)
 
     spasm_bytecode_debug(&bytecode);
 
-    SPASM_ASSERT(vector_size(&bytecode.data) == result_size,
+    SPASM_ASSERT(spasm_bytecode_size(&bytecode) == result_size,
                  "Invalid bytecode size");
 
     spasm_data_release(&data);
@@ -20,7 +20,7 @@ int main(void)
 
     SpasmData data;
 
-    if(!spasm_data_init(&data))
+    if(!spasm_data_init(&data, NULL))
     {
         spasm_error("Error while initializing data");
         return 1;
@@ -32,7 +32,7 @@ int main(void)
                          14,
                          SpasmDataType_Data);
 
-    SpasmInstructions instructions = spasm_instructions_new();
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
 
     /* Exit */
     spasm_instructions_push_back(&instructions,
@@ -49,7 +49,7 @@ int main(void)
 
     spasm_instructions_debug(&instructions, abi, 1);
 
-    SpasmByteCode bytecode = spasm_bytecode_new();
+    SpasmByteCode bytecode = spasm_bytecode_new(NULL);
 
     if(!assembler(&instructions, &bytecode, &data))
     {
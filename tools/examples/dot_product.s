@@ -0,0 +1,9 @@
+; Dot product of two float arrays, 8 floats per iteration
+; rdi: a, rsi: b, rcx: index, rdx: count
+
+loop:
+    vmovups ymm1, ymmword ptr [rdi + rcx*4]
+    vfmadd231ps ymm0, ymm1, ymmword ptr [rsi + rcx*4]
+    add rcx, 8
+    cmp rcx, rdx
+    jne loop
@@ -0,0 +1,389 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright (c) 2025 - Present Romain Augier */
+/* All rights reserved. */
+
+/*
+    Command line front end of spasm_x86_64_analyze:
+
+        spasm_analyze [--uarch generic|skylake|zen4] [--iterations N] file
+
+    The file holds the loop body, one instruction per line in Intel syntax:
+
+        loop:
+            vfmadd231ps ymm0, ymm1, ymmword ptr [rdi + rcx*4]
+            add rcx, 8      ; comments start with ; or #
+            cmp rcx, rdx
+            jne loop
+
+    Operands are registers, immediates, memory operands ([base + index*scale + disp], size
+    keywords are ignored) and labels
+*/
+
+#include "spasm/context.h"
+#include "spasm/mnemonic.h"
+#include "spasm/register.h"
+#include "spasm/x86_64.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE_SIZE 512
+#define MAX_LABELS 256
+
+typedef struct
+{
+    char names[MAX_LABELS][64];
+    SpasmLabel labels[MAX_LABELS];
+    size_t num_labels;
+} Labels;
+
+static SpasmLabel get_label(Labels* labels, SpasmInstructions* instructions, const char* name)
+{
+    for(size_t i = 0; i < labels->num_labels; i++)
+        if(strcmp(labels->names[i], name) == 0)
+            return labels->labels[i];
+
+    if(labels->num_labels == MAX_LABELS)
+        return (SpasmLabel)UINT32_MAX;
+
+    snprintf(labels->names[labels->num_labels], sizeof(labels->names[0]), "%s", name);
+    labels->labels[labels->num_labels] = spasm_instructions_new_label(instructions);
+
+    return labels->labels[labels->num_labels++];
+}
+
+static char* trim(char* s)
+{
+    while(isspace((unsigned char)*s))
+        s++;
+
+    size_t size = strlen(s);
+
+    while(size > 0 && isspace((unsigned char)s[size - 1]))
+        s[--size] = '\0';
+
+    return s;
+}
+
+static bool parse_integer(const char* s, int64_t* value)
+{
+    char* end = NULL;
+
+    *value = (int64_t)strtoll(s, &end, 0);
+
+    return end != s && *trim(end) == '\0';
+}
+
+static SpasmOperand immediate_operand(int64_t value)
+{
+    if(value >= INT8_MIN && value <= INT8_MAX)
+        return SpasmOpImm8(value);
+
+    if(value >= INT32_MIN && value <= INT32_MAX)
+        return SpasmOpImm32(value);
+
+    return SpasmOpImm64(value);
+}
+
+/* [base + index*scale + disp], terms can come in any order */
+static bool parse_memory(char* s, SpasmOperand* operand)
+{
+    uint8_t base = 0;
+    uint8_t index = 0;
+    uint8_t scale = 0;
+    int64_t displacement = 0;
+
+    char* term = s;
+    bool negative = false;
+
+    while(*term != '\0')
+    {
+        char* next = term + strcspn(term, "+-");
+        const bool next_negative = *next == '-';
+
+        if(*next != '\0')
+            *next++ = '\0';
+
+        char* name = trim(term);
+        char* star = strchr(name, '*');
+
+        if(star != NULL)
+        {
+            *star = '\0';
+
+            int64_t factor = 0;
+
+            if(!parse_integer(trim(star + 1), &factor))
+                return false;
+
+            const SpasmRegister reg = spasm_register_from_string(trim(name));
+
+            if(reg == SpasmRegister_Invalid)
+                return false;
+
+            index = (uint8_t)reg;
+            scale = (uint8_t)factor;
+        }
+        else if(*name != '\0')
+        {
+            int64_t value = 0;
+
+            if(parse_integer(name, &value))
+            {
+                displacement += negative ? -value : value;
+            }
+            else
+            {
+                const SpasmRegister reg = spasm_register_from_string(name);
+
+                if(reg == SpasmRegister_Invalid)
+                    return false;
+
+                if(base == 0)
+                {
+                    base = (uint8_t)reg;
+                }
+                else
+                {
+                    index = (uint8_t)reg;
+                    scale = 1;
+                }
+            }
+        }
+
+        negative = next_negative;
+        term = next;
+    }
+
+    *operand = SpasmOpMemory(base, index, displacement, scale);
+
+    return true;
+}
+
+static bool parse_operand(char* s, Labels* labels, SpasmInstructions* instructions, SpasmOperand* operand)
+{
+    static const char* size_keywords[] = { "byte", "word", "dword", "qword", "xmmword", "ymmword", "zmmword", "ptr" };
+
+    s = trim(s);
+
+    /* Size keywords are ignored, the first form matching the other operands is taken */
+    bool skipped = true;
+
+    while(skipped)
+    {
+        skipped = false;
+
+        for(size_t i = 0; i < sizeof(size_keywords) / sizeof(size_keywords[0]); i++)
+        {
+            const size_t size = strlen(size_keywords[i]);
+
+            if(strncmp(s, size_keywords[i], size) == 0 && isspace((unsigned char)s[size]))
+            {
+                s = trim(s + size);
+                skipped = true;
+            }
+        }
+    }
+
+    if(*s == '[')
+    {
+        char* end = strchr(s, ']');
+
+        if(end == NULL)
+            return false;
+
+        *end = '\0';
+
+        return parse_memory(s + 1, operand);
+    }
+
+    int64_t value = 0;
+
+    if(parse_integer(s, &value))
+    {
+        *operand = immediate_operand(value);
+        return true;
+    }
+
+    const SpasmRegister reg = spasm_register_from_string(s);
+
+    if(reg != SpasmRegister_Invalid)
+    {
+        *operand = SpasmOpReg(reg);
+        return true;
+    }
+
+    const SpasmLabel label = get_label(labels, instructions, s);
+
+    if(label == (SpasmLabel)UINT32_MAX)
+        return false;
+
+    *operand = SpasmOpLabel(label);
+
+    return true;
+}
+
+/* Immediates are parsed with the smallest size, widened until a form matches */
+static void widen_immediates(SpasmInstruction* instr)
+{
+    for(uint8_t i = 0; i < instr->num_operands; i++)
+    {
+        SpasmOperand* operand = &instr->operands[i];
+
+        if(operand->type < SpasmOperandType_Imm8 || operand->type > SpasmOperandType_Imm64)
+            continue;
+
+        while(spasm_x86_64_instruction_access(instr) == NULL && operand->type < SpasmOperandType_Imm64)
+            operand->type++;
+
+        if(spasm_x86_64_instruction_access(instr) == NULL)
+            operand->type = immediate_operand(operand->imm_value).type;
+    }
+}
+
+static bool parse_line(char* line, size_t line_number, Labels* labels, SpasmInstructions* instructions)
+{
+    line[strcspn(line, ";#")] = '\0';
+
+    for(char* c = line; *c != '\0'; c++)
+        *c = (char)tolower((unsigned char)*c);
+
+    line = trim(line);
+
+    if(*line == '\0')
+        return true;
+
+    const size_t size = strlen(line);
+
+    if(line[size - 1] == ':')
+    {
+        line[size - 1] = '\0';
+
+        const SpasmLabel label = get_label(labels, instructions, trim(line));
+
+        return label != (SpasmLabel)UINT32_MAX && spasm_instructions_bind_label(instructions, label);
+    }
+
+    const size_t mnemonic_size = strcspn(line, " \t");
+
+    SpasmInstruction instr;
+    memset(&instr, 0, sizeof(SpasmInstruction));
+
+    instr.mnemonic = (uint16_t)spasm_mnemonic_from_string(line, mnemonic_size);
+
+    if(instr.mnemonic == SpasmMnemonic_Invalid)
+    {
+        fprintf(stderr, "line %zu: unknown mnemonic \"%.*s\"\n", line_number, (int)mnemonic_size, line);
+        return false;
+    }
+
+    char* operands = trim(line + mnemonic_size);
+
+    while(*operands != '\0')
+    {
+        /* Commas inside brackets do not split operands */
+        char* end = operands;
+
+        while(*end != '\0' && *end != ',')
+            end = *end == '[' && strchr(end, ']') != NULL ? strchr(end, ']') + 1 : end + 1;
+
+        const bool last = *end == '\0';
+        *end = '\0';
+
+        if(instr.num_operands == SPASM_MAX_OPERANDS ||
+           !parse_operand(operands, labels, instructions, &instr.operands[instr.num_operands]))
+        {
+            fprintf(stderr, "line %zu: invalid operand \"%s\"\n", line_number, trim(operands));
+            return false;
+        }
+
+        instr.num_operands++;
+        operands = last ? end : end + 1;
+    }
+
+    widen_immediates(&instr);
+
+    return spasm_instructions_push_array(instructions,
+                                         (SpasmMnemonic)instr.mnemonic,
+                                         instr.operands,
+                                         instr.num_operands);
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: spasm_analyze [--uarch generic|skylake|zen4] [--iterations N] file\n");
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    Spasm_x86_64_AnalysisConfig config = { Spasm_x86_64_Uarch_Generic, 0 };
+    const char* path = NULL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--uarch") == 0 && i + 1 < argc)
+        {
+            config.uarch = spasm_x86_64_uarch_from_string(argv[++i]);
+
+            if(config.uarch == Spasm_x86_64_Uarch_COUNT)
+            {
+                fprintf(stderr, "unknown microarchitecture \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            config.num_iterations = (size_t)strtoull(argv[++i], NULL, 10);
+        }
+        else if(argv[i][0] != '-' && path == NULL)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if(path == NULL)
+        return usage();
+
+    FILE* file = fopen(path, "r");
+
+    if(file == NULL)
+    {
+        fprintf(stderr, "cannot open \"%s\"\n", path);
+        return 1;
+    }
+
+    SpasmInstructions instructions = spasm_instructions_new(NULL);
+
+    Labels* labels = (Labels*)calloc(1, sizeof(Labels));
+
+    char line[MAX_LINE_SIZE];
+    size_t line_number = 0;
+    bool res = labels != NULL;
+
+    while(res && fgets(line, sizeof(line), file) != NULL)
+        res = parse_line(line, ++line_number, labels, &instructions);
+
+    fclose(file);
+    free(labels);
+
+    Spasm_x86_64_Analysis analysis;
+
+    res = res && spasm_x86_64_analyze(NULL, &instructions, &config, &analysis);
+
+    if(res)
+    {
+        spasm_x86_64_analysis_print(&analysis, &instructions, stdout);
+        spasm_x86_64_analysis_release(&analysis);
+    }
+
+    spasm_instructions_destroy(&instructions);
+
+    return res ? 0 : 1;
+}
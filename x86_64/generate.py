@@ -6,12 +6,20 @@
 
 # relies on https://github.com/Maratyszcza/Opcodes
 # pip install Opcodes
+# Without it, the forms are read back from a forms file written by a previous run (-i/--input-forms),
+# and all the other outputs are generated from them
+
+from __future__ import annotations
 
 import sys
 import os
 import optparse
 from typing import List, Tuple, Optional, Any
-from opcodes import x86_64
+
+try:
+    from opcodes import x86_64
+except ImportError:
+    x86_64 = None
 
 def map_operand_type(operand: x86_64.Operand) -> str:
     if not operand:
@@ -83,10 +91,13 @@ def parse_opcode(opcode: str) -> Tuple[List[str], bool]:
 
     return b, needs_modrm
 
+# pp values of the mandatory prefixes, as in VEX and EVEX
+mandatory_prefixes_pp = { 0x66: "0x01", 0xF3: "0x02", 0xF2: "0x03" }
+
 def has_prefix(t: Any, l: List[Any]) -> bool:
     return any([isinstance(x, t) for x in l])
 
-def parse_encoding(encoding: x86_64.Encoding, first_operand_is_reg: bool) -> Tuple[List[str], bool, str, str, bool, Optional[int], Optional[int], bool]:
+def parse_encoding(encoding: x86_64.Encoding, operands: List[x86_64.Operand], first_operand_is_reg: bool) -> Tuple[List[str], bool, str, str, bool, Optional[int], Optional[int], bool]:
     # Returns: opcode, needs_modrm, modrm_reg, prefix_type, pp, uses_register_byte
 
     opcode = list()
@@ -102,6 +113,10 @@ def parse_encoding(encoding: x86_64.Encoding, first_operand_is_reg: bool) -> Tup
     for component in encoding.components:
         if isinstance(component, x86_64.Opcode):
             opcode.append("0x" + f"{component.byte:02X}")
+
+            # +rb/+rw/+rd/+rq forms (push, pop, bswap, mov r, imm) add the register to the opcode
+            if component.addend is not None:
+                reg_in_opcode = True
         elif isinstance(component, x86_64.RegisterByte):
             reg_in_opcode = True
         elif isinstance(component, x86_64.ModRM):
@@ -109,8 +124,11 @@ def parse_encoding(encoding: x86_64.Encoding, first_operand_is_reg: bool) -> Tup
 
             if isinstance(component.reg, int):
                 modrm_reg_operand = component.reg
-            if isinstance(component.rm, int):
-                modrm_rm_operand = component.rm
+
+            # ModR/M.rm references one of the operands
+            for i, operand in enumerate(operands):
+                if operand is component.rm:
+                    modrm_rm_operand = i
         elif isinstance(component, x86_64.REX):
             if component.W:
                 forces_rex_w = True
@@ -130,6 +148,16 @@ def parse_encoding(encoding: x86_64.Encoding, first_operand_is_reg: bool) -> Tup
     elif has_prefix(x86_64.REX, encoding.components):
         prefix = "Spasm_x86_64_PrefixType_REX"
 
+    # Legacy forms have no use for pp, it holds their mandatory prefix with the VEX values (66, F3, F2)
+    if prefix in ("Spasm_x86_64_PrefixType_NONE", "Spasm_x86_64_PrefixType_REX"):
+        for component in encoding.components:
+            if isinstance(component, x86_64.Prefix) and component.is_mandatory:
+                pp = mandatory_prefixes_pp.get(component.byte, pp)
+
+    # The encoder places the ModR/M operands of VEX and EVEX forms by their position
+    if prefix not in ("Spasm_x86_64_PrefixType_NONE", "Spasm_x86_64_PrefixType_REX"):
+        modrm_rm_operand = None
+
     return opcode, needs_modrm, prefix, pp, reg_in_opcode, modrm_reg_operand, modrm_rm_operand, forces_rex_w
 
 cpu_flag_map = {
@@ -180,7 +208,266 @@ def map_cpu_flag(isa: List[x86_64.ISAExtension]) -> str:
 def get_x86_64_instructions() -> List[x86_64.Instruction]:
     return x86_64.read_instruction_set()
 
-def generate_c_file(output_c_file_path: str) -> bool:
+def mnemonic_enum_name(mnemonic: str) -> str:
+    return f"SpasmMnemonic_x86_64_{mnemonic.upper()}"
+
+def generate_mnemonics_header(output_h_file_path: str, mnemonics: List[str]) -> bool:
+    with open(output_h_file_path, "w", encoding="utf-8") as f:
+        f.write("/* SPDX-License-Identifier: BSD-3-Clause */\n")
+        f.write("/* Copyright (c) 2025 - Present Romain Augier */\n")
+        f.write("/* All rights reserved. */\n")
+        f.write("\n")
+        f.write("/* Auto-generated file, don't modify it */\n")
+        f.write("\n")
+        f.write("#pragma once\n")
+        f.write("\n")
+        f.write("#if !defined(__SPASM_X86_64_MNEMONICS)\n")
+        f.write("#define __SPASM_X86_64_MNEMONICS\n")
+        f.write("\n")
+        f.write(f"#define SPASM_X86_64_NUM_MNEMONICS {len(mnemonics)}\n")
+        f.write("\n")
+        f.write("/* X(enum suffix, mnemonic string), sorted by mnemonic */\n")
+        f.write("#define SPASM_X86_64_MNEMONICS(X) \\\n")
+
+        for mnemonic in mnemonics:
+            f.write(f"    X({mnemonic.upper()}, \"{mnemonic}\") \\\n")
+
+        f.write("\n")
+        f.write("#endif /* !defined(__SPASM_X86_64_MNEMONICS) */\n")
+
+    return True
+
+emit_register_kinds = {
+    8: "r8",
+    16: "r16",
+    32: "r32",
+    64: "r64",
+    128: "xmm",
+    256: "ymm",
+    512: "zmm",
+    0: "reg", # opmask, mmx... registers, their size is not checked by the encoder
+}
+
+emit_immediate_types = {
+    "OP_IMM8": ("imm8", "rel8", "int8_t", 8),
+    "OP_IMM16": ("imm16", "rel16", "int16_t", 16),
+    "OP_IMM32": ("imm32", "rel32", "int32_t", 32),
+    "OP_IMM64": ("imm64", "rel64", "int64_t", 64),
+}
+
+def emit_operand_kind(operand_type: str, operand_size: int) -> str:
+    if operand_type == "OP_REG":
+        return emit_register_kinds[operand_size]
+    elif operand_type == "OP_MEM":
+        return "m"
+    else:
+        imm_kind, rel_kind, _, _ = emit_immediate_types[operand_type]
+        return imm_kind if operand_size != 0 else rel_kind
+
+def resolve_emit_form(instructions: List[dict], first_form: int, index: int) -> Optional[int]:
+    # Returns the form the encoder would match for operands of the kinds of the given form, so
+    # builders encode exactly as the generic push does. None if it depends on the register
+    # passed (a size-less register matched by an earlier sized form)
+
+    form = instructions[index]
+    num_operands = sum(1 for t in form["operand_types"] if t != "OP_NONE")
+
+    for i in range(first_form, index + 1):
+        candidate = instructions[i]
+
+        match = True
+
+        for j in range(num_operands):
+            operand_type = form["operand_types"][j]
+            operand_size = int(form["operand_sizes"][j])
+            candidate_size = int(candidate["operand_sizes"][j])
+
+            if candidate["operand_types"][j] != operand_type:
+                match = False
+                break
+
+            if operand_type == "OP_MEM" or candidate_size == 0:
+                continue
+
+            if operand_type == "OP_REG" and operand_size == 0:
+                return None
+
+            if operand_type == "OP_REG" and operand_size != candidate_size:
+                match = False
+                break
+
+            if operand_type in emit_immediate_types and emit_immediate_types[operand_type][3] != candidate_size:
+                match = False
+                break
+
+        if match:
+            return i
+
+    return index
+
+def generate_emit_header(output_emit_file_path: str, instructions: List[dict]) -> bool:
+    with open(output_emit_file_path, "w", encoding="utf-8") as f:
+        f.write("/* SPDX-License-Identifier: BSD-3-Clause */\n")
+        f.write("/* Copyright (c) 2025 - Present Romain Augier */\n")
+        f.write("/* All rights reserved. */\n")
+        f.write("\n")
+        f.write("/* Auto-generated file, don't modify it */\n")
+        f.write("\n")
+        f.write("#if defined(SPASM_ENABLE_X86_64)\n")
+        f.write("\n")
+        f.write("#pragma once\n")
+        f.write("\n")
+        f.write("#if !defined(__SPASM_X86_64_EMIT)\n")
+        f.write("#define __SPASM_X86_64_EMIT\n")
+        f.write("\n")
+        f.write("#include \"spasm/instruction.h\"\n")
+        f.write("#include \"spasm/register.h\"\n")
+        f.write("\n")
+        f.write("#include <stdlib.h>\n")
+        f.write("\n")
+        f.write("/*\n")
+        f.write("    Typed instruction builders, one per mnemonic and operand kinds:\n")
+        f.write("    spasm_x86_64_<mnemonic>_<kinds>(instructions, operands...), with r8/r16/r32/r64/xmm/ymm/zmm\n")
+        f.write("    registers (reg for the other register files), m memory operands (SpasmOpMemory), and\n")
+        f.write("    imm/rel immediates passed as integers.\n")
+        f.write("    The instruction is recorded with its form already resolved, so the encoder does not match\n")
+        f.write("    the operands. Register widths and memory operands are checked in debug builds only, all the\n")
+        f.write("    registers sharing the SpasmRegister type. Data and symbol operands need the generic pushes\n")
+        f.write("*/\n")
+        f.write("\n")
+        f.write("#define SPASM_X86_64_EMIT_BEGIN(mnemonic, form, num_operands)                              \\\n")
+        f.write("    SpasmInstruction* instr = spasm_instructions_push_form(instructions,                  \\\n")
+        f.write("                                                           SpasmMnemonic_x86_64_##mnemonic, \\\n")
+        f.write("                                                           (uint16_t)(form),                \\\n")
+        f.write("                                                           (uint8_t)(num_operands));        \\\n")
+        f.write("    if(instr == NULL)                                                                     \\\n")
+        f.write("        return false;\n")
+        f.write("\n")
+        f.write("#define SPASM_X86_64_EMIT_REG(index, r, size)                                               \\\n")
+        f.write("    SPASM_ASSERT((size) == 0 || (8u << (((r) - 1) / 16)) == (size), \"invalid register size\"); \\\n")
+        f.write("    instr->operands[index] = SpasmOpReg(r);\n")
+        f.write("\n")
+        f.write("#define SPASM_X86_64_EMIT_MEM(index, m)                                        \\\n")
+        f.write("    SPASM_ASSERT((m).type == SpasmOperandType_Mem, \"invalid memory operand\"); \\\n")
+        f.write("    instr->operands[index] = (m);\n")
+        f.write("\n")
+        f.write("#define SPASM_X86_64_EMIT_IMM(index, bits, value) \\\n")
+        f.write("    instr->operands[index] = SpasmOpImm##bits(value);\n")
+        f.write("\n")
+
+        emitted = set()
+        num_builders = 0
+
+        first_form = 0
+
+        for index, instruction in enumerate(instructions):
+            if index > 0 and instructions[index - 1]["mnemonic"] != instruction["mnemonic"]:
+                first_form = index
+
+            operands = [(t, int(s)) for t, s in zip(instruction["operand_types"], instruction["operand_sizes"]) if t != "OP_NONE"]
+
+            name = "_".join(["spasm_x86_64", instruction["mnemonic"]] + [emit_operand_kind(t, s) for t, s in operands])
+
+            if name in emitted:
+                continue
+
+            form = resolve_emit_form(instructions, first_form, index)
+
+            if form is None:
+                continue
+
+            emitted.add(name)
+            num_builders += 1
+
+            params = ["SpasmInstructions* instructions"]
+            body = [f"    SPASM_X86_64_EMIT_BEGIN({instruction['mnemonic'].upper()}, {form + 1}, {len(operands)})"]
+
+            for i, (t, s) in enumerate(operands):
+                if t == "OP_REG":
+                    params.append(f"SpasmRegister op{i}")
+                    body.append(f"    SPASM_X86_64_EMIT_REG({i}, op{i}, {s})")
+                elif t == "OP_MEM":
+                    params.append(f"SpasmOperand op{i}")
+                    body.append(f"    SPASM_X86_64_EMIT_MEM({i}, op{i})")
+                else:
+                    params.append(f"{emit_immediate_types[t][2]} op{i}")
+                    body.append(f"    SPASM_X86_64_EMIT_IMM({i}, {emit_immediate_types[t][3]}, op{i})")
+
+            f.write(f"static SPASM_FORCE_INLINE bool {name}({', '.join(params)})\n")
+            f.write("{\n")
+            f.write("\n".join(body) + "\n")
+            f.write("    return true;\n")
+            f.write("}\n")
+            f.write("\n")
+
+        f.write(f"#define SPASM_X86_64_NUM_EMIT_BUILDERS {num_builders}\n")
+        f.write("\n")
+        f.write("#undef SPASM_X86_64_EMIT_IMM\n")
+        f.write("#undef SPASM_X86_64_EMIT_MEM\n")
+        f.write("#undef SPASM_X86_64_EMIT_REG\n")
+        f.write("#undef SPASM_X86_64_EMIT_BEGIN\n")
+        f.write("\n")
+        f.write("#endif /* !defined(__SPASM_X86_64_EMIT) */\n")
+        f.write("\n")
+        f.write("#endif /* defined(SPASM_ENABLE_X86_64) */\n")
+
+    return True
+
+forms_operand_types = {
+    "OP_NONE": "None",
+    "OP_REG": "Register",
+    "OP_MEM": "Mem",
+    "OP_IMM8": "Imm8",
+    "OP_IMM16": "Imm16",
+    "OP_IMM32": "Imm32",
+    "OP_IMM64": "Imm64",
+}
+
+def generate_forms_file(output_forms_file_path: str, instructions: List[dict]) -> bool:
+    # One SPASM_X86_64_FORM(...) row per form, in the instruction table order, for the C table and
+    # the C++ constexpr encoder
+
+    with open(output_forms_file_path, "w", encoding="utf-8") as f:
+        f.write("/* SPDX-License-Identifier: BSD-3-Clause */\n")
+        f.write("/* Copyright (c) 2025 - Present Romain Augier */\n")
+        f.write("/* All rights reserved. */\n")
+        f.write("\n")
+        f.write("/* Auto-generated file, don't modify it */\n")
+        f.write("\n")
+        f.write("/*\n")
+        f.write("    x86_64 instruction forms, sorted by mnemonic. No include guard, define SPASM_X86_64_FORM\n")
+        f.write("    before including it:\n")
+        f.write("    SPASM_X86_64_FORM(mnemonic, 4 operand types, 4 operand sizes, 4 opcode bytes, opcode_len,\n")
+        f.write("                      needs_modrm, prefix, pp, mmmmm, cpu_flag, reg_in_opcode, reg_in_modrm_reg,\n")
+        f.write("                      modrm_reg_operand, reg_in_modrm_rm, modrm_rm_operand, force_rex_w)\n")
+        f.write("*/\n")
+        f.write("\n")
+
+        for instruction in instructions:
+            opcode = instruction["opcode"] + ["0x00"] * (4 - len(instruction["opcode"]))
+
+            row = [instruction["mnemonic"].upper()]
+            row += [forms_operand_types[t] for t in instruction["operand_types"]]
+            row += instruction["operand_sizes"]
+            row += opcode
+            row.append(str(len(instruction["opcode"])))
+            row.append(str(instruction["needs_modrm"]).lower())
+            row.append(instruction["prefix"].replace("Spasm_x86_64_PrefixType_", ""))
+            row.append(instruction["pp"])
+            row.append(instruction["mmmmm"])
+            row.append(instruction["cpu_flag"].replace("Spasm_x86_64_CPUFlag_", ""))
+            row.append(str(instruction["reg_in_opcode"]).lower())
+            row.append(str(instruction["reg_in_modrm_reg"]).lower())
+            row.append(str(instruction["modrm_reg_operand"]))
+            row.append(str(instruction["reg_in_modrm_rm"]).lower())
+            row.append(str(instruction["modrm_rm_operand"]))
+            row.append(str(instruction["force_rex_w"]).lower())
+
+            f.write(f"SPASM_X86_64_FORM({', '.join(row)})\n")
+
+    return True
+
+def collect_instructions() -> List[dict]:
     # TODO: handle multiple encodings
 
     instructions = []
@@ -205,7 +492,7 @@ def generate_c_file(output_c_file_path: str) -> bool:
                 operand_sizes = parse_operand_sizes(operands)
 
                 opcode_bytes, needs_modrm, prefix_type, pp, reg_in_opcode, modrm_reg_operand, modrm_rm_operand, force_rex_w = parse_encoding(encoding,
-                    operand_types[0] == "OP_REG")
+                    operands, operand_types[0] == "OP_REG")
                 mmmmm = "0x01" if 'VEX' in prefix_type or 'EVEX' in prefix_type else "0x00"
                 cpu_flag = map_cpu_flag(isa)
 
@@ -227,12 +514,640 @@ def generate_c_file(output_c_file_path: str) -> bool:
                     "force_rex_w": force_rex_w,
                 })
 
+    # Forms are looked up per mnemonic, keep them grouped and the mnemonics sorted
+    instructions.sort(key=lambda instruction: instruction["mnemonic"])
+
+    return instructions
+
+def read_forms_file(input_forms_file_path: str) -> List[dict]:
+    # Reads back the forms written by generate_forms_file, in the same order
+
+    operand_types = {name: operand_type for operand_type, name in forms_operand_types.items()}
+
+    instructions = []
+
+    with open(input_forms_file_path, "r", encoding="utf-8") as f:
+        for line in f:
+            if not line.startswith("SPASM_X86_64_FORM("):
+                continue
+
+            row = [field.strip() for field in line.strip()[len("SPASM_X86_64_FORM("):-1].split(",")]
+
+            opcode_len = int(row[13])
+
+            instructions.append({
+                "mnemonic": row[0].lower(),
+                "operand_types": [operand_types[t] for t in row[1:5]],
+                "operand_sizes": row[5:9],
+                "opcode": row[9:9 + opcode_len],
+                "needs_modrm": row[14] == "true",
+                "prefix": f"Spasm_x86_64_PrefixType_{row[15]}",
+                "pp": row[16],
+                "mmmmm": row[17],
+                "cpu_flag": f"Spasm_x86_64_CPUFlag_{row[18]}",
+                "reg_in_opcode": row[19] == "true",
+                "reg_in_modrm_reg": row[20] == "true",
+                "modrm_reg_operand": int(row[21]),
+                "reg_in_modrm_rm": row[22] == "true",
+                "modrm_rm_operand": int(row[23]),
+                "force_rex_w": row[24] == "true",
+            })
+
+    # The mandatory prefixes first, the ModR/M.rm operands are looked up among the forms of the same encoding
+    for instruction in instructions:
+        if is_legacy_form(instruction) and int(instruction["pp"], 16) == 0:
+            instruction["pp"] = legacy_mandatory_prefix(instruction)
+
+    for index, instruction in enumerate(instructions):
+        update_legacy_form(instructions, index)
+
+    return instructions
+
+def is_legacy_form(instruction: dict) -> bool:
+    return instruction["prefix"] in ("Spasm_x86_64_PrefixType_NONE", "Spasm_x86_64_PrefixType_REX")
+
+def legacy_modrm_rm_operand(instructions: List[dict], index: int) -> int:
+    # The memory operand of the form, or of a form of the same encoding taking memory in place of
+    # one of the registers. Without one, /digit forms take their first operand and the others their
+    # second one (movmskps r32, xmm, pextrw r32, xmm, imm8...)
+
+    form = instructions[index]
+
+    if "OP_MEM" in form["operand_types"]:
+        return form["operand_types"].index("OP_MEM")
+
+    same_encoding = ("mnemonic", "opcode", "prefix", "pp", "reg_in_modrm_reg", "modrm_reg_operand", "force_rex_w")
+
+    for candidate in instructions:
+        if any(candidate[key] != form[key] for key in same_encoding) or not "OP_MEM" in candidate["operand_types"]:
+            continue
+
+        operand = candidate["operand_types"].index("OP_MEM")
+
+        if form["operand_types"][operand] != "OP_REG":
+            continue
+
+        if all(candidate["operand_types"][i] == form["operand_types"][i] and
+               candidate["operand_sizes"][i] == form["operand_sizes"][i] for i in range(4) if i != operand):
+            return operand
+
+    return 0 if form["reg_in_modrm_reg"] else 1
+
+# Mandatory prefixes of the legacy forms, by mnemonic. The ones of the SSE mnemonics only apply to
+# their forms on xmm registers, their MMX forms have none
+legacy_prefixes = {
+    "adcx": 0x66, "adox": 0xF3, "popcnt": 0xF3, "lzcnt": 0xF3, "tzcnt": 0xF3, "pause": 0xF3,
+    "crc32": 0xF2, "clflushopt": 0x66, "clwb": 0x66, "cvtpd2pi": 0x66, "cvttpd2pi": 0x66,
+    "cvtpi2pd": 0x66, "cvtsd2si": 0xF2, "cvttsd2si": 0xF2, "cvtss2si": 0xF3, "cvttss2si": 0xF3,
+}
+
+legacy_sse_prefixes = {
+    "cvtdq2pd": 0xF3, "cvtps2pd": 0x00, "cvtpd2dq": 0xF2, "cvttpd2dq": 0x66, "cvtps2dq": 0x66,
+    "cvttps2dq": 0xF3, "cvtdq2ps": 0x00, "cvtpd2ps": 0x66, "cvtpi2ps": 0x00, "cvtps2pi": 0x00,
+    "cvttps2pi": 0x00, "cvtsi2sd": 0xF2, "cvtsi2ss": 0xF3, "cvtsd2ss": 0xF2, "cvtss2sd": 0xF3,
+    "comisd": 0x66, "ucomisd": 0x66, "comiss": 0x00, "ucomiss": 0x00, "movdqa": 0x66,
+    "movdqu": 0xF3, "movd": 0x66, "movq2dq": 0xF3, "movdq2q": 0xF2, "lddqu": 0xF2, "movddup": 0xF2,
+    "movshdup": 0xF3, "movsldup": 0xF3, "addsubps": 0xF2, "haddps": 0xF2, "hsubps": 0xF2,
+    "maskmovdqu": 0x66, "movntdq": 0x66, "pshufhw": 0xF3, "pshuflw": 0xF2, "extrq": 0x66,
+    "insertq": 0xF2,
+}
+
+def legacy_mandatory_prefix(instruction: dict) -> str:
+    # Derives the mandatory prefix of a legacy form from the SDM naming rules: packed integer and double
+    # forms take 66, scalar single F3 and scalar double F2, the 0F 38 and 0F 3A maps 66 (but SHA)
+
+    mnemonic = instruction["mnemonic"]
+
+    if mnemonic in legacy_prefixes:
+        return mandatory_prefixes_pp[legacy_prefixes[mnemonic]]
+
+    if not "128" in instruction["operand_sizes"]:
+        return "0x00"
+
+    prefix = 0x00
+
+    if mnemonic in legacy_sse_prefixes:
+        prefix = legacy_sse_prefixes[mnemonic]
+    elif mnemonic == "movq":
+        # movq xmm, xmm/m64 is F3 0F 7E, the moves from and to general purpose registers are REX.W ones
+        prefix = 0xF3 if int(instruction["opcode"][-1], 16) == 0x7E and not instruction["force_rex_w"] else 0x66
+    elif instruction["opcode"][:2] == ["0x0F", "0x38"] or instruction["opcode"][:2] == ["0x0F", "0x3A"]:
+        prefix = 0x00 if mnemonic.startswith("sha") else 0x66
+    elif mnemonic.startswith("p") or mnemonic.endswith("pd"):
+        prefix = 0x66
+    elif mnemonic.endswith("ss"):
+        prefix = 0xF3
+    elif mnemonic.endswith("sd"):
+        prefix = 0xF2
+
+    return mandatory_prefixes_pp.get(prefix, "0x00")
+
+def update_legacy_form(instructions: List[dict], index: int) -> None:
+    # Forms files may come from a version of this script that did not derive all the columns from
+    # Opcodes, the missing ones are derived from the other columns
+
+    form = instructions[index]
+
+    if not is_legacy_form(form):
+        return
+
+    if form["needs_modrm"] and not form["reg_in_modrm_rm"]:
+        form["reg_in_modrm_rm"] = True
+        form["modrm_rm_operand"] = legacy_modrm_rm_operand(instructions, index)
+
+    # +r forms (push, pop, bswap, xchg r, rax, mov r, imm) are the register forms without ModR/M with
+    # the low 3 bits of their last opcode byte clear
+    if not form["needs_modrm"] and form["operand_types"][0] == "OP_REG" and int(form["opcode"][-1], 16) & 0x7 == 0:
+        form["reg_in_opcode"] = True
+
+# Register and flags accesses of the forms, for the def-use and liveness analysis. Opcodes does not
+# describe the flags, and lists some implicit operands as explicit ones, so the semantics are
+# described per mnemonic here and applied to the forms
+
+access_flags = {
+    "CF": 0x01,
+    "PF": 0x02,
+    "AF": 0x04,
+    "ZF": 0x08,
+    "SF": 0x10,
+    "OF": 0x20,
+    "DF": 0x40,
+}
+
+access_status_flags = ["CF", "PF", "AF", "ZF", "SF", "OF"]
+
+# Registers accessed without being operands: general purpose registers by code, then vector
+# registers from bit 16
+access_registers = {
+    "rax": 0, "rcx": 1, "rdx": 2, "rbx": 3, "rsp": 4, "rbp": 5, "rsi": 6, "rdi": 7,
+    "r8": 8, "r9": 9, "r10": 10, "r11": 11, "xmm0": 16,
+}
+
+access_conditions = {
+    "o": ["OF"], "no": ["OF"],
+    "b": ["CF"], "c": ["CF"], "nae": ["CF"], "ae": ["CF"], "nb": ["CF"], "nc": ["CF"],
+    "e": ["ZF"], "z": ["ZF"], "ne": ["ZF"], "nz": ["ZF"],
+    "be": ["CF", "ZF"], "na": ["CF", "ZF"], "a": ["CF", "ZF"], "nbe": ["CF", "ZF"],
+    "s": ["SF"], "ns": ["SF"],
+    "p": ["PF"], "pe": ["PF"], "np": ["PF"], "po": ["PF"],
+    "l": ["SF", "OF"], "nge": ["SF", "OF"], "ge": ["SF", "OF"], "nl": ["SF", "OF"],
+    "le": ["ZF", "SF", "OF"], "ng": ["ZF", "SF", "OF"], "g": ["ZF", "SF", "OF"], "nle": ["ZF", "SF", "OF"],
+}
+
+# Flags written (all the status flags, defined or left undefined), the others keep their value
+access_writes_status_flags = {
+    "adc", "add", "and", "andn", "bextr", "blcfill", "blci", "blcic", "blcmsk", "blcs", "blsfill",
+    "blsi", "blsic", "blsmsk", "blsr", "bsf", "bsr", "bzhi", "cmp", "cmpxchg", "cmpxchg16b",
+    "cmpxchg8b", "comisd", "comiss", "div", "idiv", "imul", "lzcnt", "mul", "neg", "or",
+    "pcmpestri", "pcmpestrm", "pcmpistri", "pcmpistrm", "popcnt", "ptest", "rdrand", "rdseed",
+    "sal", "sar", "sbb", "shl", "shld", "shr", "shrd", "sub", "t1mskc", "test", "tzcnt", "tzmsk",
+    "ucomisd", "ucomiss", "vcomisd", "vcomiss", "vpcmpestri", "vpcmpestrm", "vpcmpistri",
+    "vpcmpistrm", "vptest", "vtestpd", "vtestps", "vucomisd", "vucomiss", "xadd", "xor",
+    "kortestb", "kortestd", "kortestq", "kortestw", "ktestb", "ktestd", "ktestq", "ktestw",
+}
+
+access_flags_written = {
+    "inc": ["PF", "AF", "ZF", "SF", "OF"],
+    "dec": ["PF", "AF", "ZF", "SF", "OF"],
+    "bt": ["CF", "PF", "AF", "SF", "OF"],
+    "btc": ["CF", "PF", "AF", "SF", "OF"],
+    "btr": ["CF", "PF", "AF", "SF", "OF"],
+    "bts": ["CF", "PF", "AF", "SF", "OF"],
+    "rol": ["CF", "OF"],
+    "ror": ["CF", "OF"],
+    "rcl": ["CF", "OF"],
+    "rcr": ["CF", "OF"],
+    "clc": ["CF"],
+    "stc": ["CF"],
+    "cmc": ["CF"],
+    "adcx": ["CF"],
+    "adox": ["OF"],
+    "cld": ["DF"],
+    "std": ["DF"],
+}
+
+access_flags_read = {
+    "adc": ["CF"],
+    "sbb": ["CF"],
+    "rcl": ["CF"],
+    "rcr": ["CF"],
+    "cmc": ["CF"],
+    "adcx": ["CF"],
+    "adox": ["OF"],
+}
+
+# Shifts and rotates by cl leave the flags untouched when the count is 0
+access_variable_shifts = {"sal", "sar", "shl", "shr", "rol", "ror", "rcl", "rcr", "shld", "shrd"}
+
+# Explicit operands, the default is the first operand read and written and the others read, VEX
+# and EVEX forms with two operands or more write their first operand without reading it
+
+access_write_first = {
+    "aesimc", "aeskeygenassist", "bsf", "bsr", "cvtdq2pd", "cvtdq2ps", "cvtpd2dq", "cvtpd2pi",
+    "cvtpd2ps", "cvtpi2pd", "cvtps2dq", "cvtps2pd", "cvtps2pi", "cvtsd2si", "cvtss2si",
+    "cvttpd2dq", "cvttpd2pi", "cvttps2dq", "cvttps2pi", "cvttsd2si", "cvttss2si", "extractps",
+    "lddqu", "lea", "lzcnt", "mov", "movapd", "movaps", "movbe", "movd", "movddup", "movdq2q",
+    "movdqa", "movdqu", "movmskpd", "movmskps", "movnti", "movntdq", "movntdqa", "movntpd",
+    "movntps", "movntq", "movntsd", "movntss", "movq", "movq2dq", "movshdup", "movsldup",
+    "movsx", "movsxd", "movupd", "movups", "movzx", "pabsb", "pabsd", "pabsw", "pextrb",
+    "pextrd", "pextrq", "pextrw", "pf2id", "pf2iw", "pfrcp", "pfrsqrt", "phminposuw", "pi2fd",
+    "pi2fw", "pmovmskb", "pmovsxbd", "pmovsxbq", "pmovsxbw", "pmovsxdq", "pmovsxwd", "pmovsxwq",
+    "pmovzxbd", "pmovzxbq", "pmovzxbw", "pmovzxdq", "pmovzxwd", "pmovzxwq", "pop", "popcnt",
+    "pshufd", "pshufhw", "pshuflw", "pshufw", "pswapd", "rcpps", "rdrand", "rdseed", "roundpd",
+    "roundps", "rsqrtps", "sqrtpd", "sqrtps", "stmxcsr", "tzcnt", "kmovb", "kmovd", "kmovq",
+    "kmovw", "knotb", "knotd", "knotq", "knotw",
+}
+
+access_read_only = {
+    "bt", "call", "clflush", "clflushopt", "clwb", "cmp", "comisd", "comiss", "div", "idiv",
+    "jecxz", "jmp", "jrcxz", "ldmxcsr", "maskmovdqu", "maskmovq", "mul", "nop", "pcmpestri",
+    "pcmpestrm", "pcmpistri", "pcmpistrm", "prefetch", "prefetchnta", "prefetcht0",
+    "prefetcht1", "prefetcht2", "prefetchw", "prefetchwt1", "ptest", "push", "ret", "test",
+    "ucomisd", "ucomiss", "vcomisd", "vcomiss", "vmaskmovdqu", "vpcmpestri", "vpcmpestrm",
+    "vpcmpistri", "vpcmpistrm", "vptest", "vtestpd", "vtestps", "vucomisd", "vucomiss",
+    "kortestb", "kortestd", "kortestq", "kortestw", "ktestb", "ktestd", "ktestq", "ktestw",
+}
+
+access_read_write_all = {"xadd", "xchg"}
+
+# VEX and EVEX forms accumulating in their first operand
+access_vex_read_write_first_prefixes = (
+    "vfmadd", "vfmsub", "vfnmadd", "vfnmsub", "vpermi2", "vpermt2", "vpternlog", "vfixupimm",
+    "vpmadd52", "vpdpbusd", "vpdpwssd", "vpshldv", "vpshrdv",
+)
+
+# Registers read and written without being operands, by mnemonic: (read, written)
+access_implicit = {
+    "cbw": (["rax"], ["rax"]),
+    "cwde": (["rax"], ["rax"]),
+    "cdqe": (["rax"], ["rax"]),
+    "cwd": (["rax"], ["rdx"]),
+    "cdq": (["rax"], ["rdx"]),
+    "cqo": (["rax"], ["rdx"]),
+    "call": (["rsp"], ["rsp"]),
+    "ret": (["rsp"], ["rsp"]),
+    "push": (["rsp"], ["rsp"]),
+    "pop": (["rsp"], ["rsp"]),
+    "cpuid": (["rax", "rcx"], ["rax", "rbx", "rcx", "rdx"]),
+    "rdtsc": ([], ["rax", "rdx"]),
+    "rdtscp": ([], ["rax", "rcx", "rdx"]),
+    "xgetbv": (["rcx"], ["rax", "rdx"]),
+    "syscall": (["rax", "rdi", "rsi", "rdx", "r10", "r8", "r9"], ["rax", "rcx", "r11"]),
+    "cmpxchg": (["rax"], ["rax"]),
+    "cmpxchg8b": (["rax", "rbx", "rcx", "rdx"], ["rax", "rdx"]),
+    "cmpxchg16b": (["rax", "rbx", "rcx", "rdx"], ["rax", "rdx"]),
+    "xlatb": (["rax", "rbx"], ["rax"]),
+    "mulx": (["rdx"], []),
+    "pcmpestri": (["rax", "rdx"], ["rcx"]),
+    "vpcmpestri": (["rax", "rdx"], ["rcx"]),
+    "pcmpestrm": (["rax", "rdx"], ["xmm0"]),
+    "vpcmpestrm": (["rax", "rdx"], ["xmm0"]),
+    "pcmpistri": ([], ["rcx"]),
+    "vpcmpistri": ([], ["rcx"]),
+    "pcmpistrm": ([], ["xmm0"]),
+    "vpcmpistrm": ([], ["xmm0"]),
+    "maskmovdqu": (["rdi"], []),
+    "vmaskmovdqu": (["rdi"], []),
+    "maskmovq": (["rdi"], []),
+    "jecxz": (["rcx"], []),
+    "jrcxz": (["rcx"], []),
+    "monitor": (["rax", "rcx", "rdx"], []),
+    "monitorx": (["rax", "rcx", "rdx"], []),
+    "mwait": (["rax", "rcx"], []),
+    "mwaitx": (["rax", "rbx", "rcx"], []),
+    "clzero": (["rax"], []),
+}
+
+def flags_mask(flags: List[str]) -> int:
+    return sum(access_flags[flag] for flag in flags)
+
+def registers_mask(registers: List[str]) -> int:
+    return sum(1 << access_registers[register] for register in registers)
+
+def form_access(instruction: dict) -> Tuple[int, int, int, int, int, int]:
+    # Returns: operands read, operands written, flags read, flags written, implicit registers read
+    # and written
+
+    mnemonic = instruction["mnemonic"]
+    operand_types = [t for t in instruction["operand_types"] if t != "OP_NONE"]
+    num_operands = len(operand_types)
+    is_vex = "VEX" in instruction["prefix"]
+
+    # Bit i is the operand i of the instruction, as laid out in the table
+    all_operands = sum(1 << i for i, t in enumerate(instruction["operand_types"]) if t != "OP_NONE")
+
+    condition = None
+
+    for prefix in ("cmov", "set", "j"):
+        if mnemonic.startswith(prefix) and mnemonic[len(prefix):] in access_conditions:
+            condition = access_conditions[mnemonic[len(prefix):]]
+
+    if mnemonic in access_read_write_all:
+        read, written = all_operands, all_operands
+    elif mnemonic == "mulx":
+        read, written = 0b100 & all_operands, 0b011 & all_operands
+    elif mnemonic in access_read_only or (condition is not None and mnemonic.startswith("j")):
+        read, written = all_operands, 0
+    elif mnemonic in access_write_first or mnemonic.startswith("set"):
+        read, written = all_operands & ~1, 1 & all_operands
+    elif mnemonic == "imul" and num_operands == 3:
+        read, written = 0b110 & all_operands, 0b001 & all_operands
+    elif mnemonic in ("movss", "movsd") and instruction["operand_types"][1] == "OP_MEM":
+        # Loads zero the rest of the register, register moves merge
+        read, written = 0b10 & all_operands, 0b01 & all_operands
+    elif is_vex and num_operands >= 2 and not mnemonic.startswith(access_vex_read_write_first_prefixes):
+        read, written = all_operands & ~1, 1 & all_operands
+    else:
+        read, written = all_operands, 1 & all_operands
+
+    flags_read = flags_mask(condition) if condition is not None else 0
+    flags_written = 0
+
+    if mnemonic in access_writes_status_flags:
+        flags_written = flags_mask(access_status_flags)
+    elif mnemonic in access_flags_written:
+        flags_written = flags_mask(access_flags_written[mnemonic])
+
+    if mnemonic in access_flags_read:
+        flags_read |= flags_mask(access_flags_read[mnemonic])
+
+    if mnemonic in access_variable_shifts and operand_types[-1] == "OP_REG":
+        flags_read |= flags_written
+
+    implicit_read, implicit_written = access_implicit.get(mnemonic, ([], []))
+    implicit_read = registers_mask(implicit_read)
+    implicit_written = registers_mask(implicit_written)
+
+    # vzeroupper only clears the upper lanes, which are not tracked apart from the registers
+    if mnemonic == "vzeroall":
+        implicit_written = 0xFFFF << 16
+
+    # One operand multiplications and divisions use ax for 8 bits operands, rdx:rax otherwise
+    if mnemonic in ("mul", "imul", "div", "idiv") and num_operands == 1:
+        is_8_bits = instruction["operand_sizes"][0] == "8" or instruction["opcode"][0] == "0xF6"
+        pair = ["rax"] if is_8_bits else ["rax", "rdx"]
+
+        implicit_read = registers_mask(pair if mnemonic in ("div", "idiv") else ["rax"])
+        implicit_written = registers_mask(pair)
+
+    return read, written, flags_read, flags_written, implicit_read, implicit_written
+
+def generate_access_table(f: Any, instructions: List[dict]) -> None:
+    f.write("/* Indexed like the instruction table, see Spasm_x86_64_FormAccess */\n")
+    f.write(f"const Spasm_x86_64_FormAccess spasm_x86_64_form_access_table[{len(instructions)}] = {{\n")
+
+    for instruction in instructions:
+        read, written, flags_read, flags_written, implicit_read, implicit_written = form_access(instruction)
+
+        f.write(f"    {{ 0x{read:X}, 0x{written:X}, 0x{flags_read:02X}, 0x{flags_written:02X}, ")
+        f.write(f"0x{implicit_read:05X}, 0x{implicit_written:05X} }}, /* {instruction['mnemonic']} */\n")
+
+    f.write("};\n")
+
+# Cost model of the scheduler: the forms get a class from their mnemonic, and each microarchitecture
+# profile gives the latency and the execution ports of the classes. Latencies are the register to
+# register ones, the profiles add their load latency to the forms reading memory. Keep the classes in
+# the order of Spasm_x86_64_CostClass and the profiles in the order of Spasm_x86_64_Uarch
+
+cost_classes = [
+    "Other",
+    "Move",
+    "Alu",
+    "Shift",
+    "Complex",
+    "Divide",
+    "Branch",
+    "VectorMove",
+    "VectorAlu",
+    "VectorShuffle",
+    "VectorMultiply",
+    "FloatAdd",
+    "FloatMultiply",
+    "FloatFma",
+    "FloatDivide",
+    "FloatSqrt",
+    "Convert",
+]
+
+cost_moves = {
+    "mov", "movzx", "movsx", "movsxd", "lea", "push", "pop", "movbe", "xchg",
+}
+
+cost_alus = {
+    "add", "adc", "sub", "sbb", "and", "or", "xor", "cmp", "test", "inc", "dec", "neg", "not",
+    "andn", "blsi", "blsmsk", "blsr", "cmc", "clc", "stc", "cld", "std", "adcx", "adox", "cbw",
+    "cwde", "cdqe", "cwd", "cdq", "cqo", "xadd", "cmpxchg", "nop", "bswap",
+}
+
+cost_shifts = {
+    "sal", "sar", "shl", "shr", "rol", "ror", "rcl", "rcr", "shld", "shrd", "sarx", "shlx", "shrx",
+    "rorx", "bt", "btc", "btr", "bts",
+}
+
+# Integer instructions on the multiplier port (3 cycles)
+cost_complexes = {
+    "imul", "mul", "mulx", "popcnt", "lzcnt", "tzcnt", "bsf", "bsr", "pdep", "pext", "bzhi",
+    "bextr", "crc32",
+}
+
+cost_divides = {"div", "idiv"}
+
+cost_branches = {"call", "ret", "jmp"}
+
+# Vector classes are looked up without the VEX/EVEX "v"
+cost_vector_moves = {
+    "movaps", "movapd", "movups", "movupd", "movdqa", "movdqu", "movdqa32", "movdqa64", "movdqu8",
+    "movdqu16", "movdqu32", "movdqu64", "movss", "movsd", "movd", "movq", "movntps", "movntpd",
+    "movntdq", "movntdqa", "movhps", "movhpd", "movlps", "movlpd", "movmskps", "movmskpd",
+    "pmovmskb", "maskmovps", "maskmovpd", "pmaskmovd", "pmaskmovq",
+}
+
+cost_vector_shuffles_prefixes = (
+    "shuf", "unpck", "punpck", "pshuf", "perm", "vperm", "palignr", "pack", "insert", "extract",
+    "broadcast", "pbroadcast", "pinsr", "pextr", "pmovzx", "pmovsx", "pslldq", "psrldq", "movddup",
+    "movshdup", "movsldup", "align", "compress", "expand", "pcompress", "pexpand",
+)
+
+cost_vector_multiplies_prefixes = ("pmul", "pmadd", "psadbw", "mpsadbw", "dpbusd", "dpwssd")
+
+cost_float_fmas_prefixes = ("fmadd", "fmsub", "fnmadd", "fnmsub")
+
+cost_float_divides_prefixes = ("div",)
+
+cost_float_sqrts_prefixes = ("sqrt",)
+
+cost_float_multiplies_prefixes = ("mul", "rcp", "rsqrt", "dpp", "scalef")
+
+cost_float_adds_prefixes = (
+    "add", "sub", "hadd", "hsub", "min", "max", "cmp", "round", "comi", "ucomi", "range", "reduce",
+    "getexp", "getmant", "fixupimm",
+)
+
+cost_converts_prefixes = ("cvt",)
+
+cost_float_suffixes = ("ps", "pd", "ss", "sd", "sh", "ph")
+
+def cost_class(mnemonic: str) -> str:
+    if mnemonic.startswith("j") or mnemonic in cost_branches:
+        return "Branch"
+
+    if mnemonic in cost_divides:
+        return "Divide"
+
+    if mnemonic in cost_complexes:
+        return "Complex"
+
+    if mnemonic in cost_shifts:
+        return "Shift"
+
+    if mnemonic in cost_moves:
+        return "Move"
+
+    if mnemonic in cost_alus or mnemonic.startswith(("cmov", "set")):
+        return "Alu"
+
+    name = mnemonic[1:] if mnemonic.startswith("v") else mnemonic
+
+    if name in cost_vector_moves:
+        return "VectorMove"
+
+    if name.startswith(cost_converts_prefixes):
+        return "Convert"
+
+    if name.startswith(cost_vector_shuffles_prefixes):
+        return "VectorShuffle"
+
+    if name.startswith(cost_vector_multiplies_prefixes):
+        return "VectorMultiply"
+
+    if name.startswith(cost_float_fmas_prefixes):
+        return "FloatFma"
+
+    if name.endswith(cost_float_suffixes):
+        if name.startswith(cost_float_sqrts_prefixes):
+            return "FloatSqrt"
+
+        if name.startswith(cost_float_divides_prefixes):
+            return "FloatDivide"
+
+        if name.startswith(cost_float_multiplies_prefixes):
+            return "FloatMultiply"
+
+        if name.startswith(cost_float_adds_prefixes):
+            return "FloatAdd"
+
+        return "VectorAlu"
+
+    if name.startswith("p") or name in ("andps", "andpd", "andnps", "andnpd", "orps", "orpd", "xorps", "xorpd"):
+        return "VectorAlu"
+
+    return "Other"
+
+# Per class (latency, execution ports). Skylake ports: p0, p1, p5, p6 in bits 0 to 3. Zen 4 ports:
+# ALU0-3 in bits 0 to 3 and FP0-3 in bits 4 to 7. The generic profile has 4 ports doing everything
+cost_profiles = [
+    {
+        "name": "generic",
+        "issue_width": 4,
+        "load_latency": 5,
+        "num_load_ports": 2,
+        "num_store_ports": 1,
+        "classes": {
+            "Other": (1, 0x0F), "Move": (1, 0x0F), "Alu": (1, 0x0F), "Shift": (1, 0x0F),
+            "Complex": (3, 0x0F), "Divide": (26, 0x0F), "Branch": (1, 0x0F),
+            "VectorMove": (1, 0x0F), "VectorAlu": (1, 0x0F), "VectorShuffle": (1, 0x0F),
+            "VectorMultiply": (5, 0x0F), "FloatAdd": (4, 0x0F), "FloatMultiply": (4, 0x0F),
+            "FloatFma": (4, 0x0F), "FloatDivide": (13, 0x0F), "FloatSqrt": (15, 0x0F),
+            "Convert": (4, 0x0F),
+        },
+    },
+    {
+        "name": "skylake",
+        "issue_width": 4,
+        "load_latency": 5,
+        "num_load_ports": 2,
+        "num_store_ports": 1,
+        "classes": {
+            "Other": (1, 0x0F), "Move": (1, 0x0F), "Alu": (1, 0x0F), "Shift": (1, 0x09),
+            "Complex": (3, 0x02), "Divide": (26, 0x01), "Branch": (1, 0x09),
+            "VectorMove": (1, 0x07), "VectorAlu": (1, 0x07), "VectorShuffle": (1, 0x04),
+            "VectorMultiply": (5, 0x03), "FloatAdd": (4, 0x03), "FloatMultiply": (4, 0x03),
+            "FloatFma": (4, 0x03), "FloatDivide": (11, 0x01), "FloatSqrt": (12, 0x01),
+            "Convert": (4, 0x03),
+        },
+    },
+    {
+        "name": "zen4",
+        "issue_width": 6,
+        "load_latency": 4,
+        "num_load_ports": 3,
+        "num_store_ports": 2,
+        "classes": {
+            "Other": (1, 0x0F), "Move": (1, 0x0F), "Alu": (1, 0x0F), "Shift": (1, 0x06),
+            "Complex": (3, 0x02), "Divide": (14, 0x02), "Branch": (1, 0x09),
+            "VectorMove": (1, 0xF0), "VectorAlu": (1, 0xF0), "VectorShuffle": (1, 0x60),
+            "VectorMultiply": (3, 0x30), "FloatAdd": (3, 0xC0), "FloatMultiply": (3, 0x30),
+            "FloatFma": (4, 0x30), "FloatDivide": (11, 0x20), "FloatSqrt": (14, 0x20),
+            "Convert": (3, 0xC0),
+        },
+    },
+]
+
+def generate_cost_tables(f: Any, instructions: List[dict]) -> None:
+    f.write("/* Indexed like the instruction table, see Spasm_x86_64_CostClass */\n")
+    f.write(f"const uint8_t spasm_x86_64_form_cost_class_table[{len(instructions)}] = {{\n")
+
+    for instruction in instructions:
+        name = cost_class(instruction["mnemonic"])
+
+        f.write(f"    Spasm_x86_64_CostClass_{name}, /* {instruction['mnemonic']} */\n")
+
+    f.write("};\n")
+    f.write("\n")
+    f.write("/* Indexed by Spasm_x86_64_Uarch */\n")
+    f.write(f"const Spasm_x86_64_UarchProfile spasm_x86_64_uarch_profiles[{len(cost_profiles)}] = {{\n")
+
+    for profile in cost_profiles:
+        f.write("    {\n")
+        f.write(f"        .name = \"{profile['name']}\",\n")
+        f.write(f"        .issue_width = {profile['issue_width']},\n")
+        f.write(f"        .load_latency = {profile['load_latency']},\n")
+        f.write(f"        .num_load_ports = {profile['num_load_ports']},\n")
+        f.write(f"        .num_store_ports = {profile['num_store_ports']},\n")
+        f.write("        .classes = {\n")
+
+        for name in cost_classes:
+            latency, ports = profile["classes"][name]
+
+            f.write(f"            {{ {latency}, 0x{ports:02X} }}, /* {name} */\n")
+
+        f.write("        },\n")
+        f.write("    },\n")
+
+    f.write("};\n")
+
+def generate_c_file(output_c_file_path: str,
+                    output_h_file_path: str,
+                    output_emit_file_path: str,
+                    output_forms_file_path: str,
+                    instructions: List[dict]) -> bool:
+    mnemonics = sorted(set(instruction["mnemonic"] for instruction in instructions))
+
     # Create output directory if it doesn’t exist
     if not os.path.exists(os.path.dirname(output_c_file_path)):
         os.makedirs(os.path.dirname(output_c_file_path))
 
+    if not generate_mnemonics_header(output_h_file_path, mnemonics):
+        return False
+
+    if not generate_emit_header(output_emit_file_path, instructions):
+        return False
+
     num_instructions = len(instructions)
 
+    if not generate_forms_file(output_forms_file_path, instructions):
+        return False
+
     # Write the C file
     with open(output_c_file_path, "w", encoding="utf-8") as f:
         f.write("/* SPDX-License-Identifier: BSD-3-Clause */\n")
@@ -243,46 +1158,68 @@ def generate_c_file(output_c_file_path: str) -> bool:
         f.write("\n")
         f.write("#include \"spasm/x86_64.h\"\n")
         f.write("\n")
-        f.write("#define OP_NONE SpasmOperandType_None\n")
-        f.write("#define OP_REG SpasmOperandType_Register\n")
-        f.write("#define OP_MEM SpasmOperandType_Mem\n")
-        f.write("#define OP_IMM8 SpasmOperandType_Imm8\n")
-        f.write("#define OP_IMM16 SpasmOperandType_Imm16\n")
-        f.write("#define OP_IMM32 SpasmOperandType_Imm32\n")
-        f.write("#define OP_IMM64 SpasmOperandType_Imm64\n")
+        f.write("/* The forms are listed in spasm/x86_64_forms.inc, shared with spasm/x86_64_encoder.hpp */\n")
+        f.write("#define SPASM_X86_64_FORM(mnemonic_, t0, t1, t2, t3, s0, s1, s2, s3, o0, o1, o2, o3, opcode_len_, needs_modrm_, \\\n")
+        f.write("                          prefix_, pp_, mmmmm_, cpu_flag_, reg_in_opcode_, reg_in_modrm_reg_, modrm_reg_operand_, \\\n")
+        f.write("                          reg_in_modrm_rm_, modrm_rm_operand_, force_rex_w_)                                    \\\n")
+        f.write("    {                                                                                                      \\\n")
+        f.write("        .mnemonic = SpasmMnemonic_x86_64_##mnemonic_,                                                      \\\n")
+        f.write("        .operand_types = { SpasmOperandType_##t0, SpasmOperandType_##t1,                                   \\\n")
+        f.write("                           SpasmOperandType_##t2, SpasmOperandType_##t3 },                                 \\\n")
+        f.write("        .operand_sizes = { s0, s1, s2, s3 },                                                               \\\n")
+        f.write("        .opcode = { o0, o1, o2, o3 },                                                                      \\\n")
+        f.write("        .opcode_len = opcode_len_,                                                                         \\\n")
+        f.write("        .needs_modrm = needs_modrm_,                                                                       \\\n")
+        f.write("        .prefix = Spasm_x86_64_PrefixType_##prefix_,                                                       \\\n")
+        f.write("        .pp = pp_,                                                                                         \\\n")
+        f.write("        .mmmmm = mmmmm_,                                                                                   \\\n")
+        f.write("        .cpu_flag = Spasm_x86_64_CPUFlag_##cpu_flag_,                                                      \\\n")
+        f.write("        .reg_in_opcode = reg_in_opcode_,                                                                   \\\n")
+        f.write("        .reg_in_modrm_reg = reg_in_modrm_reg_,                                                             \\\n")
+        f.write("        .modrm_reg_operand = modrm_reg_operand_,                                                           \\\n")
+        f.write("        .reg_in_modrm_rm = reg_in_modrm_rm_,                                                               \\\n")
+        f.write("        .modrm_rm_operand = modrm_rm_operand_,                                                             \\\n")
+        f.write("        .force_rex_w = force_rex_w_,                                                                       \\\n")
+        f.write("    },\n")
         f.write("\n")
         f.write(f"const Spasm_x86_64_InstructionInfo spasm_x86_64_instruction_table[{num_instructions}] = {{\n")
+        f.write("#include \"spasm/x86_64_forms.inc\"\n")
+        f.write("};\n")
+        f.write("\n")
+        f.write("#undef SPASM_X86_64_FORM\n")
+        f.write("\n")
+        f.write(f"const size_t spasm_x86_64_instruction_table_size = {num_instructions};\n")
+        f.write("\n")
+        f.write("/* Indexed by SpasmMnemonic, the first entry is SpasmMnemonic_Invalid */\n")
+        f.write(f"const Spasm_x86_64_MnemonicInfo spasm_x86_64_mnemonic_table[{len(mnemonics) + 1}] = {{\n")
+        f.write("    { .name = \"\", .name_len = 0, .first_form = 0, .num_forms = 0 },\n")
 
-        for instruction in instructions:
-            f.write("    {\n")
-            f.write(f"        .mnemonic = \"{instruction['mnemonic']}\",\n")
-            f.write(f"        .mnemonic_len = {len(instruction['mnemonic'])},\n")
-            f.write(f"        .operand_types = {{ {', '.join(instruction['operand_types'])} }},\n")
-            f.write(f"        .operand_sizes = {{ {', '.join(instruction['operand_sizes'])} }},\n")
-            f.write(f"        .opcode = {{ {', '.join(instruction['opcode'])} }},\n")
-            f.write(f"        .opcode_len = {len(instruction['opcode'])},\n")
-            f.write(f"        .needs_modrm = {str(instruction['needs_modrm']).lower()},\n")
-            f.write(f"        .prefix = {instruction['prefix']},\n")
-            f.write(f"        .pp = {instruction['pp']},\n")
-            f.write(f"        .mmmmm = {instruction['mmmmm']},\n")
-            f.write(f"        .cpu_flag = {instruction['cpu_flag']},\n")
-            f.write(f"        .reg_in_opcode = {str(instruction['reg_in_opcode']).lower()},\n")
-            f.write(f"        .reg_in_modrm_reg = {str(instruction['reg_in_modrm_reg']).lower()},\n")
-            f.write(f"        .modrm_reg_operand = {str(instruction['modrm_reg_operand']).lower()},\n")
-            f.write(f"        .reg_in_modrm_rm = {str(instruction['reg_in_modrm_rm']).lower()},\n")
-            f.write(f"        .modrm_rm_operand = {str(instruction['modrm_rm_operand']).lower()},\n")
-            f.write(f"        .force_rex_w = {str(instruction['force_rex_w']).lower()},\n")
-            f.write("    },\n")
+        first_form = 0
+
+        for mnemonic in mnemonics:
+            num_forms = sum(1 for instruction in instructions if instruction["mnemonic"] == mnemonic)
+
+            f.write(f"    {{ .name = \"{mnemonic}\", .name_len = {len(mnemonic)}, ")
+            f.write(f".first_form = {first_form}, .num_forms = {num_forms} }},\n")
+
+            first_form += num_forms
 
         f.write("};\n")
         f.write("\n")
-        f.write(f"const size_t spasm_x86_64_instruction_table_size = {num_instructions};\n")
+
+        generate_access_table(f, instructions)
+        f.write("\n")
+        generate_cost_tables(f, instructions)
 
     return True
 
 def main() -> int:
     parser = optparse.OptionParser()
     parser.add_option("-o", "--output", dest="output_c_file", default=None)
+    parser.add_option("-m", "--mnemonics", dest="output_h_file", default=None)
+    parser.add_option("-e", "--emit", dest="output_emit_file", default=None)
+    parser.add_option("-f", "--forms", dest="output_forms_file", default=None)
+    parser.add_option("-i", "--input-forms", dest="input_forms_file", default=None)
 
     options, _ = parser.parse_args()
 
@@ -293,7 +1230,28 @@ def main() -> int:
     if os.path.dirname(options.output_c_file) == "":
         options.output_c_file = os.path.dirname(__file__) + "/" + options.output_c_file
 
-    if not generate_c_file(options.output_c_file):
+    if options.output_h_file is None:
+        options.output_h_file = os.path.dirname(os.path.abspath(__file__)) + "/../include/spasm/x86_64_mnemonics.h"
+
+    if options.output_emit_file is None:
+        options.output_emit_file = os.path.dirname(os.path.abspath(__file__)) + "/../include/spasm/x86_64_emit.h"
+
+    if options.output_forms_file is None:
+        options.output_forms_file = os.path.dirname(os.path.abspath(__file__)) + "/../include/spasm/x86_64_forms.inc"
+
+    if options.input_forms_file is not None:
+        instructions = read_forms_file(options.input_forms_file)
+    elif x86_64 is not None:
+        instructions = collect_instructions()
+    else:
+        print("Error: Opcodes is not installed, install it or read the forms from a forms file using -i/--input-forms option")
+        return 1
+
+    if not generate_c_file(options.output_c_file,
+                           options.output_h_file,
+                           options.output_emit_file,
+                           options.output_forms_file,
+                           instructions):
         print("Error during generation of the output c file, check the log for more details")
         return 1
 